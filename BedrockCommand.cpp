@@ -1,9 +1,42 @@
 #include <libstuff/libstuff.h>
+#include <libstuff/SHistogram.h>
+#include <libstuff/SMetrics.h>
 #include "BedrockCommand.h"
 #include "BedrockPlugin.h"
 
 atomic<size_t> BedrockCommand::_commandCount(0);
 
+void* BedrockCommand::operator new(size_t size) {
+    return SSlabPool::allocate(size);
+}
+
+void BedrockCommand::operator delete(void* ptr, size_t size) {
+    SSlabPool::deallocate(ptr, size);
+}
+
+// Per-verb histograms of total command latency, fed by finalizeTimingInfo. The mutex guards the map itself; the
+// histograms are internally thread-safe, so it's only held for the lookup (map nodes don't move, so a pointer to a
+// histogram stays valid after unlocking). The verb count is capped because methodLines aren't guaranteed to be a
+// small fixed set (e.g., DB's "query: ..." shorthand puts arbitrary SQL there); past the cap, commands aggregate
+// under a catch-all entry rather than growing the map forever.
+static const size_t MAX_TRACKED_VERBS = 100;
+static const uint64_t LATENCY_LOG_INTERVAL = 60 * STIME_US_PER_S;
+static mutex _latencyHistogramMutex;
+static map<string, SHistogram> _latencyHistogramsByVerb;
+static atomic<uint64_t> _latencyLastLogged(0);
+
+static SHistogram& _latencyHistogramForVerb(const string& verb) {
+    lock_guard<mutex> lock(_latencyHistogramMutex);
+    auto it = _latencyHistogramsByVerb.find(verb);
+    if (it != _latencyHistogramsByVerb.end()) {
+        return it->second;
+    }
+    if (_latencyHistogramsByVerb.size() >= MAX_TRACKED_VERBS) {
+        return _latencyHistogramsByVerb["(other)"];
+    }
+    return _latencyHistogramsByVerb[verb];
+}
+
 const string BedrockCommand::defaultPluginName("NO_PLUGIN");
 
 BedrockCommand::BedrockCommand(SQLiteCommand&& baseCommand, BedrockPlugin* plugin, bool escalateImmediately_) :
@@ -12,10 +45,18 @@ BedrockCommand::BedrockCommand(SQLiteCommand&& baseCommand, BedrockPlugin* plugi
     peekCount(0),
     processCount(0),
     repeek(false),
+    requestHold(false),
+    responseStreamed(false),
+    allocationCount(0),
+    resultBytes(0),
+    peakRSSDelta(0),
     crashIdentifyingValues(*this),
     escalateImmediately(escalateImmediately_),
     _plugin(plugin),
     _inProgressTiming(INVALID, 0, 0),
+    _allocationsAtStart(0),
+    _resultBytesAtStart(0),
+    _peakRSSAtStart(0),
     _timeout(_getTimeout(request))
 {
     // Initialize the priority, if supplied.
@@ -85,6 +126,14 @@ void BedrockCommand::startTiming(TIMING_INFO type) {
     get<0>(_inProgressTiming) = type;
     get<1>(_inProgressTiming) = STimeNow();
     get<2>(_inProgressTiming) = 0;
+
+    // Peek and process start and stop on the same thread, so we can meaningfully sample the thread-local resource
+    // counters around them (the queue timings can't; they stop on a different thread than they started).
+    if (type == PEEK || type == PROCESS) {
+        _allocationsAtStart = SGetAllocationCount();
+        _resultBytesAtStart = SQResult::threadMaterializedBytes();
+        _peakRSSAtStart = SGetPeakRSS();
+    }
 }
 
 void BedrockCommand::stopTiming(TIMING_INFO type) {
@@ -98,6 +147,19 @@ void BedrockCommand::stopTiming(TIMING_INFO type) {
     get<2>(_inProgressTiming) = STimeNow();
     timingInfo.push_back(_inProgressTiming);
 
+    // Accumulate the resource counters sampled by the matching startTiming.
+    if (type == PEEK || type == PROCESS) {
+        allocationCount += SGetAllocationCount() - _allocationsAtStart;
+        resultBytes += SQResult::threadMaterializedBytes() - _resultBytesAtStart;
+        peakRSSDelta += SGetPeakRSS() - _peakRSSAtStart;
+    } else if (type == QUEUE_WORKER || type == QUEUE_SYNC) {
+        // Export queue waits per priority to the global metrics registry, so a scrape shows which priority band is
+        // starving without attaching a profiler.
+        string name = "queue."s + (type == QUEUE_WORKER ? "worker" : "sync") + ".p" + to_string(priority);
+        SMetrics::counter(name + ".waitUS") += get<2>(_inProgressTiming) - get<1>(_inProgressTiming);
+        SMetrics::counter(name + ".waitCount")++;
+    }
+
     // And reset it for next use.
     get<0>(_inProgressTiming) = INVALID;
     get<1>(_inProgressTiming) = 0;
@@ -127,6 +189,8 @@ void BedrockCommand::finalizeTimingInfo() {
     uint64_t commitSyncTotal = 0;
     uint64_t queueWorkerTotal = 0;
     uint64_t queueSyncTotal = 0;
+    uint64_t kernelQueueTotal = 0;
+    uint64_t parseQueueTotal = 0;
     for (const auto& entry: timingInfo) {
         if (get<0>(entry) == PEEK) {
             peekTotal += get<2>(entry) - get<1>(entry);
@@ -140,6 +204,10 @@ void BedrockCommand::finalizeTimingInfo() {
             queueWorkerTotal += get<2>(entry) - get<1>(entry);
         } else if (get<0>(entry) == QUEUE_SYNC) {
             queueSyncTotal += get<2>(entry) - get<1>(entry);
+        } else if (get<0>(entry) == KERNEL_QUEUE) {
+            kernelQueueTotal += get<2>(entry) - get<1>(entry);
+        } else if (get<0>(entry) == PARSE_QUEUE) {
+            parseQueueTotal += get<2>(entry) - get<1>(entry);
         }
     }
 
@@ -150,13 +218,21 @@ void BedrockCommand::finalizeTimingInfo() {
     uint64_t unaccountedTime = totalTime - (peekTotal + processTotal + commitWorkerTotal + commitSyncTotal +
                                             escalationTimeUS + queueWorkerTotal + queueSyncTotal);
 
-    // Build a map of the values we care about.
+    // Build a map of the values we care about. The two queue observability values aren't part of the unaccounted-time
+    // math: kernelQueueTime precedes the command's creation (it's how long the parsed request sat in kernel buffers
+    // waiting on the poll loop), and parseQueueTime contains queueWorkerTime (it runs from parse to first dequeue, so
+    // subtracting both would double-count).
     map<string, uint64_t> valuePairs = {
+        {"kernelQueueTime", kernelQueueTotal},
+        {"parseQueueTime",  parseQueueTotal},
         {"peekTime",        peekTotal},
         {"processTime",     processTotal},
         {"totalTime",       totalTime},
         {"escalationTime",  escalationTimeUS},
         {"unaccountedTime", unaccountedTime},
+        {"allocationCount", allocationCount},
+        {"resultBytes",     resultBytes},
+        {"peakRSSDelta",    peakRSSDelta},
     };
 
     // We also want to know what leader did if we're on a follower.
@@ -165,28 +241,37 @@ void BedrockCommand::finalizeTimingInfo() {
     uint64_t upstreamUnaccountedTime = 0;
     uint64_t upstreamTotalTime = 0;
 
-    // Now promote any existing values that were set upstream. This prepends `upstream` and makes the first existing
-    // character of the name uppercase, (i.e. myValue -> upstreamMyValue), letting us keep anything that was set by the
-    // leader server. We clear these values after setting the new ones, so that we can add our own values.
-    for (const auto& p : valuePairs) {
-        auto it = response.nameValueMap.find(p.first);
-        if (it != response.nameValueMap.end()) {
-            string temp = it->second;
-            response.nameValueMap.erase(it);
-            response.nameValueMap[string("upstream") + (char)toupper(p.first[0]) + (p.first.substr(1))] = temp;
+    if (sealedResponse.size()) {
+        // The leader already promoted its values to their `upstream` names before sealing; pull the ones our logline
+        // wants straight out of the sealed bytes with a bounded scan rather than parsing them.
+        upstreamPeekTime = _sealedHeaderValue("upstreamPeekTime");
+        upstreamProcessTime = _sealedHeaderValue("upstreamProcessTime");
+        upstreamUnaccountedTime = _sealedHeaderValue("upstreamUnaccountedTime");
+        upstreamTotalTime = _sealedHeaderValue("upstreamTotalTime");
+    } else {
+        // Now promote any existing values that were set upstream. This prepends `upstream` and makes the first existing
+        // character of the name uppercase, (i.e. myValue -> upstreamMyValue), letting us keep anything that was set by the
+        // leader server. We clear these values after setting the new ones, so that we can add our own values.
+        for (const auto& p : valuePairs) {
+            auto it = response.nameValueMap.find(p.first);
+            if (it != response.nameValueMap.end()) {
+                string temp = it->second;
+                response.nameValueMap.erase(it);
+                response.nameValueMap[string("upstream") + (char)toupper(p.first[0]) + (p.first.substr(1))] = temp;
 
-            // Note the upstream times for our logline.
-            if (p.first == "peekTime") {
-                upstreamPeekTime = SToUInt64(temp);
-            }
-            else if (p.first == "processTime") {
-                upstreamProcessTime = SToUInt64(temp);
-            }
-            else if (p.first == "unaccountedTime") {
-                upstreamUnaccountedTime = SToUInt64(temp);
-            }
-            else if (p.first == "totalTime") {
-                upstreamTotalTime = SToUInt64(temp);
+                // Note the upstream times for our logline.
+                if (p.first == "peekTime") {
+                    upstreamPeekTime = SToUInt64(temp);
+                }
+                else if (p.first == "processTime") {
+                    upstreamProcessTime = SToUInt64(temp);
+                }
+                else if (p.first == "unaccountedTime") {
+                    upstreamUnaccountedTime = SToUInt64(temp);
+                }
+                else if (p.first == "totalTime") {
+                    upstreamTotalTime = SToUInt64(temp);
+                }
             }
         }
     }
@@ -201,17 +286,107 @@ void BedrockCommand::finalizeTimingInfo() {
           << queueSyncTotal/1000 << ", "
           << totalTime/1000 << ", "
           << unaccountedTime/1000 << ", "
-          << escalationTimeUS/1000 << ". Upstream: "
+          << escalationTimeUS/1000 << ". Socket: "
+          << kernelQueueTotal/1000 << ", "
+          << parseQueueTotal/1000 << ". Upstream: "
           << upstreamPeekTime/1000 << ", "
           << upstreamProcessTime/1000 << ", "
           << upstreamTotalTime/1000 << ", "
           << upstreamUnaccountedTime/1000 << "."
     );
 
-    // And here's where we set our own values.
-    for (const auto& p : valuePairs) {
-        if (p.second) {
-            response[p.first] = to_string(p.second);
+    // And the memory side, in the same format as AutoTimer, so memory spikes can be attributed to specific requests.
+    if (allocationCount || resultBytes || peakRSSDelta) {
+        SINFO("[performance] command '" << request.methodLine << "' memory info: "
+              << allocationCount << " allocations, "
+              << resultBytes << " result bytes, "
+              << peakRSSDelta / 1024 << " KB peak RSS growth.");
+    }
+
+    // And here's where we set our own values. A sealed response gets them patched into its reserved slots, since the
+    // sealed bytes (not `response`) are what the client receives.
+    if (sealedResponse.size()) {
+        for (const auto& p : valuePairs) {
+            _patchSealedSlot(p.first, p.second);
+        }
+    } else {
+        for (const auto& p : valuePairs) {
+            if (p.second) {
+                response[p.first] = to_string(p.second);
+            }
+        }
+    }
+
+    // Feed the per-verb latency histogram, and periodically log every verb's percentiles.
+    _latencyHistogramForVerb(request.getVerb()).record(totalTime);
+    uint64_t lastLogged = _latencyLastLogged.load();
+    uint64_t now = STimeNow();
+    if (now > lastLogged + LATENCY_LOG_INTERVAL && _latencyLastLogged.compare_exchange_strong(lastLogged, now)) {
+        lock_guard<mutex> lock(_latencyHistogramMutex);
+        for (const auto& pair : _latencyHistogramsByVerb) {
+            SINFO("[performance] command '" << pair.first << "' latency (us): " << pair.second.summary());
         }
     }
 }
+
+const char* const BedrockCommand::SEALED_SLOT_NAMES[10] = {
+    "peekTime", "processTime", "totalTime", "escalationTime", "unaccountedTime",
+    "allocationCount", "resultBytes", "peakRSSDelta", "kernelQueueTime", "parseQueueTime",
+};
+
+void BedrockCommand::sealResponseForEscalation(const string& followerName) {
+    // Promote our timing values to the names the follower would give them, so it doesn't have to.
+    for (const char* name : SEALED_SLOT_NAMES) {
+        auto it = response.nameValueMap.find(name);
+        if (it != response.nameValueMap.end()) {
+            string temp = it->second;
+            response.nameValueMap.erase(it);
+            response.nameValueMap[string("upstream") + (char)toupper(name[0]) + (name + 1)] = temp;
+        }
+    }
+
+    // The follower would stamp its own name over ours, and we know what it is.
+    response["nodeName"] = followerName;
+
+    // Reserve a fixed-width slot for each value the follower fills in; its finalizeTimingInfo patches these in place
+    // (zero stays zero-padded, which parses the same as the header being absent).
+    for (const char* name : SEALED_SLOT_NAMES) {
+        response[name] = string(SEALED_SLOT_WIDTH, '0');
+    }
+    sealedResponse = response.serialize();
+}
+
+uint64_t BedrockCommand::_sealedHeaderValue(const string& name) const {
+    size_t headerEnd = sealedResponse.find("\r\n\r\n");
+    size_t pos = sealedResponse.find("\r\n" + name + ": ");
+    if (pos == string::npos || (headerEnd != string::npos && pos > headerEnd)) {
+        return 0;
+    }
+    pos += name.size() + 4;
+    return SFastParseU64(sealedResponse.c_str() + pos, sealedResponse.c_str() + sealedResponse.size());
+}
+
+void BedrockCommand::_patchSealedSlot(const string& name, uint64_t value) {
+    size_t headerEnd = sealedResponse.find("\r\n\r\n");
+    size_t pos = sealedResponse.find("\r\n" + name + ": ");
+    if (pos == string::npos || (headerEnd != string::npos && pos > headerEnd)) {
+        return;
+    }
+    pos += name.size() + 4;
+    if (sealedResponse.size() < pos + SEALED_SLOT_WIDTH) {
+        return;
+    }
+    for (size_t i = SEALED_SLOT_WIDTH; i > 0; i--) {
+        sealedResponse[pos + i - 1] = (char)('0' + value % 10);
+        value /= 10;
+    }
+}
+
+STable BedrockCommand::commandLatencySummaries() {
+    STable summaries;
+    lock_guard<mutex> lock(_latencyHistogramMutex);
+    for (const auto& pair : _latencyHistogramsByVerb) {
+        summaries[pair.first] = pair.second.summary();
+    }
+    return summaries;
+}
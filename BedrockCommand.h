@@ -1,4 +1,5 @@
 #pragma once
+#include <libstuff/SScratchArena.h>
 #include <sqlitecluster/SQLiteCommand.h>
 
 class BedrockPlugin;
@@ -21,6 +22,8 @@ class BedrockCommand : public SQLiteCommand {
         COMMIT_SYNC,
         QUEUE_WORKER,
         QUEUE_SYNC,
+        KERNEL_QUEUE,
+        PARSE_QUEUE,
     };
 
     enum class STAGE {
@@ -33,6 +36,13 @@ class BedrockCommand : public SQLiteCommand {
     static const uint64_t DEFAULT_TIMEOUT_FORGET = 60'000 * 60; // 1 hour for `connection: forget` commands.
     static const uint64_t DEFAULT_PROCESS_TIMEOUT = 30'000; // 30 seconds.
 
+    // Commands churn at request rate, so they allocate from the slab pool instead of the heap. The sized delete
+    // receives the most-derived object's size (deletion runs through the virtual destructor), so every plugin's
+    // command subclass gets a correctly-sized class automatically. Ownership is unchanged: the unique_ptrs holding
+    // commands still run their default deleters, which land here.
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr, size_t size);
+
     // Constructor to initialize via a request object (by move).
     BedrockCommand(SQLiteCommand&& baseCommand, BedrockPlugin* plugin, bool escalateImmediately_ = false);
 
@@ -45,6 +55,14 @@ class BedrockCommand : public SQLiteCommand {
     // read-only fashion (i.e., it opened an HTTPS request and is waiting for the response).
     virtual bool peek(SQLite& db) { STHROW("430 Unrecognized command"); }
 
+    // Called by the server right after dequeue, before any database involvement — no handle checkout, no transaction.
+    // A command that can produce its complete response from memory should write it into `response` and return true,
+    // and it will be returned to the caller without ever touching the DB layer. Implementations must not throw, and
+    // should return false for anything they can't answer with certainty, in which case the command proceeds through
+    // the normal peek/process path. Anything cached from the database is only trustworthy while leading, so
+    // implementations are responsible for checking node state themselves (see the Cache plugin's memory tier).
+    virtual bool peekable() { return false; }
+
     // Called after a command has returned `false` to peek, and will attempt to commit and distribute a transaction
     // with any changes to the DB made by this plugin.
     virtual void process(SQLite& db) { STHROW("500 Base class process called"); }
@@ -74,9 +92,24 @@ class BedrockCommand : public SQLiteCommand {
     // `startTiming`.
     void stopTiming(TIMING_INFO type);
 
-    // Add a summary of our timing info to our response object.
+    // Add a summary of our timing info to our response object. If the response is sealed (see
+    // `sealResponseForEscalation`), our values are written into the fixed-width slots reserved in the sealed bytes
+    // instead of into `response`.
     void finalizeTimingInfo();
 
+    // Called on leader just before an escalated command's response goes back to its follower. Serializes `response`
+    // into `sealedResponse` in its final, client-ready form: our timing headers are pre-promoted to their `upstream`
+    // names (the rename the follower's finalizeTimingInfo would otherwise do after a reparse), `nodeName` is stamped
+    // with the follower's name, and each timing header the follower fills in gets a fixed-width zero-padded slot it
+    // can patch in place. The follower then forwards the bytes to the client verbatim, never parsing or reserializing
+    // them. Only used for followers that advertised support in their LOGIN.
+    void sealResponseForEscalation(const string& followerName);
+
+    // Per-verb latency summaries ("p50 ..., p99 ..., max ... (N samples)", in microseconds), aggregated across every
+    // command this server has finished, for the Status response. Unlike averages, the percentiles stay meaningful
+    // when a fast common case hides a pathological tail (e.g., during conflict storms).
+    static STable commandLatencySummaries();
+
     // Returns true if all of the httpsRequests for this command are complete (or if it has none).
     bool areHttpsRequestsComplete() const;
 
@@ -104,13 +137,72 @@ class BedrockCommand : public SQLiteCommand {
     // all HTTPS requests are complete. It will be automatically cleared if the command throws an exception.
     bool repeek;
 
+    // An explicit continuation for suspendable commands. A command that starts an HTTPS request in `peek` (or in a
+    // previous continuation) can capture its locals here and return false; when the request completes and the
+    // command is re-dequeued, the server invokes the continuation — inside a transaction, with the same semantics,
+    // timing, and exception handling as `peek` — instead of re-running `peek` from the top. Return true to complete
+    // the command (with `response` filled in), false to fall through to `process`. The continuation is moved out
+    // before it's invoked, so one that wants to suspend again (serial HTTPS chains) assigns a new one; this
+    // replaces the `repeek`-and-re-derive-state pattern, where every completed request re-paid the full cost of
+    // `peek` just to figure out where it left off. Like `repeek`, it's cleared if the command throws. It's never
+    // escalated; it only exists on the node that created it, which is fine, as HTTPS requests are only made while
+    // leading.
+    function<bool(SQLite&)> continuation;
+
+    // A command can set this to true in `peek` (while returning false) to ask the server to hand it to its plugin's
+    // `holdCommand` instead of processing it. The plugin then owns the command until it hands it back via
+    // `BedrockServer::acceptCommand`, just like commands waiting on HTTPS requests. The server clears this flag
+    // before handing the command over, so a re-queued command that still wants to wait must set it again in `peek`.
+    bool requestHold;
+
+    // Set to true by a command that streamed its entire response (header, body chunks, and terminator) directly to
+    // the client socket via `BedrockServer::streamToClient`. The server then skips sending `response` when the
+    // command completes, but still runs its normal per-reply socket bookkeeping.
+    bool responseStreamed;
+
+    // Set by a plugin to keep the server from compressing this command's response body, even if the client sent
+    // Accept-Encoding and the body is over the size threshold — for content that's already compressed, or clients
+    // that can't handle an encoded body despite what they advertised.
+    bool suppressResponseCompression = false;
+
+    // The offset of this command's entry in the server's forget journal (see BedrockForgetJournal), or -1 for the
+    // overwhelming majority of commands that aren't journaled. Set when an accepted `Connection: forget` command is
+    // journaled, and used to mark the entry complete when the server finishes with the command.
+    int64_t forgetJournalOffset = -1;
+
+    // Held while this command owns its affinity lane in a BedrockCommandQueue (see `AffinityKey` there). Destroying
+    // the command releases the lane, whichever path it took to completion, so a requeue or escalation can't strand
+    // the commands waiting behind it.
+    shared_ptr<void> affinityLaneGuard;
+
+    // Bump-allocated scratch memory that dies with the command. Plugin code can carve transient buffers out of
+    // this (directly, or through an SScratchAllocator handle for STL containers) instead of paying a malloc/free
+    // pair per buffer; everything comes back at once when the command is destroyed. Untouched, it costs nothing.
+    SScratchArena scratch;
+
+    // Return the plugin that owns this command (may be null for commands with no plugin).
+    BedrockPlugin* getPlugin() const { return _plugin; }
+
     // A list of timing sets, with an info type, start, and end.
     list<tuple<TIMING_INFO, uint64_t, uint64_t>> timingInfo;
 
+    // Per-command resource accounting, collected by the same start/stopTiming brackets as the durations above, but
+    // only for PEEK and PROCESS (the queue timings start and stop on different threads, where thread-local counters
+    // don't mean anything). Summarized in the response and a `[performance]` logline by `finalizeTimingInfo`.
+    uint64_t allocationCount;  // Heap allocations made while peeking/processing.
+    uint64_t resultBytes;      // Bytes of SQResult cells materialized while peeking/processing.
+    uint64_t peakRSSDelta;     // How much the process peak RSS grew while peeking/processing, in bytes.
+
     // This defaults to false, but a specific plugin can set it to 'true' to force this command to be passed
     // to the sync thread for processing, thus guaranteeing that process() will not result in a conflict.
     virtual bool onlyProcessOnSyncThread() { return false; }
 
+    // A plugin can set this to 'true' for commands that are pure reads, i.e., that always complete in `peek` and
+    // never write. Workers run such commands against a dedicated read-only DB handle with snapshot isolation, which
+    // never touches the commit lock or the journal, so reads aren't slowed down by write bursts. If a command
+    // declares this but fails to complete in `peek`, it's re-run on the normal write path (and a warning logged).
+    virtual bool isReadOnly() { return false; }
+
     // This is a set of name/value pairs that must be present and matching for two commands to compare as "equivalent"
     // for the sake of determining whether they're likely to cause a crash.
     // i.e., if this command has set this to {userID, reportList}, and the server crashes while processing this
@@ -164,9 +256,26 @@ class BedrockCommand : public SQLiteCommand {
     // used as a temporary variable for startTiming and stopTiming.
     tuple<TIMING_INFO, uint64_t, uint64_t> _inProgressTiming;
 
+    // Thread-local counter samples taken by startTiming, consumed by the matching stopTiming.
+    uint64_t _allocationsAtStart;
+    uint64_t _resultBytesAtStart;
+    uint64_t _peakRSSAtStart;
+
     // Get the absolute timeout value for this command based on it's request. This is used to initialize _timeout.
     static int64_t _getTimeout(const SData& request);
 
+    // The timing headers that get sealed-response slots, and the width of each slot (20 zero-padded decimal digits,
+    // enough for any uint64_t).
+    static const char* const SEALED_SLOT_NAMES[10];
+    static const size_t SEALED_SLOT_WIDTH = 20;
+
+    // Reads a numeric header straight out of the sealed response bytes with a bounded scan (no parse). Returns 0 if
+    // the header isn't there.
+    uint64_t _sealedHeaderValue(const string& name) const;
+
+    // Overwrites the fixed-width slot reserved for `name` in the sealed response bytes with `value`, zero-padded.
+    void _patchSealedSlot(const string& name, uint64_t value);
+
     // This is a timestamp in *microseconds* for when this command should timeout.
     uint64_t _timeout;
 
@@ -1,25 +1,82 @@
 #include <BedrockCommandQueue.h>
 
+atomic<size_t> BedrockCommandQueue::_threadIndex(0);
+
 void BedrockCommandQueue::startTiming(unique_ptr<BedrockCommand>& command) {
     command->startTiming(BedrockCommand::QUEUE_WORKER);
 }
 
 void BedrockCommandQueue::stopTiming(unique_ptr<BedrockCommand>& command) {
     command->stopTiming(BedrockCommand::QUEUE_WORKER);
+
+    // The first dequeue also closes out parse-to-dequeue: everything between the request being parsed into a command
+    // and a worker actually picking it up, which includes handling and enqueue overhead QUEUE_WORKER doesn't see.
+    // Requeues (conflicts, future commands coming due) don't re-record it.
+    bool alreadyRecorded = false;
+    for (const auto& entry : command->timingInfo) {
+        if (std::get<0>(entry) == BedrockCommand::PARSE_QUEUE) {
+            alreadyRecorded = true;
+            break;
+        }
+    }
+    if (!alreadyRecorded) {
+        command->timingInfo.emplace_back(BedrockCommand::PARSE_QUEUE, command->creationTime, STimeNow());
+    }
+}
+
+BedrockCommandQueue::BedrockCommandQueue() {
+}
+
+size_t BedrockCommandQueue::_waitBucket(int priority) {
+    // The five BedrockCommand::Priority levels are 250 apart; anything off-scale clamps to the nearest end.
+    if (priority <= 0) {
+        return 0;
+    }
+    return min(static_cast<size_t>(priority) / 250, static_cast<size_t>(4));
+}
+
+void BedrockCommandQueue::_recordQueueWait(const unique_ptr<BedrockCommand>& command) {
+    // The interval we want is the QUEUE_WORKER entry stopTiming just appended, which is the most recent one.
+    for (auto it = command->timingInfo.rbegin(); it != command->timingInfo.rend(); it++) {
+        if (std::get<0>(*it) == BedrockCommand::QUEUE_WORKER) {
+            uint64_t sample = std::get<2>(*it) - std::get<1>(*it);
+            atomic<uint64_t>& ewma = _recentWaitUS[_waitBucket(command->priority)];
+            uint64_t previous = ewma.load();
+            ewma.store(previous ? (previous * 7 + sample) / 8 : sample);
+            return;
+        }
+    }
+}
+
+uint64_t BedrockCommandQueue::recentQueueWaitUS(int priority) const {
+    return _recentWaitUS[_waitBucket(priority)].load();
 }
 
-BedrockCommandQueue::BedrockCommandQueue() :
-  SScheduledPriorityQueue<unique_ptr<BedrockCommand>>(function<void(unique_ptr<BedrockCommand>&)>(startTiming), function<void(unique_ptr<BedrockCommand>&)>(stopTiming))
-{ }
+size_t BedrockCommandQueue::_localShardIndex() {
+    // Assigned round-robin the first time each thread asks, so worker threads spread evenly across shards.
+    static thread_local size_t index = _threadIndex.fetch_add(1) % SHARD_COUNT;
+    return index;
+}
 
 list<string> BedrockCommandQueue::getRequestMethodLines() {
     list<string> returnVal;
-    SAUTOLOCK(_queueMutex);
-    for (auto& queue : _queue) {
-        for (auto& entry : queue.second) {
-            returnVal.push_back(entry.second.item->request.methodLine);
+    for (auto& shard : _shards) {
+        lock_guard<mutex> lock(shard.shardMutex);
+        for (auto& queue : shard.readyCommands) {
+            for (auto& command : queue.second) {
+                returnVal.push_back(command->request.methodLine);
+            }
+        }
+        for (auto& lane : shard.affinityLanes) {
+            for (auto& command : lane.second.pending) {
+                returnVal.push_back(command->request.methodLine);
+            }
         }
     }
+    lock_guard<mutex> lock(_futureMutex);
+    for (auto& entry : _futureCommands) {
+        returnVal.push_back(entry.second.command->request.methodLine);
+    }
     return returnVal;
 }
 
@@ -27,46 +84,380 @@ void BedrockCommandQueue::abandonFutureCommands(int msInFuture) {
     // We're going to delete every command scehduled after this timestamp.
     uint64_t timeLimit = STimeNow() + msInFuture * 1000;
 
-    // Lock around changes to the queue.
-    unique_lock<mutex> queueLock(_queueMutex);
+    // Ready commands are by definition already due, so only the centralized future structure can hold anything
+    // scheduled past the limit, where it's one contiguous range at the tail of the time-ordered map. Move the
+    // doomed commands out and erase the range in one shot; actually destroying them (responses, affinity lane
+    // guards) happens after the lock is released, since this runs during shutdown and standdown, when whoever's
+    // racing us for this lock can least afford to wait.
+    vector<unique_ptr<BedrockCommand>> abandoned;
+    {
+        lock_guard<mutex> lock(_futureMutex);
+        auto it = _futureCommands.upper_bound(timeLimit);
+        if (it == _futureCommands.end()) {
+            return;
+        }
+        abandoned.reserve(distance(it, _futureCommands.end()));
+        for (auto doomed = it; doomed != _futureCommands.end(); doomed++) {
+            _futureCommandTimeouts.cancel(doomed->second.timeout, doomed->first);
+            _methodLineCounts.decrement(doomed->second.command->request.methodLine);
+            abandoned.push_back(move(doomed->second.command));
+        }
+        _futureCommands.erase(it, _futureCommands.end());
+        _size -= abandoned.size();
+        _nextScheduled.store(_futureCommands.empty() ? UINT64_MAX : _futureCommands.begin()->first);
+    }
+    SINFO("Erased " << abandoned.size() << " commands scheduled more than " << msInFuture << "ms in the future.");
+}
+
+void BedrockCommandQueue::push(unique_ptr<BedrockCommand>&& command) {
+    uint64_t executionTime = command->request.calcU64("commandExecuteTime");
+    startTiming(command);
+    _methodLineCounts.increment(command->request.methodLine);
+    if (executionTime > STimeNow()) {
+        // Scheduled in the future: goes to the centralized structure until it comes due.
+        uint64_t timeout = command->timeout();
+        lock_guard<mutex> lock(_futureMutex);
+        _futureCommandTimeouts.insert(timeout, executionTime);
+        _futureCommands.emplace(executionTime, FutureCommand(move(command), timeout));
+        if (executionTime < _nextScheduled.load()) {
+            _nextScheduled.store(executionTime);
+        }
+    } else {
+        // Ready now: off to a shard (consistent for AffinityKey commands, round-robin for the rest).
+        _pushReady(move(command));
+    }
+    _size++;
+    _notify(false);
+}
+
+void BedrockCommandQueue::push(vector<unique_ptr<BedrockCommand>>&& commands) {
+    if (commands.empty()) {
+        return;
+    }
+
+    // Bucket the batch by destination shard so each shard's lock is taken at most once.
+    vector<unique_ptr<BedrockCommand>> shardBuckets[SHARD_COUNT];
+    size_t count = commands.size();
+    for (auto& command : commands) {
+        uint64_t executionTime = command->request.calcU64("commandExecuteTime");
+        startTiming(command);
+        _methodLineCounts.increment(command->request.methodLine);
+        if (executionTime > STimeNow()) {
+            uint64_t timeout = command->timeout();
+            lock_guard<mutex> lock(_futureMutex);
+            _futureCommandTimeouts.insert(timeout, executionTime);
+            _futureCommands.emplace(executionTime, FutureCommand(move(command), timeout));
+            if (executionTime < _nextScheduled.load()) {
+                _nextScheduled.store(executionTime);
+            }
+        } else if (_affinityKey(command)) {
+            // Affinity commands route by key and may park in a lane, so they don't fit the bucket fast path.
+            _pushReady(move(command));
+        } else {
+            shardBuckets[_pushIndex.fetch_add(1) % SHARD_COUNT].push_back(move(command));
+        }
+    }
+    for (size_t i = 0; i < SHARD_COUNT; i++) {
+        if (shardBuckets[i].empty()) {
+            continue;
+        }
+        Shard& shard = _shards[i];
+        lock_guard<mutex> lock(shard.shardMutex);
+        for (auto& command : shardBuckets[i]) {
+            _enqueueReady(shard, move(command));
+        }
+    }
+    _size += count;
+    commands.clear();
+
+    // One command only needs one consumer; more than one is worth waking everyone for.
+    _notify(count > 1);
+}
 
-    // We're going to look at each queue by priority. It's possible we'll end up removing *everything* from multiple
-    // queues. In that case, we need to remove the queues themselves, so we keep a list of queues to delete when we're
-    // done operating on each of them (so that we don't delete them while iterating over them).
-    list<typename decltype(_queue)::iterator> toDelete;
-    for (typename decltype(_queue)::iterator queueMapIt = _queue.begin(); queueMapIt != _queue.end(); ++queueMapIt) {
-        // Starting from the first item, skip any items that have a valid scheduled time.
-        auto commandMapIt = queueMapIt->second.begin();
-        while (commandMapIt != queueMapIt->second.end() && commandMapIt->first < timeLimit) {
-            commandMapIt++;
+unique_ptr<BedrockCommand> BedrockCommandQueue::get(uint64_t waitUS) {
+    uint64_t deadline = waitUS ? STimeNow() + waitUS : 0;
+    while (true) {
+        // Move any due future-scheduled commands into the shards. The atomic check keeps this off the hot path when
+        // nothing's scheduled (the overwhelmingly common case).
+        uint64_t now = STimeNow();
+        if (_nextScheduled.load() != UINT64_MAX) {
+            _drainFutureCommands(now);
         }
 
-        // Whatever's left in the queue is scheduled in the future and can be erased.
-        size_t numberToErase = distance(commandMapIt, queueMapIt->second.end());
-        if (numberToErase) {
-            queueMapIt->second.erase(commandMapIt, queueMapIt->second.end());
+        // If there's already work in a shard, just return some.
+        unique_ptr<BedrockCommand> command = _tryGet();
+        if (command) {
+            stopTiming(command);
+            _recordQueueWait(command);
+            _methodLineCounts.decrement(command->request.methodLine);
+            return command;
         }
 
-        // If the whole queue is empty, save it for deletion.
-        if (queueMapIt->second.empty()) {
-            toDelete.push_back(queueMapIt);
+        // Did we go past our timeout? If so, we give up.
+        if (deadline && STimeNow() >= deadline) {
+            throw timeout_error();
         }
 
-        // If we deleted any commands, log that.
-        if (numberToErase) {
-            SINFO("Erased " << numberToErase << " commands scheduled more than " << msInFuture << "ms in the future.");
+        // Otherwise, we'll wait for some. The re-check under the wait mutex is what makes this race-free: a pusher
+        // publishes its shard's priority hint before it checks for waiters, so either we see the hint here, or the
+        // pusher sees us and notifies.
+        unique_lock<mutex> waitLock(_waitMutex);
+        _waiters++;
+        bool ready = false;
+        for (const auto& shard : _shards) {
+            if (shard.topPriority.load() >= 0) {
+                ready = true;
+                break;
+            }
         }
+        if (!ready) {
+            // Wake for our own deadline or for the next scheduled command, whichever's first.
+            uint64_t wake = min(deadline ? deadline : UINT64_MAX, _nextScheduled.load());
+            if (wake == UINT64_MAX) {
+                _waitCondition.wait(waitLock);
+            } else {
+                now = STimeNow();
+                if (wake > now) {
+                    _waitCondition.wait_for(waitLock, chrono::microseconds(wake - now));
+                }
+            }
+        }
+        _waiters--;
     }
+}
+
+bool BedrockCommandQueue::empty() {
+    return !_size.load();
+}
+
+size_t BedrockCommandQueue::size() {
+    return _size.load();
+}
 
-    // Delete any empty queues.
-    for (auto& it : toDelete) {
-        _queue.erase(it);
+void BedrockCommandQueue::clear() {
+    for (auto& shard : _shards) {
+        // Moved out and destroyed after the lock is released: a ready command holding an affinity lane guard
+        // re-takes this shard's mutex from its destructor.
+        map<int, deque<unique_ptr<BedrockCommand>>> readyCommands;
+        map<string, Shard::AffinityLane> affinityLanes;
+        {
+            lock_guard<mutex> lock(shard.shardMutex);
+            readyCommands = move(shard.readyCommands);
+            affinityLanes = move(shard.affinityLanes);
+            shard.readyCommands.clear();
+            shard.affinityLanes.clear();
+            shard.topPriority.store(-1);
+        }
+        for (auto& queue : readyCommands) {
+            _size -= queue.second.size();
+        }
+        for (auto& lane : affinityLanes) {
+            _size -= lane.second.pending.size();
+        }
     }
+    lock_guard<mutex> lock(_futureMutex);
+    _size -= _futureCommands.size();
+    _futureCommands.clear();
+    _futureCommandTimeouts.clear();
+    _nextScheduled.store(UINT64_MAX);
+    _methodLineCounts.clear();
 }
 
-void BedrockCommandQueue::push(unique_ptr<BedrockCommand>&& command) {
-    BedrockCommand::Priority priority = command->priority;
-    uint64_t executionTime = command->request.calcU64("commandExecuteTime");
-    uint64_t timeout = command->timeout();
-    SScheduledPriorityQueue<unique_ptr<BedrockCommand>>::push(move(command), priority, executionTime, timeout);
+map<string, int64_t> BedrockCommandQueue::getMethodLineCounts() {
+    return _methodLineCounts.snapshot();
+}
+
+void BedrockCommandQueue::_enqueueReady(Shard& shard, unique_ptr<BedrockCommand>&& command) {
+    int priority = command->priority;
+    shard.readyCommands[priority].push_back(move(command));
+    if (priority > shard.topPriority.load()) {
+        shard.topPriority.store(priority);
+    }
+}
+
+const string* BedrockCommandQueue::_affinityKey(const unique_ptr<BedrockCommand>& command) {
+    auto it = command->request.nameValueMap.find("AffinityKey");
+    return (it != command->request.nameValueMap.end() && !it->second.empty()) ? &it->second : nullptr;
+}
+
+void BedrockCommandQueue::_pushReady(unique_ptr<BedrockCommand>&& command) {
+    const string* key = _affinityKey(command);
+    if (key) {
+        // Hash to a consistent shard so a key's commands share one lane (and one FIFO).
+        Shard& shard = _shards[hash<string>{}(*key) & (SHARD_COUNT - 1)];
+        lock_guard<mutex> lock(shard.shardMutex);
+        Shard::AffinityLane& lane = shard.affinityLanes[*key];
+        if (command->affinityLaneGuard) {
+            // A requeue (conflict retry, future-commit release, completed HTTPS wait) of the command that owns
+            // this lane: it stays the owner and goes straight back to ready.
+            _enqueueReady(shard, move(command));
+        } else if (lane.inFlight || lane.queuedReady || !lane.pending.empty()) {
+            lane.pending.push_back(move(command));
+        } else {
+            lane.queuedReady = true;
+            _enqueueReady(shard, move(command));
+        }
+    } else {
+        // Distribute round-robin across the shards.
+        Shard& shard = _shards[_pushIndex.fetch_add(1) % SHARD_COUNT];
+        lock_guard<mutex> lock(shard.shardMutex);
+        _enqueueReady(shard, move(command));
+    }
+}
+
+void BedrockCommandQueue::_claimAffinityLane(size_t shardIndex, unique_ptr<BedrockCommand>& command) {
+    const string* key = _affinityKey(command);
+    if (!key || command->affinityLaneGuard) {
+        // No affinity, or a requeued command that already owns its lane.
+        return;
+    }
+    Shard& shard = _shards[shardIndex];
+    auto it = shard.affinityLanes.find(*key);
+    if (it == shard.affinityLanes.end()) {
+        // No lane (the map was cleared); nothing to serialize against.
+        return;
+    }
+    it->second.queuedReady = false;
+    it->second.inFlight = true;
+
+    // The guard's destructor is what releases the lane: whenever and wherever this command is destroyed, the next
+    // parked command (if any) becomes dequeuable.
+    command->affinityLaneGuard = shared_ptr<void>(reinterpret_cast<void*>(1),
+        [this, shardIndex, laneKey = *key](void*) {
+            _releaseAffinityLane(shardIndex, laneKey);
+        });
+}
+
+void BedrockCommandQueue::_releaseAffinityLane(size_t shardIndex, const string& key) {
+    Shard& shard = _shards[shardIndex];
+    bool notify = false;
+    {
+        lock_guard<mutex> lock(shard.shardMutex);
+        auto it = shard.affinityLanes.find(key);
+        if (it == shard.affinityLanes.end()) {
+            // clear() already dropped the lane.
+            return;
+        }
+        Shard::AffinityLane& lane = it->second;
+        lane.inFlight = false;
+        if (!lane.pending.empty()) {
+            unique_ptr<BedrockCommand> next = move(lane.pending.front());
+            lane.pending.pop_front();
+            lane.queuedReady = true;
+            _enqueueReady(shard, move(next));
+            notify = true;
+        } else if (!lane.queuedReady) {
+            shard.affinityLanes.erase(it);
+        }
+    }
+    if (notify) {
+        _notify(false);
+    }
+}
+
+void BedrockCommandQueue::_drainFutureCommands(uint64_t now) {
+    lock_guard<mutex> lock(_futureMutex);
+
+    // Anything that's timed out gets returned even though it's not due yet; it will hit its timeout in a worker
+    // thread, same as a ready command that's timed out in a shard.
+    uint64_t timedOutAt = 0;
+    uint64_t timedOutScheduled = 0;
+    while (_futureCommandTimeouts.popExpired(now, timedOutAt, timedOutScheduled)) {
+        auto itPair = _futureCommands.equal_range(timedOutScheduled);
+        for (auto it = itPair.first; it != itPair.second; it++) {
+            if (it->second.timeout == timedOutAt) {
+                _pushReady(move(it->second.command));
+                _futureCommands.erase(it);
+                break;
+            }
+        }
+    }
+
+    // And move everything that's come due into the shards.
+    auto it = _futureCommands.begin();
+    while (it != _futureCommands.end() && it->first <= now) {
+        _futureCommandTimeouts.cancel(it->second.timeout, it->first);
+        _pushReady(move(it->second.command));
+        it = _futureCommands.erase(it);
+    }
+    _nextScheduled.store(_futureCommands.empty() ? UINT64_MAX : _futureCommands.begin()->first);
+}
+
+unique_ptr<BedrockCommand> BedrockCommandQueue::_tryGet() {
+    size_t own = _localShardIndex();
+
+    // A couple of optimistic passes over the lock-free hints, then one authoritative pass under the locks, so a
+    // command can't hide from a worker that races a concurrent pop.
+    for (int attempt = 0; attempt < 2; attempt++) {
+        // Find the shard advertising the highest-priority work. Starting at our own shard and requiring a strict
+        // improvement means we prefer our own shard on ties.
+        int bestPriority = -1;
+        size_t bestShard = own;
+        for (size_t i = 0; i < SHARD_COUNT; i++) {
+            size_t index = (own + i) % SHARD_COUNT;
+            int priority = _shards[index].topPriority.load();
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                bestShard = index;
+                if (priority >= BedrockCommand::PRIORITY_MAX) {
+                    break;
+                }
+            }
+        }
+        if (bestPriority < 0) {
+            return nullptr;
+        }
+
+        // Lock the winner and pop its highest-priority command, unless someone beat us to the whole shard.
+        Shard& shard = _shards[bestShard];
+        lock_guard<mutex> lock(shard.shardMutex);
+        if (shard.readyCommands.empty()) {
+            continue;
+        }
+        auto queueIt = prev(shard.readyCommands.end());
+        unique_ptr<BedrockCommand> command = move(queueIt->second.front());
+        queueIt->second.pop_front();
+        if (queueIt->second.empty()) {
+            shard.readyCommands.erase(queueIt);
+        }
+        shard.topPriority.store(shard.readyCommands.empty() ? -1 : shard.readyCommands.rbegin()->first);
+        _claimAffinityLane(bestShard, command);
+        _size--;
+        return command;
+    }
+
+    // The optimistic passes kept losing races; check every shard under its lock.
+    for (size_t i = 0; i < SHARD_COUNT; i++) {
+        Shard& shard = _shards[(own + i) % SHARD_COUNT];
+        lock_guard<mutex> lock(shard.shardMutex);
+        if (shard.readyCommands.empty()) {
+            continue;
+        }
+        auto queueIt = prev(shard.readyCommands.end());
+        unique_ptr<BedrockCommand> command = move(queueIt->second.front());
+        queueIt->second.pop_front();
+        if (queueIt->second.empty()) {
+            shard.readyCommands.erase(queueIt);
+        }
+        shard.topPriority.store(shard.readyCommands.empty() ? -1 : shard.readyCommands.rbegin()->first);
+        _claimAffinityLane((own + i) % SHARD_COUNT, command);
+        _size--;
+        return command;
+    }
+    return nullptr;
+}
+
+void BedrockCommandQueue::_notify(bool all) {
+    if (!_waiters.load()) {
+        return;
+    }
+
+    // Taking the mutex (without holding it through the notify target's wakeup) closes the window between a waiter's
+    // last emptiness check and its wait.
+    lock_guard<mutex> lock(_waitMutex);
+    if (all) {
+        _waitCondition.notify_all();
+    } else {
+        _waitCondition.notify_one();
+    }
 }
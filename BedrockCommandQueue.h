@@ -1,23 +1,181 @@
 #pragma once
 #include <libstuff/libstuff.h>
-#include <libstuff/SScheduledPriorityQueue.h>
+#include <libstuff/SStringCounts.h>
+#include <libstuff/STimerWheel.h>
 #include "BedrockCommand.h"
 
-class BedrockCommandQueue : public SScheduledPriorityQueue<unique_ptr<BedrockCommand>> {
+// A sharded command queue. Ready commands live in per-shard priority deques, each guarded by its own mutex: a worker
+// dequeues from the shard its thread hashes to and steals from the others when its own is empty, so at high worker
+// counts threads mostly touch disjoint locks instead of serializing on one queue mutex (formerly our hottest lock
+// after the commit lock). Only future-scheduled commands (`commandExecuteTime`) keep a centralized ordered structure,
+// which is drained into the shards as commands come due.
+//
+// Priority semantics are preserved per shard exactly, and globally via a per-shard top-priority hint: a dequeuing
+// worker takes from the shard advertising the highest-priority work, preferring its own shard on ties. Unlike
+// SScheduledPriorityQueue, a timed-out command no longer jumps the queue; workers already check `isTimedOut` on every
+// command they dequeue, which is where timeouts are actually handled.
+//
+// Commands carrying an `AffinityKey` request header opt into serialization: they hash to a consistent shard, and at
+// most one command per key is dequeuable (or in flight) at a time - the rest park in that key's lane, FIFO, until the
+// in-flight one is destroyed. Clients stamp natural conflict groups (a job worker's heartbeat stream, say) with a
+// shared key so they run one at a time instead of racing each other to conflict at commit.
+class BedrockCommandQueue {
   public:
+    // If nothing becomes available to dequeue while waiting, a timeout_error exception is thrown.
+    class timeout_error : exception {
+      public:
+        const char* what() const noexcept {
+            return "timeout";
+        }
+    };
+
     BedrockCommandQueue();
 
     // Functions to start and stop timing on the commands when they're inserted/removed from the queue.
     static void startTiming(unique_ptr<BedrockCommand>& command);
     static void stopTiming(unique_ptr<BedrockCommand>& command);
-    
-    // Returns a list of all the method lines for all the requests currently queued. This function exists for state
-    // reporting, and is called by BedrockServer when we receive a `Status` command.
+
+    // Returns a list of all the method lines for all the requests currently queued. This walks every shard under its
+    // lock, so it's reserved for `Status?detail=full` and shutdown logging; normal state reporting uses
+    // getMethodLineCounts.
     list<string> getRequestMethodLines();
 
+    // Returns approximate counts of queued requests by method line, from counters maintained on push/pop, without
+    // touching the shard locks.
+    map<string, int64_t> getMethodLineCounts();
+
     // Discards all commands scheduled more than msInFuture milliseconds after right now.
     void abandonFutureCommands(int msInFuture);
 
     // Add an item to the queue. The queue takes ownership of the item and the caller's copy is invalidated.
     void push(unique_ptr<BedrockCommand>&& command);
+
+    // Add a batch of commands, grouping the per-shard lock acquisitions and waking every waiting consumer once.
+    // The vector is emptied.
+    void push(vector<unique_ptr<BedrockCommand>>&& commands);
+
+    // Get a command from the queue. Optionally, a timeout can be specified.
+    // If timeout is non-zero, a timeout_error exception will be thrown after waitUS microseconds, if no work was
+    // available.
+    unique_ptr<BedrockCommand> get(uint64_t waitUS = 0);
+
+    // Recently observed queue wait (in microseconds) for commands at the given priority: an EWMA over the
+    // `QUEUE_WORKER` intervals closed at dequeue, kept per priority level since higher-priority commands wait less.
+    // This is what admission control (see BedrockServer) projects an incoming command's wait from. Zero until a
+    // command at that priority has been dequeued.
+    uint64_t recentQueueWaitUS(int priority) const;
+
+    // Returns true if there are no queued commands.
+    bool empty();
+
+    // Returns the size of the queue.
+    size_t size();
+
+    // Remove all items from the queue.
+    void clear();
+
+  private:
+    // Power of two so a thread ID hashes to a shard with a mask. More shards than we expect concurrent pushers or
+    // poppers to usually collide on, while keeping the steal scan short.
+    static const size_t SHARD_COUNT = 16;
+
+    struct Shard {
+        // Ready commands at each priority, FIFO within a priority. Sparse map because BedrockCommand::Priority
+        // values are sparse.
+        map<int, deque<unique_ptr<BedrockCommand>>> readyCommands;
+
+        // One serialization lane per AffinityKey that hashes to this shard. At most one of a lane's commands is in
+        // readyCommands or in flight at a time (`queuedReady`/`inFlight`); the rest wait in `pending`, FIFO,
+        // bypassing priority ordering since serialization implies their order anyway. An idle lane is erased.
+        struct AffinityLane {
+            deque<unique_ptr<BedrockCommand>> pending;
+            bool inFlight = false;
+            bool queuedReady = false;
+        };
+        map<string, AffinityLane> affinityLanes;
+
+        // The highest priority with a non-empty deque, or -1 if the shard is empty. Readable without the lock so a
+        // dequeuing worker can pick a shard before committing to a mutex.
+        atomic<int> topPriority{-1};
+
+        mutex shardMutex;
+    };
+
+    // A future-scheduled command bundled with its scheduling parameters, for the centralized structure.
+    struct FutureCommand {
+        FutureCommand(unique_ptr<BedrockCommand>&& _command, uint64_t _timeout)
+          : command(move(_command)), timeout(_timeout) {}
+        unique_ptr<BedrockCommand> command;
+        uint64_t timeout;
+    };
+
+    // Returns the shard index this thread prefers, assigned round-robin the first time each thread asks.
+    static size_t _localShardIndex();
+
+    // Maps a priority value to an index into _recentWaitUS: one bucket per BedrockCommand::Priority level.
+    static size_t _waitBucket(int priority);
+
+    // Folds the QUEUE_WORKER interval stopTiming just closed on this command into its priority's wait EWMA.
+    void _recordQueueWait(const unique_ptr<BedrockCommand>& command);
+
+    // Appends to the given shard's ready deques. Caller must hold the shard's mutex.
+    void _enqueueReady(Shard& shard, unique_ptr<BedrockCommand>&& command);
+
+    // Returns a pointer to the command's AffinityKey header value, or null if it doesn't carry one.
+    static const string* _affinityKey(const unique_ptr<BedrockCommand>& command);
+
+    // Routes a ready (due-now) command to its shard: AffinityKey commands hash to a consistent shard and may park
+    // in their lane, everything else round-robins. Takes the destination shard's lock; the caller must not hold it.
+    void _pushReady(unique_ptr<BedrockCommand>&& command);
+
+    // Marks a just-popped command's lane in flight and attaches the release guard. Caller must hold the shard's
+    // mutex; a no-op for commands without a key, and for requeued commands that still own their lane.
+    void _claimAffinityLane(size_t shardIndex, unique_ptr<BedrockCommand>& command);
+
+    // Called when a lane's in-flight command is destroyed: readies the next parked command, or retires the lane.
+    void _releaseAffinityLane(size_t shardIndex, const string& key);
+
+    // Moves any due (or timed-out) future-scheduled commands into the shards.
+    void _drainFutureCommands(uint64_t now);
+
+    // Pops the best ready command across all shards, or nullptr if everything's empty. Prefers the shard advertising
+    // the highest priority, breaking ties toward this thread's own shard.
+    unique_ptr<BedrockCommand> _tryGet();
+
+    // Wakes one waiting consumer (or all of them, for batches).
+    void _notify(bool all);
+
+    Shard _shards[SHARD_COUNT];
+
+    // The centralized ordered structure for commands scheduled in the future, keyed by scheduled time, with a timer
+    // wheel of their timeouts: a command whose timeout fires before its scheduled time still gets returned, where it
+    // will time out in a worker thread.
+    multimap<uint64_t, FutureCommand> _futureCommands;
+    STimerWheel<uint64_t> _futureCommandTimeouts;
+    mutex _futureMutex;
+
+    // The earliest scheduled time in _futureCommands (UINT64_MAX when empty), readable without _futureMutex so the
+    // hot path can skip the drain entirely.
+    atomic<uint64_t> _nextScheduled{UINT64_MAX};
+
+    // Total commands queued, across the shards and the future structure.
+    atomic<size_t> _size{0};
+
+    // Approximate per-method-line counts of everything queued, so `Status` doesn't need to walk the shards.
+    SStringCounts _methodLineCounts;
+
+    // Per-priority-level queue wait EWMAs (weighted 7/8 old, 1/8 new sample), updated at dequeue. Plain loads and
+    // stores; a racing update losing a sample only delays the average by one dequeue, which doesn't matter for a
+    // statistic.
+    atomic<uint64_t> _recentWaitUS[5] = {};
+
+    // Consumers with nothing to do sleep here. The mutex guards no data; it exists so a push can't slip between a
+    // consumer's last emptiness check and its wait.
+    mutex _waitMutex;
+    condition_variable _waitCondition;
+    atomic<size_t> _waiters{0};
+
+    // Round-robin distribution counters: one for pushes, one for assigning threads their preferred shard.
+    atomic<size_t> _pushIndex{0};
+    static atomic<size_t> _threadIndex;
 };
@@ -0,0 +1,68 @@
+#include <libstuff/libstuff.h>
+#include <libstuff/SMetrics.h>
+#include "BedrockConflictManager.h"
+
+void BedrockConflictManager::recordConflict(const set<string>& tables) {
+    static atomic<uint64_t>& conflictCount = SMetrics::counter("conflict.count");
+    conflictCount++;
+    uint64_t now = STimeNow();
+    lock_guard<mutex> lock(_mutex);
+    for (const auto& table : tables) {
+        TableCounts& counts = _countsByTable[table];
+        _decay(counts, now);
+        counts.conflicts++;
+    }
+}
+
+void BedrockConflictManager::recordSuccess(const set<string>& tables) {
+    uint64_t now = STimeNow();
+    lock_guard<mutex> lock(_mutex);
+    for (const auto& table : tables) {
+        // Only decay tables we've already seen conflict, there's no point tracking every quiet table in the schema.
+        auto it = _countsByTable.find(table);
+        if (it != _countsByTable.end()) {
+            _decay(it->second, now);
+            it->second.successes++;
+        }
+    }
+}
+
+bool BedrockConflictManager::shouldSerialize(const set<string>& tables) {
+    static atomic<uint64_t>& serializedCount = SMetrics::counter("conflict.serializedCount");
+    uint64_t now = STimeNow();
+    lock_guard<mutex> lock(_mutex);
+    for (const auto& table : tables) {
+        auto it = _countsByTable.find(table);
+        if (it == _countsByTable.end()) {
+            continue;
+        }
+        TableCounts& counts = it->second;
+        _decay(counts, now);
+
+        // Hot means conflicts are at least keeping pace with successes, with enough recent samples to mean it.
+        if (counts.conflicts >= MIN_CONFLICTS && counts.conflicts >= counts.successes) {
+            serializedCount++;
+            SINFO("Table '" << table << "' is conflict-hot (" << counts.conflicts << " conflicts vs "
+                  << counts.successes << " successes), serializing.");
+            return true;
+        }
+    }
+    return false;
+}
+
+void BedrockConflictManager::_decay(TableCounts& counts, uint64_t now) {
+    if (!counts.lastDecay) {
+        counts.lastDecay = now;
+        return;
+    }
+    while (counts.lastDecay + DECAY_INTERVAL < now) {
+        if (!counts.conflicts && !counts.successes) {
+            // Nothing left to decay, just catch the timestamp up.
+            counts.lastDecay = now;
+            return;
+        }
+        counts.conflicts /= 2;
+        counts.successes /= 2;
+        counts.lastDecay += DECAY_INTERVAL;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <libstuff/libstuff.h>
+
+// Tracks, per table, how often parallel worker commits hit SQLITE_BUSY_SNAPSHOT conflicts, and decides whether
+// commands writing conflict-hot tables should skip their parallel retries and be serialized through the blocking
+// queue instead. Counts decay over time, so when a conflict storm subsides, the affected tables return to normal
+// parallel processing.
+class BedrockConflictManager {
+  public:
+    // Record the outcome of a parallel worker commit attempt for the given set of written tables.
+    void recordConflict(const set<string>& tables);
+    void recordSuccess(const set<string>& tables);
+
+    // Returns true if any of the given tables is currently conflict-hot, i.e., commits against it have recently been
+    // conflicting more often than succeeding. Callers should route such commands to the blocking queue rather than
+    // burning parallel retries that will likely just conflict again.
+    bool shouldSerialize(const set<string>& tables);
+
+  private:
+    // Counts are halved each time this interval elapses, so "hot" is a recency-weighted judgement rather than a
+    // lifetime one.
+    static constexpr uint64_t DECAY_INTERVAL = 10 * STIME_US_PER_S;
+
+    // A table isn't considered hot until it has at least this many recent conflicts, regardless of its conflict
+    // fraction, so that a single collision on a quiet table doesn't serialize it.
+    static constexpr uint64_t MIN_CONFLICTS = 3;
+
+    struct TableCounts {
+        uint64_t conflicts = 0;
+        uint64_t successes = 0;
+        uint64_t lastDecay = 0;
+    };
+
+    // Apply any pending decay to the given counts. Must be called with _mutex held.
+    void _decay(TableCounts& counts, uint64_t now);
+
+    mutex _mutex;
+    map<string, TableCounts> _countsByTable;
+};
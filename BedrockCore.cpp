@@ -70,6 +70,18 @@ BedrockCore::RESULT BedrockCore::peekCommand(unique_ptr<BedrockCommand>& command
     BedrockServer::ScopedStateSnapshot snapshot(_server);
     command->lastPeekedOrProcessedInState = _server.getState();
 
+    // If a follower attached its own peek's conclusion to this escalated command — the tables that peek read, and
+    // the commit count of the snapshot it read them at — and our write history proves none of those tables changed
+    // after that commit, then the conclusion (this command needs `process`) still holds, and we skip re-running
+    // `peek` entirely.
+    if (command->speculativePeekCommitCount && !command->repeek && !command->continuation &&
+        _db.tablesUnmodifiedSince(command->speculativePeekTables, command->speculativePeekCommitCount)) {
+        SINFO("Speculative peek of '" << command->request.methodLine << "' at commit "
+              << command->speculativePeekCommitCount << " still valid, skipping peek.");
+        command->peekCount++;
+        return RESULT::SHOULD_PROCESS;
+    }
+
     // Convenience references to commonly used properties.
     const SData& request = command->request;
     SData& response = command->response;
@@ -77,6 +89,12 @@ BedrockCore::RESULT BedrockCore::peekCommand(unique_ptr<BedrockCommand>& command
 
     // We catch any exception and handle in `_handleCommandException`.
     RESULT returnValue = RESULT::COMPLETE;
+
+    // If we're resuming a suspended command, its continuation is moved out here before it's invoked, so one that
+    // doesn't suspend again leaves the command in the normal flow. Declared at this scope so the checkpoint handler
+    // below can put it back: an abandoned resume did nothing durable (the transaction is rolled back), and the retry
+    // should resume from the same point, not re-run `peek` from the top.
+    function<bool(SQLite&)> continuation;
     try {
         SDEBUG("Peeking at '" << request.methodLine << "' with priority: " << command->priority);
         uint64_t timeout = _getRemainingTime(command);
@@ -95,13 +113,38 @@ BedrockCore::RESULT BedrockCore::peekCommand(unique_ptr<BedrockCommand>& command
             // Make sure no writes happen while in peek command
             _db.read("PRAGMA query_only = true;");
 
+            // On followers, collect the peek's read set: if the peek concludes the command needs `process`, we
+            // escalate that conclusion along with its evidence, so leader may be able to skip its own peek. Not
+            // worth the bookkeeping for commands that make HTTPS requests or that are resuming a continuation, which
+            // leader has to peek itself anyway.
+            bool captureReadSet = _server.getState() == SQLiteNode::FOLLOWING && command->httpsRequests.empty() &&
+                                  !command->continuation;
+            if (captureReadSet) {
+                _db.trackReadTables(true);
+            }
+
             // Peek.
             command->reset(BedrockCommand::STAGE::PEEK);
-            bool completed = command->peek(_db);
-            SDEBUG("Plugin '" << command->getName() << "' peeked command '" << request.methodLine << "'");
+            bool completed;
+            if (command->continuation) {
+                // Resume a suspended command exactly where it left off rather than re-running `peek` from the top.
+                continuation = move(command->continuation);
+                command->continuation = nullptr;
+                completed = continuation(_db);
+                SDEBUG("Plugin '" << command->getName() << "' resumed command '" << request.methodLine << "'");
+            } else {
+                completed = command->peek(_db);
+                SDEBUG("Plugin '" << command->getName() << "' peeked command '" << request.methodLine << "'");
+            }
 
             if (!completed) {
                 SINFO("Command '" << request.methodLine << "' not finished in peek, re-queuing.");
+                if (captureReadSet && command->httpsRequests.empty()) {
+                    // Attach the evidence for the "needs process" conclusion to the command, for escalation.
+                    command->speculativePeekTables = _db.getReadTables();
+                    command->speculativePeekCommitCount = _db.getDBCountAtStart();
+                }
+                _db.trackReadTables(false);
                 _db.resetTiming();
                 _db.read("PRAGMA query_only = false;");
                 return RESULT::SHOULD_PROCESS;
@@ -137,17 +180,25 @@ BedrockCore::RESULT BedrockCore::peekCommand(unique_ptr<BedrockCommand>& command
         }
     } catch (const SException& e) {
         command->repeek = false;
+        command->continuation = nullptr;
         _handleCommandException(command, e);
     } catch (const SHTTPSManager::NotLeading& e) {
         command->repeek = false;
+        command->continuation = nullptr;
         returnValue = RESULT::SHOULD_PROCESS;
         SINFO("Command '" << request.methodLine << "' wants to make HTTPS request, queuing for processing.");
     } catch (const SQLite::checkpoint_required_error& e) {
         command->repeek = false;
+        // An abandoned resume did nothing durable (the transaction rolls back below), so put the continuation back
+        // for the retry to resume from the same point — unless the resume already re-armed a new one.
+        if (continuation && !command->continuation) {
+            command->continuation = move(continuation);
+        }
         returnValue = RESULT::ABANDONED_FOR_CHECKPOINT;
         SINFO("[checkpoint] Command " << command->request.methodLine << " abandoned (peek) for checkpoint");
     } catch (...) {
         command->repeek = false;
+        command->continuation = nullptr;
         SALERT("Unhandled exception typename: " << SGetCurrentExceptionName() << ", command: " << request.methodLine);
         command->response.methodLine = "500 Unhandled Exception";
     }
@@ -156,6 +207,7 @@ BedrockCore::RESULT BedrockCore::peekCommand(unique_ptr<BedrockCommand>& command
     command->complete = returnValue == RESULT::COMPLETE;
 
     // Back out of the current transaction, it doesn't need to do anything.
+    _db.trackReadTables(false);
     _db.rollback();
     _db.resetTiming();
 
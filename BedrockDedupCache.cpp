@@ -0,0 +1,37 @@
+#include "BedrockDedupCache.h"
+
+void BedrockDedupCache::store(const string& key, const SData& response) {
+    uint64_t now = STimeNow();
+    lock_guard<mutex> lock(_mutex);
+
+    // Drop expired entries from the old end, and then oldest live ones if we're still at the cap. A stale order
+    // record (its key was re-stored with a later expiry) is skipped rather than evicted.
+    while (!_insertionOrder.empty() &&
+           (_insertionOrder.front().first <= now || _entries.size() >= MAX_ENTRIES)) {
+        auto entryIt = _entries.find(_insertionOrder.front().second);
+        if (entryIt != _entries.end() && entryIt->second.expiresUS == _insertionOrder.front().first) {
+            _entries.erase(entryIt);
+        }
+        _insertionOrder.pop_front();
+    }
+
+    uint64_t expiresUS = now + TTL_US;
+    _entries[key] = {expiresUS, response};
+    _insertionOrder.emplace_back(expiresUS, key);
+}
+
+bool BedrockDedupCache::lookup(const string& key, SData& response) {
+    uint64_t now = STimeNow();
+    lock_guard<mutex> lock(_mutex);
+    auto entryIt = _entries.find(key);
+    if (entryIt == _entries.end()) {
+        return false;
+    }
+    if (entryIt->second.expiresUS <= now) {
+        // Expired; its order record will age out of the list on a future store.
+        _entries.erase(entryIt);
+        return false;
+    }
+    response = entryIt->second.response;
+    return true;
+}
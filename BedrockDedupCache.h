@@ -0,0 +1,36 @@
+#pragma once
+#include <libstuff/libstuff.h>
+
+// A bounded, time-limited cache of final responses for commands that carried an `IdempotencyKey` request header.
+// Client timeouts cause retries of commands that actually committed, and each plugin used to defend against that
+// ad-hoc (or not at all), paying the double-processing and the conflict retries that duplicate writes cause during
+// timeout storms. Instead, BedrockServer stores the final response of any keyed command here as it replies, and a
+// retry presenting the same key (scoped by method line) is answered straight from the cache without ever being
+// dispatched. Keys are client-chosen; two different commands sharing a key get each other's responses, which is the
+// same contract every idempotency-key scheme has.
+class BedrockDedupCache {
+  public:
+    // How long a stored response stays answerable, and how many responses we'll hold. Oldest-first eviction; at the
+    // cap, storing a new response pushes out the oldest one even if it hasn't expired.
+    static const uint64_t TTL_US = 5 * 60 * STIME_US_PER_S;
+    static const size_t MAX_ENTRIES = 10'000;
+
+    // Stores the final response for a key, replacing any existing entry (and refreshing its TTL).
+    void store(const string& key, const SData& response);
+
+    // If the key has an unexpired response, copies it into `response` and returns true.
+    bool lookup(const string& key, SData& response);
+
+  private:
+    struct Entry {
+        uint64_t expiresUS;
+        SData response;
+    };
+
+    // Entries by key, plus the insertion order as (expiresUS, key) pairs, oldest first, which is what store prunes
+    // and evicts from. A key stored twice leaves its older order record behind; the expiry stamp tells the pruner
+    // the record is stale so it doesn't evict the newer entry.
+    map<string, Entry> _entries;
+    list<pair<uint64_t, string>> _insertionOrder;
+    mutex _mutex;
+};
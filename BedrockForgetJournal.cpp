@@ -0,0 +1,176 @@
+#include <libstuff/libstuff.h>
+#include "BedrockForgetJournal.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+BedrockForgetJournal::BedrockForgetJournal(const string& filename, uint64_t size) : _size(size) {
+    // The ring needs room for the header and at least one reasonable entry.
+    SASSERT(_size > sizeof(Header) + 4096);
+
+    // Open (creating if needed) and size the file. A short or oversized file is resized; existing contents within
+    // the new size are validated below.
+    _fd = open(filename.c_str(), O_RDWR | O_CREAT, 0666);
+    if (_fd < 0) {
+        SWARN("Couldn't open forget journal '" << filename << "' (" << strerror(errno) << "), running unjournaled.");
+        return;
+    }
+    struct stat st = {};
+    bool isNew = fstat(_fd, &st) == 0 && st.st_size == 0;
+    if (ftruncate(_fd, _size)) {
+        SWARN("Couldn't size forget journal '" << filename << "' (" << strerror(errno) << "), running unjournaled.");
+        close(_fd);
+        _fd = -1;
+        return;
+    }
+    void* map = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (map == MAP_FAILED) {
+        SWARN("Couldn't map forget journal '" << filename << "' (" << strerror(errno) << "), running unjournaled.");
+        close(_fd);
+        _fd = -1;
+        return;
+    }
+    _map = static_cast<uint8_t*>(map);
+    _header = reinterpret_cast<Header*>(_map);
+
+    // A fresh file gets an empty ring. An existing file is only trusted if its header is internally consistent;
+    // anything else (torn writes from a crash mid-initialize, an old version, a resized file) is discarded -- the
+    // worst case is replaying nothing, which is no worse than not having a journal.
+    lock_guard<mutex> lock(_mutex);
+    if (isNew) {
+        _initialize();
+    } else if (_header->magic != MAGIC || _header->version != FORMAT_VERSION || _header->size != _size ||
+               _header->head < sizeof(Header) || _header->head > _size ||
+               _header->tail < sizeof(Header) || _header->tail > _size) {
+        SWARN("Forget journal '" << filename << "' header invalid, reinitializing empty.");
+        _initialize();
+    }
+}
+
+BedrockForgetJournal::~BedrockForgetJournal() {
+    if (_map) {
+        munmap(_map, _size);
+    }
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+void BedrockForgetJournal::_initialize() {
+    memset(_map, 0, sizeof(Header));
+    _header->head = sizeof(Header);
+    _header->tail = sizeof(Header);
+    _header->count = 0;
+    _header->size = _size;
+    _header->version = FORMAT_VERSION;
+
+    // The magic goes last, so a crash mid-initialize leaves a header that fails validation rather than one that
+    // looks empty with garbage fields.
+    _header->magic = MAGIC;
+}
+
+int64_t BedrockForgetJournal::append(const SData& request) {
+    if (!_map) {
+        return -1;
+    }
+    string payload = request.serializeBinary();
+    uint64_t need = ENTRY_OVERHEAD + payload.size();
+    lock_guard<mutex> lock(_mutex);
+
+    // Not enough contiguous room before the end of the file? Leave a wrap marker (when there's room for one; a
+    // remainder too small for even a length field wraps implicitly) and continue from the top.
+    uint64_t tail = _header->tail;
+    if (_size - tail < need) {
+        // Wrapping is only possible if the live region sits strictly below us, leaving the top free.
+        if (_header->count && _header->head <= tail && sizeof(Header) + need < _header->head) {
+            if (_size - tail >= 4) {
+                *reinterpret_cast<uint32_t*>(_map + tail) = UINT32_MAX;
+            }
+            tail = sizeof(Header);
+        } else if (!_header->count) {
+            // Empty ring: reclaim the whole data region.
+            _header->head = sizeof(Header);
+            tail = sizeof(Header);
+            if (_size - tail < need) {
+                return -1; // Bigger than the whole ring.
+            }
+        } else {
+            return -1;
+        }
+    } else if (_header->count && _header->head > tail && _header->head - tail <= need) {
+        // We're below the live region and would catch the head; tail must never reach head while entries remain.
+        return -1;
+    }
+
+    // Write the entry and publish it by advancing the tail.
+    int64_t offset = tail;
+    *reinterpret_cast<uint32_t*>(_map + tail) = (uint32_t)payload.size();
+    _map[tail + 4] = PENDING;
+    memcpy(_map + tail + ENTRY_OVERHEAD, payload.data(), payload.size());
+    _header->tail = tail + need;
+    _header->count++;
+    return offset;
+}
+
+void BedrockForgetJournal::markComplete(int64_t offset) {
+    if (!_map || offset < (int64_t)sizeof(Header) || offset + ENTRY_OVERHEAD > (int64_t)_size) {
+        return;
+    }
+    lock_guard<mutex> lock(_mutex);
+    _map[offset + 4] = DONE;
+
+    // Advance the head past completed entries. Completion is mostly in-order, so this usually frees the slot we
+    // just marked; out-of-order completions are freed later, when everything ahead of them finishes.
+    while (_header->count) {
+        uint64_t head = _header->head;
+        if (_size - head < ENTRY_OVERHEAD || *reinterpret_cast<uint32_t*>(_map + head) == UINT32_MAX) {
+            _header->head = sizeof(Header);
+            continue;
+        }
+        uint32_t length = *reinterpret_cast<uint32_t*>(_map + head);
+        if (_map[head + 4] != DONE) {
+            break;
+        }
+        _header->head = head + ENTRY_OVERHEAD + length;
+        _header->count--;
+    }
+    if (!_header->count) {
+        _header->head = sizeof(Header);
+        _header->tail = sizeof(Header);
+    }
+}
+
+list<pair<int64_t, SData>> BedrockForgetJournal::replay() {
+    list<pair<int64_t, SData>> pending;
+    if (!_map) {
+        return pending;
+    }
+    lock_guard<mutex> lock(_mutex);
+    uint64_t at = _header->head;
+    for (uint64_t seen = 0; seen < _header->count; seen++) {
+        if (_size - at < ENTRY_OVERHEAD || *reinterpret_cast<uint32_t*>(_map + at) == UINT32_MAX) {
+            at = sizeof(Header);
+        }
+        uint32_t length = *reinterpret_cast<uint32_t*>(_map + at);
+        if (at + ENTRY_OVERHEAD + length > _size) {
+            // A torn entry means everything past it is suspect; take what we have and start the ring over.
+            SWARN("Forget journal entry at " << at << " is torn, discarding it and " << (_header->count - seen)
+                  << " entries after it.");
+            _initialize();
+            return pending;
+        }
+        if (_map[at + 4] == PENDING) {
+            SData request;
+            if (request.deserialize(reinterpret_cast<const char*>(_map + at + ENTRY_OVERHEAD), length)) {
+                pending.emplace_back(at, move(request));
+            } else {
+                // Unparseable but intact-looking: complete it so it doesn't wedge the head forever.
+                SWARN("Forget journal entry at " << at << " doesn't parse, skipping it.");
+                _map[at + 4] = DONE;
+            }
+        }
+        at += ENTRY_OVERHEAD + length;
+    }
+    return pending;
+}
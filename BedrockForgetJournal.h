@@ -0,0 +1,72 @@
+#pragma once
+#include <libstuff/libstuff.h>
+
+// A crash-safe intake journal for `Connection: forget` commands. Those commands are acknowledged with a 202 the
+// moment they're parsed, but until now lived only in the in-RAM command queue, so a crash between the ack and the
+// commit silently dropped them. When enabled (`-forgetJournal <path>`), each accepted forget command is appended to
+// a memory-mapped ring file before it's queued, marked complete when the server finishes with it, and any entries
+// still pending at startup are replayed into the queue, so a crash loses nothing that was acknowledged.
+//
+// Durability model: writes land in the mapped pages and are flushed by the kernel on its own schedule -- there is
+// deliberately no fsync/msync per command, so the append costs a memcpy. This survives a process crash (the page
+// cache outlives us) but not a power loss, which matches the at-least-once guarantee of the external queueing
+// systems this traffic is moving off of. Replayed commands may therefore occasionally run twice; forget traffic is
+// expected to tolerate that, as it already must with any at-least-once queue.
+//
+// The file is a fixed-size ring: a small header holding head/tail offsets, then entries of
+// [uint32 length][uint8 state][serialized request]. `markComplete` flips the state byte in place and advances the
+// head past any contiguous run of completed entries, which is what "truncates" the journal; entries complete
+// mostly in order, so the ring stays near-empty in steady state. A full ring fails the append, and the caller just
+// queues the command unjournaled -- availability beats durability for this traffic.
+class BedrockForgetJournal {
+  public:
+    // Maps the journal file, creating and initializing it if it doesn't exist. If the file exists but is corrupt or
+    // was created with different parameters, it's reinitialized empty (with a warning) rather than trusted.
+    BedrockForgetJournal(const string& filename, uint64_t size = DEFAULT_SIZE);
+    ~BedrockForgetJournal();
+
+    // Returns whether the file mapped successfully. When false, every other call is a harmless no-op, so the server
+    // can run un-journaled rather than refuse to start.
+    bool ok() const { return _map != nullptr; }
+
+    // Appends a serialized request as a pending entry. Returns the entry's offset (to pass to `markComplete`), or
+    // -1 if the ring is full or the journal isn't mapped.
+    int64_t append(const SData& request);
+
+    // Marks the entry at the given offset complete and advances the head past any contiguous completed prefix.
+    void markComplete(int64_t offset);
+
+    // Returns every entry still pending, oldest first, paired with its offset so completion can be recorded against
+    // the same slot. Called once at startup, before new commands are accepted.
+    list<pair<int64_t, SData>> replay();
+
+    static const uint64_t DEFAULT_SIZE = 64 * 1024 * 1024;
+
+  private:
+    // On-disk header at offset 0. `head`/`tail` delimit the live region; `count` disambiguates head == tail (empty
+    // vs full), since the ring never lets tail catch head while entries remain.
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t size;
+        uint64_t head;
+        uint64_t tail;
+        uint64_t count;
+    };
+    static const uint32_t MAGIC = 0xBDF06E7A;
+    static const uint32_t FORMAT_VERSION = 1;
+    static const size_t ENTRY_OVERHEAD = 5; // uint32 length + uint8 state.
+
+    // Entry states. A length of UINT32_MAX is a wrap marker: the next entry starts back at the top of the ring.
+    static const uint8_t PENDING = 1;
+    static const uint8_t DONE = 2;
+
+    // Resets the header to an empty ring. Must be called with _mutex held.
+    void _initialize();
+
+    mutex _mutex;
+    uint8_t* _map = nullptr;
+    Header* _header = nullptr;
+    uint64_t _size = 0;
+    int _fd = -1;
+};
@@ -65,10 +65,23 @@ const string& BedrockPlugin::getName() const {
     SERROR("No name defined by this plugin, aborting.");
 }
 
+const set<string, STableComp>& BedrockPlugin::supportedVerbs() const {
+    static const set<string, STableComp> none;
+    return none;
+}
+
 bool BedrockPlugin::preventAttach() {
     return false;
 }
 
 void BedrockPlugin::timerFired(SStopwatch* timer) {}
 
+void BedrockPlugin::holdCommand(unique_ptr<BedrockCommand>&& command) {
+    SWARN("Command '" << command->request.methodLine << "' requested a hold, but " << getName()
+          << " doesn't hold commands, re-queueing.");
+    server.acceptCommand(unique_ptr<SQLiteCommand>(move(command)), false);
+}
+
 void BedrockPlugin::upgradeDatabase(SQLite& db) {}
+
+void BedrockPlugin::onPrepareToLead(SQLite& db) {}
@@ -35,9 +35,20 @@ class BedrockPlugin {
     // Return a command, or a null pointer if this plugin can't handle this request.
     virtual unique_ptr<BedrockCommand> getCommand(SQLiteCommand&& baseCommand) = 0;
 
+    // The fixed set of request verbs this plugin's getCommand claims, used to build the server's dispatch index at
+    // startup. Plugins that match on anything other than an exact verb (like a methodLine prefix) advertise
+    // whatever fixed verbs they have (possibly none, the default) and are still probed via getCommand for the
+    // rest.
+    virtual const set<string, STableComp>& supportedVerbs() const;
+
     // Called at some point during initiation to allow the plugin to verify/change the database schema.
     virtual void upgradeDatabase(SQLite& db);
 
+    // Called on the sync thread when this node's standup has been approved, just before it starts accepting LEADING
+    // traffic. Standup blocks until this returns, so plugins can warm caches or other hot structures (e.g., by
+    // touching the B-trees their busiest queries read) without racing the first wave of commands.
+    virtual void onPrepareToLead(SQLite& db);
+
     // A list of SHTTPSManagers that the plugin would like the server to watch for activity. It is only guaranteed to
     // be safe to modify this list during `initialize`.
     list<SHTTPSManager*> httpsManagers;
@@ -47,6 +58,28 @@ class BedrockPlugin {
     set<SStopwatch*> timers;
     virtual void timerFired(SStopwatch* timer);
 
+    // A unit of idle-time maintenance work (see backgroundTasks). `work` is called repeatedly with a DB handle
+    // while the server is idle. Each call should do one bounded slice -- tens of milliseconds at most, since
+    // returning load only preempts the task between slices -- and return true if there's more to do, or false when
+    // this run is finished. A finished task isn't started again until `intervalS` seconds have passed; a preempted
+    // one resumes at the next idle window.
+    struct BackgroundTask {
+        string name;
+        uint64_t intervalS = 3600;
+        function<bool(SQLite& db)> work;
+    };
+
+    // Returns this plugin's idle-time maintenance tasks. The server collects these once at startup and runs them on
+    // a background DB handle whenever the command queues have stayed empty for a few seconds. Tasks can run in any
+    // node state, so they must not write to replicated tables: a direct write outside the replication stream would
+    // diverge this node from the cluster. Reads (e.g., warming caches) and node-local housekeeping are fair game.
+    virtual list<BackgroundTask> backgroundTasks() { return {}; }
+
+    // A command whose `peek` set `requestHold` is passed here instead of being processed. The plugin takes ownership
+    // and must eventually hand the command back via `server.acceptCommand` (where it will be re-peeked). The default
+    // implementation logs a warning and re-queues immediately, as holding is only useful to plugins that implement it.
+    virtual void holdCommand(unique_ptr<BedrockCommand>&& command);
+
     // Below here are several functions for allowing plugins to open a port and accept their own connections.
     // Returns "host:port" on which to listen, or empty if none
     virtual string getPort() { return ""; }
@@ -1,10 +1,17 @@
 // Manages connections to a single instance of the bedrock server.
 #include <bedrockVersion.h>
 #include <libstuff/libstuff.h>
+#include <libstuff/SMetrics.h>
 #include "BedrockServer.h"
 #include "BedrockPlugin.h"
 #include "BedrockCore.h"
+#include "sqlitecluster/SQLiteClusterBridge.h"
+#include "sqlitecluster/SQLitePlanMonitor.h"
+#include "sqlitecluster/SQLiteQueryLedger.h"
+#include "sqlitecluster/SQLiteStatementTracer.h"
 #include <iomanip>
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
 
 #include <sys/time.h>
 #include <sys/resource.h>
@@ -176,6 +183,26 @@ void BedrockServer::sync(const SData& args,
         workerThreads = 2;
     }
 
+    // NUMA placement: bind the sync thread to node 0 *before* the DB pool exists. Linux allocates pages on the node
+    // of the thread that first touches them, so binding here makes the base handle's page cache — and everything
+    // else the sync thread allocates — node-local. Workers get partitioned across all nodes when they start.
+    if (args.test("-numaPlacement")) {
+        int numaNodes = SNUMANodeCount();
+        if (numaNodes > 1) {
+            server._numaNodeCount.store(numaNodes);
+            bool bound = SBindThreadToNUMANode(0);
+            if (bound) {
+                SINFO("Bound sync thread to NUMA node 0 (of " << numaNodes << ").");
+            } else {
+                SWARN("Failed to bind sync thread to NUMA node 0, leaving it unbound.");
+            }
+            lock_guard<mutex> lock(server._threadPlacementMutex);
+            server._threadPlacement[_syncThreadName] = bound ? "node0" : "unbound";
+        } else {
+            SINFO("-numaPlacement set, but this machine has one NUMA node; placement is a no-op.");
+        }
+    }
+
     // Initialize the DB.
     int64_t mmapSizeGB = args.isSet("-mmapSizeGB") ? stoll(args["-mmapSizeGB"]) : 0;
 
@@ -188,19 +215,65 @@ void BedrockServer::sync(const SData& args,
     // Initialize the command processor.
     BedrockCore core(db, server);
 
-    // And the sync node.
-    uint64_t firstTimeout = STIME_US_PER_M * 2 + SRandom::rand64() % STIME_US_PER_S * 30;
+    // And the sync node. Tests override the first election timeout (in microseconds) so that freshly-started
+    // clusters settle in milliseconds instead of waiting out the multi-minute production backoff.
+    uint64_t firstTimeout = STIME_US_PER_M * 2 + SRandom::fast64() % STIME_US_PER_S * 30;
+    if (args.isSet("-firstTimeoutUS")) {
+        firstTimeout = args.calcU64("-firstTimeoutUS");
+    }
 
     // Initialize the shared pointer to our sync node object.
     atomic_store(&server._syncNode, make_shared<SQLiteNode>(server, dbPool, args["-nodeName"], args["-nodeHost"],
                                                             args["-peerList"], args.calc("-priority"), firstTimeout,
-                                                            server._version, args.test("-parallelReplication")));
+                                                            server._version, args.test("-parallelReplication"),
+                                                            workerThreads, args["-subscribeTo"]));
 
     // This should be empty anyway, but let's make sure.
     if (server._completedCommands.size()) {
         SWARN("_completedCommands not empty at startup of sync thread.");
     }
 
+    // Set up the adaptive worker pool's range. `-workerThreads` remains the peak provisioning (and what the journal
+    // table count is sized to); `-minWorkerThreads` is how far the pool may shrink when idle, defaulting to a
+    // quarter of the maximum. We start at the maximum so a server that comes up under load doesn't have to scale up
+    // first, and shrink from there if it turns out to be idle.
+    int minWorkerThreads = args.calc("-minWorkerThreads");
+    minWorkerThreads = minWorkerThreads ? minWorkerThreads : max(2, workerThreads / 4);
+    server._minWorkerThreads = min(max(2, minWorkerThreads), workerThreads);
+    server._maxWorkerThreads = workerThreads;
+    server._activeWorkerLimit.store(workerThreads);
+
+    // Apply any tuned compression level for large peer messages; the right ratio/CPU tradeoff depends on the links
+    // between this cluster's regions, so it's an argument rather than a constant.
+    if (args.isSet("-peerCompressionLevel")) {
+        SZstdSetCompressionLevel(args.calc("-peerCompressionLevel"));
+    }
+
+    // Optionally force INDEXED BY pins for every hot statement registered with the plan monitor, rather than waiting
+    // for a detected regression, for deployments that would rather never let the planner drift on these.
+    if (args.test("-pinQueryPlans")) {
+        SQLitePlanMonitor::alwaysPin = true;
+    }
+
+    // Optionally record per-transaction statement traces, so the report of which statements extend the write-lock
+    // and commit-lock hold times (`Status` with a `statementTrace` header) has data to show.
+    if (args.test("-enableStatementTrace")) {
+        SQLiteStatementTracer::enabled = true;
+    }
+
+    // Optionally retune (or disable, with 0) the query ledger's statement sampling rate.
+    if (args.isSet("-queryLedgerSampleRate")) {
+        SQLiteQueryLedger::sampleInterval = args.calcU64("-queryLedgerSampleRate");
+    }
+
+    // If we're the leader of a disaster-recovery cluster, start the bridge that pulls the primary cluster's journal
+    // and applies it here (see SQLiteClusterBridge). It idles until this node is LEADING. Created before the workers
+    // so they can report its status without synchronization.
+    if (args.isSet("-bridgeFrom")) {
+        server._clusterBridge = make_unique<SQLiteClusterBridge>(server, dbPool, args["-nodeName"],
+                                                                 args["-bridgeFrom"], server._version);
+    }
+
     // The node is now coming up, and should eventually end up in a `LEADING` or `FOLLOWING` state. We can start adding
     // our worker threads now. We don't wait until the node is `LEADING` or `FOLLOWING`, as it's state can change while
     // it's running, and our workers will have to maintain awareness of that state anyway.
@@ -217,6 +290,16 @@ void BedrockServer::sync(const SData& args,
                                       threadId);
     }
 
+    // Start the responder thread, which serializes and sends responses for commands this thread completes, so
+    // escalation completion batches don't stall the loop below behind response I/O.
+    server._responderShouldExit.store(false);
+    thread responderThread(&BedrockServer::_responder, &server);
+
+    // Start the maintenance scheduler, which runs plugins' registered background tasks whenever the command queues
+    // go idle (see BedrockPlugin::backgroundTasks).
+    server._maintenanceShouldExit.store(false);
+    thread maintenanceThread(_maintenance, ref(dbPool), ref(server));
+
     // Now we jump into our main command processing loop.
     uint64_t nextActivity = STimeNow();
     unique_ptr<BedrockCommand> command(nullptr);
@@ -233,6 +316,16 @@ void BedrockServer::sync(const SData& args,
             SAUTOPREFIX(command->request);
         }
 
+        // Re-evaluate the adaptive worker pool. This is rate-limited internally, so calling it every loop is cheap.
+        server._scaleWorkerPool();
+
+        // Re-check registered query plans against their baselines. Also rate-limited internally.
+        SQLitePlanMonitor::check(db);
+
+        // Capture plans for any query-ledger shapes whose p99 regressed, and flush the ledger's aggregates to the
+        // log on its interval. Cheap when nothing is flagged.
+        SQLiteQueryLedger::capturePlans(db);
+
         // If there were commands waiting on our commit count to come up-to-date, we'll move them back to the main
         // command queue here. There's no place in particular that's best to do this, so we do it at the top of this
         // main loop, as that prevents it from ever getting skipped in the event that we `continue` early from a loop
@@ -245,16 +338,17 @@ void BedrockServer::sync(const SData& args,
             // First, see if anything has timed out, and move that back to the main queue.
             if (server._futureCommitCommandTimeouts.size()) {
                 uint64_t now = STimeNow();
-                auto it =  server._futureCommitCommandTimeouts.begin();
-                while (it != server._futureCommitCommandTimeouts.end() && it->first < now) {
+                uint64_t timedOutAt = 0;
+                uint64_t timedOutCommit = 0;
+                while (server._futureCommitCommandTimeouts.popExpired(now, timedOutAt, timedOutCommit)) {
                     // Find commands depending on this commit.
-                    auto itPair =  server._futureCommitCommands.equal_range(it->second);
+                    auto itPair =  server._futureCommitCommands.equal_range(timedOutCommit);
                     for (auto cmdIt = itPair.first; cmdIt != itPair.second; cmdIt++) {
                         // Check for one with this timeout.
-                        if (cmdIt->second->timeout() == it->first) {
+                        if (cmdIt->second->timeout() == timedOutAt) {
                             // This command has the right commit count *and* timeout, return it.
                             SINFO("Returning command (" << cmdIt->second->request.methodLine << ") waiting on commit " << cmdIt->first
-                                  << " to queue, timed out at: " << now << ", timeout was: " << it->first << ".");
+                                  << " to queue, timed out at: " << now << ", timeout was: " << timedOutAt << ".");
 
                             // Goes back to the main queue, where it will hit it's timeout in a worker thread.
                             server._commandQueue.push(move(cmdIt->second));
@@ -266,12 +360,6 @@ void BedrockServer::sync(const SData& args,
                             break;
                         }
                     }
-                    it++;
-                }
-
-                // And remove everything we just iterated through.
-                if (it != server._futureCommitCommandTimeouts.begin()) {
-                    server._futureCommitCommandTimeouts.erase(server._futureCommitCommandTimeouts.begin(), it);
                 }
             }
 
@@ -286,14 +374,8 @@ void BedrockServer::sync(const SData& args,
                           << " to queue, now have commit " << commitCount);
                     server._commandQueue.push(move(it->second));
 
-                    // Remove it from the timed out list as well.
-                    auto itPair = server._futureCommitCommandTimeouts.equal_range(commandTimeout);
-                    for (auto timeoutIt = itPair.first; timeoutIt != itPair.second; timeoutIt++) {
-                        if (timeoutIt->second == it->first) {
-                             server._futureCommitCommandTimeouts.erase(timeoutIt);
-                            break;
-                        }
-                    }
+                    // Remove it from the timer wheel as well.
+                    server._futureCommitCommandTimeouts.cancel(commandTimeout, it->first);
                     it++;
                 }
                 if (it != server._futureCommitCommands.begin()) {
@@ -478,16 +560,11 @@ void BedrockServer::sync(const SData& args,
                 if (command) {
                     SINFO("[performance] Sync thread finished committing command " << command->request.methodLine);
 
-                    // Otherwise, save the commit count, mark this command as complete, and reply.
+                    // Otherwise, save the commit count, mark this command as complete, and hand it to the responder
+                    // thread to reply, so this loop can get back to state-machine work immediately.
                     command->response["commitCount"] = to_string(db.getCommitCount());
                     command->complete = true;
-                    if (command->initiatingPeerID) {
-                        // This is a command that came from a peer. Have the sync node send the response back to the peer.
-                        server._finishPeerCommand(command);
-                    } else {
-                        // The only other option is this came from a client, so respond via the server.
-                        server._reply(command);
-                    }
+                    server._queueSyncResponse(move(command));
                 } else {
                     SINFO("Sync thread finished committing non-command");
                 }
@@ -521,7 +598,7 @@ void BedrockServer::sync(const SData& args,
                     SASSERT(completedCommand->complete);
                     SASSERT(completedCommand->initiatingPeerID);
                     SASSERT(!completedCommand->initiatingClientID);
-                    server._finishPeerCommand(completedCommand);
+                    server._queueSyncResponse(move(completedCommand));
                 }
             } catch (const out_of_range& e) {
                 // when _completedCommands.pop() throws for running out of commands, we fall out of the loop.
@@ -543,13 +620,8 @@ void BedrockServer::sync(const SData& args,
             // We want to run through all of the commands in our queue. However, we set a maximum limit. This list is
             // potentially infinite, as we can add new commands to the list as we iterate across it (coming from
             // workers), and we will need to break and read from the network to see what to do next at some point.
-            // Additionally, in exceptional cases, if we get stuck in this loop for more than 64k commands, we can hit
-            // the internal limit of the buffer for the pipe inside syncNodeQueuedCommands, and writes there will
-            // block, and this can cause deadlocks in various places. This is cleared every time we run `postPoll` for
-            // syncNodeQueuedCommands, which occurs when break out of this loop, so we do so periodically to avoid
-            // this.
-            // TODO: We could potentially make writes to the pipe in the queue non-blocking and help to mitigate that
-            // part of this issue as well.
+            // Breaking out with commands still queued is safe: the queue's postPoll re-arms its wakeup signal
+            // whenever commands remain, so the next poll returns immediately instead of sleeping on them.
             size_t escalateCount = 0;
             while (++escalateCount < 1000) {
                 AutoTimerTime escalateTime(escalateLoopTimer);
@@ -587,18 +659,15 @@ void BedrockServer::sync(const SData& args,
                     // have changed in the meantime.
                     // IMPORTANT: This check is omitted for commands with an HTTPS request object, because we don't want to
                     // risk duplicating that request. If your command creates an HTTPS request, it needs to explicitly
-                    // re-verify that any checks made in peek are still valid in process.
-                    if (!command->httpsRequests.size()) {
+                    // re-verify that any checks made in peek are still valid in process. A pending continuation is
+                    // the exception: resuming it doesn't re-run the code that started the request, so it's safe (and
+                    // necessary — the suspended logic has to finish before `process`).
+                    if (!command->httpsRequests.size() || command->continuation) {
                         BedrockCore::RESULT result = core.peekCommand(command, true);
                         if (result == BedrockCore::RESULT::COMPLETE) {
-                            // This command completed in peek, respond to it appropriately, either directly or by sending it
-                            // back to the sync thread.
+                            // This command completed in peek; hand it to the responder thread to reply.
                             SASSERT(command->complete);
-                            if (command->initiatingPeerID) {
-                                server._finishPeerCommand(command);
-                            } else {
-                                server._reply(command);
-                            }
+                            server._queueSyncResponse(move(command));
                             break;
                         } else if (result == BedrockCore::RESULT::SHOULD_PROCESS) {
                             // This is sort of the "default" case after checking if this command was complete above. If so,
@@ -611,6 +680,16 @@ void BedrockServer::sync(const SData& args,
                             SERROR("peekCommand (" << command->request.getVerb() << ") returned invalid result code: " << (int)result);
                         }
 
+                        // As in worker threads, a command can ask to be parked with its plugin instead of processed.
+                        if (command->requestHold) {
+                            core.rollback();
+                            command->requestHold = false;
+                            BedrockPlugin* plugin = command->getPlugin();
+                            SASSERT(plugin);
+                            plugin->holdCommand(move(command));
+                            break;
+                        }
+
                         // If we just started a new HTTPS request, save it for later.
                         if (command->httpsRequests.size()) {
                             server.waitForHTTPS(move(command));
@@ -640,12 +719,8 @@ void BedrockServer::sync(const SData& args,
                         break;
                     } else if (result == BedrockCore::RESULT::NO_COMMIT_REQUIRED) {
                         // Otherwise, the command doesn't need a commit (maybe it was an error, or it didn't have any work
-                        // to do). We'll just respond.
-                        if (command->initiatingPeerID) {
-                            server._finishPeerCommand(command);
-                        } else {
-                            server._reply(command);
-                        }
+                        // to do). We'll just respond, via the responder thread.
+                        server._queueSyncResponse(move(command));
                     } else if (result == BedrockCore::RESULT::ABANDONED_FOR_CHECKPOINT) {
                         SINFO("[checkpoint] Re-queuing abandoned command (from process) in sync thread");
                         server._commandQueue.push(move(command));
@@ -662,7 +737,18 @@ void BedrockServer::sync(const SData& args,
                     // bother peeking it again.
                     auto it = command->request.nameValueMap.find("Connection");
                     bool forget = it != command->request.nameValueMap.end() && SIEquals(it->second, "forget");
-                    server._syncNode->escalateCommand(move(command), forget);
+
+                    // Pass the command's effective priority along explicitly: leader rebuilds the command from its
+                    // serialized request and would otherwise re-derive the priority from the `priority` header alone,
+                    // losing any priority a plugin assigned directly.
+                    int priority = command->priority;
+
+                    // A forget command handed to leader is destroyed after the send (leader never responds), so it
+                    // won't pass through _reply; its journal slot is done once it's leader's responsibility.
+                    if (forget && command->forgetJournalOffset >= 0 && server._forgetJournal) {
+                        server._forgetJournal->markComplete(command->forgetJournalOffset);
+                    }
+                    server._syncNode->escalateCommand(move(command), forget, priority);
                 }
             }
             if (escalateCount == 1000) {
@@ -709,6 +795,29 @@ void BedrockServer::sync(const SData& args,
         workerThread.join();
     }
 
+    // Stop the maintenance scheduler. It checks this flag between slices, so it exits within one slice's latency.
+    server._maintenanceShouldExit.store(true);
+    SINFO("Joining maintenance thread.");
+    maintenanceThread.join();
+
+    // And the cluster bridge, which holds a handle from dbPool and so can't outlive this function. The workers that
+    // might have read its status are already gone.
+    if (server._clusterBridge) {
+        SINFO("Stopping cluster bridge.");
+        server._clusterBridge.reset();
+    }
+
+    // The workers are done, so nothing else will queue responses. Tell the responder to drain whatever's left and
+    // exit, and wait for it. The flag flips under the queue mutex so the notify can't slip between the responder's
+    // predicate check and its wait.
+    {
+        lock_guard<mutex> lock(server._responderMutex);
+        server._responderShouldExit.store(true);
+    }
+    server._responderCV.notify_one();
+    SINFO("Joining responder thread.");
+    responderThread.join();
+
     // If there's anything left in the command queue here, we'll discard it, because we have no way of processing it.
     if (server._commandQueue.size()) {
         SWARN("Sync thread shut down with " << server._commandQueue.size() << " queued commands. Commands were: "
@@ -731,6 +840,80 @@ void BedrockServer::sync(const SData& args,
     server._syncThreadComplete.store(true);
 }
 
+void BedrockServer::_maintenance(SQLitePool& dbPool, BedrockServer& server) {
+    SInitialize("maintenance");
+
+    // Collect every plugin's tasks once. Plugins are fully constructed before the sync thread starts us, and the
+    // set never changes afterward, so no locking is needed.
+    struct ScheduledTask {
+        BedrockPlugin::BackgroundTask task;
+        string pluginName;
+        uint64_t nextStartTime = 0;
+        bool inProgress = false;
+    };
+    list<ScheduledTask> tasks;
+    for (auto& p : server.plugins) {
+        for (auto& task : p.second->backgroundTasks()) {
+            tasks.push_back({move(task), p.first, 0, false});
+        }
+    }
+    if (tasks.empty()) {
+        SINFO("No background maintenance tasks registered, maintenance thread exiting.");
+        return;
+    }
+    SINFO("Maintenance scheduler watching " << tasks.size() << " background task(s).");
+
+    // Idle means every queue is empty and no commands exist anywhere in the server -- the same signals canStandDown
+    // inspects -- and it has to stay that way for a few seconds before we start working, so a momentary gap between
+    // commands doesn't trigger maintenance.
+    static const uint64_t IDLE_THRESHOLD = 5 * STIME_US_PER_S;
+    auto busy = [&server]() {
+        return server._commandQueue.size() || server._blockingCommandQueue.size() || BedrockCommand::getCommandCount();
+    };
+    uint64_t idleSince = 0;
+    while (!server._maintenanceShouldExit) {
+        usleep(250'000);
+        uint64_t now = STimeNow();
+        if (busy()) {
+            idleSince = 0;
+            continue;
+        }
+        if (!idleSince) {
+            idleSince = now;
+        }
+        if (now - idleSince < IDLE_THRESHOLD) {
+            continue;
+        }
+
+        // We're idle. Find a task that's due (or was preempted mid-run) and run it one slice at a time, re-checking
+        // for load between slices so a returning command preempts it within one slice's latency. The DB handle is
+        // checked out per run, not held across the idle wait, so it's available to a worker the rest of the time.
+        for (auto& scheduled : tasks) {
+            if (!scheduled.inProgress && now < scheduled.nextStartTime) {
+                continue;
+            }
+            SQLiteScopedHandle dbScope(dbPool, dbPool.getIndex());
+            bool more = true;
+            while (more && !server._maintenanceShouldExit && !busy()) {
+                more = scheduled.task.work(dbScope.db());
+            }
+            scheduled.inProgress = more;
+            if (more) {
+                SINFO("Background task '" << scheduled.task.name << "' (" << scheduled.pluginName
+                      << ") preempted, will resume at the next idle window.");
+            } else {
+                // Finished; don't start it again until its interval elapses.
+                scheduled.nextStartTime = STimeNow() + scheduled.task.intervalS * STIME_US_PER_S;
+                SINFO("Background task '" << scheduled.task.name << "' (" << scheduled.pluginName << ") finished.");
+            }
+
+            // One task per wakeup, so a preempting command isn't also behind the next task's first slice.
+            break;
+        }
+    }
+    SINFO("Maintenance thread exiting.");
+}
+
 void BedrockServer::worker(SQLitePool& dbPool,
                            atomic<SQLiteNode::State>& replicationState,
                            atomic<string>& leaderVersion,
@@ -742,21 +925,63 @@ void BedrockServer::worker(SQLitePool& dbPool,
     // Worker 0 is the "blockingCommit" thread.
     SInitialize(threadId ? "worker" + to_string(threadId) : "blockingCommit");
 
-    // Get a DB handle to work on. This will automatically be returned when dbScope goes out of scope.
+    // If NUMA placement is on (see sync()), partition workers round-robin across the machine's nodes before the DB
+    // handle below is checked out, so each thread's page cache slice and scratch memory are first-touched
+    // node-local. Workers cycle through every node (including the sync thread's node 0) since there are typically
+    // far more workers than nodes.
+    int numaNodes = server._numaNodeCount.load();
+    if (numaNodes > 1) {
+        int node = threadId % numaNodes;
+        bool bound = SBindThreadToNUMANode(node);
+        if (!bound) {
+            SWARN("Failed to bind worker " << threadId << " to NUMA node " << node << ", leaving it unbound.");
+        }
+        lock_guard<mutex> lock(server._threadPlacementMutex);
+        server._threadPlacement[threadId ? "worker" + to_string(threadId) : "blockingCommit"]
+            = bound ? "node" + to_string(node) : "unbound";
+    }
+
+    // Get a DB handle to work on. This will automatically be returned when dbScope goes out of scope. Note that we
+    // deliberately hold this one handle for the life of the thread rather than checking one out per command: each
+    // handle carries its own page cache slice (-cacheSize) and prepared statement cache, and pinning it to the
+    // thread keeps both warm across commands. The pool's free list is LIFO for the same reason, so even when
+    // threads restart, the most recently used (warmest) handles are handed out first.
     SQLiteScopedHandle dbScope(dbPool, dbPool.getIndex());
     SQLite& db = dbScope.db();
     BedrockCore core(db, server);
 
+    // A second, read-only handle for commands that declare themselves pure reads (see
+    // BedrockCommand::isReadOnly). It's created lazily the first time such a command is dequeued, so workers that
+    // never see one don't pay for the extra FD. These handles serve snapshot-isolated reads without ever touching
+    // the commit lock or the journal.
+    unique_ptr<SQLite> readOnlyDb;
+    unique_ptr<BedrockCore> readOnlyCore;
+
     // Command to work on. This default command is replaced when we find work to do.
     unique_ptr<BedrockCommand> command(nullptr);
 
     // Which command queue do we use? The blockingCommit thread special and does blocking commits from the blocking queue.
     BedrockCommandQueue& commandQueue = threadId ? server._commandQueue : server._blockingCommandQueue;
 
+    // Marks this thread busy from dequeue to completion for the adaptive pool's bookkeeping. RAII so every exit path
+    // from a loop iteration — the many `continue`s, exceptions, returns — decrements it.
+    struct BusyWorker {
+        atomic<int>& count;
+        BusyWorker(atomic<int>& count_) : count(count_) { count++; }
+        ~BusyWorker() { count--; }
+    };
+
     // We just run this loop looking for commands to process forever. There's a check for appropriate exit conditions
     // at the bottom, which will cause our loop and thus this thread to exit when that becomes true.
     while (true) {
         try {
+            // Park this thread if the adaptive pool has scaled below our ID (see _scaleWorkerPool). Thread 0 never
+            // parks, as it's the only consumer of the blocking queue, and parked threads wake back up for shutdown
+            // so queued commands still drain. Unparking takes effect within one sleep interval.
+            if (threadId && threadId >= server._activeWorkerLimit.load() && server._shutdownState.load() == RUNNING) {
+                usleep(100'000);
+                continue;
+            }
             // Set a signal handler function that we can call even if we die early with no command.
             SSetSignalHandlerDieFunc([&](){
                 SWARN("Die function called early with no command, probably died in `commandQueue.get`.");
@@ -771,6 +996,7 @@ void BedrockServer::worker(SQLitePool& dbPool,
             SAUTOPREFIX(command->request);
             SINFO("Dequeued command " << command->request.methodLine << " in worker, "
                   << commandQueue.size() << " commands in " << (threadId ? "" : "blocking") << " queue.");
+            BusyWorker busyWorker(server._busyWorkers);
 
             // Set the function that lets the signal handler know which command caused a problem, in case that happens.
             // If a signal is caught on this thread, which should only happen for unrecoverable, yet synchronous
@@ -790,6 +1016,19 @@ void BedrockServer::worker(SQLitePool& dbPool,
             // to be returned to the main queue, where they would have timed out in `peek`, but it was never called
             // because the commands already had a HTTPS request attached, and then they were immediately re-sent to the
             // sync queue, because of the QUORUM consistency requirement, resulting in an endless loop.
+            // Under admission control, a local command whose deadline passed while it sat in the queue gets a fast
+            // 503 here instead of falling through to the 555 the timeout machinery below produces: 503 tells the
+            // client this was overload shedding (retryable elsewhere) rather than a command failure, and skips the
+            // exception path. Escalated commands keep the existing behavior; the follower that owns the client
+            // runs its own admission control.
+            if (server._admissionControlEnabled && !command->initiatingPeerID && STimeNow() >= command->timeout()) {
+                SINFO("Shedding '" << command->request.methodLine << "' at dequeue, deadline passed while queued.");
+                command->response.methodLine = "503 Service Unavailable";
+                command->complete = true;
+                server._reply(command);
+                continue;
+            }
+
             if (core.isTimedOut(command)) {
                 if (command->initiatingPeerID) {
                     // Escalated command. Give it back to the sync thread to respond.
@@ -815,6 +1054,23 @@ void BedrockServer::worker(SQLitePool& dbPool,
                 continue;
             }
 
+            // Give the command a chance to answer entirely from memory, before any database involvement: no handle
+            // checkout, no begin/rollback pair. This is how cache hits and similar memory-resident answers skip the
+            // DB layer completely.
+            if (command->peekable()) {
+                if (command->response.methodLine.empty()) {
+                    command->response.methodLine = "200 OK";
+                }
+                command->complete = true;
+                if (command->initiatingPeerID) {
+                    // Escalated command. Give it back to the sync thread to respond.
+                    syncNodeCompletedCommands.push(move(command));
+                } else {
+                    server._reply(command);
+                }
+                continue;
+            }
+
             // If this was a command initiated by a peer as part of a cluster operation, then we process it separately
             // and respond immediately. This allows SQLiteNode to offload read-only operations to worker threads.
             if (SQLiteNode::peekPeerCommand(server._syncNode, db, *command)) {
@@ -911,7 +1167,7 @@ void BedrockServer::worker(SQLitePool& dbPool,
                 auto newQueueSize = server._futureCommitCommands.size() + 1;
                 SINFO("Command (" << command->request.methodLine << ") depends on future commit (" << commandCommitCount
                       << "), Currently at: " << commitCount << ", storing for later. Queue size: " << newQueueSize);
-                server._futureCommitCommandTimeouts.insert(make_pair(command->timeout(), commandCommitCount));
+                server._futureCommitCommandTimeouts.insert(command->timeout(), commandCommitCount);
                 server._futureCommitCommands.insert(make_pair(commandCommitCount, move(command)));
 
                 // Don't count this as `in progress`, it's just sitting there.
@@ -962,8 +1218,28 @@ void BedrockServer::worker(SQLitePool& dbPool,
                 // If peek succeeds, then it's finished, and all we need to do is respond to the command at the bottom.
                 bool calledPeek = false;
                 BedrockCore::RESULT peekResult = BedrockCore::RESULT::INVALID;
-                if (command->repeek || !command->httpsRequests.size()) {
-                    peekResult = core.peekCommand(command, threadId == 0);
+                // A pending continuation also gets us into `peekCommand`, which resumes it instead of re-peeking.
+                if (command->repeek || command->continuation || !command->httpsRequests.size()) {
+                    // Commands that declare themselves pure reads get peeked on the read-only handle, which serves
+                    // a consistent WAL snapshot without any of the write-lane machinery. The blocking thread
+                    // (threadId 0) keeps its exclusive path even for reads, it exists to serialize, not to be fast.
+                    if (threadId && command->isReadOnly()) {
+                        if (!readOnlyCore) {
+                            readOnlyDb = make_unique<SQLite>(db, true);
+                            readOnlyCore = make_unique<BedrockCore>(*readOnlyDb, server);
+                        }
+                        peekResult = readOnlyCore->peekCommand(command);
+                        if (peekResult == BedrockCore::RESULT::SHOULD_PROCESS) {
+                            // The plugin lied: this command wants to write (or make an HTTPS request). Abandon the
+                            // read-only attempt and re-peek on the normal write path.
+                            SWARN("Command '" << command->request.methodLine << "' declared isReadOnly but didn't "
+                                  << "complete in peek, re-running on the write path.");
+                            readOnlyCore->rollback();
+                            peekResult = core.peekCommand(command, false);
+                        }
+                    } else {
+                        peekResult = core.peekCommand(command, threadId == 0);
+                    }
                     calledPeek = true;
                 }
 
@@ -974,6 +1250,20 @@ void BedrockServer::worker(SQLitePool& dbPool,
                 }
 
                 if (!calledPeek || peekResult == BedrockCore::RESULT::SHOULD_PROCESS) {
+                    // If peek asked for this command to be parked with its plugin (see BedrockCommand::requestHold),
+                    // hand over ownership, just like we do below for commands waiting on HTTPS requests. The plugin
+                    // re-queues it via acceptCommand when whatever it's waiting for happens.
+                    if (command->requestHold) {
+                        if (calledPeek) {
+                            core.rollback();
+                        }
+                        command->requestHold = false;
+                        BedrockPlugin* plugin = command->getPlugin();
+                        SASSERT(plugin);
+                        plugin->holdCommand(move(command));
+                        break;
+                    }
+
                     // We've just unsuccessfully peeked a command, which means we're in a state where we might want to
                     // write it. We'll flag that here, to keep the node from falling out of LEADING/STANDINGDOWN
                     // until we're finished with this command.
@@ -992,7 +1282,7 @@ void BedrockServer::worker(SQLitePool& dbPool,
                         }
 
                         // If the command isn't complete, we'll re-queue it.
-                        if (command->repeek || !command->areHttpsRequestsComplete()) {
+                        if (command->repeek || command->continuation || !command->areHttpsRequestsComplete()) {
                             // Roll back the existing transaction, but only if we are inside an transaction
                             if (calledPeek) {
                                 core.rollback();
@@ -1001,9 +1291,9 @@ void BedrockServer::worker(SQLitePool& dbPool,
                             if (!command->areHttpsRequestsComplete()) {
                                 // If it has outstanding HTTPS requests, we'll wait for them.
                                 server.waitForHTTPS(move(command));
-                            } else if (command->repeek) {
-                                // Otherwise, it needs to be re-peeked, but had no outstanding requests, so it goes
-                                // back in the main queue.
+                            } else if (command->repeek || command->continuation) {
+                                // Otherwise, it needs to be re-peeked (or resumed), but had no outstanding requests,
+                                // so it goes back in the main queue.
                                 commandQueue.push(move(command));
                             }
 
@@ -1073,9 +1363,25 @@ void BedrockServer::worker(SQLitePool& dbPool,
                             // mark it as complete. We add the currentCommit count here as well.
                             command->response["commitCount"] = to_string(db.getCommitCount());
                             command->complete = true;
+                            if (threadId) {
+                                server._conflictManager.recordSuccess(db.getWrittenTables());
+                            }
                         } else {
                             SINFO("Conflict or state change committing " << command->request.methodLine
                                   << " on worker thread with " << retry << " retries remaining.");
+                            if (threadId) {
+                                server._conflictManager.recordConflict(db.getWrittenTables());
+
+                                // If this command's tables are conflict-hot, parallel retries will most likely just
+                                // collide with whatever we conflicted with, so skip the remaining retries and let the
+                                // blocking queue serialize it. Once the conflict rate decays, commands for these
+                                // tables go back to retrying in parallel.
+                                if (retry > 1 && server._conflictManager.shouldSerialize(db.getWrittenTables())) {
+                                    SINFO("Conflict-hot tables for '" << command->request.methodLine
+                                          << "', skipping remaining retries and serializing.");
+                                    retry = 1;
+                                }
+                            }
                         }
                     } else if (result == BedrockCore::RESULT::ABANDONED_FOR_CHECKPOINT) {
                         SINFO("[checkpoint] Re-trying abandoned command (from process) in worker thread");
@@ -1144,6 +1450,78 @@ void BedrockServer::worker(SQLitePool& dbPool,
     }
 }
 
+void BedrockServer::_responder() {
+    SInitialize("responder");
+    while (true) {
+        // Grab everything that's accumulated in one swap, so a completion batch costs one lock round-trip.
+        list<unique_ptr<BedrockCommand>> commands;
+        {
+            unique_lock<mutex> lock(_responderMutex);
+            while (_responderQueue.empty() && !_responderShouldExit.load()) {
+                _responderCV.wait(lock);
+            }
+            if (_responderQueue.empty() && _responderShouldExit.load()) {
+                return;
+            }
+            commands = move(_responderQueue);
+            _responderQueue.clear();
+        }
+        for (auto& command : commands) {
+            SAUTOPREFIX(command->request);
+            if (command->initiatingPeerID) {
+                // This is a command that came from a peer. Have the sync node send the response back to the peer.
+                _finishPeerCommand(command);
+            } else {
+                // The only other option is this came from a client, so respond via the server.
+                _reply(command);
+            }
+        }
+    }
+}
+
+void BedrockServer::_queueSyncResponse(unique_ptr<BedrockCommand>&& command) {
+    lock_guard<mutex> lock(_responderMutex);
+    _responderQueue.push_back(move(command));
+    _responderCV.notify_one();
+}
+
+void BedrockServer::_scaleWorkerPool() {
+    uint64_t now = STimeNow();
+    if (now < _nextWorkerScaleCheck) {
+        return;
+    }
+    _nextWorkerScaleCheck = now + _WORKER_SCALE_INTERVAL;
+
+    int limit = _activeWorkerLimit.load();
+    int busy = _busyWorkers.load();
+    size_t queued = _commandQueue.size();
+    if (queued && busy >= limit) {
+        // Commands are waiting and every active worker is occupied — whether making progress, stuck in a long
+        // `process`, or blocked on HTTPS — so unpark a chunk of the reserve at once. Repeated intervals under
+        // pressure compound this up to the maximum.
+        int newLimit = min(_maxWorkerThreads, limit + max(1, limit / 4));
+        if (newLimit != limit) {
+            SINFO("Worker pool scaling up from " << limit << " to " << newLimit << " active threads ("
+                  << queued << " queued, " << busy << " busy).");
+            _activeWorkerLimit.store(newLimit);
+        }
+        _workerIdleIntervals = 0;
+    } else if (!queued && busy < limit / 2) {
+        // The pool looks oversized, but only park a thread after it's looked that way continuously — a burst
+        // arriving mid-decision should reset the clock, not fight a shrinking pool.
+        if (++_workerIdleIntervals >= _WORKER_SCALE_DOWN_INTERVALS) {
+            _workerIdleIntervals = 0;
+            int newLimit = max(_minWorkerThreads, limit - 1);
+            if (newLimit != limit) {
+                SINFO("Worker pool scaling down from " << limit << " to " << newLimit << " active threads.");
+                _activeWorkerLimit.store(newLimit);
+            }
+        }
+    } else {
+        _workerIdleIntervals = 0;
+    }
+}
+
 bool BedrockServer::_handleIfStatusOrControlCommand(unique_ptr<BedrockCommand>& command) {
     if (_isStatusCommand(command)) {
         _status(command);
@@ -1222,6 +1600,7 @@ void BedrockServer::_resetServer() {
     _shutdownState = RUNNING;
     _shouldBackup = false;
     _commandPort = nullptr;
+    _unixCommandPort = nullptr;
     _gracefulShutdownTimeout.alarmDuration = 0;
     _pluginsDetached = false;
 
@@ -1239,7 +1618,8 @@ BedrockServer::BedrockServer(const SData& args_)
     _upgradeInProgress(false), _suppressCommandPort(false), _suppressCommandPortManualOverride(false),
     _syncThreadComplete(false), _syncNode(nullptr), _shutdownState(RUNNING),
     _multiWriteEnabled(args.test("-enableMultiWrite")), _shouldBackup(false), _detach(args.isSet("-bootstrap")),
-    _controlPort(nullptr), _commandPort(nullptr), _maxConflictRetries(3), _lastQuorumCommandTime(STimeNow()),
+    _admissionControlEnabled(args.test("-admissionControl")),
+    _commandPort(nullptr), _unixCommandPort(nullptr), _maxConflictRetries(3), _lastQuorumCommandTime(STimeNow()),
     _pluginsDetached(false)
 {
     _version = VERSION;
@@ -1268,6 +1648,15 @@ BedrockServer::BedrockServer(const SData& args_)
     sort(versions.begin(), versions.end());
     _version = SComposeList(versions, ":");
 
+    // Build the command dispatch index from each plugin's advertised verbs. We iterate `plugins` (sorted by name) and
+    // `emplace` keeps the first entry, so if two plugins ever claim the same verb, the one the old probe loop would
+    // have reached first wins here too.
+    for (auto& p : plugins) {
+        for (auto& verb : p.second->supportedVerbs()) {
+            _commandDispatchIndex.emplace(verb, p.second);
+        }
+    }
+
     list<string> pluginString;
     for (auto& p : plugins) {
         pluginString.emplace_back(p.first);
@@ -1288,6 +1677,12 @@ BedrockServer::BedrockServer(const SData& args_)
         SQLite::enableTrace.store(true);
     }
 
+    // Allow enabling group commit at startup. This must be set before any SQLite object is created, as it changes the
+    // synchronous mode the DB is opened with.
+    if (args.isSet("-groupCommit")) {
+        SQLite::enableGroupCommit.store(true);
+    }
+
     // Check for commands that will be forced to use QUORUM write consistency.
     if (args.isSet("-synchronousCommands")) {
         list<string> syncCommands;
@@ -1307,10 +1702,6 @@ BedrockServer::BedrockServer(const SData& args_)
         }
     }
 
-    // Allow sending control commands when the server's not LEADING/FOLLOWING.
-    SINFO("Opening control port on '" << args["-controlPort"] << "'");
-    _controlPort = openPort(args["-controlPort"]);
-
     // If we're bootstraping this node we need to go into detached mode here.
     // The syncWrapper will handle this for us.
     if (_detach) {
@@ -1320,6 +1711,36 @@ BedrockServer::BedrockServer(const SData& args_)
     // Set the quorum checkpoint, or default if not specified.
     _quorumCheckpointSeconds = args.isSet("-quorumCheckpointSeconds") ? args.calc("-quorumCheckpointSeconds") : 60;
 
+    // Optionally journal accepted `Connection: forget` commands so a crash doesn't silently drop them after the
+    // 202 ack. Anything a previous run accepted but never finished gets requeued here, before we take new traffic.
+    if (args.isSet("-forgetJournal")) {
+        SINFO("Opening forget journal at '" << args["-forgetJournal"] << "'");
+        _forgetJournal = make_unique<BedrockForgetJournal>(args["-forgetJournal"]);
+        if (!_forgetJournal->ok()) {
+            // The journal already warned about why; run without one rather than refuse to start.
+            _forgetJournal = nullptr;
+        } else {
+            auto pendingEntries = _forgetJournal->replay();
+            if (!pendingEntries.empty()) {
+                SHMMM("Replaying " << pendingEntries.size() << " forget command(s) from a previous run.");
+            }
+            for (auto& entry : pendingEntries) {
+                unique_ptr<BedrockCommand> command = getCommandFromPlugins(move(entry.second));
+                command->id = args["-nodeName"] + "#" + to_string(_requestCount++);
+                command->initiatingClientID = -1;
+                command->forgetJournalOffset = entry.first;
+                _commandQueue.push(move(command));
+            }
+        }
+    }
+
+    // Launch the control thread, which binds the control port and serves Status and control commands for the
+    // server's entire lifetime - including when we're not LEADING/FOLLOWING, while detached, and while the main
+    // loop is saturated with production traffic.
+    SINFO("Launching control thread 'control'");
+    _controlThreadShouldExit = false;
+    _controlThread = thread(&BedrockServer::_controlLoop, this);
+
     // Start the sync thread, which will start the worker threads.
     SINFO("Launching sync thread '" << _syncThreadName << "'");
     _syncThread = thread(syncWrapper,
@@ -1328,6 +1749,15 @@ BedrockServer::BedrockServer(const SData& args_)
                      ref(_leaderVersion),
                      ref(_syncNodeQueuedCommands),
                      ref(*this));
+
+    // Launch any requested extra acceptor threads. Each binds the command port with SO_REUSEPORT and runs its own
+    // accept/receive/parse loop, so connection storms aren't bottlenecked on the main poll loop.
+    _acceptorThreadsShouldExit = false;
+    int64_t acceptorThreads = args.calc64("-acceptorThreads");
+    for (int64_t threadNum = 0; threadNum < acceptorThreads; threadNum++) {
+        SINFO("Launching acceptor thread 'acceptor" << threadNum << "'");
+        _acceptorThreads.emplace_back(&BedrockServer::_acceptorLoop, this, threadNum);
+    }
 }
 
 BedrockServer::~BedrockServer() {
@@ -1336,12 +1766,25 @@ BedrockServer::~BedrockServer() {
     if (_syncThread.joinable()) {
         _syncThread.join();
     }
+
+    // Stop any acceptor threads; they close their own ports and sockets on the way out.
+    _acceptorThreadsShouldExit = true;
+    for (auto& acceptorThread : _acceptorThreads) {
+        acceptorThread.join();
+    }
+
+    // Stop the control thread last, so the control plane answers until the very end; it closes its own port and
+    // sockets on the way out.
+    _controlThreadShouldExit = true;
+    _controlThread.join();
     SINFO("Threads closed.");
 
     // Close any sockets that are still open. We wait until the sync thread has completed to do this, as until it's
     // finished, it may keep writing to these sockets.
-    if (_socketIDMap.size()) {
-        SWARN("Still have " << _socketIDMap.size() << " entries in _socketIDMap.");
+    size_t trackedConnections = count_if(_clientConnections.begin(), _clientConnections.end(),
+                                         [](const ClientConnection& conn) { return conn.socket != nullptr; });
+    if (trackedConnections) {
+        SWARN("Still have " << trackedConnections << " tracked client connections.");
     }
 
     if (socketList.size()) {
@@ -1411,8 +1854,349 @@ bool BedrockServer::shutdownComplete() {
     return false;
 }
 
+// Handles one client socket for the poll loop that owns it: reaps it if it's closed, otherwise parses every
+// complete request out of its receive buffer into commands. Called by the main poll loop for the sockets in
+// `socketList`, and by each acceptor thread (see _acceptorLoop) for its own sockets; all the state it touches is
+// either passed in or locked.
+void BedrockServer::_handleSocket(STCPManager::Socket* s, vector<unique_ptr<BedrockCommand>>& newCommands,
+                                  list<STCPManager::Socket*>& socketsToClose, int& deserializationAttempts,
+                                  int& deserializedRequests, uint64_t lastChance) {
+    switch (s->state.load()) {
+        case STCPManager::Socket::CLOSED:
+        {
+            // TODO: Cancel any outstanding commands initiated by this socket. This isn't critical, and is an
+            // optimization. Otherwise, they'll continue to get processed to completion, and will just never be
+            // able to have their responses returned.
+            SAUTOLOCK(_clientConnectionsMutex);
+            _untrackClientConnection(s);
+            socketsToClose.push_back(s);
+        }
+        break;
+        case STCPManager::Socket::CONNECTED:
+        {
+            {
+                SAUTOLOCK(_clientConnectionsMutex);
+                if (s->recvBuffer.empty()) {
+                    // If nothing's been received, break early.
+                    if (_shutdownState.load() != RUNNING && lastChance && lastChance < STimeNow() && !_findClientConnection(s)) {
+                        // If we're shutting down and past our lastChance timeout, we start killing these.
+                        SINFO("Closing socket " << s->id << " with no data and no pending command: shutting down.");
+                        socketsToClose.push_back(s);
+                    }
+                    break;
+                } else if (s->data) {
+                    // Plugin-owned sockets keep the old one-command-at-a-time behavior: the plugin parses its own
+                    // protocol and sends its own responses outside our sequencing, so we don't read another
+                    // request until the pending one completes.
+                    if (_findClientConnection(s)) {
+                        break;
+                    }
+                }
+            }
+
+            // Dequeue every complete request in the buffer. Clients are allowed to pipeline: each request is
+            // dispatched as soon as it's read, and responses go back in the order the requests arrived (see
+            // ClientConnection), so clients can keep matching responses up by position.
+            while (true) {
+                SData request;
+                uint64_t kernelRecvTime = 0;
+
+                // If the socket is owned by a plugin, we let the plugin populate our request.
+                BedrockPlugin* plugin = static_cast<BedrockPlugin*>(s->data);
+                if (plugin) {
+                    // Call the plugin's handler.
+                    plugin->onPortRecv(s, request);
+                    if (!request.empty()) {
+                        // If it populated our request, then we'll save the plugin name so we can handle the response.
+                        request["plugin"] = plugin->getName();
+                    }
+                } else {
+                    // Otherwise, handle any default request.
+                    int requestSize = request.deserialize(s->recvBuffer);
+                    s->recvBuffer.consumeFront(requestSize);
+                    deserializationAttempts++;
+
+                    // Ask the kernel when the last packet on this socket arrived, which for a request we just
+                    // completed parsing is (approximately) when its final bytes hit the receive buffer. The gap
+                    // between that and now is time the request spent waiting on this poll loop, which timing that
+                    // starts at command creation can't see. The very first request on a socket may not have a stamp
+                    // yet (the first SIOCGSTAMP is what turns stamping on), so this can fail harmlessly.
+                    if (requestSize) {
+                        struct timeval tv;
+                        if (!ioctl(s->s, SIOCGSTAMP, &tv) && (tv.tv_sec || tv.tv_usec)) {
+                            kernelRecvTime = (uint64_t)tv.tv_sec * STIME_US_PER_S + (uint64_t)tv.tv_usec;
+                        }
+                    }
+                }
+
+                // If there's no (more) complete requests on this socket, we're done with it for now.
+                if (request.empty()) {
+                    SAUTOLOCK(_clientConnectionsMutex);
+                    // If we weren't able to deserialize a complete request, and we're shutting down, give up.
+                    if (_shutdownState.load() != RUNNING && lastChance && lastChance < STimeNow() && !_findClientConnection(s)) {
+                        SINFO("Closing socket " << s->id << " with incomplete data and no pending command: shutting down.");
+                        socketsToClose.push_back(s);
+                    }
+                    break;
+                }
+                SAUTOPREFIX(request);
+                deserializedRequests++;
+
+                // Either respond to the request immediately or sequence it so we can eventually sync out the
+                // response. Sequence 0 means the response is sent the moment the command completes; clients opt
+                // into that (accepting out-of-order responses) with the `Idempotent` header.
+                uint64_t sequence = 0;
+                bool discardForShutdown = false;
+                if (SIEquals(request["Connection"], "forget") ||
+                    (uint64_t)request.calc64("commandExecuteTime") > STimeNow()) {
+                    // Respond immediately to make it clear we successfully queued it, but don't count it against
+                    // the socket's outstanding commands as we don't care about the answer. If sequenced responses
+                    // are already outstanding on this socket, the 202 takes a sequence slot so it goes out in
+                    // order with them.
+                    SINFO("Firing and forgetting '" << request.methodLine << "'");
+                    SData response("202 Successfully queued");
+                    if (_shutdownState.load() != RUNNING) {
+                        response["Connection"] = "close";
+                    }
+                    {
+                        SAUTOLOCK(_clientConnectionsMutex);
+                        ClientConnection* conn = _findClientConnection(s);
+                        if (conn && conn->commandCount) {
+                            _sendPipelinedResponse(s, *conn, conn->nextRequestSequence++, response.serialize());
+                        } else {
+                            s->send(response.serialize());
+                        }
+                    }
+
+                    // If we're shutting down, discard this command, we won't wait for the future.
+                    if (_shutdownState.load() != RUNNING) {
+                        SINFO("Not queuing future command '" << request.methodLine << "' while shutting down.");
+                        discardForShutdown = true;
+                    }
+                } else {
+                    SINFO("Waiting for '" << request.methodLine << "' to complete.");
+                    SAUTOLOCK(_clientConnectionsMutex);
+                    ClientConnection& conn = _trackClientConnection(s);
+                    conn.commandCount++;
+                    if (!request.test("Idempotent")) {
+                        sequence = conn.nextRequestSequence++;
+                    }
+                }
+                if (discardForShutdown) {
+                    break;
+                }
+
+                // Get the source ip of the command.
+                char *ip = inet_ntoa(s->addr.sin_addr);
+                if (ip != "127.0.0.1"s) {
+                    // We only add this if it's not localhost because existing code expects commands that come from
+                    // localhost to have it blank.
+                    request["_source"] = ip;
+                }
+
+                // Create a command.
+                unique_ptr<BedrockCommand> command = getCommandFromPlugins(move(request));
+                command->socketSequence = sequence;
+
+                // Record the kernel-to-parse interval, if we got a plausible stamp (STimeNow and the socket stamp
+                // come from the same wall clock, but guard against it stepping between the two reads).
+                if (kernelRecvTime && kernelRecvTime <= command->creationTime) {
+                    command->timingInfo.emplace_back(BedrockCommand::KERNEL_QUEUE, kernelRecvTime,
+                                                     command->creationTime);
+                }
+
+                if (command->writeConsistency != SQLiteNode::QUORUM
+                    && _syncCommands.find(command->request.methodLine) != _syncCommands.end()) {
+
+                    command->writeConsistency = SQLiteNode::QUORUM;
+                    _lastQuorumCommandTime = STimeNow();
+                    SINFO("Forcing QUORUM consistency for command " << command->request.methodLine);
+                }
+
+                // This is important! All commands passed through the entire cluster must have unique IDs, or they
+                // won't get routed properly from follower to leader and back.
+                command->id = args["-nodeName"] + "#" + to_string(_requestCount++);
+
+                // And we and keep track of the client that initiated this command, so we can respond later, except
+                // if we received connection:forget in which case we don't respond later
+                command->initiatingClientID = SIEquals(command->request["Connection"], "forget") ? -1 : _clientID(s);
+
+                // If forget commands are journaled, record this one before it enters the queue, so a crash after
+                // the 202 we already sent doesn't lose it. A full journal just means this command runs unjournaled.
+                if (_forgetJournal && command->initiatingClientID == -1) {
+                    command->forgetJournalOffset = _forgetJournal->append(command->request);
+                }
+
+                // A retry of a keyed command that already finished here gets its stored response back without
+                // being dispatched (see BedrockDedupCache); this is the client-timeout-storm defense, where the
+                // original committed but the client never saw the response.
+                const string& idempotencyKey = command->request["IdempotencyKey"];
+                if (!idempotencyKey.empty() && command->initiatingClientID >= 0 &&
+                    _dedupCache.lookup(command->request.methodLine + '\0' + idempotencyKey, command->response)) {
+                    SINFO("Answering '" << command->request.methodLine << "' from dedup cache (IdempotencyKey '"
+                          << idempotencyKey << "').");
+                    _reply(command);
+                }
+
+                // If it's a status or control command, we handle it specially there. If not, we'll queue it for
+                // later processing.
+                else if (!_handleIfStatusOrControlCommand(command)) {
+                    // Admission control: if commands at this priority have recently been waiting longer than this
+                    // one's entire timeout budget, it can't plausibly be served in time, so reject it now rather
+                    // than letting it queue, time out, and burn a worker producing an answer nobody's waiting for.
+                    // Only applies when the queue actually has a backlog; an idle queue's stale EWMA shouldn't
+                    // reject anything. Forget commands are exempt (nobody's waiting, so late is fine, and shedding
+                    // one silently loses it).
+                    uint64_t projectedWaitUS = _admissionControlEnabled && command->initiatingClientID >= 0 &&
+                                               !_commandQueue.empty()
+                                               ? _commandQueue.recentQueueWaitUS(command->priority) : 0;
+                    if (projectedWaitUS && command->creationTime + projectedWaitUS >= command->timeout()) {
+                        SINFO("Rejecting '" << command->request.methodLine << "' at admission, projected queue wait "
+                              << (projectedWaitUS / 1000) << "ms exceeds its timeout budget.");
+                        command->response.methodLine = "503 Service Unavailable";
+                        command->complete = true;
+                        _reply(command);
+                    } else {
+                        auto _syncNodeCopy = atomic_load(&_syncNode);
+                        if (_syncNodeCopy && _syncNodeCopy->getState() == SQLiteNode::STANDINGDOWN) {
+                            _standDownQueue.push(move(command));
+                        } else {
+                            SINFO("Queuing new '" << command->request.methodLine
+                                  << "' command from local client for batch enqueue.");
+                            newCommands.push_back(move(command));
+                        }
+                    }
+                }
+
+                // Plugin-owned sockets only hand us one request per poll.
+                if (plugin) {
+                    break;
+                }
+            }
+        }
+        break;
+        case STCPManager::Socket::SHUTTINGDOWN:
+        {
+            // We do nothing in this state, we just wait until the next iteration of poll and let the CLOSED
+            // case run. This block just prevents default warning from firing.
+        }
+        break;
+        default:
+        {
+            SWARN("Socket in unhandled state: " << s->state);
+        }
+        break;
+    }
+}
+
+void BedrockServer::_acceptorLoop(size_t threadNum) {
+    SInitialize("acceptor" + to_string(threadNum));
+    SINFO("Acceptor thread starting.");
+
+    // A private listener with its own socket set, fd_map, and poll loop. The port shares -serverHost with the main
+    // command port via SO_REUSEPORT, so the kernel spreads incoming connections across all of them, and each loop
+    // accepts and parses its own sockets without ever contending with the others. Commands land in the shared queue,
+    // and responses are written straight to the socket by whichever thread completes the command (as always), so the
+    // only thing this loop does for established sockets is read.
+    STCPServer listener("");
+    Port* port = nullptr;
+    while (!_acceptorThreadsShouldExit) {
+        // Track the main command port: listen only while it's open, so suppression and version-mismatch behavior
+        // stay consistent across all the listening sockets.
+        bool shouldBeOpen = _commandPort && !_suppressCommandPort && _shutdownState.load() == RUNNING;
+        if (shouldBeOpen && !port) {
+            SINFO("Acceptor opening port on '" << args["-serverHost"] << "'.");
+            port = listener.openPort(args["-serverHost"], true);
+        } else if (!shouldBeOpen && port) {
+            SINFO("Acceptor closing port.");
+            listener.closePorts();
+            port = nullptr;
+        }
+
+        fd_map fdm;
+        listener.prePoll(fdm);
+        S_poll(fdm, STIME_US_PER_S);
+        uint64_t nextActivity = STimeNow() + STIME_US_PER_S;
+        listener.postPoll(fdm, nextActivity);
+
+        // Accept anything new, then parse whatever's arrived, exactly as the main poll loop does for its sockets.
+        while (listener.acceptSocket()) {
+        }
+        vector<unique_ptr<BedrockCommand>> newCommands;
+        list<STCPManager::Socket*> socketsToClose;
+        int deserializationAttempts = 0;
+        int deserializedRequests = 0;
+        for (auto s : listener.socketList) {
+            _handleSocket(s, newCommands, socketsToClose, deserializationAttempts, deserializedRequests, 0);
+        }
+        if (newCommands.size()) {
+            SINFO("Enqueuing " << newCommands.size() << " commands from acceptor, with " << _commandQueue.size()
+                  << " commands already queued.");
+            _commandQueue.push(move(newCommands));
+        }
+        for (auto s : socketsToClose) {
+            listener.closeSocket(s);
+        }
+    }
+
+    // Shutting down; close anything we still own.
+    listener.closePorts();
+    while (!listener.socketList.empty()) {
+        listener.closeSocket(listener.socketList.front());
+    }
+    SINFO("Acceptor thread exiting.");
+}
+
+void BedrockServer::_controlLoop() {
+    SInitialize("control");
+    SINFO("Control thread starting.");
+
+    // A private listener with its own socket set and poll loop, bound to the control port. Status and control
+    // commands are handled inline by _handleSocket (via _handleIfStatusOrControlCommand), so they're parsed and
+    // answered right here with nothing but other control traffic ahead of them; a saturated main poll loop or a
+    // backed-up command queue can't delay them. The port stays open for the life of the server - through command
+    // port suppression, graceful shutdown, and detach - because losing the ability to query or manage a struggling
+    // server is exactly the failure this thread exists to prevent.
+    STCPServer listener("");
+    SINFO("Opening control port on '" << args["-controlPort"] << "'");
+    listener.openPort(args["-controlPort"]);
+    while (!_controlThreadShouldExit) {
+        fd_map fdm;
+        listener.prePoll(fdm);
+        S_poll(fdm, STIME_US_PER_S);
+        uint64_t nextActivity = STimeNow() + STIME_US_PER_S;
+        listener.postPoll(fdm, nextActivity);
+
+        // Accept anything new, then parse whatever's arrived. Control and status commands are answered inside
+        // _handleSocket; anything else lands in newCommands and feeds the shared queue, as it always has.
+        while (listener.acceptSocket()) {
+        }
+        vector<unique_ptr<BedrockCommand>> newCommands;
+        list<STCPManager::Socket*> socketsToClose;
+        int deserializationAttempts = 0;
+        int deserializedRequests = 0;
+        for (auto s : listener.socketList) {
+            _handleSocket(s, newCommands, socketsToClose, deserializationAttempts, deserializedRequests, 0);
+        }
+        if (newCommands.size()) {
+            SINFO("Enqueuing " << newCommands.size() << " non-control commands from the control port.");
+            _commandQueue.push(move(newCommands));
+        }
+        for (auto s : socketsToClose) {
+            listener.closeSocket(s);
+        }
+    }
+
+    // Shutting down; close anything we still own.
+    listener.closePorts();
+    while (!listener.socketList.empty()) {
+        listener.closeSocket(listener.socketList.front());
+    }
+    SINFO("Control thread exiting.");
+}
+
 void BedrockServer::prePoll(fd_map& fdm) {
-    SAUTOLOCK(_socketIDMutex);
+    SAUTOLOCK(_clientConnectionsMutex);
     STCPServer::prePoll(fdm);
 }
 
@@ -1420,8 +2204,8 @@ void BedrockServer::postPoll(fd_map& fdm, uint64_t& nextActivity) {
     // Let the base class do its thing. We lock around this because we allow worker threads to modify the sockets (by
     // writing to them, but this can truncate send buffers).
     {
-        SAUTOLOCK(_socketIDMutex);
-        STCPServer::postPoll(fdm);
+        SAUTOLOCK(_clientConnectionsMutex);
+        STCPServer::postPoll(fdm, nextActivity);
     }
 
     // Open the port the first time we enter a command-processing state
@@ -1448,13 +2232,17 @@ void BedrockServer::postPoll(fd_map& fdm, uint64_t& nextActivity) {
         // Open the port
         if (!_commandPort) {
             SINFO("Ready to process commands, opening command port on '" << args["-serverHost"] << "'");
-            _commandPort = openPort(args["-serverHost"]);
-        }
-        if (!_controlPort) {
-            SINFO("Opening control port on '" << args["-controlPort"] << "'");
-            _controlPort = openPort(args["-controlPort"]);
+            // If acceptor threads are configured, they bind this same port, which requires SO_REUSEPORT on every
+            // socket bound to it, including this one.
+            _commandPort = openPort(args["-serverHost"], !_acceptorThreads.empty());
         }
 
+        // If configured, also listen for same-host clients on a unix domain socket, which skips the loopback TCP
+        // stack entirely. Commands arriving here enter the queues identically to ones from the TCP command port.
+        if (!_unixCommandPort && args.isSet("-unixSocket")) {
+            SINFO("Opening local command port on '" << args["-unixSocket"] << "'");
+            _unixCommandPort = openUnixPort(args["-unixSocket"]);
+        }
         // Open any plugin ports on enabled plugins
         for (auto plugin : plugins) {
             string portHost = plugin.second->getPort();
@@ -1504,6 +2292,9 @@ void BedrockServer::postPoll(fd_map& fdm, uint64_t& nextActivity) {
     int deserializationAttempts = 0;
     int deserializedRequests = 0;
 
+    // Commands read this cycle, enqueued in one batch at the end (one queue lock and one wakeup for all of them).
+    vector<unique_ptr<BedrockCommand>> newCommands;
+
     // Accept any new connections
     _acceptSockets();
 
@@ -1520,149 +2311,14 @@ void BedrockServer::postPoll(fd_map& fdm, uint64_t& nextActivity) {
     // need to figure out some way to handle them. We'll wait 5 seconds and then start killing them.
     static uint64_t lastChance = 0;
     for (auto s : socketList) {
-        switch (s->state.load()) {
-            case STCPManager::Socket::CLOSED:
-            {
-                // TODO: Cancel any outstanding commands initiated by this socket. This isn't critical, and is an
-                // optimization. Otherwise, they'll continue to get processed to completion, and will just never be
-                // able to have their responses returned.
-                SAUTOLOCK(_socketIDMutex);
-                _socketIDMap.erase(s->id);
-                socketsToClose.push_back(s);
-            }
-            break;
-            case STCPManager::Socket::CONNECTED:
-            {
-                {
-                    SAUTOLOCK(_socketIDMutex);
-                    if (s->recvBuffer.empty()) {
-                        // If nothing's been received, break early.
-                        if (_shutdownState.load() != RUNNING && lastChance && lastChance < STimeNow() && _socketIDMap.find(s->id) == _socketIDMap.end()) {
-                            // If we're shutting down and past our lastChance timeout, we start killing these.
-                            SINFO("Closing socket " << s->id << " with no data and no pending command: shutting down.");
-                            socketsToClose.push_back(s);
-                        }
-                        break;
-                    } else {
-                        // Otherwise, we'll see if there's any activity on this socket. Currently, we don't handle clients
-                        // pipelining requests well. We process commands in no particular order, so we can't dequeue two
-                        // requests off the same socket at one time, or we don't guarantee their return order, thus we just
-                        // wait and will try again later.
-                        auto socketIt = _socketIDMap.find(s->id);
-                        if (socketIt != _socketIDMap.end()) {
-                            break;
-                        }
-                    }
-                }
-
-                // If there's a request, we'll dequeue it (but only the first one).
-                SData request;
-
-                // If the socket is owned by a plugin, we let the plugin populate our request.
-                BedrockPlugin* plugin = static_cast<BedrockPlugin*>(s->data);
-                if (plugin) {
-                    // Call the plugin's handler.
-                    plugin->onPortRecv(s, request);
-                    if (!request.empty()) {
-                        // If it populated our request, then we'll save the plugin name so we can handle the response.
-                        request["plugin"] = plugin->getName();
-                    }
-                } else {
-                    // Otherwise, handle any default request.
-                    int requestSize = request.deserialize(s->recvBuffer);
-                    s->recvBuffer.consumeFront(requestSize);
-                    deserializationAttempts++;
-                }
-
-                // If we have a populated request, from either a plugin or our default handling, we'll queue up the
-                // command.
-                if (!request.empty()) {
-                    SAUTOPREFIX(request);
-                    deserializedRequests++;
-                    // Either shut down the socket or store it so we can eventually sync out the response.
-                    if (SIEquals(request["Connection"], "forget") ||
-                        (uint64_t)request.calc64("commandExecuteTime") > STimeNow()) {
-                        // Respond immediately to make it clear we successfully queued it, but don't add to the socket
-                        // map as we don't care about the answer.
-                        SINFO("Firing and forgetting '" << request.methodLine << "'");
-                        SData response("202 Successfully queued");
-                        if (_shutdownState.load() != RUNNING) {
-                            response["Connection"] = "close";
-                        }
-                        s->send(response.serialize());
-
-                        // If we're shutting down, discard this command, we won't wait for the future.
-                        if (_shutdownState.load() != RUNNING) {
-                            SINFO("Not queuing future command '" << request.methodLine << "' while shutting down.");
-                            break;
-                        }
-                    } else {
-                        SINFO("Waiting for '" << request.methodLine << "' to complete.");
-                        SAUTOLOCK(_socketIDMutex);
-                        _socketIDMap[s->id] = s;
-                    }
-
-                    // Get the source ip of the command.
-                    char *ip = inet_ntoa(s->addr.sin_addr);
-                    if (ip != "127.0.0.1"s) {
-                        // We only add this if it's not localhost because existing code expects commands that come from
-                        // localhost to have it blank.
-                        request["_source"] = ip;
-                    }
-
-                    // Create a command.
-                    unique_ptr<BedrockCommand> command = getCommandFromPlugins(move(request));
-
-                    if (command->writeConsistency != SQLiteNode::QUORUM
-                        && _syncCommands.find(command->request.methodLine) != _syncCommands.end()) {
-
-                        command->writeConsistency = SQLiteNode::QUORUM;
-                        _lastQuorumCommandTime = STimeNow();
-                        SINFO("Forcing QUORUM consistency for command " << command->request.methodLine);
-                    }
-
-                    // This is important! All commands passed through the entire cluster must have unique IDs, or they
-                    // won't get routed properly from follower to leader and back.
-                    command->id = args["-nodeName"] + "#" + to_string(_requestCount++);
-
-                    // And we and keep track of the client that initiated this command, so we can respond later, except
-                    // if we received connection:forget in which case we don't respond later
-                    command->initiatingClientID = SIEquals(command->request["Connection"], "forget") ? -1 : s->id;
+        _handleSocket(s, newCommands, socketsToClose, deserializationAttempts, deserializedRequests, lastChance);
+    }
 
-                    // If it's a status or control command, we handle it specially there. If not, we'll queue it for
-                    // later processing.
-                    if (!_handleIfStatusOrControlCommand(command)) {
-                        auto _syncNodeCopy = atomic_load(&_syncNode);
-                        if (_syncNodeCopy && _syncNodeCopy->getState() == SQLiteNode::STANDINGDOWN) {
-                            _standDownQueue.push(move(command));
-                        } else {
-                            SINFO("Queued new '" << command->request.methodLine << "' command from local client, with "
-                                  << _commandQueue.size() << " commands already queued.");
-                            _commandQueue.push(move(command));
-                        }
-                    }
-                } else {
-                    SAUTOLOCK(_socketIDMutex);
-                    // If we weren't able to deserialize a complete request, and we're shutting down, give up.
-                    if (_shutdownState.load() != RUNNING && lastChance && lastChance < STimeNow() && _socketIDMap.find(s->id) == _socketIDMap.end()) {
-                        SINFO("Closing socket " << s->id << " with incomplete data and no pending command: shutting down.");
-                        socketsToClose.push_back(s);
-                    }
-                }
-            }
-            break;
-            case STCPManager::Socket::SHUTTINGDOWN:
-            {
-                // We do nothing in this state, we just wait until the next iteration of poll and let the CLOSED
-                // case run. This block just prevents default warning from firing.
-            }
-            break;
-            default:
-            {
-                SWARN("Socket in unhandled state: " << s->state);
-            }
-            break;
-        }
+    // Enqueue everything we read this cycle in one shot.
+    if (newCommands.size()) {
+        SINFO("Enqueuing " << newCommands.size() << " commands from local clients, with " << _commandQueue.size()
+              << " commands already queued.");
+        _commandQueue.push(move(newCommands));
     }
 
     // Log the timing of this loop.
@@ -1696,11 +2352,11 @@ void BedrockServer::postPoll(fd_map& fdm, uint64_t& nextActivity) {
             // We empty the socket list here, we will no longer allow new requests to come in, as the sync node can
             // shutdown any time after here, and we'll have no way to handle new requests.
             if (socketList.size()) {
-                SAUTOLOCK(_socketIDMutex);
+                SAUTOLOCK(_clientConnectionsMutex);
                 SINFO("Killing " << socketList.size() << " remaining sockets at graceful shutdown timeout.");
                 while(socketList.size()) {
                     auto s = socketList.front();
-                    _socketIDMap.erase(s->id);
+                    _untrackClientConnection(s);
                     closeSocket(s);
                 }
             }
@@ -1714,6 +2370,17 @@ unique_ptr<BedrockCommand> BedrockServer::getCommandFromPlugins(SData&& request)
 }
 
 unique_ptr<BedrockCommand> BedrockServer::getCommandFromPlugins(unique_ptr<SQLiteCommand>&& baseCommand) {
+    // Fast path: most commands are an exact verb advertised by some plugin, so try the dispatch index first. A plugin
+    // only consumes `baseCommand` when it claims the command, so if this plugin declines (returns null, e.g. because
+    // the verb matched but the rest of the methodLine didn't) we can still fall through to the full probe below.
+    auto indexIt = _commandDispatchIndex.find(baseCommand->request.getVerb());
+    if (indexIt != _commandDispatchIndex.end()) {
+        auto command = indexIt->second->getCommand(move(*baseCommand));
+        if (command) {
+            SDEBUG("Plugin " << indexIt->second->getName() << " handling command " << command->request.methodLine);
+            return command;
+        }
+    }
     for (auto pair : plugins) {
 
         // This is a bit weird to avoid changing this signature in all the plugins. It would be more straightforward if
@@ -1729,52 +2396,195 @@ unique_ptr<BedrockCommand> BedrockServer::getCommandFromPlugins(unique_ptr<SQLit
     return make_unique<BedrockCommand>(move(*baseCommand), nullptr);
 }
 
+int64_t BedrockServer::_clientID(const Socket* s) {
+    // A million fds is beyond any configuration we run; the assert is here for the day that changes.
+    SASSERT((uint64_t)s->s < (1ull << CLIENT_ID_FD_BITS));
+    return (int64_t)(((uint64_t)s->id << CLIENT_ID_FD_BITS) | (uint64_t)s->s);
+}
+
+BedrockServer::ClientConnection* BedrockServer::_findClientConnection(int64_t clientID) {
+    size_t fd = (uint64_t)clientID & ((1ull << CLIENT_ID_FD_BITS) - 1);
+    uint64_t socketID = (uint64_t)clientID >> CLIENT_ID_FD_BITS;
+    if (fd >= _clientConnections.size()) {
+        return nullptr;
+    }
+    ClientConnection& conn = _clientConnections[fd];
+    return (conn.socket && conn.socketID == socketID) ? &conn : nullptr;
+}
+
+BedrockServer::ClientConnection* BedrockServer::_findClientConnection(const Socket* s) {
+    if ((size_t)s->s >= _clientConnections.size()) {
+        return nullptr;
+    }
+    ClientConnection& conn = _clientConnections[s->s];
+    return (conn.socket == s && conn.socketID == s->id) ? &conn : nullptr;
+}
+
+BedrockServer::ClientConnection& BedrockServer::_trackClientConnection(Socket* s) {
+    if ((size_t)s->s >= _clientConnections.size()) {
+        // Grow geometrically so a burst of high-numbered fds doesn't reallocate per connection.
+        _clientConnections.resize(max<size_t>((size_t)s->s + 1, _clientConnections.size() * 2));
+    }
+    ClientConnection& conn = _clientConnections[s->s];
+    if (conn.socket != s || conn.socketID != s->id) {
+        // First command of a burst on this connection (or the fd's previous owner left nothing behind to match):
+        // start fresh, sequences and all.
+        conn = ClientConnection();
+        conn.socket = s;
+        conn.socketID = s->id;
+    }
+    return conn;
+}
+
+void BedrockServer::_untrackClientConnection(const Socket* s) {
+    ClientConnection* conn = _findClientConnection(s);
+    if (conn) {
+        *conn = ClientConnection();
+    }
+}
+
+// Sets `Content-Encoding` on the response when the client advertised support for gzip or zstd and the body is big
+// enough to be worth it. Serialization does the actual compression (SComposeHTTP handles both encodings), so this
+// just negotiates. Bodies under the threshold aren't worth the client-side decompress round trip, and commands can
+// opt out via `suppressResponseCompression`.
+static void _negotiateResponseCompression(BedrockCommand& command) {
+    static const size_t MIN_COMPRESS_SIZE = 1024;
+    if (command.suppressResponseCompression ||
+        command.response.content.size() < MIN_COMPRESS_SIZE ||
+        command.response.isSet("Content-Encoding") ||
+        !command.request.isSet("Accept-Encoding")) {
+        return;
+    }
+    const list<string> encodings = SParseList(SToLower(command.request["Accept-Encoding"]));
+    if (SContains(encodings, "zstd")) {
+        command.response["Content-Encoding"] = "zstd";
+    } else if (SContains(encodings, "gzip")) {
+        command.response["Content-Encoding"] = "gzip";
+    }
+}
+
 void BedrockServer::_reply(unique_ptr<BedrockCommand>& command) {
-    SAUTOLOCK(_socketIDMutex);
+    SAUTOLOCK(_clientConnectionsMutex);
 
     // Finalize timing info even for commands we won't respond to (this makes this data available in logs).
     command->finalizeTimingInfo();
 
+    // Every locally-finished command ends up here, including forget commands (which then hit the early return
+    // below), so this is where a journaled command's slot is freed.
+    if (command->forgetJournalOffset >= 0 && _forgetJournal) {
+        _forgetJournal->markComplete(command->forgetJournalOffset);
+        command->forgetJournalOffset = -1;
+    }
+
+    // Remember the final response of any keyed command - whether or not we can still respond, since the retry case
+    // that matters most is precisely the one where the client timed out and its socket is already gone. Only
+    // successes are cached; an error response shouldn't suppress a retry that might work. Sealed responses (the
+    // escalated case) get parsed for storage, so a replay goes through the normal stamping below.
+    if (command->initiatingClientID >= 0 && command->request.isSet("IdempotencyKey")) {
+        const string dedupKey = command->request.methodLine + '\0' + command->request["IdempotencyKey"];
+        if (command->sealedResponse.size()) {
+            SData parsed;
+            if (parsed.deserialize(command->sealedResponse) && SStartsWith(parsed.methodLine, "2")) {
+                _dedupCache.store(dedupKey, parsed);
+            }
+        } else if (SStartsWith(command->response.methodLine, "2")) {
+            _dedupCache.store(dedupKey, command->response);
+        }
+    }
+
     // Don't reply to commands with pseudo-clients (i.e., commands that we generated by other commands).
     if (command->initiatingClientID < 0) {
         return;
     }
 
-    // Do we have a socket for this command?
-    auto socketIt = _socketIDMap.find(command->initiatingClientID);
-    if (socketIt != _socketIDMap.end()) {
-        command->response["nodeName"] = args["-nodeName"];
+    // Do we have a connection for this command?
+    ClientConnection* conn = _findClientConnection(command->initiatingClientID);
+    if (conn) {
+        Socket* socket = conn->socket;
+        // A sealed response (escalated, completed on leader) is already its final client-ready bytes: leader stamped
+        // our node name and the commit count, and finalizeTimingInfo above patched our timing into its reserved
+        // slots. It skips all the header stamping below and goes out verbatim -- except that plugins and shutdown's
+        // `Connection: close` need the parsed form, so those rare cases unseal it and fall through.
+        if (command->sealedResponse.size() &&
+            (!command->request["plugin"].empty() || command->responseStreamed || _shutdownState.load() != RUNNING)) {
+            command->response.deserialize(command->sealedResponse);
+            command->sealedResponse.clear();
+        }
+        if (command->sealedResponse.size()) {
+            // Forward the sealed bytes, in request order if this command was sequenced.
+            if (command->socketSequence) {
+                _sendPipelinedResponse(socket, *conn, command->socketSequence, move(command->sealedResponse));
+            } else {
+                socket->send(command->sealedResponse);
+            }
+        } else {
+            command->response["nodeName"] = args["-nodeName"];
+
+            // Every response carries the commit count it observed, as a read-your-writes token: a client that echoes it
+            // as the `commitCount` request header on a follow-up read gets held (in _futureCommitCommands) until this
+            // node has replicated at least that far, and then served locally, instead of having to escalate the read to
+            // leader to avoid staleness. Commands that committed stamped the exact count they saw; don't overwrite it.
+            if (!command->response.isSet("commitCount")) {
+                auto _syncNodeCopy = atomic_load(&_syncNode);
+                if (_syncNodeCopy) {
+                    command->response["commitCount"] = to_string(_syncNodeCopy->getCommitCount());
+                }
+            }
 
-        // If we're shutting down, tell the caller to close the connection.
-        if (_shutdownState.load() != RUNNING) {
-            command->response["Connection"] = "close";
-        }
+            // If we're shutting down, tell the caller to close the connection.
+            if (_shutdownState.load() != RUNNING) {
+                command->response["Connection"] = "close";
+            }
 
-        // Is a plugin handling this command? If so, it gets to send the response.
-        const string& pluginName = command->request["plugin"];
+            // Is a plugin handling this command? If so, it gets to send the response.
+            const string& pluginName = command->request["plugin"];
 
-        if (!pluginName.empty()) {
-            // Let the plugin handle it
-            SINFO("Plugin '" << pluginName << "' handling response '" << command->response.methodLine
-                  << "' to request '" << command->request.methodLine << "'");
-            auto it = plugins.find(pluginName);
-            if (it != plugins.end()) {
-                it->second->onPortRequestComplete(*command, socketIt->second);
+            if (command->responseStreamed) {
+                // The command already streamed its entire framed response from `peek` (see streamToClient), so there's
+                // nothing to send. A sequenced command still has to advance the socket's response pipeline, though, or
+                // every later response on this socket would buffer forever; sending the empty string does exactly that.
+                if (command->socketSequence) {
+                    _sendPipelinedResponse(socket, *conn, command->socketSequence, "");
+                }
+            } else if (!pluginName.empty()) {
+                // Let the plugin handle it
+                SINFO("Plugin '" << pluginName << "' handling response '" << command->response.methodLine
+                      << "' to request '" << command->request.methodLine << "'");
+                auto it = plugins.find(pluginName);
+                if (it != plugins.end()) {
+                    it->second->onPortRequestComplete(*command, socket);
+                } else {
+                    SERROR("Couldn't find plugin '" << pluginName << ".");
+                }
             } else {
-                SERROR("Couldn't find plugin '" << pluginName << ".");
+                // Otherwise we send the standard response, compressed if the client asked for that, in request order
+                // if this command was sequenced. Plugin-handled and sealed responses are deliberately left alone:
+                // plugins own their own framing (e.g., the MySQL port), and sealed bytes were finalized on leader.
+                _negotiateResponseCompression(*command);
+                if (command->socketSequence) {
+                    _sendPipelinedResponse(socket, *conn, command->socketSequence, command->response.serialize());
+                } else {
+                    socket->send(command->response.serialize());
+                }
             }
-        } else {
-            // Otherwise we send the standard response.
-            socketIt->second->send(command->response.serialize());
         }
 
-        // If `Connection: close` was set, shut down the socket, in case the caller ignores us.
-        if (SIEquals(command->request["Connection"], "close") || _shutdownState.load() != RUNNING) {
-            shutdownSocket(socketIt->second, SHUT_RDWR);
+        // If `Connection: close` was set, we want to shut down the socket, in case the caller ignores us -- but not
+        // until the socket's other outstanding responses (if the client pipelined) have gone out.
+        bool wantShutdown = SIEquals(command->request["Connection"], "close") || _shutdownState.load() != RUNNING;
+        conn->shutdownOnCompletion = conn->shutdownOnCompletion || wantShutdown;
+        wantShutdown = conn->shutdownOnCompletion;
+        if (conn->commandCount) {
+            conn->commandCount--;
         }
+        if (!conn->commandCount) {
+            if (wantShutdown) {
+                shutdownSocket(socket, SHUT_RDWR);
+            }
 
-        // We only keep track of sockets with pending commands.
-        _socketIDMap.erase(socketIt);
+            // We only keep track of connections with pending commands.
+            _untrackClientConnection(socket);
+        }
     } else {
         if (!SIEquals(command->request["Connection"], "forget")) {
             SINFO("No socket to reply for: '" << command->request.methodLine << "' #" << command->initiatingClientID);
@@ -1785,6 +2595,72 @@ void BedrockServer::_reply(unique_ptr<BedrockCommand>& command) {
     }
 }
 
+void BedrockServer::_sendPipelinedResponse(Socket* socket, ClientConnection& conn, uint64_t sequence, string&& response) {
+    // Not this response's turn yet? Hold onto it; whoever sends the response before it will flush it.
+    if (sequence != conn.nextResponseSequence) {
+        conn.bufferedResponses.emplace(sequence, move(response));
+        return;
+    }
+    socket->send(move(response));
+    conn.nextResponseSequence++;
+
+    // Flush any successors that finished early.
+    auto it = conn.bufferedResponses.begin();
+    while (it != conn.bufferedResponses.end() && it->first == conn.nextResponseSequence) {
+        socket->send(move(it->second));
+        conn.nextResponseSequence++;
+        it = conn.bufferedResponses.erase(it);
+    }
+}
+
+bool BedrockServer::canStreamResponse(const BedrockCommand& command) {
+    // Escalated commands reply to a peer, and pseudo-clients don't reply at all; neither can stream.
+    if (command.initiatingPeerID || command.initiatingClientID < 0) {
+        return false;
+    }
+    SAUTOLOCK(_clientConnectionsMutex);
+    ClientConnection* conn = _findClientConnection(command.initiatingClientID);
+    if (!conn) {
+        return false;
+    }
+
+    // Anything else outstanding on this socket could complete mid-stream and land its bytes between two of our
+    // chunks, so we only stream to clients that aren't pipelining.
+    return conn->commandCount == 1;
+}
+
+bool BedrockServer::streamToClient(const BedrockCommand& command, const string& data) {
+    // How many unsent bytes we let accumulate before waiting for the main poll loop to drain some. This is what
+    // bounds a streamed response's memory use: a slow client pins roughly this much, plus one chunk, instead of the
+    // whole serialized result.
+    static const size_t STREAM_SEND_BUFFER_MAX = 4 * 1024 * 1024;
+    while (true) {
+        {
+            SAUTOLOCK(_clientConnectionsMutex);
+            ClientConnection* conn = _findClientConnection(command.initiatingClientID);
+            if (!conn || conn->socket->state.load() != STCPManager::Socket::CONNECTED) {
+                // Client's gone (closed sockets are untracked in postPoll); tell the streamer to stop.
+                return false;
+            }
+            if (conn->socket->sendBufferSize() < STREAM_SEND_BUFFER_MAX) {
+                conn->socket->send(data);
+                return true;
+            }
+        }
+
+        // The socket's backed up. Wait with the lock dropped so other replies aren't blocked behind this client.
+        usleep(10'000);
+    }
+}
+
+void BedrockServer::abortClientStream(const BedrockCommand& command) {
+    SAUTOLOCK(_clientConnectionsMutex);
+    ClientConnection* conn = _findClientConnection(command.initiatingClientID);
+    if (conn) {
+        shutdownSocket(conn->socket, SHUT_RDWR);
+    }
+}
+
 void BedrockServer::suppressCommandPort(const string& reason, bool suppress, bool manualOverride) {
     // If we've set the manual override flag, then we'll only actually make this change if we've specified it again.
     if (_suppressCommandPortManualOverride && !manualOverride) {
@@ -1799,12 +2675,14 @@ void BedrockServer::suppressCommandPort(const string& reason, bool suppress, boo
     // Process accordingly
     _suppressCommandPort = suppress;
     if (suppress) {
-        // Close the command port, and all plugin's ports. Won't reopen.
+        // Close the command port, and all plugin's ports. Won't reopen. The control port is unaffected; it
+        // belongs to the control thread.
         SHMMM("Suppressing command port");
         if (!portList.empty()) {
-            closePorts({_controlPort});
+            closePorts();
             _portPluginMap.clear();
             _commandPort = nullptr;
+            _unixCommandPort = nullptr;
         }
     } else {
         // Clearing past suppression, but don't reopen (It's always safe to close, but not always safe to open).
@@ -1847,6 +2725,147 @@ bool BedrockServer::isDetached() {
     return _detach && _syncThreadComplete && _pluginsDetached;
 }
 
+// Builds the content table for a full `Status` response. Factored out of _status so the skeleton cache for the
+// no-argument health-check variant (see _statusSkeleton) can reuse it.
+STable BedrockServer::_statusContentTable(const SData& request) {
+    STable content;
+    SQLiteNode::State state = _replicationState.load();
+    list<string> pluginList;
+    for (auto plugin : plugins) {
+        STable pluginData = plugin.second->getInfo();
+        pluginData["name"] = plugin.second->getName();
+        pluginList.push_back(SComposeJSONObject(pluginData));
+    }
+    content["isLeader"] = state == SQLiteNode::LEADING ? "true" : "false";
+    content["plugins"]  = SComposeJSONArray(pluginList);
+    content["state"]    = SQLiteNode::stateName(state);
+    content["version"]  = _version;
+    content["host"]     = args["-nodeHost"];
+
+    {
+        // Make it known if anything is known to cause crashes.
+        shared_lock<decltype(_crashCommandMutex)> lock(_crashCommandMutex);
+        size_t totalCount = 0;
+        for (const auto& s : _crashCommands) {
+            totalCount += s.second.size();
+        }
+        content["crashCommands"] = totalCount;
+    }
+
+    // On leader, return the current multi-write blacklists.
+    if (state == SQLiteNode::LEADING) {
+        // Both of these need to be in the correct state for multi-write to be enabled.
+        content["multiWriteEnabled"] = _multiWriteEnabled ? "true" : "false";
+        content["multiWriteManualBlacklist"] = SComposeJSONArray(_blacklistedParallelCommands);
+    }
+
+    // Coalesce all of the peer data into one value to return or return
+    // an error message if we timed out getting the peerList data.
+    list<string> peerList;
+    list<STable> peerData = getPeerInfo();
+    for (const STable& peerTable : peerData) {
+        peerList.push_back(SComposeJSONObject(peerTable));
+    }
+
+    // The full queue walks lock every queue they report on, so they're opt-in; the cheap per-method-line
+    // counters are always included and are what monitoring should poll.
+    bool fullDetail = SIEquals(request["detail"], "full");
+
+    // Compose the approximate queued-command counts from the counters the queue maintains on push/pop.
+    STable queuedCommandCounts;
+    for (const auto& countPair : _commandQueue.getMethodLineCounts()) {
+        queuedCommandCounts[countPair.first] = countPair.second;
+    }
+    content["peerList"]            = SComposeJSONArray(peerList);
+    content["queuedCommandCounts"] = SComposeJSONObject(queuedCommandCounts);
+    content["commandLatency"]      = SComposeJSONObject(BedrockCommand::commandLatencySummaries());
+
+    // Dump the global perf counter registry (lock waits, queue waits, escalation RTT, replication apply time)
+    // when asked, i.e., `Status` with `metrics: 1`. These are monotonic; scrapers diff successive samples.
+    if (request.test("metrics")) {
+        content["metrics"] = SComposeJSONObject(SMetrics::getAll());
+    }
+
+    // Per-statement plan state from the plan monitor ("baseline", "changed", or "uncaptured"), so a plan
+    // regression is visible here before anyone goes digging through logs.
+    STable queryPlans = SQLitePlanMonitor::status();
+    if (!queryPlans.empty()) {
+        content["queryPlans"] = SComposeJSONObject(queryPlans);
+    }
+
+    // The sampled query ledger's most expensive statement shapes, when asked (`Status` with `queryLedger: 1`).
+    // Unlike the statement trace this is always on, so there's always data to show unless sampling was disabled.
+    if (request.test("queryLedger")) {
+        STable queryLedger = SQLiteQueryLedger::status();
+        if (!queryLedger.empty()) {
+            content["queryLedger"] = SComposeJSONObject(queryLedger);
+        }
+    }
+
+    // The transactions that held the write position longest, per the statement tracer, when asked (`Status` with
+    // `statementTrace: 1`). Only populated when the server was started with -enableStatementTrace.
+    if (request.test("statementTrace")) {
+        STable statementTrace = SQLiteStatementTracer::status();
+        if (!statementTrace.empty()) {
+            content["statementTrace"] = SComposeJSONObject(statementTrace);
+        }
+    }
+
+    // Where each thread landed under -numaPlacement (empty, and thus omitted, when placement is off or the
+    // machine has a single node).
+    {
+        lock_guard<mutex> lock(_threadPlacementMutex);
+        if (!_threadPlacement.empty()) {
+            content["threadPlacement"] = SComposeJSONObject(_threadPlacement);
+        }
+    }
+    if (fullDetail) {
+        // We can use the `each` functionality to pass a lambda that will grab each method line in
+        // `_syncNodeQueuedCommands`.
+        list<string> syncNodeQueuedMethods;
+        _syncNodeQueuedCommands.each([&syncNodeQueuedMethods](auto& item){
+            syncNodeQueuedMethods.push_back(item->request.methodLine);
+        });
+        content["queuedCommandList"]           = SComposeJSONArray(_commandQueue.getRequestMethodLines());
+        content["syncThreadQueuedCommandList"] = SComposeJSONArray(syncNodeQueuedMethods);
+    }
+
+    auto _syncNodeCopy = atomic_load(&_syncNode);
+    if (_syncNodeCopy) {
+        content["syncNodeAvailable"] = "true";
+        // Set some information about this node.
+        content["CommitCount"] = to_string(_syncNodeCopy->getCommitCount());
+        content["priority"] = to_string(_syncNodeCopy->getPriority());
+
+        // Advertise the chained-read-replica role (see -subscribeTo), so client routing can steer analytical
+        // queries to these nodes and away from the followers serving production reads.
+        if (!_syncNodeCopy->getSubscribeTo().empty()) {
+            content["chainedReplica"] = "true";
+            content["upstreamPeer"] = _syncNodeCopy->getSubscribeTo();
+        }
+
+        // And the DR bridge's position against the primary cluster (see -bridgeFrom), so replication lag between
+        // the clusters is monitorable from the same place as everything else.
+        if (_clusterBridge) {
+            content["clusterBridge"] = SComposeJSONObject(_clusterBridge->status());
+        }
+
+        // Report the escalated commands that are waiting to be processed, from counters by default.
+        STable escalatedCommandCounts;
+        for (const auto& countPair : _syncNodeCopy->getEscalatedCommandCounts()) {
+            escalatedCommandCounts[countPair.first] = countPair.second;
+        }
+        content["escalatedCommandCounts"] = SComposeJSONObject(escalatedCommandCounts);
+        if (fullDetail) {
+            content["escalatedCommandList"] = SComposeJSONArray(_syncNodeCopy->getEscalatedCommandRequestMethodLines());
+        }
+        _syncNodeCopy = nullptr;
+    } else {
+        content["syncNodeAvailable"] = "false";
+    }
+    return content;
+}
+
 void BedrockServer::_status(unique_ptr<BedrockCommand>& command) {
     const SData& request  = command->request;
     SData& response = command->response;
@@ -1888,72 +2907,51 @@ void BedrockServer::_status(unique_ptr<BedrockCommand>& command) {
 
     // This collects the current state of the server, which also includes some state from the underlying SQLiteNode.
     else if (SIEquals(request.methodLine, STATUS_STATUS)) {
-        STable content;
-        SQLiteNode::State state = _replicationState.load();
-        list<string> pluginList;
-        for (auto plugin : plugins) {
-            STable pluginData = plugin.second->getInfo();
-            pluginData["name"] = plugin.second->getName();
-            pluginList.push_back(SComposeJSONObject(pluginData));
-        }
-        content["isLeader"] = state == SQLiteNode::LEADING ? "true" : "false";
-        content["plugins"]  = SComposeJSONArray(pluginList);
-        content["state"]    = SQLiteNode::stateName(state);
-        content["version"]  = _version;
-        content["host"]     = args["-nodeHost"];
-
-        {
-            // Make it known if anything is known to cause crashes.
-            shared_lock<decltype(_crashCommandMutex)> lock(_crashCommandMutex);
-            size_t totalCount = 0;
-            for (const auto& s : _crashCommands) {
-                totalCount += s.second.size();
+        // Health checks poll `Status` with no arguments several times a second per node. Serve that variant from a
+        // prebuilt skeleton, rebuilt at most once a second: everything slow to gather (plugin info, peer state,
+        // query plans - all behind their own locks) is at most a second stale, and the fields monitoring actually
+        // alarms on (state, commit count, queue depth) are patched onto the end fresh on every call.
+        if (!SIEquals(request["detail"], "full") && !request.test("metrics") && !request.test("statementTrace")) {
+            uint64_t now = STimeNow();
+            string content;
+            {
+                lock_guard<mutex> lock(_statusSkeletonMutex);
+                if (_statusSkeleton.empty() || now > _statusSkeletonBuiltUS + STATUS_SKELETON_TTL_US) {
+                    STable skeleton = _statusContentTable(request);
+                    skeleton.erase("state");
+                    skeleton.erase("isLeader");
+                    skeleton.erase("CommitCount");
+                    string serialized = SComposeJSONObject(skeleton);
+                    serialized.pop_back(); // Drop the closing brace; the patched fields complete the object.
+                    _statusSkeleton = move(serialized);
+                    _statusSkeletonBuiltUS = now;
+                }
+                content = _statusSkeleton;
             }
-            content["crashCommands"] = totalCount;
-        }
-
-        // On leader, return the current multi-write blacklists.
-        if (state == SQLiteNode::LEADING) {
-            // Both of these need to be in the correct state for multi-write to be enabled.
-            content["multiWriteEnabled"] = _multiWriteEnabled ? "true" : "false";
-            content["multiWriteManualBlacklist"] = SComposeJSONArray(_blacklistedParallelCommands);
-        }
-
-        // Coalesce all of the peer data into one value to return or return
-        // an error message if we timed out getting the peerList data.
-        list<string> peerList;
-        list<STable> peerData = getPeerInfo();
-        for (const STable& peerTable : peerData) {
-            peerList.push_back(SComposeJSONObject(peerTable));
-        }
-
-        // We can use the `each` functionality to pass a lambda that will grab each method line in
-        // `_syncNodeQueuedCommands`.
-        list<string> syncNodeQueuedMethods;
-        _syncNodeQueuedCommands.each([&syncNodeQueuedMethods](auto& item){
-            syncNodeQueuedMethods.push_back(item->request.methodLine);
-        });
-        content["peerList"]                    = SComposeJSONArray(peerList);
-        content["queuedCommandList"]           = SComposeJSONArray(_commandQueue.getRequestMethodLines());
-        content["syncThreadQueuedCommandList"] = SComposeJSONArray(syncNodeQueuedMethods);
-
-        auto _syncNodeCopy = atomic_load(&_syncNode);
-        if (_syncNodeCopy) {
-            content["syncNodeAvailable"] = "true";
-            // Set some information about this node.
-            content["CommitCount"] = to_string(_syncNodeCopy->getCommitCount());
-            content["priority"] = to_string(_syncNodeCopy->getPriority());
-
-            // Get any escalated commands that are waiting to be processed.
-            content["escalatedCommandList"] = SComposeJSONArray(_syncNodeCopy->getEscalatedCommandRequestMethodLines());
-            _syncNodeCopy = nullptr;
+            // Match SComposeJSONObject's value rendering (SToJSON): state is a quoted string, the booleans and
+            // numbers go out bare.
+            SQLiteNode::State state = _replicationState.load();
+            content += ",\"state\":\"";
+            content += SQLiteNode::stateName(state);
+            content += "\",\"isLeader\":";
+            content += (state == SQLiteNode::LEADING) ? "true" : "false";
+            auto syncNodeCopy = atomic_load(&_syncNode);
+            if (syncNodeCopy) {
+                content += ",\"CommitCount\":";
+                content += to_string(syncNodeCopy->getCommitCount());
+                syncNodeCopy = nullptr;
+            }
+            content += ",\"queuedCommandCount\":";
+            content += to_string(_commandQueue.size());
+            content += '}';
+            response.methodLine = "200 OK";
+            response.content = move(content);
         } else {
-            content["syncNodeAvailable"] = "false";
+            // The detailed variants change shape with their arguments and aren't polled, so they just pay for a
+            // fresh build.
+            response.methodLine = "200 OK";
+            response.content = SComposeJSONObject(_statusContentTable(request));
         }
-
-        // Done, compose the response.
-        response.methodLine = "200 OK";
-        response.content = SComposeJSONObject(content);
     }
 
     else if (SIEquals(request.methodLine, STATUS_BLACKLIST)) {
@@ -2062,11 +3060,72 @@ void BedrockServer::_control(unique_ptr<BedrockCommand>& command) {
     }
 }
 
+void BedrockServer::onPrepareToLead(SQLite& db) {
+    // Read the tail of the journal back into the page cache. These are the pages the first SYNCHRONIZE requests and
+    // escalations will hit, and after a failover they're usually cold.
+    static const uint64_t JOURNAL_WARM_COMMITS = 10'000;
+    uint64_t commitCount = db.getCommitCount();
+    uint64_t fromIndex = commitCount > JOURNAL_WARM_COMMITS ? commitCount - JOURNAL_WARM_COMMITS + 1 : 1;
+    uint64_t start = STimeNow();
+    SQResult ignore;
+    db.getCommits(fromIndex, commitCount, ignore);
+    SINFO("Warmed " << (commitCount - fromIndex + 1) << " recent journal commits in "
+          << (STimeNow() - start) / 1000 << "ms.");
+
+    // And let each plugin warm whatever its own hot paths need.
+    for (auto plugin : plugins) {
+        plugin.second->onPrepareToLead(db);
+    }
+}
+
 bool BedrockServer::_upgradeDB(SQLite& db) {
-    // These all get conglomerated into one big query.
+    // First pass: dry-run every plugin's upgrade concurrently, each on its own handle in write-probe mode. On a
+    // normal startup no plugin needs any schema changes, so this turns the serial verification walk into a parallel
+    // one, and any in-memory warm-up the plugins do (index rebuilds, allocator seeding) happens concurrently too. A
+    // plugin that *does* need a write aborts its dry-run on the first attempt - before paying for the write, which
+    // could be an entire index build - and re-runs for real below.
+    list<thread> dryRunThreads;
+    mutex upgradeListMutex;
+    set<string> pluginsNeedingUpgrade;
+    for (auto plugin : plugins) {
+        dryRunThreads.emplace_back([&, plugin]() {
+            SInitialize("upgrade" + plugin.first);
+            SQLite threadDB(db);
+            threadDB.setWriteProbeMode(true);
+            threadDB.beginTransaction(SQLite::TRANSACTION_TYPE::SHARED);
+            try {
+                plugin.second->upgradeDatabase(threadDB);
+                SINFO("Plugin '" << plugin.first << "' requires no DB upgrade.");
+            } catch (const SQLite::write_attempted_error&) {
+                SINFO("Plugin '" << plugin.first << "' requires a DB upgrade.");
+                lock_guard<mutex> lock(upgradeListMutex);
+                pluginsNeedingUpgrade.insert(plugin.first);
+            } catch (...) {
+                // Whatever this was, let it recur on the sync thread, where it would always have happened before.
+                SWARN("Plugin '" << plugin.first << "' threw during dry-run upgrade, re-running it serially.");
+                lock_guard<mutex> lock(upgradeListMutex);
+                pluginsNeedingUpgrade.insert(plugin.first);
+            }
+            threadDB.rollback();
+        });
+    }
+    for (auto& dryRunThread : dryRunThreads) {
+        dryRunThread.join();
+    }
+    if (pluginsNeedingUpgrade.empty()) {
+        SINFO("Finished running DB upgrade (no changes).");
+        return false;
+    }
+
+    // Second pass: the plugins that need writes run serially on the sync thread's handle, conglomerated into one big
+    // query, so the whole upgrade still replicates as a single quorum commit. (SQLite has no online index build or
+    // index swap, and replicated DDL has to ride the journal, so there's no safe way to move these writes off this
+    // path; the dry-run just keeps plugins that don't need them from waiting in line behind them.)
     db.beginTransaction(SQLite::TRANSACTION_TYPE::EXCLUSIVE);
     for (auto plugin : plugins) {
-        plugin.second->upgradeDatabase(db);
+        if (pluginsNeedingUpgrade.count(plugin.first)) {
+            plugin.second->upgradeDatabase(db);
+        }
     }
     if (db.getUncommittedQuery().empty()) {
         db.rollback();
@@ -2133,16 +3192,13 @@ void BedrockServer::_beginShutdown(const string& reason, bool detach) {
         // state.
         _acceptSockets();
 
-        // Close our listening ports, we won't accept any new connections on them, except the control port, if we're
-        // detaching. It needs to keep listening.
-        if (_detach) {
-            closePorts({_controlPort});
-        } else {
-            closePorts();
-            _controlPort = nullptr;
-        }
+        // Close our listening ports, we won't accept any new connections on them. The control port isn't ours to
+        // close - it lives on the control thread and keeps listening through shutdown (required when detaching,
+        // and it lets Status work while we drain).
+        closePorts();
         _portPluginMap.clear();
         _commandPort = nullptr;
+        _unixCommandPort = nullptr;
         _shutdownState.store(START_SHUTDOWN);
         SINFO("START_SHUTDOWN. Ports shutdown, will perform final socket read. Commands queued: " << _commandQueue.size()
               << ", blocking commands queued: " << _blockingCommandQueue.size());
@@ -2202,6 +3258,19 @@ void BedrockServer::_finishPeerCommand(unique_ptr<BedrockCommand>& command) {
     } else {
         auto _syncNodeCopy = atomic_load(&_syncNode);
         if (_syncNodeCopy) {
+            // Stamp the read-your-writes token with *our* commit count (we're leader here) if the command didn't
+            // commit anything itself, so the follower relays a token at least as new as the data this command saw,
+            // not its own (possibly behind) count.
+            if (!command->response.isSet("commitCount")) {
+                command->response["commitCount"] = to_string(_syncNodeCopy->getCommitCount());
+            }
+
+            // If the follower forwards sealed responses, serialize the final client-ready bytes now, so it never has
+            // to reparse and reserialize them on its way to the client.
+            STCPNode::Peer* peer = _syncNodeCopy->getPeerByID(command->initiatingPeerID);
+            if (peer && peer->useSealedResponses) {
+                command->sealResponseForEscalation(peer->name);
+            }
             _syncNodeCopy->sendResponse(*command);
         }
     }
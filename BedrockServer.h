@@ -1,10 +1,15 @@
 #pragma once
 #include <libstuff/libstuff.h>
+#include <libstuff/STimerWheel.h>
 #include <sqlitecluster/SQLiteNode.h>
 #include <sqlitecluster/SQLiteServer.h>
 #include "BedrockPlugin.h"
 #include "BedrockCommandQueue.h"
+#include "BedrockConflictManager.h"
+#include "BedrockDedupCache.h"
+#include "BedrockForgetJournal.h"
 #include "BedrockTimeoutCommandQueue.h"
+class SQLiteClusterBridge;
 
 class BedrockServer : public SQLiteServer {
   public:
@@ -108,12 +113,12 @@ class BedrockServer : public SQLiteServer {
     // need to support it for now. Here's the case that should look catastrophic, but is actually quite common, and what
     // we should eventually do about it:
     //
-    // A follower begins shutdown, and sets a 60 second timeout. It has escalated commands to leader. It wants to wait for
-    // the responses to these commands before it finishes shutting down, but *there is no timeout on escalated
-    // commands*. Normally, we won't try to shut down the sync node until we've responded to all connected clients.
-    // Because there will always be connected clients waiting for these responses to escalated commands, we'll wait the
-    // full 60 seconds, and then we'll just die with no responses. Effectively, the sever `kill -9`'s itself here,
-    // leaving clients hanging with no cleanup.
+    // A follower begins shutdown, and sets a 60 second timeout. It has escalated commands to leader. It wants to wait
+    // for the responses to these commands before it finishes shutting down. Escalated commands do carry their own
+    // timeout now (SQLiteNode fails them with "555 Timeout" when it passes, see _failTimedOutEscalations), so a lost
+    // response no longer pins the command forever - but a command whose own timeout extends past the 60-second window
+    // still does. In that case we'll wait the full 60 seconds, and then we'll just die with no responses. Effectively,
+    // the sever `kill -9`'s itself here, leaving clients hanging with no cleanup.
     //
     // On leader, this state could be catastrophic, though leader doesn't need to worry about a lack of timeouts on
     // escalations, so let's look at a different case - a command running a custom query that takes longer than our 60
@@ -148,6 +153,12 @@ class BedrockServer : public SQLiteServer {
     // All of our available plugins, indexed by the name they supply.
     map<string, BedrockPlugin*> plugins;
 
+    // Request verb -> plugin, built once at startup from each plugin's `supportedVerbs`, so that constructing a
+    // command is a single case-insensitive hash lookup rather than probing every plugin's `getCommand` in turn.
+    // Commands that miss the index (prefix-matched methodLines, plugins that don't advertise verbs) still fall back
+    // to the probe loop.
+    unordered_map<string, BedrockPlugin*, SCaseInsensitiveHash, SCaseInsensitiveEqual> _commandDispatchIndex;
+
     // Our primary constructor.
     BedrockServer(const SData& args_);
 
@@ -186,6 +197,22 @@ class BedrockServer : public SQLiteServer {
     // SQLiteNode API.
     void cancelCommand(const string& commandID);
 
+    // Whether `command` may stream its response straight to its client socket: it must have come from a connected
+    // local client (not a peer escalation or a pseudo-client), and it must be that socket's only outstanding command,
+    // so the stream's chunks can't interleave with another response's bytes. A client that asked for a streamed
+    // response should wait for it to finish before pipelining its next request.
+    bool canStreamResponse(const BedrockCommand& command);
+
+    // Appends `data` to the client socket's send buffer for a streaming response. If the socket already has more
+    // than a high-water mark of unsent bytes, blocks until the main poll loop drains it, so a slow client bounds our
+    // memory use instead of growing the buffer to the size of the result. Returns false once the client is gone, so
+    // the streamer can stop producing rows.
+    bool streamToClient(const BedrockCommand& command, const string& data);
+
+    // Shuts down the client socket of a command whose streamed response failed partway through. The missing
+    // terminating chunk plus the closed connection is what tells the client the result was truncated.
+    void abortClientStream(const BedrockCommand& command);
+
     // Flush the send buffers
     // STCPNode API.
     void prePoll(fd_map& fdm);
@@ -205,6 +232,12 @@ class BedrockServer : public SQLiteServer {
     // When a peer node logs in, we'll send it our crash command list.
     void onNodeLogin(SQLiteNode::Peer* peer);
 
+    // Called by the sync node once standup is approved, before it goes LEADING. Touches the tail of the journal (the
+    // pages synchronization and escalation will read first) and then lets each plugin warm its own hot structures via
+    // BedrockPlugin::onPrepareToLead.
+    // SQLiteNode API.
+    void onPrepareToLead(SQLite& db) override;
+
     // Control the command port. The server will toggle this as necessary, unless manualOverride is set,
     // in which case the `suppress` setting will be forced.
     void suppressCommandPort(const string& reason, bool suppress, bool manualOverride = false);
@@ -253,15 +286,97 @@ class BedrockServer : public SQLiteServer {
     // These are commands that will be processed in a blacking fashion.
     BedrockCommandQueue _blockingCommandQueue;
 
-    // Each time we read a new request from a client, we give it a unique ID.
-    uint64_t _requestCount;
+    // Tracks per-table conflict rates for worker commits, so that commands writing conflict-hot tables can be routed
+    // to _blockingCommandQueue instead of retrying in parallel against commands they'll just conflict with again.
+    BedrockConflictManager _conflictManager;
+
+    // Adaptive worker-pool scaling. Every worker thread exists for the life of the server (the journal table count
+    // and DB pool are sized to the maximum at startup), but threads with IDs at or above _activeWorkerLimit park
+    // instead of dequeuing commands. The sync loop adjusts the limit between min and max via _scaleWorkerPool():
+    // scale-up is immediate whenever commands are waiting and every active worker is busy — which also covers
+    // workers stuck in long `process` calls or parked on HTTPS requests — while scale-down requires the pool to
+    // look idle for _WORKER_SCALE_DOWN_INTERVALS consecutive intervals, so bursts don't thrash it.
+    atomic<int> _activeWorkerLimit = {0};
+    atomic<int> _busyWorkers = {0};
+    int _minWorkerThreads = 0;
+    int _maxWorkerThreads = 0;
+    uint64_t _nextWorkerScaleCheck = 0;
+    int _workerIdleIntervals = 0;
+    static const uint64_t _WORKER_SCALE_INTERVAL = 250 * STIME_US_PER_MS;
+    static const int _WORKER_SCALE_DOWN_INTERVALS = 20;
+    void _scaleWorkerPool();
+
+    // NUMA placement (enabled with `-numaPlacement` on multi-node machines, see sync()): the machine's memory node
+    // count (0 when placement is off), and which node each thread ended up bound to, surfaced in Status. Guarded by
+    // _threadPlacementMutex.
+    atomic<int> _numaNodeCount = {0};
+    STable _threadPlacement;
+    mutex _threadPlacementMutex;
+
+    // Each time we read a new request from a client, we give it a unique ID. Atomic because acceptor threads assign
+    // IDs concurrently with the main poll loop.
+    atomic<uint64_t> _requestCount;
+
+    // Per-connection client state, one struct per socket, held in the flat fd-indexed registry below. A connection
+    // is "tracked" from the time a command is read from it until the last outstanding response is sent, even if the
+    // socket stays open; it's re-tracked (with fresh sequences) when another command is read from it.
+    //
+    // Clients can pipeline: we read every complete request off a socket and dispatch them all concurrently, but
+    // responses have to go back in the order the requests were received, since clients match them up by position.
+    // The sequence fields track that ordering. Commands complete on arbitrary worker threads, so a response that
+    // finishes early gets buffered here until its turn. Commands whose requests include the `Idempotent` header opt
+    // out and are sent the moment they complete. The hot scalar fields sit together up front; the buffer map at the
+    // end is only touched when pipelined commands actually complete out of order.
+    struct ClientConnection {
+        // The socket this state belongs to, and its STCPManager id. The id identifies the *connection* where the fd
+        // alone can't: fd numbers get recycled, ids don't, so the id doubles as the slot's generation counter (see
+        // _findClientConnection). A null socket means the slot isn't tracked.
+        Socket* socket = nullptr;
+        uint64_t socketID = 0;
+
+        // The sequence to assign to the next request read from this socket, and the sequence of the next response to
+        // send. Sequences start at 1; 0 means "not sequenced" (see SQLiteCommand::socketSequence).
+        uint64_t nextRequestSequence = 1;
+        uint64_t nextResponseSequence = 1;
+
+        // The number of commands we've read from this socket and not yet replied to. When it hits zero, we stop
+        // tracking the connection.
+        size_t commandCount = 0;
+
+        // Set when a reply wanted to shut the socket down (Connection: close, or server shutdown) but other commands
+        // were still outstanding; we shut down after the last of them is sent.
+        bool shutdownOnCompletion = false;
+
+        // Completed responses that can't be sent until an earlier one finishes, by sequence.
+        map<uint64_t, string> bufferedResponses;
+    };
+
+    // The registry: flat, indexed by fd, grown on demand and never shrunk (entries are small, and the table tops out
+    // at the process's fd limit). Guarded by _clientConnectionsMutex.
+    vector<ClientConnection> _clientConnections;
+
+    // How many low bits of a client ID hold the fd; the socket id sits in the bits above. Commands carry the packed
+    // value in initiatingClientID, so a completed command finds its connection with a single index into the registry
+    // instead of a map walk, and an ID from a closed connection just fails the socket-id check.
+    static constexpr int CLIENT_ID_FD_BITS = 20;
+    static int64_t _clientID(const Socket* s);
+
+    // Returns the tracked connection for a packed client ID or a socket, or nullptr if it isn't tracked (including
+    // when the fd has since been recycled for a newer connection). Callers hold _clientConnectionsMutex.
+    ClientConnection* _findClientConnection(int64_t clientID);
+    ClientConnection* _findClientConnection(const Socket* s);
+
+    // Returns the connection's entry, creating it (with fresh sequences) if this socket isn't currently tracked.
+    ClientConnection& _trackClientConnection(Socket* s);
 
-    // Each time we read a command off a socket, we put the socket in this map, so that we can respond to it when the
-    // command completes. We remove the socket from the map when we reply to the command, even if the socket is still
-    // open. It will be re-inserted in this set when another command is read from it.
-    map <uint64_t, Socket*> _socketIDMap;
+    // Drops a connection's state. No-op if it isn't tracked, or if the slot now belongs to a newer connection.
+    void _untrackClientConnection(const Socket* s);
 
-    // The above _socketIDMap is modified by multiple threads, so we lock this mutex around operations that access it.
+    // Sends `response` on `socket` if it's this socket's turn (flushing any buffered successors), or buffers it
+    // until it is. Must be called with _clientConnectionsMutex held.
+    void _sendPipelinedResponse(Socket* socket, ClientConnection& conn, uint64_t sequence, string&& response);
+
+    // The registry above is modified by multiple threads, so we lock this mutex around operations that access it.
     // We don't need to lock around access to the base class's `socketList` because we carefully control access to it
     // to the main thread.
     // The only functions that access `socketList` are prePoll, postPoll, openSocket, and closeSocket, in STCPManager,
@@ -269,7 +384,7 @@ class BedrockServer : public SQLiteServer {
     // prePoll and postPoll are only ever called by the main thread.
     // openSocket is never called by bedrockServer (it is called in SHTTPSManager and STCPNode).
     // closeSocket and acceptSocket are only called inside postPoll.
-    recursive_mutex _socketIDMutex;
+    recursive_mutex _clientConnectionsMutex;
 
     // This is the replication state of the sync node. It's updated after every SQLiteNode::update() iteration. A
     // reference to this object is passed to the sync thread to allow this update.
@@ -336,6 +451,18 @@ class BedrockServer : public SQLiteServer {
                        BedrockServer& server,
                        int threadId);
 
+    // The maintenance scheduler thread runs this function: it watches for the command queues to go idle and runs
+    // plugins' registered background tasks (see BedrockPlugin::backgroundTasks) one slice at a time on its own DB
+    // handle, yielding the moment load returns. Started and joined by the sync thread alongside the workers.
+    static void _maintenance(SQLitePool& dbPool, BedrockServer& server);
+
+    // Tells the maintenance thread to exit; set by the sync thread at shutdown.
+    atomic<bool> _maintenanceShouldExit = {false};
+
+    // The inter-cluster replication bridge (see SQLiteClusterBridge), created by the sync thread when the server is
+    // started with -bridgeFrom and destroyed when the sync thread exits. Null otherwise.
+    unique_ptr<SQLiteClusterBridge> _clusterBridge;
+
     // Send a reply for a completed command back to the initiating client. If the `originator` of the command is set,
     // then this is an error, as the command should have been sent back to a peer.
     void _reply(unique_ptr<BedrockCommand>& command);
@@ -358,6 +485,19 @@ class BedrockServer : public SQLiteServer {
     // Functions for checking for and responding to status and control commands.
     bool _isStatusCommand(const unique_ptr<BedrockCommand>& command);
     void _status(unique_ptr<BedrockCommand>& command);
+
+    // Builds the content table for a full `Status` response; see the skeleton cache below for why it's factored out
+    // of _status.
+    STable _statusContentTable(const SData& request);
+
+    // Prebuilt no-argument `Status` response content: the serialized JSON of everything that's slow to gather
+    // (plugin info, peer state, query plans - all behind their own locks), with the closing brace left off so the
+    // per-call fields (state, isLeader, CommitCount, queuedCommandCount) can be patched onto the end. Health checks
+    // poll Status several times a second; within the TTL each one costs a string copy and a few appends.
+    mutex _statusSkeletonMutex;
+    string _statusSkeleton;
+    uint64_t _statusSkeletonBuiltUS = 0;
+    static constexpr uint64_t STATUS_SKELETON_TTL_US = 1'000'000;
     bool _isControlCommand(const unique_ptr<BedrockCommand>& command);
     bool _isNonSecureControlCommand(const unique_ptr<BedrockCommand>& command);
     void _control(unique_ptr<BedrockCommand>& command);
@@ -366,6 +506,29 @@ class BedrockServer : public SQLiteServer {
     // those ports.
     void _acceptSockets();
 
+    // Handles one client socket for the poll loop that owns it: reaps closed sockets, and parses every complete
+    // request in the receive buffer into commands appended to `newCommands`. Shared by the main poll loop and the
+    // acceptor threads.
+    void _handleSocket(STCPManager::Socket* s, vector<unique_ptr<BedrockCommand>>& newCommands,
+                       list<STCPManager::Socket*>& socketsToClose, int& deserializationAttempts,
+                       int& deserializedRequests, uint64_t lastChance);
+
+    // Body of each extra acceptor thread (`-acceptorThreads`). Binds the command port with SO_REUSEPORT, so the
+    // kernel spreads incoming connections across the main poll loop and every acceptor, and runs a private
+    // accept/receive/parse loop feeding the shared command queue. Takes the accept+parse path off the main poll
+    // loop's critical path during connection storms.
+    void _acceptorLoop(size_t threadNum);
+    list<thread> _acceptorThreads;
+    atomic<bool> _acceptorThreadsShouldExit;
+
+    // Body of the control thread. Owns a private listener bound to the control port for the server's entire
+    // lifetime, so Status and control commands are parsed and answered on this thread and never wait behind
+    // production traffic in the main poll loop or the command queue - the server stays manageable even at 100%
+    // load. Anything else arriving on the control port still feeds the shared command queue, as it always has.
+    void _controlLoop();
+    thread _controlThread;
+    atomic<bool> _controlThreadShouldExit;
+
     // This stars the server shutting down.
     void _beginShutdown(const string& reason, bool detach = false);
 
@@ -375,8 +538,8 @@ class BedrockServer : public SQLiteServer {
     // we catch up, and then move them back to the regular command queue.
     multimap<uint64_t, unique_ptr<BedrockCommand>> _futureCommitCommands;
 
-    // Map of command timeouts to the indexes into _futureCommitCommands where those commands live.
-    multimap<uint64_t, uint64_t> _futureCommitCommandTimeouts;
+    // Timer wheel of command timeouts to the indexes into _futureCommitCommands where those commands live.
+    STimerWheel<uint64_t> _futureCommitCommandTimeouts;
     recursive_mutex _futureCommitCommandMutex;
 
     // A set of command names that will always be run with QUORUM consistency level.
@@ -400,10 +563,31 @@ class BedrockServer : public SQLiteServer {
     bool _shouldBackup;
     atomic<bool> _detach;
 
-    // Pointers to the ports on which we accept commands.
-    Port* _controlPort;
+    // Whether admission control is enabled (see -admissionControl): commands whose projected queue wait already
+    // exceeds their timeout budget are rejected with a fast 503 instead of queued, and commands whose deadline
+    // passed while queued are shed at dequeue the same way, so a backed-up queue stops burning workers on answers
+    // no client is still waiting for.
+    bool _admissionControlEnabled = false;
+
+    // Pointer to the port on which we accept commands. The control port is not here; it's owned by the control
+    // thread's private listener (see _controlLoop).
     Port* _commandPort;
 
+    // The unix domain socket port for same-host clients (see -unixSocket), or null when not configured or not open.
+    // It opens, suppresses, and closes in lockstep with the command port; commands arriving on it are handled
+    // identically to ones from the TCP command port.
+    Port* _unixCommandPort;
+
+    // The crash-safe intake journal for accepted `Connection: forget` commands (see -forgetJournal), or null when
+    // not configured or the file couldn't be mapped. Written at accept time, marked complete when a command
+    // finishes, and replayed at startup.
+    unique_ptr<BedrockForgetJournal> _forgetJournal;
+
+    // Final responses of commands that carried an `IdempotencyKey` header, so client-timeout retries are answered
+    // here instead of being dispatched (and possibly committed) a second time. Stored in _reply, consulted at
+    // accept time.
+    BedrockDedupCache _dedupCache;
+
     // The maximum number of conflicts we'll accept before forwarding a command to the sync thread.
     atomic<int> _maxConflictRetries;
 
@@ -473,6 +657,19 @@ class BedrockServer : public SQLiteServer {
     // that just needs to be returned to a peer.
     BedrockTimeoutCommandQueue _completedCommands;
 
+    // The responder thread serializes and sends responses for commands the sync thread completes, so the sync loop
+    // never blocks on response composition or socket writes between state-machine iterations — during commit storms,
+    // escalation completion batches used to stall replication behind exactly that I/O. The sync loop hands completed
+    // commands over via _queueSyncResponse; the responder routes each through the same thread-safe _reply /
+    // _finishPeerCommand paths the workers use. The thread itself is started and joined by the sync thread, which
+    // also flips _responderShouldExit; the responder drains the queue before exiting, so nothing queued is lost.
+    void _responder();
+    void _queueSyncResponse(unique_ptr<BedrockCommand>&& command);
+    list<unique_ptr<BedrockCommand>> _responderQueue;
+    mutex _responderMutex;
+    condition_variable _responderCV;
+    atomic<bool> _responderShouldExit = {false};
+
     // Whether or not all plugins are detached
     bool _pluginsDetached;
 
@@ -7,9 +7,11 @@ const unique_ptr<BedrockCommand>& BedrockTimeoutCommandQueue::front() const {
     }
 
     // has anything timed out?
-    if (_timeoutMap.begin()->first < STimeNow()) {
-        // first item has timed out, that's the effective front.
-        return *(_timeoutMap.begin()->second);
+    uint64_t timedOutAt;
+    list<unique_ptr<BedrockCommand>>::iterator timedOutIt;
+    if (_timeouts.peekExpired(STimeNow(), timedOutAt, timedOutIt)) {
+        // That item has timed out, that's the effective front.
+        return *timedOutIt;
     }
     return _queue.front();
 }
@@ -17,18 +19,20 @@ const unique_ptr<BedrockCommand>& BedrockTimeoutCommandQueue::front() const {
 void BedrockTimeoutCommandQueue::push(unique_ptr<BedrockCommand>&& rhs) {
     lock_guard<decltype(_queueMutex)> lock(_queueMutex);
 
-    // Add to the queue and timeout map.
+    // Add to the queue and timer wheel.
+    bool wasEmpty = _queue.empty();
     _queue.push_back(move(rhs));
     _queue.back()->startTiming(BedrockCommand::QUEUE_SYNC);
 
     // This is past-the-end, so we decrement it to point to the last element.
     auto lastIt = _queue.end();
     lastIt--;
-    _timeoutMap.insert(make_pair((*lastIt)->timeout(), lastIt));
+    _timeouts.insert((*lastIt)->timeout(), lastIt);
 
-    // Write arbitrary buffer to the pipe so any subscribers will be awoken.
-    // **NOTE: 1 byte so write is atomic.
-    SASSERT(write(_pipeFD[1], "A", 1));
+    // Wake any subscribers, if the queue was empty before this push (see the base class).
+    if (wasEmpty) {
+        _signal();
+    }
 }
 
 unique_ptr<BedrockCommand> BedrockTimeoutCommandQueue::pop() {
@@ -36,24 +40,18 @@ unique_ptr<BedrockCommand> BedrockTimeoutCommandQueue::pop() {
     if (_queue.empty()) {
         throw out_of_range("No commands");
     }
-    if (_timeoutMap.begin()->first < STimeNow()) {
-        unique_ptr<BedrockCommand> item = move(*(_timeoutMap.begin()->second));
-        _queue.erase(_timeoutMap.begin()->second);
-        _timeoutMap.erase(_timeoutMap.begin());
+    uint64_t timedOutAt;
+    list<unique_ptr<BedrockCommand>>::iterator timedOutIt;
+    if (_timeouts.popExpired(STimeNow(), timedOutAt, timedOutIt)) {
+        unique_ptr<BedrockCommand> item = move(*timedOutIt);
+        _queue.erase(timedOutIt);
         item->stopTiming(BedrockCommand::QUEUE_SYNC);
         return item;
     }
 
-    // We need to remove the reference in the timeout map for this item as well.
+    // We need to remove the reference in the timer wheel for this item as well.
     auto firstCommandIt = _queue.begin();
-    auto itPair = _timeoutMap.equal_range((*firstCommandIt)->timeout());
-    for (auto it = itPair.first; it != itPair.second; it++) {
-        if (it->second == firstCommandIt) {
-            // This one points at this command, remove it.
-            _timeoutMap.erase(it);
-            break;
-        }
-    }
+    _timeouts.cancel((*firstCommandIt)->timeout(), firstCommandIt);
     unique_ptr<BedrockCommand> item = move(*firstCommandIt);
     item->stopTiming(BedrockCommand::QUEUE_SYNC);
     _queue.pop_front();
@@ -1,4 +1,5 @@
 #include <libstuff/libstuff.h>
+#include <libstuff/STimerWheel.h>
 #include <BedrockCommand.h>
 
 class BedrockTimeoutCommandQueue : public SSynchronizedQueue<unique_ptr<BedrockCommand>> {
@@ -9,7 +10,8 @@ class BedrockTimeoutCommandQueue : public SSynchronizedQueue<unique_ptr<BedrockC
     unique_ptr<BedrockCommand> pop();
 
   private:
-    // Map of timeouts to commands in the queue. Because the queue is a std::list, we can store iterators into it and
-    // they stay valid as we manipulate the list, avoiding walking the list to re-locate them.
-    multimap<uint64_t, list<unique_ptr<BedrockCommand>>::iterator> _timeoutMap;
+    // Timer wheel of timeouts to commands in the queue. Because the queue is a std::list, we can store iterators
+    // into it and they stay valid as we manipulate the list, avoiding walking the list to re-locate them. Mutable
+    // because the wheel advances (internally re-buckets) when `front` checks for expirations.
+    mutable STimerWheel<list<unique_ptr<BedrockCommand>>::iterator> _timeouts;
 };
@@ -0,0 +1,156 @@
+// A sharded, open-addressing hash map for tracking in-flight objects by integer ID. Where SynchronizedMap serializes
+// every operation through one global mutex (and std::map chases pointers per lookup), this hashes each key to one of
+// a fixed set of shards, each with its own mutex and its own linear-probing table, so threads working on different
+// IDs don't contend and a lookup touches one contiguous slot array. Keys are expected to come from a monotonic
+// counter, so consecutive IDs land on consecutive shards. The whole-map operations (forEach, takeAll) lock every
+// shard and are intended for rare accounting paths like shutdown and state changes, not steady-state traffic.
+#pragma once
+template <typename V>
+class ShardedMap {
+  public:
+    // Inserts a value under the given key. Returns false (leaving the map unchanged) if the key is already present.
+    bool emplace(uint64_t key, V&& value) {
+        Shard& shard = _shards[key & (SHARD_COUNT - 1)];
+        lock_guard<mutex> lock(shard.m);
+        if (shard.keys.empty() || (shard.count + 1) * 4 > shard.keys.size() * 3) {
+            _grow(shard);
+        }
+        size_t mask = shard.keys.size() - 1;
+        size_t i = _slot(key, mask);
+        while (shard.keys[i] != EMPTY_SLOT) {
+            if (shard.keys[i] == key) {
+                return false;
+            }
+            i = (i + 1) & mask;
+        }
+        shard.keys[i] = key;
+        shard.values[i] = move(value);
+        shard.count++;
+        return true;
+    }
+
+    // Removes and returns the value stored under the given key, or a default-constructed V if it isn't present.
+    V take(uint64_t key) {
+        Shard& shard = _shards[key & (SHARD_COUNT - 1)];
+        lock_guard<mutex> lock(shard.m);
+        if (shard.keys.empty()) {
+            return V();
+        }
+        size_t mask = shard.keys.size() - 1;
+        size_t i = _slot(key, mask);
+        while (shard.keys[i] != EMPTY_SLOT) {
+            if (shard.keys[i] == key) {
+                V value = move(shard.values[i]);
+                _eraseSlot(shard, i);
+                return value;
+            }
+            i = (i + 1) & mask;
+        }
+        return V();
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (const Shard& shard : _shards) {
+            lock_guard<mutex> lock(shard.m);
+            total += shard.count;
+        }
+        return total;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    // Calls `f(key, value)` for every entry, with every shard locked for the duration. This stalls all concurrent
+    // operations, so it's reserved for accounting (i.e., logging what's left at shutdown).
+    void forEach(const function<void(uint64_t, const V&)>& f) const {
+        for (const Shard& shard : _shards) {
+            lock_guard<mutex> lock(shard.m);
+            for (size_t i = 0; i < shard.keys.size(); i++) {
+                if (shard.keys[i] != EMPTY_SLOT) {
+                    f(shard.keys[i], shard.values[i]);
+                }
+            }
+        }
+    }
+
+    // Removes every entry and returns the values, in no particular order.
+    list<V> takeAll() {
+        list<V> values;
+        for (Shard& shard : _shards) {
+            lock_guard<mutex> lock(shard.m);
+            for (size_t i = 0; i < shard.keys.size(); i++) {
+                if (shard.keys[i] != EMPTY_SLOT) {
+                    values.push_back(move(shard.values[i]));
+                    shard.keys[i] = EMPTY_SLOT;
+                    shard.values[i] = V();
+                }
+            }
+            shard.count = 0;
+        }
+        return values;
+    }
+
+  private:
+    static const size_t SHARD_COUNT = 16;
+    static const size_t INITIAL_CAPACITY = 16;
+
+    // Slot key meaning "unoccupied". Real keys are counter-derived and never approach this.
+    static const uint64_t EMPTY_SLOT = (uint64_t)-1;
+
+    struct Shard {
+        mutable mutex m;
+        vector<uint64_t> keys;
+        vector<V> values;
+        size_t count = 0;
+    };
+
+    // Fibonacci hashing spreads the counter-derived keys across the table.
+    static size_t _slot(uint64_t key, size_t mask) {
+        return (size_t)(key * 0x9E3779B97F4A7C15ull) & mask;
+    }
+
+    // Doubles the shard's capacity (capacities are always powers of two) and rehashes everything into place.
+    static void _grow(Shard& shard) {
+        vector<uint64_t> oldKeys = move(shard.keys);
+        vector<V> oldValues = move(shard.values);
+        size_t capacity = oldKeys.empty() ? INITIAL_CAPACITY : oldKeys.size() * 2;
+        shard.keys.assign(capacity, EMPTY_SLOT);
+        shard.values.clear();
+        shard.values.resize(capacity);
+        size_t mask = capacity - 1;
+        for (size_t i = 0; i < oldKeys.size(); i++) {
+            if (oldKeys[i] != EMPTY_SLOT) {
+                size_t j = _slot(oldKeys[i], mask);
+                while (shard.keys[j] != EMPTY_SLOT) {
+                    j = (j + 1) & mask;
+                }
+                shard.keys[j] = oldKeys[i];
+                shard.values[j] = move(oldValues[i]);
+            }
+        }
+    }
+
+    // Empties the slot at `i` using backward-shift deletion: any entry further down the probe chain whose ideal
+    // position is at or before the hole gets moved back into it, so probing never needs tombstones.
+    static void _eraseSlot(Shard& shard, size_t i) {
+        size_t mask = shard.keys.size() - 1;
+        size_t hole = i;
+        size_t next = (hole + 1) & mask;
+        while (shard.keys[next] != EMPTY_SLOT) {
+            size_t ideal = _slot(shard.keys[next], mask);
+            if (((next - ideal) & mask) >= ((next - hole) & mask)) {
+                shard.keys[hole] = shard.keys[next];
+                shard.values[hole] = move(shard.values[next]);
+                hole = next;
+            }
+            next = (next + 1) & mask;
+        }
+        shard.keys[hole] = EMPTY_SLOT;
+        shard.values[hole] = V();
+        shard.count--;
+    }
+
+    Shard _shards[SHARD_COUNT];
+};
@@ -2,60 +2,64 @@
 
 WallClockTimer::WallClockTimer() :
   _count(0),
-  _currentStart(),
-  _absoluteStart(),
-  _elapsedRecorded(chrono::milliseconds::zero())
+  _currentStartUS(0),
+  _absoluteStartUS(0),
+  _elapsedRecordedUS(0)
 {
 }
 
+int64_t WallClockTimer::_nowUS() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 void WallClockTimer::start() {
-    lock_guard<mutex> lock(_m);
+    // If the timer isn't running, start it. Nobody else can write _currentStartUS until the count returns to zero,
+    // which it can't while we're inside our own start/stop pair.
+    if (_count.fetch_add(1) == 0) {
+        int64_t now = _nowUS();
+        _currentStartUS.store(now);
 
-    // If the timer isn't running, start it.
-    if (!_count) {
-        _currentStart = chrono::steady_clock::now();
-    }
-    _count++;
-    
-    // If we've never started this timer before, mark this as its absolute beginning.
-    if (_absoluteStart.time_since_epoch() == chrono::milliseconds::zero()) {
-        _absoluteStart = _currentStart;
+        // If we've never started this timer before, mark this as its absolute beginning.
+        int64_t expected = 0;
+        _absoluteStartUS.compare_exchange_strong(expected, now);
     }
 }
 
 void WallClockTimer::stop() {
-    lock_guard<mutex> lock(_m);
-
-    // If we're about to decrement to zero, record the time.
-    if (_count == 1) {
-        // No longer timing, record the length of time that we were.
-        _elapsedRecorded += chrono::duration_cast<std::chrono::milliseconds>(chrono::steady_clock::now() - _currentStart);
-    } else if (_count == 0) {
+    // Read the start time *before* decrementing: while our increment is still counted, no 0->1 transition can
+    // overwrite it. The moment we decrement to zero another thread may begin a new stretch, but by then we have our
+    // copy.
+    int64_t startedUS = _currentStartUS.load();
+    int64_t previous = _count.fetch_sub(1);
+    if (previous == 1) {
+        // We were the last thread running; record the length of time that we were.
+        _elapsedRecordedUS.fetch_add(_nowUS() - startedUS);
+    } else if (previous <= 0) {
         SWARN("Stopped timer that wasn't running. Resetting.");
-        _count = 0;
-        _absoluteStart = chrono::steady_clock::time_point();
-        _currentStart = chrono::steady_clock::time_point();
-        _elapsedRecorded = chrono::milliseconds::zero();
+        _count.store(0);
+        _currentStartUS.store(0);
+        _absoluteStartUS.store(0);
+        _elapsedRecordedUS.store(0);
     }
-    _count--;
 }
 
 pair<chrono::milliseconds, chrono::milliseconds> WallClockTimer::getStatsAndReset() {
-    lock_guard<mutex> lock(_m);
-
-    // Figure out how much time it's been.
-    auto now = chrono::steady_clock::now();
-    auto startTime = _absoluteStart;
-    auto recorded = _elapsedRecorded;
-    if (_count) {
-        recorded += chrono::duration_cast<std::chrono::milliseconds>(now - _currentStart);
+    // Figure out how much time it's been, swapping in the new window as we read the old one out. A sample completing
+    // concurrently with this lands in whichever window its stop happened to race into; over the 10-second windows
+    // this is called at, that's noise.
+    int64_t now = _nowUS();
+    int64_t startTime = _absoluteStartUS.exchange(now);
+    int64_t recorded = _elapsedRecordedUS.exchange(0);
+    if (_count.load()) {
+        // Still running: credit the current stretch to the window being closed, and restart it at the boundary.
+        recorded += now - _currentStartUS.exchange(now);
+    }
+    if (!startTime) {
+        // Never started; an empty window.
+        startTime = now;
     }
-
-    // reset our counters.
-    _currentStart = now;
-    _absoluteStart = now;
-    _elapsedRecorded = chrono::milliseconds::zero();
 
     // Return our result.
-    return make_pair(chrono::duration_cast<std::chrono::milliseconds>(now - startTime), recorded);
+    return make_pair(chrono::duration_cast<chrono::milliseconds>(chrono::microseconds(now - startTime)),
+                     chrono::duration_cast<chrono::milliseconds>(chrono::microseconds(recorded)));
 }
@@ -2,6 +2,12 @@
 
 // A WallClockTimer is a class that can be used by multiple threads to count wall clock time that some task is
 // occurring. This won't double-count the same wall clock time for two different threads that are working in parallel.
+//
+// start/stop are wait-free: one atomic increment or decrement, plus one store on the transitions where the timer
+// actually starts or stops running (0->1 and 1->0). These are called per-replicated-transaction, so they can't
+// afford a shared mutex. The cost of going lock-free is that a start racing the very instant of a 0->1 transition
+// can read a start time that's off by the width of that race; the error is bounded by scheduler jitter, which is
+// noise against the 10-second windows this reports over.
 class WallClockTimer {
   public:
     // Create a new WallClockTimer.
@@ -20,11 +26,22 @@ class WallClockTimer {
     pair<chrono::milliseconds, chrono::milliseconds> getStatsAndReset();
 
   private:
-    mutex _m;
-    uint64_t _count;
-    chrono::steady_clock::time_point _currentStart;
-    chrono::steady_clock::time_point _absoluteStart;
-    chrono::milliseconds _elapsedRecorded;
+    // Current steady-clock time in microseconds, the unit all the atomics below are kept in.
+    static int64_t _nowUS();
+
+    // How many threads are currently inside a start/stop pair. The timer is "running" whenever this is non-zero.
+    atomic<int64_t> _count;
+
+    // When the current running stretch began (valid while _count is non-zero). Only ever written on a 0->1
+    // transition, so it's stable for as long as any thread keeps the count above zero — which is what lets stop()
+    // read it without a lock.
+    atomic<int64_t> _currentStartUS;
+
+    // When the current reporting window began. Zero until the first start, reset by getStatsAndReset.
+    atomic<int64_t> _absoluteStartUS;
+
+    // Running time accumulated by completed stretches in the current reporting window.
+    atomic<int64_t> _elapsedRecordedUS;
 };
 
 // You can use an AutoScopedWallClockTimer to start timing with a WallClockTimer and have timing stop automatically
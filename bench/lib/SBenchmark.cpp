@@ -0,0 +1,68 @@
+#include "SBenchmark.h"
+
+// How long a measured interval needs to be before we trust it. Well above timer granularity, well below tedium.
+static const uint64_t MINIMUM_INTERVAL_US = 200'000;
+
+// Give up growing the iteration count at a billion; anything whose billion iterations finish under the minimum
+// interval is sub-nanosecond and the harness can't resolve it anyway.
+static const uint64_t MAXIMUM_ITERATIONS = 1'000'000'000;
+
+SBenchmark::SBenchmark(const string& name, Body body) : _name(name), _body(move(body)), _bytesPerOp(0) {
+    _registry().push_back(this);
+}
+
+list<SBenchmark*>& SBenchmark::_registry() {
+    static list<SBenchmark*> registry;
+    return registry;
+}
+
+void SBenchmark::setBytesPerOp(size_t bytes) {
+    _bytesPerOp = bytes;
+}
+
+void SBenchmark::_run() {
+    // Grow the iteration count until the measured interval is long enough to trust. The final (trusted) measurement
+    // is the one we report.
+    uint64_t iterations = 1;
+    uint64_t elapsedUS = 0;
+    while (true) {
+        uint64_t start = STimeNow();
+        _body(*this, iterations);
+        elapsedUS = STimeNow() - start;
+        if (elapsedUS >= MINIMUM_INTERVAL_US || iterations >= MAXIMUM_ITERATIONS) {
+            break;
+        }
+
+        // Scale toward ~2x the minimum interval in one step when we have a signal, otherwise just multiply.
+        if (elapsedUS) {
+            iterations = min(MAXIMUM_ITERATIONS, max(iterations + 1, iterations * 2 * MINIMUM_INTERVAL_US / elapsedUS));
+        } else {
+            iterations = min(MAXIMUM_ITERATIONS, iterations * 100);
+        }
+    }
+
+    double seconds = (double)elapsedUS / STIME_US_PER_S;
+    double opsPerSec = (double)iterations / seconds;
+    double nsPerOp = seconds * 1e9 / (double)iterations;
+    char line[256];
+    if (_bytesPerOp) {
+        double mbPerSec = opsPerSec * (double)_bytesPerOp / (1024.0 * 1024.0);
+        snprintf(line, sizeof(line), "%-40s %12.1f ns/op %15.0f ops/sec %10.1f MB/sec", _name.c_str(), nsPerOp,
+                 opsPerSec, mbPerSec);
+    } else {
+        snprintf(line, sizeof(line), "%-40s %12.1f ns/op %15.0f ops/sec", _name.c_str(), nsPerOp, opsPerSec);
+    }
+    cout << line << endl;
+}
+
+size_t SBenchmark::runAll(const set<string>& only) {
+    size_t count = 0;
+    for (SBenchmark* benchmark : _registry()) {
+        if (!only.empty() && !only.count(benchmark->_name)) {
+            continue;
+        }
+        benchmark->_run();
+        count++;
+    }
+    return count;
+}
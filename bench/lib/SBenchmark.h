@@ -0,0 +1,48 @@
+#pragma once
+#include <libstuff/libstuff.h>
+
+// Minimal microbenchmark harness in the spirit of tpunit++: each measurement is a statically-constructed SBenchmark,
+// which registers itself, and `main` calls `runAll`. The body receives an iteration count and must run its operation
+// exactly that many times; the harness re-runs it with growing counts until the measured interval is long enough to
+// trust, then prints one line with ns/op, ops/sec, and (if the benchmark declares a per-op payload size) MB/sec.
+//
+// Usage:
+//
+//     SBenchmark parseHTTP("SParseHTTP", [](SBenchmark& b, uint64_t iterations) {
+//         b.setBytesPerOp(request.size());
+//         for (uint64_t i = 0; i < iterations; i++) {
+//             ... one parse ...
+//         }
+//     });
+class SBenchmark {
+  public:
+    typedef function<void(SBenchmark&, uint64_t iterations)> Body;
+
+    // Registers this benchmark under `name`. Like tpunit++ fixtures, these are meant to be constructed statically.
+    SBenchmark(const string& name, Body body);
+
+    // Declares the number of payload bytes each iteration handles, enabling bytes/sec reporting. Call from the body;
+    // it's fine to call every run.
+    void setBytesPerOp(size_t bytes);
+
+    // Keeps the compiler from optimizing away a computed result the benchmark doesn't otherwise use.
+    template <typename T>
+    static void doNotOptimize(const T& value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    // Runs every registered benchmark (or just those named in `only`, if non-empty) and prints one line per
+    // benchmark. Returns the number run.
+    static size_t runAll(const set<string>& only = {});
+
+  private:
+    // Runs this benchmark's calibration loop and prints its report line.
+    void _run();
+
+    string _name;
+    Body _body;
+    size_t _bytesPerOp;
+
+    // All registered benchmarks, in construction order.
+    static list<SBenchmark*>& _registry();
+};
@@ -0,0 +1,118 @@
+#include <libstuff/libstuff.h>
+#include <libstuff/SScheduledPriorityQueue.h>
+#include <bench/lib/SBenchmark.h>
+
+// Microbenchmarks for libstuff hot paths. Run with `make bench && bench/bench`, optionally passing `-only` with a
+// comma-separated list of benchmark names. These exist so a regression in any of these paths shows up as a number in
+// a diff, not as production graphs; compare before/after on the same idle machine, as the harness does nothing to
+// control for noisy neighbors.
+
+// A representative request: a verb, a handful of headers, and a small body, like the command traffic between peers.
+static string _sampleRequest() {
+    SData request("CreateJob / HTTP/1.1");
+    request["Host"] = "bedrock.example.com";
+    request["Connection"] = "keep-alive";
+    request["requestID"] = "ab12cd34ef56";
+    request["priority"] = "500";
+    request["commandExecuteTime"] = "1714000000000000";
+    request["Content-Type"] = "application/json";
+    request.content = "{\"name\":\"test/job/name\",\"data\":{\"key\":\"value\",\"count\":42},\"repeat\":\"SCHEDULED, +1 HOUR\"}";
+    return request.serialize();
+}
+
+static SBenchmark _benchParseHTTP("SParseHTTP", [](SBenchmark& b, uint64_t iterations) {
+    static const string request = _sampleRequest();
+    b.setBytesPerOp(request.size());
+    string methodLine;
+    STable headers;
+    string content;
+    for (uint64_t i = 0; i < iterations; i++) {
+        methodLine.clear();
+        headers.clear();
+        content.clear();
+        SBenchmark::doNotOptimize(SParseHTTP(request, methodLine, headers, content));
+    }
+});
+
+static SBenchmark _benchToJSON("SToJSON escape", [](SBenchmark& b, uint64_t iterations) {
+    // Mostly-clean text with a sprinkling of characters that need escaping, like real job data.
+    static const string value = "A \"quoted\" string with a\ttab, a\nnewline, some / slashes, and then a long plain "
+                                "tail: " + string(400, 'x');
+    b.setBytesPerOp(value.size());
+    for (uint64_t i = 0; i < iterations; i++) {
+        SBenchmark::doNotOptimize(SToJSON(value));
+    }
+});
+
+static SBenchmark _benchFastBufferAppend("SFastBuffer append", [](SBenchmark& b, uint64_t iterations) {
+    static const string chunk(1024, 'x');
+    b.setBytesPerOp(chunk.size());
+    SFastBuffer buffer;
+    for (uint64_t i = 0; i < iterations; i++) {
+        buffer.append(chunk.data(), chunk.size());
+
+        // Periodically drain so the buffer models a socket that keeps up, rather than growing without bound.
+        if (buffer.size() >= 1024 * 1024) {
+            buffer.consumeFront(buffer.size());
+        }
+    }
+    SBenchmark::doNotOptimize(buffer.size());
+});
+
+static SBenchmark _benchScheduledQueue("SScheduledPriorityQueue push/get", [](SBenchmark& b, uint64_t iterations) {
+    SScheduledPriorityQueue<string> queue;
+    string item = "a queued item well past small-string size, like a serialized command";
+    uint64_t now = STimeNow();
+    for (uint64_t i = 0; i < iterations; i++) {
+        // Alternate priorities so the queue actually exercises its priority map, and schedule in the past so `get`
+        // never waits.
+        string copy = item;
+        queue.push(move(copy), (i % 2) ? 500 : 1000, now - 1, now + STIME_US_PER_H);
+        SBenchmark::doNotOptimize(queue.get());
+    }
+});
+
+static SBenchmark _benchSQResultSerialize("SQResult serializeToJSON", [](SBenchmark& b, uint64_t iterations) {
+    // A mid-sized query result: 100 rows of 5 modest columns.
+    static const SQResult result = [] {
+        SQResult r;
+        r.headers = {"jobID", "name", "created", "state", "data"};
+        for (int row = 0; row < 100; row++) {
+            r.addRow();
+            r.addCell(to_string(1000000 + row));
+            r.addCell("some/job/name/" + to_string(row));
+            r.addCell("2024-04-01 12:34:56");
+            r.addCell("QUEUED");
+            r.addCell("{\"key\":\"value\",\"count\":" + to_string(row) + "}");
+        }
+        return r;
+    }();
+    b.setBytesPerOp(result.contentSize());
+    for (uint64_t i = 0; i < iterations; i++) {
+        SBenchmark::doNotOptimize(result.serializeToJSON());
+    }
+});
+
+static SBenchmark _benchSDataHeaderAccess("SData header access", [](SBenchmark& b, uint64_t iterations) {
+    static const SData request(_sampleRequest());
+    for (uint64_t i = 0; i < iterations; i++) {
+        SBenchmark::doNotOptimize(request["requestID"]);
+        SBenchmark::doNotOptimize(request.calc("priority"));
+        SBenchmark::doNotOptimize(request.calcU64("commandExecuteTime"));
+        SBenchmark::doNotOptimize(request.isSet("Connection"));
+    }
+});
+
+int main(int argc, char* argv[]) {
+    SData args = SParseCommandLine(argc, argv);
+    set<string> only;
+    for (string name : SParseList(args["-only"])) {
+        only.insert(name);
+    }
+    size_t count = SBenchmark::runAll(only);
+    if (!count) {
+        cout << "No benchmarks matched." << endl;
+        return 1;
+    }
+    return 0;
+}
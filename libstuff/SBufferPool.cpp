@@ -0,0 +1,107 @@
+#include "libstuff.h"
+
+// The pool keeps three size classes. Each tier bounds how many free buffers it retains (so the pool itself can't
+// balloon), and every DECAY_INTERVAL it frees the buffers it didn't need during the last interval: we track the
+// free list's low-water mark, and anything that sat on the list through a whole interval clearly wasn't required to
+// service the load, so we give it back to the allocator.
+namespace {
+    struct Tier {
+        Tier(size_t capacity_, size_t maxFree_) : capacity(capacity_), maxFree(maxFree_) { }
+        const size_t capacity;
+        const size_t maxFree;
+        mutex m;
+        vector<string> freeList;
+        size_t lowWaterMark = 0;
+        uint64_t lastDecay = 0;
+    };
+
+    // Decay unused buffers every 10 seconds.
+    const uint64_t DECAY_INTERVAL = 10 * STIME_US_PER_S;
+
+    // Tier capacities and retention caps: 4MB of 4KB buffers, 16MB of 64KB buffers, 64MB of 1MB buffers, worst-case.
+    Tier& tier4KB() { static Tier t(4 * 1024, 1024); return t; }
+    Tier& tier64KB() { static Tier t(64 * 1024, 256); return t; }
+    Tier& tier1MB() { static Tier t(1024 * 1024, 64); return t; }
+
+    // With the tier lock held, frees buffers that went unused for a full decay interval.
+    void decayIdle(Tier& tier) {
+        uint64_t now = STimeNow();
+        if (!tier.lastDecay) {
+            tier.lastDecay = now;
+        } else if (now > tier.lastDecay + DECAY_INTERVAL) {
+            // Everything below the low-water mark sat idle all interval; drop it.
+            for (size_t i = 0; i < tier.lowWaterMark && !tier.freeList.empty(); i++) {
+                tier.freeList.pop_back();
+            }
+            tier.lowWaterMark = tier.freeList.size();
+            tier.lastDecay = now;
+        }
+    }
+}
+
+string SBufferPool::acquire(size_t sizeHint) {
+    // Find the smallest tier that covers the request. Oversized requests get an unpooled backing.
+    Tier* tier = nullptr;
+    if (sizeHint <= tier4KB().capacity) {
+        tier = &tier4KB();
+    } else if (sizeHint <= tier64KB().capacity) {
+        tier = &tier64KB();
+    } else if (sizeHint <= tier1MB().capacity) {
+        tier = &tier1MB();
+    } else {
+        string buffer;
+        buffer.reserve(sizeHint);
+        return buffer;
+    }
+
+    // Reuse a pooled backing if one's free, tracking the low-water mark for the decay pass.
+    {
+        lock_guard<mutex> lock(tier->m);
+        decayIdle(*tier);
+        if (!tier->freeList.empty()) {
+            string buffer = move(tier->freeList.back());
+            tier->freeList.pop_back();
+            tier->lowWaterMark = min(tier->lowWaterMark, tier->freeList.size());
+            return buffer;
+        }
+    }
+
+    // Nothing free, make a new one at the tier's full capacity so it's maximally reusable.
+    string buffer;
+    buffer.reserve(tier->capacity);
+    return buffer;
+}
+
+void SBufferPool::release(string&& buffer) {
+    // File by capacity. Anything below the smallest class isn't worth a lock, and anything well beyond the largest
+    // class would let one pathological message pin memory forever, so both just get freed.
+    size_t capacity = buffer.capacity();
+    Tier* tier = nullptr;
+    if (capacity >= tier1MB().capacity) {
+        tier = capacity <= 2 * tier1MB().capacity ? &tier1MB() : nullptr;
+    } else if (capacity >= tier64KB().capacity) {
+        tier = &tier64KB();
+    } else if (capacity >= tier4KB().capacity) {
+        tier = &tier4KB();
+    }
+    if (!tier) {
+        return;
+    }
+    buffer.clear();
+    lock_guard<mutex> lock(tier->m);
+    decayIdle(*tier);
+    if (tier->freeList.size() < tier->maxFree) {
+        tier->freeList.push_back(move(buffer));
+    }
+}
+
+size_t SBufferPool::freeBytes() {
+    size_t total = 0;
+    for (Tier* tier : {&tier4KB(), &tier64KB(), &tier1MB()}) {
+        lock_guard<mutex> lock(tier->m);
+        for (const string& buffer : tier->freeList) {
+            total += buffer.capacity();
+        }
+    }
+    return total;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+using namespace std;
+
+// A global, tiered pool of reusable buffer backings (plain strings with reserved capacity) in 4KB, 64KB, and 1MB
+// classes. SFastBuffer leases its backing storage from here when it grows and returns it when it drains or is
+// destroyed, so ten thousand mostly-idle sockets share one working set of large buffers instead of each pinning its
+// own peak-sized allocation. Each tier caps how many free buffers it retains, and decays toward its recent low-water
+// mark, so a burst of large messages doesn't permanently inflate RSS.
+class SBufferPool {
+  public:
+    // Buffers smaller than this aren't worth pooling; acquire and release both ignore them.
+    static constexpr size_t MIN_POOLED_CAPACITY = 4 * 1024;
+
+    // Returns a string with at least `sizeHint` bytes of reserved capacity, reusing a pooled backing when one of the
+    // size classes covers the request. Requests larger than the biggest class get a freshly-reserved string that
+    // won't be retained on release.
+    static string acquire(size_t sizeHint);
+
+    // Returns a backing to the pool. The buffer is cleared and filed by capacity class; buffers below the smallest
+    // class, beyond the largest class, or exceeding the tier's retention cap are simply freed.
+    static void release(string&& buffer);
+
+    // The total bytes currently held in free lists, for tests and diagnostics.
+    static size_t freeBytes();
+};
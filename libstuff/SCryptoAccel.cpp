@@ -0,0 +1,288 @@
+#include "SCryptoAccel.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+#include <immintrin.h>
+
+bool SCryptoAccel::aesAvailable() {
+    static const bool available = __builtin_cpu_supports("aes") && __builtin_cpu_supports("sse4.1");
+    return available;
+}
+
+bool SCryptoAccel::shaAvailable() {
+    static const bool available = __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+    return available;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// AES-256-CBC with AES-NI.
+/////////////////////////////////////////////////////////////////////////////
+
+// The AES-256 key schedule alternates two expansion steps: odd round keys use AESKEYGENASSIST's rot/sub word (with
+// the round constant), even ones just the sub word.
+__attribute__((target("aes,sse2")))
+static inline __m128i _aes256KeyExpOdd(__m128i key, __m128i assist) {
+    assist = _mm_shuffle_epi32(assist, 0xFF);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+}
+
+__attribute__((target("aes,sse2")))
+static inline __m128i _aes256KeyExpEven(__m128i key, __m128i prev) {
+    __m128i assist = _mm_shuffle_epi32(_mm_aeskeygenassist_si128(prev, 0x00), 0xAA);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+}
+
+__attribute__((target("aes,sse2")))
+static void _aes256ExpandKey(const unsigned char* key, __m128i roundKeys[15]) {
+    roundKeys[0] = _mm_loadu_si128((const __m128i*)key);
+    roundKeys[1] = _mm_loadu_si128((const __m128i*)(key + 16));
+    roundKeys[2] = _aes256KeyExpOdd(roundKeys[0], _mm_aeskeygenassist_si128(roundKeys[1], 0x01));
+    roundKeys[3] = _aes256KeyExpEven(roundKeys[1], roundKeys[2]);
+    roundKeys[4] = _aes256KeyExpOdd(roundKeys[2], _mm_aeskeygenassist_si128(roundKeys[3], 0x02));
+    roundKeys[5] = _aes256KeyExpEven(roundKeys[3], roundKeys[4]);
+    roundKeys[6] = _aes256KeyExpOdd(roundKeys[4], _mm_aeskeygenassist_si128(roundKeys[5], 0x04));
+    roundKeys[7] = _aes256KeyExpEven(roundKeys[5], roundKeys[6]);
+    roundKeys[8] = _aes256KeyExpOdd(roundKeys[6], _mm_aeskeygenassist_si128(roundKeys[7], 0x08));
+    roundKeys[9] = _aes256KeyExpEven(roundKeys[7], roundKeys[8]);
+    roundKeys[10] = _aes256KeyExpOdd(roundKeys[8], _mm_aeskeygenassist_si128(roundKeys[9], 0x10));
+    roundKeys[11] = _aes256KeyExpEven(roundKeys[9], roundKeys[10]);
+    roundKeys[12] = _aes256KeyExpOdd(roundKeys[10], _mm_aeskeygenassist_si128(roundKeys[11], 0x20));
+    roundKeys[13] = _aes256KeyExpEven(roundKeys[11], roundKeys[12]);
+    roundKeys[14] = _aes256KeyExpOdd(roundKeys[12], _mm_aeskeygenassist_si128(roundKeys[13], 0x40));
+}
+
+__attribute__((target("aes,sse2")))
+static void _aes256CBCEncryptImpl(const unsigned char* key, unsigned char iv[16], const unsigned char* in,
+                                  size_t length, unsigned char* out) {
+    __m128i rk[15];
+    _aes256ExpandKey(key, rk);
+
+    // CBC encryption is inherently serial: each block's input includes the previous block's output.
+    __m128i chain = _mm_loadu_si128((const __m128i*)iv);
+    for (size_t offset = 0; offset < length; offset += 16) {
+        __m128i block = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(in + offset)), chain);
+        block = _mm_xor_si128(block, rk[0]);
+        for (int round = 1; round < 14; round++) {
+            block = _mm_aesenc_si128(block, rk[round]);
+        }
+        chain = _mm_aesenclast_si128(block, rk[14]);
+        _mm_storeu_si128((__m128i*)(out + offset), chain);
+    }
+    _mm_storeu_si128((__m128i*)iv, chain);
+}
+
+__attribute__((target("aes,sse2")))
+static void _aes256CBCDecryptImpl(const unsigned char* key, unsigned char iv[16], const unsigned char* in,
+                                  size_t length, unsigned char* out) {
+    __m128i rk[15];
+    _aes256ExpandKey(key, rk);
+
+    // Decryption uses the round keys in reverse, passed through the inverse MixColumns transform.
+    __m128i drk[15];
+    drk[0] = rk[14];
+    for (int i = 1; i < 14; i++) {
+        drk[i] = _mm_aesimc_si128(rk[14 - i]);
+    }
+    drk[14] = rk[0];
+
+    __m128i chain = _mm_loadu_si128((const __m128i*)iv);
+    for (size_t offset = 0; offset < length; offset += 16) {
+        __m128i cipher = _mm_loadu_si128((const __m128i*)(in + offset));
+        __m128i block = _mm_xor_si128(cipher, drk[0]);
+        for (int round = 1; round < 14; round++) {
+            block = _mm_aesdec_si128(block, drk[round]);
+        }
+        block = _mm_xor_si128(_mm_aesdeclast_si128(block, drk[14]), chain);
+        _mm_storeu_si128((__m128i*)(out + offset), block);
+        chain = cipher;
+    }
+    _mm_storeu_si128((__m128i*)iv, chain);
+}
+
+void SCryptoAccel::aes256CBCEncrypt(const unsigned char* key, unsigned char iv[16], const unsigned char* in,
+                                    size_t length, unsigned char* out) {
+    _aes256CBCEncryptImpl(key, iv, in, length, out);
+}
+
+void SCryptoAccel::aes256CBCDecrypt(const unsigned char* key, unsigned char iv[16], const unsigned char* in,
+                                    size_t length, unsigned char* out) {
+    _aes256CBCDecryptImpl(key, iv, in, length, out);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SHA-1 and SHA-256 with the SHA extensions.
+/////////////////////////////////////////////////////////////////////////////
+
+// Runs the SHA-1 compression function over `blocks` 64-byte blocks. The SHA1RNDS4 instruction does four rounds at a
+// time, so a block is 20 groups; the message schedule is kept in a rotating window of four W registers, with
+// W[g] = SHA1MSG2(SHA1MSG1(W[g-4], W[g-3]) ^ W[g-2], W[g-1]).
+__attribute__((target("sha,ssse3,sse4.1")))
+static void _sha1Blocks(uint32_t state[5], const unsigned char* data, size_t blocks) {
+    const __m128i MASK = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+    __m128i ABCD = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1B);
+    __m128i E = _mm_set_epi32((int)state[4], 0, 0, 0);
+    while (blocks--) {
+        const __m128i ABCD_SAVE = ABCD;
+        const __m128i E_SAVE = E;
+        __m128i msg[4];
+        __m128i saved = _mm_setzero_si128();
+        for (int g = 0; g < 20; g++) {
+            __m128i w;
+            if (g < 4) {
+                w = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16 * g)), MASK);
+            } else {
+                w = _mm_sha1msg2_epu32(
+                    _mm_xor_si128(_mm_sha1msg1_epu32(msg[g & 3], msg[(g + 1) & 3]), msg[(g + 2) & 3]),
+                    msg[(g + 3) & 3]);
+            }
+            msg[g & 3] = w;
+
+            // The first group adds E directly; later groups derive it from the ABCD saved before the previous
+            // SHA1RNDS4. The round function selector must be an immediate, hence the switch.
+            __m128i eIn = g == 0 ? _mm_add_epi32(E, w) : _mm_sha1nexte_epu32(saved, w);
+            saved = ABCD;
+            switch (g / 5) {
+                case 0: ABCD = _mm_sha1rnds4_epu32(ABCD, eIn, 0); break;
+                case 1: ABCD = _mm_sha1rnds4_epu32(ABCD, eIn, 1); break;
+                case 2: ABCD = _mm_sha1rnds4_epu32(ABCD, eIn, 2); break;
+                default: ABCD = _mm_sha1rnds4_epu32(ABCD, eIn, 3); break;
+            }
+        }
+        E = _mm_sha1nexte_epu32(saved, E_SAVE);
+        ABCD = _mm_add_epi32(ABCD, ABCD_SAVE);
+        data += 64;
+    }
+    _mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(ABCD, 0x1B));
+    state[4] = (uint32_t)_mm_extract_epi32(E, 3);
+}
+
+static const uint32_t _sha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+// Runs the SHA-256 compression function over `blocks` 64-byte blocks. SHA256RNDS2 does two rounds and works on the
+// state packed as ABEF/CDGH; the schedule is again a rotating four-register window, with
+// W[g] = SHA256MSG2(SHA256MSG1(W[g-4], W[g-3]) + ALIGNR(W[g-1], W[g-2], 4), W[g-1]).
+__attribute__((target("sha,ssse3,sse4.1")))
+static void _sha256Blocks(uint32_t state[8], const unsigned char* data, size_t blocks) {
+    const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i TMP = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xB1);    // CDAB
+    __m128i STATE1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1B); // EFGH
+    __m128i STATE0 = _mm_alignr_epi8(TMP, STATE1, 8);                                     // ABEF
+    STATE1 = _mm_blend_epi16(STATE1, TMP, 0xF0);                                          // CDGH
+    while (blocks--) {
+        const __m128i STATE0_SAVE = STATE0;
+        const __m128i STATE1_SAVE = STATE1;
+        __m128i msg[4];
+        for (int g = 0; g < 16; g++) {
+            __m128i w;
+            if (g < 4) {
+                w = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16 * g)), MASK);
+            } else {
+                w = _mm_sha256msg2_epu32(
+                    _mm_add_epi32(_mm_sha256msg1_epu32(msg[g & 3], msg[(g + 1) & 3]),
+                                  _mm_alignr_epi8(msg[(g + 3) & 3], msg[(g + 2) & 3], 4)),
+                    msg[(g + 3) & 3]);
+            }
+            msg[g & 3] = w;
+            __m128i wk = _mm_add_epi32(w, _mm_loadu_si128((const __m128i*)&_sha256K[4 * g]));
+            STATE1 = _mm_sha256rnds2_epu32(STATE1, STATE0, wk);
+            STATE0 = _mm_sha256rnds2_epu32(STATE0, STATE1, _mm_shuffle_epi32(wk, 0x0E));
+        }
+        STATE0 = _mm_add_epi32(STATE0, STATE0_SAVE);
+        STATE1 = _mm_add_epi32(STATE1, STATE1_SAVE);
+        data += 64;
+    }
+    TMP = _mm_shuffle_epi32(STATE0, 0x1B);       // FEBA
+    STATE1 = _mm_shuffle_epi32(STATE1, 0xB1);    // DCHG
+    STATE0 = _mm_blend_epi16(TMP, STATE1, 0xF0); // DCBA
+    STATE1 = _mm_alignr_epi8(STATE1, TMP, 8);    // HGFE
+    _mm_storeu_si128((__m128i*)&state[0], STATE0);
+    _mm_storeu_si128((__m128i*)&state[4], STATE1);
+}
+
+// Shared padding for both hashes: copy the partial tail block, append 0x80 and the bit length as a 64-bit
+// big-endian integer, producing one or two final blocks.
+static size_t _shaPadTail(const unsigned char* data, size_t length, unsigned char tail[128]) {
+    memset(tail, 0, 128);
+    const size_t tailLen = length % 64;
+    memcpy(tail, data + (length - tailLen), tailLen);
+    tail[tailLen] = 0x80;
+    const size_t padded = (tailLen + 1 + 8 > 64) ? 128 : 64;
+    const uint64_t bits = (uint64_t)length * 8;
+    for (int i = 0; i < 8; i++) {
+        tail[padded - 1 - i] = (unsigned char)(bits >> (8 * i));
+    }
+    return padded;
+}
+
+void SCryptoAccel::sha1(const unsigned char* data, size_t length, unsigned char result[20]) {
+    uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    _sha1Blocks(state, data, length / 64);
+    unsigned char tail[128];
+    _sha1Blocks(state, tail, _shaPadTail(data, length, tail) / 64);
+    for (int i = 0; i < 5; i++) {
+        result[4 * i + 0] = (unsigned char)(state[i] >> 24);
+        result[4 * i + 1] = (unsigned char)(state[i] >> 16);
+        result[4 * i + 2] = (unsigned char)(state[i] >> 8);
+        result[4 * i + 3] = (unsigned char)(state[i]);
+    }
+}
+
+void SCryptoAccel::sha256(const unsigned char* data, size_t length, unsigned char result[32]) {
+    uint32_t state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    _sha256Blocks(state, data, length / 64);
+    unsigned char tail[128];
+    _sha256Blocks(state, tail, _shaPadTail(data, length, tail) / 64);
+    for (int i = 0; i < 8; i++) {
+        result[4 * i + 0] = (unsigned char)(state[i] >> 24);
+        result[4 * i + 1] = (unsigned char)(state[i] >> 16);
+        result[4 * i + 2] = (unsigned char)(state[i] >> 8);
+        result[4 * i + 3] = (unsigned char)(state[i]);
+    }
+}
+
+#else
+
+// Non-x86_64 builds: no hardware paths, callers fall back to mbedtls. The worker functions are never called when
+// the `*Available()` flags are false.
+bool SCryptoAccel::aesAvailable() {
+    return false;
+}
+
+bool SCryptoAccel::shaAvailable() {
+    return false;
+}
+
+void SCryptoAccel::aes256CBCEncrypt(const unsigned char*, unsigned char*, const unsigned char*, size_t,
+                                    unsigned char*) {
+}
+
+void SCryptoAccel::aes256CBCDecrypt(const unsigned char*, unsigned char*, const unsigned char*, size_t,
+                                    unsigned char*) {
+}
+
+void SCryptoAccel::sha1(const unsigned char*, size_t, unsigned char*) {
+}
+
+void SCryptoAccel::sha256(const unsigned char*, size_t, unsigned char*) {
+}
+
+#endif
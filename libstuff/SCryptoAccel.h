@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+
+// Hardware-accelerated implementations of the crypto primitives behind SAESEncrypt/SAESDecrypt and the SHash
+// helpers, using the AES-NI and SHA instruction set extensions where the CPU has them. Callers check the
+// `*Available()` flags (detected once, at first use) and fall back to the mbedtls software implementations when the
+// instructions aren't there, so the S* helpers behave identically everywhere — these just make the common x86_64
+// server case several times faster.
+class SCryptoAccel {
+  public:
+    // True if this CPU supports the AES-NI (respectively SHA) extensions. Always false on non-x86_64 builds.
+    static bool aesAvailable();
+    static bool shaAvailable();
+
+    // AES-256-CBC. `length` must be a multiple of the 16-byte block size. `iv` is advanced past the processed
+    // blocks, exactly like mbedtls_aes_crypt_cbc, so chained calls produce the same stream as one big call.
+    static void aes256CBCEncrypt(const unsigned char* key, unsigned char iv[16], const unsigned char* in,
+                                 size_t length, unsigned char* out);
+    static void aes256CBCDecrypt(const unsigned char* key, unsigned char iv[16], const unsigned char* in,
+                                 size_t length, unsigned char* out);
+
+    // One-shot hashes, bit-identical to mbedtls_sha1/mbedtls_sha256.
+    static void sha1(const unsigned char* data, size_t length, unsigned char result[20]);
+    static void sha256(const unsigned char* data, size_t length, unsigned char result[32]);
+};
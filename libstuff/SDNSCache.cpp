@@ -0,0 +1,159 @@
+#include "libstuff.h"
+
+#include <netdb.h>
+
+// Cache internals. The shared state is heap-allocated once and intentionally never freed, so the background
+// refresher thread can't race static destruction at process exit.
+namespace {
+    // Freshness windows (see the header for why these are fixed rather than TTL-driven).
+    const uint64_t POSITIVE_TTL = 60 * STIME_US_PER_S;
+    const uint64_t NEGATIVE_TTL = 10 * STIME_US_PER_S;
+
+    struct Entry {
+        uint32_t ip = 0;
+        uint64_t freshUntil = 0;
+        bool negative = false;
+        bool refreshQueued = false;
+    };
+
+    struct State {
+        mutex m;
+        map<string, Entry> cache;
+        list<string> refreshQueue;
+        condition_variable refreshSignal;
+        bool refresherRunning = false;
+    };
+
+    State& state() {
+        static State* s = new State;
+        return *s;
+    }
+
+    // The actual blocking getaddrinfo call (the same one S_socket used to make inline). Returns true and fills `ip`
+    // (network byte order) on success.
+    bool lookup(const string& domain, uint32_t& ip) {
+        uint64_t start = STimeNow();
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof hints);
+        hints.ai_family = AF_INET; // IPv4
+        hints.ai_socktype = SOCK_STREAM;
+        struct addrinfo* resolved = nullptr;
+        int result = getaddrinfo(domain.c_str(), nullptr, &hints, &resolved);
+        SINFO("DNS lookup took " << (STimeNow() - start) / 1000 << "ms for '" << domain << "'.");
+        if (result || !resolved) {
+            freeaddrinfo(resolved);
+            return false;
+        }
+        sockaddr_in* addr = (sockaddr_in*)resolved->ai_addr;
+        ip = addr->sin_addr.s_addr;
+        char plainTextIP[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &addr->sin_addr, plainTextIP, INET_ADDRSTRLEN);
+        SINFO("Resolved " << domain << " to ip: " << plainTextIP << ".");
+        freeaddrinfo(resolved);
+        return true;
+    }
+
+    // Stores a lookup outcome in the cache. Caller must hold the state mutex.
+    void store(State& s, const string& domain, bool success, uint32_t ip) {
+        Entry& entry = s.cache[domain];
+        uint64_t now = STimeNow();
+        if (success) {
+            entry.ip = ip;
+            entry.negative = false;
+            entry.freshUntil = now + POSITIVE_TTL;
+        } else if (entry.freshUntil && !entry.negative) {
+            // A refresh of a previously-good entry failed. Keep serving the old address (better than failing
+            // connects outright), but retry on the negative schedule.
+            entry.freshUntil = now + NEGATIVE_TTL;
+        } else {
+            entry.negative = true;
+            entry.freshUntil = now + NEGATIVE_TTL;
+        }
+        entry.refreshQueued = false;
+    }
+
+    // Body of the background refresher: pulls names off the queue and re-resolves them, forever. The lock is
+    // dropped around the lookup itself, so a slow resolver never blocks anyone but this thread.
+    void refresherMain() {
+        SInitialize("dnsrefresh");
+        State& s = state();
+        unique_lock<mutex> lock(s.m);
+        while (true) {
+            if (s.refreshQueue.empty()) {
+                s.refreshSignal.wait(lock);
+                continue;
+            }
+            string domain = move(s.refreshQueue.front());
+            s.refreshQueue.pop_front();
+            lock.unlock();
+            uint32_t ip = 0;
+            bool success = lookup(domain, ip);
+            lock.lock();
+            store(s, domain, success, ip);
+        }
+    }
+
+    // Queues a background re-resolution of `domain` unless one's already pending, starting the refresher thread
+    // lazily the first time anything needs it. Caller must hold the state mutex.
+    void scheduleRefresh(State& s, const string& domain, Entry& entry) {
+        if (entry.refreshQueued) {
+            return;
+        }
+        entry.refreshQueued = true;
+        s.refreshQueue.push_back(domain);
+        if (!s.refresherRunning) {
+            s.refresherRunning = true;
+            thread(refresherMain).detach();
+        }
+        s.refreshSignal.notify_one();
+    }
+}
+
+uint32_t SDNSCache::resolve(const string& domain) {
+    State& s = state();
+    uint64_t now = STimeNow();
+    {
+        lock_guard<mutex> lock(s.m);
+        auto it = s.cache.find(domain);
+        if (it != s.cache.end()) {
+            Entry& entry = it->second;
+            if (entry.negative) {
+                // Fresh negative entries fail fast; stale ones fall through to a synchronous retry below, since a
+                // connect attempt wants the freshest possible "no".
+                if (entry.freshUntil > now) {
+                    STHROW("can't resolve host (negative cached)");
+                }
+            } else {
+                // Positive entries are served stale or not; a stale one also kicks a background refresh, so the
+                // cache converges on the resolver's current answer without anyone blocking on it.
+                if (entry.freshUntil <= now) {
+                    scheduleRefresh(s, domain, entry);
+                }
+                return entry.ip;
+            }
+        }
+    }
+
+    // Nothing cached (or a stale negative): resolve synchronously, like S_socket always did.
+    uint32_t ip = 0;
+    bool success = lookup(domain, ip);
+    lock_guard<mutex> lock(s.m);
+    store(s, domain, success, ip);
+    if (!success) {
+        STHROW("can't resolve host");
+    }
+    return ip;
+}
+
+size_t SDNSCache::size() {
+    State& s = state();
+    lock_guard<mutex> lock(s.m);
+    return s.cache.size();
+}
+
+void SDNSCache::clear() {
+    State& s = state();
+    lock_guard<mutex> lock(s.m);
+    s.cache.clear();
+    s.refreshQueue.clear();
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string>
+using namespace std;
+
+// A process-wide DNS cache so connection setup doesn't block on the resolver. S_socket historically called
+// getaddrinfo synchronously on every connect, which stalls the calling thread for however long the resolver takes —
+// peer reconnects and every new HTTPS transaction paid it, and a slow resolver once froze the sync loop for seconds.
+// With the cache, only the *first* resolution of a name blocks; after that, connects take the cached address, and
+// expired entries are served stale while a background thread refreshes them, so a steady-state caller never waits on
+// DNS again. In a fixed cluster, peer host resolution is therefore a one-time cost per process.
+//
+// getaddrinfo doesn't expose record TTLs, so freshness windows are fixed: long enough that repeat connects are free,
+// short enough that a DNS failover is picked up within a minute. Failed resolutions are negative-cached briefly so an
+// unresolvable host doesn't hammer the resolver on every retry.
+class SDNSCache {
+  public:
+    // Resolves `domain` to an IPv4 address in network byte order. Serves fresh entries from the cache; a miss
+    // resolves synchronously and caches the result; an expired entry is returned stale immediately while the
+    // background refresher re-resolves it. Throws SException when the name can't be resolved (and negative-caches
+    // the failure).
+    static uint32_t resolve(const string& domain);
+
+    // Number of entries currently cached, for tests and diagnostics.
+    static size_t size();
+
+    // Empties the cache and forgets negative entries, for tests.
+    static void clear();
+};
@@ -13,6 +13,12 @@ SData::SData(const string& fromString) {
     }
 }
 
+SData::SData(string&& fromString) {
+    if(!SParseHTTP(fromString, methodLine, nameValueMap, content)){
+        methodLine = move(fromString);
+    }
+}
+
 string& SData::operator[](const string& name) {
     return nameValueMap[name];
 }
@@ -40,11 +46,19 @@ void SData::merge(const STable& table) {
     nameValueMap.insert(table.begin(), table.end());
 }
 
+void SData::merge(STable&& table) {
+    nameValueMap.insert(make_move_iterator(table.begin()), make_move_iterator(table.end()));
+}
+
 void SData::merge(const SData& rhs) {
     // **FIXME: What do we do with the content?  Where do we use this?
     merge(rhs.nameValueMap);
 }
 
+void SData::merge(SData&& rhs) {
+    merge(move(rhs.nameValueMap));
+}
+
 bool SData::empty() const {
     return (methodLine.empty() && nameValueMap.empty() && content.empty());
 }
@@ -61,9 +75,18 @@ int64_t SData::calc64(const string& name) const {
     STable::const_iterator it = nameValueMap.find(name);
     if (it == nameValueMap.end()) {
         return 0;
-    } else {
-        return strtoll(it->second.c_str(), 0, 10);
     }
+    // Values are written in fixed decimal format (to_string and friends), so parse digits directly rather than
+    // paying for strtoll's whitespace and base handling on every lookup.
+    const string& value = it->second;
+    const char* ptr = value.c_str();
+    const char* end = ptr + value.size();
+    bool negative = (ptr < end && *ptr == '-');
+    if (negative || (ptr < end && *ptr == '+')) {
+        ptr++;
+    }
+    uint64_t magnitude = SFastParseU64(ptr, end);
+    return negative ? -(int64_t)magnitude : (int64_t)magnitude;
 }
 
 uint64_t SData::calcU64(const string& name) const {
@@ -71,7 +94,7 @@ uint64_t SData::calcU64(const string& name) const {
     if (it == nameValueMap.end()) {
         return 0;
     } else {
-        return strtoull(it->second.c_str(), 0, 10);
+        return SFastParseU64(it->second);
     }
 }
 
@@ -92,14 +115,239 @@ string SData::serialize() const {
     return SComposeHTTP(methodLine, nameValueMap, content);
 }
 
+// The magic byte that starts every binary frame. Text messages start with an ASCII method line, so this can never be
+// confused with one.
+static const unsigned char SDATA_BINARY_MAGIC = 0xBD;
+
+// Little-endian integer packing/unpacking helpers for the binary format.
+static void SAppendLE(string& out, uint32_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out += (char)((value >> (8 * i)) & 0xFF);
+    }
+}
+
+static uint32_t SReadLE(const char* buffer, size_t bytes) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        value |= ((uint32_t)(unsigned char)buffer[i]) << (8 * i);
+    }
+    return value;
+}
+
+string SData::serializeBinary() const {
+    // Reserve roughly the right amount up front so we don't reallocate while appending.
+    string out;
+    size_t estimate = 5 + 2 + methodLine.size() + 2 + 4 + content.size();
+    for (auto& pair : nameValueMap) {
+        estimate += 1 + pair.first.size() + 4 + pair.second.size();
+    }
+    out.reserve(estimate);
+
+    // Method line.
+    out += (char)SDATA_BINARY_MAGIC;
+    SAppendLE(out, 0, 4); // Frame length placeholder, filled in below.
+    SAppendLE(out, (uint32_t)methodLine.size(), 2);
+    out += methodLine;
+
+    // Headers. Names are limited to 255 bytes, which nothing approaches in practice.
+    SAppendLE(out, (uint32_t)nameValueMap.size(), 2);
+    for (auto& pair : nameValueMap) {
+        SASSERT(pair.first.size() < 256);
+        SAppendLE(out, (uint32_t)pair.first.size(), 1);
+        out += pair.first;
+        SAppendLE(out, (uint32_t)pair.second.size(), 4);
+        out += pair.second;
+    }
+
+    // Content.
+    SAppendLE(out, (uint32_t)content.size(), 4);
+    out += content;
+
+    // Now we know the frame length, fill in the placeholder.
+    uint32_t frameLength = (uint32_t)(out.size() - 5);
+    for (size_t i = 0; i < 4; i++) {
+        out[1 + i] = (char)((frameLength >> (8 * i)) & 0xFF);
+    }
+    return out;
+}
+
+int SData::deserializeBinary(const char* buffer, size_t length) {
+    // Do we at least have the prefix?
+    if (length < 5 || (unsigned char)buffer[0] != SDATA_BINARY_MAGIC) {
+        return 0;
+    }
+    uint32_t frameLength = SReadLE(buffer + 1, 4);
+    if (length < 5 + (size_t)frameLength) {
+        // Not all here yet.
+        return 0;
+    }
+
+    // We have a complete frame, parse it. Any structural problem below indicates a corrupt frame; we treat that the
+    // same way SParseHTTP treats garbage, by consuming nothing (callers will time out and reconnect).
+    const char* p = buffer + 5;
+    const char* end = p + frameLength;
+    methodLine.clear();
+    nameValueMap.clear();
+    content.clear();
+
+    if (end - p < 2) {
+        return 0;
+    }
+    uint32_t methodLength = SReadLE(p, 2);
+    p += 2;
+    if ((size_t)(end - p) < methodLength + 2) {
+        return 0;
+    }
+    methodLine.assign(p, methodLength);
+    p += methodLength;
+
+    uint32_t headerCount = SReadLE(p, 2);
+    p += 2;
+    for (uint32_t i = 0; i < headerCount; i++) {
+        if (end - p < 1) {
+            return 0;
+        }
+        uint32_t nameLength = SReadLE(p, 1);
+        p += 1;
+        if ((size_t)(end - p) < nameLength + 4) {
+            return 0;
+        }
+        string name(p, nameLength);
+        p += nameLength;
+        uint32_t valueLength = SReadLE(p, 4);
+        p += 4;
+        if ((size_t)(end - p) < valueLength) {
+            return 0;
+        }
+        nameValueMap[name] = string(p, valueLength);
+        p += valueLength;
+    }
+
+    if (end - p < 4) {
+        return 0;
+    }
+    uint32_t contentLength = SReadLE(p, 4);
+    p += 4;
+    if ((size_t)(end - p) < contentLength) {
+        return 0;
+    }
+    content.assign(p, contentLength);
+    return (int)(5 + frameLength);
+}
+
 int SData::deserialize(const string& fromString) {
-    return (SParseHTTP(fromString, methodLine, nameValueMap, content));
+    return deserialize(fromString.c_str(), fromString.size());
 }
 
 int SData::deserialize(const char* buffer, size_t length) {
+    if (length && (unsigned char)buffer[0] == SDATA_BINARY_MAGIC) {
+        return deserializeBinary(buffer, length);
+    }
     return (SParseHTTP(buffer, length, methodLine, nameValueMap, content));
 }
 
+int SData::deserialize(const char* buffer, size_t length, SHTTPParseState& state) {
+    if (length && (unsigned char)buffer[0] == SDATA_BINARY_MAGIC) {
+        return deserializeBinary(buffer, length);
+    }
+    return (SParseHTTP(buffer, length, methodLine, nameValueMap, content, state));
+}
+
+int SDataView::deserialize(const char* buffer, size_t length) {
+    _base = nullptr;
+    _size = 0;
+    _pinned.clear();
+
+    // Binary frames are cheap to parse but not to view (SData's parser copies as it goes), so let the caller fall
+    // back for those too.
+    if (length && (unsigned char)buffer[0] == SDATA_BINARY_MAGIC) {
+        return 0;
+    }
+    int consumed = SParseHTTPView(buffer, length, methodLine, headers, content);
+    if (consumed) {
+        _base = buffer;
+        _size = consumed;
+    }
+    return consumed;
+}
+
+string_view SDataView::operator[](const string& name) const {
+    // Scan backwards so a repeated header resolves to its last value, like the copying parser's overwrite behavior.
+    for (auto it = headers.rbegin(); it != headers.rend(); ++it) {
+        if (it->first.size() == name.size() && !strncasecmp(it->first.data(), name.c_str(), name.size())) {
+            return it->second;
+        }
+    }
+    return string_view();
+}
+
+bool SDataView::isSet(const string& name) const {
+    for (auto& header : headers) {
+        if (header.first.size() == name.size() && !strncasecmp(header.first.data(), name.c_str(), name.size())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int64_t SDataView::calc64(const string& name) const {
+    // Views aren't null-terminated, so parse by hand rather than with strtoll.
+    string_view value = (*this)[name];
+    size_t i = 0;
+    bool negative = false;
+    if (i < value.size() && (value[i] == '-' || value[i] == '+')) {
+        negative = (value[i] == '-');
+        i++;
+    }
+    int64_t result = 0;
+    for (; i < value.size() && isdigit(value[i]); i++) {
+        result = result * 10 + (value[i] - '0');
+    }
+    return negative ? -result : result;
+}
+
+bool SDataView::test(const string& name) const {
+    string_view value = (*this)[name];
+    return ((value.size() == 4 && !strncasecmp(value.data(), "true", 4)) || calc64(name) != 0);
+}
+
+bool SDataView::empty() const {
+    return (methodLine.empty() && headers.empty() && content.empty());
+}
+
+void SDataView::pin() {
+    if (!_base || !_pinned.empty()) {
+        // Never parsed, or already pinned.
+        return;
+    }
+    _pinned.assign(_base, _size);
+
+    // Rebase every view onto the pinned copy.
+    auto rebase = [&](string_view& view) {
+        if (view.data()) {
+            view = string_view(_pinned.data() + (view.data() - _base), view.size());
+        }
+    };
+    rebase(methodLine);
+    rebase(content);
+    for (auto& header : headers) {
+        rebase(header.first);
+        rebase(header.second);
+    }
+    _base = _pinned.data();
+}
+
+SData SDataView::toSData() const {
+    SData data;
+    data.methodLine = string(methodLine);
+    for (auto& header : headers) {
+        // Assignment (not insertion) so a repeated header keeps its last value, like the copying parser.
+        data.nameValueMap[string(header.first)] = string(header.second);
+    }
+    data.content = string(content);
+    return data;
+}
+
 SData SData::create(const string& fromString) {
     SData data;
     int header = data.deserialize(fromString);
@@ -8,6 +8,10 @@ struct SData {
     // Public attributes
     string methodLine;
     STable nameValueMap;
+
+    // The content body. Note that most command bodies are empty or tiny, and `string` guarantees no heap allocation
+    // for an empty body (and, via the small-string optimization, for bodies up to its inline capacity), so the
+    // common case costs nothing; commands also move their request through construction rather than copying it.
     string content;
 
     // Constructors
@@ -17,6 +21,10 @@ struct SData {
     // an entire HTTPs like message, the string is used as the methodLine.
     SData(const string& fromString);
 
+    // Same, but takes ownership of the string: if it turns out to just be a
+    // methodLine, it's moved rather than copied.
+    SData(string&& fromString);
+
     // Allow forwarding emplacements directly so SData can act like `std::map`.
     template <typename... Ts>
     pair<decltype(nameValueMap)::iterator, bool> emplace(Ts&&... args) {
@@ -41,9 +49,9 @@ struct SData {
         nameValueMap[key] = to_string(item);
     }
     template <typename T>
-    typename enable_if<!is_arithmetic<T>::value, void>::type set(const string& key, const T item)
+    typename enable_if<!is_arithmetic<typename decay<T>::type>::value, void>::type set(const string& key, T&& item)
     {
-        nameValueMap[key] = item;
+        nameValueMap[key] = forward<T>(item);
     }
 
     // Mutators
@@ -55,9 +63,11 @@ struct SData {
 
     // Combine the name/value pairs from two datas
     void merge(const STable& table);
+    void merge(STable&& table);
 
     // Combine two SData into one
     void merge(const SData& rhs);
+    void merge(SData&& rhs);
 
     // Accessors
     // Returns whether or not this data is empty
@@ -81,6 +91,10 @@ struct SData {
     // Gets the verb (eg "GET") from the method line
     string getVerb() const;
 
+    // Returns a non-owning view of the content, for callers that only inspect it and shouldn't pay for a copy. The
+    // view is only valid while the content isn't modified, like any string_view.
+    string_view contentView() const { return string_view(content); }
+
     // Serialization
     // Serializes this to an ostringstream
     void serialize(ostringstream& out) const;
@@ -88,15 +102,36 @@ struct SData {
     // Serializes this to a string
     string serialize() const;
 
-    // Deserializes from a string
+    // Serializes this to a length-prefixed binary frame instead of HTTP-style text. The frame starts with a magic
+    // byte that can't begin a text message, so `deserialize` can tell the two formats apart and parse either. This is
+    // much cheaper to produce and parse than the text format (no line scanning, no case-insensitive header matching on
+    // parse, no decimal rendering of lengths), and is used for peer-to-peer cluster traffic once both sides have
+    // advertised support for it. The wire layout is:
+    //   [0xBD][uint32 frameLength][uint16 methodLine length][methodLine]
+    //   [uint16 headerCount]([uint8 name length][name][uint32 value length][value])*
+    //   [uint32 content length][content]
+    // All integers are little-endian. `frameLength` counts everything after the 5-byte prefix.
+    string serializeBinary() const;
+
+    // Deserializes from a string. Auto-detects binary frames by their leading magic byte.
     int deserialize(const string& rhs);
 
-    // Deserializes from a buffer
+    // Deserializes from a buffer. Auto-detects binary frames by their leading magic byte.
     int deserialize(const char* buffer, size_t length);
 
-    // Deserializes from an SFastBuffer.
+    // Deserializes a binary frame produced by `serializeBinary`. Returns the number of bytes consumed, or 0 if the
+    // buffer doesn't yet contain a complete frame.
+    int deserializeBinary(const char* buffer, size_t length);
+
+    // Deserializes from a buffer, resuming an earlier incomplete parse from `state` (see SParseHTTP). Auto-detects
+    // binary frames by their leading magic byte; those carry their total length up front, so they never need state.
+    int deserialize(const char* buffer, size_t length, SHTTPParseState& state);
+
+    // Deserializes from an SFastBuffer. Parses the first contiguous segment, which for receive buffers (which are
+    // never chained) is the entire buffer. Uses the buffer's embedded parse state, so repeated attempts against a
+    // message that's still trickling in don't rescan it from the start.
     int deserialize(const SFastBuffer& buf) {
-        return deserialize(buf.c_str(), buf.size());
+        return deserialize(buf.c_str(), buf.firstSegmentSize(), buf.httpParseState);
     }
 
     // Initializes a new SData from a string. If there is no content provided,
@@ -105,3 +140,63 @@ struct SData {
     static SData create(const string& rhs);
     static const string placeholder;
 };
+
+// --------------------------------------------------------------------------
+// A non-owning view of a parsed message. Where SData copies the method line, every header, and the content out of
+// the socket buffer into fresh strings before anything can look at them, this just records views into the buffer it
+// was parsed from, so inspecting a message's headers allocates nothing. The views are only valid until that buffer
+// is modified or consumed; call `pin()` to copy the message bytes into the view itself (one allocation total) if it
+// needs to live longer. `deserialize` only handles messages the view parser supports (see SParseHTTPView) and
+// returns 0 otherwise -- callers should fall back to SData's parser when it does.
+// --------------------------------------------------------------------------
+struct SDataView {
+    // Once pinned, the views point into our own storage, which copying or moving would invalidate. This is a
+    // short-lived parse object, so rather than rebase on every copy, just forbid them.
+    SDataView() = default;
+    SDataView(const SDataView&) = delete;
+    SDataView& operator=(const SDataView&) = delete;
+
+    // Public attributes. Headers are kept in parse order; lookups are case-insensitive like STable's.
+    string_view methodLine;
+    vector<pair<string_view, string_view>> headers;
+    string_view content;
+
+    // Deserializes from a buffer without copying. Returns the number of bytes consumed, or 0 if the buffer doesn't
+    // yet contain a complete message, or contains one the view parser can't handle.
+    int deserialize(const char* buffer, size_t length);
+
+    // Deserializes from an SFastBuffer. Like SData, parses the first contiguous segment, which for receive buffers
+    // is the entire buffer.
+    int deserialize(const SFastBuffer& buf) {
+        return deserialize(buf.c_str(), buf.firstSegmentSize());
+    }
+
+    // Case-insensitive header lookup. Returns an empty view if the header isn't set. If a header is repeated, the
+    // last value wins, matching the copying parser.
+    string_view operator[](const string& name) const;
+
+    // Returns whether or not a particular header has been set
+    bool isSet(const string& name) const;
+
+    // Return a header as a 64-bit value
+    int64_t calc64(const string& name) const;
+
+    // Returns if the header evaluates to true
+    bool test(const string& name) const;
+
+    // Returns whether or not this view is empty
+    bool empty() const;
+
+    // Copies the underlying message bytes into this object and rebases all the views onto the copy, so they remain
+    // valid after the buffer they were parsed from changes.
+    void pin();
+
+    // Materializes an owning SData from this view.
+    SData toSData() const;
+
+  private:
+    // The extent of the message within the buffer passed to `deserialize`, and the pinned copy of it, if any.
+    const char* _base = nullptr;
+    size_t _size = 0;
+    string _pinned;
+};
@@ -1,9 +1,14 @@
 #include <libstuff/libstuff.h>
 
-SFastBuffer::SFastBuffer() : front(0) {
+SFastBuffer::SFastBuffer() : front(0), chainSize(0), tailCommitted(0) {
 }
 
-SFastBuffer::SFastBuffer(const string& str) : front(0), data(str) {
+SFastBuffer::SFastBuffer(const string& str) : front(0), data(str), chainSize(0), tailCommitted(0) {
+}
+
+SFastBuffer::~SFastBuffer() {
+    // Hand any pooled backings back for the next socket to reuse.
+    clear();
 }
 
 bool SFastBuffer::empty() const {
@@ -11,28 +16,139 @@ bool SFastBuffer::empty() const {
 }
 
 size_t SFastBuffer::size() const {
-    return data.size() - front;
+    return (data.size() - front) + chainSize;
 }
 
 const char* SFastBuffer::c_str() const {
-    return data.data() + front;
+    if (data.size() - front || chain.empty()) {
+        return data.data() + front;
+    }
+    return chain.front().segData();
+}
+
+size_t SFastBuffer::firstSegmentSize() const {
+    if (data.size() - front || chain.empty()) {
+        return data.size() - front;
+    }
+    return chain.front().segSize();
+}
+
+string SFastBuffer::toString() const {
+    string out;
+    out.reserve(size());
+    out.append(data.data() + front, data.size() - front);
+    for (const Segment& segment : chain) {
+        out.append(segment.segData(), segment.segSize());
+    }
+    return out;
+}
+
+int SFastBuffer::gather(struct iovec* iov, int maxCount) const {
+    int count = 0;
+    if (count < maxCount && data.size() - front) {
+        iov[count].iov_base = (void*)(data.data() + front);
+        iov[count].iov_len = data.size() - front;
+        count++;
+    }
+    for (const Segment& segment : chain) {
+        if (count >= maxCount) {
+            break;
+        }
+        iov[count].iov_base = (void*)segment.segData();
+        iov[count].iov_len = segment.segSize();
+        count++;
+    }
+    return count;
 }
 
 void SFastBuffer::clear() {
+    httpParseState.clear();
     front = 0;
-    data.clear();
+    _releaseBacking();
+    for (Segment& segment : chain) {
+        // Shared segments just drop their reference; only owned backings can go back to the pool.
+        if (!segment.shared) {
+            SBufferPool::release(move(segment.owned));
+        }
+    }
+    chain.clear();
+    chainSize = 0;
+}
+
+void SFastBuffer::_releaseBacking() {
+    // Small backings aren't pooled and keeping them avoids re-reserving for the next small message; big ones go back
+    // to the pool so an idle socket doesn't pin its peak allocation.
+    if (data.capacity() >= SBufferPool::MIN_POOLED_CAPACITY) {
+        SBufferPool::release(move(data));
+        data = string();
+    } else {
+        data.clear();
+    }
 }
 
 void SFastBuffer::consumeFront(size_t bytes) {
-    front += bytes;
+    // The front is moving, so any parse progress against the old front is meaningless.
+    httpParseState.clear();
+    while (bytes) {
+        size_t inData = data.size() - front;
+        if (inData > bytes) {
+            front += bytes;
+            return;
+        }
+
+        // We've consumed all of `data`. Promote the next segment (if any) into its place, which is just a pointer
+        // move, and keep consuming.
+        bytes -= inData;
+        front = 0;
+        data.clear();
+        if (chain.empty()) {
+            // Consumed everything (any remainder is an overconsume, which the old implementation also ignored).
+            // We're drained, so give the backing back for another socket to use.
+            _releaseBacking();
+            return;
+        }
+
+        // Promotion replaces `data`'s storage wholesale, so return the old backing to the pool rather than letting
+        // the move-assignment silently free it. A shared segment can't be promoted (we don't own its bytes), so it's
+        // consumed in place via its own front offset instead.
+        _releaseBacking();
+        Segment& segment = chain.front();
+        if (segment.shared) {
+            size_t remaining = segment.segSize();
+            if (remaining > bytes) {
+                segment.front += bytes;
+                chainSize -= bytes;
+                return;
+            }
+            bytes -= remaining;
+            chainSize -= remaining;
+            chain.pop_front();
+        } else {
+            data = move(segment.owned);
+            chain.pop_front();
+            chainSize -= data.size();
+        }
+    }
 
     // If we're all caught up, reset.
-    if (front == data.size()) {
+    if (front == data.size() && chain.empty()) {
         clear();
     }
 }
 
 void SFastBuffer::append(const char* buffer, size_t bytes) {
+    // If there are chained segments, this data comes after them, so it has to go on the end of the chain (in a new
+    // segment if the last one is shared, since we can't write into bytes other buffers reference).
+    if (!chain.empty()) {
+        if (chain.back().shared) {
+            chain.push_back(Segment(string(buffer, bytes)));
+        } else {
+            chain.back().owned.append(buffer, bytes);
+        }
+        chainSize += bytes;
+        return;
+    }
+
     // When will we condense everything to the front of the buffer?
     // When:
     // 1. We're not already at the front of the buffer (this implies there's data in the buffer).
@@ -49,19 +165,107 @@ void SFastBuffer::append(const char* buffer, size_t bytes) {
         }
     }
 
+    // If this append would still force a reallocation into pool territory, lease the next class of backing from the
+    // pool (and return the old one) instead of letting the string allocator grow this one, so the big buffer is
+    // shared across sockets once we drain.
+    size_t needed = data.size() + bytes;
+    if (needed > data.capacity() && needed >= SBufferPool::MIN_POOLED_CAPACITY) {
+        string upgraded = SBufferPool::acquire(needed);
+        upgraded.append(data.data() + front, data.size() - front);
+        front = 0;
+        SBufferPool::release(move(data));
+        data = move(upgraded);
+    }
+
     // After the resize, we may or may not need to actually reallocate. We can append now and let the string
     // implementation decide if it needs more room.
     data.append(buffer, bytes);
 }
 
+char* SFastBuffer::writableTail(size_t bytes) {
+    // Tail writes land after everything already buffered, so with chained segments the tail is the back segment
+    // (a fresh one if the current back is shared, whose bytes we can't write into).
+    string* target;
+    if (!chain.empty()) {
+        if (chain.back().shared) {
+            chain.push_back(Segment(string()));
+        }
+        target = &chain.back().owned;
+    } else {
+        target = &data;
+
+        // Make room exactly the way append() would for a write of this size: condense to the front of the buffer
+        // if that avoids a reallocation, and lease a pooled backing if we're growing into pool territory.
+        if (front && (data.capacity() - data.size() < bytes)) {
+            memmove(&data[0], data.data() + front, size());
+            data.resize(size());
+            front = 0;
+            if (data.capacity() > (data.size() + bytes) * 4) {
+                data.shrink_to_fit();
+            }
+        }
+        size_t needed = data.size() + bytes;
+        if (needed > data.capacity() && needed >= SBufferPool::MIN_POOLED_CAPACITY) {
+            string upgraded = SBufferPool::acquire(needed);
+            upgraded.append(data.data() + front, data.size() - front);
+            front = 0;
+            SBufferPool::release(move(data));
+            data = move(upgraded);
+        }
+    }
+
+    // Extend over the tail space; commit() trims back to what actually got written.
+    tailCommitted = target->size();
+    target->resize(tailCommitted + bytes);
+    return &(*target)[tailCommitted];
+}
+
+void SFastBuffer::commit(size_t bytes) {
+    string& target = chain.empty() ? data : chain.back().owned;
+    target.resize(tailCommitted + bytes);
+    if (!chain.empty()) {
+        // chainSize wasn't touched by writableTail's resize (it's a cached sum), so just add what stuck.
+        chainSize += bytes;
+    }
+}
+
+void SFastBuffer::append(string&& buffer) {
+    // Large payloads become their own segment - no copy, and consuming them later is just dropping the segment.
+    if (buffer.size() >= SEGMENT_MIN_SIZE) {
+        chainSize += buffer.size();
+        chain.push_back(Segment(move(buffer)));
+        return;
+    }
+    append(buffer.data(), buffer.size());
+}
+
+void SFastBuffer::append(const shared_ptr<const string>& buffer) {
+    // Reference the shared bytes rather than copying them, unless the payload's small enough that the segment
+    // bookkeeping (and the extra iovec per send) costs more than the copy would.
+    if (buffer->size() >= SHARED_SEGMENT_MIN_SIZE) {
+        chainSize += buffer->size();
+        chain.push_back(Segment(buffer));
+        return;
+    }
+    append(buffer->data(), buffer->size());
+}
+
 SFastBuffer& SFastBuffer::operator+=(const string& rhs) {
     append(rhs.c_str(), rhs.size());
     return *this;
 }
 
+SFastBuffer& SFastBuffer::operator+=(string&& rhs) {
+    append(move(rhs));
+    return *this;
+}
+
 SFastBuffer& SFastBuffer::operator=(const string& rhs) {
+    httpParseState.clear();
     front = 0;
     data = rhs;
+    chain.clear();
+    chainSize = 0;
     return *this;
 }
 
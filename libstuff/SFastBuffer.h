@@ -1,19 +1,121 @@
 #pragma once
+#include <sys/uio.h>
+
+// Resumable state for parsing an HTTP-style message that's arriving incrementally (see SParseHTTP). Remembers how
+// far into the header block parsing has already gotten (along with everything parsed up to there) and, once the
+// headers announce a Content-Length, the total size the message needs before a parse could possibly succeed, so
+// repeated parse attempts against a slow-trickling message don't rescan the same bytes from the start on every poll
+// cycle. Lives on the receive buffer it describes, which invalidates it whenever its front moves.
+struct SHTTPParseState {
+    size_t parsedOffset = 0;
+    string methodLine;
+    STable nameValueMap;
+    string lastHeaderName;
+    size_t neededBytes = 0;
+    void clear() {
+        parsedOffset = 0;
+        methodLine.clear();
+        nameValueMap.clear();
+        lastHeaderName.clear();
+        neededBytes = 0;
+    }
+};
+
+// A buffer for socket IO. Data is appended at the back and consumed from the front. Small appends land in one
+// contiguous string (with a `front` offset so consuming doesn't memmove), but large payloads appended from an rvalue
+// (i.e., a >1MB response body) are kept as their own segments in a chain, so they're never copied: `gather` exposes
+// the segments as iovecs for scatter-gather sends (see S_sendconsume), and consuming drops whole segments instead of
+// shuffling a giant string.
+//
+// Backing storage is leased from SBufferPool: growth past a pool class acquires a pooled backing, and draining the
+// buffer (or destroying it, i.e., on socket close) returns the backing, so per-socket memory doesn't stay pinned at
+// the peak message size.
 class SFastBuffer {
   public:
     SFastBuffer();
     SFastBuffer(const string& str);
+    ~SFastBuffer();
     bool empty() const;
     size_t size() const;
+
+    // Returns a pointer to the first *contiguous* region of the buffer, whose length is `firstSegmentSize()`. For
+    // buffers that are only ever appended to with the copying `append` (i.e., receive buffers), this is the entire
+    // buffer contents, as it always has been. When chained segments exist, it's only the first segment.
     const char* c_str() const;
+    size_t firstSegmentSize() const;
+
+    // Copies the entire contents (all segments) into one string.
+    string toString() const;
+
+    // Fills up to `maxCount` iovecs with the buffer's segments, in order, and returns the number filled.
+    int gather(struct iovec* iov, int maxCount) const;
+
+    // Upper bound on the number of iovecs `gather` can return, for sizing its array.
+    int segmentCount() const { return (int)chain.size() + 1; }
+
     void clear();
     void consumeFront(size_t bytes);
     void append(const char* buffer, size_t bytes);
+
+    // Zero-copy append, for filling the buffer directly from a syscall: writableTail returns a writable pointer to
+    // `bytes` of tail space (growing the buffer with the same condense/pool-upgrade rules as `append`), the caller
+    // fills some prefix of it (e.g. recv()ing straight off a socket, skipping the bounce through a temp buffer and
+    // the memcpy after it), and commit records how many bytes were actually written. Every writableTail call must
+    // be paired with a commit (commit(0) if nothing was written) before the buffer is read or appended to again;
+    // between the two, size() and friends overcount by the uncommitted tail.
+    char* writableTail(size_t bytes);
+    void commit(size_t bytes);
+
+    // Parse-resume state for the message currently at the front of this buffer (see SParseHTTP). Appending more
+    // bytes leaves it valid (the already-scanned prefix hasn't changed); consuming or replacing the contents resets
+    // it. Mutable so a parse attempt against a const buffer reference can still record its progress.
+    mutable SHTTPParseState httpParseState;
+
+    // Appending from an rvalue moves large payloads into the buffer as their own segment, with no copy.
+    void append(string&& buffer);
+
+    // Appending a shared payload chains a refcounted reference to it rather than copying: a message broadcast to six
+    // peers is serialized (and held in memory) once, with each socket's buffer pointing at the same bytes. Tiny
+    // payloads are copied anyway, since a segment costs more than the copy.
+    void append(const shared_ptr<const string>& buffer);
+
     SFastBuffer& operator+=(const string& rhs);
+    SFastBuffer& operator+=(string&& rhs);
     SFastBuffer& operator=(const string& rhs);
 
   private:
+    // Rvalue payloads at least this large get chained as segments rather than copied into `data`.
+    static const size_t SEGMENT_MIN_SIZE = 16 * 1024;
+
+    // Shared payloads at least this large get chained (smaller ones are copied). Much lower than SEGMENT_MIN_SIZE
+    // because a shared append otherwise pays a copy per referencing buffer, not one copy total.
+    static const size_t SHARED_SEGMENT_MIN_SIZE = 512;
+
+    // One link in the chain: either a string this buffer owns outright, or a refcounted reference to bytes shared
+    // with other buffers. `front` is how much of the segment has already been consumed; only ever non-zero on the
+    // first link (and only for shared segments, since owned ones get promoted into `data` instead).
+    struct Segment {
+        Segment(string&& owned_) : owned(move(owned_)) {}
+        Segment(const shared_ptr<const string>& shared_) : shared(shared_) {}
+        const char* segData() const { return (shared ? shared->data() : owned.data()) + front; }
+        size_t segSize() const { return (shared ? shared->size() : owned.size()) - front; }
+        string owned;
+        shared_ptr<const string> shared;
+        size_t front = 0;
+    };
+
+    // Returns `data`'s backing to SBufferPool (if it's pool-sized) and leaves `data` empty.
+    void _releaseBacking();
+
     size_t front;
     string data;
+
+    // Segments appended after `data`, oldest first, and the sum of their (unconsumed) sizes.
+    list<Segment> chain;
+    size_t chainSize;
+
+    // Size of the tail target (`data`, or the back segment when chained) as of the last writableTail call, so
+    // commit knows where the written bytes start.
+    size_t tailCommitted;
 };
 ostream& operator<<(ostream& os, const SFastBuffer& buf);
@@ -41,6 +41,14 @@ SStandaloneHTTPSManager::~SStandaloneHTTPSManager() {
     while (!_completedTransactionList.empty()) {
         closeTransaction(_completedTransactionList.front());
     }
+
+    // Close any connections we were keeping warm.
+    for (auto& hostSockets : _idleSocketPool) {
+        for (PooledSocket& pooled : hostSockets.second) {
+            STCPManager::closeSocket(pooled.s);
+        }
+    }
+    _idleSocketPool.clear();
 }
 
 void SStandaloneHTTPSManager::closeTransaction(Transaction* transaction) {
@@ -52,13 +60,52 @@ void SStandaloneHTTPSManager::closeTransaction(Transaction* transaction) {
     // Clean up the socket and done
     _activeTransactionList.remove(transaction);
     _completedTransactionList.remove(transaction);
+    if (transaction->deadline) {
+        // No-op if postPoll already popped or canceled it.
+        _transactionDeadlines.cancel(transaction->deadline, transaction);
+    }
     if (transaction->s) {
-        closeSocket(transaction->s);
+        // If the transaction completed cleanly - we parsed a whole response, the connection's still up with nothing
+        // left over in either buffer, and the server didn't ask us to close - keep the warm connection for the next
+        // request to this host instead of tearing down and re-handshaking.
+        bool reusable = !transaction->host.empty() && !transaction->fullResponse.methodLine.empty() &&
+                        transaction->s->state.load() == Socket::CONNECTED && transaction->s->recvBuffer.empty() &&
+                        transaction->s->sendBufferEmpty() &&
+                        !SIEquals(transaction->fullResponse["Connection"], "close");
+        if (reusable) {
+            _idleSocketPool[transaction->host].push_back({transaction->s, STimeNow()});
+        } else {
+            closeSocket(transaction->s);
+        }
     }
     transaction->s = nullptr;
     delete transaction;
 }
 
+SStandaloneHTTPSManager::Socket* SStandaloneHTTPSManager::_getPooledSocket(const string& host) {
+    SAUTOLOCK(_listMutex);
+    auto poolIt = _idleSocketPool.find(host);
+    if (poolIt == _idleSocketPool.end()) {
+        return nullptr;
+    }
+
+    // Oldest first, discarding any the server closed while they sat idle.
+    list<PooledSocket>& sockets = poolIt->second;
+    while (!sockets.empty()) {
+        PooledSocket pooled = sockets.front();
+        sockets.pop_front();
+        if (pooled.s->state.load() == Socket::CONNECTED && pooled.s->recvBuffer.empty()) {
+            if (sockets.empty()) {
+                _idleSocketPool.erase(poolIt);
+            }
+            return pooled.s;
+        }
+        STCPManager::closeSocket(pooled.s);
+    }
+    _idleSocketPool.erase(poolIt);
+    return nullptr;
+}
+
 int SStandaloneHTTPSManager::getHTTPResponseCode(const string& methodLine) {
     // This code looks for the first space in the methodLine, and then for the first non-space
     // after that, and *then* parses the response code. If we fail to find such a code, or can't parse it as an
@@ -108,27 +155,62 @@ void SStandaloneHTTPSManager::postPoll(fd_map& fdm, uint64_t& nextActivity, list
     SAUTOLOCK(_listMutex);
 
     // Let the base class do its thing
-    STCPManager::postPoll(fdm);
+    STCPManager::postPoll(fdm, nextActivity);
 
-    // Update each of the active requests
+    // Update each of the active requests. A transaction with nothing new on its socket is skipped after a couple of
+    // loads; its timeout lives on the deadline wheel, so a slow upstream with thousands of requests outstanding no
+    // longer makes every cycle pay a parse attempt and clock read per transaction.
     uint64_t timeout = timeoutMS * 1000;
+    uint64_t now = STimeNow();
     list<Transaction*>::iterator nextIt = _activeTransactionList.begin();
     while (nextIt != _activeTransactionList.end()) {
-        // Did we get any responses?
         list<Transaction*>::iterator activeIt = nextIt++;
         Transaction* active = *activeIt;
-        if (active->isDelayedSend && !active->sentTime) {
-            // This transaction was created, queued, and then meant to be sent later.
-            // As such we'll use STimeNow() as it's "created" time for time.
-            SINFO("Transaction is marked for delayed sending, setting sentTime for timeout.");
-            active->sentTime = STimeNow();
+
+        // First cycle we've seen this transaction: register its deadline on the wheel.
+        if (!active->deadline) {
+            if (active->isDelayedSend && !active->sentTime) {
+                // This transaction was created, queued, and then meant to be sent later.
+                // As such we'll use STimeNow() as it's "created" time for time.
+                SINFO("Transaction is marked for delayed sending, setting sentTime for timeout.");
+                active->sentTime = now;
+            }
+            active->deadline = (active->sentTime ? active->sentTime : active->created) + timeout;
+            auto timeoutIt = transactionTimeouts.find(active);
+            if (timeoutIt != transactionTimeouts.end() && timeoutIt->second < active->deadline) {
+                active->deadline = timeoutIt->second;
+            }
+            _transactionDeadlines.insert(active->deadline, active);
+        } else if (!transactionTimeouts.empty()) {
+            // A caller-specified timeout can show up after registration; tighten the deadline if it did.
+            auto timeoutIt = transactionTimeouts.find(active);
+            if (timeoutIt != transactionTimeouts.end() && timeoutIt->second < active->deadline) {
+                _transactionDeadlines.cancel(active->deadline, active);
+                active->deadline = timeoutIt->second;
+                _transactionDeadlines.insert(active->deadline, active);
+            }
+        }
+
+        // Haven't timed out yet, let the caller know how long until we do.
+        nextActivity = min(nextActivity, active->deadline);
+
+        // Nothing new on a healthy socket means there's nothing else to do for this transaction this cycle.
+        if (active->s->recvBuffer.empty() && active->s->state.load() <= Socket::CONNECTED) {
+            continue;
+        }
+
+        uint64_t elapsed = now - (active->sentTime ? active->sentTime : active->created);
+        // Try the non-owning parser first. On the (common) polls where the response isn't complete yet, it figures
+        // that out without a single allocation, where SData's parser would build up and then throw away the whole
+        // header table every time. If it can't handle the response (e.g., chunked encoding), it returns 0 and we
+        // fall back to the copying parser, which is no worse than what we always did.
+        SDataView responseView;
+        int size = responseView.deserialize(active->s->recvBuffer);
+        if (size) {
+            active->fullResponse = responseView.toSData();
+        } else {
+            size = active->fullResponse.deserialize(active->s->recvBuffer);
         }
-        uint64_t timeoutFromTime = active->sentTime ? active->sentTime : active->created;
-        uint64_t now = STimeNow();
-        uint64_t elapsed = now - timeoutFromTime;
-        int size = active->fullResponse.deserialize(active->s->recvBuffer);
-        auto timeoutIt = transactionTimeouts.find(active);
-        bool specificallyTimedOut = timeoutIt != transactionTimeouts.end() && timeoutIt->second < now;
         if (size) {
             // Consume how much we read.
             active->s->recvBuffer.consumeFront(size);
@@ -147,17 +229,10 @@ void SStandaloneHTTPSManager::postPoll(fd_map& fdm, uint64_t& nextActivity, list
                 SWARN("Message failed: '" << active->fullResponse.methodLine << "'");
                 active->response = 500;
             }
-        } else if (active->s->state.load() > Socket::CONNECTED || elapsed > timeout || specificallyTimedOut) {
+        } else if (active->s->state.load() > Socket::CONNECTED) {
             // Net problem. Did this transaction end in an inconsistent state?
-            SWARN("Connection " << (elapsed > timeout ? "timed out" : "died prematurely") << " after " << elapsed / 1000 << "ms");
+            SWARN("Connection died prematurely after " << elapsed / 1000 << "ms");
             active->response = active->s->sendBufferEmpty() ? 501 : 500;
-            if (active->response == 501) {
-                SHMMM("SStandaloneHTTPSManager: '" << active->fullRequest.methodLine
-                      << "' timed out receiving response in " << (elapsed / 1000) << "ms.");
-            }
-        } else {
-            // Haven't timed out yet, let the caller know how long until we do.
-            nextActivity = min(nextActivity, timeoutFromTime + timeout);
         }
 
         // If we're done, remove from the active and add to completed
@@ -165,11 +240,49 @@ void SStandaloneHTTPSManager::postPoll(fd_map& fdm, uint64_t& nextActivity, list
             // Switch lists
             SINFO("Completed request '" << active->fullRequest.methodLine << "' to '" << active->fullRequest["Host"]
                   << "' with response '" << active->response << "' in '" << elapsed / 1000 << "'ms");
+            _transactionDeadlines.cancel(active->deadline, active);
             _activeTransactionList.erase(activeIt);
             _completedTransactionList.push_back(active);
             completedRequests.push_back(active);
         }
     }
+
+    // Time out whatever the wheel says is due; only transactions that actually expired are touched, in deadline
+    // order, and their responses land in `completedRequests` as one batch.
+    uint64_t expiredAt = 0;
+    Transaction* expired = nullptr;
+    while (_transactionDeadlines.popExpired(now, expiredAt, expired)) {
+        uint64_t elapsed = now - (expired->sentTime ? expired->sentTime : expired->created);
+        SWARN("Connection timed out after " << elapsed / 1000 << "ms");
+        expired->response = expired->s->sendBufferEmpty() ? 501 : 500;
+        if (expired->response == 501) {
+            SHMMM("SStandaloneHTTPSManager: '" << expired->fullRequest.methodLine
+                  << "' timed out receiving response in " << (elapsed / 1000) << "ms.");
+        }
+        SINFO("Completed request '" << expired->fullRequest.methodLine << "' to '" << expired->fullRequest["Host"]
+              << "' with response '" << expired->response << "' in '" << elapsed / 1000 << "'ms");
+        _activeTransactionList.remove(expired);
+        _completedTransactionList.push_back(expired);
+        completedRequests.push_back(expired);
+    }
+
+    // Sweep the keep-alive pool: drop connections the server closed (or sent unexpected data on) while they sat
+    // idle, and ones idle past the timeout.
+    auto poolIt = _idleSocketPool.begin();
+    while (poolIt != _idleSocketPool.end()) {
+        list<PooledSocket>& sockets = poolIt->second;
+        auto socketIt = sockets.begin();
+        while (socketIt != sockets.end()) {
+            if (socketIt->s->state.load() != Socket::CONNECTED || !socketIt->s->recvBuffer.empty() ||
+                socketIt->idleSince + POOL_IDLE_TIMEOUT < now) {
+                STCPManager::closeSocket(socketIt->s);
+                socketIt = sockets.erase(socketIt);
+            } else {
+                socketIt++;
+            }
+        }
+        poolIt = sockets.empty() ? _idleSocketPool.erase(poolIt) : next(poolIt);
+    }
 }
 
 SStandaloneHTTPSManager::Transaction::Transaction(SStandaloneHTTPSManager& manager_) :
@@ -179,7 +292,8 @@ SStandaloneHTTPSManager::Transaction::Transaction(SStandaloneHTTPSManager& manag
     response(0),
     manager(manager_),
     isDelayedSend(0),
-    sentTime(0)
+    sentTime(0),
+    deadline(0)
 {
     manager.validate();
 }
@@ -214,15 +328,20 @@ SStandaloneHTTPSManager::Transaction* SStandaloneHTTPSManager::_httpsSend(const
     // Create a new transaction. This can throw if `validate` fails. We explicitly do this *before* creating a socket.
     Transaction* transaction = new Transaction(*this);
 
-    // If this is going to be an https transaction, create a certificate and give it to the socket.
-    SX509* x509 = SStartsWith(url, "https://") ? SX509Open(_pem, _srvCrt, _caCrt) : nullptr;
-    Socket* s = openSocket(host, x509);
+    // Reuse a warm connection to this host if we have one - it's already connected and through the TLS handshake.
+    // Otherwise open a fresh socket (creating a certificate for it if the URL is HTTPS).
+    Socket* s = _getPooledSocket(host);
+    if (!s) {
+        SX509* x509 = SStartsWith(url, "https://") ? SX509Open(_pem, _srvCrt, _caCrt) : nullptr;
+        s = openSocket(host, x509);
+    }
     if (!s) {
         delete transaction;
         return _createErrorTransaction();
     }
 
     transaction->s = s;
+    transaction->host = host;
     transaction->fullRequest = request;
 
     // Ship it.
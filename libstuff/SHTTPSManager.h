@@ -1,5 +1,6 @@
 #pragma once
 #include <libstuff/libstuff.h>
+#include <libstuff/STimerWheel.h>
 #include <sqlitecluster/SQLiteNode.h>
 class BedrockPlugin;
 
@@ -21,6 +22,14 @@ class SStandaloneHTTPSManager : public STCPManager {
         SStandaloneHTTPSManager& manager;
         bool isDelayedSend;
         uint64_t sentTime;
+
+        // The "host:port" this transaction connected to, so closeTransaction can return the socket to the
+        // keep-alive pool for the next request to the same host.
+        string host;
+
+        // When this transaction times out (epoch microseconds), as registered on the manager's deadline wheel.
+        // Zero until the first postPoll after activation computes it.
+        uint64_t deadline;
     };
 
     // Constructor/Destructor
@@ -66,6 +75,23 @@ class SStandaloneHTTPSManager : public STCPManager {
     list<Transaction*> _activeTransactionList;
     list<Transaction*> _completedTransactionList;
 
+    // Active transactions' timeouts, ordered by deadline, so postPoll only touches the ones that actually expired
+    // instead of re-checking every outstanding transaction's clock each cycle. Guarded by _listMutex.
+    STimerWheel<Transaction*> _transactionDeadlines;
+
+    // Keep-alive pool: sockets whose transaction completed cleanly, kept warm (TCP + TLS session) for the next
+    // request to the same host, with when they went idle. Guarded by _listMutex. postPoll sweeps out sockets the
+    // server has since closed and ones idle past the timeout.
+    struct PooledSocket {
+        Socket* s;
+        uint64_t idleSince;
+    };
+    map<string, list<PooledSocket>> _idleSocketPool;
+    static const uint64_t POOL_IDLE_TIMEOUT = 60 * STIME_US_PER_S;
+
+    // Pops a healthy pooled socket for this host, or returns null if there isn't one.
+    Socket* _getPooledSocket(const string& host);
+
     // SStandaloneHTTPSManager operations are thread-safe, we lock around any accesses to our transaction lists, so that
     // multiple threads can add/remove from them.
     recursive_mutex _listMutex;
@@ -0,0 +1,84 @@
+#include "SHistogram.h"
+
+SHistogram::SHistogram() : _count(0), _max(0) {
+    for (auto& bucket : _buckets) {
+        bucket.store(0, memory_order_relaxed);
+    }
+}
+
+size_t SHistogram::_bucketFor(uint64_t value) {
+    // Small values get their own buckets (they already fit in the first group's resolution).
+    if (value < SUB_BUCKETS) {
+        return (size_t)value;
+    }
+
+    // Otherwise the group is determined by the position of the top bit, and the sub-bucket by the next few bits.
+    size_t msb = 63 - __builtin_clzll(value);
+    size_t shift = msb - SUB_BUCKET_BITS;
+    size_t group = msb - SUB_BUCKET_BITS + 1;
+    size_t sub = (value >> shift) & (SUB_BUCKETS - 1);
+    return (group << SUB_BUCKET_BITS) + sub;
+}
+
+uint64_t SHistogram::_bucketUpperBound(size_t bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    size_t group = bucket >> SUB_BUCKET_BITS;
+    size_t sub = bucket & (SUB_BUCKETS - 1);
+    size_t msb = group + SUB_BUCKET_BITS - 1;
+    size_t shift = msb - SUB_BUCKET_BITS;
+    return (1ull << msb) + (((uint64_t)sub + 1) << shift) - 1;
+}
+
+void SHistogram::record(uint64_t value) {
+    _buckets[_bucketFor(value)].fetch_add(1, memory_order_relaxed);
+    _count.fetch_add(1, memory_order_relaxed);
+
+    // Keep the exact maximum, since the tail is the whole point.
+    uint64_t seen = _max.load(memory_order_relaxed);
+    while (value > seen && !_max.compare_exchange_weak(seen, value, memory_order_relaxed)) {
+    }
+}
+
+uint64_t SHistogram::count() const {
+    return _count.load(memory_order_relaxed);
+}
+
+uint64_t SHistogram::max() const {
+    return _max.load(memory_order_relaxed);
+}
+
+uint64_t SHistogram::percentile(double percent) const {
+    uint64_t total = count();
+    if (!total) {
+        return 0;
+    }
+
+    // Walk the buckets until we've passed the requested fraction of the samples.
+    uint64_t threshold = (uint64_t)(percent / 100.0 * (double)total + 0.5);
+    threshold = std::max(threshold, (uint64_t)1);
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+        seen += _buckets[bucket].load(memory_order_relaxed);
+        if (seen >= threshold) {
+            // Never report past the exact max (the top bucket's bound can overshoot it).
+            return std::min(_bucketUpperBound(bucket), max());
+        }
+    }
+    return max();
+}
+
+string SHistogram::summary() const {
+    return "p50 " + to_string(percentile(50)) + ", p90 " + to_string(percentile(90)) + ", p99 " +
+           to_string(percentile(99)) + ", p999 " + to_string(percentile(99.9)) + ", max " + to_string(max()) + " (" +
+           to_string(count()) + " samples)";
+}
+
+void SHistogram::clear() {
+    for (auto& bucket : _buckets) {
+        bucket.store(0, memory_order_relaxed);
+    }
+    _count.store(0, memory_order_relaxed);
+    _max.store(0, memory_order_relaxed);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <libstuff/libstuff.h>
+
+// A fixed-memory, log-bucketed latency histogram (HDR-histogram style). Values land in buckets whose width doubles
+// every power of two, subdivided 16 ways, so any recorded value is off by at most ~6% while the whole structure stays
+// under 8KB no matter how many samples it sees. Recording is a single atomic increment, so many threads can record
+// into one histogram without locking; `percentile` reads are approximate if writers are concurrent, which is fine for
+// monitoring. Unlike an average, the percentiles stay honest when the distribution is bimodal (e.g., during conflict
+// storms, where a fast common case hides a catastrophic tail).
+class SHistogram {
+  public:
+    SHistogram();
+
+    // Records one sample. Thread-safe, wait-free.
+    void record(uint64_t value);
+
+    // Number of samples recorded.
+    uint64_t count() const;
+
+    // Largest sample recorded (exact, not bucketed).
+    uint64_t max() const;
+
+    // The value at or below which `percent` (0-100) of recorded samples fall, as the upper bound of the containing
+    // bucket (so it errs high, never under-reporting the tail). Returns 0 if nothing's been recorded.
+    uint64_t percentile(double percent) const;
+
+    // A one-line "p50/p90/p99/p999/max (N samples)" summary, for logs and Status.
+    string summary() const;
+
+    void clear();
+
+  private:
+    // 16 sub-buckets per power of two.
+    static constexpr size_t SUB_BUCKET_BITS = 4;
+    static constexpr size_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    // Maps a value to its bucket index, and a bucket index back to the largest value that maps to it.
+    static size_t _bucketFor(uint64_t value);
+    static uint64_t _bucketUpperBound(size_t bucket);
+
+    atomic<uint64_t> _buckets[BUCKET_COUNT];
+    atomic<uint64_t> _count;
+    atomic<uint64_t> _max;
+};
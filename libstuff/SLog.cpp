@@ -13,3 +13,182 @@ void SLogStackTrace() {
         SWARN(frame);
     }
 }
+
+// --------------------------------------------------------------------------
+// Async logging backend.
+//
+// Each thread that logs gets its own single-producer ring buffer; one logger thread is the single consumer for all
+// of them, so neither side ever takes a lock on the hot path. Pushing a line is two atomic loads, a string move, and
+// an atomic store - the only syscall is a condition variable poke when the ring was empty. A full ring drops the
+// line and bumps a counter, which the logger reports when it next drains that ring: at our log volume, falling 8k
+// lines behind means /dev/log itself is wedged, which is exactly when we want to drop instead of block workers.
+namespace {
+    struct SLogRing {
+        // Must be a power of two.
+        static const size_t SIZE = 8192;
+
+        struct Entry {
+            int priority;
+            string message;
+        };
+        Entry entries[SIZE];
+
+        // Next slot to write. Written by the owning thread only.
+        atomic<size_t> head{0};
+
+        // Next slot to read. Written by the logger thread only.
+        atomic<size_t> tail{0};
+
+        // Lines discarded because the ring was full.
+        atomic<size_t> dropped{0};
+
+        // Set when the owning thread exits; the logger unregisters the ring once it's drained it empty.
+        atomic<bool> retired{false};
+    };
+
+    // Every live ring. The registry lock is only taken when a thread logs for the first time, when a ring is
+    // retired, and to snapshot the list each drain pass.
+    mutex _registryMutex;
+    list<shared_ptr<SLogRing>> _registry;
+
+    atomic<bool> _asyncEnabled(false);
+    atomic<bool> _loggerRunning(false);
+    thread _loggerThread;
+    mutex _loggerMutex;
+    condition_variable _loggerCondition;
+
+    // Counts completed passes over every ring, so SLogFlush can tell when everything queued before it was called
+    // has been written out.
+    atomic<uint64_t> _drainPasses(0);
+    condition_variable _drainPassCondition;
+
+    // The thread_local handle retires the ring when its thread exits; the shared_ptr keeps the ring alive until the
+    // logger has drained and unregistered it.
+    struct SLogRingHandle {
+        shared_ptr<SLogRing> ring;
+        ~SLogRingHandle() {
+            if (ring) {
+                ring->retired.store(true);
+            }
+        }
+    };
+    thread_local SLogRingHandle _threadRing;
+
+    SLogRing& _localRing() {
+        if (!_threadRing.ring) {
+            _threadRing.ring = make_shared<SLogRing>();
+            lock_guard<mutex> lock(_registryMutex);
+            _registry.push_back(_threadRing.ring);
+        }
+        return *_threadRing.ring;
+    }
+
+    void _drainRing(SLogRing& ring) {
+        size_t tail = ring.tail.load();
+        size_t head = ring.head.load();
+        while (tail != head) {
+            SLogRing::Entry& entry = ring.entries[tail % SLogRing::SIZE];
+            syslog(entry.priority, "%s", entry.message.c_str());
+
+            // Keep small buffers around for reuse, but don't let one giant line pin its capacity forever.
+            if (entry.message.capacity() > 1024) {
+                entry.message = string();
+            } else {
+                entry.message.clear();
+            }
+            ring.tail.store(++tail);
+        }
+        size_t dropped = ring.dropped.exchange(0);
+        if (dropped) {
+            // Logged directly (in the same shape SWHEREAMI produces) rather than through the rings, so the report
+            // can't itself be dropped.
+            syslog(LOG_WARNING, "%s", ("(SLog.cpp:0) _drainRing [logger] [warn] Dropped " + to_string(dropped)
+                                       + " log lines under overload.").c_str());
+        }
+    }
+
+    void _loggerMain() {
+        SLogSetThreadName("logger");
+        bool exitAfterPass = false;
+        while (!exitAfterPass) {
+            {
+                unique_lock<mutex> lock(_loggerMutex);
+                if (_loggerRunning.load()) {
+                    _loggerCondition.wait_for(lock, chrono::milliseconds(100));
+                }
+            }
+
+            // Once asked to stop, run one final pass so anything enqueued before the stop still gets written.
+            exitAfterPass = !_loggerRunning.load();
+
+            list<shared_ptr<SLogRing>> rings;
+            {
+                lock_guard<mutex> lock(_registryMutex);
+                rings = _registry;
+            }
+            for (auto& ring : rings) {
+                _drainRing(*ring);
+                if (ring->retired.load() && ring->head.load() == ring->tail.load()) {
+                    lock_guard<mutex> lock(_registryMutex);
+                    _registry.remove(ring);
+                }
+            }
+            _drainPasses++;
+            _drainPassCondition.notify_all();
+        }
+    }
+}
+
+void SLogAsync(int priority, string&& message) {
+    if (!_asyncEnabled.load()) {
+        syslog(priority, "%s", message.c_str());
+        return;
+    }
+    SLogRing& ring = _localRing();
+    size_t head = ring.head.load();
+    size_t tail = ring.tail.load();
+    if (head - tail >= SLogRing::SIZE) {
+        // Full. Drop and count rather than block the working thread.
+        ring.dropped++;
+        return;
+    }
+    SLogRing::Entry& entry = ring.entries[head % SLogRing::SIZE];
+    entry.priority = priority;
+    entry.message = move(message);
+    ring.head.store(head + 1);
+    if (head == tail) {
+        // The logger may be asleep with nothing to do; poke it.
+        _loggerCondition.notify_one();
+    }
+}
+
+void SLogAsyncEnable(bool enabled) {
+    if (enabled && !_loggerRunning.load()) {
+        _loggerRunning.store(true);
+        _loggerThread = thread(_loggerMain);
+        _asyncEnabled.store(true);
+    } else if (!enabled && _loggerRunning.load()) {
+        // New lines go back to synchronous syslog immediately; the logger runs one final pass over the rings before
+        // exiting, so shutdown flushes with bounded latency.
+        _asyncEnabled.store(false);
+        _loggerRunning.store(false);
+        _loggerCondition.notify_one();
+        _loggerThread.join();
+    }
+}
+
+void SLogFlush() {
+    if (!_asyncEnabled.load() || !_loggerRunning.load()) {
+        return;
+    }
+
+    // Two full passes guarantee every line enqueued before this call has been written: the pass in progress may
+    // have already read our ring's head before our last line landed, but the next one can't have.
+    uint64_t target = _drainPasses.load() + 2;
+    uint64_t deadline = STimeNow() + 2 * STIME_US_PER_S;
+    unique_lock<mutex> lock(_loggerMutex);
+    while (_drainPasses.load() < target && STimeNow() < deadline) {
+        _loggerCondition.notify_one();
+        _drainPassCondition.wait_for(lock, chrono::milliseconds(50));
+    }
+}
@@ -0,0 +1,27 @@
+#include "SMetrics.h"
+
+mutex SMetrics::_registryMutex;
+
+map<string, unique_ptr<atomic<uint64_t>>>& SMetrics::_registry() {
+    // Function-local so counters registered from other static initializers don't race the registry's construction.
+    static map<string, unique_ptr<atomic<uint64_t>>> registry;
+    return registry;
+}
+
+atomic<uint64_t>& SMetrics::counter(const string& name) {
+    lock_guard<mutex> lock(_registryMutex);
+    auto& entry = _registry()[name];
+    if (!entry) {
+        entry = make_unique<atomic<uint64_t>>(0);
+    }
+    return *entry;
+}
+
+STable SMetrics::getAll() {
+    STable snapshot;
+    lock_guard<mutex> lock(_registryMutex);
+    for (const auto& pair : _registry()) {
+        snapshot[pair.first] = to_string(pair.second->load(memory_order_relaxed));
+    }
+    return snapshot;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <libstuff/libstuff.h>
+
+// A global registry of named atomic counters, for always-on instrumentation of hot paths that we'd otherwise need
+// `perf` on a production box to see (lock waits, queue waits, escalation round trips). Counters only ever count up;
+// scrapers diff successive snapshots to get rates, and a paired "fooUS"/"fooCount" convention gives average waits.
+class SMetrics {
+  public:
+    // Returns the counter registered under `name`, creating it on first use. The returned reference is valid for the
+    // life of the process, so hot paths should look it up once (e.g., into a function-local static) and then
+    // increment the atomic directly, which costs one relaxed add and no locks.
+    static atomic<uint64_t>& counter(const string& name);
+
+    // A snapshot of every registered counter, for the Status handler.
+    static STable getAll();
+
+  private:
+    // The registry itself. Values are pointers so counter references stay stable as the map grows.
+    static map<string, unique_ptr<atomic<uint64_t>>>& _registry();
+    static mutex _registryMutex;
+};
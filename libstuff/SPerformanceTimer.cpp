@@ -3,36 +3,64 @@
 
 SPerformanceTimer::SPerformanceTimer(string description, map<string, chrono::steady_clock::duration> defaults)
   : _description(description),
-  _lastLogStart(chrono::steady_clock::now()),
   _defaults(defaults),
-  _totals(_defaults)
+  _aggregate(_defaults),
+  _lastLogStart(chrono::steady_clock::now())
 {}
 
+SPerformanceTimer::ThreadBucket& SPerformanceTimer::_bucket() {
+    static thread_local map<const SPerformanceTimer*, ThreadBucket> buckets;
+    auto pair = buckets.emplace(this, ThreadBucket());
+    if (pair.second) {
+        // A brand-new bucket's first flush window starts now.
+        pair.first->second.lastFlush = chrono::steady_clock::now();
+    }
+    return pair.first->second;
+}
+
 void SPerformanceTimer::start(const string& type) {
-    _lastType = type;
-    _lastStart = chrono::steady_clock::now();
+    ThreadBucket& bucket = _bucket();
+    bucket.lastType = type;
+    bucket.lastStart = chrono::steady_clock::now();
 }
 
 void SPerformanceTimer::stop() {
     // Get the time, and the time since last start.
+    ThreadBucket& bucket = _bucket();
     auto now = chrono::steady_clock::now();
-    auto duration = now - _lastStart;
+    auto duration = now - bucket.lastStart;
 
-    // Record this time.
-    auto it = _totals.find(_lastType);
-    if (it != _totals.end()) {
-        it->second += now - _lastStart;
+    // Record this time, in our own bucket only.
+    auto it = bucket.totals.find(bucket.lastType);
+    if (it != bucket.totals.end()) {
+        it->second += duration;
     } else {
-        _totals.emplace(_lastType, duration);
+        bucket.totals.emplace(bucket.lastType, duration);
     }
 
-    // Now log, if required.
+    // Our epoch isn't up yet; nothing shared to touch.
+    if (now - bucket.lastFlush <= 10s) {
+        return;
+    }
+
+    // Fold our bucket into the shared aggregate, and log if the reporting epoch has expired too.
+    bucket.lastFlush = now;
+    lock_guard<mutex> lock(_aggregateMutex);
+    for (auto& p : bucket.totals) {
+        auto aggregateIt = _aggregate.find(p.first);
+        if (aggregateIt != _aggregate.end()) {
+            aggregateIt->second += p.second;
+        } else {
+            _aggregate.emplace(p.first, p.second);
+        }
+    }
+    bucket.totals.clear();
     if (now - _lastLogStart > 10s) {
         log(now - _lastLogStart);
 
         // Reset.
         _lastLogStart = now;
-        _totals = _defaults;
+        _aggregate = _defaults;
     }
 }
 
@@ -41,7 +69,7 @@ void SPerformanceTimer::log(chrono::steady_clock::duration elapsed) {
     chrono::steady_clock::duration accounted(chrono::steady_clock::duration::zero());
     list<string> results;
     char buffer[100];
-    for (auto& p : _totals) {
+    for (auto& p : _aggregate) {
         double microsecs = chrono::duration_cast<chrono::microseconds>(p.second).count();
         double percentage = (microsecs / elapsedUS) * 100.0;
         snprintf(buffer, 100, "%s %.2fms (%.2f%%)", p.first.c_str(), (microsecs / 1000), percentage);
@@ -1,18 +1,44 @@
 #pragma once
 #include <libstuff/libstuff.h>
 
+// Accumulates elapsed time by category and logs a percentage breakdown of where the time went every ~10 seconds.
+//
+// Samples accumulate in a thread-local bucket, so start/stop touch no shared state at all; each thread folds its
+// bucket into the shared aggregate once per epoch (~10 seconds), and whichever flush finds the epoch expired writes
+// the log line. The mutex is therefore taken a handful of times per epoch instead of twice per sample, and the
+// timer's own bookkeeping never shows up inside the intervals it measures. A thread that goes quiet carries at most
+// one epoch of unflushed samples, which land in the next window it participates in; the log output format is
+// unchanged.
 class SPerformanceTimer {
   public:
     SPerformanceTimer(string description, map<string, chrono::steady_clock::duration> defaults = {});
     void start(const string& type);
     void stop();
+
+    // Writes the log line for the current shared aggregate. Called by stop() with the aggregate lock held when an
+    // epoch expires; it doesn't take the lock itself.
     void log(chrono::steady_clock::duration elapsed);
 
   protected:
+    // Per-thread accumulation state: the in-progress interval and the per-category totals not yet folded into the
+    // shared aggregate. Owned exclusively by one thread, so none of it is synchronized.
+    struct ThreadBucket {
+        chrono::steady_clock::time_point lastStart;
+        chrono::steady_clock::time_point lastFlush;
+        string lastType;
+        map<string, chrono::steady_clock::duration> totals;
+    };
+
+    // Returns the calling thread's bucket for this timer instance. Buckets are keyed per-instance in a thread_local
+    // map; instances are expected to live for the life of the process (the existing ones do), since a destroyed
+    // timer's buckets would linger until its threads exit.
+    ThreadBucket& _bucket();
+
     string _description;
-    chrono::steady_clock::time_point _lastStart;
+    map<string, chrono::steady_clock::duration> _defaults;
+
+    // The shared aggregate buckets flush into, and the start of the epoch it covers. Only touched on flushes.
+    mutex _aggregateMutex;
+    map<string, chrono::steady_clock::duration> _aggregate;
     chrono::steady_clock::time_point _lastLogStart;
-    string _lastType;
-    map <string, chrono::steady_clock::duration> _defaults;
-    map <string, chrono::steady_clock::duration> _totals;
 };
@@ -1,25 +1,117 @@
 #include <libstuff/libstuff.h>
 #include "SQResult.h"
 
+// JSON internals defined in libstuff.cpp, declared here the same way SToJSON declares _SParseJSONValue.
+extern void _SAppendJSONEscaped(string& out, string_view value);
+extern const char* _SParseJSONValueView(const char* ptr, const char* end, string_view& value);
+extern const char* _SParseJSONString(const char* ptr, const char* end, string& out, bool populateOut);
+extern const char* _SParseJSONValue(const char* ptr, const char* end, string& value, bool populateValue);
+
+// Running total of cell bytes appended to any SQResult on this thread, for per-command accounting.
+static thread_local uint64_t _threadMaterializedBytes = 0;
+
+// Appends one cell to JSON output with the semantics SToJSON has always given cells: numbers, booleans, null, and
+// embedded JSON pass through bare, everything else escaped and quoted. The first-character test routes the
+// overwhelmingly common case - an ordinary string - straight to the escaping appender with no temporaries; only a
+// cell that might deserve bare treatment takes the old SToJSON path, keeping the output byte-identical.
+static void _appendCellJSON(string& out, string_view cell) {
+    char first = cell.empty() ? '\0' : cell[0];
+    if (isdigit(first) || first == '-' || first == '[' || first == '{' || first == 't' || first == 'T' ||
+        first == 'f' || first == 'F' || first == 'n' || first == 'N' || first == 'i' || first == 'I') {
+        out += SToJSON(string(cell));
+        return;
+    }
+    out += '"';
+    _SAppendJSONEscaped(out, cell);
+    out += '"';
+}
+
+uint64_t SQResult::threadMaterializedBytes() {
+    return _threadMaterializedBytes;
+}
+
+void SQResult::addRow() {
+    _rowEnds.push_back(_cellEnds.size());
+}
+
+void SQResult::addCell(string_view cell) {
+    SASSERT(!_rowEnds.empty());
+    _arena += cell;
+    _cellEnds.push_back(_arena.size());
+    _rowEnds.back() = _cellEnds.size();
+    _threadMaterializedBytes += cell.size();
+}
+
+void SQResult::addCell(const char* data, size_t size) {
+    addCell(string_view(data, size));
+}
+
+void SQResult::reserve(size_t rowCount, size_t columnCount, size_t contentBytes) {
+    _arena.reserve(contentBytes);
+    _cellEnds.reserve(rowCount * columnCount);
+    _rowEnds.reserve(rowCount);
+}
+
+void SQResult::clear() {
+    headers.clear();
+    _arena.clear();
+    _cellEnds.clear();
+    _rowEnds.clear();
+}
+
 string SQResult::serializeToJSON() const {
-    // Just output as a simple object
-    // **NOTE: This probably isn't super fast, but could be easily optimized
-    //         if it ever became necessary.
-    STable output;
-    output["headers"] = SComposeJSONArray(headers);
-    vector<string> jsonRows;
-    for (size_t c = 0; c < rows.size(); ++c)
-        jsonRows.push_back(SComposeJSONArray(rows[c]));
-    output["rows"] = SComposeJSONArray(jsonRows);
-    return SComposeJSONObject(output);
+    // Emit {"headers":[...],"rows":[[...],...]} directly into one output string - byte-identical to composing it
+    // through STable/SComposeJSONArray/SComposeJSONObject, but with a single sized allocation instead of a
+    // temporary string per row plus the final object copy. The size estimate assumes cells don't need escaping
+    // (the common case); a result full of quotes just grows the string once more.
+    size_t estimatedSize = contentSize() + cellCount() * 3 + size() * 3 + 32;
+    for (const string& header : headers) {
+        estimatedSize += header.size() + 3;
+    }
+    string output;
+    output.reserve(estimatedSize);
+    output += "{\"headers\":";
+    if (headers.empty()) {
+        output += "[]";
+    } else {
+        output += '[';
+        for (const string& header : headers) {
+            _appendCellJSON(output, header);
+            output += ',';
+        }
+        output[output.size() - 1] = ']';
+    }
+    output += ",\"rows\":";
+    if (empty()) {
+        output += "[]";
+    } else {
+        output += '[';
+        for (const auto& row : *this) {
+            if (row.empty()) {
+                output += "[],";
+                continue;
+            }
+            output += '[';
+            for (const auto& cell : row) {
+                _appendCellJSON(output, cell);
+                output += ',';
+            }
+            output[output.size() - 1] = ']';
+            output += ',';
+        }
+        output[output.size() - 1] = ']';
+    }
+    output += '}';
+    return output;
 }
 
 string SQResult::serializeToText() const {
     // Just output as human readable text
     // **NOTE: This could be prettied up *a lot*
     string output = SComposeList(headers, " | ") + "\n";
-    for (size_t c = 0; c < rows.size(); ++c)
-        output += SComposeList(rows[c], " | ") + "\n";
+    for (const auto& row : *this) {
+        output += SComposeList(row, " | ") + "\n";
+    }
     return output;
 }
 
@@ -35,35 +127,132 @@ bool SQResult::deserialize(const string& json) {
     // Reset ourselves to start
     clear();
 
-    // If there are any problems, clean up whatever we've parsed
+    // Parse the object in a single pass, appending cells straight into the arena as they're encountered. The old
+    // path re-parsed everything three times (object, rows array, each row) with a string copy at every level; here
+    // a cell without escapes - nearly all of them - goes from the input buffer to the arena in one append.
     try {
-        // Verify we have the basic components
-        STable content = SParseJSONObject(json);
-        if (!SContains(content, "headers")) {
-            STHROW("Missing 'headers'");
-        }
-        if (!SContains(content, "rows")) {
-            STHROW("Missing 'rows'");
-        }
+        const char* ptr = json.c_str();
+        const char* end = ptr + json.size();
+        auto skipWhitespace = [&ptr, end] {
+            while (ptr < end && isspace(*ptr)) {
+                ++ptr;
+            }
+        };
+        auto expect = [&ptr, end, &skipWhitespace](char c) {
+            skipWhitespace();
+            if (ptr >= end || *ptr != c) {
+                STHROW("Expecting '" + string(1, c) + "'");
+            }
+            ++ptr;
+        };
+        expect('{');
+        bool sawHeaders = false;
+        bool sawRows = false;
+        string temp;
+        while (true) {
+            // Parse one "name": value pair.
+            skipWhitespace();
+            string name;
+            ptr = _SParseJSONString(ptr, end, name, true);
+            if (!ptr) {
+                STHROW("Malformed key");
+            }
+            expect(':');
+            skipWhitespace();
+            if (name == "headers") {
+                sawHeaders = true;
+                expect('[');
+                skipWhitespace();
+                if (ptr < end && *ptr == ']') {
+                    ++ptr;
+                } else {
+                    while (true) {
+                        skipWhitespace();
+                        string header;
+                        ptr = _SParseJSONValue(ptr, end, header, true);
+                        if (!ptr) {
+                            STHROW("Malformed header");
+                        }
+                        headers.push_back(move(header));
+                        skipWhitespace();
+                        if (ptr < end && *ptr == ']') {
+                            ++ptr;
+                            break;
+                        }
+                        expect(',');
+                    }
+                }
+            } else if (name == "rows") {
+                sawRows = true;
+                expect('[');
+                skipWhitespace();
+                if (ptr < end && *ptr == ']') {
+                    ++ptr;
+                } else {
+                    while (true) {
+                        // One row.
+                        expect('[');
+                        addRow();
+                        skipWhitespace();
+                        if (ptr < end && *ptr == ']') {
+                            ++ptr;
+                        } else {
+                            while (true) {
+                                skipWhitespace();
+                                bool isString = ptr < end && *ptr == '"';
+                                string_view cell;
+                                ptr = _SParseJSONValueView(ptr, end, cell);
+                                if (!ptr) {
+                                    STHROW("Malformed cell");
+                                }
+                                if (isString && cell.find('\\') != string_view::npos) {
+                                    // The view is the string's raw (still escaped) contents; unescape a copy.
+                                    temp.assign(cell);
+                                    addCell(SUnescape(temp.c_str(), '\\'));
+                                } else {
+                                    addCell(cell);
+                                }
+                                skipWhitespace();
+                                if (ptr < end && *ptr == ']') {
+                                    ++ptr;
+                                    break;
+                                }
+                                expect(',');
+                            }
+                        }
+                        if (back().size() != headers.size()) {
+                            STHROW("Incorrect number of columns in row");
+                        }
+                        skipWhitespace();
+                        if (ptr < end && *ptr == ']') {
+                            ++ptr;
+                            break;
+                        }
+                        expect(',');
+                    }
+                }
+            } else {
+                // Something we don't recognize; skip its value.
+                ptr = _SParseJSONValue(ptr, end, temp, false);
+                if (!ptr) {
+                    STHROW("Malformed value");
+                }
+            }
 
-        // Add the headers
-        list<string> jsonHeaders = SParseJSONArray(content["headers"]);
-        headers.insert(headers.end(), jsonHeaders.begin(), jsonHeaders.end());
-
-        // Add the rows
-        list<string> jsonRows = SParseJSONArray(content["rows"]);
-        rows.resize(jsonRows.size());
-        int rowIndex = 0;
-        for (string& jsonRowStr : jsonRows) {
-            // Get the row and make sure it has the right number of columns
-            list<string> jsonRow = SParseJSONArray(jsonRowStr);
-            if (jsonRow.size() != headers.size()) {
-                STHROW("Incorrect number of columns in row");
+            // See if we're done with the object.
+            skipWhitespace();
+            if (ptr < end && *ptr == '}') {
+                break;
             }
+            expect(',');
+        }
 
-            // Insert the values
-            vector<string>& row = rows[rowIndex++];
-            row.insert(row.end(), jsonRow.begin(), jsonRow.end());
+        // Verify we had the basic components
+        if (!sawHeaders) {
+            STHROW("Missing 'headers'");
+        }
+        if (!sawRows) {
+            STHROW("Missing 'rows'");
         }
 
         // Success!
@@ -76,3 +265,120 @@ bool SQResult::deserialize(const string& json) {
     clear();
     return false;
 }
+
+// The binary format is versioned only by its magic byte (distinct from SData's), since both ends of a cluster
+// upgrade together.
+static const unsigned char SQRESULT_BINARY_MAGIC = 0xBF;
+
+// Appends 'value' to 'out' as 'bytes' little-endian bytes.
+static void _appendLE(string& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out += (char)(value & 0xff);
+        value >>= 8;
+    }
+}
+
+// Reads 'bytes' little-endian bytes from 'ptr' into 'value', advancing 'ptr'. Returns false if the buffer's too
+// short.
+static bool _readLE(const char*& ptr, const char* end, size_t bytes, uint64_t& value) {
+    if ((size_t)(end - ptr) < bytes) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        value |= (uint64_t)(unsigned char)ptr[i] << (8 * i);
+    }
+    ptr += bytes;
+    return true;
+}
+
+string SQResult::serializeBinary() const {
+    // [magic:1][headerCount:4][each header: length:4 + bytes][rowCount:8][cellCount:8][arenaLength:8]
+    // [rowEnds: rowCount x 8][cellEnds: cellCount x 8][arena bytes]
+    size_t totalSize = 1 + 4 + 8 + 8 + 8 + (size() + cellCount()) * 8 + contentSize();
+    for (const string& header : headers) {
+        totalSize += 4 + header.size();
+    }
+    string output;
+    output.reserve(totalSize);
+    output += (char)SQRESULT_BINARY_MAGIC;
+    _appendLE(output, headers.size(), 4);
+    for (const string& header : headers) {
+        _appendLE(output, header.size(), 4);
+        output += header;
+    }
+    _appendLE(output, size(), 8);
+    _appendLE(output, cellCount(), 8);
+    _appendLE(output, _arena.size(), 8);
+    for (size_t rowEnd : _rowEnds) {
+        _appendLE(output, rowEnd, 8);
+    }
+    for (size_t cellEnd : _cellEnds) {
+        _appendLE(output, cellEnd, 8);
+    }
+    output += _arena;
+    return output;
+}
+
+bool SQResult::deserializeBinary(const char* buffer, size_t length) {
+    clear();
+    const char* ptr = buffer;
+    const char* end = buffer + length;
+    uint64_t headerCount, rowCount, cellCount, arenaLength, value;
+    if (ptr >= end || (unsigned char)*ptr != SQRESULT_BINARY_MAGIC || !_readLE(++ptr, end, 4, headerCount)) {
+        clear();
+        return false;
+    }
+    for (uint64_t i = 0; i < headerCount; i++) {
+        if (!_readLE(ptr, end, 4, value) || (size_t)(end - ptr) < value) {
+            clear();
+            return false;
+        }
+        headers.emplace_back(ptr, value);
+        ptr += value;
+    }
+    if (!_readLE(ptr, end, 8, rowCount) || !_readLE(ptr, end, 8, cellCount) || !_readLE(ptr, end, 8, arenaLength) ||
+        (size_t)(end - ptr) != (rowCount + cellCount) * 8 + arenaLength) {
+        clear();
+        return false;
+    }
+    _rowEnds.reserve(rowCount);
+    for (uint64_t i = 0; i < rowCount; i++) {
+        _readLE(ptr, end, 8, value);
+        // Row ends index into the cell array and can't go backwards.
+        if (value > cellCount || (!_rowEnds.empty() && value < _rowEnds.back())) {
+            clear();
+            return false;
+        }
+        _rowEnds.push_back(value);
+    }
+    if (rowCount && _rowEnds.back() != cellCount) {
+        clear();
+        return false;
+    }
+    _cellEnds.reserve(cellCount);
+    for (uint64_t i = 0; i < cellCount; i++) {
+        _readLE(ptr, end, 8, value);
+        // Cell ends index into the arena and can't go backwards.
+        if (value > arenaLength || (!_cellEnds.empty() && value < _cellEnds.back())) {
+            clear();
+            return false;
+        }
+        _cellEnds.push_back(value);
+    }
+    if (cellCount && _cellEnds.back() != arenaLength) {
+        clear();
+        return false;
+    }
+    if (!rowCount && cellCount) {
+        clear();
+        return false;
+    }
+    _arena.assign(ptr, arenaLength);
+    _threadMaterializedBytes += arenaLength;
+    return true;
+}
+
+bool SQResult::deserializeBinary(const string& buffer) {
+    return deserializeBinary(buffer.c_str(), buffer.size());
+}
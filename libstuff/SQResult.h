@@ -1,34 +1,142 @@
 #pragma once
 // Can't include libstuff.h here because it'd be circular.
 #include <string>
+#include <string_view>
 #include <vector>
 using namespace std;
 
+// A query result. Storage is columnar: every cell's bytes live back-to-back in one contiguous character arena with
+// offset arrays alongside, so a 100k-row x 10-column result costs the arena's occasional growth instead of a million
+// string allocations, and walking it for serialization touches memory strictly in order. Rows are append-only
+// (addRow starts a row, addCell appends its cells straight into the arena) and are read through lightweight proxies
+// that keep the familiar result[row][column] syntax. Cells come back as string_views into the arena, which stay
+// valid until the result is cleared, re-filled, or destroyed - copy a cell out if it has to outlive the result.
 class SQResult {
   public:
+    // A read-only view of one row.
+    class Row {
+      public:
+        // Number of cells in this row
+        size_t size() const;
+        bool empty() const { return !size(); }
+
+        // Cell access
+        string_view operator[](size_t column) const;
+
+        // Cell iteration, so rows keep working with range-for, SComposeList, and friends
+        class const_iterator {
+          public:
+            string_view operator*() const { return Row(_result, _rowIndex)[_column]; }
+            const_iterator& operator++() {
+                ++_column;
+                return *this;
+            }
+            bool operator==(const const_iterator& other) const { return _column == other._column; }
+            bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+          private:
+            friend class Row;
+            const_iterator(const SQResult& result, size_t rowIndex, size_t column)
+              : _result(result), _rowIndex(rowIndex), _column(column) {}
+            const SQResult& _result;
+            size_t _rowIndex;
+            size_t _column;
+        };
+        const_iterator begin() const { return const_iterator(_result, _rowIndex, 0); }
+        const_iterator end() const { return const_iterator(_result, _rowIndex, size()); }
+
+      private:
+        friend class SQResult;
+        Row(const SQResult& result, size_t rowIndex) : _result(result), _rowIndex(rowIndex) {}
+        const SQResult& _result;
+        size_t _rowIndex;
+    };
+
+    // Row iteration
+    class const_iterator {
+      public:
+        Row operator*() const { return Row(_result, _rowIndex); }
+        const_iterator& operator++() {
+            ++_rowIndex;
+            return *this;
+        }
+        bool operator==(const const_iterator& other) const { return _rowIndex == other._rowIndex; }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+      private:
+        friend class SQResult;
+        const_iterator(const SQResult& result, size_t rowIndex) : _result(result), _rowIndex(rowIndex) {}
+        const SQResult& _result;
+        size_t _rowIndex;
+    };
+
     // Attributes
     vector<string> headers;
-    vector<vector<string>> rows;
 
     // Accessors
-    inline bool empty() const { return rows.empty(); }
-    inline size_t size() const { return rows.size(); }
+    bool empty() const { return _rowEnds.empty(); }
+    size_t size() const { return _rowEnds.size(); }
+    size_t cellCount() const { return _cellEnds.size(); }
+    size_t contentSize() const { return _arena.size(); }
+
+    // Operators
+    Row operator[](size_t rowNum) const { return Row(*this, rowNum); }
+    Row back() const { return Row(*this, size() - 1); }
+    const_iterator begin() const { return const_iterator(*this, 0); }
+    const_iterator end() const { return const_iterator(*this, size()); }
 
-    // Mutators
-    inline void clear() {
-        headers.clear();
-        rows.clear();
+    // Mutators. Rows are append-only: addRow starts a new (empty) row, and addCell appends one cell to the row most
+    // recently started. The cell passed to addCell must not view this result's own arena (appending can grow it).
+    void addRow();
+    void addCell(string_view cell);
+    void addCell(const char* data, size_t size);
+
+    // Copies any container of string-like cells in as one row.
+    template <typename T> void addRow(const T& row) {
+        addRow();
+        for (auto&& cell : row) {
+            addCell(cell);
+        }
     }
 
-    // Operators
-    inline vector<string>& operator[](size_t rowNum) { return rows[rowNum]; }
-    inline const vector<string>& operator[](size_t rowNum) const { return rows[rowNum]; }
+    // Pre-sizes the backing storage for a result whose dimensions are known (or estimable) up front.
+    void reserve(size_t rowCount, size_t columnCount, size_t contentBytes);
+
+    // Total cell bytes appended to any SQResult on the calling thread since it started. Sampling this before and
+    // after a block of work gives how much query result data that work materialized.
+    static uint64_t threadMaterializedBytes();
+
+    void clear();
 
     // Serializers
     string serializeToJSON() const;
     string serializeToText() const;
     string serialize(const string& format) const;
 
+    // Binary wire format for peer-to-peer transfer, where JSON fidelity isn't needed: counts, the offset arrays,
+    // and the raw arena bytes, so both directions are a handful of bulk copies instead of per-cell encoding. Not
+    // for client-facing output.
+    string serializeBinary() const;
+    bool deserializeBinary(const char* buffer, size_t length);
+    bool deserializeBinary(const string& buffer);
+
     // Deserializers
     bool deserialize(const string& json);
+
+  private:
+    // Every cell's bytes, back to back. _cellEnds[k] is where cell k (row-major) ends in the arena, and _rowEnds[i]
+    // is where row i ends in _cellEnds; a cell or row begins where its predecessor ends.
+    string _arena;
+    vector<size_t> _cellEnds;
+    vector<size_t> _rowEnds;
 };
+
+inline size_t SQResult::Row::size() const {
+    return _result._rowEnds[_rowIndex] - (_rowIndex ? _result._rowEnds[_rowIndex - 1] : 0);
+}
+
+inline string_view SQResult::Row::operator[](size_t column) const {
+    size_t cell = (_rowIndex ? _result._rowEnds[_rowIndex - 1] : 0) + column;
+    size_t begin = cell ? _result._cellEnds[cell - 1] : 0;
+    return string_view(_result._arena).substr(begin, _result._cellEnds[cell] - begin);
+}
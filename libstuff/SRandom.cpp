@@ -22,3 +22,36 @@ string SRandom::randStr(uint& length) {
     }
     return newstr;
 }
+
+static inline uint64_t _rotl64(const uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+uint64_t SRandom::fast64() {
+    // xoshiro256++ with per-thread state, seeded once per thread from the random device through splitmix64 (the
+    // seeding scheme xoshiro's authors recommend), so calls share nothing between threads.
+    thread_local uint64_t s[4];
+    thread_local bool seeded = false;
+    if (!seeded) {
+        random_device rd;
+        uint64_t seed = (uint64_t)rd() << 32 | rd();
+        for (auto& word : s) {
+            // splitmix64 of the seed fills out the 256 bits of state.
+            seed += 0x9e3779b97f4a7c15;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            word = z ^ (z >> 31);
+        }
+        seeded = true;
+    }
+    const uint64_t result = _rotl64(s[0] + s[3], 23) + s[0];
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = _rotl64(s[3], 45);
+    return result;
+}
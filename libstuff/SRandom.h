@@ -7,6 +7,11 @@ class SRandom {
     static uint64_t limitedRand64(uint64_t min, uint64_t max);
     static string randStr(uint& length);
 
+    // A cheap generator (xoshiro256++ on per-thread state, nothing shared) for call sites that just need jitter or
+    // probe values - ID probing, reconnect backoff - where statistical quality is plenty and rand64's shared
+    // generator is both needless cost and a data race under concurrent callers.
+    static uint64_t fast64();
+
   private:
     static mt19937_64 _generator;
     static uniform_int_distribution<uint64_t> _distribution64;
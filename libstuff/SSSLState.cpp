@@ -2,6 +2,50 @@
 #include <mbedtls/error.h>
 #include <mbedtls/net.h>
 
+// A global cache of negotiated TLS sessions keyed by "host:port". Outbound HTTPS transactions open a fresh
+// connection per request, so without this every request pays for a full key exchange; offering a cached session lets
+// the server resume it (abbreviated handshake, no RSA). Stale offers are harmless - the server just falls back to a
+// full handshake - but we age entries out anyway so we're not offering hour-old tickets forever.
+namespace {
+    struct SSSLCachedSession {
+        mbedtls_ssl_session session;
+        uint64_t savedAt;
+    };
+    map<string, SSSLCachedSession> _sessionCache;
+    mutex _sessionCacheMutex;
+
+    // Don't offer sessions older than an hour, and don't track more hosts than this (we talk to a handful).
+    const uint64_t SESSION_MAX_AGE = 60 * 60 * STIME_US_PER_S;
+    const size_t SESSION_CACHE_MAX_ENTRIES = 1000;
+
+    // The first time a connection with a known host finishes its handshake, clone the negotiated session into the
+    // cache for the next connection to that host to offer.
+    void SSSLCacheSession(SSSLState* state) {
+        if (state->sessionCached || state->host.empty() || state->ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+            return;
+        }
+        state->sessionCached = true;
+        mbedtls_ssl_session session;
+        mbedtls_ssl_session_init(&session);
+        if (mbedtls_ssl_get_session(&state->ssl, &session) != 0) {
+            mbedtls_ssl_session_free(&session);
+            return;
+        }
+        lock_guard<mutex> lock(_sessionCacheMutex);
+        auto it = _sessionCache.find(state->host);
+        if (it != _sessionCache.end()) {
+            // Replace the old session for this host with the fresh one.
+            mbedtls_ssl_session_free(&it->second.session);
+            _sessionCache.erase(it);
+        } else if (_sessionCache.size() >= SESSION_CACHE_MAX_ENTRIES) {
+            mbedtls_ssl_session_free(&_sessionCache.begin()->second.session);
+            _sessionCache.erase(_sessionCache.begin());
+        }
+        // The map entry takes over the session's internal allocations, so don't free the local.
+        _sessionCache.emplace(state->host, SSSLCachedSession{session, STimeNow()});
+    }
+}
+
 SSSLState::SSSLState() {
     mbedtls_ssl_init(&ssl);
     mbedtls_ssl_config_init(&conf);
@@ -17,15 +61,21 @@ SSSLState::~SSSLState() {
 }
 
 // --------------------------------------------------------------------------
-SSSLState* SSSLOpen(int s, SX509* x509) {
+SSSLState* SSSLOpen(int s, SX509* x509, const string& host) {
     // Initialize the SSL state
     SASSERT(s >= 0);
     SSSLState* state = new SSSLState;
     state->s = s;
+    state->host = host;
 
     mbedtls_ctr_drbg_seed(&state->ctr_drbg, mbedtls_entropy_func, &state->ec, 0, 0);
     mbedtls_ssl_config_defaults(&state->conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, 0);
 
+#ifdef MBEDTLS_SSL_SESSION_TICKETS
+    // Ask for session tickets so servers that prefer them over session IDs can still resume us.
+    mbedtls_ssl_conf_session_tickets(&state->conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
     mbedtls_ssl_setup(&state->ssl, &state->conf);
 
     mbedtls_ssl_conf_authmode(&state->conf, MBEDTLS_SSL_VERIFY_OPTIONAL);
@@ -37,15 +87,39 @@ SSSLState* SSSLOpen(int s, SX509* x509) {
         mbedtls_ssl_conf_ca_chain(&state->conf, x509->srvcert.next, 0);
         SASSERT(mbedtls_ssl_conf_own_cert(&state->conf, &x509->srvcert, &x509->pk) == 0);
     }
+
+    // If we've connected to this host before, offer its last session so the server can do an abbreviated handshake.
+    // A stale or rejected offer just means a full handshake, same as today.
+    if (!host.empty()) {
+        lock_guard<mutex> lock(_sessionCacheMutex);
+        auto it = _sessionCache.find(host);
+        if (it != _sessionCache.end()) {
+            if (it->second.savedAt + SESSION_MAX_AGE > STimeNow() &&
+                mbedtls_ssl_set_session(&state->ssl, &it->second.session) == 0) {
+                SDEBUG("Offering cached TLS session for '" << host << "'");
+            } else {
+                mbedtls_ssl_session_free(&it->second.session);
+                _sessionCache.erase(it);
+            }
+        }
+    }
     return state;
 }
 
+// --------------------------------------------------------------------------
+bool SSSLHandshakeComplete(SSSLState* ssl) {
+    SASSERT(ssl);
+    return ssl->ssl.state == MBEDTLS_SSL_HANDSHAKE_OVER;
+}
+
 // --------------------------------------------------------------------------
 int SSSLSend(SSSLState* sslState, const char* buffer, int length) {
     // Send as much as possible and report what happened
     SASSERT(sslState && buffer);
     const int numSent = mbedtls_ssl_write(&sslState->ssl, (unsigned char*)buffer, length);
     if (numSent > 0) {
+        // Application data is flowing, so the handshake is done; save the session for reuse.
+        SSSLCacheSession(sslState);
         return numSent;
     }
 
@@ -71,6 +145,8 @@ int SSSLRecv(SSSLState* sslState, char* buffer, int length) {
     SASSERT(sslState && buffer);
     const int numRecv = mbedtls_ssl_read(&sslState->ssl, (unsigned char*)buffer, length);
     if (numRecv > 0) {
+        // The server's NewSessionTicket (if any) arrives just before application data, so cache from here too.
+        SSSLCacheSession(sslState);
         return numRecv;
     }
 
@@ -147,8 +223,9 @@ void SSSLClose(SSSLState* ssl) {
 
 // --------------------------------------------------------------------------
 int SSSLSend(SSSLState* ssl, const SFastBuffer& buffer) {
-    // Unwind the buffer
-    return SSSLSend(ssl, buffer.c_str(), (int)buffer.size());
+    // Unwind the buffer. SSL can't scatter-gather, so we send the first contiguous segment; the caller's
+    // send/consume loop comes back for the rest.
+    return SSSLSend(ssl, buffer.c_str(), (int)buffer.firstSegmentSize());
 }
 
 // --------------------------------------------------------------------------
@@ -185,14 +262,19 @@ bool SSSLSendAll(SSSLState* ssl, const string& buffer) {
 
 // --------------------------------------------------------------------------
 bool SSSLRecvAppend(SSSLState* ssl, SFastBuffer& recvBuffer) {
-    // Keep trying to receive as long as we can
+    // Keep trying to receive as long as we can, decrypting straight into the receive buffer's tail so the
+    // plaintext is only written once (no bounce through a stack buffer and memcpy after it).
     SASSERT(ssl);
-    char buffer[1024 * 16];
+    const size_t CHUNK_SIZE = 1024 * 16;
     int totalRecv = 0;
     int numRecv = 0;
-    while ((numRecv = SSSLRecv(ssl, buffer, sizeof(buffer))) > 0) {
-        // Got some more data
-        recvBuffer.append(buffer, numRecv);
+    while (true) {
+        char* tail = recvBuffer.writableTail(CHUNK_SIZE);
+        numRecv = SSSLRecv(ssl, tail, CHUNK_SIZE);
+        recvBuffer.commit(numRecv > 0 ? numRecv : 0);
+        if (numRecv <= 0) {
+            break;
+        }
         totalRecv += numRecv;
     }
 
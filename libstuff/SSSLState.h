@@ -12,12 +12,20 @@ struct SSSLState {
     mbedtls_ssl_config conf;
     mbedtls_ssl_context ssl;
 
+    // The host this connection was opened to ("host:port"), used as the key into the global session cache, and
+    // whether we've already saved this connection's negotiated session there.
+    string host;
+    bool sessionCached = false;
+
     SSSLState();
     ~SSSLState();
 };
 
-// SSL helpers
-extern SSSLState* SSSLOpen(int s, SX509* x509);
+// SSL helpers. Passing a host to SSSLOpen enables session resumption: the first successful handshake to a host
+// caches its negotiated session (session ID or ticket), and later connections to the same host offer it, letting the
+// server skip the full key exchange.
+extern SSSLState* SSSLOpen(int s, SX509* x509, const string& host = "");
+extern bool SSSLHandshakeComplete(SSSLState* ssl);
 extern int SSSLSend(SSSLState* ssl, const char* buffer, int length);
 extern int SSSLSend(SSSLState* ssl, const SFastBuffer& buffer);
 extern bool SSSLSendConsume(SSSLState* ssl, SFastBuffer& sendBuffer);
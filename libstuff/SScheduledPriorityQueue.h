@@ -60,6 +60,20 @@ class SScheduledPriorityQueue {
     // Add an item to the queue. The queue takes ownership of the item and the caller's copy is invalidated.
     void push(T&& item, Priority priority, Scheduled scheduled, Timeout timeout);
 
+    // An item bundled with its scheduling parameters, for bulk pushes.
+    struct ScheduledItem {
+        ScheduledItem(T&& _item, Priority _priority, Scheduled _scheduled, Timeout _timeout)
+          : item(move(_item)), priority(_priority), scheduled(_scheduled), timeout(_timeout) {}
+        T item;
+        Priority priority;
+        Scheduled scheduled;
+        Timeout timeout;
+    };
+
+    // Add a batch of items under a single lock acquisition, waking every waiting consumer once, instead of taking
+    // the lock and notifying per item. The queue takes ownership of the items.
+    void push(vector<ScheduledItem>&& items);
+
   protected:
 
     // Associate the item with it's timeout so that when we dequeue an item to return, we can also remove it's entry
@@ -174,6 +188,29 @@ void SScheduledPriorityQueue<T>::push(T&& item, Priority priority, Scheduled sch
     _queueCondition.notify_one();
 }
 
+template<typename T>
+void SScheduledPriorityQueue<T>::push(vector<ScheduledItem>&& items) {
+    if (items.empty()) {
+        return;
+    }
+    {
+        lock_guard<decltype(_queueMutex)> lock(_queueMutex);
+        for (ScheduledItem& entry : items) {
+            _startFunction(entry.item);
+            _lookupByTimeout.insert(make_pair(entry.timeout, make_pair(entry.priority, entry.scheduled)));
+            _queue[entry.priority].emplace(entry.scheduled, ItemTimeoutPair(move(entry.item), entry.timeout));
+        }
+    }
+
+    // One item only needs one consumer; more than one is worth waking everyone for.
+    if (items.size() == 1) {
+        _queueCondition.notify_one();
+    } else {
+        _queueCondition.notify_all();
+    }
+    items.clear();
+}
+
 template<typename T>
 T SScheduledPriorityQueue<T>::_dequeue() {
     // NOTE: We don't grab a mutex here on purpose - we use a non-recursive mutex to work with condition_variable, so
@@ -0,0 +1,78 @@
+#include <libstuff/libstuff.h>
+#include "SScratchArena.h"
+
+thread_local SScratchArena::ThreadCache SScratchArena::_threadCache;
+
+SScratchArena::ThreadCache::~ThreadCache() {
+    while (head) {
+        Chunk* chunk = head;
+        head = chunk->next;
+        delete[] reinterpret_cast<char*>(chunk);
+    }
+}
+
+SScratchArena::~SScratchArena() {
+    // Park chunks on the thread cache for the next arena built on this thread, until the cache is full.
+    while (_chunks) {
+        Chunk* chunk = _chunks;
+        _chunks = chunk->next;
+        if (_threadCache.bytes + chunk->size <= THREAD_CACHE_MAX_BYTES) {
+            chunk->used = 0;
+            chunk->next = _threadCache.head;
+            _threadCache.head = chunk;
+            _threadCache.bytes += chunk->size;
+        } else {
+            delete[] reinterpret_cast<char*>(chunk);
+        }
+    }
+}
+
+SScratchArena::Chunk* SScratchArena::_acquireChunk(size_t minBytes) {
+    // Check the thread cache first. It's short (a handful of chunks at most), so a linear scan is fine.
+    Chunk** link = &_threadCache.head;
+    while (*link) {
+        if ((*link)->size >= minBytes) {
+            Chunk* chunk = *link;
+            *link = chunk->next;
+            _threadCache.bytes -= chunk->size;
+            return chunk;
+        }
+        link = &(*link)->next;
+    }
+
+    // Nothing cached fits; make a new one. The header is counted in the raw allocation but not in `size`.
+    size_t usableBytes = max(minBytes, DEFAULT_CHUNK_SIZE);
+    Chunk* chunk = reinterpret_cast<Chunk*>(new char[sizeof(Chunk) + usableBytes]);
+    chunk->next = nullptr;
+    chunk->size = usableBytes;
+    chunk->used = 0;
+    return chunk;
+}
+
+void* SScratchArena::allocate(size_t size, size_t alignment) {
+    // Figure out where this allocation would start in the current chunk, aligned up.
+    Chunk* chunk = _chunks;
+    size_t offset = 0;
+    if (chunk) {
+        offset = (chunk->used + alignment - 1) & ~(alignment - 1);
+    }
+    if (!chunk || offset + size > chunk->size) {
+        // Doesn't fit; chain on a chunk that does. Chunk data follows the max_align_t-aligned header, so offset
+        // zero satisfies any fundamental alignment.
+        chunk = _acquireChunk(size);
+        chunk->next = _chunks;
+        _chunks = chunk;
+        offset = 0;
+    }
+    char* data = reinterpret_cast<char*>(chunk + 1) + offset;
+    _bytesUsed += (offset - chunk->used) + size;
+    chunk->used = offset + size;
+    return data;
+}
+
+void SScratchArena::reset() {
+    for (Chunk* chunk = _chunks; chunk; chunk = chunk->next) {
+        chunk->used = 0;
+    }
+    _bytesUsed = 0;
+}
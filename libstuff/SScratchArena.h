@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+using namespace std;
+
+// A chunked bump allocator for short-lived scratch memory. Allocation is a pointer bump within the current chunk
+// (a new chunk is chained on when one fills up), individual frees don't exist, and everything comes back at once
+// with `reset` or destruction. This suits per-command scratch exactly: a command allocates dozens of transient
+// buffers that all die when the command completes, so instead of a malloc/free pair per buffer, the whole
+// lifetime costs a handful of chunk acquisitions.
+//
+// Chunks released by a destroyed arena are parked on a per-thread cache (bounded, so an occasional huge command
+// doesn't pin memory forever) and picked up by the next arena built on that thread, which is what takes chunk
+// allocation itself out of the per-command steady state on worker threads.
+//
+// This class does no internal synchronization: an arena belongs to whoever owns the command, and the thread cache
+// is thread-local by construction.
+class SScratchArena {
+  public:
+    // Constructing is free; the first chunk is acquired on first allocation, so untouched arenas cost nothing.
+    SScratchArena() : _chunks(nullptr), _bytesUsed(0) {}
+    ~SScratchArena();
+
+    // No copies; scratch memory belongs to exactly one owner.
+    SScratchArena(const SScratchArena&) = delete;
+    SScratchArena& operator=(const SScratchArena&) = delete;
+
+    // Returns `size` bytes aligned to `alignment`, valid until `reset` or destruction.
+    void* allocate(size_t size, size_t alignment = alignof(max_align_t));
+
+    // Discards everything allocated but keeps the chunks, so the arena can be refilled without touching malloc.
+    void reset();
+
+    // Total bytes handed out since construction or the last `reset` (including alignment padding).
+    size_t bytesUsed() const { return _bytesUsed; }
+
+  private:
+    // The alignas pads the header to a max_align_t boundary, so the data following it starts fully aligned.
+    struct alignas(max_align_t) Chunk {
+        Chunk* next;
+        size_t size; // Usable bytes following this header.
+        size_t used;
+    };
+
+    // Get a chunk with at least `minBytes` free, from the thread cache when one fits.
+    static Chunk* _acquireChunk(size_t minBytes);
+
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 16 * 1024;
+
+    // Cap on cached chunk bytes per thread; anything beyond this is freed for real. The cache is an object with
+    // a destructor (not a bare pointer) so a thread that exits frees its cached chunks instead of leaking them.
+    static constexpr size_t THREAD_CACHE_MAX_BYTES = 256 * 1024;
+    struct ThreadCache {
+        ~ThreadCache();
+        Chunk* head = nullptr;
+        size_t bytes = 0;
+    };
+    static thread_local ThreadCache _threadCache;
+
+    Chunk* _chunks; // Singly-linked, current chunk first.
+    size_t _bytesUsed;
+};
+
+// An STL-compatible handle onto an arena, so containers and strings can opt in to scratch storage (e.g.
+// `vector<int64_t, SScratchAllocator<int64_t>>`). `deallocate` is deliberately a no-op: the memory comes back
+// when the arena resets, which must outlive the container.
+template <typename T>
+class SScratchAllocator {
+  public:
+    typedef T value_type;
+
+    SScratchAllocator(SScratchArena& arena) : _arena(&arena) {}
+    template <typename U>
+    SScratchAllocator(const SScratchAllocator<U>& other) : _arena(other._arena) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(_arena->allocate(count * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    bool operator==(const SScratchAllocator& other) const { return _arena == other._arena; }
+    bool operator!=(const SScratchAllocator& other) const { return _arena != other._arena; }
+
+  private:
+    template <typename U>
+    friend class SScratchAllocator;
+    SScratchArena* _arena;
+};
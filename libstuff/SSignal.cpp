@@ -172,6 +172,10 @@ void _SSignal_StackTrace(int signum, siginfo_t *info, void *ucontext) {
             SSignalHandlerDieFunc();
             SSignalHandlerDieFunc = [](){};
             SWARN("DIE function returned, aborting (if not done).");
+
+            // If async logging is on, everything we just logged is sitting in ring buffers; give the logger thread
+            // a bounded chance to write it out before we abort. Not signal-safe, like the rest of this block.
+            SLogFlush();
         }
 
         // If we weren't already in ABORT, we'll call that. The second call will skip the above callstack generation.
@@ -0,0 +1,140 @@
+#include "libstuff.h"
+
+// Blocks are filed in 64-byte size classes. Each class has one shared depot (mutex + free list, with the same
+// low-water-mark decay as SBufferPool's tiers), and each thread a private magazine. Magazines are pure thread-local
+// state: the hot path is a push or pop on a small vector. When a magazine runs empty it pulls half a load from the
+// depot in one locked batch; when it fills it pushes half its load back the same way, so the depot lock is paid once
+// per MAGAZINE_BATCH operations per thread, not per operation. A thread's magazines drain to the depots when the
+// thread exits.
+namespace {
+    const size_t CLASS_SIZE_STEP = 64;
+    const size_t NUM_CLASSES = SSlabPool::MAX_POOLED_SIZE / CLASS_SIZE_STEP;
+
+    // Magazine capacity, and the batch size exchanged with the depot (half a magazine).
+    const size_t MAGAZINE_MAX = 32;
+    const size_t MAGAZINE_BATCH = MAGAZINE_MAX / 2;
+
+    // Each depot retains at most this many free blocks; beyond it, blocks are freed immediately.
+    const size_t DEPOT_MAX_FREE = 4096;
+
+    // Decay idle depot blocks every 10 seconds.
+    const uint64_t DECAY_INTERVAL = 10 * STIME_US_PER_S;
+
+    struct Depot {
+        mutex m;
+        vector<void*> freeList;
+        size_t lowWaterMark = 0;
+        uint64_t lastDecay = 0;
+    };
+
+    Depot* depots() {
+        static Depot d[NUM_CLASSES];
+        return d;
+    }
+
+    // With the depot lock held, frees blocks that went unused for a full decay interval.
+    void decayIdle(Depot& depot) {
+        uint64_t now = STimeNow();
+        if (!depot.lastDecay) {
+            depot.lastDecay = now;
+        } else if (now > depot.lastDecay + DECAY_INTERVAL) {
+            // Everything below the low-water mark sat idle all interval; drop it.
+            for (size_t i = 0; i < depot.lowWaterMark && !depot.freeList.empty(); i++) {
+                ::operator delete(depot.freeList.back());
+                depot.freeList.pop_back();
+            }
+            depot.lowWaterMark = depot.freeList.size();
+            depot.lastDecay = now;
+        }
+    }
+
+    // The per-thread magazines, wrapped so a thread's cached blocks return to the depots when it exits.
+    struct Magazines {
+        vector<void*> blocks[NUM_CLASSES];
+        ~Magazines() {
+            for (size_t c = 0; c < NUM_CLASSES; c++) {
+                if (blocks[c].empty()) {
+                    continue;
+                }
+                Depot& depot = depots()[c];
+                lock_guard<mutex> lock(depot.m);
+                for (void* block : blocks[c]) {
+                    if (depot.freeList.size() < DEPOT_MAX_FREE) {
+                        depot.freeList.push_back(block);
+                    } else {
+                        ::operator delete(block);
+                    }
+                }
+            }
+        }
+    };
+    thread_local Magazines magazines;
+
+    size_t classIndex(size_t size) {
+        return (size + CLASS_SIZE_STEP - 1) / CLASS_SIZE_STEP - 1;
+    }
+}
+
+void* SSlabPool::allocate(size_t size) {
+    if (!size || size > MAX_POOLED_SIZE) {
+        return ::operator new(size);
+    }
+    size_t c = classIndex(size);
+    vector<void*>& magazine = magazines.blocks[c];
+    if (magazine.empty()) {
+        // Refill a batch from the depot in one locked pass.
+        Depot& depot = depots()[c];
+        lock_guard<mutex> lock(depot.m);
+        decayIdle(depot);
+        while (!depot.freeList.empty() && magazine.size() < MAGAZINE_BATCH) {
+            magazine.push_back(depot.freeList.back());
+            depot.freeList.pop_back();
+        }
+        depot.lowWaterMark = min(depot.lowWaterMark, depot.freeList.size());
+    }
+    if (!magazine.empty()) {
+        void* block = magazine.back();
+        magazine.pop_back();
+        return block;
+    }
+
+    // Nothing cached anywhere; carve a fresh block at the full class size so it's reusable for the whole class.
+    return ::operator new((c + 1) * CLASS_SIZE_STEP);
+}
+
+void SSlabPool::deallocate(void* ptr, size_t size) {
+    if (!ptr) {
+        return;
+    }
+    if (!size || size > MAX_POOLED_SIZE) {
+        ::operator delete(ptr);
+        return;
+    }
+    size_t c = classIndex(size);
+    vector<void*>& magazine = magazines.blocks[c];
+    if (magazine.size() >= MAGAZINE_MAX) {
+        // Flush a batch to the depot in one locked pass; anything over its retention cap is freed for real.
+        Depot& depot = depots()[c];
+        lock_guard<mutex> lock(depot.m);
+        decayIdle(depot);
+        for (size_t i = 0; i < MAGAZINE_BATCH; i++) {
+            if (depot.freeList.size() < DEPOT_MAX_FREE) {
+                depot.freeList.push_back(magazine.back());
+            } else {
+                ::operator delete(magazine.back());
+            }
+            magazine.pop_back();
+        }
+    }
+    magazine.push_back(ptr);
+}
+
+size_t SSlabPool::depotBytes() {
+    size_t total = 0;
+    for (size_t c = 0; c < NUM_CLASSES; c++) {
+        Depot& depot = depots()[c];
+        lock_guard<mutex> lock(depot.m);
+        total += depot.freeList.size() * (c + 1) * CLASS_SIZE_STEP;
+    }
+    return total;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+using namespace std;
+
+// A global pool of reusable heap blocks for small, fixed-size-ish objects that churn at request rate — commands and
+// sockets, principally, which are allocated and freed tens of thousands of times a second and otherwise fragment
+// the heap. Blocks are filed in 64-byte size classes. Each thread keeps a small magazine of free blocks per class,
+// so the common allocate/deallocate pair is a thread-local push/pop with no synchronization at all; magazines
+// exchange blocks with a shared per-class depot in batches when they run empty or full. Like SBufferPool, each
+// depot decays toward its recent low-water mark, so a burst doesn't permanently inflate RSS: blocks that sat idle
+// through a whole decay interval are returned to the allocator.
+//
+// The intended consumers are class-level operator new/delete (see BedrockCommand, STCPManager::Socket): the sized
+// operator delete hands back the most-derived object size, so every subclass automatically gets a correctly-sized
+// class without registering anything.
+class SSlabPool {
+  public:
+    // Objects above this size aren't pooled; allocate falls through to the global allocator and deallocate frees.
+    static constexpr size_t MAX_POOLED_SIZE = 4096;
+
+    // Returns a block of at least `size` bytes, from the calling thread's magazine when possible.
+    static void* allocate(size_t size);
+
+    // Files a block back by size class. `size` must be the same value the block was allocated with (which is what
+    // sized operator delete provides).
+    static void deallocate(void* ptr, size_t size);
+
+    // Bytes currently held in the shared depots (thread-local magazines aren't counted), for tests and diagnostics.
+    static size_t depotBytes();
+};
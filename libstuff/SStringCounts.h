@@ -0,0 +1,55 @@
+#pragma once
+#include <libstuff/libstuff.h>
+
+// Cheap, thread-safe counters keyed by string, for status reporting on hot queues. Counting an existing key takes a
+// shared lock and an atomic increment, so concurrent updaters don't serialize against each other; a unique lock is
+// only taken the first time a new key appears. Keys stick around at zero until clear() - the keys we count (command
+// method lines) are low-cardinality, and never erasing them is what keeps the fast path contention-free.
+//
+// Snapshots taken during concurrent updates are approximate: an in-flight increment may or may not be included.
+// That's the point - this exists so `Status` can report queue contents without locking the queues themselves.
+class SStringCounts {
+  public:
+    void increment(const string& key) {
+        {
+            shared_lock<shared_mutex> lock(_mutex);
+            auto it = _counts.find(key);
+            if (it != _counts.end()) {
+                it->second++;
+                return;
+            }
+        }
+        unique_lock<shared_mutex> lock(_mutex);
+        _counts[key]++;
+    }
+
+    void decrement(const string& key) {
+        shared_lock<shared_mutex> lock(_mutex);
+        auto it = _counts.find(key);
+        if (it != _counts.end()) {
+            it->second--;
+        }
+    }
+
+    // Returns the current non-zero counts.
+    map<string, int64_t> snapshot() const {
+        map<string, int64_t> result;
+        shared_lock<shared_mutex> lock(_mutex);
+        for (const auto& countPair : _counts) {
+            int64_t count = countPair.second.load();
+            if (count) {
+                result[countPair.first] = count;
+            }
+        }
+        return result;
+    }
+
+    void clear() {
+        unique_lock<shared_mutex> lock(_mutex);
+        _counts.clear();
+    }
+
+  private:
+    mutable shared_mutex _mutex;
+    map<string, atomic<int64_t>> _counts;
+};
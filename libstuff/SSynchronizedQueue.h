@@ -1,4 +1,5 @@
 #pragma once
+#include <sys/eventfd.h>
 
 template <typename T>
 class SSynchronizedQueue {
@@ -35,64 +36,60 @@ class SSynchronizedQueue {
     void each(const function<void (T&)> f);
 
   protected:
+    // Wake any poll loop watching this queue. Called by `push` when the queue transitions from empty to non-empty;
+    // while the queue stays non-empty a single pending signal suffices (postPoll re-arms it if commands remain), so
+    // pushes at high escalation rates cost no signaling syscalls at all.
+    void _signal();
+
     list<T> _queue;
     mutable recursive_mutex _queueMutex;
 
-    // You may be wondering why we use a pipe instead of a condition variable
+    // You may be wondering why we use an eventfd instead of a condition variable
     // for alerting threads that work is available. That's because we are treating
     // queue activity like network activity in BedrockServer. This means that we
-    // treat the queue as if it was a network socket and we use the pipe to know
+    // treat the queue as if it was a network socket and we use the eventfd to know
     // if there are "unread bytes on the socket" that is to say -- work available --
     // in the queue.
-    // This is kind of weird but prevents threads from waiting for a the poll()
-    // timeout on network activity. Since queue activity also causes poll() to return
-    // if there is work in the queue.
-    int _pipeFD[2] = {-1, -1};
+    // Unlike the pipe this used to be, an eventfd is a single counter: it drains in
+    // one read rather than one read per pushed item, and it can't fill up and block
+    // writers the way a pipe's 64k buffer can when the consumer falls behind.
+    int _eventFD = -1;
 };
 
 template<typename T>
 SSynchronizedQueue<T>::SSynchronizedQueue() {
-    // Open up a pipe for communication and set the non-blocking reads.
-    SASSERT(0 == pipe(_pipeFD));
-    int flags = fcntl(_pipeFD[0], F_GETFL, 0);
-    fcntl(_pipeFD[0], F_SETFL, flags | O_NONBLOCK);
+    _eventFD = eventfd(0, EFD_NONBLOCK);
+    SASSERT(_eventFD != -1);
 }
 
 template<typename T>
 SSynchronizedQueue<T>::~SSynchronizedQueue() {
-    if (_pipeFD[0] != -1) {
-        close(_pipeFD[0]);
-    }
-    if (_pipeFD[1] != -1) {
-        close(_pipeFD[1]);
+    if (_eventFD != -1) {
+        close(_eventFD);
     }
 }
 
 template<typename T>
 void SSynchronizedQueue<T>::prePoll(fd_map& fdm) {
-    // Put the read-side of the pipe into the fd set.
-    // **NOTE: This is *not* synchronized.  All threads use the same pipes. All threads use *different* fd_maps, though
-    //         so we don't have to worry about contention inside FDSet.
-    SFDset(fdm, _pipeFD[0], SREADEVTS);
+    // Put the eventfd into the fd set.
+    // **NOTE: This is *not* synchronized.  All threads use the same eventfd. All threads use *different* fd_maps,
+    //         though so we don't have to worry about contention inside FDSet.
+    SFDset(fdm, _eventFD, SREADEVTS);
 }
 
 template<typename T>
 void SSynchronizedQueue<T>::postPoll(fd_map& fdm) {
-    // Check if there is anything to read off of the pipe, if there is, empty it.
-    if (SFDAnySet(fdm, _pipeFD[0], SREADEVTS)) {
-        // Read until there is nothing left to read.
-        while (true) {
-            char readbuffer[1];
-            int ret = read(_pipeFD[0], readbuffer, sizeof(readbuffer));
-
-            // Since the pipe is set to non-blocking reads, read() will return -1
-            // when there is no data to read  and will set errno to EAGAIN/EWOULDBLOCK
-            // otherwise it will 0 when we have read it all
-            if (ret <= 0 && errno == EWOULDBLOCK) {
-                break;
-            } else if (ret == -1) {
-                STHROW("Failed to read from pipe");
-            }
+    // If the eventfd fired, a single read drains the whole counter. If the consumer then leaves commands behind
+    // (e.g., the sync loop breaks out to service the network), we re-arm the signal so the next poll returns
+    // immediately rather than sleeping on a non-empty queue.
+    if (SFDAnySet(fdm, _eventFD, SREADEVTS)) {
+        uint64_t count = 0;
+        if (read(_eventFD, &count, sizeof(count)) == -1 && errno != EWOULDBLOCK && errno != EAGAIN) {
+            STHROW("Failed to read from eventfd");
+        }
+        lock_guard<decltype(_queueMutex)> lock(_queueMutex);
+        if (!_queue.empty()) {
+            _signal();
         }
     }
 }
@@ -126,12 +123,14 @@ T SSynchronizedQueue<T>::pop() {
 template<typename T>
 void SSynchronizedQueue<T>::push(T&& rhs) {
     lock_guard<decltype(_queueMutex)> lock(_queueMutex);
-    // Just add to the queue
-    _queue.push_back(move(rhs));
 
-    // Write arbitrary buffer to the pipe so any subscribers will be awoken.
-    // **NOTE: 1 byte so write is atomic.
-    SASSERT(write(_pipeFD[1], "A", 1));
+    // Just add to the queue, and signal pollers only on the empty -> non-empty transition; while the queue is
+    // non-empty a pending signal already exists (postPoll maintains this invariant).
+    bool wasEmpty = _queue.empty();
+    _queue.push_back(move(rhs));
+    if (wasEmpty) {
+        _signal();
+    }
 }
 
 template<typename T>
@@ -145,3 +144,11 @@ void SSynchronizedQueue<T>::each(const function<void (T&)> f) {
     lock_guard<decltype(_queueMutex)> lock(_queueMutex);
     for_each(_queue.begin(), _queue.end(), f);
 }
+
+template<typename T>
+void SSynchronizedQueue<T>::_signal() {
+    // Adding to the eventfd counter can't block (the counter saturates at 2^64-2, which we'll never approach with
+    // one pending signal at a time), unlike writes to the pipe this replaced.
+    uint64_t one = 1;
+    SASSERT(write(_eventFD, &one, sizeof(one)) == sizeof(one));
+}
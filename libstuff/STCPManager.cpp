@@ -1,6 +1,9 @@
 #include "libstuff.h"
+#include <sys/sendfile.h>
 
 atomic<uint64_t> STCPManager::Socket::socketCount(1);
+atomic<uint64_t> STCPManager::sendCoalescingUS(0);
+atomic<size_t> STCPManager::Socket::spoolThresholdBytes(0);
 
 STCPManager::~STCPManager() {
     SASSERTWARN(socketList.empty());
@@ -199,6 +202,23 @@ void STCPManager::postPoll(fd_map& fdm) {
     }
 }
 
+void STCPManager::postPoll(fd_map& fdm, uint64_t& nextActivity) {
+    postPoll(fdm);
+
+    // If coalescing is on, any socket may have deferred a flush in Socket::send. prePoll registers non-empty send
+    // buffers for write events, so the next poll cycle sends them; here we just make sure that cycle isn't further
+    // away than the coalescing deadline.
+    uint64_t deadline = sendCoalescingUS.load();
+    if (deadline) {
+        for (Socket* socket : socketList) {
+            if (socket->state.load() == Socket::CONNECTED && !socket->sendBufferEmpty()) {
+                nextActivity = min(nextActivity, STimeNow() + deadline);
+                break;
+            }
+        }
+    }
+}
+
 void STCPManager::shutdownSocket(Socket* socket, int how) {
     // Send the shutdown and note
     SASSERT(socket);
@@ -216,6 +236,14 @@ void STCPManager::closeSocket(Socket* socket) {
     delete socket;
 }
 
+void* STCPManager::Socket::operator new(size_t size) {
+    return SSlabPool::allocate(size);
+}
+
+void STCPManager::Socket::operator delete(void* ptr, size_t size) {
+    SSlabPool::deallocate(ptr, size);
+}
+
 STCPManager::Socket::Socket(int sock, STCPManager::Socket::State state_, SX509* x509)
   : s(sock), addr{}, state(state_), connectFailure(false), openTime(STimeNow()), lastSendTime(openTime),
     lastRecvTime(openTime), ssl(nullptr), data(nullptr), id(STCPManager::Socket::socketCount++), _x509(x509),
@@ -223,6 +251,7 @@ STCPManager::Socket::Socket(int sock, STCPManager::Socket::State state_, SX509*
 { }
 
 STCPManager::Socket::~Socket() {
+    _spoolDiscard();
     ::close(s);
     if (ssl) {
         SSSLClose(ssl);
@@ -242,7 +271,7 @@ STCPManager::Socket* STCPManager::openSocket(const string& host, SX509* x509, re
 
     // Create a new socket
     Socket* socket = new Socket(s, Socket::CONNECTING, x509);
-    socket->ssl = x509 ? SSSLOpen(socket->s, x509) : 0;
+    socket->ssl = x509 ? SSSLOpen(socket->s, x509, host) : 0;
     SASSERT(!x509 || socket->ssl);
 
     if (listMutexPtr) {
@@ -279,38 +308,198 @@ bool STCPManager::Socket::send() {
         result = SSSLSendConsume(ssl, sendBuffer);
     } else if (s > 0) {
         result = S_sendconsume(s, sendBuffer);
+
+        // Once the in-memory buffer is drained, feed the socket straight from the spool file, if there is one. The
+        // kernel pulls pages from the page cache as the socket accepts them, so the payload never sits in our heap.
+        if (result && sendBuffer.empty() && spoolFD >= 0) {
+            while (spoolReadOffset < spoolWriteOffset) {
+                ssize_t sent = sendfile(s, spoolFD, &spoolReadOffset, spoolWriteOffset - spoolReadOffset);
+                if (sent > 0) {
+                    sentBytes += sent;
+                } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                    // Socket's full for now; the poll loop will call us again when it drains.
+                    break;
+                } else {
+                    SWARN("sendfile from spool failed (" << strerror(errno) << "), closing socket.");
+                    result = false;
+                    break;
+                }
+            }
+            if (spoolReadOffset == spoolWriteOffset) {
+                // Fully drained; back to normal buffering.
+                _spoolDiscard();
+            }
+        }
     }
     sentBytes += (oldSize - sendBuffer.size());
     lastSendTime = STimeNow();
     return result;
 }
 
+bool STCPManager::Socket::_spoolAppend(const char* data, size_t length) {
+    if (spoolFD < 0) {
+        // An unlinked temp file: it has no name, and the kernel reclaims it the moment the fd closes, however we
+        // exit. O_TMPFILE does that in one step where supported; otherwise mkstemp and immediately unlink.
+#ifdef O_TMPFILE
+        spoolFD = open("/tmp", O_TMPFILE | O_RDWR | O_CLOEXEC, S_IRUSR | S_IWUSR);
+#endif
+        if (spoolFD < 0) {
+            char path[] = "/tmp/bedrock-spool-XXXXXX";
+            spoolFD = mkstemp(path);
+            if (spoolFD >= 0) {
+                unlink(path);
+            }
+        }
+        if (spoolFD < 0) {
+            SWARN("Couldn't open spool file (" << strerror(errno) << "), falling back to in-memory send buffer.");
+            return false;
+        }
+        spoolReadOffset = 0;
+        spoolWriteOffset = 0;
+    }
+    size_t written = 0;
+    while (written < length) {
+        ssize_t wrote = pwrite(spoolFD, data + written, length - written, spoolWriteOffset + written);
+        if (wrote < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            SWARN("Couldn't write to spool file (" << strerror(errno) << "), falling back to in-memory send buffer.");
+            // Pretend the partial write never happened; the caller buffers the whole payload instead.
+            return false;
+        }
+        written += wrote;
+    }
+    spoolWriteOffset += length;
+    return true;
+}
+
+void STCPManager::Socket::_spoolDiscard() {
+    if (spoolFD >= 0) {
+        ::close(spoolFD);
+        spoolFD = -1;
+        spoolReadOffset = 0;
+        spoolWriteOffset = 0;
+    }
+}
+
 bool STCPManager::Socket::send(const string& buffer) {
     lock_guard<decltype(sendRecvMutex)> lock(sendRecvMutex);
 
-    // If the socket's in a valid state for sending, append to the sendBuffer, otherwise warn
+    // If the socket's in a valid state for sending, append to the sendBuffer, otherwise warn. Oversized payloads
+    // (and, to preserve ordering, everything queued behind an active spool) go to the temp-file spool instead of the
+    // heap; TLS sockets always buffer (sendfile can't feed an encrypted stream), as does anything the spool file
+    // can't take.
     if (state.load() < Socket::State::SHUTTINGDOWN) {
-        sendBuffer += buffer;
+        size_t threshold = spoolThresholdBytes.load();
+        if (ssl || (spoolFD < 0 && (!threshold || buffer.size() < threshold)) ||
+            !_spoolAppend(buffer.c_str(), buffer.size())) {
+            sendBuffer += buffer;
+        }
     } else if (!sendBuffer.empty()) {
         SWARN("Not appending to sendBuffer in socket state " << state.load() << ", tried to send: " << buffer);
     }
 
+    // If this socket is still mid-handshake, don't step the handshake from the caller's thread (typically a worker
+    // queueing a request); the poll loop drives the handshake state machine and flushes the buffer once it's done.
+    if (ssl && !SSSLHandshakeComplete(ssl)) {
+        return true;
+    }
+
+    // If we flushed this socket very recently, let the data ride in the buffer instead of making another syscall;
+    // the next send after the window (or the poll loop, see STCPManager::postPoll) flushes everything in one go.
+    uint64_t deadline = sendCoalescingUS.load();
+    if (deadline && lastSendTime + deadline > STimeNow()) {
+        return true;
+    }
+
+    // Send anything we've got.
+    return send();
+}
+
+bool STCPManager::Socket::send(const shared_ptr<const string>& buffer) {
+    lock_guard<decltype(sendRecvMutex)> lock(sendRecvMutex);
+
+    // Same as send(const string&), but the sendBuffer chains a reference to the shared bytes rather than copying
+    // them (see SFastBuffer::append(shared_ptr)), so a broadcast's serialization is stored once across all its
+    // sockets. Spooled payloads still copy - they're leaving memory anyway.
+    if (state.load() < Socket::State::SHUTTINGDOWN) {
+        size_t threshold = spoolThresholdBytes.load();
+        if (ssl || (spoolFD < 0 && (!threshold || buffer->size() < threshold)) ||
+            !_spoolAppend(buffer->c_str(), buffer->size())) {
+            sendBuffer.append(buffer);
+        }
+    } else if (!sendBuffer.empty()) {
+        SWARN("Not appending to sendBuffer in socket state " << state.load() << ", tried to send: " << *buffer);
+    }
+
+    // Same handshake deferral as above.
+    if (ssl && !SSSLHandshakeComplete(ssl)) {
+        return true;
+    }
+
+    // Same coalescing window as above.
+    uint64_t deadline = sendCoalescingUS.load();
+    if (deadline && lastSendTime + deadline > STimeNow()) {
+        return true;
+    }
+
+    // Send anything we've got.
+    return send();
+}
+
+bool STCPManager::Socket::send(string&& buffer) {
+    lock_guard<decltype(sendRecvMutex)> lock(sendRecvMutex);
+
+    // Same as above, but large payloads are moved into the sendBuffer as their own segment rather than copied.
+    // Most callers pass freshly-serialized messages, so they land here automatically. Same spool routing as above;
+    // spooling beats moving, since the moved string still pins its bytes in the heap until sent.
+    if (state.load() < Socket::State::SHUTTINGDOWN) {
+        size_t threshold = spoolThresholdBytes.load();
+        if (ssl || (spoolFD < 0 && (!threshold || buffer.size() < threshold)) ||
+            !_spoolAppend(buffer.c_str(), buffer.size())) {
+            sendBuffer += move(buffer);
+        }
+    } else if (!sendBuffer.empty()) {
+        SWARN("Not appending to sendBuffer in socket state " << state.load() << ", tried to send: " << buffer);
+    }
+
+    // Same handshake deferral as above.
+    if (ssl && !SSSLHandshakeComplete(ssl)) {
+        return true;
+    }
+
+    // Same coalescing window as above.
+    uint64_t deadline = sendCoalescingUS.load();
+    if (deadline && lastSendTime + deadline > STimeNow()) {
+        return true;
+    }
+
     // Send anything we've got.
     return send();
 }
 
 bool STCPManager::Socket::sendBufferEmpty() {
     lock_guard<decltype(sendRecvMutex)> lock(sendRecvMutex);
-    return sendBuffer.empty();
+    // An active spool counts as pending data: the poll loop uses this to decide whether to wait for writability,
+    // and the shutdown paths use it to decide whether everything's been sent.
+    return sendBuffer.empty() && spoolFD < 0;
+}
+
+size_t STCPManager::Socket::sendBufferSize() {
+    lock_guard<decltype(sendRecvMutex)> lock(sendRecvMutex);
+    return sendBuffer.size() + (spoolWriteOffset - spoolReadOffset);
 }
 
 string STCPManager::Socket::sendBufferCopy() {
     lock_guard<decltype(sendRecvMutex)> lock(sendRecvMutex);
-    return string(sendBuffer.c_str(), sendBuffer.size());
+    return sendBuffer.toString();
 }
 
 void STCPManager::Socket::setSendBuffer(const string& buffer) {
     lock_guard<decltype(sendRecvMutex)> lock(sendRecvMutex);
+    // This replaces everything pending, which includes anything spooled.
+    _spoolDiscard();
     sendBuffer = buffer;
 }
 
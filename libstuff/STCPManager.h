@@ -7,6 +7,12 @@ struct STCPManager {
     class Socket {
       public:
         enum State { CONNECTING, CONNECTED, SHUTTINGDOWN, CLOSED };
+
+        // Sockets are created and destroyed once per connection, which at high accept rates is enough allocator
+        // churn to be worth recycling through the slab pool (see SSlabPool).
+        static void* operator new(size_t size);
+        static void operator delete(void* ptr, size_t size);
+
         Socket(int sock = 0, State state_ = CONNECTING, SX509* x509 = nullptr);
         ~Socket();
         // Attributes
@@ -22,14 +28,27 @@ struct STCPManager {
         void* data;
         bool send();
         bool send(const string& buffer);
+        bool send(string&& buffer);
+
+        // For payloads sent to several sockets at once (peer broadcasts): the buffer references the shared bytes
+        // instead of copying them, so the payload is serialized and stored once however many sockets it goes to.
+        bool send(const shared_ptr<const string>& buffer);
         bool recv();
         uint64_t id;
         string logString;
 
         bool sendBufferEmpty();
+        size_t sendBufferSize();
         string sendBufferCopy();
         void setSendBuffer(const string& buffer);
 
+        // Size threshold (in bytes) above which an outgoing payload is spooled to an unlinked temp file and sent
+        // with sendfile() rather than held in the in-memory send buffer (see the send() overloads). Caps the
+        // per-socket memory a few oversized responses can pin to roughly this threshold, regardless of how large
+        // the payloads themselves are. Zero (the default) disables spooling. TLS sockets never spool (sendfile
+        // can't feed an encrypted stream).
+        static atomic<size_t> spoolThresholdBytes;
+
         void resetCounters();
         uint64_t getRecvBytes();
         uint64_t getSentBytes();
@@ -43,9 +62,24 @@ struct STCPManager {
         // NOTE: Currently there's no synchronization around `recvBuffer`. It can only be accessed by one thread.
         SFastBuffer sendBuffer;
 
-        // Each socket owns it's own SX509 object to avoid thread-safety issues reading/writing the same certificate in
-        // the underlying ssl code. Once assigned, the socket owns this object for it's lifetime and will delete it
-        // upon destruction.
+        // Spool state for oversized payloads. Once a send crosses `spoolThresholdBytes`, it (and every later send,
+        // to preserve ordering) is appended to an unlinked temp file instead of the send buffer, and send() drains
+        // the file to the socket with sendfile() after the in-memory buffer empties. When the file is fully drained
+        // it's closed and buffering returns to normal. -1 when no spool is active.
+        int spoolFD = -1;
+        off_t spoolReadOffset = 0;
+        off_t spoolWriteOffset = 0;
+
+        // Appends `length` bytes to the spool file, opening it first if there isn't one. Returns false (and spools
+        // nothing) if the file can't be opened or written, in which case the caller falls back to the send buffer.
+        bool _spoolAppend(const char* data, size_t length);
+
+        // Closes and forgets the spool file, discarding anything not yet sent.
+        void _spoolDiscard();
+
+        // The credentials for this socket's TLS context. These days this usually points at the process-wide parse
+        // cache (see SX509Open), which is shared between sockets; the destructor still calls SX509Close, which only
+        // frees uncached objects.
         SX509* _x509;
 
         uint64_t sentBytes;
@@ -59,6 +93,18 @@ struct STCPManager {
     void prePoll(fd_map& fdm);
     void postPoll(fd_map& fdm);
 
+    // Same, but also runs the send coalescing scheduler: if any socket deferred a flush (see Socket::send), caps
+    // `nextActivity` so the next poll wakes up in time to send it within the coalescing deadline.
+    void postPoll(fd_map& fdm, uint64_t& nextActivity);
+
+    // Deadline (in microseconds) for coalescing socket sends. When non-zero, Socket::send() skips the send syscall
+    // if the socket was flushed within this window and leaves the data in the send buffer; under load, several
+    // small responses commonly land within the window and go out in a single syscall (the chained send buffer
+    // already gathers them into one sendmsg). Anything still buffered gets flushed by the poll loop, so the added
+    // latency is bounded by this deadline while the server is busy, which is the only time anything is deferred.
+    // Zero (the default) disables coalescing and sends immediately, exactly as before.
+    static atomic<uint64_t> sendCoalescingUS;
+
     // Opens outgoing socket
     Socket* openSocket(const string& host, SX509* x509 = nullptr, recursive_mutex* listMutexPtr = nullptr);
 
@@ -1,14 +1,27 @@
 #include "libstuff.h"
+#include "SMetrics.h"
 #include <execinfo.h> // for backtrace
+#include <sys/eventfd.h>
 #undef SLOGPREFIX
 #define SLOGPREFIX "{" << name << "} "
 
 STCPNode::STCPNode(const string& name_, const string& host, const vector<Peer*> _peerList, const uint64_t recvTimeout_)
     : STCPServer(host), name(name_), recvTimeout(recvTimeout_), peerList(_peerList), _deserializeTimer("STCPNode::deserialize"),
       _sConsumeFrontTimer("STCPNode::SConsumeFront"), _sAppendTimer("STCPNode::append") {
+    _bulkWakeFD = eventfd(0, EFD_NONBLOCK);
+    SASSERT(_bulkWakeFD != -1);
+    _bulkThread = thread(&STCPNode::_bulkThreadMain, this);
 }
 
 STCPNode::~STCPNode() {
+    // Stop the bulk I/O thread before tearing down any connections.
+    _bulkThreadShouldExit = true;
+    _bulkWake();
+    if (_bulkThread.joinable()) {
+        _bulkThread.join();
+    }
+    close(_bulkWakeFD);
+
     // Clean up all the sockets and peers
     for (Socket* socket : acceptedSocketList) {
         closeSocket(socket);
@@ -98,7 +111,7 @@ void STCPNode::postPoll(fd_map& fdm, uint64_t& nextActivity) {
     // Process the sockets
     {
         AutoTimerTime appendTime(_sAppendTimer);
-        STCPServer::postPoll(fdm);
+        STCPServer::postPoll(fdm, nextActivity);
     }
 
     // Accept any new peers
@@ -125,6 +138,34 @@ void STCPNode::postPoll(fd_map& fdm, uint64_t& nextActivity) {
                 // What is it?
                 socket->recvBuffer.consumeFront(messageSize);
                 if (SIEquals(message.methodLine, "NODE_LOGIN")) {
+                    if (message.test("Bulk")) {
+                        // A sidecar connection for large payloads (see BULK_MESSAGE_MIN_SIZE): verify the name, then
+                        // hand the raw fd (and anything already buffered behind the login) to the bulk I/O thread
+                        // and forget the Socket wrapper.
+                        bool knownName = false;
+                        for (Peer* peer : peerList) {
+                            if (peer->name == message["Name"]) {
+                                knownName = true;
+                                break;
+                            }
+                        }
+                        if (!knownName) {
+                            SWARN("Unauthenticated node '" << message["Name"] << "' attempted to connect a bulk channel, rejecting.");
+                            STHROW("unauthenticated node");
+                        }
+                        SINFO("Attaching incoming bulk channel from '" << message["Name"] << "'");
+                        int fd = socket->s;
+                        socket->s = -1;
+                        {
+                            lock_guard<mutex> lock(_bulkMutex);
+                            _bulkInboundHandoff.push_back(BulkHandoff{fd, message["Name"], socket->recvBuffer.toString()});
+                        }
+                        _bulkWake();
+                        closeSocket(socket);
+                        acceptedSocketList.erase(socketIt);
+                        continue;
+                    }
+
                     // Got it -- can we associate with a peer?
                     bool foundIt = false;
                     for (Peer* peer : peerList) {
@@ -200,8 +241,30 @@ void STCPNode::postPoll(fd_map& fdm, uint64_t& nextActivity) {
                         _sendPING(peer);
                     }
 
+                    // Move staged bulk messages into whatever room the socket's writes just opened up; throws once
+                    // this peer is over its hard cap, tearing the connection down via the catch below.
+                    peer->flushStagedMessages();
+
+                    // If the last thing this peer sent was a handle to a payload still in flight on the bulk
+                    // channel, nothing behind it can be processed without reordering its messages; see if the
+                    // payload has finished reassembling.
+                    if (peer->pendingBulkHandle.methodLine.size()) {
+                        string payload;
+                        if (_takeBulkPayload(peer->name, peer->pendingBulkHandle.calcU64("ID"), payload)) {
+                            SData bulkMessage;
+                            if (!bulkMessage.deserialize(payload)) {
+                                STHROW("malformed bulk payload");
+                            }
+                            peer->pendingBulkHandle.clear();
+                            _processMessage(peer, bulkMessage);
+                        } else if (STimeNow() > peer->pendingBulkWaitStart + recvTimeout) {
+                            STHROW("timed out waiting for bulk payload");
+                        }
+                    }
+
                     // Process all messages
-                    while (AutoTimerTime(_deserializeTimer), (messageSize = message.deserialize(peer->socket->recvBuffer))) {
+                    while (!peer->pendingBulkHandle.methodLine.size() &&
+                           (AutoTimerTime(_deserializeTimer), (messageSize = message.deserialize(peer->socket->recvBuffer)))) {
                         // Which message?
                         {
                             AutoTimerTime consumeTime(_sConsumeFrontTimer);
@@ -209,32 +272,18 @@ void STCPNode::postPoll(fd_map& fdm, uint64_t& nextActivity) {
                         }
                         if (peer->socket->recvBuffer.size() > 10'000) {
                             // Make in known if this buffer ever gets big.
-                            PINFO("Received '" << message.methodLine << "'(size: " << messageSize << ") with " 
+                            PINFO("Received '" << message.methodLine << "'(size: " << messageSize << ") with "
                                   << (peer->socket->recvBuffer.size()) << " bytes remaining in message buffer.");
                         } else {
                             PDEBUG("Received '" << message.methodLine << "'.");
                         }
-                        if (SIEquals(message.methodLine, "PING")) {
-                            // Let's not delay on flushing the PING PONG
-                            // exchanges in case we get blocked before we
-                            // get to flush later.  Pass back the remote
-                            // timestamp of the PING such that the remote
-                            // host can calculate latency.
-                            SINFO("Received PING from peer '" << peer->name << "'. Sending PONG.");
-                            SData pong("PONG");
-                            pong["Timestamp"] = message["Timestamp"];
-                            peer->socket->send(pong.serialize());
-                        } else if (SIEquals(message.methodLine, "PONG")) {
-                            // Recevied the PONG; update our latency estimate for this peer.
-                            // We set a lower bound on this at 1, because even though it should be pretty impossible
-                            // for this to be 0 (it's in us), we rely on it being non-zero in order to connect to
-                            // peers.
-                            peer->latency = max(STimeNow() - message.calc64("Timestamp"), (uint64_t)1);
-                            SINFO("Received PONG from peer '" << peer->name << "' (" << peer->latency/1000 << "ms latency)");
-                        } else {
-                            // Not a PING or PONG; pass to the child class
-                            _onMESSAGE(peer, message);
-                        }
+                        _processMessage(peer, message);
+                    }
+
+                    // If we're parked on a handle, its payload is arriving on a socket the main poll loop doesn't
+                    // watch, so check back shortly rather than waiting for main-channel activity.
+                    if (peer->pendingBulkHandle.methodLine.size()) {
+                        nextActivity = min(nextActivity, STimeNow() + 100 * STIME_US_PER_MS);
                     }
                 } catch (const SException& e) {
                     // Warn if the message is set. Otherwise, the error is that we got no message (we timed out), just
@@ -254,7 +303,7 @@ void STCPNode::postPoll(fd_map& fdm, uint64_t& nextActivity) {
 
             case Socket::CLOSED: {
                 // Done; clean up and try to reconnect
-                uint64_t delay = SRandom::rand64() % (STIME_US_PER_S * 5);
+                uint64_t delay = SRandom::fast64() % (STIME_US_PER_S * 5);
                 if (peer->socket->connectFailure) {
                     PINFO("Peer connection failed after " << (STimeNow() - peer->socket->openTime) / 1000
                                                           << "ms, reconnecting in " << delay / 1000 << "ms");
@@ -314,6 +363,240 @@ void STCPNode::_sendPING(Peer* peer) {
     peer->socket->send(ping.serialize());
 }
 
+void STCPNode::_processMessage(Peer* peer, SData& message) {
+    // If the sender compressed the body (see Peer::serializeMessage), restore it before anything looks at it. A
+    // malformed frame throws, which reconnects the peer like any other bad message.
+    if (message.isSet("Compression")) {
+        if (!SIEquals(message["Compression"], "zstd")) {
+            STHROW("unknown Compression '" + message["Compression"] + "'");
+        }
+        message.content = SZstdDecompress(message.content);
+        message.nameValueMap.erase("Compression");
+    }
+    if (SIEquals(message.methodLine, "BULK_HANDLE")) {
+        // The real message is traveling on the bulk channel. If it's already fully arrived, process it right now in
+        // the handle's place; otherwise park the handle, which stops processing this peer's stream until it shows.
+        string payload;
+        if (_takeBulkPayload(peer->name, message.calcU64("ID"), payload)) {
+            SData bulkMessage;
+            if (!bulkMessage.deserialize(payload)) {
+                STHROW("malformed bulk payload");
+            }
+            _processMessage(peer, bulkMessage);
+        } else {
+            PINFO("Waiting on bulk payload " << message["ID"] << " (" << message["Size"] << " bytes).");
+            peer->pendingBulkHandle = message;
+            peer->pendingBulkWaitStart = STimeNow();
+        }
+    } else if (SIEquals(message.methodLine, "PING")) {
+        // Let's not delay on flushing the PING PONG
+        // exchanges in case we get blocked before we
+        // get to flush later.  Pass back the remote
+        // timestamp of the PING such that the remote
+        // host can calculate latency.
+        SINFO("Received PING from peer '" << peer->name << "'. Sending PONG.");
+        SData pong("PONG");
+        pong["Timestamp"] = message["Timestamp"];
+        peer->socket->send(pong.serialize());
+    } else if (SIEquals(message.methodLine, "PONG")) {
+        // Recevied the PONG; update our latency estimate for this peer.
+        // We set a lower bound on this at 1, because even though it should be pretty impossible
+        // for this to be 0 (it's in us), we rely on it being non-zero in order to connect to
+        // peers.
+        peer->latency = max(STimeNow() - message.calc64("Timestamp"), (uint64_t)1);
+        SINFO("Received PONG from peer '" << peer->name << "' (" << peer->latency/1000 << "ms latency)");
+    } else {
+        // Not a PING or PONG; pass to the child class
+        _onMESSAGE(peer, message);
+    }
+}
+
+void STCPNode::_sendBulkToPeer(Peer* peer, SData message) {
+    uint64_t id = _nextBulkMessageID++;
+    SData payload("BULK_PAYLOAD");
+    payload["ID"] = to_string(id);
+    payload.content = peer->serializeMessage(message);
+    {
+        lock_guard<mutex> lock(_bulkMutex);
+        _bulkSendQueues[peer->host].push_back(payload.serialize());
+    }
+    _bulkWake();
+
+    // The handle holds the payload's position in the main message stream, so per-peer ordering survives the detour.
+    SData handle("BULK_HANDLE");
+    handle["ID"] = to_string(id);
+    handle["Size"] = to_string(payload.content.size());
+    peer->socket->send(handle.serialize());
+}
+
+bool STCPNode::_takeBulkPayload(const string& peerName, uint64_t id, string& payload) {
+    lock_guard<mutex> lock(_bulkMutex);
+    auto payloadIt = _bulkReceivedPayloads.find(make_pair(peerName, id));
+    if (payloadIt == _bulkReceivedPayloads.end()) {
+        return false;
+    }
+    payload = move(payloadIt->second.second);
+    _bulkReceivedPayloads.erase(payloadIt);
+    return true;
+}
+
+void STCPNode::_bulkWake() {
+    uint64_t one = 1;
+    SASSERT(write(_bulkWakeFD, &one, sizeof(one)) == sizeof(one));
+}
+
+void STCPNode::_bulkThreadMain() {
+    SInitialize("bulkio");
+
+    // The connections this thread owns. Outbound are keyed by peer host and opened on demand; inbound arrive from
+    // the accept path in postPoll as raw fds. All fds are non-blocking.
+    struct BulkConnection {
+        int fd = -1;
+        string peerName; // Inbound only: the authenticated peer from the connection's NODE_LOGIN.
+        SFastBuffer recvBuffer;
+        SFastBuffer sendBuffer;
+    };
+    map<string, BulkConnection> outbound;
+    list<BulkConnection> inbound;
+
+    while (!_bulkThreadShouldExit) {
+        // Adopt handed-off inbound connections and collect newly-staged outbound frames, then do the slow work
+        // (opening sockets) outside the lock.
+        list<BulkHandoff> newInbound;
+        map<string, list<string>> newFrames;
+        {
+            lock_guard<mutex> lock(_bulkMutex);
+            newInbound = move(_bulkInboundHandoff);
+            _bulkInboundHandoff.clear();
+            newFrames = move(_bulkSendQueues);
+            _bulkSendQueues.clear();
+
+            // Drop reassembled payloads nobody ever claimed (their peer reconnected before processing the handle).
+            uint64_t now = STimeNow();
+            auto payloadIt = _bulkReceivedPayloads.begin();
+            while (payloadIt != _bulkReceivedPayloads.end()) {
+                if (payloadIt->second.first + 5 * STIME_US_PER_M < now) {
+                    SWARN("Dropping unclaimed bulk payload " << payloadIt->first.second << " from '"
+                          << payloadIt->first.first << "'.");
+                    payloadIt = _bulkReceivedPayloads.erase(payloadIt);
+                } else {
+                    payloadIt++;
+                }
+            }
+        }
+        for (auto& handoff : newInbound) {
+            inbound.emplace_back();
+            inbound.back().fd = handoff.fd;
+            inbound.back().peerName = move(handoff.peerName);
+            if (!handoff.buffered.empty()) {
+                inbound.back().recvBuffer.append(handoff.buffered.data(), handoff.buffered.size());
+            }
+        }
+        for (auto& hostFrames : newFrames) {
+            BulkConnection& connection = outbound[hostFrames.first];
+            if (connection.fd < 0) {
+                // First traffic for this host (or the last connection died); open a fresh one, identifying it as a
+                // bulk channel so the far side hands it to its own bulk thread.
+                connection.fd = S_socket(hostFrames.first, true, false, false);
+                if (connection.fd < 0) {
+                    // The receiver times out on the handle and reconnects the main channel, resyncing anything lost.
+                    SWARN("Couldn't open bulk channel to '" << hostFrames.first << "', dropping "
+                          << hostFrames.second.size() << " payloads.");
+                    outbound.erase(hostFrames.first);
+                    continue;
+                }
+                SData login("NODE_LOGIN");
+                login["Name"] = name;
+                login["Bulk"] = "true";
+                connection.sendBuffer += login.serialize();
+            }
+            for (auto& frame : hostFrames.second) {
+                connection.sendBuffer += move(frame);
+            }
+        }
+
+        // Poll everything we own, plus the wake fd.
+        vector<pollfd> fds;
+        fds.push_back({_bulkWakeFD, POLLIN, 0});
+        for (auto& hostConnection : outbound) {
+            short events = POLLIN;
+            if (!hostConnection.second.sendBuffer.empty()) {
+                events |= POLLOUT;
+            }
+            fds.push_back({hostConnection.second.fd, events, 0});
+        }
+        for (auto& connection : inbound) {
+            fds.push_back({connection.fd, POLLIN, 0});
+        }
+        poll(fds.data(), fds.size(), 1'000);
+
+        // Drain the wake fd; it's just there to interrupt the poll.
+        if (fds[0].revents & POLLIN) {
+            uint64_t ignored;
+            if (read(_bulkWakeFD, &ignored, sizeof(ignored)) != sizeof(ignored)) {
+                SWARN("Couldn't drain bulk wake fd.");
+            }
+        }
+
+        // Flush outbound sends. A dead connection just gets dropped along with anything still buffered for it.
+        size_t fdIndex = 1;
+        auto outboundIt = outbound.begin();
+        while (outboundIt != outbound.end()) {
+            auto current = outboundIt++;
+            pollfd& entry = fds[fdIndex++];
+            bool alive = !(entry.revents & (POLLERR | POLLHUP | POLLNVAL));
+            if (alive && (entry.revents & POLLOUT) && !current->second.sendBuffer.empty()) {
+                alive = S_sendconsume(current->second.fd, current->second.sendBuffer);
+            }
+            if (!alive) {
+                SWARN("Bulk channel to '" << current->first << "' died, dropping "
+                      << current->second.sendBuffer.size() << " buffered bytes.");
+                close(current->second.fd);
+                outbound.erase(current);
+            }
+        }
+
+        // Receive and reassemble inbound payloads.
+        auto inboundIt = inbound.begin();
+        while (inboundIt != inbound.end()) {
+            auto current = inboundIt++;
+            pollfd& entry = fds[fdIndex++];
+            bool alive = !(entry.revents & (POLLERR | POLLNVAL));
+            if (alive && (entry.revents & (POLLIN | POLLHUP))) {
+                alive = S_recvappend(current->fd, current->recvBuffer);
+            }
+            SData payload;
+            int frameSize = 0;
+            while ((frameSize = payload.deserialize(current->recvBuffer))) {
+                current->recvBuffer.consumeFront(frameSize);
+                if (SIEquals(payload.methodLine, "BULK_PAYLOAD")) {
+                    SINFO("Reassembled bulk payload " << payload["ID"] << " from '" << current->peerName << "' ("
+                          << payload.content.size() << " bytes).");
+                    // Assign rather than emplace: a restarted sender's counter starts over, and its fresh payload
+                    // should replace any stale unclaimed one under the same id rather than being dropped.
+                    lock_guard<mutex> lock(_bulkMutex);
+                    _bulkReceivedPayloads[make_pair(current->peerName, payload.calcU64("ID"))] =
+                        make_pair(STimeNow(), move(payload.content));
+                } else {
+                    SWARN("Unexpected '" << payload.methodLine << "' on bulk channel, ignoring.");
+                }
+            }
+            if (!alive) {
+                close(current->fd);
+                inbound.erase(current);
+            }
+        }
+    }
+
+    // Shutting down; close everything we own.
+    for (auto& hostConnection : outbound) {
+        close(hostConnection.second.fd);
+    }
+    for (auto& connection : inbound) {
+        close(connection.fd);
+    }
+}
+
 STCPNode::Peer::Peer(const string& name_, const string& host_, const STable& params_, uint64_t id_)
   : name(name_), host(host_), id(id_), params(params_), permaFollower(isPermafollower(params)),
     commitCount(0),
@@ -327,7 +610,11 @@ STCPNode::Peer::Peer(const string& name_, const string& host_, const STable& par
     subscribed(false),
     transactionResponse(Response::NONE),
     version(),
-    hash()
+    useBinaryMessages(false),
+    useZstdCompression(false),
+    useTemplateEncoding(false),
+    useBulkChannel(false),
+    useSealedResponses(false)
 { }
 
 bool STCPNode::Peer::connected() const {
@@ -346,16 +633,103 @@ void STCPNode::Peer::reset() {
     subscribed = false;
     transactionResponse = Response::NONE;
     version = "";
+    useBinaryMessages = false;
+    useZstdCompression = false;
+    useTemplateEncoding = false;
+    useBulkChannel = false;
+    useSealedResponses = false;
+    pendingBulkHandle.clear();
+    pendingBulkWaitStart = 0;
+    sentQueryTemplates.clear();
+    receivedQueryTemplates.clear();
+    _stagedBulk.clear();
+    _stagedBytes = 0;
+    _congestedSince = 0;
     setCommit(0, "");
 }
 
 void STCPNode::Peer::sendMessage(const SData& message) {
     lock_guard<decltype(_stateMutex)> lock(_stateMutex);
-    if (socket) {
-        socket->send(message.serialize());
-    } else {
+    if (!socket) {
         SWARN("Tried to send " << message.methodLine << " to peer, but not available.");
+        return;
+    }
+
+    // Serialize in whatever wire format this peer negotiated.
+    string frame;
+    if (useZstdCompression && message.content.size() >= COMPRESSION_MIN_SIZE) {
+        // Compression rewrites the message, so this path needs its own copy; small messages skip it.
+        SData messageCopy = message;
+        frame = serializeMessage(messageCopy);
+    } else {
+        frame = useBinaryMessages ? message.serializeBinary() : message.serialize();
     }
+
+    // Control messages (approvals, state changes, PING - anything without a real body) always go straight out:
+    // they're tiny, and writing them ahead of any staged bulk data is exactly the preemption we want. Bulk messages
+    // go straight out too while the socket is keeping up, but once it's over the high watermark - or anything is
+    // already staged, which has to keep its order - they wait for the buffer to drain.
+    const bool bulk = message.content.size() >= COMPRESSION_MIN_SIZE || SIEquals(message.methodLine, "SYNCHRONIZE_RESPONSE");
+    if (bulk && (_stagedBytes || socket->sendBufferSize() > SEND_HIGH_WATERMARK)) {
+        _stagedBytes += frame.size();
+        _stagedBulk.push_back(move(frame));
+        return;
+    }
+    socket->send(move(frame));
+}
+
+void STCPNode::Peer::flushStagedMessages() {
+    lock_guard<decltype(_stateMutex)> lock(_stateMutex);
+    if (!socket) {
+        return;
+    }
+    while (_stagedBytes && socket->sendBufferSize() < SEND_HIGH_WATERMARK) {
+        _stagedBytes -= _stagedBulk.front().size();
+        socket->send(move(_stagedBulk.front()));
+        _stagedBulk.pop_front();
+    }
+
+    // Track how this peer is doing, and give up on the connection entirely past the hard cap: our caller's reconnect
+    // path tears it down, and the peer resynchronizes whatever it missed when it comes back.
+    const size_t queued = _stagedBytes + socket->sendBufferSize();
+    if (queued > SEND_MAX_QUEUED) {
+        STHROW("send queue over hard cap");
+    }
+    if (queued > SEND_HIGH_WATERMARK) {
+        uint64_t expected = 0;
+        if (_congestedSince.compare_exchange_strong(expected, STimeNow())) {
+            SHMMM("Peer '" << name << "' send queue congested (" << queued << " bytes queued).");
+        }
+    } else if (_congestedSince) {
+        SINFO("Peer '" << name << "' send queue drained.");
+        _congestedSince = 0;
+    }
+}
+
+bool STCPNode::Peer::congestedFor(uint64_t durationUS) const {
+    const uint64_t since = _congestedSince;
+    return since && since + durationUS < STimeNow();
+}
+
+string STCPNode::Peer::serializeMessage(SData& message) const {
+    if (useZstdCompression && message.content.size() >= COMPRESSION_MIN_SIZE && !message.isSet("Compression")) {
+        static atomic<uint64_t>& bytesSaved = SMetrics::counter("peerCompression.bytesSaved");
+        static atomic<uint64_t>& compressUS = SMetrics::counter("peerCompression.compressUS");
+        static atomic<uint64_t>& compressedCount = SMetrics::counter("peerCompression.messages");
+        uint64_t start = STimeNow();
+        string compressed = SZstdCompress(message.content);
+        compressUS += STimeNow() - start;
+
+        // Only ship the compressed body if it actually came out smaller (and compression didn't fail, in which case
+        // it's empty); incompressible content goes out as-is, unmarked.
+        if (!compressed.empty() && compressed.size() < message.content.size()) {
+            bytesSaved += message.content.size() - compressed.size();
+            compressedCount++;
+            message["Compression"] = "zstd";
+            message.content = move(compressed);
+        }
+    }
+    return useBinaryMessages ? message.serializeBinary() : message.serialize();
 }
 
 void STCPNode::Peer::closeSocket(STCPManager* manager) {
@@ -385,15 +759,47 @@ string STCPNode::Peer::responseName(Response response) {
 }
 
 void STCPNode::Peer::setCommit(uint64_t count, const string& hashString) {
-    lock_guard<decltype(_stateMutex)> lock(_stateMutex);
+    // Claim the sequence by making it odd. Writers serialize on this (they're nearly always just the sync thread,
+    // but reset() can race it), and readers copying mid-update see the odd value and retry.
+    uint64_t seq = _commitSeq.load();
+    do {
+        while (seq % 2) {
+            seq = _commitSeq.load();
+        }
+    } while (!_commitSeq.compare_exchange_weak(seq, seq + 1));
     const_cast<atomic<uint64_t>&>(commitCount) = count;
-    hash = hashString;
+    _hashSize = min(hashString.size(), HASH_BUFFER_SIZE);
+    if (hashString.size() > HASH_BUFFER_SIZE) {
+        SWARN("Peer hash '" << hashString << "' doesn't fit the hash buffer, truncating.");
+    }
+    memcpy(_hashBuffer, hashString.data(), _hashSize);
+    _commitSeq.store(seq + 2);
 }
 
-void STCPNode::Peer::getCommit(uint64_t& count, string& hashString) {
-    lock_guard<decltype(_stateMutex)> lock(_stateMutex);
-    count = commitCount.load();
-    hashString = hash.load();
+void STCPNode::Peer::getCommit(uint64_t& count, string& hashString) const {
+    // Copy the pair, then confirm the sequence didn't move while we did; if it did, a writer overlapped us and we
+    // go again. Readers never block and never allocate beyond the output string itself.
+    while (true) {
+        uint64_t seqBefore = _commitSeq.load();
+        if (seqBefore % 2) {
+            continue;
+        }
+        count = commitCount.load();
+        char buffer[HASH_BUFFER_SIZE];
+        size_t size = min(_hashSize, HASH_BUFFER_SIZE);
+        memcpy(buffer, _hashBuffer, size);
+        if (_commitSeq.load() == seqBefore) {
+            hashString.assign(buffer, size);
+            return;
+        }
+    }
+}
+
+string STCPNode::Peer::getHash() const {
+    uint64_t ignored;
+    string hashString;
+    getCommit(ignored, hashString);
+    return hashString;
 }
 
 STable STCPNode::Peer::getData() const {
@@ -409,11 +815,12 @@ STable STCPNode::Peer::getData() const {
         {"loggedIn", (loggedIn ? "true" : "false")},
         {"priority", to_string(priority)},
         {"version", version},
-        {"hash", hash},
+        {"hash", getHash()},
         {"commitCount", to_string(commitCount)},
         {"standupResponse", responseName(standupResponse)},
         {"transactionResponse", responseName(transactionResponse)},
         {"subscribed", (subscribed ? "true" : "false")},
+        {"congestedSince", to_string(_congestedSince.load())},
     });
 
     // And anything from the params (note: doesn't overwrite our standard stuff).
@@ -99,6 +99,62 @@ struct STCPNode : public STCPServer {
         atomic<Response> transactionResponse;
         atomic<string> version;
 
+        // True once this peer has advertised (in its LOGIN message) that it understands the binary SData wire format,
+        // at which point we send it binary frames instead of text. Receiving auto-detects either format, so this only
+        // gates what we send. Negotiated per-connection: cleared on reset().
+        atomic<bool> useBinaryMessages;
+
+        // True once this peer has advertised (in its LOGIN message) that it can decompress zstd message bodies, at
+        // which point serializeMessage compresses any content at or above COMPRESSION_MIN_SIZE. Receiving is gated
+        // by the `Compression` header on each message, so like useBinaryMessages this only affects what we send.
+        // Negotiated per-connection: cleared on reset().
+        atomic<bool> useZstdCompression;
+
+        // True once this peer has advertised (in its LOGIN message) that it understands template-encoded replicated
+        // transactions (a statement shape registered once per connection, subsequent sends carrying just the shape's
+        // id and the literal values). Negotiated per-connection: cleared on reset().
+        atomic<bool> useTemplateEncoding;
+
+        // True once this peer has advertised (in its LOGIN message) that it accepts bulk-channel transfers, at which
+        // point any message with content at or above BULK_MESSAGE_MIN_SIZE travels on the sidecar connection instead
+        // of the main one (see _sendBulkToPeer). Negotiated per-connection: cleared on reset().
+        atomic<bool> useBulkChannel;
+
+        // True once this peer has advertised (in its LOGIN message) that it forwards sealed escalation responses
+        // verbatim, at which point we send it pre-serialized response bytes (with fixed-width slots reserved for the
+        // headers it patches) instead of an SData it would reparse. Negotiated per-connection: cleared on reset().
+        atomic<bool> useSealedResponses;
+
+        // When the last message received from this peer was a BULK_HANDLE whose payload hasn't finished arriving on
+        // the bulk channel yet, the handle parks here and nothing further from this peer is processed (its message
+        // order must be preserved) until the payload shows up. Main poll thread only; cleared on reset().
+        SData pendingBulkHandle;
+        uint64_t pendingBulkWaitStart = 0;
+
+        // Template-encoding bookkeeping, both scoped to this connection and cleared on reset() so both ends forget
+        // together on reconnect. `sentQueryTemplates` holds the template ids we've already registered with this peer
+        // (we're the sender); `receivedQueryTemplates` maps ids this peer has registered with us to their shape text
+        // (we're the receiver). Only ever touched by the sync thread, so unsynchronized.
+        set<uint64_t> sentQueryTemplates;
+        map<uint64_t, string> receivedQueryTemplates;
+
+        // Don't bother compressing content below this size; the frame overhead and CPU aren't worth it.
+        static const size_t COMPRESSION_MIN_SIZE = 1024;
+
+        // Send-queue backpressure: once this much buffered-but-unsent data has accumulated on the socket, bulk
+        // messages are staged in `_stagedBulk` instead of being written behind it, so control traffic keeps jumping
+        // ahead of the backlog.
+        static const size_t SEND_HIGH_WATERMARK = 4 * 1024 * 1024;
+
+        // Hard cap on buffered plus staged bytes for one peer. Past this the connection is torn down (the peer
+        // resynchronizes on reconnect) rather than letting one bad link grow our memory without bound.
+        static const size_t SEND_MAX_QUEUED = 256 * 1024 * 1024;
+
+        // Serialize a message for this peer, in whatever wire format it negotiated. If the peer supports it and the
+        // content is large enough, the content is zstd-compressed and the message marked with a `Compression`
+        // header; the receiving node undoes this before dispatch. Mutates `message`, so callers pass a local copy.
+        string serializeMessage(SData& message) const;
+
         // Constructor.
         Peer(const string& name_, const string& host_, const STable& params_, uint64_t id_);
 
@@ -106,7 +162,10 @@ struct STCPNode : public STCPServer {
         void setCommit(uint64_t count, const string& hashString);
 
         // Atomically get commit and hash.
-        void getCommit(uint64_t& count, string& hashString);
+        void getCommit(uint64_t& count, string& hashString) const;
+
+        // Returns just the hash corresponding to commitCount.
+        string getHash() const;
 
         // Gets an STable representation of this peer's current state in order to display status info.
         STable getData() const;
@@ -120,15 +179,35 @@ struct STCPNode : public STCPServer {
         // Close the peer's socket. Thread-safe.
         void closeSocket(STCPManager* manager);
 
-        // Send a message to this peer. Thread-safe.
+        // Send a message to this peer. Thread-safe. Small control messages (approvals, state changes, PING) are
+        // written to the socket immediately; bulk messages (synchronization and replication payloads) are staged
+        // once the socket buffer is over SEND_HIGH_WATERMARK and flushed as it drains, so a slow peer's backlog
+        // can't delay its own control traffic.
         void sendMessage(const SData& message);
 
+        // Writes staged bulk messages into the socket while it's under the high watermark, and tracks congestion.
+        // Called from the main poll loop every cycle. Throws an SException when this peer is over SEND_MAX_QUEUED,
+        // so the caller's normal reconnect path tears the connection down.
+        void flushStagedMessages();
+
+        // True when this peer's send queue has been congested (over the high watermark) continuously for at least
+        // `durationUS`. Such a peer can't receive a transaction or respond to it in a timely way, so SQLiteNode
+        // stops waiting on it in quorum decisions (its vote still counts if it does arrive).
+        bool congestedFor(uint64_t durationUS) const;
+
         // Get a string name for a Response object.
         static string responseName(Response response);
 
       private:
-        // The hash corresponding to commitCount.
-        atomic<string> hash;
+        // The hash corresponding to commitCount, as a fixed-size buffer under a sequence lock rather than an
+        // atomic<string>: setCommit runs on every received peer message and getCommit many times per sync loop
+        // iteration, and the string version paid two mutexes and a heap copy per call. Writers bump `_commitSeq`
+        // to an odd value, update commitCount and the buffer, then bump it even again; readers copy and retry
+        // until the sequence reads the same even value on both sides, so they never block and never allocate.
+        static const size_t HASH_BUFFER_SIZE = 64;
+        char _hashBuffer[HASH_BUFFER_SIZE];
+        size_t _hashSize = 0;
+        atomic<uint64_t> _commitSeq{0};
 
         // This allows direct access to the socket from the node object that should actually be managing peer
         // connections, which should always be handled by a single thread, and thus safe. Ideally, this isn't required,
@@ -140,6 +219,15 @@ struct STCPNode : public STCPServer {
         // Mutex for locking around non-atomic member access (for set/getCommit, accessing socket, etc).
         mutable recursive_mutex _stateMutex;
 
+        // Serialized bulk frames waiting for socket buffer room, oldest first, and their total size. Under
+        // _stateMutex; cleared on reset() since staged frames die with the connection.
+        deque<string> _stagedBulk;
+        size_t _stagedBytes = 0;
+
+        // When this peer's send queue first went over the high watermark, or 0 while it's keeping up. Atomic so
+        // congestedFor can read it without _stateMutex.
+        atomic<uint64_t> _congestedSince{0};
+
         // For initializing the permafollower value from the params list.
         static bool isPermafollower(const STable& params);
     };
@@ -163,6 +251,14 @@ struct STCPNode : public STCPServer {
     // Called when the peer sends us a message; throw an SException to reconnect.
     virtual void _onMESSAGE(Peer* peer, const SData& message) = 0;
 
+    // Messages with content at or above this size don't travel down the main peer connection, where receiving and
+    // parsing a multi-megabyte frame stalls every message queued behind it. Instead the sender ships a small
+    // BULK_HANDLE in the message's place and the bytes themselves move on a second per-host connection owned by a
+    // dedicated I/O thread. The receiver's poll loop holds that one peer's message stream at the handle until the
+    // payload has been reassembled, preserving per-peer ordering without making any other peer (or the poll loop
+    // itself) wait on the elephant.
+    static const size_t BULK_MESSAGE_MIN_SIZE = 1024 * 1024;
+
   protected:
     // Returns a peer by it's ID. If the ID is invalid, returns nullptr.
     Peer* getPeerByID(uint64_t id);
@@ -170,6 +266,11 @@ struct STCPNode : public STCPServer {
     // Inverse of the above function. If the peer is not found, returns 0.
     uint64_t getIDByPeer(Peer* peer);
 
+    // Ships `message` to this peer over the bulk channel: queues the serialized payload for the bulk I/O thread and
+    // sends a BULK_HANDLE on the main socket so the message keeps its position in the stream. The caller must have
+    // verified the peer has a socket and negotiated the channel. Thread-safe.
+    void _sendBulkToPeer(Peer* peer, SData message);
+
   private:
     // Override dead function
     void postPoll(fd_map& ignore) { SERROR("Don't call."); }
@@ -177,6 +278,44 @@ struct STCPNode : public STCPServer {
     // Helper functions
     void _sendPING(Peer* peer);
 
+    // Shared receive-side handling for one parsed message: decompression, PING/PONG, BULK_HANDLE parking, and
+    // dispatch to _onMESSAGE. Main poll thread only.
+    void _processMessage(Peer* peer, SData& message);
+
+    // Looks up (and removes) a fully-reassembled inbound bulk payload by the sending peer and handle id. IDs come
+    // from each sender's own counter, so they're only unique per peer; requiring the handle's peer to match the
+    // payload's keeps concurrent senders from colliding and keeps one peer's handle from ever claiming a payload
+    // that arrived on another peer's authenticated channel.
+    bool _takeBulkPayload(const string& peerName, uint64_t id, string& payload);
+
+    // The bulk I/O thread: owns every bulk connection (inbound ones are handed over from the accept path, outbound
+    // ones it opens on demand) and moves their bytes with its own poll loop, so the main poll loop never touches
+    // them. A dead bulk connection just drops its in-flight payloads; the receiver times out waiting on the handle
+    // and reconnects the main channel, which resynchronizes anything lost.
+    void _bulkThreadMain();
+    void _bulkWake();
+    thread _bulkThread;
+    atomic<bool> _bulkThreadShouldExit = {false};
+    int _bulkWakeFD = -1;
+    atomic<uint64_t> _nextBulkMessageID = {1};
+
+    // An inbound bulk connection handed over by the accept path: the raw fd, the authenticated peer name from its
+    // NODE_LOGIN, and whatever arrived behind the login.
+    struct BulkHandoff {
+        int fd;
+        string peerName;
+        string buffered;
+    };
+
+    // Shared with the bulk thread, all under _bulkMutex: outbound frames staged by sender threads, inbound
+    // connections handed over by the accept path, and reassembled payloads waiting for their handle to be
+    // processed, keyed by (sending peer, sender-assigned id) and timestamped so orphans from reconnected peers can
+    // be dropped.
+    mutex _bulkMutex;
+    map<string, list<string>> _bulkSendQueues;
+    list<BulkHandoff> _bulkInboundHandoff;
+    map<pair<string, uint64_t>, pair<uint64_t, string>> _bulkReceivedPayloads;
+
     AutoTimer _deserializeTimer;
     AutoTimer _sConsumeFrontTimer;
     AutoTimer _sAppendTimer;
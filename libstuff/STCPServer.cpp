@@ -12,12 +12,24 @@ STCPServer::~STCPServer() {
     closePorts();
 }
 
-STCPServer::Port* STCPServer::openPort(const string& host) {
+STCPServer::Port* STCPServer::openPort(const string& host, bool reusePort) {
     // Open a port on the requested host
     SASSERT(SHostIsValid(host));
     Port port;
     port.host = host;
-    port.s = S_socket(host, true, true, false);
+    port.s = S_socket(host, true, true, false, reusePort);
+    SASSERT(port.s >= 0);
+    lock_guard <decltype(portListMutex)> lock(portListMutex);
+    list<Port>::iterator portIt = portList.insert(portList.end(), port);
+    return &*portIt;
+}
+
+STCPServer::Port* STCPServer::openUnixPort(const string& path) {
+    // Same plumbing as openPort, but listening on a unix domain socket at `path` instead of a TCP host. Accepted
+    // connections flow through acceptSocket and the socket list just like TCP ones.
+    Port port;
+    port.host = path;
+    port.s = S_unixSocket(path);
     SASSERT(port.s >= 0);
     lock_guard <decltype(portListMutex)> lock(portListMutex);
     list<Port>::iterator portIt = portList.insert(portList.end(), port);
@@ -49,9 +61,12 @@ void STCPServer::closePorts(list<Port*> except) {
 STCPManager::Socket* STCPServer::acceptSocket(Port*& portOut) {
     // Initialize to 0 in case we don't accept anything. Note that this *does* overwrite the passed-in pointer.
     portOut = 0;
-    Socket* socket = nullptr;
 
-    // See if we can accept on any port
+    // See if we can accept on any port. We return as soon as we've accepted one connection, so that when several
+    // ports are ready at once the caller's drain loop (`while (acceptSocket(port))`) sees every socket paired with
+    // the port it arrived on; callers keep calling until we come up empty, which is when every listener has hit
+    // EAGAIN for this wakeup. The socket arrives from S_accept already non-blocking and tuned, so there's no
+    // per-connection fixup left to do here beyond wrapping it.
     lock_guard <decltype(portListMutex)> lock(portListMutex);
     for (Port& port : portList) {
         // Try to accept on the port and wrap in a socket
@@ -60,7 +75,7 @@ STCPManager::Socket* STCPServer::acceptSocket(Port*& portOut) {
         if (s > 0) {
             // Received a socket, wrap
             SDEBUG("Accepting socket from '" << addr << "' on port '" << port.host << "'");
-            socket = new Socket(s, Socket::CONNECTED);
+            Socket* socket = new Socket(s, Socket::CONNECTED);
             socket->addr = addr;
             socketList.push_back(socket);
 
@@ -69,10 +84,11 @@ STCPManager::Socket* STCPServer::acceptSocket(Port*& portOut) {
 
             // Record what port it was accepted on
             portOut = &port;
+            return socket;
         }
     }
 
-    return socket;
+    return nullptr;
 }
 
 void STCPServer::prePoll(fd_map& fdm) {
@@ -91,3 +107,9 @@ void STCPServer::postPoll(fd_map& fdm) {
     // FIXME: Detect port failure
     STCPManager::postPoll(fdm);
 }
+
+void STCPServer::postPoll(fd_map& fdm, uint64_t& nextActivity) {
+    // Same, but with the send coalescing scheduler.
+    // FIXME: Detect port failure
+    STCPManager::postPoll(fdm, nextActivity);
+}
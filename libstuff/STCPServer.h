@@ -16,8 +16,14 @@ struct STCPServer : public STCPManager {
     // Destructor
     virtual ~STCPServer();
 
-    // Begins listening on a new port
-    Port* openPort(const string& host);
+    // Begins listening on a new port. With `reusePort`, the socket is opened with SO_REUSEPORT, so several sockets
+    // (typically one per acceptor thread) can listen on the same port and let the kernel spread connections across
+    // them; every socket bound to the port must set the flag.
+    Port* openPort(const string& host, bool reusePort = false);
+
+    // Begins listening on a unix domain socket at the given filesystem path, for same-host clients that want to skip
+    // loopback TCP. Accepted connections are handled identically to TCP ones.
+    Port* openUnixPort(const string& path);
 
     // Closes all open ports, allowing for exceptions.
     void closePorts(list<Port*> except = {});
@@ -32,6 +38,7 @@ struct STCPServer : public STCPManager {
     // Updates all managed ports and sockets
     void prePoll(fd_map& fdm);
     void postPoll(fd_map& fdm);
+    void postPoll(fd_map& fdm, uint64_t& nextActivity);
 
     // Attributes
     list<Port> portList;
@@ -17,6 +17,23 @@ string SComposeTime(const string& format, uint64_t when) {
     return string(buf, length);
 }
 
+// --------------------------------------------------------------------------
+string SUNQUOTED_TIMESTAMP(uint64_t when) {
+    // Per-thread cache of the last second formatted. Thread-local rather than shared so the hot path has no
+    // synchronization at all, and gmtime_r rather than SComposeTime's gmtime so a cache miss doesn't race other
+    // threads on the static tm.
+    thread_local time_t cachedSecond = -1;
+    thread_local char cached[20] = {};
+    const time_t second = (time_t)(when / STIME_US_PER_S);
+    if (second != cachedSecond) {
+        struct tm parts;
+        gmtime_r(&second, &parts);
+        strftime(cached, sizeof(cached), "%Y-%m-%d %H:%M:%S", &parts);
+        cachedSecond = second;
+    }
+    return string(cached);
+}
+
 // --------------------------------------------------------------------------
 int SDaysInMonth(int year, int month) {
     // 30 days hath September...
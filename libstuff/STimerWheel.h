@@ -0,0 +1,176 @@
+#pragma once
+#include <libstuff/libstuff.h>
+
+// A hierarchical timer wheel. Timers are bucketed by expiration time into fixed arrays of slots: a near wheel at
+// millisecond granularity, and progressively coarser wheels behind it (256ms, ~65s, ~4.7h per slot), covering about
+// 50 days in total; anything further out parks in the farthest slot and re-buckets as time passes. Registration and
+// cancellation are O(1) (plus a scan of one short slot), where the multimaps this replaces were O(log n) under a
+// single lock for every operation.
+//
+// Timers don't fire on their own: callers advance the wheel by passing the current time to `peekExpired` or
+// `popExpired`, which is how every user of this class already polls (the sync loop, and queue front()/pop()).
+// Expiration order is preserved to slot granularity: entries expiring in the same millisecond may pop in either
+// order, which no caller depends on.
+//
+// This class does no internal synchronization; callers guard it with whatever lock guards the structure the timers
+// point into.
+template <typename T>
+class STimerWheel {
+  public:
+    STimerWheel() : _lastTick(STimeNow() / TICK_US), _size(0) {}
+
+    // Registers `value` to expire at `whenUS` (epoch microseconds). Times in the past expire immediately.
+    void insert(uint64_t whenUS, const T& value) {
+        _slotFor(whenUS / TICK_US)->push_back(Entry{whenUS, value});
+        _size++;
+    }
+
+    // Removes the entry registered with exactly this time and value, whether or not it's already expired. Returns
+    // whether anything was removed.
+    bool cancel(uint64_t whenUS, const T& value) {
+        // Which level an entry is in depends on how far the wheel had advanced when it was inserted, not on the
+        // current delta: cascades only re-bucket when a level rolls over, so an entry can sit in a coarser level
+        // than its remaining time implies. Its slot index *within* each level depends only on the expiration tick,
+        // though, so the entry is either expired, in its tick's slot at one of the levels, or far-parked.
+        uint64_t tick = whenUS / TICK_US;
+        if (_removeFrom(_expired, whenUS, value)) {
+            return true;
+        }
+        for (int level = 0; level < LEVELS; level++) {
+            if (_removeFrom(_slots[level][(tick >> (SLOT_BITS * level)) & (SLOTS - 1)], whenUS, value)) {
+                return true;
+            }
+        }
+
+        // Entries parked beyond the wheel's range land in a top-level slot computed from the insert-time tick
+        // rather than their own, so a parked entry can be in any top-level slot. The slots are lists, so walking
+        // the (mostly empty) level is cheap, and anything close enough to have re-bucketed was found above.
+        for (int slot = 0; slot < SLOTS; slot++) {
+            if (_removeFrom(_slots[LEVELS - 1][slot], whenUS, value)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Advances the wheel to `nowUS` and, if any timer has expired, fills in its time and value and returns true.
+    bool peekExpired(uint64_t nowUS, uint64_t& whenOut, T& valueOut) {
+        _advance(nowUS);
+        if (_expired.empty()) {
+            return false;
+        }
+        whenOut = _expired.front().when;
+        valueOut = _expired.front().value;
+        return true;
+    }
+
+    // Same, but removes the expired entry.
+    bool popExpired(uint64_t nowUS, uint64_t& whenOut, T& valueOut) {
+        if (!peekExpired(nowUS, whenOut, valueOut)) {
+            return false;
+        }
+        _expired.pop_front();
+        _size--;
+        return true;
+    }
+
+    // Removes all timers without advancing.
+    void clear() {
+        for (auto& level : _slots) {
+            for (auto& slot : level) {
+                slot.clear();
+            }
+        }
+        _expired.clear();
+        _size = 0;
+    }
+
+    size_t size() const { return _size; }
+    bool empty() const { return !_size; }
+
+  private:
+    static const uint64_t TICK_US = 1000; // Near-wheel granularity: 1ms.
+    static const int SLOT_BITS = 8;
+    static const int SLOTS = 1 << SLOT_BITS; // 256 slots per level.
+    static const int LEVELS = 4;
+
+    struct Entry {
+        uint64_t when;
+        T value;
+    };
+
+    // Removes the first entry in `slot` matching this time and value, if any.
+    bool _removeFrom(list<Entry>& slot, uint64_t whenUS, const T& value) {
+        for (auto it = slot.begin(); it != slot.end(); it++) {
+            if (it->when == whenUS && it->value == value) {
+                slot.erase(it);
+                _size--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Returns the slot an entry expiring at `tick` currently belongs in. Entries at or before the current tick are
+    // due, and live in the expired list.
+    list<Entry>* _slotFor(uint64_t tick) {
+        if (tick <= _lastTick) {
+            return &_expired;
+        }
+        uint64_t delta = tick - _lastTick;
+        for (int level = 0; level < LEVELS; level++) {
+            if (delta < ((uint64_t)1 << (SLOT_BITS * (level + 1)))) {
+                return &_slots[level][(tick >> (SLOT_BITS * level)) & (SLOTS - 1)];
+            }
+        }
+
+        // Too far out for the wheel to represent; park it in the farthest slot and it'll re-bucket as time passes.
+        uint64_t farTick = _lastTick + ((uint64_t)1 << (SLOT_BITS * LEVELS)) - 1;
+        return &_slots[LEVELS - 1][(farTick >> (SLOT_BITS * (LEVELS - 1))) & (SLOTS - 1)];
+    }
+
+    void _advance(uint64_t nowUS) {
+        uint64_t targetTick = nowUS / TICK_US;
+        if (targetTick <= _lastTick) {
+            return;
+        }
+
+        // If there's nothing in the wheel itself, we can jump straight to the present.
+        if (_size == _expired.size()) {
+            _lastTick = targetTick;
+            return;
+        }
+
+        // Otherwise, step through the ticks. Callers advance every poll/sync cycle, so this is normally a handful of
+        // ticks; empty ticks cost an increment and an empty splice.
+        while (_lastTick < targetTick) {
+            _lastTick++;
+            uint64_t index = _lastTick & (SLOTS - 1);
+
+            // When a level rolls over, pull the newly-current slot of the level above down into the finer wheels.
+            if (index == 0) {
+                for (int level = 1; level < LEVELS; level++) {
+                    uint64_t levelIndex = (_lastTick >> (SLOT_BITS * level)) & (SLOTS - 1);
+                    list<Entry> pending;
+                    pending.swap(_slots[level][levelIndex]);
+                    for (Entry& entry : pending) {
+                        _slotFor(entry.when / TICK_US)->push_back(move(entry));
+                    }
+
+                    // Only cascade further up if this level also rolled over.
+                    if (levelIndex != 0) {
+                        break;
+                    }
+                }
+            }
+
+            // Everything in the now-current near slot is due.
+            _expired.splice(_expired.end(), _slots[0][index]);
+        }
+    }
+
+    list<Entry> _slots[LEVELS][SLOTS];
+    list<Entry> _expired;
+    uint64_t _lastTick;
+    size_t _size;
+};
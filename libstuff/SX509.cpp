@@ -1,6 +1,15 @@
 #include "libstuff.h"
 #include <mbedtls/certs.h>
 
+// Process-wide cache of parsed certificates and keys, keyed by the PEM inputs. A process uses a handful of distinct
+// credential sets but opens a TLS connection (and so, historically, re-parsed all three PEMs) per HTTPS request; the
+// parsed mbedtls objects are immutable once loaded, so we parse each set once and hand every caller the same object.
+// SX509Close on a cached object is a no-op - the cache keeps it warm for the next connection.
+namespace {
+    map<string, SX509*> _x509Cache;
+    mutex _x509CacheMutex;
+}
+
 // --------------------------------------------------------------------------
 SX509* SX509Open() {
     // Initialize with defaults
@@ -9,6 +18,16 @@ SX509* SX509Open() {
 
 // --------------------------------------------------------------------------
 SX509* SX509Open(const string& pem, const string& srvCrt, const string& caCrt) {
+    // If we've parsed this credential set before, hand out the cached copy.
+    string cacheKey = pem + "|" + srvCrt + "|" + caCrt;
+    {
+        lock_guard<mutex> lock(_x509CacheMutex);
+        auto it = _x509Cache.find(cacheKey);
+        if (it != _x509Cache.end()) {
+            return it->second;
+        }
+    }
+
     // Use either the supplied credentials, or defaults for testing
     const char* pemPtr = (pem.empty() ? mbedtls_test_srv_key : pem.c_str());
     const char* srvCrtPtr = (srvCrt.empty() ? mbedtls_test_srv_crt : srvCrt.c_str());
@@ -29,7 +48,16 @@ SX509* SX509Open(const string& pem, const string& srvCrt, const string& caCrt) {
         if (mbedtls_x509_crt_parse(&x509->srvcert, (unsigned char*)caCrtPtr, (int)strlen(caCrtPtr) + 1)) {
             STHROW("parsing CA certificate");
         }
-        return x509;
+
+        // Parsed clean; cache it for the next caller. If another thread beat us to it, use theirs and toss ours.
+        x509->cached = true;
+        lock_guard<mutex> lock(_x509CacheMutex);
+        auto result = _x509Cache.emplace(cacheKey, x509);
+        if (!result.second) {
+            x509->cached = false;
+            SX509Close(x509);
+        }
+        return result.first->second;
     } catch (const SException& e) {
         // Failed
         SWARN("X509 creation failed while '" << e.what() << "', cancelling.");
@@ -40,6 +68,11 @@ SX509* SX509Open(const string& pem, const string& srvCrt, const string& caCrt) {
 
 // --------------------------------------------------------------------------
 void SX509Close(SX509* x509) {
+    // Cached certificates are shared process-wide and stay warm for the next connection, so closing them is a no-op.
+    if (x509->cached) {
+        return;
+    }
+
     // Clean up
     mbedtls_x509_crt_free(&x509->srvcert);
     mbedtls_pk_free(&x509->pk);
@@ -7,9 +7,15 @@ struct SX509 {
     // Attributes
     mbedtls_x509_crt srvcert;
     mbedtls_pk_context pk;
+
+    // Whether this object lives in the process-wide parse cache. Cached objects are shared between connections and
+    // never freed; SX509Close on them is a no-op.
+    bool cached = false;
 };
 
-// X509 Certificates
+// X509 Certificates. SX509Open parses each distinct credential set once and returns the same (immutable) object to
+// every caller after that, so opening a connection doesn't re-parse the PEMs. Callers still pair every SX509Open
+// with an SX509Close, which only frees uncached objects.
 extern SX509* SX509Open();
 extern SX509* SX509Open(const string& pem, const string& srvCrt, const string& caCrt);
 extern void SX509Close(SX509* x509);
@@ -4,18 +4,31 @@
 #include "libstuff.h"
 #include <sys/stat.h>
 #include <zlib.h>
+#include <zstd.h>
 
 #include <mbedtls/aes.h>
 #include <mbedtls/base64.h>
 #include <mbedtls/sha1.h>
 #include <mbedtls/sha256.h>
 
+#include <libstuff/SCryptoAccel.h>
+
 // Additional headers
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include <netdb.h>
+#include <netinet/tcp.h>
+#include <sched.h>
+#include <sys/un.h>
 #include <sys/time.h>
+#include <sys/resource.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <dirent.h>
+#ifndef __APPLE__
+#include <sys/epoll.h>
+#endif
 #ifdef __APPLE__
 // Apple specific tweaks
 #include <sys/types.h>
@@ -62,6 +75,83 @@
 thread_local string SThreadLogPrefix;
 thread_local string SThreadLogName;
 
+// Per-thread allocation counter, maintained by the replacement global allocation functions below. A plain
+// zero-initialized thread_local integer needs no dynamic initialization, so it's safe to bump even for allocations
+// made before main() or during thread startup.
+static thread_local uint64_t _threadAllocationCount = 0;
+
+void* operator new(size_t size) {
+    _threadAllocationCount++;
+    void* ptr = malloc(size);
+    if (!ptr) {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    _threadAllocationCount++;
+    void* ptr = malloc(size);
+    if (!ptr) {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+
+uint64_t SGetAllocationCount() {
+    return _threadAllocationCount;
+}
+
+uint64_t SGetPeakRSS() {
+    // ru_maxrss is in kilobytes on Linux (bytes on OS X).
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return (uint64_t)usage.ru_maxrss;
+#else
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+int SNUMANodeCount() {
+    // Nodes are numbered consecutively from 0, so count until one's missing.
+    int count = 0;
+    while (SFileExists("/sys/devices/system/node/node" + to_string(count))) {
+        count++;
+    }
+    return count ? count : 1;
+}
+
+bool SBindThreadToNUMANode(int node) {
+#ifdef __APPLE__
+    return false;
+#else
+    // The node's CPU list is a comma-separated set of ranges, e.g. "0-15,32-47".
+    string cpuList;
+    if (!SFileLoad("/sys/devices/system/node/node" + to_string(node) + "/cpulist", cpuList)) {
+        return false;
+    }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    int cpuCount = 0;
+    for (const string& range : SParseList(STrim(cpuList))) {
+        size_t dash = range.find('-');
+        int first = SToInt(range);
+        int last = (dash == string::npos) ? first : SToInt(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, &cpus);
+            cpuCount++;
+        }
+    }
+    return cpuCount && !sched_setaffinity(0, sizeof(cpus), &cpus);
+#endif
+}
+
 void SInitialize(string threadName, const char* processName) {
     // If a specific process name has been supplied, initialize syslog with it.
     if (processName) {
@@ -358,6 +448,29 @@ string SEscape(const char* lhs, const string& unsafe, char escaper) {
     return working;
 }
 
+// --------------------------------------------------------------------------
+void SAppendQuoted(string& out, const char* val, size_t length) {
+    // Reserve for the common case of a value with nothing to escape: the two enclosing quotes plus the bytes.
+    out.reserve(out.size() + length + 2);
+    out += '\'';
+
+    // Copy clean spans wholesale, doubling each quote character as it's found. memchr does the scanning, so the
+    // typical quote-free value is a single scan and a single bulk copy rather than a byte-at-a-time loop.
+    const char* at = val;
+    const char* end = val + length;
+    while (at < end) {
+        const char* quote = static_cast<const char*>(memchr(at, '\'', end - at));
+        if (!quote) {
+            out.append(at, end - at);
+            break;
+        }
+        out.append(at, quote - at);
+        out += "''";
+        at = quote + 1;
+    }
+    out += '\'';
+}
+
 // --------------------------------------------------------------------------
 string SUnescape(const char* lhs, char escaper) {
     // Fix all escaped values
@@ -628,10 +741,11 @@ const char* _SParseHTTP_GetUpToNext(const char* start, const char* lineEnd, char
     while (*start == ' ')
         ++start;
 
-    // Look for the separator
-    const char* end = start;
-    while ((end < lineEnd) && (*end != separator))
-        ++end;
+    // Look for the separator; memchr so the scan is vectorized.
+    const char* end = start < lineEnd ? (const char*)memchr(start, separator, lineEnd - start) : nullptr;
+    if (!end) {
+        end = lineEnd;
+    }
     const char* separatorPos = end;
 
     // Found the separator, trim off any trailing whitespace
@@ -665,26 +779,62 @@ void _SParseHTTP_GetUpToEnd(const char* start, const char* end, string& out) {
     }
 }
 
+// --------------------------------------------------------------------------
+// Returns a pointer to the first '\r' or '\n' in [start, end), or `end` if there isn't one. memchr so the search is
+// vectorized by libc instead of running a byte at a time.
+static const char* _SParseHTTP_FindLineEnd(const char* start, const char* end) {
+    const char* newline = (const char*)memchr(start, '\n', end - start);
+    const char* searchEnd = newline ? newline : end;
+    const char* carriageReturn = (const char*)memchr(start, '\r', searchEnd - start);
+    if (carriageReturn) {
+        return carriageReturn;
+    }
+    return newline ? newline : end;
+}
+
 // --------------------------------------------------------------------------
 int SParseHTTP(const char* buffer, size_t length, string& methodLine, STable& nameValueMap, string& content) {
-    // Clear the output
-    methodLine.clear();
-    nameValueMap.clear();
+    // Stateless compatibility wrapper: parse with throwaway resume state.
+    SHTTPParseState state;
+    return SParseHTTP(buffer, length, methodLine, nameValueMap, content, state);
+}
+
+// --------------------------------------------------------------------------
+int SParseHTTP(const char* buffer, size_t length, string& methodLine, STable& nameValueMap, string& content,
+               SHTTPParseState& state) {
+    // If a previous attempt already parsed the headers and knows the total message size, there's nothing to do
+    // until that much has arrived.
+    if (state.neededBytes && length < state.neededBytes) {
+        methodLine.clear();
+        nameValueMap.clear();
+        content.clear();
+        return 0;
+    }
+
+    // Resume from wherever the last attempt left off (the start, with nothing parsed, for a fresh buffer).
+    methodLine = state.methodLine;
+    nameValueMap = state.nameValueMap;
     content.clear();
 
     // Keep parsing until we run out of input or encounter a blank line
-    const char* lineStart = buffer;
+    const char* lineStart = buffer + state.parsedOffset;
     const char* inputEnd = buffer + length;
-    string name;
+    string name = state.lastHeaderName;
     bool isChunked = false;
     bool lastChunkFound = false;
     while (lineStart < inputEnd) {
         // Find the end of the line
-        const char* lineEnd = lineStart;
-        while ((lineEnd < inputEnd) && (*lineEnd != '\r') && (*lineEnd != '\n'))
-            ++lineEnd;
+        const char* lineEnd = _SParseHTTP_FindLineEnd(lineStart, inputEnd);
         if (lineEnd >= inputEnd) {
-            // Couldn't find end of line; couldn't complete parsing.
+            // Couldn't find end of line; couldn't complete parsing. Record how far we got -- but only while still
+            // in the header block, since a chunked body rebuilds `content` from the blank line on every attempt --
+            // so the next attempt resumes here instead of rescanning everything parsed so far.
+            if (!isChunked) {
+                state.parsedOffset = lineStart - buffer;
+                state.methodLine = move(methodLine);
+                state.nameValueMap = move(nameValueMap);
+                state.lastHeaderName = move(name);
+            }
             methodLine.clear();
             nameValueMap.clear();
             content.clear();
@@ -707,6 +857,7 @@ int SParseHTTP(const char* buffer, size_t length, string& methodLine, STable& na
                     int numEOLs = 2;
                     while (parseEnd < inputEnd && (*parseEnd == '\r' || *parseEnd == '\n') && numEOLs--)
                         ++parseEnd;
+                    state.clear();
                     return (int)(parseEnd - buffer);
                 }
 
@@ -724,12 +875,17 @@ int SParseHTTP(const char* buffer, size_t length, string& methodLine, STable& na
                     int contentLength = (SContains(nameValueMap, "Content-Length")
                                              ? atoi(nameValueMap["Content-Length"].c_str())
                                              : 0);
-                    if (!contentLength)
+                    if (!contentLength) {
+                        state.clear();
                         return headerLength;
+                    }
 
-                    // There is a content length -- if we don't have enough, then cancel the parse.
+                    // There is a content length -- if we don't have enough, then cancel the parse. Record the total
+                    // size needed so subsequent attempts bail out immediately, without re-parsing the headers, until
+                    // it has all arrived.
                     if ((int)(length - headerLength) < contentLength) {
                         // Insufficient content
+                        state.neededBytes = headerLength + contentLength;
                         methodLine.clear();
                         nameValueMap.clear();
                         content.clear();
@@ -739,6 +895,7 @@ int SParseHTTP(const char* buffer, size_t length, string& methodLine, STable& na
                     // We have enough data -- copy it and return the full length
                     content.resize(contentLength);
                     memcpy(&content[0], parseEnd, contentLength);
+                    state.clear();
                     return (headerLength + contentLength);
                 }
 
@@ -851,13 +1008,144 @@ int SParseHTTP(const char* buffer, size_t length, string& methodLine, STable& na
             SWARN("How did we get here?");
     }
 
-    // Reached the end of the input and haven't finished parsing the header
+    // Reached the end of the input and haven't finished parsing the header; record our progress (see above).
+    if (!isChunked) {
+        state.parsedOffset = lineStart - buffer;
+        state.methodLine = move(methodLine);
+        state.nameValueMap = move(nameValueMap);
+        state.lastHeaderName = move(name);
+    }
     methodLine.clear();
     nameValueMap.clear();
     content.clear();
     return 0;
 }
 
+// --------------------------------------------------------------------------
+// Trims leading/trailing spaces from [start, end) and returns the result as a view.
+static string_view _SParseHTTPView_Trim(const char* start, const char* end) {
+    while (start < end && *start == ' ')
+        ++start;
+    while (end > start && *(end - 1) == ' ')
+        --end;
+    return string_view(start, end - start);
+}
+
+// --------------------------------------------------------------------------
+int SParseHTTPView(const char* buffer, size_t length, string_view& methodLine,
+                   vector<pair<string_view, string_view>>& headers, string_view& content) {
+    // Clear the output
+    methodLine = string_view();
+    headers.clear();
+    content = string_view();
+
+    // Keep parsing until we run out of input or encounter a blank line. This mirrors SParseHTTP, except that
+    // anything requiring us to *transform* the input (chunk reassembly, header folding, unescaping) makes us bail
+    // out so the caller can use the copying parser; we can only point at bytes, not rewrite them.
+    const char* lineStart = buffer;
+    const char* inputEnd = buffer + length;
+    while (lineStart < inputEnd) {
+        // Find the end of the line
+        const char* lineEnd = _SParseHTTP_FindLineEnd(lineStart, inputEnd);
+        if (lineEnd >= inputEnd) {
+            // Couldn't find end of line; couldn't complete parsing.
+            break;
+        }
+
+        // Found the end of the line; is the line blank?
+        if (lineEnd == lineStart) {
+            // Blank line -- if we have at least the method, then we're done. Otherwise, ignore.
+            if (!methodLine.empty()) {
+                // Figure out the end of the headers by consuming up to 2 EOL characters.
+                const char* parseEnd = lineEnd;
+                int numEOLs = 2;
+                while (parseEnd < inputEnd && (*parseEnd == '\r' || *parseEnd == '\n') && numEOLs--)
+                    ++parseEnd;
+                size_t headerLength = parseEnd - buffer;
+
+                // Find the content length, if any.
+                size_t contentLength = 0;
+                for (const auto& header : headers) {
+                    if (header.first.size() == 14 && !strncasecmp(header.first.data(), "Content-Length", 14)) {
+                        for (char c : header.second) {
+                            if (!isdigit(c))
+                                break;
+                            contentLength = contentLength * 10 + (c - '0');
+                        }
+                        break;
+                    }
+                }
+
+                // If we don't have the whole content yet, cancel the parse.
+                if (length - headerLength < contentLength) {
+                    break;
+                }
+
+                // Done -- the content is a view over the body, no copy.
+                content = string_view(parseEnd, contentLength);
+                return (int)(headerLength + contentLength);
+            }
+        } else {
+            // Not blank. Is this the method line?
+            if (methodLine.empty()) {
+                // Everything in the line is the method
+                methodLine = _SParseHTTPView_Trim(lineStart, lineEnd);
+            } else if (isspace(*lineStart)) {
+                // A folded continuation line -- the copying parser appends these to the previous value, which we
+                // can't express as a view. Fall back.
+                break;
+            } else {
+                // Parse name/value pair. Name is everything up to the ':'.
+                const char* colon = (const char*)memchr(lineStart, ':', lineEnd - lineStart);
+                if (!colon) {
+                    colon = lineEnd;
+                }
+                string_view name = _SParseHTTPView_Trim(lineStart, colon);
+                if (!name.empty()) {
+                    string_view value = colon < lineEnd ? _SParseHTTPView_Trim(colon + 1, lineEnd) : string_view();
+
+                    // The copying parser unescapes values, accumulates repeated Set-Cookie headers, and reassembles
+                    // chunked bodies. We can't do any of those without copying, so fall back for all of them.
+                    if (value.find('\\') != string_view::npos) {
+                        break;
+                    }
+                    if (name.size() == 17 && !strncasecmp(name.data(), "Transfer-Encoding", 17)) {
+                        break;
+                    }
+                    bool repeatedSetCookie = false;
+                    if (name.size() == 10 && !strncasecmp(name.data(), "Set-Cookie", 10)) {
+                        for (const auto& header : headers) {
+                            if (header.first.size() == 10 && !strncasecmp(header.first.data(), "Set-Cookie", 10)) {
+                                repeatedSetCookie = true;
+                                break;
+                            }
+                        }
+                    }
+                    if (repeatedSetCookie) {
+                        break;
+                    }
+                    headers.emplace_back(name, value);
+                }
+            }
+        }
+
+        // Consume the end of the line -- accept \r\n, \n\r, \r, or \n. But *not* \n\n (that's two endings)
+        lineStart = lineEnd;
+        if (inputEnd - lineStart >= 2 && lineStart[0] == '\r' && lineStart[1] == '\n')
+            lineStart += 2;
+        else if (inputEnd - lineStart >= 2 && lineStart[0] == '\n' && lineStart[1] == '\r')
+            lineStart += 2;
+        else
+            ++lineStart;
+    }
+
+    // Incomplete, or something the view parser can't represent.
+    methodLine = string_view();
+    headers.clear();
+    content = string_view();
+    return 0;
+}
+
 // --------------------------------------------------------------------------
 bool SParseRequestMethodLine(const string& methodLine, string& method, string& uri) {
     // Clear the input
@@ -1026,6 +1314,7 @@ bool SParseURIPath(const char* buffer, int length, string& path, STable& nameVal
 // --------------------------------------------------------------------------
 void SComposeHTTP(string& buffer, const string& methodLine, const STable& nameValueMap, const string& content) {
     bool tryGzip = false;
+    bool tryZstd = false;
 
     // Just walk across and compose a valid HTTP-like message
     buffer.clear();
@@ -1045,17 +1334,21 @@ void SComposeHTTP(string& buffer, const string& methodLine, const STable& nameVa
             // Ignore Content-Length; will be generated fresh later
         } else if (SIEquals("Content-Encoding", item.first) && SIEquals("gzip", item.second)) {
             tryGzip = !content.empty();
+        } else if (SIEquals("Content-Encoding", item.first) && SIEquals("zstd", item.second)) {
+            tryZstd = !content.empty();
         } else {
             buffer += item.first + ": " + SEscape(item.second, "\r\n\t") + "\r\n";
         }
     }
 
-    const string gzipContent = tryGzip ? SGZip(content) : "";
-    const bool gzipSuccess = !gzipContent.empty();
-    const string& finalContent = gzipSuccess ? gzipContent : content;
+    // Compress the body if an encoding was requested; if compression fails, fall back to sending it plain (with no
+    // Content-Encoding header).
+    const string compressedContent = tryGzip ? SGZip(content) : (tryZstd ? SZstdCompress(content) : "");
+    const bool compressSuccess = !compressedContent.empty();
+    const string& finalContent = compressSuccess ? compressedContent : content;
 
-    if (gzipSuccess) {
-        buffer += "Content-Encoding: gzip\r\n";
+    if (compressSuccess) {
+        buffer += string("Content-Encoding: ") + (tryGzip ? "gzip" : "zstd") + "\r\n";
     }
 
     // Always add a Content-Length, even if no content, so there is no ambiguity
@@ -1167,16 +1460,87 @@ string SDecodeURIComponent(const char* buffer, int length) {
     return working;
 }
 
+// --------------------------------------------------------------------------
+// Appends one string value to JSON output, escaping the same set SEscape was historically given here: all control
+// characters (not just the white-space ones), DEL, quote, backslash, and forward slash. Clean bytes are the
+// overwhelmingly common case, so instead of testing each byte against the escape set we scan for the next byte
+// needing an escape -- 16 at a time where SSE2 is available -- and bulk-append the untouched run before it.
+// Like SEscape (which walked a C string), this stops at an embedded NUL. Non-static so SQResult's serializer can
+// escape cells straight into its output.
+void _SAppendJSONEscaped(string& out, string_view value) {
+    const char* ptr = value.data();
+    const char* end = ptr + value.size();
+    while (ptr < end) {
+        // Find the end of the clean run starting here.
+        const char* runEnd = ptr;
+#ifdef __SSE2__
+        while (end - runEnd >= 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i*)runEnd);
+            // Bytes at or below 0x1f (controls and NUL, compared unsigned via min), plus the named offenders.
+            __m128i needsEscape = _mm_cmpeq_epi8(_mm_min_epu8(chunk, _mm_set1_epi8(0x1f)), chunk);
+            needsEscape = _mm_or_si128(needsEscape, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')));
+            needsEscape = _mm_or_si128(needsEscape, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')));
+            needsEscape = _mm_or_si128(needsEscape, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('/')));
+            needsEscape = _mm_or_si128(needsEscape, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(0x7f)));
+            int mask = _mm_movemask_epi8(needsEscape);
+            if (mask) {
+                runEnd += __builtin_ctz(mask);
+                break;
+            }
+            runEnd += 16;
+        }
+#endif
+        while (runEnd < end) {
+            unsigned char c = *runEnd;
+            if (c <= 0x1f || c == 0x7f || c == '"' || c == '\\' || c == '/') {
+                break;
+            }
+            ++runEnd;
+        }
+
+        // Append the clean run, then escape the offender (if we didn't just run off the end).
+        out.append(ptr, runEnd - ptr);
+        if (runEnd == end) {
+            return;
+        }
+        const char c = *runEnd;
+        if (!c) {
+            // Embedded NUL terminates the value, as it always has.
+            return;
+        }
+        out += '\\';
+        if (c == '\b') {
+            out += 'b';
+        } else if (c == '\f') {
+            out += 'f';
+        } else if (c == '\n') {
+            out += 'n';
+        } else if (c == '\r') {
+            out += 'r';
+        } else if (c == '\t') {
+            out += 't';
+        } else if (c > 0x00 && c < 0x20) {
+            const char* hexChars = "0123456789abcdef";
+            out += "u00";
+            out += hexChars[(c >> 4) & 0xf];
+            out += hexChars[c & 0xf];
+        } else {
+            out += c;
+        }
+        ptr = runEnd + 1;
+    }
+}
+
 // --------------------------------------------------------------------------
 extern const char* _SParseJSONValue(const char* ptr, const char* end, string& value, bool populateValue);
 
 string SToJSON(const string& value, const bool forceString) {
     // Is it an integer?
-    if (SToStr(SToInt64(value.c_str())) == value) {
+    if (SToStr(SToInt64(value)) == value) {
         return value;
     }
     // Is it a float?
-    if (SToStr(SToFloat(value.c_str())) == value) {
+    if (SToStr(SToFloat(value)) == value) {
         return value;
     }
 
@@ -1203,24 +1567,36 @@ string SToJSON(const string& value, const bool forceString) {
     }
 
     // Otherwise, it's a string -- escape and return
-    // We need to escape all control characters in the string, not just the
-    // white-space control characters.
-    return "\"" + SEscape(value, "\x01\x02\x03\x04\x05\x06\x07\b\t\n\x0b\f\r\x0e\x0f\x10\x11"
-                                 "\x12\x13\x14\x15\x16\x17\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f\x7f\"\\/",
-                          '\\') +
-           "\"";
+    string working;
+    working.reserve(value.size() + 2);
+    working += '"';
+    _SAppendJSONEscaped(working, value);
+    working += '"';
+    return working;
 }
 
 // --------------------------------------------------------------------------
 string SComposeJSONObject(const STable& nameValueMap, const bool forceString) {
     if (nameValueMap.empty())
         return "{}";
-    string working = "{";
-    for (pair<string, string> item : nameValueMap) {
-        working += "\"" + item.first + "\":" + SToJSON(item.second, forceString) + ",";
+
+    // Size the output once up front: names, values, and a few bytes of punctuation each. Values that get escaped
+    // or quoted can run a little over; that just means one late growth instead of reallocating all the way up.
+    size_t estimate = 2;
+    for (const auto& item : nameValueMap) {
+        estimate += item.first.size() + item.second.size() + 6;
     }
-    working.resize(working.size() - 1);
-    working += "}";
+    string working;
+    working.reserve(estimate);
+    working += '{';
+    for (const auto& item : nameValueMap) {
+        working += '"';
+        working += item.first;
+        working += "\":";
+        working += SToJSON(item.second, forceString);
+        working += ',';
+    }
+    working[working.size() - 1] = '}';
     return working;
 }
 
@@ -1260,6 +1636,7 @@ const char* _SParseJSONString(const char* ptr, const char* end, string& out, boo
     _JSONWS();
     _JSONTEST('"');
     const char* strStart = ptr;
+    bool sawEscape = false;
     for (; ptr < end && *ptr; ++ptr) {
         // Found the end of this string
         if (*ptr == '"')
@@ -1267,15 +1644,59 @@ const char* _SParseJSONString(const char* ptr, const char* end, string& out, boo
 
         // We want to skip all escaped characters so we don't mistakenly count
         // an escaped double-quote as the actual end.
-        else if (*ptr == '\\')
+        else if (*ptr == '\\') {
+            sawEscape = true;
             ++ptr;
+        }
     }
     _JSONTEST('"');
 
     if (populateOut) {
-        string strOut(strStart, ptr - strStart - 1);
-        out += SUnescape(strOut.c_str(), '\\');
+        if (!sawEscape) {
+            // Nothing to unescape (the common case) -- take the bytes as they are.
+            out.append(strStart, ptr - strStart - 1);
+        } else {
+            string strOut(strStart, ptr - strStart - 1);
+            out += SUnescape(strOut.c_str(), '\\');
+        }
+    }
+    return ptr;
+}
+
+// --------------------------------------------------------------------------
+// As _SParseJSONString, but produces a view of the string's raw contents (without the surrounding quotes, and
+// still escaped) rather than unescaping a copy.
+static const char* _SParseJSONStringView(const char* ptr, const char* end, string_view& out) {
+    SASSERT(ptr && end);
+    SASSERT(*ptr);
+    _JSONWS();
+    _JSONTEST('"');
+    const char* strStart = ptr;
+    for (; ptr < end && *ptr; ++ptr) {
+        if (*ptr == '"')
+            break;
+        else if (*ptr == '\\')
+            ++ptr;
     }
+    _JSONTEST('"');
+    out = string_view(strStart, ptr - strStart - 1);
+    return ptr;
+}
+
+// --------------------------------------------------------------------------
+// As _SParseJSONValue, but produces a view of the value rather than a copy: the raw contents for a string, and
+// the full serialized text for anything else. Non-static so SQResult's deserializer can parse cells without
+// copying them through intermediate strings.
+const char* _SParseJSONValueView(const char* ptr, const char* end, string_view& value) {
+    _JSONWS();
+    if (*ptr == '"') {
+        return _SParseJSONStringView(ptr, end, value);
+    }
+    const char* valueStart = ptr;
+    string ignore;
+    ptr = _SParseJSONValue(ptr, end, ignore, false);
+    _JSONASSERTPTR(); // Make sure no parse error.
+    value = string_view(valueStart, ptr - valueStart);
     return ptr;
 }
 
@@ -1297,7 +1718,7 @@ const char* _SParseJSONArray(const char* ptr, const char* end, list<string>& out
         ptr = _SParseJSONValue(ptr, end, value, populateOut);
         _JSONASSERTPTR(); // Make sure no parse error.
         if (populateOut)
-            out.push_back(value);
+            out.push_back(move(value));
         _JSONLOG();
 
         // See if we're done
@@ -1400,16 +1821,16 @@ const char* _SParseJSONValue(const char* ptr, const char* end, string& value, bo
                 ++ptr;
 
             // Maybe a float value?
-            if (*ptr == '.') {
+            if (ptr < end && *ptr == '.') {
                 ++ptr;
                 while (ptr < end && isdigit(*ptr))
                     ++ptr;
             }
 
             // Maybe a scientific notation value?
-            if (*ptr == 'e' || *ptr == 'E') {
+            if (ptr < end && (*ptr == 'e' || *ptr == 'E')) {
                 ++ptr;
-                if (*ptr == '-' || *ptr == '+')
+                if (ptr < end && (*ptr == '-' || *ptr == '+'))
                     ++ptr;
                 while (ptr < end && isdigit(*ptr))
                     ++ptr;
@@ -1419,17 +1840,17 @@ const char* _SParseJSONValue(const char* ptr, const char* end, string& value, bo
                 value.resize(ptr - numStart);
                 memcpy(&value[0], numStart, ptr - numStart);
             }
-        } else if (!strncmp(ptr, "true", 4)) {
+        } else if (end - ptr >= 4 && !strncmp(ptr, "true", 4)) {
             // Found boolean true
             if (populateValue)
                 value = "true";
             ptr += 4; // strlen(true)
-        } else if (!strncmp(ptr, "false", 5)) {
+        } else if (end - ptr >= 5 && !strncmp(ptr, "false", 5)) {
             // Found boolean false
             if (populateValue)
                 value = "false";
             ptr += 5; // strlen(false)
-        } else if (!strncmp(ptr, "null", 4)) {
+        } else if (end - ptr >= 4 && !strncmp(ptr, "null", 4)) {
             // Found null
             if (populateValue)
                 value = "null";
@@ -1486,54 +1907,187 @@ list<string> SParseJSONArray(const string& array) {
 }
 
 // --------------------------------------------------------------------------
-string SGZip(const string& content) {
-    z_stream stream;
+// The view-producing twins of _SParseJSONObject/_SParseJSONArray: same structure and strictness, but entries view
+// into the input instead of being copied out of it.
+static const char* _SParseJSONObjectView(const char* ptr, const char* end, vector<pair<string_view, string_view>>& out) {
+    SASSERT(ptr && end);
+    SASSERT(*ptr);
+    _JSONWS();
+    _JSONTEST('{');
+    _JSONWS();
+    if (*ptr == '}')
+        return ptr + 1; // Empty object
+    while (true) {
+        // Find the name
+        _JSONWS();
+        string_view name;
+        ptr = _SParseJSONStringView(ptr, end, name);
+        _JSONASSERTPTR(); // Make sure no parse error.
+        _JSONWS();
+        _JSONTEST(':');
 
-    stream.zalloc = Z_NULL;
-    stream.zfree = Z_NULL;
-    stream.opaque = Z_NULL;
+        // Find the value
+        _JSONWS();
+        string_view value;
+        ptr = _SParseJSONValueView(ptr, end, value);
+        _JSONASSERTPTR(); // Make sure no parse error.
+        out.emplace_back(name, value);
 
-    stream.next_in = (unsigned char*)content.c_str();
-    stream.avail_in = (unsigned int)content.size();
+        // See if we're done
+        _JSONWS();
+        if (*ptr == '}')
+            return ptr + 1; // Finished this object
+        _JSONTEST(',');
+    }
+}
 
-    int GZIP_ENCODING = 16;
+static const char* _SParseJSONArrayView(const char* ptr, const char* end, vector<string_view>& out) {
+    SASSERT(ptr && end);
+    SASSERT(*ptr);
+    _JSONWS();
+    _JSONTEST('[');
+    _JSONWS();
+    if (*ptr == ']')
+        return ptr + 1; // Empty array
+    while (true) {
+        // Find the value
+        _JSONWS();
+        string_view value;
+        ptr = _SParseJSONValueView(ptr, end, value);
+        _JSONASSERTPTR(); // Make sure no parse error.
+        out.push_back(value);
 
-    unsigned int bufferSize = stream.avail_in + (stream.avail_in / 1000) + 20;
-    unsigned char* outBuffer = new unsigned char[bufferSize];
+        // See if we're done
+        _JSONWS();
+        if (*ptr == ']')
+            return ptr + 1; // Done
+        _JSONTEST(',');
+    }
+}
 
-    stream.avail_out = bufferSize;
-    stream.next_out = outBuffer;
+// --------------------------------------------------------------------------
+vector<pair<string_view, string_view>> SParseJSONObjectView(string_view object) {
+    vector<pair<string_view, string_view>> out;
+    if (object.size() < 2)
+        return out;
+    const char* ptr = object.data();
+    const char* end = ptr + object.size();
+    const char* parseEnd = _SParseJSONObjectView(ptr, end, out);
 
-    int status = deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, MAX_WBITS | GZIP_ENCODING, MAX_MEM_LEVEL,
-                              Z_DEFAULT_STRATEGY);
+    // Trim trailing whitespace
+    while (parseEnd && parseEnd < end && *parseEnd && isspace(*parseEnd))
+        ++parseEnd;
 
-    if (status != Z_OK) {
-        SHMMM("failed to initialize a GZip context");
-        return "";
+    // Did we parse it all?  If not, return nothing.
+    if (parseEnd < end) {
+        out.clear();
     }
+    return out;
+}
 
-    status = deflate(&stream, Z_FINISH);
-    if (status != Z_STREAM_END && status != Z_OK) {
-        SHMMM("We deflated but we didn't get Z_STREAM_END or Z_OK, we got " << status);
-        deflateEnd(&stream);
-        if (status == Z_OK) {
-            status = Z_BUF_ERROR;
+// --------------------------------------------------------------------------
+vector<string_view> SParseJSONArrayView(string_view array) {
+    vector<string_view> out;
+    if (array.size() < 2)
+        return out;
+    const char* ptr = array.data();
+    const char* end = ptr + array.size();
+    const char* parseEnd = _SParseJSONArrayView(ptr, end, out);
+    if (parseEnd != end) { // Did not parse it all.
+        out.clear();
+    }
+    return out;
+}
+
+// --------------------------------------------------------------------------
+// Initializing a deflate stream allocates a couple hundred KB of internal state, which is pure overhead when
+// compressing many small response bodies, so each thread keeps one stream and resets it between uses.
+struct SGZipContext {
+    z_stream stream;
+    bool initialized = false;
+    ~SGZipContext() {
+        if (initialized) {
+            deflateEnd(&stream);
         }
-    } else {
-        status = deflateEnd(&stream);
     }
+};
+static thread_local SGZipContext _gzipContext;
+
+// Returns the calling thread's deflate stream, initialized (first use) or reset and ready for a new message, or
+// null on failure.
+static z_stream* _SGZipBegin() {
+    static const int GZIP_ENCODING = 16;
+    z_stream& stream = _gzipContext.stream;
+    if (!_gzipContext.initialized) {
+        memset(&stream, 0, sizeof(stream));
+        if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, MAX_WBITS | GZIP_ENCODING, MAX_MEM_LEVEL,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            SHMMM("failed to initialize a GZip context");
+            return nullptr;
+        }
+        _gzipContext.initialized = true;
+    } else if (deflateReset(&stream) != Z_OK) {
+        SHMMM("failed to reset the GZip context");
+        return nullptr;
+    }
+    return &stream;
+}
 
-    string result;
-    result.append((char*)outBuffer, stream.total_out);
+string SGZip(const string& content) {
+    z_stream* stream = _SGZipBegin();
+    if (!stream) {
+        return "";
+    }
 
-    delete[] outBuffer;
+    stream->next_in = (unsigned char*)content.c_str();
+    stream->avail_in = (unsigned int)content.size();
 
-    if (status == Z_OK) {
-        return result;
-    } else {
-        SHMMM("GZip operation failed status:" << status);
+    // deflateBound guarantees a single Z_FINISH pass completes.
+    string result;
+    result.resize(deflateBound(stream, content.size()));
+    stream->next_out = (unsigned char*)&result[0];
+    stream->avail_out = (unsigned int)result.size();
+
+    int status = deflate(stream, Z_FINISH);
+    if (status != Z_STREAM_END) {
+        SHMMM("We deflated but we didn't get Z_STREAM_END, we got " << status);
         return "";
     }
+
+    result.resize(stream->total_out);
+    return result;
+}
+
+bool SGZipStream(const SFastBuffer& content, SFastBuffer& out) {
+    z_stream* stream = _SGZipBegin();
+    if (!stream) {
+        return false;
+    }
+
+    // Feed the buffer's segments through deflate one at a time (with a final no-input pass to finish the stream),
+    // writing compressed output in bounded chunks straight into `out`'s tail, so neither the input nor the output
+    // ever needs to be a single contiguous copy.
+    vector<struct iovec> iov(content.segmentCount());
+    const int count = content.gather(iov.data(), (int)iov.size());
+    for (int i = 0; i <= count; i++) {
+        const bool last = i == count;
+        stream->next_in = last ? nullptr : (unsigned char*)iov[i].iov_base;
+        stream->avail_in = last ? 0 : (unsigned int)iov[i].iov_len;
+        int status = Z_OK;
+        do {
+            static const size_t CHUNK = 64 * 1024;
+            char* tail = out.writableTail(CHUNK);
+            stream->next_out = (unsigned char*)tail;
+            stream->avail_out = CHUNK;
+            status = deflate(stream, last ? Z_FINISH : Z_NO_FLUSH);
+            out.commit(CHUNK - stream->avail_out);
+            if (status == Z_STREAM_ERROR) {
+                SHMMM("GZip stream failed, status:" << status);
+                return false;
+            }
+        } while (stream->avail_in || (last && status != Z_STREAM_END));
+    }
+    return true;
 }
 
 string SGUnzip (const string& content) {
@@ -1584,12 +2138,50 @@ string SGUnzip (const string& content) {
     return data;
 }
 
+// The process-wide default zstd level. 3 is zstd's own default, and a good tradeoff between ratio and the CPU we can
+// afford on the peer send path.
+static atomic<int> _SZstdLevel(3);
+
+void SZstdSetCompressionLevel(int level) {
+    _SZstdLevel.store(level);
+}
+
+string SZstdCompress(const string& content, int level) {
+    if (!level) {
+        level = _SZstdLevel.load();
+    }
+    string compressed;
+    compressed.resize(ZSTD_compressBound(content.size()));
+    size_t size = ZSTD_compress(&compressed[0], compressed.size(), content.data(), content.size(), level);
+    if (ZSTD_isError(size)) {
+        SHMMM("Zstd compression failed: " << ZSTD_getErrorName(size));
+        return "";
+    }
+    compressed.resize(size);
+    return compressed;
+}
+
+string SZstdDecompress(const string& content) {
+    // Zstd frames record their decompressed size, so we can allocate the output exactly once.
+    unsigned long long originalSize = ZSTD_getFrameContentSize(content.data(), content.size());
+    if (originalSize == ZSTD_CONTENTSIZE_ERROR || originalSize == ZSTD_CONTENTSIZE_UNKNOWN) {
+        STHROW("malformed zstd frame");
+    }
+    string decompressed;
+    decompressed.resize(originalSize);
+    size_t size = ZSTD_decompress(&decompressed[0], decompressed.size(), content.data(), content.size());
+    if (ZSTD_isError(size) || size != originalSize) {
+        STHROW("zstd decompression failed");
+    }
+    return decompressed;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // Socket helpers
 /////////////////////////////////////////////////////////////////////////////
 
 // --------------------------------------------------------------------------
-int S_socket(const string& host, bool isTCP, bool isPort, bool isBlocking) {
+int S_socket(const string& host, bool isTCP, bool isPort, bool isBlocking, bool reusePort) {
     // Try to set up the socket
     int s = 0;
     try {
@@ -1603,36 +2195,9 @@ int S_socket(const string& host, bool isTCP, bool isPort, bool isBlocking) {
         // Is the domain just a raw IP?
         unsigned int ip = inet_addr(domain.c_str());
         if (!ip || ip == INADDR_NONE) {
-            // Nope -- resolve the domain
-            uint64_t start = STimeNow();
-
-            // Allocate and initialize addrinfo structures.
-            struct addrinfo hints;
-            memset(&hints, 0, sizeof hints);
-            struct addrinfo* resolved = nullptr;
-
-            // Set up the hints.
-            hints.ai_family = AF_INET; // IPv4
-            hints.ai_socktype = SOCK_STREAM;
-
-            // Do the initialization.
-            int result = getaddrinfo(domain.c_str(), to_string(port).c_str(), &hints, &resolved);
-            SINFO("DNS lookup took " << (STimeNow() - start) / 1000 << "ms for '" << domain << "'.");
-
-            // There was a problem.
-            if (result || !resolved) {
-                freeaddrinfo(resolved);
-                STHROW("can't resolve host error no#" + result);
-            }
-            // Grab the resolved address.
-            sockaddr_in* addr = (sockaddr_in*)resolved->ai_addr;
-            ip = addr->sin_addr.s_addr;
-            char plainTextIP[INET_ADDRSTRLEN];
-            inet_ntop(AF_INET, &addr->sin_addr, plainTextIP, INET_ADDRSTRLEN);
-            SINFO("Resolved " << domain << " to ip: " << plainTextIP << ".");
-
-            // Done resolving.
-            freeaddrinfo(resolved);
+            // Nope -- resolve it through the process-wide cache, which only blocks on the resolver the first time
+            // it sees a name (see SDNSCache).
+            ip = SDNSCache::resolve(domain);
         }
 
         // Open a socket
@@ -1658,6 +2223,13 @@ int S_socket(const string& host, bool isTCP, bool isPort, bool isBlocking) {
             if (setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (char*)&enable, sizeof(enable)))
                 STHROW("couldn't set REUSEADDR");
 
+            // If requested, also allow several sockets to bind this same port; the kernel then load-balances
+            // incoming connections across all of them.
+#ifdef SO_REUSEPORT
+            if (reusePort && setsockopt(s, SOL_SOCKET, SO_REUSEPORT, (char*)&enable, sizeof(enable)))
+                STHROW("couldn't set REUSEPORT");
+#endif
+
             // Bind to the configured port
             sockaddr_in addr;
             memset(&addr, 0, sizeof(addr));
@@ -1705,6 +2277,51 @@ int S_socket(const string& host, bool isTCP, bool isPort, bool isBlocking) {
     }
 }
 
+int S_unixSocket(const string& path) {
+    // Try to set up the socket
+    int s = 0;
+    try {
+        if (path.empty() || path.size() >= sizeof(sockaddr_un::sun_path)) {
+            STHROW("invalid unix socket path: " + path);
+        }
+
+        // Open a socket
+        s = (int)socket(AF_UNIX, SOCK_STREAM, 0);
+        if (!s || s == -1)
+            STHROW("couldn't open");
+
+        // Set non-blocking, like our listening TCP ports.
+        int flags = fcntl(s, F_GETFL);
+        if ((flags < 0) || fcntl(s, F_SETFL, flags | O_NONBLOCK))
+            STHROW("couldn't set non-blocking");
+
+        // A previous run may have left its socket file behind (nothing unlinks it at shutdown); a bind to an
+        // existing path fails even when nobody's listening, so clear it first.
+        unlink(path.c_str());
+
+        // Bind to the configured path and listen.
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        if (::bind(s, (sockaddr*)&addr, sizeof(addr))) {
+            STHROW("couldn't bind");
+        }
+        if (listen(s, SOMAXCONN))
+            STHROW("couldn't listen");
+
+        // Success, ready to go.
+        return s;
+    } catch (const SException& e) {
+        // Failed to open
+        SWARN("Failed to open unix socket '" << path << "': " << e.what() << "(errno=" << S_errno << " '"
+                                             << strerror(S_errno) << "')");
+        if (s > 0)
+            close(s);
+        return -1;
+    }
+}
+
 // --------------------------------------------------------------------------
 ssize_t S_recvfrom(int s, char* recvBuffer, int recvBufferSize, sockaddr_in& fromAddr) {
     SASSERT(s);
@@ -1762,20 +2379,23 @@ ssize_t S_recvfrom(int s, char* recvBuffer, int recvBufferSize, sockaddr_in& fro
 
 // --------------------------------------------------------------------------
 int S_accept(int port, sockaddr_in& fromAddr, bool isBlocking) {
-    // Try to receive into the buffer
+    // Try to receive into the buffer. accept4 lets us ask for non-blocking at accept time rather than spending two
+    // fcntl calls per connection after the fact, which adds up during reconnect storms.
     socklen_t fromAddrLen = sizeof(fromAddr);
     memset(&fromAddr, 0, sizeof(fromAddr));
-    int s = (int)accept(port, (sockaddr*)&fromAddr, &fromAddrLen);
+    int s = (int)accept4(port, (sockaddr*)&fromAddr, &fromAddrLen, isBlocking ? 0 : SOCK_NONBLOCK);
 
     // Process the result
     if (s != -1) {
-        // Enable non-blocking, if requested.
-        if (!isBlocking) {
-            // Set non-blocking
-            int flags = fcntl(s, F_GETFL);
-            if ((flags < 0) || fcntl(s, F_SETFL, flags | O_NONBLOCK))
-                STHROW("couldn't set non-blocking");
-        }
+        // Tune the new socket. Command traffic is small request/response frames, so Nagle only adds latency, and a
+        // fixed 1MB send buffer skips the kernel's autotune ramp-up, which a connection that only lives for a few
+        // commands never gets through. These are best-effort: if the kernel refuses we just run with its defaults,
+        // and we don't log per-connection at these accept rates.
+        static const int enable = 1;
+        static const int bufferSize = 1024 * 1024;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&enable, sizeof(enable));
+        setsockopt(s, SOL_SOCKET, SO_SNDBUF, (const char*)&bufferSize, sizeof(bufferSize));
+        setsockopt(s, SOL_SOCKET, SO_RCVBUF, (const char*)&bufferSize, sizeof(bufferSize));
 
         // Accepted a valid socket; return
         return s;
@@ -1868,15 +2488,20 @@ bool S_recvappend(int s, SFastBuffer& recvBuffer) {
         SINFO("[performance] " << bytesInBuffer << " bytes in the socket buffer before receiving.");
     }
 
-    // Keep trying to receive as long as we can
-    char buffer[4096];
+    // Keep trying to receive as long as we can, straight into the receive buffer's tail so the bytes are only
+    // written once (no bounce through a stack buffer and memcpy after it).
+    const size_t CHUNK_SIZE = 4096;
     int totalRecv = 0;
     ssize_t numRecv = 0;
     sockaddr_in fromAddr;
     socklen_t fromAddrLen = sizeof(fromAddr);
-    while ((numRecv = recvfrom(s, buffer, sizeof(buffer), 0, (sockaddr*)&fromAddr, &fromAddrLen)) > 0) {
-        // Got some more data
-        recvBuffer.append(buffer, numRecv);
+    while (true) {
+        char* tail = recvBuffer.writableTail(CHUNK_SIZE);
+        numRecv = recvfrom(s, tail, CHUNK_SIZE, 0, (sockaddr*)&fromAddr, &fromAddrLen);
+        recvBuffer.commit(numRecv > 0 ? numRecv : 0);
+        if (numRecv <= 0) {
+            break;
+        }
         totalRecv += numRecv;
 
         // If this is a blocking socket, don't try again, once is enough
@@ -1903,8 +2528,8 @@ bool S_sendconsume(int s, SFastBuffer& sendBuffer) {
         return true; // Assume no error, still alive
     }
 
-    // 17 is size of "ESCALATE_RESPONSE".
-    if (SStartsWith(sendBuffer.c_str(), sendBuffer.size(), "ESCALATE_RESPONSE", 17)) {
+    // 17 is size of "ESCALATE_RESPONSE". Note we only inspect the first contiguous segment of the buffer.
+    if (SStartsWith(sendBuffer.c_str(), sendBuffer.firstSegmentSize(), "ESCALATE_RESPONSE", 17)) {
         SData tempData;
         tempData.deserialize(sendBuffer);
         string id = tempData["id"];
@@ -1914,8 +2539,14 @@ bool S_sendconsume(int s, SFastBuffer& sendBuffer) {
     // Timer for tracking how long the call to send is taking to debug slow ESCALATE_RESPONSEs
     chrono::steady_clock::time_point start = chrono::steady_clock::now();
 
-    // Send as much as we can
-    ssize_t numSent = send(s, sendBuffer.c_str(), sendBuffer.size(), MSG_NOSIGNAL);
+    // Send as much as we can, gathering the buffer's segments so chained payloads (large response bodies) go to the
+    // kernel without ever being coalesced into one contiguous copy. sendmsg rather than writev so we keep
+    // MSG_NOSIGNAL.
+    struct iovec iov[16];
+    struct msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = sendBuffer.gather(iov, 16);
+    ssize_t numSent = sendmsg(s, &msg, MSG_NOSIGNAL);
     string errorMessage;
     if (numSent == -1) {
         errorMessage = " Error: "s + strerror(errno);
@@ -1964,13 +2595,10 @@ bool SFDAnySet(fd_map& fdm, int socket, short evts) {
 }
 
 // --------------------------------------------------------------------------
-int S_poll(fd_map& fdm, uint64_t timeout) {
-    // Why doesn't this function lock around our fd_map, you might ask? Because in the existing bedrock architecture,
-    // each worker thread allocates its own fd_map, and thus different threads wont compete for the same resource
-    // here. The only place they share resources is around a bedrock MessageQueue, which does its own locking. If we
-    // ever want to allow multiple threads to manipulate a shared fd_map directly, then we need locking in the related
-    // functions.
+atomic<bool> SPollUseEpoll(true);
 
+// The original poll() backend for S_poll.
+static int S_pollWithPoll(fd_map& fdm, uint64_t timeout) {
     // Build a vector we can use to pass data to poll().
     vector<pollfd> pollvec;
     for (pair<int, pollfd> pfd : fdm) {
@@ -1992,6 +2620,103 @@ int S_poll(fd_map& fdm, uint64_t timeout) {
     return returnValue;
 }
 
+#ifdef __APPLE__
+// No epoll on OS X; development builds just use poll().
+static int S_pollWithEpoll(fd_map& fdm, uint64_t timeout) {
+    return S_pollWithPoll(fdm, timeout);
+}
+#else
+// The epoll backend for S_poll. Callers rebuild their fd_map every loop iteration (that's the prePoll contract), so
+// we keep a per-thread mirror of what's registered in the kernel and sync it incrementally: sockets that persist
+// across iterations (the overwhelmingly common case) cost nothing, and epoll_wait returns only the ready ones, so
+// the per-iteration cost scales with activity rather than with total connection count. Note that POLLIN/POLLOUT/
+// POLLERR/POLLHUP/POLLPRI have the same values as their EPOLL equivalents on Linux, so no event translation is
+// needed in either direction.
+static int S_pollWithEpoll(fd_map& fdm, uint64_t timeout) {
+    // Per-thread epoll instance, and a mirror of the (fd -> events) set currently registered with it. Thread-local
+    // because each bedrock thread polls its own fd_map (see the locking note in S_poll).
+    thread_local int epollFD = -1;
+    thread_local map<int, short> registered;
+    if (epollFD == -1) {
+        epollFD = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFD == -1) {
+            SWARN("epoll_create1 failed with '" << strerror(S_errno) << "' (#" << S_errno << "), falling back to poll().");
+            return S_pollWithPoll(fdm, timeout);
+        }
+    }
+
+    // Sync the kernel's registration set with the caller's fd_map. Both maps are sorted by fd, so this is a single
+    // merge pass: add what's new, modify what changed, delete what's gone.
+    auto fdmIt = fdm.begin();
+    auto regIt = registered.begin();
+    while (fdmIt != fdm.end() || regIt != registered.end()) {
+        if (regIt == registered.end() || (fdmIt != fdm.end() && fdmIt->first < regIt->first)) {
+            // New socket, register it.
+            epoll_event event = {};
+            event.events = (uint32_t)(unsigned short)fdmIt->second.events;
+            event.data.fd = fdmIt->first;
+            if (epoll_ctl(epollFD, EPOLL_CTL_ADD, fdmIt->first, &event) && S_errno == EEXIST) {
+                // The fd number was closed and reused while still registered somewhere; just update it.
+                epoll_ctl(epollFD, EPOLL_CTL_MOD, fdmIt->first, &event);
+            }
+            regIt = registered.emplace_hint(regIt, fdmIt->first, fdmIt->second.events);
+            fdmIt++;
+            regIt++;
+        } else if (fdmIt == fdm.end() || regIt->first < fdmIt->first) {
+            // Socket's gone, deregister it. This fails harmlessly (EBADF/ENOENT) if the fd was already closed,
+            // which removes it from the epoll set automatically.
+            epoll_ctl(epollFD, EPOLL_CTL_DEL, regIt->first, 0);
+            regIt = registered.erase(regIt);
+        } else {
+            // Same socket in both. Update the kernel only if the requested events changed.
+            if (regIt->second != fdmIt->second.events) {
+                epoll_event event = {};
+                event.events = (uint32_t)(unsigned short)fdmIt->second.events;
+                event.data.fd = fdmIt->first;
+                epoll_ctl(epollFD, EPOLL_CTL_MOD, fdmIt->first, &event);
+                regIt->second = fdmIt->second.events;
+            }
+            fdmIt++;
+            regIt++;
+        }
+    }
+
+    // Clear any stale results from the last iteration.
+    for (auto& pfd : fdm) {
+        pfd.second.revents = 0;
+    }
+
+    // Timeout is specified in microseconds, but epoll uses milliseconds, so we divide by 1000.
+    vector<epoll_event> events(max(fdm.size(), (size_t)1));
+    int returnValue = epoll_wait(epollFD, &events[0], (int)events.size(), int(timeout / 1000));
+    if (returnValue == -1) {
+        SWARN("epoll_wait failed with response '" << strerror(S_errno) << "' (#" << S_errno << "), ignoring");
+        return returnValue;
+    }
+
+    // And write the ready events back to the caller's structure.
+    for (int i = 0; i < returnValue; i++) {
+        auto it = fdm.find(events[i].data.fd);
+        if (it != fdm.end()) {
+            it->second.revents = (short)events[i].events;
+        }
+    }
+    return returnValue;
+}
+#endif // __APPLE__
+
+int S_poll(fd_map& fdm, uint64_t timeout) {
+    // Why doesn't this function lock around our fd_map, you might ask? Because in the existing bedrock architecture,
+    // each worker thread allocates its own fd_map, and thus different threads wont compete for the same resource
+    // here. The only place they share resources is around a bedrock MessageQueue, which does its own locking. If we
+    // ever want to allow multiple threads to manipulate a shared fd_map directly, then we need locking in the related
+    // functions.
+    if (SPollUseEpoll.load()) {
+        return S_pollWithEpoll(fdm, timeout);
+    }
+    return S_pollWithPoll(fdm, timeout);
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // Network helpers
 /////////////////////////////////////////////////////////////////////////////
@@ -2025,15 +2750,20 @@ string SAESEncrypt(const string& buffer, const string& ivStr, const string& key)
         paddedBuffer.append(SAES_BLOCK_SIZE - ((int)buffer.size() % SAES_BLOCK_SIZE), (char)0);
     }
 
-    // Encrypt
+    // Encrypt, with AES-NI where the CPU supports it.
     unsigned char iv[SAES_BLOCK_SIZE];
     memcpy(iv, ivStr.c_str(), SAES_BLOCK_SIZE);
-    mbedtls_aes_context ctx;
-    mbedtls_aes_setkey_enc(&ctx, (unsigned char*)key.c_str(), 8 * SAES_KEY_SIZE);
     string encryptedBuffer;
     encryptedBuffer.resize(paddedBuffer.size());
-    mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_ENCRYPT, (int)paddedBuffer.size(), iv, (unsigned char*)paddedBuffer.c_str(),
-                          (unsigned char*)encryptedBuffer.c_str());
+    if (SCryptoAccel::aesAvailable()) {
+        SCryptoAccel::aes256CBCEncrypt((unsigned char*)key.c_str(), iv, (unsigned char*)paddedBuffer.c_str(),
+                                       paddedBuffer.size(), (unsigned char*)encryptedBuffer.c_str());
+    } else {
+        mbedtls_aes_context ctx;
+        mbedtls_aes_setkey_enc(&ctx, (unsigned char*)key.c_str(), 8 * SAES_KEY_SIZE);
+        mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_ENCRYPT, (int)paddedBuffer.size(), iv,
+                              (unsigned char*)paddedBuffer.c_str(), (unsigned char*)encryptedBuffer.c_str());
+    }
 
     return encryptedBuffer;
 }
@@ -2068,16 +2798,19 @@ string SAESDecryptNoStrip(const string& buffer, const size_t& bufferSize, unsign
         return "";
     }
 
-    // Decrypt
-    mbedtls_aes_context ctx;
+    // Decrypt, with AES-NI where the CPU supports it.
     string decryptedBuffer;
     decryptedBuffer.resize(bufferSize);
-    mbedtls_aes_setkey_dec(&ctx, (unsigned char*)key.c_str(), 8 * SAES_KEY_SIZE);
-    mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_DECRYPT, (int)buffer.size(), iv, (unsigned char*)buffer.c_str(),
-                          (unsigned char*)decryptedBuffer.c_str());
+    if (SCryptoAccel::aesAvailable()) {
+        SCryptoAccel::aes256CBCDecrypt((unsigned char*)key.c_str(), iv, (unsigned char*)buffer.c_str(),
+                                       buffer.size(), (unsigned char*)decryptedBuffer.c_str());
+    } else {
+        mbedtls_aes_context ctx;
+        mbedtls_aes_setkey_dec(&ctx, (unsigned char*)key.c_str(), 8 * SAES_KEY_SIZE);
+        mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_DECRYPT, (int)buffer.size(), iv, (unsigned char*)buffer.c_str(),
+                              (unsigned char*)decryptedBuffer.c_str());
+    }
     return decryptedBuffer;
-
-
 }
 
 string SAESDecryptNoStrip(const string& buffer, const size_t& bufferSize, const string& ivStr, const string& key) {
@@ -2256,14 +2989,37 @@ uint64_t SFileSize(const string& path) {
 string SHashSHA1(const string& buffer) {
     string result;
     result.resize(20);
-    mbedtls_sha1((unsigned char*)buffer.c_str(), buffer.size(), (unsigned char*)&result[0]);
+    if (SCryptoAccel::shaAvailable()) {
+        SCryptoAccel::sha1((unsigned char*)buffer.c_str(), buffer.size(), (unsigned char*)&result[0]);
+    } else {
+        mbedtls_sha1((unsigned char*)buffer.c_str(), buffer.size(), (unsigned char*)&result[0]);
+    }
+    return result;
+}
+
+string SHashSHA1(const string& buffer1, const string& buffer2) {
+    // Hashes the concatenation of the two buffers without materializing it, for callers hashing a small prefix plus
+    // a large body.
+    mbedtls_sha1_context ctx;
+    mbedtls_sha1_init(&ctx);
+    mbedtls_sha1_starts(&ctx);
+    mbedtls_sha1_update(&ctx, (unsigned char*)buffer1.c_str(), buffer1.size());
+    mbedtls_sha1_update(&ctx, (unsigned char*)buffer2.c_str(), buffer2.size());
+    string result;
+    result.resize(20);
+    mbedtls_sha1_finish(&ctx, (unsigned char*)&result[0]);
+    mbedtls_sha1_free(&ctx);
     return result;
 }
 
 string SHashSHA256(const string& buffer) {
     string result;
     result.resize(32);
-    mbedtls_sha256((unsigned char*)buffer.c_str(), buffer.size(), (unsigned char*)&result[0], 0);
+    if (SCryptoAccel::shaAvailable()) {
+        SCryptoAccel::sha256((unsigned char*)buffer.c_str(), buffer.size(), (unsigned char*)&result[0]);
+    } else {
+        mbedtls_sha256((unsigned char*)buffer.c_str(), buffer.size(), (unsigned char*)&result[0], 0);
+    }
     return result;
 }
 
@@ -2416,9 +3172,9 @@ static int _SQueryCallback(void* data, int argc, char** argv, char** colNames) {
     }
 
     // Record the result (and check for NULLs)
-    result.rows.resize(result.size() + 1);
+    result.addRow();
     for (int c = 0; c < argc; ++c) {
-        result.rows.back().push_back(argv[c] ? argv[c] : "");
+        result.addCell(argv[c] ? argv[c] : "");
     }
     return 0;
 }
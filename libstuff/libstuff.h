@@ -26,6 +26,7 @@
 #include <cctype>
 #include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <iomanip>
 #include <iostream>
 #include <list>
@@ -35,7 +36,9 @@
 #include <set>
 #include <shared_mutex>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
 #include <functional>
@@ -83,18 +86,58 @@ void SSetSignalHandlerDieFunc(function<void()>&& func);
 // --------------------------------------------------------------------------
 // A very simple name/value pair table with case-insensitive name matching
 // --------------------------------------------------------------------------
-// See: http://stackoverflow.com/questions/1801892/making-mapfind-operation-case-insensitive
+// ASCII-only lowercase table, so case folding is an index instead of a locale-aware tolower() call per character.
+// Our protocol headers are ASCII by construction; bytes past 0x7f map to themselves.
+struct SCaseTable {
+    unsigned char toLower[256];
+    constexpr SCaseTable() : toLower() {
+        for (int c = 0; c < 256; c++) {
+            toLower[c] = (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+        }
+    }
+};
+inline constexpr SCaseTable SCaseFold;
+
+// Case-folded hash and equality functors, so unordered containers can key on names the way STable compares them
+// (case-insensitively) without lowercasing a copy of the key per lookup.
+struct SCaseInsensitiveHash {
+    size_t operator()(const string& value) const {
+        // FNV-1a over the folded bytes.
+        size_t hash = 14695981039346656037ull;
+        for (char c : value) {
+            hash ^= SCaseFold.toLower[(unsigned char)c];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+};
+struct SCaseInsensitiveEqual {
+    bool operator()(const string& lhs, const string& rhs) const {
+        if (lhs.size() != rhs.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < lhs.size(); i++) {
+            if (SCaseFold.toLower[(unsigned char)lhs[i]] != SCaseFold.toLower[(unsigned char)rhs[i]]) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
 class STableComp : binary_function<string, string, bool> {
   public:
     bool operator()(const string& s1, const string& s2) const {
-        return lexicographical_compare(s1.begin(), s1.end(), s2.begin(), s2.end(), nocase_compare());
+        size_t shorter = min(s1.size(), s2.size());
+        for (size_t i = 0; i < shorter; i++) {
+            unsigned char c1 = SCaseFold.toLower[(unsigned char)s1[i]];
+            unsigned char c2 = SCaseFold.toLower[(unsigned char)s2[i]];
+            if (c1 != c2) {
+                return c1 < c2;
+            }
+        }
+        return s1.size() < s2.size();
     }
-
-  private:
-    class nocase_compare : public binary_function<unsigned char, unsigned char, bool> {
-      public:
-        bool operator()(const unsigned char& c1, const unsigned char& c2) const { return tolower(c1) < tolower(c2); }
-    };
 };
 
 // An SString is just a string with special assignment operators so that we get automatic conversion from arithmetic
@@ -119,6 +162,12 @@ class SString : public string {
         return *this;
     }
 
+    // Strings passed as rvalues get moved in rather than copied.
+    SString& operator=(string&& from) {
+        string::operator=(move(from));
+        return *this;
+    }
+
     // Chars are special, we don't treat them as integral types, even though they'd normally count.
     SString& operator=(const char& from) {
         string::operator=(from);
@@ -138,10 +187,107 @@ class SString : public string {
     }
 };
 
-typedef map<string, SString, STableComp> STable;
+// This was a `map<string, SString, STableComp>` for most of its life, but commands only carry a handful of headers,
+// and at that size a red-black tree is all overhead: an allocation per entry and pointer-chasing on every lookup.
+// It's now a flat vector kept sorted with the same case-insensitive comparison, exposing the subset of the map
+// interface the codebase uses, so call sites are unchanged: one contiguous allocation for the whole table, binary
+// search lookups, and short names and values stay inline via string's small-string storage.
+class STable {
+  public:
+    typedef string key_type;
+    typedef SString mapped_type;
+    typedef pair<string, SString> value_type;
+    typedef vector<value_type>::iterator iterator;
+    typedef vector<value_type>::const_iterator const_iterator;
+
+    STable() {}
+    STable(initializer_list<value_type> init) {
+        for (auto& entry : init) {
+            (*this)[entry.first] = entry.second;
+        }
+    }
+
+    iterator begin() { return _entries.begin(); }
+    iterator end() { return _entries.end(); }
+    const_iterator begin() const { return _entries.begin(); }
+    const_iterator end() const { return _entries.end(); }
+    bool empty() const { return _entries.empty(); }
+    size_t size() const { return _entries.size(); }
+    void clear() { _entries.clear(); }
+
+    iterator find(const string& name) {
+        iterator it = _lowerBound(name);
+        return (it != _entries.end() && !_less(name, it->first)) ? it : _entries.end();
+    }
+    const_iterator find(const string& name) const {
+        // Share the non-const implementation.
+        return const_cast<STable*>(this)->find(name);
+    }
+
+    // Like map's, throws if the entry doesn't exist.
+    SString& at(const string& name) {
+        iterator it = find(name);
+        if (it == _entries.end()) {
+            throw out_of_range("STable::at");
+        }
+        return it->second;
+    }
+    const SString& at(const string& name) const { return const_cast<STable*>(this)->at(name); }
+
+    // Creates the entry if it doesn't exist, like map's.
+    SString& operator[](const string& name) {
+        iterator it = _lowerBound(name);
+        if (it == _entries.end() || _less(name, it->first)) {
+            it = _entries.emplace(it, name, SString());
+        }
+        return it->second;
+    }
+
+    // Like map's, these don't overwrite an existing entry.
+    template <typename... Ts>
+    pair<iterator, bool> emplace(Ts&&... args) {
+        value_type entry(forward<Ts>(args)...);
+        iterator it = _lowerBound(entry.first);
+        if (it != _entries.end() && !_less(entry.first, it->first)) {
+            return make_pair(it, false);
+        }
+        return make_pair(_entries.insert(it, move(entry)), true);
+    }
+    pair<iterator, bool> insert(const value_type& entry) { return emplace(entry); }
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            emplace(*first);
+        }
+    }
+
+    size_t erase(const string& name) {
+        iterator it = find(name);
+        if (it == _entries.end()) {
+            return 0;
+        }
+        _entries.erase(it);
+        return 1;
+    }
+    iterator erase(iterator it) { return _entries.erase(it); }
+
+    bool operator==(const STable& rhs) const { return _entries == rhs._entries; }
+    bool operator!=(const STable& rhs) const { return !(*this == rhs); }
+    bool operator<(const STable& rhs) const { return _entries < rhs._entries; }
+
+  private:
+    static bool _less(const string& lhs, const string& rhs) { return STableComp()(lhs, rhs); }
+    iterator _lowerBound(const string& name) {
+        return ::lower_bound(_entries.begin(), _entries.end(), name,
+                             [](const value_type& entry, const string& value) { return _less(entry.first, value); });
+    }
+
+    vector<value_type> _entries;
+};
 
 // Libstuff items that must be included here so they are available in the rest of the file
 // However it must be included AFTER the STable definition because SData uses this type.
+#include "SBufferPool.h"
 #include "SFastBuffer.h"
 #include "SData.h"
 
@@ -177,6 +323,30 @@ class SException : public exception {
 // Utility function for generating pretty callstacks.
 vector<string> SGetCallstack(int depth = 0, void* const* callstack = nullptr) noexcept;
 
+// --------------------------------------------------------------------------
+// Resource accounting
+// --------------------------------------------------------------------------
+// Number of heap allocations made by the calling thread since it started. The global allocation functions are
+// replaced (in libstuff.cpp) with versions that bump a thread-local counter, so sampling this before and after a
+// block of work gives its allocation count without any locking or symbol interposition tricks.
+uint64_t SGetAllocationCount();
+
+// The process's peak resident set size, in bytes. This only ever grows, so the delta across a block of work is a
+// lower bound on how much that work (plus anything running concurrently) pushed the high-water mark.
+uint64_t SGetPeakRSS();
+
+// --------------------------------------------------------------------------
+// Thread placement
+// --------------------------------------------------------------------------
+// The number of NUMA memory nodes on this machine, read from the sysfs topology. Returns 1 when the topology isn't
+// exposed (non-Linux, no sysfs), so callers can treat "1" as "placement is a no-op".
+int SNUMANodeCount();
+
+// Restricts the calling thread to the CPUs of the given NUMA node. Because Linux allocates pages on the node of the
+// thread that first touches them, binding a thread *before* it allocates its working memory also makes that memory
+// node-local. Returns false (and changes nothing) if the node doesn't exist or the affinity call fails.
+bool SBindThreadToNUMANode(int node);
+
 // --------------------------------------------------------------------------
 // Time stuff TODO: Replace with std::chrono
 // --------------------------------------------------------------------------
@@ -265,6 +435,17 @@ inline void SLogLevel(int level) {
 // Stack trace logging
 void SLogStackTrace();
 
+// Async logging backend. When enabled, SSYSLOG lines are still formatted on the calling thread (so the SWHEREAMI
+// prefix is exactly what it always was), but the syslog() call itself happens on a dedicated logger thread, fed by
+// per-thread lock-free ring buffers. A thread that outruns the logger has its lines dropped and counted, and the
+// count is reported when its buffer next drains. Disabled by default; see -asyncLogging.
+void SLogAsync(int priority, string&& message);
+void SLogAsyncEnable(bool enabled);
+
+// Blocks until everything queued before the call has reached syslog, with a bounded wait. A no-op when async
+// logging is disabled.
+void SLogFlush();
+
 // **NOTE: rsyslog default max line size is 8k bytes. We split on 7k byte boundaries in order to fit the syslog line prefix and the expanded \r\n to #015#012
 #define SWHEREAMI SThreadLogPrefix + "(" + basename((char*)__FILE__) + ":" + SToStr(__LINE__) + ") " + __FUNCTION__ + " [" + SThreadLogName + "] "
 #define SSYSLOG(_PRI_, _MSG_)                                              \
@@ -275,7 +456,7 @@ void SLogStackTrace();
             const string s = __out.str();                                  \
             const string prefix = SWHEREAMI;                               \
             for (size_t i = 0; i < s.size(); i += 7168) {                  \
-                syslog(_PRI_, "%s", (prefix + s.substr(i, 7168)).c_str()); \
+                SLogAsync(_PRI_, prefix + s.substr(i, 7168));              \
             }                                                              \
         }                                                                  \
     } while (false)
@@ -290,6 +471,7 @@ void SLogStackTrace();
     do {                                                    \
         SSYSLOG(LOG_ERR, "[eror] " << SLOGPREFIX << _MSG_); \
         SLogStackTrace();                                   \
+        SLogFlush();                                        \
         abort();                                            \
     } while (false)
 
@@ -397,6 +579,13 @@ inline int SToInt(const string& val) { return atoi(val.c_str()); }
 inline int64_t SToInt64(const string& val) { return atoll(val.c_str()); }
 inline uint64_t SToUInt64(const string& val) { return strtoull(val.c_str(), NULL, 10); }
 
+// string_view flavors, for callers holding views (e.g., SQResult cells). The C conversion functions need a
+// terminated buffer, so these copy - but a numeric value always fits the small-string optimization.
+inline float SToFloat(string_view val) { return SToFloat(string(val)); }
+inline int SToInt(string_view val) { return SToInt(string(val)); }
+inline int64_t SToInt64(string_view val) { return SToInt64(string(val)); }
+inline uint64_t SToUInt64(string_view val) { return SToUInt64(string(val)); }
+
 // General utility for testing map containment
 template <class A, class B, class C> inline bool SContains(const map<A, B, C>& nameValueMap, const A& name) {
     return (nameValueMap.find(name) != nameValueMap.end());
@@ -416,8 +605,53 @@ inline bool SContains(const STable& nameValueMap, const string& name) {
 }
 bool SIsValidSQLiteDateModifier(const string& modifier);
 
+// Branch-light fixed-format integer conversions for hot paths. SFastParseU64 reads leading ASCII digits -- no
+// whitespace, signs, or base prefixes, which is the fixed format our own protocol headers are written in -- and
+// stops at the first non-digit. SFastFormatU64 writes the decimal digits into the caller's buffer (at least
+// SFAST_U64_BUFFER_SIZE bytes, no terminator) and returns the length written; no allocation, no locale machinery.
+inline uint64_t SFastParseU64(const char* ptr, const char* end) {
+    uint64_t value = 0;
+    while (ptr < end) {
+        unsigned digit = (unsigned char)*ptr - '0';
+        if (digit > 9) {
+            break;
+        }
+        value = value * 10 + digit;
+        ptr++;
+    }
+    return value;
+}
+inline uint64_t SFastParseU64(string_view value) { return SFastParseU64(value.data(), value.data() + value.size()); }
+constexpr size_t SFAST_U64_BUFFER_SIZE = 20;
+inline size_t SFastFormatU64(char* buffer, uint64_t value) {
+    // Emit digits least-significant first, then reverse into place.
+    char reversed[SFAST_U64_BUFFER_SIZE];
+    size_t length = 0;
+    do {
+        reversed[length++] = '0' + (value % 10);
+        value /= 10;
+    } while (value);
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = reversed[length - 1 - i];
+    }
+    return length;
+}
+
 // General testing functions
 inline bool SIEquals(const string& lhs, const string& rhs) { return !strcasecmp(lhs.c_str(), rhs.c_str()); }
+inline bool SIEquals(const char* lhs, const char* rhs) { return !strcasecmp(lhs, rhs); }
+inline bool SIEquals(string_view lhs, string_view rhs) {
+    // The view flavor (again, for SQResult cells) can't rely on termination, so compare in place.
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < lhs.size(); i++) {
+        if (SCaseFold.toLower[(unsigned char)lhs[i]] != SCaseFold.toLower[(unsigned char)rhs[i]]) {
+            return false;
+        }
+    }
+    return true;
+}
 bool SIContains(const string& haystack, const string& needle);
 bool SStartsWith(const string& haystack, const string& needle);
 bool SStartsWith(const char* haystack, size_t haystackSize, const char* needle, size_t needleSize);
@@ -496,6 +730,22 @@ int SParseHTTP(const char* buffer, size_t length, string& methodLine, STable& na
 inline int SParseHTTP(const string& buffer, string& methodLine, STable& nameValueMap, string& content) {
     return SParseHTTP(buffer.c_str(), (int)buffer.size(), methodLine, nameValueMap, content);
 }
+
+// Resumable variant for buffers that fill incrementally (i.e., socket receive buffers, which get a parse attempt on
+// every poll cycle). An incomplete parse records its progress in `state` -- how far into the header block it got,
+// the headers parsed so far, and (once known) the total bytes the message needs -- so the next attempt picks up
+// where it left off instead of rescanning from the start, which is quadratic for a large message trickling in.
+// `state` must be reset whenever the front of the buffer moves; SFastBuffer's embedded state handles this itself.
+int SParseHTTP(const char* buffer, size_t length, string& methodLine, STable& nameValueMap, string& content,
+               SHTTPParseState& state);
+
+// Non-owning variant of SParseHTTP. Produces views into `buffer` rather than copying the method line, every header,
+// and the content into fresh strings, so checking a socket buffer for a complete message allocates nothing. Only
+// handles the common case: messages with chunked transfer-encoding, folded (continuation) headers, slash-escaped
+// values, or repeated Set-Cookie headers make it return 0, and the caller should fall back to the copying parser.
+// Returns the number of bytes consumed, or 0 for an incomplete or unsupported message.
+int SParseHTTPView(const char* buffer, size_t length, string_view& methodLine,
+                   vector<pair<string_view, string_view>>& headers, string_view& content);
 bool SParseRequestMethodLine(const string& methodLine, string& method, string& uri);
 bool SParseResponseMethodLine(const string& methodLine, string& protocol, int& code, string& reason);
 bool SParseURI(const char* buffer, int length, string& host, string& path);
@@ -572,18 +822,34 @@ string SComposeJSONArray(const T& valueList) {
     if (valueList.empty()) {
         return "[]";
     }
-    string working = "[";
-    for (auto value : valueList) {
-        working += SToJSON(value) + ",";
+    // Size the output once up front; escaping can push a value a little over its own length, which at worst
+    // costs one late growth rather than reallocating all the way up.
+    size_t estimate = 2;
+    for (const auto& value : valueList) {
+        estimate += value.size() + 3;
+    }
+    string working;
+    working.reserve(estimate);
+    working += '[';
+    for (const auto& value : valueList) {
+        working += SToJSON(value);
+        working += ',';
     }
-    working.resize(working.size() - 1);
-    working += "]";
+    working[working.size() - 1] = ']';
     return working;
 }
 
 string SComposeJSONObject(const STable& nameValueMap, const bool forceString = false);
 STable SParseJSONObject(const string& object);
 list<string> SParseJSONArray(const string& array);
+
+// View-based flavors for hot paths: every entry views into the input (object entries come back in document order),
+// so the caller must keep the input alive and unmodified while using them. String values are returned raw --
+// without the surrounding quotes, but still escaped, so run SUnescape over any value that can contain escapes --
+// and nested objects and arrays as their full serialized text. Malformed input yields an empty container, like the
+// copying flavors.
+vector<pair<string_view, string_view>> SParseJSONObjectView(string_view object);
+vector<string_view> SParseJSONArrayView(string_view array);
 inline string SGetJSONArrayFront(const string& jsonArray) {
     list<string> l = SParseJSONArray(jsonArray);
     return l.empty() ? "" : l.front();
@@ -613,7 +879,18 @@ void SFDset(fd_map& fdm, int socket, short evts);
 bool SFDAnySet(fd_map& fdm, int socket, short evts);
 
 // Socket helpers
-int S_socket(const string& host, bool isTCP, bool isPort, bool isBlocking);
+int S_socket(const string& host, bool isTCP, bool isPort, bool isBlocking, bool reusePort = false);
+
+// Opens a non-blocking listening socket on a unix domain socket at `path` (unlinking any stale socket file left by a
+// previous run), for same-host clients that want to skip loopback TCP. Accepted connections speak the same protocol
+// as TCP ones and work with S_accept (the returned peer address is just truncated into the sockaddr_in). Returns the
+// listening fd, or -1 on failure.
+int S_unixSocket(const string& path);
+
+// Accepts one pending connection from a listening fd. The returned socket comes back non-blocking (unless isBlocking)
+// straight from accept4, and already tuned for command traffic: TCP_NODELAY plus fixed 1MB send/receive buffers (both
+// best-effort, and no-ops on unix domain sockets). Returns the new fd, 0 when there's nothing left to accept, or -1
+// when the listening socket should be closed.
 int S_accept(int port, sockaddr_in& fromAddr, bool isBlocking);
 ssize_t S_recvfrom(int s, char* recvBuffer, int recvBufferSize, sockaddr_in& fromAddr);
 bool S_recvappend(int s, SFastBuffer& recvBuffer);
@@ -623,6 +900,12 @@ inline SFastBuffer S_recv(int s) {
     return buf;
 }
 bool S_sendconsume(int s, SFastBuffer& sendBuffer);
+
+// When true (the default on Linux), S_poll is backed by epoll: each polling thread keeps a persistent epoll
+// instance, sockets are registered with the kernel once and modified incrementally as the caller's fd_map changes,
+// and the kernel returns only the ready sockets rather than scanning every registered one. Set this to false at
+// startup (before any thread polls) to fall back to plain poll().
+extern atomic<bool> SPollUseEpoll;
 int S_poll(fd_map& fdm, uint64_t timeout);
 
 // Network helpers
@@ -649,6 +932,7 @@ uint64_t SFileSize(const string& path);
 // --------------------------------------------------------------------------
 // Various hashing functions
 string SHashSHA1(const string& buffer);
+string SHashSHA1(const string& buffer1, const string& buffer2); // hashes buffer1+buffer2 without concatenating them
 string SHashSHA256(const string& buffer);
 
 // Various encoding/decoding functions
@@ -676,8 +960,38 @@ string SAESDecryptNoStrip(const string& buffer, const size_t& bufferSize, const
 // --------------------------------------------------------------------------
 #include "sqlite3.h"
 #include "SQResult.h"
-inline string SQ(const char* val) { return "'" + SEscape(val, "'", '\'') + "'"; }
-inline string SQ(const string& val) { return SQ(val.c_str()); }
+// Appends `val` as a quoted SQL string literal directly onto `out` -- the same bytes `out += SQ(val)` produces,
+// without the intermediate string. Rather than walking byte-by-byte, clean spans between quote characters are found
+// with memchr (which the libc vectorizes) and bulk-copied, so for typical values this is one scan and one copy.
+// Query builders assembling large statements should prefer this over concatenating SQ() results.
+void SAppendQuoted(string& out, const char* val, size_t length);
+
+// Appends SQ(val) onto `out`, for any type SQ accepts. The string forms use the vectorized escaper above; the
+// numeric forms don't need escaping at all.
+inline void SQAppend(string& out, const char* val) { SAppendQuoted(out, val, strlen(val)); }
+inline void SQAppend(string& out, const string& val) { SAppendQuoted(out, val.data(), val.size()); }
+inline void SQAppend(string& out, string_view val) { SAppendQuoted(out, val.data(), val.size()); }
+inline void SQAppend(string& out, int val) { out += SToStr(val); }
+inline void SQAppend(string& out, unsigned val) { out += SToStr(val); }
+inline void SQAppend(string& out, uint64_t val) { out += SToStr(val); }
+inline void SQAppend(string& out, int64_t val) { out += SToStr(val); }
+inline void SQAppend(string& out, double val) { out += SToStr(val); }
+
+inline string SQ(const char* val) {
+    string out;
+    SAppendQuoted(out, val, strlen(val));
+    return out;
+}
+inline string SQ(const string& val) {
+    string out;
+    SAppendQuoted(out, val.data(), val.size());
+    return out;
+}
+inline string SQ(string_view val) {
+    string out;
+    SAppendQuoted(out, val.data(), val.size());
+    return out;
+}
 inline string SQ(int val) { return SToStr(val); }
 inline string SQ(unsigned val) { return SToStr(val); }
 inline string SQ(uint64_t val) { return SToStr(val); }
@@ -685,12 +999,30 @@ inline string SQ(int64_t val) { return SToStr(val); }
 inline string SQ(double val) { return SToStr(val); }
 string SQList(const string& val, bool integersOnly = true);
 
+// How many bytes SQ(val) will produce, assuming no characters need escaping -- used to pre-size list output. Values
+// that do contain quotes grow past the estimate and just cost a reallocation.
+inline size_t SQEstimatedSize(const char* val) { return strlen(val) + 2; }
+inline size_t SQEstimatedSize(const string& val) { return val.size() + 2; }
+inline size_t SQEstimatedSize(string_view val) { return val.size() + 2; }
+template <typename T>
+typename enable_if<is_arithmetic<T>::value, size_t>::type SQEstimatedSize(T val) { return 24; }
+
 template <typename Container> string SQList(const Container& valueList) {
-    list<string> safeValues;
+    // Pre-size the output from the input lengths, so building the list is one allocation instead of one per value
+    // plus the joins.
+    size_t estimate = 0;
     for (typename Container::const_iterator valueIt = valueList.begin(); valueIt != valueList.end(); ++valueIt) {
-        safeValues.push_back(SQ(*valueIt));
+        estimate += SQEstimatedSize(*valueIt) + 2; // Plus the ", " separator.
     }
-    return SComposeList(safeValues);
+    string result;
+    result.reserve(estimate);
+    for (typename Container::const_iterator valueIt = valueList.begin(); valueIt != valueList.end(); ++valueIt) {
+        if (!result.empty()) {
+            result += ", ";
+        }
+        SQAppend(result, *valueIt);
+    }
+    return result;
 }
 
 void SQueryLogOpen(const string& logFilename);
@@ -708,7 +1040,10 @@ bool SQVerifyTable(sqlite3* db, const string& tableName, const string& sql);
 bool SQVerifyTableExists(sqlite3* db, const string& tableName);
 
 // --------------------------------------------------------------------------
-inline string SUNQUOTED_TIMESTAMP(uint64_t when) { return SComposeTime("%Y-%m-%d %H:%M:%S", when); }
+// "%Y-%m-%d %H:%M:%S" rendering of `when`, with the last-formatted second cached per thread: Jobs embeds the
+// current time into nearly every query it builds, so repeat calls within the same second (the overwhelmingly common
+// case) copy 19 bytes instead of running gmtime/strftime again.
+string SUNQUOTED_TIMESTAMP(uint64_t when);
 inline string STIMESTAMP(uint64_t when) { return SQ(SUNQUOTED_TIMESTAMP(when)); }
 inline string SUNQUOTED_CURRENT_TIMESTAMP() { return SUNQUOTED_TIMESTAMP(STimeNow()); }
 inline string SCURRENT_TIMESTAMP() { return STIMESTAMP(STimeNow()); }
@@ -720,6 +1055,18 @@ inline string SCURRENT_TIMESTAMP() { return STIMESTAMP(STimeNow()); }
 string SGZip(const string& content);
 string SGUnzip(const string& content);
 
+// Streaming variant of SGZip: deflates `content` segment by segment (without flattening it) directly into `out`'s
+// tail — e.g., a socket send buffer — in bounded chunks, so large bodies never need a contiguous compressed copy.
+// Returns false on failure, in which case `out` may hold a partial stream and shouldn't be sent.
+bool SGZipStream(const SFastBuffer& content, SFastBuffer& out);
+
+// Zstd compression, used for large peer messages. `level` 0 means use the process-wide default level, which defaults
+// to 3 and can be changed with SZstdSetCompressionLevel. SZstdCompress returns "" on failure (like SGZip);
+// SZstdDecompress throws an SException on malformed input, since callers receive this data off the network.
+string SZstdCompress(const string& content, int level = 0);
+string SZstdDecompress(const string& content);
+void SZstdSetCompressionLevel(int level);
+
 // Command-line helpers
 SData SParseCommandLine(int argc, char* argv[]);
 
@@ -795,6 +1142,8 @@ struct STestTimer {
 #include "SHTTPSManager.h"
 
 // Other libstuff headers.
+#include "SDNSCache.h"
+#include "SSlabPool.h"
 #include "SRandom.h"
 #include "SPerformanceTimer.h"
 #include "SSynchronizedQueue.h"
@@ -13,6 +13,8 @@
 #include "sqlitecluster/SQLite.h"
 #include <sys/stat.h> // for umask()
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/resource.h>
 
 /////////////////////////////////////////////////////////////////////////////
@@ -158,6 +160,43 @@ int main(int argc, char* argv[]) {
         SASSERT(sqlite3_config(SQLITE_CONFIG_MMAP_SIZE, mmapSizeGB * GB, 16 * 1024 * GB) == SQLITE_OK); // Max is 16TB
     }
 
+    // Optionally back the page cache with explicit 2MB hugepages. One TLB entry then covers 512 cache slots instead
+    // of one, and the allocation is done up front rather than growing (and faulting) lazily under the first load
+    // after a restart. This must be configured before sqlite3_initialize().
+    if (args.test("-hugePageCache")) {
+        static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+        // Each slot holds one database page plus SQLite's per-page header; 4,224 covers the default 4KB page size
+        // with room to spare (any page too big for a slot just falls through to the normal allocator).
+        static const int PAGE_SLOT_SIZE = 4224;
+        int64_t cacheSizeKB = args.isSet("-cacheSize") ? stoll(args["-cacheSize"]) : 1024 * 1024;
+        size_t bytes = ((cacheSizeKB * 1024 + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+        void* cache = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        cache = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+        if (cache == MAP_FAILED) {
+            // No pre-reserved hugepages available (see /proc/sys/vm/nr_hugepages); take a normal mapping and ask
+            // the kernel to back it with transparent hugepages instead.
+            SWARN("Couldn't map explicit hugepages for the page cache (" << strerror(errno)
+                  << "), trying transparent hugepages.");
+            cache = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+            if (cache != MAP_FAILED) {
+                madvise(cache, bytes, MADV_HUGEPAGE);
+            }
+#endif
+        }
+        if (cache == MAP_FAILED) {
+            SWARN("Couldn't allocate a page cache buffer at all, using SQLite's default page cache.");
+        } else {
+            int pageCount = (int)(bytes / PAGE_SLOT_SIZE);
+            SINFO("Backing page cache with " << bytes / HUGE_PAGE_SIZE << " 2MB hugepages (" << pageCount
+                  << " slots of " << PAGE_SLOT_SIZE << " bytes).");
+            SASSERT(sqlite3_config(SQLITE_CONFIG_PAGECACHE, cache, PAGE_SLOT_SIZE, pageCount) == SQLITE_OK);
+        }
+    }
+
     // Disable a mutex around `malloc`, which is *EXTREMELY IMPORTANT* for multi-threaded performance. Without this
     // setting, all reads are essentially single-threaded as they'll all fight with each other for this mutex.
     SASSERT(sqlite3_config(SQLITE_CONFIG_MEMSTATUS, 0) == SQLITE_OK);
@@ -228,14 +267,35 @@ int main(int argc, char* argv[]) {
         cout
             << "-serverHost     <host:port> Listen on this host:port for cluster connections (default 'localhost:8888')"
             << endl;
+        cout << "-unixSocket     <path>      Also listen for commands on a unix domain socket at this path, for "
+                "same-host clients"
+             << endl;
+        cout << "-forgetJournal  <path>      Journal accepted 'Connection: forget' commands to a memory-mapped file "
+                "at this path, replayed after a crash"
+             << endl;
         cout << "-nodeName       <name>      Name this specfic node in the cluster as indicated (defaults to '"
              << SGetHostName() << "')" << endl;
         cout << "-nodeHost       <host:port> Listen on this host:port for connections from other nodes" << endl;
         cout << "-peerList       <list>      See below" << endl;
         cout << "-priority       <value>     See '-peerList Details' below (defaults to 100)" << endl;
+        cout << "-subscribeTo    <name>      Run as a chained read replica: subscribe to this peer (a follower) "
+                "instead of leader. Requires -priority 0"
+             << endl;
+        cout << "-bridgeFrom     <host:port> Asynchronously replicate another cluster's journal into this one: pull "
+                "from this node of the primary cluster and re-apply its commits here while leading. This node's "
+                "-nodeName must be listed in the primary cluster's -peerList with ?Permafollower=true"
+             << endl;
+        cout << "-admissionControl           Shed commands that can't meet their timeout: reject with 503 at parse "
+                "time when the projected queue wait exceeds the command's timeout, and at dequeue once the deadline "
+                "has passed"
+             << endl;
         cout << "-plugins        <list>      Enable these plugins (defaults to 'db,jobs,cache,mysql')" << endl;
         cout << "-cacheSize      <kb>        number of KB to allocate for a page cache (defaults to 1GB)" << endl;
-        cout << "-workerThreads  <#>         Number of worker threads to start (min 1, defaults to # of cores)" << endl;
+        cout << "-workerThreads  <#>         Maximum number of worker threads (min 1, defaults to # of cores)" << endl;
+        cout << "-minWorkerThreads <#>       Floor the adaptive worker pool can shrink to when idle (defaults to a "
+                "quarter of -workerThreads)"
+             << endl;
+        cout << "-peerCompressionLevel <#>   zstd level for large peer messages (defaults to 3)" << endl;
         cout << "-queryLog       <filename>  Set the query log filename (default 'queryLog.csv', SIGUSR2/SIGQUIT to "
                 "enable/disable)"
              << endl;
@@ -244,6 +304,36 @@ int main(int argc, char* argv[]) {
         cout << "-synchronous    <value>     Set the PRAGMA schema.synchronous "
                 "(defaults see https://sqlite.org/pragma.html#pragma_synchronous)"
              << endl;
+        cout << "-groupCommit                Batch the WAL sync across commits that queue up behind the commit lock "
+                "(one fsync per group instead of one per commit)"
+             << endl;
+        cout << "-disableEpoll               Use plain poll() for socket readiness instead of the default epoll "
+                "backend"
+             << endl;
+        cout << "-sendCoalescingUS <µs>      Coalesce socket sends within this window into one syscall (try 100; "
+                "default 0, off)"
+             << endl;
+        cout << "-spoolThresholdMB <MB>      Spool responses this large or larger to unlinked temp files and stream "
+                "them out with sendfile(), capping per-command memory (default 0, off)"
+             << endl;
+        cout << "-asyncLogging               Move syslog writes off the working threads onto a dedicated logger "
+                "thread (drops and counts lines under overload)"
+             << endl;
+        cout << "-acceptorThreads <#>        Extra threads that each bind the command port with SO_REUSEPORT and "
+                "run their own accept/parse loop (default 0; try 2-4 for connection-churn-heavy clients)"
+             << endl;
+        cout << "-preloadDB                  Queue kernel readahead for the database and WAL files at startup, so "
+                "the first commands after a restart don't pay a minor-fault storm"
+             << endl;
+        cout << "-hugePageCache              Back the page cache (-cacheSize) with 2MB hugepages (falls back to "
+                "transparent hugepages, then to the default allocator)"
+             << endl;
+        cout << "-enableStatementTrace       Record per-transaction statement timings and report the transactions "
+                "holding the write position longest ('Status' with a statementTrace header)"
+             << endl;
+        cout << "-queryLedgerSampleRate <#>  Sample one in every # statements into the hot-query ledger ('Status' "
+                "with a queryLedger header; default 128, 0 disables)"
+             << endl;
         cout << endl;
         cout << "Quick Start Tips:" << endl;
         cout << "-----------------" << endl;
@@ -283,6 +373,31 @@ int main(int argc, char* argv[]) {
         SLogLevel(LOG_WARNING);
     }
 
+    // This must be set before any thread starts polling.
+    if (args.isSet("-disableEpoll")) {
+        SINFO("Disabling epoll, using poll() for socket readiness.");
+        SPollUseEpoll.store(false);
+    }
+
+    // If set, small sends within this window ride the send buffer and go out together (see STCPManager).
+    if (args.isSet("-sendCoalescingUS")) {
+        SINFO("Coalescing socket sends within " << args.calc("-sendCoalescingUS") << "us.");
+        STCPManager::sendCoalescingUS.store(args.calc64("-sendCoalescingUS"));
+    }
+
+    // If set, oversized outgoing payloads spool to unlinked temp files and stream out with sendfile, so a few
+    // giant responses can't pin their whole bodies in the heap (see STCPManager::Socket::spoolThresholdBytes).
+    if (args.isSet("-spoolThresholdMB")) {
+        SINFO("Spooling socket sends of " << args.calc("-spoolThresholdMB") << "MB or more to temp files.");
+        STCPManager::Socket::spoolThresholdBytes.store(args.calc64("-spoolThresholdMB") * 1024 * 1024);
+    }
+
+    // If set, syslog writes move off the calling threads onto a logger thread (see SLogAsync in libstuff).
+    if (args.isSet("-asyncLogging")) {
+        SINFO("Enabling async logging.");
+        SLogAsyncEnable(true);
+    }
+
 // Set the defaults
 #define SETDEFAULT(_NAME_, _VAL_)                                                                                      \
     do {                                                                                                               \
@@ -318,6 +433,29 @@ int main(int argc, char* argv[]) {
         SASSERT(SFileExists(args["-db"]));
     }
 
+    // If requested, tell the kernel to start reading the database and WAL files back into the page cache now,
+    // asynchronously, instead of paying for each page as a minor fault when the first commands touch it. We can't
+    // map individual tables to file regions from out here, so this advises the whole file; WILLNEED is only a hint,
+    // so the kernel reads ahead as capacity allows and the per-structure warming happens later, in
+    // BedrockServer::onPrepareToLead.
+    if (args.test("-preloadDB")) {
+        for (const string& path : {args["-db"], args["-db"] + "-wal"}) {
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                // The WAL file legitimately may not exist yet.
+                continue;
+            }
+            struct stat fileStat = {};
+            if (!fstat(fd, &fileStat) && fileStat.st_size) {
+                SINFO("Queueing readahead for '" << path << "' (" << fileStat.st_size / (1024 * 1024) << "MB).");
+                if (posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED)) {
+                    SWARN("posix_fadvise(WILLNEED) failed for '" << path << "': " << strerror(errno));
+                }
+            }
+            close(fd);
+        }
+    }
+
     // Set our soft limit to the same as our hard limit to allow for more file handles.
     struct rlimit limits;
     if (!getrlimit(RLIMIT_NOFILE, &limits)) {
@@ -389,5 +527,8 @@ int main(int argc, char* argv[]) {
 
     // All done
     SINFO("Graceful process shutdown complete");
+
+    // Stops the logger thread after a final drain, so the lines above make it out. A no-op if async logging's off.
+    SLogAsyncEnable(false);
     return 0;
 }
@@ -1,5 +1,6 @@
 #include "Cache.h"
 #include "BedrockServer.h"
+#include <fnmatch.h> // for GLOB matching against memory-tier names
 
 const string BedrockPlugin_Cache::name("Cache");
 const string& BedrockPlugin_Cache::getName() const {
@@ -23,42 +24,135 @@ unique_ptr<BedrockCommand> BedrockPlugin_Cache::getCommand(SQLiteCommand&& baseC
     return nullptr;
 }
 
-BedrockPlugin_Cache::LRUMap::LRUMap() {
+BedrockPlugin_Cache::LRUMap::LRUMap(int64_t maxMemoryBytes) : _maxMemoryBytes(maxMemoryBytes) {
     // Initialize
 }
 
 BedrockPlugin_Cache::LRUMap::~LRUMap() {
-    // Just delete all the entries
-    while (!empty()) {
-        // Pop it off
-        popLRU();
+    // Just delete all the entries. Nothing else can hold a shard lock during destruction.
+    for (Shard& shard : _shards) {
+        Entry* entry = shard.lruHead;
+        while (entry) {
+            Entry* next = entry->next;
+            delete entry;
+            entry = next;
+        }
     }
 }
 
+BedrockPlugin_Cache::LRUMap::Entry* BedrockPlugin_Cache::LRUMap::tombstone() {
+    // Any stable address that can't be a real entry works; we only ever compare against it.
+    static Entry marker;
+    return &marker;
+}
+
 bool BedrockPlugin_Cache::LRUMap::empty() {
-    // Both the map and list are the same size, so check either
-    lock_guard<decltype(_mutex)> lock(_mutex);
-    return _lruList.empty();
+    for (Shard& shard : _shards) {
+        lock_guard<mutex> lock(shard.shardMutex);
+        if (shard.count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+BedrockPlugin_Cache::LRUMap::Entry** BedrockPlugin_Cache::LRUMap::_findSlot(Shard& shard, const string& name,
+                                                                            size_t hash) {
+    // The low bits of the hash picked the shard, so start probing from the higher bits to avoid every name in this
+    // shard clustering around the same slots.
+    size_t mask = shard.slots.size() - 1;
+    size_t i = (hash / SHARD_COUNT) & mask;
+    Entry** insertSlot = nullptr;
+    while (true) {
+        Entry** slot = &shard.slots[i];
+        if (!*slot) {
+            // End of the probe chain; the name's not here. Prefer reusing a tombstone we passed on the way.
+            return insertSlot ? insertSlot : slot;
+        }
+        if (*slot == tombstone()) {
+            if (!insertSlot) {
+                insertSlot = slot;
+            }
+        } else if ((*slot)->hash == hash && (*slot)->name == name) {
+            return slot;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+void BedrockPlugin_Cache::LRUMap::_grow(Shard& shard) {
+    // Double the table and re-place every live entry; tombstones are dropped in the process.
+    vector<Entry*> oldSlots(shard.slots.size() * 2, nullptr);
+    oldSlots.swap(shard.slots);
+    shard.occupied = shard.count;
+    size_t mask = shard.slots.size() - 1;
+    for (Entry* entry : oldSlots) {
+        if (entry && entry != tombstone()) {
+            size_t i = (entry->hash / SHARD_COUNT) & mask;
+            while (shard.slots[i]) {
+                i = (i + 1) & mask;
+            }
+            shard.slots[i] = entry;
+        }
+    }
+}
+
+void BedrockPlugin_Cache::LRUMap::_linkMRU(Shard& shard, Entry* entry) {
+    entry->prev = shard.lruTail;
+    entry->next = nullptr;
+    if (shard.lruTail) {
+        shard.lruTail->next = entry;
+    } else {
+        shard.lruHead = entry;
+    }
+    shard.lruTail = entry;
+}
+
+void BedrockPlugin_Cache::LRUMap::_unlink(Shard& shard, Entry* entry) {
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        shard.lruHead = entry->next;
+    }
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    } else {
+        shard.lruTail = entry->prev;
+    }
+    entry->prev = nullptr;
+    entry->next = nullptr;
 }
 
 void BedrockPlugin_Cache::LRUMap::pushMRU(const string& name) {
-    // See if if it's already there
-    lock_guard<decltype(_mutex)> lock(_mutex);
-    map<string, Entry*>::iterator mapIt = _lruMap.find(name);
-    if (mapIt == _lruMap.end()) {
-        // Not in the map -- add a new entry
-        Entry* entry = new Entry;
-        entry->name = name;
+    const size_t hashValue = hash<string>{}(name);
+    Shard& shard = _shards[hashValue & (SHARD_COUNT - 1)];
 
-        // Insert into the map and list, retaining iterators to both
-        entry->mapIt = _lruMap.insert(std::pair<string, Entry*>(name, entry)).first;
-        entry->listIt = _lruList.insert(_lruList.end(), entry);
+    // The sequence is taken outside the lock; it only needs to be monotonic enough for popLRU to compare shard
+    // heads, not to serialize with other shards.
+    const uint64_t sequence = _sequence.fetch_add(1);
+    lock_guard<mutex> lock(shard.shardMutex);
+    Entry** slot = _findSlot(shard, name, hashValue);
+    Entry* entry = *slot;
+    if (entry && entry != tombstone()) {
+        // Already tracked, just move to the MRU end of the list.
+        _unlink(shard, entry);
     } else {
-        // Already in the map, just move to the end of the list
-        Entry* entry = mapIt->second;
-        _lruList.erase(entry->listIt);
-        entry->listIt = _lruList.insert(_lruList.end(), entry);
+        // Not tracked -- add a new entry. Reusing a tombstone doesn't lengthen any probe chain, so it doesn't count
+        // against the occupancy limit.
+        if (!entry) {
+            shard.occupied++;
+        }
+        entry = new Entry;
+        entry->name = name;
+        entry->hash = hashValue;
+        *slot = entry;
+        shard.count++;
+        if (shard.occupied * 4 > shard.slots.size() * 3) {
+            _grow(shard);
+        }
     }
+    entry->sequence = sequence;
+    _linkMRU(shard, entry);
 }
 
 // ==========================================================================
@@ -66,18 +160,133 @@ void BedrockPlugin_Cache::LRUMap::pushMRU(const string& name) {
 // a bool of whether or not the cache was empty when we tried to pop. If the
 // cache is empty, the LRU item will be an empty string and the bool will be false.
 pair<string, bool> BedrockPlugin_Cache::LRUMap::popLRU() {
-    // Make sure we're not empty
-    lock_guard<decltype(_mutex)> lock(_mutex);
-    if (empty()) {
-        return make_pair("", false);
+    while (true) {
+        // Find the shard whose least-recent entry is globally oldest. Shards are locked one at a time, so another
+        // thread can touch an entry between our scan and the pop below; in that case we just evict whatever is that
+        // shard's LRU by then, which is as close to global LRU order as matters for cache eviction.
+        size_t best = SHARD_COUNT;
+        uint64_t bestSequence = UINT64_MAX;
+        for (size_t i = 0; i < SHARD_COUNT; i++) {
+            lock_guard<mutex> lock(_shards[i].shardMutex);
+            if (_shards[i].lruHead && _shards[i].lruHead->sequence < bestSequence) {
+                bestSequence = _shards[i].lruHead->sequence;
+                best = i;
+            }
+        }
+        if (best == SHARD_COUNT) {
+            return make_pair("", false);
+        }
+        Shard& shard = _shards[best];
+        lock_guard<mutex> lock(shard.shardMutex);
+        Entry* entry = shard.lruHead;
+        if (!entry) {
+            // Another popLRU drained this shard after our scan; rescan.
+            continue;
+        }
+        _unlink(shard, entry);
+        Entry** slot = _findSlot(shard, entry->name, entry->hash);
+        SASSERT(*slot == entry);
+        *slot = tombstone();
+        shard.count--;
+        if (entry->hasValue) {
+            _memoryBytes -= entry->value.size();
+        }
+        string nameCopy = move(entry->name);
+        delete entry;
+        return make_pair(nameCopy, true);
+    }
+}
+
+void BedrockPlugin_Cache::LRUMap::setValue(const string& name, const string& value) {
+    if (!_maxMemoryBytes) {
+        return;
+    }
+    const size_t hashValue = hash<string>{}(name);
+    Shard& shard = _shards[hashValue & (SHARD_COUNT - 1)];
+    lock_guard<mutex> lock(shard.shardMutex);
+    Entry** slot = _findSlot(shard, name, hashValue);
+    Entry* entry = *slot;
+    if (!entry || entry == tombstone()) {
+        return;
+    }
+    if (entry->hasValue) {
+        _memoryBytes -= entry->value.size();
+    }
+    entry->value = value;
+    entry->hasValue = true;
+    _memoryBytes += value.size();
+
+    // If that pushed us over budget, shed this shard's least-recent values (sparing the one we just stored).
+    Entry* victim = shard.lruHead;
+    while (_memoryBytes.load() > _maxMemoryBytes && victim) {
+        if (victim->hasValue && victim != entry) {
+            _memoryBytes -= victim->value.size();
+            victim->value = string();
+            victim->hasValue = false;
+        }
+        victim = victim->next;
     }
-    // Take the first item off the list
-    Entry* entry = _lruList.front();
-    _lruList.erase(entry->listIt);
-    _lruMap.erase(entry->mapIt);
-    string nameCopy = entry->name;
-    delete entry;
-    return make_pair(nameCopy, true);
+}
+
+void BedrockPlugin_Cache::LRUMap::clearValue(const string& name) {
+    const size_t hashValue = hash<string>{}(name);
+    Shard& shard = _shards[hashValue & (SHARD_COUNT - 1)];
+    lock_guard<mutex> lock(shard.shardMutex);
+    Entry** slot = _findSlot(shard, name, hashValue);
+    Entry* entry = *slot;
+    if (entry && entry != tombstone() && entry->hasValue) {
+        _memoryBytes -= entry->value.size();
+        entry->value = string();
+        entry->hasValue = false;
+    }
+}
+
+void BedrockPlugin_Cache::LRUMap::invalidate(const string& namePattern) {
+    // fnmatch (without FNM_PATHNAME) matches the same '*', '?', and '[]' syntax SQLite GLOB does. Walking every
+    // entry is fine here; invalidation is rare compared to reads.
+    for (Shard& shard : _shards) {
+        lock_guard<mutex> lock(shard.shardMutex);
+        for (Entry* entry = shard.lruHead; entry; entry = entry->next) {
+            if (entry->hasValue && !fnmatch(namePattern.c_str(), entry->name.c_str(), 0)) {
+                _memoryBytes -= entry->value.size();
+                entry->value = string();
+                entry->hasValue = false;
+            }
+        }
+    }
+}
+
+void BedrockPlugin_Cache::LRUMap::clearAllValues() {
+    if (!_memoryBytes.load()) {
+        return;
+    }
+    for (Shard& shard : _shards) {
+        lock_guard<mutex> lock(shard.shardMutex);
+        for (Entry* entry = shard.lruHead; entry; entry = entry->next) {
+            if (entry->hasValue) {
+                _memoryBytes -= entry->value.size();
+                entry->value = string();
+                entry->hasValue = false;
+            }
+        }
+    }
+}
+
+bool BedrockPlugin_Cache::LRUMap::peekValue(const string& name, string& value) {
+    const size_t hashValue = hash<string>{}(name);
+    Shard& shard = _shards[hashValue & (SHARD_COUNT - 1)];
+    const uint64_t sequence = _sequence.fetch_add(1);
+    lock_guard<mutex> lock(shard.shardMutex);
+    Entry** slot = _findSlot(shard, name, hashValue);
+    Entry* entry = *slot;
+    if (!entry || entry == tombstone() || !entry->hasValue) {
+        return false;
+    }
+    value = entry->value;
+    entry->sequence = sequence;
+    _unlink(shard, entry);
+    _linkMRU(shard, entry);
+    return true;
 }
 
 int64_t BedrockPlugin_Cache::initCacheSize(string cacheString) {
@@ -100,8 +309,28 @@ int64_t BedrockPlugin_Cache::initCacheSize(string cacheString) {
     return maxCacheSize;
 }
 
+int64_t BedrockPlugin_Cache::initSize(string sizeString, int64_t defaultSize, const string& argName) {
+    // Same suffix handling as initCacheSize, with a caller-supplied default.
+    const string& size = SToUpper(sizeString);
+    int64_t bytes = SToInt64(size);
+    if (SEndsWith(size, "KB"))
+        bytes *= 1024;
+    if (SEndsWith(size, "MB"))
+        bytes *= 1024 * 1024;
+    if (SEndsWith(size, "GB"))
+        bytes *= 1024 * 1024 * 1024;
+    if (!bytes) {
+        SINFO("No " << argName << " specified, defaulting to " << defaultSize << " bytes");
+        bytes = defaultSize;
+    }
+    SASSERT(bytes > 0);
+    return bytes;
+}
+
 BedrockPlugin_Cache::BedrockPlugin_Cache(BedrockServer& s)
-    : BedrockPlugin(s), _maxCacheSize(initCacheSize(server.args["-cache.max"]))
+    : BedrockPlugin(s), _maxCacheSize(initCacheSize(server.args["-cache.max"])),
+      _maxMemValueSize(initSize(server.args["-cache.memValueMax"], 64 * 1024, "-cache.memValueMax")),
+      _lruMap(initSize(server.args["-cache.memMax"], 256 * 1024 * 1024, "-cache.memMax"))
 {
 }
 
@@ -112,6 +341,29 @@ BedrockPlugin_Cache::~BedrockPlugin_Cache() {
 #undef SLOGPREFIX
 #define SLOGPREFIX "{" << getName() << "} "
 
+list<BedrockPlugin::BackgroundTask> BedrockPlugin_Cache::backgroundTasks() {
+    // Walk the cache table in rowid slices, materializing each row, purely to fault its pages into the SQLite page
+    // cache while the server is idle: after a restart (or a day of page churn) the first client reads hit warm
+    // pages instead of disk. Reads only -- the memory tier isn't touched, since its values are only coherent while
+    // leading and this can run in any node state.
+    BackgroundTask prime;
+    prime.name = "primePageCache";
+    prime.intervalS = 24 * 60 * 60;
+    auto cursor = make_shared<int64_t>(0);
+    prime.work = [cursor](SQLite& db) {
+        SQResult result;
+        if (!db.read("SELECT rowid, value FROM cache WHERE rowid > " + SQ(*cursor) + " ORDER BY rowid LIMIT 100;",
+                     result) || result.empty()) {
+            // Done (or unreadable); start over from the top next time.
+            *cursor = 0;
+            return false;
+        }
+        *cursor = SToInt64(result[result.size() - 1][0]);
+        return true;
+    };
+    return {prime};
+}
+
 void BedrockPlugin_Cache::upgradeDatabase(SQLite& db) {
     // Create or verify the cache table
     bool ignore;
@@ -123,30 +375,39 @@ void BedrockPlugin_Cache::upgradeDatabase(SQLite& db) {
         SASSERT(db.write("DROP TABLE cache;"));
     }
 
-    // Add a one row, one column table to keep track of the current size of the cache
-    SASSERT(db.verifyTable("cacheSize", "CREATE TABLE cacheSize ( size INTEGER )", ignore));
-    SQResult result;
-    SASSERT(db.read("SELECT * FROM cacheSize;", result));
-    if (result.empty()) {
-        // Insert the first (and only) row into the cache
-        SASSERT(db.write("INSERT INTO cacheSize VALUES ( 0 );"));
-    }
+    // The cache size is tracked in memory now (see _cacheSize); drop the old trigger-maintained bookkeeping row,
+    // which doubled the write amplification of the cache tier - every cache operation paid a second B-tree write
+    // and its journal bytes just to keep one number current.
+    SASSERT(db.write("DROP TRIGGER IF EXISTS cacheOnInsert;"));
+    SASSERT(db.write("DROP TRIGGER IF EXISTS cacheOnUpdate;"));
+    SASSERT(db.write("DROP TRIGGER IF EXISTS cacheOnDelete;"));
+    SASSERT(db.write("DROP TABLE IF EXISTS cacheSize;"));
 
-    // Add the triggers to track the cache size.  (Enable recursive triggers so
-    // INSERT OR REPLACE triggers a delete when replacing.)
-    SASSERT(db.write("PRAGMA recursive_triggers = 1;"));
-    SASSERT(db.write("CREATE TRIGGER IF NOT EXISTS cacheOnInsert AFTER INSERT ON cache "
-                     "BEGIN "
-                     "UPDATE cacheSize SET size = size + LENGTH( NEW.value ); "
-                     "END;"));
-    SASSERT(db.write("CREATE TRIGGER IF NOT EXISTS cacheOnUpdate AFTER UPDATE ON cache "
-                     "BEGIN "
-                     "UPDATE cacheSize SET size = size - LENGTH( OLD.value ) + LENGTH( NEW.value ); "
-                     "END;"));
-    SASSERT(db.write("CREATE TRIGGER IF NOT EXISTS cacheOnDelete AFTER DELETE ON cache "
-                     "BEGIN "
-                     "UPDATE cacheSize SET size = size - LENGTH( OLD.value ); "
-                     "END;"));
+    // Reconcile the in-memory counter from the table. This runs on every standup, so any drift the counter picked
+    // up (from a rolled-back transaction that had already adjusted it) clears the next time we lead.
+    _cacheSize.store(SToInt64(db.read("SELECT COALESCE(SUM(LENGTH(value)), 0) FROM cache;")));
+}
+
+bool BedrockCacheCommand::peekable() {
+    // Only an exact-name ReadCache can be answered from the memory tier, and only while leading or standing down
+    // (see peek below for why the tier can't be trusted on a follower). Anything else — GLOB patterns, misses,
+    // malformed requests — falls through to the normal peek path, which handles validation and error responses.
+    if (!SIEquals(request.getVerb(), "ReadCache")) {
+        return false;
+    }
+    const string& name = request["name"];
+    if (name.empty() || name.size() > BedrockPlugin::MAX_SIZE_SMALL || name.find_first_of("*?[") != string::npos) {
+        return false;
+    }
+    SQLiteNode::State nodeState = plugin().server.getState().load();
+    if (nodeState != SQLiteNode::LEADING && nodeState != SQLiteNode::STANDINGDOWN) {
+        return false;
+    }
+    if (plugin()._lruMap.peekValue(name, response.content)) {
+        response["name"] = name;
+        return true;
+    }
+    return false;
 }
 
 bool BedrockCacheCommand::peek(SQLite& db) {
@@ -168,6 +429,22 @@ bool BedrockCacheCommand::peek(SQLite& db) {
         const string& name = request["name"];
         crashIdentifyingValues.insert("name");
 
+        // The memory tier can only be trusted while leading (or standing down): a follower applies replicated
+        // writes straight to the DB, with nothing to invalidate values it cached from its own reads. If we're not
+        // leading, skip the tier and drop anything it still holds from when we were.
+        SQLiteNode::State nodeState = plugin().server.getState().load();
+        bool canUseMemTier = (nodeState == SQLiteNode::LEADING || nodeState == SQLiteNode::STANDINGDOWN);
+        if (!canUseMemTier) {
+            plugin()._lruMap.clearAllValues();
+        }
+
+        // An exact name (no GLOB metacharacters) can be answered straight from the memory tier, with no DB access.
+        if (canUseMemTier && name.find_first_of("*?[") == string::npos
+            && plugin()._lruMap.peekValue(name, response.content)) {
+            response["name"] = name;
+            return true;
+        }
+
         // Get the list
         SQResult result;
         if (!db.read("SELECT name, value "
@@ -189,8 +466,12 @@ bool BedrockCacheCommand::peek(SQLite& db) {
             response["name"] = result[0][0];
             response.content = result[0][1];
 
-            // Update the LRU Map
+            // Update the LRU Map, keeping the value in the memory tier if it's small enough so the next read of
+            // this name never touches the DB. Reads only ever see committed rows, so this fill is always current.
             plugin()._lruMap.pushMRU(response["name"]);
+            if (canUseMemTier && (int64_t)response.content.size() <= plugin()._maxMemValueSize) {
+                plugin()._lruMap.setValue(response["name"], response.content);
+            }
             return true;
         }
     }
@@ -248,24 +529,68 @@ void BedrockCacheCommand::process(SQLite& db) {
         // Note that we will leave these items in the lruMap in memory, but
         // that's non-harmful.
         if (!request["invalidateName"].empty()) {
+            // Measure what we're about to remove, so the in-memory size counter stays right.
+            int64_t invalidatedBytes = SToInt64(db.read("SELECT COALESCE(SUM(LENGTH(value)), 0) FROM cache "
+                                                        "WHERE name GLOB " + SQ(request["invalidateName"]) + ";"));
             if (!db.write("DELETE FROM cache WHERE name GLOB " + SQ(request["invalidateName"]) + ";"))
                 STHROW("502 Query failed (invalidating)");
+            plugin()._cacheSize.fetch_sub(invalidatedBytes);
+
+            // The memory tier must drop these values too, or reads would keep serving them.
+            plugin()._lruMap.invalidate(request["invalidateName"]);
         }
 
-        // Clear out room for the new object
-        while (SToInt64(db.read("SELECT size FROM cacheSize;")) + contentSize > plugin()._maxCacheSize) {
-            // Find the least recently used (LRU) item if there is one.  (If the server was recently restarted,
-            // its LRU might not be fully populated.)
-            auto popResult = plugin()._lruMap.popLRU();
-            const string& name = (popResult.second ? popResult.first : db.read("SELECT name FROM cache LIMIT 1"));
-            SASSERT(!name.empty());
+        // Clear out room for the new object. The overage is computed once, then LRU victims are popped and measured
+        // in batches until they cover it, and the whole set is deleted with a single statement - so a large write
+        // into a full cache pays for one DELETE, not one per victim.
+        int64_t overage = plugin()._cacheSize.load() + contentSize - plugin()._maxCacheSize;
+        if (overage > 0) {
+            const size_t evictionBatchSize = 16;
+            list<string> victims;
+            int64_t reclaimed = 0;
+            while (reclaimed < overage) {
+                // Pop a batch of least recently used (LRU) items if there are any. (If the server was recently
+                // restarted, its LRU might not be fully populated.)
+                list<string> batch;
+                for (size_t i = 0; i < evictionBatchSize; i++) {
+                    auto popResult = plugin()._lruMap.popLRU();
+                    if (!popResult.second) {
+                        break;
+                    }
+                    batch.push_back(popResult.first);
+                }
+                if (batch.empty()) {
+                    // The LRU is empty; evict arbitrary rows we haven't already picked.
+                    SQResult fallback;
+                    if (!db.read("SELECT name FROM cache " +
+                                 string(victims.empty() ? "" : "WHERE name NOT IN (" + SQList(victims) + ") ") +
+                                 "LIMIT " + SQ((int64_t)evictionBatchSize) + ";",
+                                 fallback)) {
+                        STHROW("502 Query failed (finding eviction victims)");
+                    }
+                    for (const auto& row : fallback) {
+                        batch.emplace_back(row[0]);
+                    }
+                    SASSERT(!batch.empty());
+                }
 
-            // Delete it
-            if (!db.write("DELETE FROM cache WHERE name=" + SQ(name) + ";")) {
+                // One query sizes the whole batch. Stale LRU names that aren't in the table just contribute zero.
+                reclaimed += SToInt64(db.read("SELECT COALESCE(SUM(LENGTH(value)), 0) "
+                                              "FROM cache WHERE name IN (" + SQList(batch) + ");"));
+                victims.splice(victims.end(), batch);
+            }
+
+            // Delete them all at once
+            if (!db.write("DELETE FROM cache WHERE name IN (" + SQList(victims) + ");")) {
                 STHROW("502 Query failed (deleting)");
             }
+            plugin()._cacheSize.fetch_sub(reclaimed);
         }
 
+        // The bytes this write replaces, if the name already exists (INSERT OR REPLACE drops the old row). A point
+        // read, which is still far cheaper than the B-tree write the bookkeeping trigger used to pay here.
+        int64_t replacedBytes = SToInt64(db.read("SELECT LENGTH(value) FROM cache WHERE name = " + SQ(name) + ";"));
+
         // Insert the new entry
         const string& safeValue = SQ(valueHeader.empty() ? request.content : valueHeader);
         if (!db.write("INSERT OR REPLACE INTO cache ( name, value ) "
@@ -273,12 +598,19 @@ void BedrockCacheCommand::process(SQLite& db) {
                       SQ(name) + ", " + safeValue + " );")) {
                           STHROW("502 Query failed (inserting)");
                       }
+        plugin()._cacheSize.fetch_add(contentSize - replacedBytes);
 
-        // Writing is a form of "use", so this is the new MRU.  Note that we're
-        // adding it to the MRU, even before we commit.  So if this transaction
-        // gets rolled back for any reason, the MRU will have a record for a
-        // name that isn't in the database.  But that is fine.
+        // Writing is a form of "use", so this is the new MRU, and small values are written through to the memory
+        // tier so reads of this name never touch the row we just wrote. Larger ones instead drop any value the tier
+        // already holds for this name, which would otherwise go stale. Note that we're updating the map even before
+        // we commit. So if this transaction gets rolled back for any reason, the tier can briefly disagree with the
+        // database; a commit conflict re-runs process() and re-stores the right value.
         plugin()._lruMap.pushMRU(name);
+        if (contentSize <= plugin()._maxMemValueSize) {
+            plugin()._lruMap.setValue(name, valueHeader.empty() ? request.content : valueHeader);
+        } else {
+            plugin()._lruMap.clearValue(name);
+        }
         return;
     }
 }
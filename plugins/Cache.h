@@ -11,14 +11,25 @@ class BedrockPlugin_Cache : public BedrockPlugin {
     // Implement base class interface
     virtual const string& getName() const;
     virtual void upgradeDatabase(SQLite& db);
+    virtual list<BackgroundTask> backgroundTasks();
     virtual unique_ptr<BedrockCommand> getCommand(SQLiteCommand&& baseCommand);
     static const string name;
 
-    // Bedrock Cache LRU map
+    // Bedrock Cache LRU map. Sharded by name hash so concurrent ReadCache/WriteCache traffic from many workers
+    // doesn't serialize on a single lock: each shard is an open-addressing hash table whose entries carry their own
+    // LRU list links, so a pushMRU is one short per-shard lock, one probe sequence, and a few pointer swaps. popLRU
+    // evicts from the shard whose least-recent entry has the oldest global sequence number, which keeps eviction
+    // order exact within a shard and near-exact across them.
+    //
+    // Entries can also carry their cached value, making this a memory tier in front of the `cache` table: ReadCache
+    // answers exact-name hits straight from here with no DB access, with SQLite as the spill and persistence layer.
+    // The tier is write-through and best-effort - a value can be dropped at any time to stay under the RAM budget,
+    // and a miss just falls back to the table.
     class LRUMap {
       public:
-        // Constructor / Destructor
-        LRUMap();
+        // Constructor / Destructor. `maxMemoryBytes` is the RAM budget for cached values; zero disables the memory
+        // tier (names are still tracked for eviction order).
+        LRUMap(int64_t maxMemoryBytes = 0);
         ~LRUMap();
 
         // Tests if anything is in the map
@@ -30,32 +41,98 @@ class BedrockPlugin_Cache : public BedrockPlugin {
         // Remove the name that is the least recently used (LRU)
         pair<string, bool> popLRU();
 
+        // Store a value in the memory tier for a tracked name. A no-op if the name isn't tracked (it can be evicted
+        // between a pushMRU and this call) or the tier is disabled.
+        void setValue(const string& name, const string& value);
+
+        // Drop the memory-tier value for one exact name, if any. Used when the name's row is overwritten with
+        // something too big to keep in RAM.
+        void clearValue(const string& name);
+
+        // Drop every memory-tier value whose name matches a GLOB pattern. Used when WriteCache invalidates rows.
+        void invalidate(const string& namePattern);
+
+        // Drop every memory-tier value (cheaply skipped when none are held). Used when the node stops leading and
+        // its values can no longer be kept coherent.
+        void clearAllValues();
+
+        // Exact-name memory-tier lookup: on a hit, fills `value`, marks the name MRU, and returns true.
+        bool peekValue(const string& name, string& value);
+
       private:
-        // A single entry being tracked
+        // A single entry being tracked: a slot in its shard's hash table, with intrusive links into that shard's
+        // LRU list (prev is toward the least recently used end), optionally holding the memory-tier value.
         struct Entry {
-            // Attributes
             string name;
-            list<Entry*>::iterator listIt;
-            map<string, Entry*>::iterator mapIt;
+            size_t hash = 0;
+            uint64_t sequence = 0;
+            bool hasValue = false;
+            string value;
+            Entry* prev = nullptr;
+            Entry* next = nullptr;
+        };
+
+        // Both must be powers of two.
+        static const size_t SHARD_COUNT = 16;
+        static const size_t INITIAL_SLOTS = 64;
+
+        // One lock's worth of the map. `slots` is open-addressed with linear probing; erased slots hold a tombstone
+        // so probe chains keep walking past them, and the table grows at 3/4 occupancy (live plus tombstones) so a
+        // probe always terminates.
+        struct Shard {
+            mutex shardMutex;
+            vector<Entry*> slots = vector<Entry*>(INITIAL_SLOTS, nullptr);
+            size_t count = 0;         // live entries
+            size_t occupied = 0;      // live entries plus tombstones
+            Entry* lruHead = nullptr; // least recently used
+            Entry* lruTail = nullptr; // most recently used
         };
 
+        // The marker stored in slots whose entry was erased.
+        static Entry* tombstone();
+
+        // Internal helpers; all assume the shard's mutex is held. _findSlot returns the slot holding `name` if it's
+        // present, or the slot where it should be inserted (an empty slot or a reusable tombstone) if not.
+        Entry** _findSlot(Shard& shard, const string& name, size_t hash);
+        void _grow(Shard& shard);
+        void _linkMRU(Shard& shard, Entry* entry);
+        void _unlink(Shard& shard, Entry* entry);
+
         // Attributes
-        recursive_mutex _mutex;
-        list<Entry*> _lruList;
-        map<string, Entry*> _lruMap;
+        Shard _shards[SHARD_COUNT];
+        atomic<uint64_t> _sequence{1};
+
+        // The RAM budget for cached values and the bytes currently held against it. When a setValue pushes the
+        // total over budget, the storing shard drops its own least-recent values; name hashing spreads stores
+        // uniformly, so every shard sheds its share over time without any cross-shard locking.
+        const int64_t _maxMemoryBytes;
+        atomic<int64_t> _memoryBytes{0};
     };
 
     static int64_t initCacheSize(string cacheString);
+    static int64_t initSize(string sizeString, int64_t defaultSize, const string& argName);
 
     // Constants
     const int64_t _maxCacheSize;
+    const int64_t _maxMemValueSize;
     LRUMap _lruMap;
+
+    // Total bytes of value data in the `cache` table, maintained in memory by WriteCache so the eviction check can
+    // consult the budget without a trigger-maintained bookkeeping row (which cost every cache write a second B-tree
+    // write plus its journal bytes). Only read on leader, where the writes happen; reconciled from the table on
+    // every standup in upgradeDatabase, which also clears any drift from a rolled-back transaction that had already
+    // adjusted it (the same caveat the memory tier documents above).
+    atomic<int64_t> _cacheSize{0};
     static const set<string, STableComp> supportedRequestVerbs;
+
+  public:
+    virtual const set<string, STableComp>& supportedVerbs() const { return supportedRequestVerbs; }
 };
 
 class BedrockCacheCommand : public BedrockCommand {
   public:
     BedrockCacheCommand(SQLiteCommand&& baseCommand, BedrockPlugin_Cache* plugin);
+    virtual bool peekable();
     virtual bool peek(SQLite& db);
     virtual void process(SQLite& db);
 
@@ -5,6 +5,12 @@
 #define SLOGPREFIX "{" << getName() << "} "
 
 const string BedrockPlugin_DB::name("DB");
+
+const set<string, STableComp>& BedrockPlugin_DB::supportedVerbs() const {
+    static const set<string, STableComp> verbs = {"Query"};
+    return verbs;
+}
+
 const string& BedrockPlugin_DB::getName() const {
     return name;
 }
@@ -76,6 +82,14 @@ bool BedrockDBCommand::peek(SQLite& db) {
         return false;
     }
 
+    // In streaming mode, rows are serialized and flushed to the client in bounded chunks while sqlite3_step is
+    // still producing them, so a huge analytical SELECT never sits in RAM as SQResult, serialization, and socket
+    // buffer all at once. Quietly falls back to the buffered path when this client can't take a stream.
+    if (request.test("Stream") && _plugin->server.canStreamResponse(*this)) {
+        _streamQueryResults(db);
+        return true;
+    }
+
     // Attempt the read-only query
     SQResult result;
     int preChangeCount = db.getChangeCount();
@@ -102,6 +116,127 @@ bool BedrockDBCommand::peek(SQLite& db) {
     return true; // Successfully peeked
 }
 
+// Appends `data` to `out` as one Transfer-Encoding:chunked-style chunk: the length in hex, CRLF, the data, CRLF.
+// Empty data is skipped, since an empty chunk is the end-of-stream marker.
+static void _appendChunk(string& out, const string& data) {
+    if (data.empty()) {
+        return;
+    }
+    string length = SToHex((uint64_t)data.size());
+    out += length.substr(min(length.find_first_not_of('0'), length.size() - 1));
+    out += "\r\n";
+    out += data;
+    out += "\r\n";
+}
+
+void BedrockDBCommand::_streamQueryResults(SQLite& db) {
+    BedrockServer& server = _plugin->server;
+    const bool json = SIEquals(request["Format"], "json");
+
+    // Flush whenever this much of the body has accumulated: small enough to bound memory, big enough that framing
+    // and send overhead don't matter.
+    static const size_t CHUNK_SIZE = 64 * 1024;
+
+    int preChangeCount = db.getChangeCount();
+    string buffer;
+    bool clientGone = false;
+    uint64_t rowCount = 0;
+    vector<string> headers;
+
+    // `responseStreamed` doubles as our "header's been sent" flag: it only goes true once the response header is on
+    // the wire, which is also exactly when the server has to stop sending `response` itself.
+    bool ok = db.readStreaming(query, headers, [&](const vector<string>& row) {
+        if (!responseStreamed) {
+            // First row: the query compiled and is producing results, so commit to streaming. The header goes out
+            // before we know the query will finish cleanly -- that's the price of never materializing the result.
+            // Clients that asked to Stream read body chunks until the empty terminator, and ignore the Content-Length
+            // (which is for the empty `response.content`).
+            response.methodLine = "200 OK";
+            response["nodeName"] = server.args["-nodeName"];
+            response["Transfer-Encoding"] = "chunked";
+            if (!server.streamToClient(*this, response.serialize())) {
+                clientGone = true;
+                return false;
+            }
+            responseStreamed = true;
+
+            // Body prefix; the fully-decoded body comes out byte-identical to what SQResult::serialize builds.
+            if (json) {
+                buffer += "{\"headers\":" + SComposeJSONArray(headers) + ",\"rows\":[";
+            } else {
+                buffer += SComposeList(headers, " | ") + "\n";
+            }
+        }
+        if (json) {
+            if (rowCount) {
+                buffer += ",";
+            }
+            buffer += SComposeJSONArray(row);
+        } else {
+            buffer += SComposeList(row, " | ") + "\n";
+        }
+        rowCount++;
+        if (buffer.size() >= CHUNK_SIZE) {
+            string framed;
+            _appendChunk(framed, buffer);
+            buffer.clear();
+            if (!server.streamToClient(*this, framed)) {
+                clientGone = true;
+                return false;
+            }
+        }
+        return true;
+    });
+
+    // Same corruption check as the buffered path.
+    if (preChangeCount != db.getChangeCount()) {
+        SERROR("Read query actually managed to write; database is corrupt "
+               << "and must be recovered from backup or peer.  Offending query: '" << query << "'");
+    }
+
+    if (clientGone) {
+        // The client hung up mid-stream; stepping was cut short, and there's nobody left to send anything to.
+        SINFO("Client disconnected after " << rowCount << " streamed rows, aborted query.");
+        return;
+    }
+
+    if (!ok) {
+        if (!responseStreamed) {
+            // The query failed before producing anything; fail exactly like the buffered path would.
+            SALERT("Query failed: '" << query << "'");
+            response["error"] = db.getLastError();
+            STHROW("502 Query failed");
+        }
+
+        // The query failed mid-stream, after the 200 and some rows already went out, so it's too late for an error
+        // response. All we can do is withhold the terminating chunk and drop the connection, which is how the
+        // client learns the result was truncated.
+        SALERT("Query failed after streaming " << rowCount << " rows: '" << query << "'");
+        server.abortClientStream(*this);
+        return;
+    }
+
+    if (!responseStreamed) {
+        // The query succeeded without producing a single row, so nothing's been sent and we can reply with an
+        // ordinary buffered (empty) result.
+        SQResult result;
+        result.headers = headers;
+        response.content = result.serialize(request["Format"]);
+        return;
+    }
+
+    // Close out the body: the suffix, whatever's left in the buffer, and the empty terminating chunk.
+    if (json) {
+        buffer += "]}";
+    }
+    string framed;
+    _appendChunk(framed, buffer);
+    framed += "0\r\n\r\n";
+    if (!server.streamToClient(*this, framed)) {
+        SINFO("Client disconnected before the last chunk of " << rowCount << " streamed rows.");
+    }
+}
+
 void BedrockDBCommand::process(SQLite& db) {
     if (db.getUpdateNoopMode()) {
         SINFO("Query run in mocked request, just ignoring.");
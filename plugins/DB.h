@@ -7,6 +7,10 @@ class BedrockPlugin_DB : public BedrockPlugin {
     BedrockPlugin_DB(BedrockServer& s);
     virtual const string& getName() const;
     virtual unique_ptr<BedrockCommand> getCommand(SQLiteCommand&& baseCommand);
+
+    // Only the exact "Query" verb is indexable; "query:..." methodLines are a prefix match, which the server's
+    // fallback probe handles.
+    virtual const set<string, STableComp>& supportedVerbs() const;
     static const string name;
 };
 
@@ -17,5 +21,9 @@ class BedrockDBCommand : public BedrockCommand {
     virtual void process(SQLite& db);
 
   private:
+    // Runs the (already classified read-only) query, streaming rows to the client in bounded chunks while sqlite is
+    // still producing them. Only called when `BedrockServer::canStreamResponse` says this client can take one.
+    void _streamQueryResults(SQLite& db);
+
     const string query;
 };
@@ -1,5 +1,6 @@
 #include "Jobs.h"
 #include "../BedrockServer.h"
+#include "../sqlitecluster/SQLitePlanMonitor.h"
 
 #undef SLOGPREFIX
 #define SLOGPREFIX "{" << getName() << "} "
@@ -58,8 +59,53 @@ BedrockJobsCommand::BedrockJobsCommand(SQLiteCommand&& baseCommand, BedrockPlugi
 
 BedrockPlugin_Jobs::BedrockPlugin_Jobs(BedrockServer& s) :
     BedrockPlugin(s),
-    isLive(server.args.isSet("-live"))
+    isLive(server.args.isSet("-live")),
+    _heldCommandsSweepTimer(STIME_US_PER_S)
 {
+    timers.insert(&_heldCommandsSweepTimer);
+}
+
+void BedrockPlugin_Jobs::holdCommand(unique_ptr<BedrockCommand>&& command) {
+    SINFO("Holding '" << command->request.methodLine << "' for '" << command->request["name"] << "'.");
+    list<string> names = SParseList(command->request["name"]);
+    lock_guard<mutex> lock(_heldCommandsMutex);
+    _heldCommands.emplace_back(move(names), move(command));
+}
+
+void BedrockPlugin_Jobs::timerFired(SStopwatch* timer) {
+    if (timer == &_heldCommandsSweepTimer) {
+        wakeWaitingCommands("*");
+    }
+}
+
+void BedrockPlugin_Jobs::wakeWaitingCommands(const string& name) {
+    // Collect the matches under the lock, but hand them back to the server outside it - acceptCommand can do real
+    // work, and holdCommand can be called re-entrantly if a worker re-peeks one of these before we finish.
+    list<unique_ptr<BedrockCommand>> wake;
+    {
+        lock_guard<mutex> lock(_heldCommandsMutex);
+        auto it = _heldCommands.begin();
+        while (it != _heldCommands.end()) {
+            bool matches = (name == "*");
+            for (const string& waitingFor : it->first) {
+                if (matches) {
+                    break;
+                }
+                // A held pattern with GLOB metacharacters is woken for any name rather than evaluating the GLOB
+                // here; the re-peek sorts out whether it really matched.
+                matches = (waitingFor == name) || waitingFor.find_first_of("*?[") != string::npos;
+            }
+            if (matches) {
+                wake.push_back(move(it->second));
+                it = _heldCommands.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+    for (auto& command : wake) {
+        server.acceptCommand(unique_ptr<SQLiteCommand>(move(command)), false);
+    }
 }
 
 unique_ptr<BedrockCommand> BedrockPlugin_Jobs::getCommand(SQLiteCommand&& baseCommand) {
@@ -71,16 +117,23 @@ unique_ptr<BedrockCommand> BedrockPlugin_Jobs::getCommand(SQLiteCommand&& baseCo
 
 int64_t BedrockPlugin_Jobs::getNextID(SQLite& db)
 {
+    // If the allocator is seeded, IDs come straight from an atomic increment: no table reads to find a free ID, and
+    // no two concurrent CreateJobs can pick the same one. Everything already in the table is below the seed point.
+    if (_nextJobID.load()) {
+        return _nextJobID.fetch_add(1);
+    }
+
+    // Unseeded (we haven't stood up as leader, or the table's existing IDs leave no headroom); probe random IDs.
     int64_t newID = 0;
     while (!newID) {
         // Make sure this fits even in a signed int64_t, and is positive.
-        newID = SRandom::rand64();
+        newID = SRandom::fast64();
         if (newID < 0) {
             newID = -newID;
         }
         newID %= INT64_MAX;
-        string result = db.read( "SELECT jobID FROM jobs WHERE jobID = " + to_string(newID) + ";");
-        if (!result.empty()) {
+        if (!db.read("SELECT jobID FROM jobs WHERE jobID = " + to_string(newID) + ";").empty() ||
+            !db.read("SELECT jobID FROM jobsCompleted WHERE jobID = " + to_string(newID) + ";").empty()) {
             // This one exists! Pick a new one.
             newID = 0;
         }
@@ -88,6 +141,178 @@ int64_t BedrockPlugin_Jobs::getNextID(SQLite& db)
     return newID;
 }
 
+// ==========================================================================
+const string& BedrockJobsIndex::getName() const {
+    static const string name("Jobs");
+    return name;
+}
+
+void BedrockJobsIndex::rebuild(SQLite& db) {
+    // This is a full scan of the runnable portion of the table, but it's satisfied entirely from the
+    // jobsStatePriorityNextRunName index and only runs on leader standup.
+    SQResult result;
+    SASSERT(db.read("SELECT jobID, name, priority, nextRun "
+                    "FROM jobs "
+                    "WHERE state IN ('QUEUED', 'RUNQUEUED') AND JSON_EXTRACT(data, '$.mockRequest') IS NULL;",
+                    result));
+    lock_guard<mutex> lock(_mutex);
+    _byName.clear();
+    _byJob.clear();
+    for (const auto& row : result) {
+        _update(SToInt64(row[0]), string(row[1]), SToInt64(row[2]), string(row[3]));
+    }
+    _usable.store(true);
+    SINFO("Rebuilt runnable job index with " << _byJob.size() << " entries.");
+}
+
+list<BedrockJobsIndex::Candidate> BedrockJobsIndex::peek(const list<string>& names, const string& now, size_t limit,
+                                                         int64_t priority) {
+    // Collect up to `limit` candidates from each requested name (each name's bands are already in priority DESC,
+    // nextRun ASC order), then merge across names and truncate.
+    vector<Candidate> found;
+    {
+        lock_guard<mutex> lock(_mutex);
+        for (const string& name : names) {
+            auto nameIt = _byName.find(name);
+            if (nameIt == _byName.end()) {
+                continue;
+            }
+            size_t taken = 0;
+            for (const auto& band : nameIt->second) {
+                if (priority != -1 && band.first != priority) {
+                    continue;
+                }
+                for (const auto& entry : band.second) {
+                    if (entry.first > now) {
+                        // This band is nextRun-ordered, so nothing later in it is runnable yet.
+                        break;
+                    }
+                    found.push_back({entry.second, name, band.first, entry.first});
+                    if (++taken >= limit) {
+                        break;
+                    }
+                }
+                if (taken >= limit) {
+                    break;
+                }
+            }
+        }
+    }
+    stable_sort(found.begin(), found.end(), [](const Candidate& a, const Candidate& b) {
+        return a.priority != b.priority ? a.priority > b.priority : a.nextRun < b.nextRun;
+    });
+    if (found.size() > limit) {
+        found.resize(limit);
+    }
+    return list<Candidate>(found.begin(), found.end());
+}
+
+void BedrockJobsIndex::update(int64_t jobID, const string& name, int64_t priority, const string& nextRun) {
+    lock_guard<mutex> lock(_mutex);
+    _update(jobID, name, priority, nextRun);
+}
+
+void BedrockJobsIndex::remove(int64_t jobID) {
+    lock_guard<mutex> lock(_mutex);
+    _remove(jobID);
+}
+
+void BedrockJobsIndex::updateFromDB(SQLite& db, int64_t jobID) {
+    if (!_usable.load()) {
+        return;
+    }
+    SQResult result;
+    if (!db.read("SELECT name, priority, nextRun, state, JSON_EXTRACT(data, '$.mockRequest') IS NOT NULL "
+                 "FROM jobs "
+                 "WHERE jobID=" + SQ(jobID) + ";",
+                 result)) {
+        // Leave the entry alone; a stale entry is filtered at claim time anyway.
+        return;
+    }
+    if (result.empty() || (!SIEquals(result[0][3], "QUEUED") && !SIEquals(result[0][3], "RUNQUEUED"))
+        || result[0][4] == "1") {
+        remove(jobID);
+    } else {
+        update(jobID, string(result[0][0]), SToInt64(result[0][1]), string(result[0][2]));
+    }
+}
+
+void BedrockJobsIndex::updateChildrenFromDB(SQLite& db, int64_t parentJobID) {
+    if (!_usable.load()) {
+        return;
+    }
+    SQResult result;
+    if (!db.read("SELECT jobID FROM jobs WHERE parentJobID != 0 AND parentJobID=" + SQ(parentJobID) +
+                 " AND state='QUEUED';", result)) {
+        return;
+    }
+    for (const auto& row : result) {
+        updateFromDB(db, SToInt64(row[0]));
+    }
+}
+
+void BedrockJobsIndex::updateManyFromDB(SQLite& db, const list<int64_t>& jobIDs) {
+    if (!_usable.load() || jobIDs.empty()) {
+        return;
+    }
+    SQResult result;
+    if (!db.read("SELECT jobID, name, priority, nextRun, state, JSON_EXTRACT(data, '$.mockRequest') IS NOT NULL "
+                 "FROM jobs "
+                 "WHERE jobID IN (" + SQList(jobIDs) + ");",
+                 result)) {
+        // Leave the entries alone; stale entries are filtered at claim time anyway.
+        return;
+    }
+    map<int64_t, size_t> rowByJobID;
+    for (size_t i = 0; i < result.size(); i++) {
+        rowByJobID[SToInt64(result[i][0])] = i;
+    }
+    lock_guard<mutex> lock(_mutex);
+    for (int64_t jobID : jobIDs) {
+        auto it = rowByJobID.find(jobID);
+        if (it == rowByJobID.end()) {
+            _remove(jobID);
+            continue;
+        }
+        const auto& row = result[it->second];
+        if ((!SIEquals(row[4], "QUEUED") && !SIEquals(row[4], "RUNQUEUED")) || row[5] == "1") {
+            _remove(jobID);
+        } else {
+            _update(jobID, string(row[1]), SToInt64(row[2]), string(row[3]));
+        }
+    }
+}
+
+void BedrockJobsIndex::_update(int64_t jobID, const string& name, int64_t priority, const string& nextRun) {
+    _remove(jobID);
+    _byName[name][priority].emplace(nextRun, jobID);
+    _byJob[jobID] = make_tuple(name, priority, nextRun);
+}
+
+void BedrockJobsIndex::_remove(int64_t jobID) {
+    auto it = _byJob.find(jobID);
+    if (it == _byJob.end()) {
+        return;
+    }
+    const string& name = get<0>(it->second);
+    int64_t priority = get<1>(it->second);
+    const string& nextRun = get<2>(it->second);
+    auto nameIt = _byName.find(name);
+    if (nameIt != _byName.end()) {
+        auto bandIt = nameIt->second.find(priority);
+        if (bandIt != nameIt->second.end()) {
+            bandIt->second.erase(make_pair(nextRun, jobID));
+            if (bandIt->second.empty()) {
+                nameIt->second.erase(bandIt);
+            }
+        }
+        if (nameIt->second.empty()) {
+            _byName.erase(nameIt);
+        }
+    }
+    _byJob.erase(it);
+}
+
 // ==========================================================================
 void BedrockPlugin_Jobs::upgradeDatabase(SQLite& db) {
     // Create or verify the jobs table
@@ -106,10 +331,99 @@ void BedrockPlugin_Jobs::upgradeDatabase(SQLite& db) {
                                "parentJobID INTEGER NOT NULL DEFAULT 0, "
                                "retryAfter  TEXT NOT NULL DEFAULT \"\")",
                            ignore));
+    // Completed jobs (FINISHED and CANCELLED children awaiting their parent, plus FAILED jobs) live in a separate
+    // table with the same columns, so the live table and its indexes only cover rows a GetJob scan could actually
+    // want, and stay cache-resident no matter how much terminal history accumulates. Rows move between the tables
+    // inside the same transaction as the state change that made them terminal (or live again).
+    SASSERT(db.verifyTable("jobsCompleted",
+                           "CREATE TABLE jobsCompleted ( "
+                               "created     TIMESTAMP NOT NULL, "
+                               "jobID       INTEGER NOT NULL PRIMARY KEY, "
+                               "state       TEXT NOT NULL, "
+                               "name        TEXT NOT NULL, "
+                               "nextRun     TIMESTAMP NOT NULL, "
+                               "lastRun     TIMESTAMP, "
+                               "repeat      TEXT NOT NULL, "
+                               "data        TEXT NOT NULL, "
+                               "priority    INTEGER NOT NULL DEFAULT " + SToStr(JOBS_DEFAULT_PRIORITY) + ", "
+                               "parentJobID INTEGER NOT NULL DEFAULT 0, "
+                               "retryAfter  TEXT NOT NULL DEFAULT \"\")",
+                           ignore));
+
     // verify and conditionally create indexes
     SASSERT(db.verifyIndex("jobsName", "jobs", "( name )", false, !BedrockPlugin_Jobs::isLive));
     SASSERT(db.verifyIndex("jobsParentJobIDState", "jobs", "( parentJobID, state ) WHERE parentJobID != 0", false, !BedrockPlugin_Jobs::isLive));
     SASSERT(db.verifyIndex("jobsStatePriorityNextRunName", "jobs", "( state, priority, nextRun, name )", false, !BedrockPlugin_Jobs::isLive));
+    SASSERT(db.verifyIndex("jobsCompletedName", "jobsCompleted", "( name )", false, !BedrockPlugin_Jobs::isLive));
+    SASSERT(db.verifyIndex("jobsCompletedParentJobIDState", "jobsCompleted", "( parentJobID, state ) WHERE parentJobID != 0", false, !BedrockPlugin_Jobs::isLive));
+
+    // Migrate any terminal rows still in the live table. This is a one-time cost on the first standup after this
+    // table is introduced; after that, the set here is empty.
+    if (!db.read("SELECT 1 FROM jobs WHERE state IN ('FINISHED', 'CANCELLED', 'FAILED') LIMIT 1;").empty()) {
+        SINFO("Migrating terminal rows from jobs to jobsCompleted.");
+        SASSERT(db.write("INSERT INTO jobsCompleted SELECT * FROM jobs WHERE state IN ('FINISHED', 'CANCELLED', 'FAILED');"));
+        SASSERT(db.write("DELETE FROM jobs WHERE state IN ('FINISHED', 'CANCELLED', 'FAILED');"));
+    }
+
+    // Watch GetJob's scan for plan regressions: after an ANALYZE run or stat drift, the planner has been seen
+    // abandoning jobsStatePriorityNextRunName in production, which nothing notices until latency does. A
+    // representative instance is enough -- the plan depends on the statement's shape, not its literal values. The pin
+    // target lets the monitor force the index back with INDEXED BY once a regression is detected (see the fallback
+    // query in GetJob).
+    SQLitePlanMonitor::registerQuery("GetJob",
+        "SELECT jobID, name, data, parentJobID, retryAfter, created, repeat, lastRun, nextRun "
+        "FROM jobs "
+        "WHERE state IN ('QUEUED', 'RUNQUEUED') "
+            "AND priority=500 "
+            "AND '2000-01-01 00:00:00'>=nextRun "
+            "AND +name GLOB '*' "
+        "ORDER BY nextRun ASC LIMIT 1;",
+        "jobs", "jobsStatePriorityNextRunName");
+    SQLitePlanMonitor::captureBaselines(db);
+
+    // (Re)build the in-memory runnable job index. This runs on leader standup, so it also heals any entries the
+    // index lost to rolled-back transactions since the last rebuild.
+    jobsIndex.rebuild(db);
+
+    // Seed the in-memory jobID allocator just past the current maximum, so CreateJob never probes the table for a
+    // free ID. Tables created before sequential allocation can hold random IDs near the top of the int64 range; if
+    // there's not enough headroom left above MAX(jobID), leave the allocator unseeded and keep the probing fallback.
+    int64_t maxJobID = SToInt64(db.read("SELECT COALESCE(MAX(maxID), 0) FROM "
+                                        "(SELECT MAX(jobID) maxID FROM jobs "
+                                         "UNION ALL SELECT MAX(jobID) FROM jobsCompleted);"));
+    if (maxJobID < INT64_MAX - (1ll << 40)) {
+        _nextJobID.store(maxJobID + 1);
+        SINFO("Seeded jobID allocator at " << (maxJobID + 1) << ".");
+    } else {
+        _nextJobID.store(0);
+        SWARN("MAX(jobID) is " << maxJobID << ", not enough headroom for sequential jobIDs; keeping random allocation.");
+    }
+}
+
+void BedrockPlugin_Jobs::onPrepareToLead(SQLite& db) {
+    // GetJob's scan is served by the jobsStatePriorityNextRunName index, so walk the whole index once to fault its
+    // pages in before the first burst of GetJob traffic arrives. The `state >= ''` constraint keeps SQLite on the
+    // named index (every state matches, so this reads every entry).
+    uint64_t start = STimeNow();
+    string indexedRows = db.read("SELECT COUNT(*) FROM jobs INDEXED BY jobsStatePriorityNextRunName WHERE state >= '';");
+
+    // GetJob also reads `data` from the table itself, so touch the table B-tree too. Reading a non-indexed column
+    // forces a real row fetch rather than an index-only count.
+    db.read("SELECT COUNT(LENGTH(data)) FROM jobs;");
+    SINFO("Warmed jobs table and jobsStatePriorityNextRunName (" << indexedRows << " rows) in "
+          << (STimeNow() - start) / 1000 << "ms.");
+}
+
+// Moves any rows matching `where` from one of the jobs tables to the other (the two have identical columns). Used
+// when a state change makes a row terminal (jobs -> jobsCompleted) or live again (jobsCompleted -> jobs).
+static void _moveJobs(SQLite& db, const string& from, const string& to, const string& where) {
+    if (db.read("SELECT 1 FROM " + from + " WHERE " + where + " LIMIT 1;").empty()) {
+        return;
+    }
+    if (!db.writeIdempotent("INSERT INTO " + to + " SELECT * FROM " + from + " WHERE " + where + ";") ||
+        !db.writeIdempotent("DELETE FROM " + from + " WHERE " + where + ";")) {
+        STHROW("502 Failed to move jobs between live and completed tables");
+    }
 }
 
 // ==========================================================================
@@ -162,6 +476,22 @@ bool BedrockJobsCommand::peek(SQLite& db) {
             _validatePriority(priority);
         }
 
+        // Long-polling: rather than answering "404 No job found" and letting the worker immediately poll again,
+        // `BlockUntilAvailable: <timeoutMs>` parks the command with the plugin when nothing matches. It's re-queued
+        // (and re-peeked) when a matching job lands, when the plugin's sweep timer next fires, or when the deadline
+        // passes, whichever comes first - a re-peek that finds the table still empty with time remaining just parks
+        // again. The absolute deadline is pinned on the first peek so re-parks can't extend it. Mocked requests
+        // never block; tests want their 404s immediately.
+        if (request.isSet("BlockUntilAvailable") && !mockRequest) {
+            if (!_blockUntil) {
+                int64_t blockMs = min(request.calc64("BlockUntilAvailable"), (int64_t)BedrockPlugin_Jobs::MAX_BLOCK_MS);
+                _blockUntil = blockMs > 0 ? STimeNow() + blockMs * STIME_US_PER_MS : 1;
+            }
+            if (STimeNow() < _blockUntil && !_anyJobAvailable(db)) {
+                requestHold = true;
+            }
+        }
+
         return false;
     }
 
@@ -196,6 +526,15 @@ bool BedrockJobsCommand::peek(SQLite& db) {
                      result)) {
             STHROW("502 Select failed");
         }
+        if (result.empty()) {
+            // Not live; it may have completed.
+            if (!db.read("SELECT created, jobID, state, name, nextRun, lastRun, repeat, data, retryAfter, priority "
+                         "FROM jobsCompleted "
+                         "WHERE jobID=" + SQ(request.calc64("jobID")) + ";",
+                         result)) {
+                STHROW("502 Select failed");
+            }
+        }
         if (result.empty()) {
             STHROW("404 No job with this jobID");
         }
@@ -283,7 +622,7 @@ bool BedrockJobsCommand::peek(SQLite& db) {
                 // not. Note that this is the first place we'll look at `mockRequest` while handling this command so
                 // any change made here will happen early enough for all of our existing checks to work correctly, and
                 // everything should be good when we get to `processCommand`.
-                STable parentData = SParseJSONObject(result[0][1]);
+                STable parentData = SParseJSONObject(string(result[0][1]));
                 bool parentIsMocked = parentData.find("mockRequest") != parentData.end();
                 bool childIsMocked = request.isSet("mockRequest");
 
@@ -340,12 +679,23 @@ bool BedrockJobsCommand::peek(SQLite& db) {
         int64_t jobID = request.calc64("jobID");
 
         SQResult result;
-        if (!db.read("SELECT j.jobID, j.state, j.parentJobID, (SELECT COUNT(1) FROM jobs WHERE parentJobID != 0 AND parentJobID=" + SQ(jobID) + ") children "
+        const string childCount = "(SELECT (SELECT COUNT(1) FROM jobs WHERE parentJobID != 0 AND parentJobID=" + SQ(jobID) + ") + "
+                                          "(SELECT COUNT(1) FROM jobsCompleted WHERE parentJobID != 0 AND parentJobID=" + SQ(jobID) + ")) children ";
+        if (!db.read("SELECT j.jobID, j.state, j.parentJobID, " + childCount +
                      "FROM jobs j "
                      "WHERE j.jobID=" + SQ(jobID) + ";",
                      result)) {
             STHROW("502 Select failed");
         }
+        if (result.empty()) {
+            // The job may be a completed (e.g., FAILED) child.
+            if (!db.read("SELECT j.jobID, j.state, j.parentJobID, " + childCount +
+                         "FROM jobsCompleted j "
+                         "WHERE j.jobID=" + SQ(jobID) + ";",
+                         result)) {
+                STHROW("502 Select failed");
+            }
+        }
 
         // Verify the job exists
         if (result.empty() || result[0][0].empty()) {
@@ -389,6 +739,11 @@ void BedrockJobsCommand::process(SQLite& db) {
     // Pull out some helpful variables
     const string& requestVerb = request.getVerb();
 
+    // The in-memory runnable job index. GetJob peeks it for candidates, and every verb below that changes a job's
+    // runnability updates it from its own writes (all no-ops until the index is built on leader standup).
+    BedrockPlugin_Jobs& jobsPlugin = *static_cast<BedrockPlugin_Jobs*>(_plugin);
+    BedrockJobsIndex& jobsIndex = jobsPlugin.jobsIndex;
+
     if (SIEquals(requestVerb, "CreateJob") || SIEquals(requestVerb, "CreateJobs")) {
         // - CreateJob( name, [data], [firstRun], [repeat], [jobPriority], [unique], [parentJobID], [retryAfter] )
         //
@@ -469,6 +824,7 @@ void BedrockJobsCommand::process(SQLite& db) {
             }
 
             int64_t updateJobID = 0;
+            string updateJobTable = "jobs";
             if (SContains(job, "unique") && job["unique"] == "true") {
                 SQResult result;
                 SINFO("Unique flag was passed, checking existing job with name " << job["name"] << ", mocked? "
@@ -481,6 +837,17 @@ void BedrockJobsCommand::process(SQLite& db) {
                              result)) {
                     STHROW("502 Select failed");
                 }
+                if (result.empty()) {
+                    // No live job by this name; a completed (e.g., FAILED) one still counts as existing.
+                    if (!db.read("SELECT jobID, data "
+                                 "FROM jobsCompleted "
+                                 "WHERE name=" + SQ(job["name"]) +
+                                 "  AND JSON_EXTRACT(data, '$.mockRequest') " + operation + " NULL;",
+                                 result)) {
+                        STHROW("502 Select failed");
+                    }
+                    updateJobTable = "jobsCompleted";
+                }
 
                 // If we got a result, and it's data is the same as passed, we won't change anything.
                 if (!result.empty() && ((job["data"].empty() && result[0][1] == "{}") || (!job["data"].empty() && result[0][1] == job["data"]))) {
@@ -494,7 +861,7 @@ void BedrockJobsCommand::process(SQLite& db) {
                     }
 
                     // Append new jobID to list of created jobs.
-                    jobIDs.push_back(result[0][0]);
+                    jobIDs.emplace_back(result[0][0]);
                     continue;
                 }
 
@@ -543,6 +910,12 @@ void BedrockJobsCommand::process(SQLite& db) {
                 if (!db.read("SELECT state, parentJobID, data FROM jobs WHERE jobID=" + SQ(parentJobID) + ";", result)) {
                     STHROW("502 Select failed");
                 }
+                if (result.empty()) {
+                    // A completed parent (e.g., FAILED) still exists; it just fails the state check below.
+                    if (!db.read("SELECT state, parentJobID, data FROM jobsCompleted WHERE jobID=" + SQ(parentJobID) + ";", result)) {
+                        STHROW("502 Select failed");
+                    }
+                }
                 if (result.empty()) {
                     STHROW("404 parentJobID does not exist");
                 }
@@ -552,7 +925,7 @@ void BedrockJobsCommand::process(SQLite& db) {
                 }
 
                 // Verify that the parent and child job have the same `mockRequest` setting.
-                STable parentData = SParseJSONObject(result[0][2]);
+                STable parentData = SParseJSONObject(string(result[0][2]));
                 if (mockRequest != (parentData.find("mockRequest") != parentData.end())) {
                     STHROW("405 Parent and child jobs must have matching mockRequest setting");
                 }
@@ -567,7 +940,7 @@ void BedrockJobsCommand::process(SQLite& db) {
             // Are we creating a new job, or updating an existing job?
             if (updateJobID) {
                 // Update the existing job.
-                if(!db.writeIdempotent("UPDATE jobs SET "
+                if(!db.writeIdempotent("UPDATE " + updateJobTable + " SET "
                                          "repeat   = " + SQ(SToUpper(job["repeat"])) + ", " +
                                          "data     = JSON_PATCH(data, " + safeData + "), " +
                                          "priority = " + SQ(priority) + " " +
@@ -576,6 +949,9 @@ void BedrockJobsCommand::process(SQLite& db) {
                     STHROW("502 update query failed");
                 }
 
+                // The job's priority (and hence its index position) may have changed.
+                jobsIndex.updateFromDB(db, updateJobID);
+
                 // If we are calling CreateJob, return early, there are no more jobs to create.
                 if (SIEquals(requestVerb, "CreateJob")) {
                     jsonContent["jobID"] = SToStr(updateJobID);
@@ -602,7 +978,7 @@ void BedrockJobsCommand::process(SQLite& db) {
                 const string& safeRetryAfter = SContains(job, "retryAfter") && !job["retryAfter"].empty() ? SQ(job["retryAfter"]) : SQ("");
 
                 // Create this new job with a new generated ID
-                const int64_t jobIDToUse = BedrockPlugin_Jobs::getNextID(db);
+                const int64_t jobIDToUse = static_cast<BedrockPlugin_Jobs*>(_plugin)->getNextID(db);
                 SINFO("Next jobID to be used " << jobIDToUse);
                 if (!db.writeIdempotent("INSERT INTO jobs ( jobID, created, state, name, nextRun, repeat, data, priority, parentJobID, retryAfter ) "
                          "VALUES( " +
@@ -621,6 +997,13 @@ void BedrockJobsCommand::process(SQLite& db) {
                     STHROW("502 insert query failed");
                 }
 
+                // Index the new job if it's runnable (PAUSED children and mocked jobs won't be), and wake anything
+                // parked waiting on this name (a PAUSED child can't satisfy a waiter, so don't bother for those).
+                jobsIndex.updateFromDB(db, jobIDToUse);
+                if (SIEquals(initialState, "QUEUED") && !mockRequest) {
+                    jobsPlugin.wakeWaitingCommands(job["name"]);
+                }
+
                 if (SIEquals(requestVerb, "CreateJob")) {
                     jsonContent["jobID"] = SToStr(jobIDToUse);
                     return;
@@ -633,10 +1016,7 @@ void BedrockJobsCommand::process(SQLite& db) {
 
         jsonContent["jobIDs"] = SComposeJSONArray(jobIDs);
 
-        // Release workers waiting on this state
-        // TODO: No "HeldBy" anymore. If a plugin wants to hold a command, it should own it until it's done.
-        // node->clearCommandHolds("Jobs:" + request["name"]);
-
+        // Workers parked on these names were released as each job was inserted above.
         return; // Successfully processed
     }
 
@@ -651,10 +1031,70 @@ void BedrockJobsCommand::process(SQLite& db) {
         // works!
         SQResult result;
         const list<string> nameList = SParseList(request["name"]);
-        string safeNumResults = SQ(max(request.calc("numResults"),1));
+        size_t numResults = max(request.calc("numResults"), 1);
+        string safeNumResults = SQ((int64_t)numResults);
         mockRequest = mockRequest || request.isSet("getMockedJobs");
+
+        // Try the in-memory index first. It only holds exact names, so a name with GLOB metacharacters has to take
+        // the query below, as do requests for mocked jobs (which are never indexed). Every candidate the index hands
+        // back is re-read from SQLite (a rowid point lookup) before we'll return it, so stale entries cost us a point
+        // lookup, never a wrong answer.
+        bool exactNames = nameList.size() > 1 || request["name"].find_first_of("*?[") == string::npos;
+        if (jobsIndex.usable() && !mockRequest && exactNames) {
+            int64_t priorityFilter = request.isSet("jobPriority") ? request.calc64("jobPriority") : -1;
+            string now = SUNQUOTED_CURRENT_TIMESTAMP();
+            set<int64_t> seenJobIDs;
+
+            // A few passes: stale candidates get corrected as we discover them, so the next peek sees past them.
+            for (int pass = 0; pass < 5 && result.size() < numResults; pass++) {
+                list<BedrockJobsIndex::Candidate> candidates =
+                    jobsIndex.peek(nameList, now, numResults + seenJobIDs.size(), priorityFilter);
+                list<string> candidateIDs;
+                for (const auto& candidate : candidates) {
+                    if (seenJobIDs.insert(candidate.jobID).second) {
+                        candidateIDs.push_back(SToStr(candidate.jobID));
+                    }
+                }
+                if (candidateIDs.empty()) {
+                    break;
+                }
+                SQResult verified;
+                if (!db.read("SELECT jobID, name, data, parentJobID, retryAfter, created, repeat, lastRun, nextRun "
+                             "FROM jobs "
+                             "WHERE jobID IN (" + SQList(candidateIDs) + ") "
+                                 "AND state IN ('QUEUED', 'RUNQUEUED') "
+                                 "AND " + SCURRENT_TIMESTAMP() + ">=nextRun "
+                                 "AND JSON_EXTRACT(data, '$.mockRequest') IS NULL "
+                             "ORDER BY priority DESC, nextRun ASC "
+                             "LIMIT " + SQ((int64_t)(numResults - result.size())) + ";",
+                             verified)) {
+                    STHROW("502 Query failed");
+                }
+
+                // Candidates the verify query didn't return are stale - claimed, finished, deleted, or rescheduled
+                // out from under the index - so fix their entries before the next peek.
+                set<string> verifiedIDs;
+                for (const auto& row : verified) {
+                    verifiedIDs.emplace(row[0]);
+                    result.addRow(row);
+                }
+                for (const string& candidateID : candidateIDs) {
+                    if (!verifiedIDs.count(candidateID)) {
+                        jobsIndex.updateFromDB(db, SToInt64(candidateID));
+                    }
+                }
+            }
+        }
+
+        // If the index couldn't fill the request - disabled, bypassed, out of candidates, or missing entries - run
+        // the original query. Fewer rows than asked for is not authoritative: index mutations made inside a
+        // transaction survive a rollback, so a conflict-retried GetJob can leave a still-QUEUED job evicted from the
+        // index, and only the table can see it. Rerunning the query from scratch also beats deduplicating against a
+        // partial index result.
         string selectQuery;
-        if (request.isSet("jobPriority")) {
+        if (result.size() >= numResults) {
+            // The index filled the request; skip the query.
+        } else if (request.isSet("jobPriority")) {
             selectQuery =
                 "SELECT jobID, name, data, parentJobID, retryAfter, created, repeat, lastRun, nextRun "
                 "FROM jobs "
@@ -703,8 +1143,11 @@ void BedrockJobsCommand::process(SQLite& db) {
                 "ORDER BY priority DESC "
                 "LIMIT " + safeNumResults + ";";
         }
-        if (!db.read(selectQuery, result)) {
-            STHROW("502 Query failed");
+        if (!selectQuery.empty()) {
+            result.clear();
+            if (!db.read(SQLitePlanMonitor::pin("GetJob", selectQuery), result)) {
+                STHROW("502 Query failed");
+            }
         }
 
         // Are there any results?
@@ -751,12 +1194,14 @@ void BedrockJobsCommand::process(SQLite& db) {
                 job["nextRun"] = result[c][8];
                 retriableJobs.push_back(job);
             } else {
-                nonRetriableJobs.push_back(result[c][0]);
+                nonRetriableJobs.emplace_back(result[c][0]);
             }
 
             // See if this job has any FINISHED/CANCELLED child jobs, indicating it is being resumed
             SQResult childJobs;
-            if (!db.read("SELECT jobID, data, state FROM jobs WHERE parentJobID != 0 AND parentJobID=" + result[c][0] + " AND state IN ('FINISHED', 'CANCELLED');", childJobs)) {
+            if (!db.read("SELECT jobID, data, state FROM jobs WHERE parentJobID != 0 AND parentJobID=" + string(result[c][0]) + " AND state IN ('FINISHED', 'CANCELLED') "
+                         "UNION ALL "
+                         "SELECT jobID, data, state FROM jobsCompleted WHERE parentJobID != 0 AND parentJobID=" + string(result[c][0]) + " AND state IN ('FINISHED', 'CANCELLED');", childJobs)) {
                 STHROW("502 Failed to select finished child jobs");
             }
 
@@ -764,7 +1209,7 @@ void BedrockJobsCommand::process(SQLite& db) {
                 // Add arrays of children jobs to our response, 2 arrays to clearly distinguish between finished and cancelled children.
                 list<string> finishedChildJobArray;
                 list<string> cancelledChildJobArray;
-                for (auto row : childJobs.rows) {
+                for (const auto& row : childJobs) {
                     STable childJob;
                     childJob["jobID"] = row[0];
                     childJob["data"] = row[1];
@@ -791,23 +1236,40 @@ void BedrockJobsCommand::process(SQLite& db) {
             if (!db.writeIdempotent(updateQuery)) {
                 STHROW("502 Update failed");
             }
+
+            // These jobs are RUNNING now; drop them from the runnable index.
+            for (const string& jobID : nonRetriableJobs) {
+                jobsIndex.remove(SToInt64(jobID));
+            }
         }
 
         if (!retriableJobs.empty()) {
+            // Each job's new nextRun depends on its own retryAfter and repeat, but we can still claim the whole batch
+            // with a single UPDATE by computing the per-job values in a CASE expression, rather than paying the
+            // statement overhead once per job.
             SINFO("Updating jobs with retryAfter");
-            for (auto job : retriableJobs) {
-                string currentTime = SUNQUOTED_CURRENT_TIMESTAMP();
+            string currentTime = SUNQUOTED_CURRENT_TIMESTAMP();
+            list<string> retriableJobIDs;
+            string nextRunCases;
+            for (auto& job : retriableJobs) {
                 string retryAfterDateTime = "DATETIME(" + SQ(currentTime) + ", " + SQ(job["retryAfter"]) + ")";
                 string repeatDateTime = _constructNextRunDATETIME(job["nextRun"], currentTime, job["repeat"]);
                 string nextRunDateTime = repeatDateTime != "" ? "MIN(" + retryAfterDateTime + ", " + repeatDateTime + ")" : retryAfterDateTime;
-                string updateQuery = "UPDATE jobs "
-                                     "SET state='RUNQUEUED', "
-                                         "lastRun=" + SQ(currentTime) + ", "
-                                         "nextRun=" + nextRunDateTime + " "
-                                     "WHERE jobID = " + SQ(job["jobID"]) + ";";
-                if (!db.writeIdempotent(updateQuery)) {
-                    STHROW("502 Update failed");
-                }
+                nextRunCases += "WHEN " + SQ(job["jobID"]) + " THEN " + nextRunDateTime + " ";
+                retriableJobIDs.push_back(job["jobID"]);
+            }
+            string updateQuery = "UPDATE jobs "
+                                 "SET state='RUNQUEUED', "
+                                     "lastRun=" + SQ(currentTime) + ", "
+                                     "nextRun=CASE jobID " + nextRunCases + "END "
+                                 "WHERE jobID IN (" + SQList(retriableJobIDs) + ");";
+            if (!db.writeIdempotent(updateQuery)) {
+                STHROW("502 Update failed");
+            }
+
+            // Still RUNQUEUED, but with recomputed nextRuns; re-read them so the index agrees.
+            for (const string& jobID : retriableJobIDs) {
+                jobsIndex.updateFromDB(db, SToInt64(jobID));
             }
         }
 
@@ -815,7 +1277,7 @@ void BedrockJobsCommand::process(SQLite& db) {
         if (SIEquals(requestVerb, "GetJob")) {
             // Single response
             SASSERT(jobList.size() == 1);
-            response.content = jobList.front();
+            response.content = move(jobList.front());
         } else {
             // Multiple responses
             SASSERT(SIEquals(requestVerb, "GetJobs"));
@@ -856,7 +1318,8 @@ void BedrockJobsCommand::process(SQLite& db) {
             _validatePriority(priority);
         }
 
-        // Verify there is a job like this
+        // Verify there is a job like this (a completed one can still have its data updated in place).
+        string updateJobTable = "jobs";
         SQResult result;
         if (!db.read("SELECT jobID, nextRun, lastRun "
                      "FROM jobs "
@@ -864,12 +1327,21 @@ void BedrockJobsCommand::process(SQLite& db) {
                      result)) {
             STHROW("502 Select failed");
         }
+        if (result.empty()) {
+            if (!db.read("SELECT jobID, nextRun, lastRun "
+                         "FROM jobsCompleted "
+                         "WHERE jobID=" + SQ(request.calc64("jobID")) + ";",
+                         result)) {
+                STHROW("502 Select failed");
+            }
+            updateJobTable = "jobsCompleted";
+        }
         if (result.empty() || !SToInt64(result[0][0])) {
             STHROW("404 No job with this jobID");
         }
 
-        const string& nextRun = result[0][1];
-        const string& lastRun = result[0][2];
+        const string nextRun(result[0][1]);
+        const string lastRun(result[0][2]);
 
         // Passed next run takes priority over the one computed via the repeat feature
         string newNextRun;
@@ -880,7 +1352,7 @@ void BedrockJobsCommand::process(SQLite& db) {
         }
 
         // Update the data
-        if (!db.writeIdempotent("UPDATE jobs "
+        if (!db.writeIdempotent("UPDATE " + updateJobTable + " "
                                 "SET data=" +
                                 SQ(request["data"]) + " " +
                                 (request["repeat"].size() ? ", repeat=" + SQ(SToUpper(request["repeat"])) : "") +
@@ -890,6 +1362,9 @@ void BedrockJobsCommand::process(SQLite& db) {
                                 SQ(request.calc64("jobID")) + ";")) {
             STHROW("502 Update failed");
         }
+
+        // The job's nextRun and/or priority may have changed.
+        jobsIndex.updateFromDB(db, request.calc64("jobID"));
         return; // Successfully processed
     }
 
@@ -938,17 +1413,31 @@ void BedrockJobsCommand::process(SQLite& db) {
                      result)) {
             STHROW("502 Select failed");
         }
+        if (result.empty()) {
+            // It may be in the completed table (e.g., a mocked job in a terminal state). If so, move it back to the
+            // live table so the updates below find it; if the state check below then throws, the move rolls back with
+            // the rest of the transaction.
+            if (!db.read("SELECT state, nextRun, lastRun, repeat, parentJobID, json_extract(data, '$.mockRequest'), retryAfter "
+                         "FROM jobsCompleted "
+                         "WHERE jobID=" + SQ(jobID) + ";",
+                         result)) {
+                STHROW("502 Select failed");
+            }
+            if (!result.empty()) {
+                _moveJobs(db, "jobsCompleted", "jobs", "jobID=" + SQ(jobID));
+            }
+        }
         if (result.empty()) {
             STHROW("404 No job with this jobID");
         }
 
-        const string& state = result[0][0];
-        const string& nextRun = result[0][1];
-        const string& lastRun = result[0][2];
-        string repeat = result[0][3];
+        const string state(result[0][0]);
+        const string nextRun(result[0][1]);
+        const string lastRun(result[0][2]);
+        string repeat(result[0][3]);
         int64_t parentJobID = SToInt64(result[0][4]);
         mockRequest = result[0][5] == "1";
-        const string retryAfter = result[0][6];
+        const string retryAfter(result[0][6]);
 
         // Make sure we're finishing a job that's actually running
         if (state != "RUNNING" && state != "RUNQUEUED" && !mockRequest) {
@@ -969,7 +1458,8 @@ void BedrockJobsCommand::process(SQLite& db) {
 
         // Delete any FINISHED/CANCELLED child jobs, but leave any PAUSED children alone (as those will signal that
         // we just want to re-PAUSE this job so those new children can run)
-        if (!db.writeIdempotent("DELETE FROM jobs WHERE parentJobID != 0 AND parentJobID=" + SQ(jobID) + " AND state IN ('FINISHED', 'CANCELLED');")) {
+        if (!db.writeIdempotent("DELETE FROM jobs WHERE parentJobID != 0 AND parentJobID=" + SQ(jobID) + " AND state IN ('FINISHED', 'CANCELLED');") ||
+            !db.writeIdempotent("DELETE FROM jobsCompleted WHERE parentJobID != 0 AND parentJobID=" + SQ(jobID) + " AND state IN ('FINISHED', 'CANCELLED');")) {
             STHROW("502 Failed deleting finished/cancelled child jobs");
         }
 
@@ -1016,6 +1506,20 @@ void BedrockJobsCommand::process(SQLite& db) {
                 STHROW("502 Child update failed");
             }
 
+            // The parent is PAUSED (drops out of the index) and its children just became runnable.
+            jobsIndex.remove(jobID);
+            jobsIndex.updateChildrenFromDB(db, jobID);
+
+            // Wake anything parked waiting on the names of the now-runnable children.
+            SQResult childNames;
+            if (db.read("SELECT DISTINCT name FROM jobs "
+                        "WHERE parentJobID != 0 AND parentJobID=" + SQ(jobID) + " AND state='QUEUED';",
+                        childNames)) {
+                for (const auto& row : childNames) {
+                    jobsPlugin.wakeWaitingCommands(string(row[0]));
+                }
+            }
+
             // All done processing this command
             return;
         }
@@ -1086,6 +1590,11 @@ void BedrockJobsCommand::process(SQLite& db) {
             if (!db.writeIdempotent("UPDATE jobs SET nextRun=" + safeNewNextRun + ", state='QUEUED' WHERE jobID=" + SQ(jobID) + ";")) {
                 STHROW("502 Update failed");
             }
+
+            // The job is runnable again (possibly under a new name or priority); re-read its row for the index, and
+            // wake anything parked waiting on its name.
+            jobsIndex.updateFromDB(db, jobID);
+            jobsPlugin.wakeWaitingCommands(!name.empty() ? name : db.read("SELECT name FROM jobs WHERE jobID=" + SQ(jobID) + ";"));
         } else {
             // We are done with this job.  What do we do with it?
             SASSERT(!SIEquals(requestVerb, "RetryJob"));
@@ -1094,6 +1603,8 @@ void BedrockJobsCommand::process(SQLite& db) {
                 if (!db.writeIdempotent("UPDATE jobs SET state='FINISHED' WHERE jobID=" + SQ(jobID) + ";")) {
                     STHROW("502 Failed to mark job as FINISHED");
                 }
+                _moveJobs(db, "jobs", "jobsCompleted", "jobID=" + SQ(jobID));
+                jobsIndex.remove(jobID);
 
                 // Resume the parent if this is the last pending child
                 if (!_hasPendingChildJobs(db, parentJobID)) {
@@ -1102,16 +1613,20 @@ void BedrockJobsCommand::process(SQLite& db) {
                     if (!db.writeIdempotent("UPDATE jobs SET state='QUEUED' where jobID=" + SQ(parentJobID) + ";")) {
                         STHROW("502 Update failed");
                     }
+                    jobsIndex.updateFromDB(db, parentJobID);
+                    jobsPlugin.wakeWaitingCommands(db.read("SELECT name FROM jobs WHERE jobID=" + SQ(parentJobID) + ";"));
                 }
             } else {
                 // This is a standalone (not a child) job; delete it.
                 if (!db.writeIdempotent("DELETE FROM jobs WHERE jobID=" + SQ(jobID) + ";")) {
                     STHROW("502 Delete failed");
                 }
+                jobsIndex.remove(jobID);
 
                 // At this point, all child jobs should already be deleted, but
                 // let's double check.
-                if (!db.read("SELECT 1 FROM jobs WHERE parentJobID != 0 AND parentJobID=" + SQ(jobID) + " LIMIT 1;").empty()) {
+                if (!db.read("SELECT 1 FROM jobs WHERE parentJobID != 0 AND parentJobID=" + SQ(jobID) + " LIMIT 1;").empty() ||
+                    !db.read("SELECT 1 FROM jobsCompleted WHERE parentJobID != 0 AND parentJobID=" + SQ(jobID) + " LIMIT 1;").empty()) {
                     STHROW("405 Failed to delete a job with outstanding children");
                 }
             }
@@ -1131,19 +1646,24 @@ void BedrockJobsCommand::process(SQLite& db) {
         //
         int64_t jobID = request.calc64("jobID");
 
-        // Cancel the job
-        if (!db.writeIdempotent("UPDATE jobs SET state='CANCELLED' WHERE jobID=" + SQ(jobID) + ";")) {
+        // Cancel the job wherever it lives (a FAILED child has already moved to the completed table), then make sure
+        // it ends up in the completed table.
+        if (!db.writeIdempotent("UPDATE jobs SET state='CANCELLED' WHERE jobID=" + SQ(jobID) + ";") ||
+            !db.writeIdempotent("UPDATE jobsCompleted SET state='CANCELLED' WHERE jobID=" + SQ(jobID) + ";")) {
             STHROW("502 Failed to update job data");
         }
+        _moveJobs(db, "jobs", "jobsCompleted", "jobID=" + SQ(jobID));
+        jobsIndex.remove(jobID);
 
         // If this was the last queued child, resume the parent
         SQResult result;
         if (!db.read("SELECT parentJobID "
-                     "FROM jobs "
+                     "FROM jobsCompleted "
                      "WHERE jobID=" + SQ(jobID) + ";",
                      result)) {
             STHROW("502 Select failed");
         }
+        int64_t parentJobID = SToInt64(result[0][0]);
         const string& safeParentJobID = SQ(result[0][0]);
         if (!db.read("SELECT count(1) "
                      "FROM jobs "
@@ -1157,6 +1677,8 @@ void BedrockJobsCommand::process(SQLite& db) {
             if (!db.writeIdempotent("UPDATE jobs SET state='QUEUED' WHERE jobID=" + safeParentJobID + ";")) {
                 STHROW("502 Failed to update job data");
             }
+            jobsIndex.updateFromDB(db, parentJobID);
+            jobsPlugin.wakeWaitingCommands(db.read("SELECT name FROM jobs WHERE jobID=" + safeParentJobID + ";"));
         }
 
         // All done processing this command
@@ -1184,10 +1706,19 @@ void BedrockJobsCommand::process(SQLite& db) {
                      result)) {
             STHROW("502 Select failed");
         }
+        if (result.empty()) {
+            // A completed job still exists; it just fails the state check below.
+            if (!db.read("SELECT state, nextRun, lastRun, repeat "
+                         "FROM jobsCompleted "
+                         "WHERE jobID=" + SQ(request.calc64("jobID")) + ";",
+                         result)) {
+                STHROW("502 Select failed");
+            }
+        }
         if (result.empty()) {
             STHROW("404 No job with this jobID");
         }
-        const string& state = result[0][0];
+        const string state(result[0][0]);
 
         // Make sure we're failing a job that's actually running or running with a retryAfter
         if (state != "RUNNING" && state != "RUNQUEUED") {
@@ -1209,6 +1740,8 @@ void BedrockJobsCommand::process(SQLite& db) {
         if (!db.writeIdempotent("UPDATE jobs SET " + SComposeList(updateList) + "WHERE jobID=" + SQ(request.calc64("jobID")) + ";")) {
             STHROW("502 Fail failed");
         }
+        _moveJobs(db, "jobs", "jobsCompleted", "jobID=" + SQ(request.calc64("jobID")));
+        jobsIndex.remove(request.calc64("jobID"));
 
         // Successfully processed
         return;
@@ -1226,7 +1759,8 @@ void BedrockJobsCommand::process(SQLite& db) {
         //
         BedrockPlugin::verifyAttributeInt64(request, "jobID", 1);
 
-        // Verify there is a job like this and it's not running
+        // Verify there is a job like this and it's not running (completed jobs, e.g. FAILED ones, are deletable too).
+        string deleteJobTable = "jobs";
         SQResult result;
         if (!db.read("SELECT state "
                      "FROM jobs "
@@ -1234,6 +1768,15 @@ void BedrockJobsCommand::process(SQLite& db) {
                      result)) {
             STHROW("502 Select failed");
         }
+        if (result.empty()) {
+            if (!db.read("SELECT state "
+                         "FROM jobsCompleted "
+                         "WHERE jobID=" + SQ(request.calc64("jobID")) + ";",
+                         result)) {
+                STHROW("502 Select failed");
+            }
+            deleteJobTable = "jobsCompleted";
+        }
         if (result.empty()) {
             STHROW("404 No job with this jobID");
         }
@@ -1245,11 +1788,12 @@ void BedrockJobsCommand::process(SQLite& db) {
         }
 
         // Delete the job
-        if (!db.writeIdempotent("DELETE FROM jobs "
+        if (!db.writeIdempotent("DELETE FROM " + deleteJobTable + " "
                       "WHERE jobID=" +
                       SQ(request.calc64("jobID")) + ";")) {
             STHROW("502 Delete failed");
         }
+        jobsIndex.remove(request.calc64("jobID"));
 
         // Successfully processed
         return;
@@ -1261,30 +1805,182 @@ void BedrockJobsCommand::process(SQLite& db) {
         list<int64_t> jobIDs = SParseIntegerList(request["jobIDs"]);
 
         if (jobIDs.size()) {
+            // Any of these jobs that already completed become live again.
+            _moveJobs(db, "jobsCompleted", "jobs", "jobID IN(" + SQList(jobIDs) + ")");
+
             const string& name = request["name"];
             string nameQuery = name.empty() ? "" : ", name = " + SQ(name) + "";
             string updateQuery = "UPDATE jobs SET state = 'QUEUED', nextRun = created"+ nameQuery +" WHERE jobID IN(" + SQList(jobIDs)+ ");";
             if (!db.writeIdempotent(updateQuery)) {
                 STHROW("502 RequeueJobs update failed");
             }
+
+            // The single UPDATE above transitions the whole set in one journal entry. The rest is bookkeeping from
+            // one bulk index refresh and one read-back over the same set (this SQLite predates UPDATE...RETURNING,
+            // so the read-back is a separate query): report per-job outcomes and wake anything parked on the
+            // requeued names, without the point lookup per job this used to cost.
+            jobsIndex.updateManyFromDB(db, jobIDs);
+            SQResult requeuedJobs;
+            if (db.read("SELECT jobID, name FROM jobs WHERE jobID IN (" + SQList(jobIDs) + ");", requeuedJobs)) {
+                set<int64_t> foundIDs;
+                set<string> requeuedNames;
+                list<string> requeued;
+                for (const auto& row : requeuedJobs) {
+                    foundIDs.insert(SToInt64(row[0]));
+                    requeuedNames.emplace(row[1]);
+                    requeued.emplace_back(row[0]);
+                }
+                list<string> notFound;
+                for (int64_t jobID : jobIDs) {
+                    if (!foundIDs.count(jobID)) {
+                        notFound.push_back(SToStr(jobID));
+                    }
+                }
+                jsonContent["requeued"] = SComposeJSONArray(requeued);
+                if (!notFound.empty()) {
+                    jsonContent["notFound"] = SComposeJSONArray(notFound);
+                }
+                for (const auto& requeuedName : requeuedNames) {
+                    jobsPlugin.wakeWaitingCommands(requeuedName);
+                }
+            }
         }
 
         return;
     }
 }
 
+// The calendar units the repeat grammar accepts, mapped onto the `tm` field each one adjusts. The repeat grammar is a
+// strict subset of SQLite's date modifiers (see SIsValidSQLiteDateModifier), which lets us compute most schedules
+// in-process instead of round-tripping the expression through SQLite's datetime functions.
+enum JobsDateUnit { JOBS_DATE_YEAR, JOBS_DATE_MONTH, JOBS_DATE_DAY, JOBS_DATE_HOUR, JOBS_DATE_MINUTE, JOBS_DATE_SECOND };
+struct JobsDateUnitToken {
+    const char* token;
+    JobsDateUnit unit;
+};
+static constexpr JobsDateUnitToken JOBS_DATE_UNITS[] = {
+    {"YEAR",   JOBS_DATE_YEAR},
+    {"MONTH",  JOBS_DATE_MONTH},
+    {"DAY",    JOBS_DATE_DAY},
+    {"HOUR",   JOBS_DATE_HOUR},
+    {"MINUTE", JOBS_DATE_MINUTE},
+    {"SECOND", JOBS_DATE_SECOND},
+};
+
+// Parses a "YYYY-MM-DD HH:MM:SS" datetime (UTC, which is what SQLite datetimes are). Returns false on any other
+// format, which makes the caller fall back to SQLite.
+static bool _parseJobsDateTime(const string& value, struct tm& out) {
+    memset(&out, 0, sizeof(out));
+    const char* end = strptime(value.c_str(), "%Y-%m-%d %H:%M:%S", &out);
+    return end && *end == '\0';
+}
+
+// Renormalizes overflowed fields (timegm handles them the same way SQLite does, e.g. Jan 31 '+1 MONTH' is Mar 3).
+static void _normalizeJobsDateTime(struct tm& t) {
+    time_t when = timegm(&t);
+    gmtime_r(&when, &t);
+}
+
+// Computes DATETIME(base, modifiers...) in-process. Returns false if the base or any modifier falls outside the
+// repeat grammar, in which case the caller evaluates the expression in SQLite instead. Modifiers are applied left to
+// right with normalization between each, matching SQLite.
+static bool _computeJobsDateTime(const string& base, const list<string>& modifiers, string& out) {
+    struct tm t;
+    if (!_parseJobsDateTime(base, t)) {
+        return false;
+    }
+    for (const string& modifier : modifiers) {
+        if (modifier.empty()) {
+            return false;
+        }
+        if (modifier[0] == '+' || modifier[0] == '-') {
+            // "+NNN UNIT[S]"
+            size_t space = modifier.find(' ');
+            if (space == string::npos) {
+                return false;
+            }
+            int64_t count = SToInt64(modifier);
+            string unitName = modifier.substr(space + 1);
+            if (!unitName.empty() && unitName.back() == 'S') {
+                unitName.pop_back();
+            }
+            bool found = false;
+            for (const JobsDateUnitToken& unit : JOBS_DATE_UNITS) {
+                if (unitName == unit.token) {
+                    switch (unit.unit) {
+                        case JOBS_DATE_YEAR:   t.tm_year += (int)count; break;
+                        case JOBS_DATE_MONTH:  t.tm_mon  += (int)count; break;
+                        case JOBS_DATE_DAY:    t.tm_mday += (int)count; break;
+                        case JOBS_DATE_HOUR:   t.tm_hour += (int)count; break;
+                        case JOBS_DATE_MINUTE: t.tm_min  += (int)count; break;
+                        case JOBS_DATE_SECOND: t.tm_sec  += (int)count; break;
+                    }
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                return false;
+            }
+        } else if (modifier == "START OF HOUR") {
+            // Not part of SQLite's grammar (the HOURLY schedule uses STRFTIME for this), but handy internally.
+            t.tm_min = 0;
+            t.tm_sec = 0;
+        } else if (modifier == "START OF DAY") {
+            t.tm_hour = 0;
+            t.tm_min = 0;
+            t.tm_sec = 0;
+        } else if (modifier == "START OF MONTH") {
+            t.tm_mday = 1;
+            t.tm_hour = 0;
+            t.tm_min = 0;
+            t.tm_sec = 0;
+        } else if (modifier == "START OF YEAR") {
+            t.tm_mon = 0;
+            t.tm_mday = 1;
+            t.tm_hour = 0;
+            t.tm_min = 0;
+            t.tm_sec = 0;
+        } else if (SStartsWith(modifier, "WEEKDAY ") && modifier.size() == 9 && modifier[8] >= '0' && modifier[8] <= '6') {
+            // Advances to the next date with the given weekday (0 = Sunday), or stays put if already there.
+            _normalizeJobsDateTime(t);
+            t.tm_mday += (modifier[8] - '0' - t.tm_wday + 7) % 7;
+        } else {
+            return false;
+        }
+        _normalizeJobsDateTime(t);
+    }
+    char buffer[20];
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &t);
+    out = buffer;
+    return true;
+}
+
 string BedrockJobsCommand::_constructNextRunDATETIME(const string& lastScheduled, const string& lastRun, const string& repeat) {
     if (repeat.empty()) {
         return "";
     }
 
     // Some "canned" times for convenience
-    if (SIEquals(repeat, "HOURLY"))
+    string computed;
+    if (SIEquals(repeat, "HOURLY")) {
+        if (_computeJobsDateTime(SUNQUOTED_CURRENT_TIMESTAMP(), {"+1 HOUR", "START OF HOUR"}, computed)) {
+            return SQ(computed);
+        }
         return "STRFTIME( '%Y-%m-%d %H:00:00', DATETIME( " + SCURRENT_TIMESTAMP() + ", '+1 HOUR' ) )";
-    if (SIEquals(repeat, "DAILY"))
+    }
+    if (SIEquals(repeat, "DAILY")) {
+        if (_computeJobsDateTime(SUNQUOTED_CURRENT_TIMESTAMP(), {"+1 DAY", "START OF DAY"}, computed)) {
+            return SQ(computed);
+        }
         return "DATETIME( " + SCURRENT_TIMESTAMP() + ", '+1 DAY', 'START OF DAY'  )";
-    if (SIEquals(repeat, "WEEKLY"))
+    }
+    if (SIEquals(repeat, "WEEKLY")) {
+        if (_computeJobsDateTime(SUNQUOTED_CURRENT_TIMESTAMP(), {"+1 DAY", "WEEKDAY 0", "START OF DAY"}, computed)) {
+            return SQ(computed);
+        }
         return "DATETIME( " + SCURRENT_TIMESTAMP() + ", '+1 DAY', 'WEEKDAY 0', 'START OF DAY' )";
+    }
 
     // Not canned, split the advanced repeat into its parts
     list<string> parts = SParseList(SToUpper(repeat));
@@ -1296,12 +1992,16 @@ string BedrockJobsCommand::_constructNextRunDATETIME(const string& lastScheduled
     // Make sure the first part indicates the base (eg, what we are modifying)
     list<string> safeParts;
     string base = parts.front();
+    string baseValue;
     parts.pop_front();
     if (base == "SCHEDULED") {
+        baseValue = lastScheduled;
         safeParts.push_back(SQ(lastScheduled));
     } else if (base == "STARTED") {
+        baseValue = lastRun;
         safeParts.push_back(SQ(lastRun));
     } else if (base == "FINISHED") {
+        baseValue = SUNQUOTED_CURRENT_TIMESTAMP();
         safeParts.push_back(SCURRENT_TIMESTAMP());
     } else {
         SWARN("Syntax error, failed parsing repeat '" << repeat << "': missing base (" << base << ")");
@@ -1318,6 +2018,12 @@ string BedrockJobsCommand::_constructNextRunDATETIME(const string& lastScheduled
         safeParts.push_back(SQ(part));
     }
 
+    // Compute the schedule in-process where we can; only exotic cases (like a base timestamp in a format we don't
+    // recognize) still round-trip through SQLite's datetime functions.
+    if (_computeJobsDateTime(baseValue, parts, computed)) {
+        return SQ(computed);
+    }
+
     // Combine the parts together and return the full DATETIME statement
     return "DATETIME( " + SComposeList(safeParts) + " )";
 }
@@ -1339,6 +2045,26 @@ bool BedrockJobsCommand::_hasPendingChildJobs(SQLite& db, int64_t jobID) {
     return !result.empty();
 }
 
+bool BedrockJobsCommand::_anyJobAvailable(SQLite& db) {
+    // The cheapest check that mirrors the GetJob query's filters: a single probe of the
+    // jobsStatePriorityNextRunName index, stopping at the first hit. Used to decide whether a `BlockUntilAvailable`
+    // GetJob should park; a false negative just means the command parks and the sweep timer re-checks in a second.
+    const list<string> nameList = SParseList(request["name"]);
+    SQResult result;
+    if (!db.read("SELECT 1 "
+                 "FROM jobs "
+                 "WHERE state IN ('QUEUED', 'RUNQUEUED') " +
+                     string(request.isSet("jobPriority") ? "AND priority=" + SQ(request.calc("jobPriority")) + " " : "") +
+                     "AND " + SCURRENT_TIMESTAMP() + ">=nextRun "
+                     "AND name " + (nameList.size() > 1 ? "IN (" + SQList(nameList) + ")" : "GLOB " + SQ(request["name"])) + " "
+                     "AND JSON_EXTRACT(data, '$.mockRequest') IS NULL "
+                 "LIMIT 1;",
+                 result)) {
+        STHROW("502 Select failed");
+    }
+    return !result.empty();
+}
+
 void BedrockJobsCommand::_validatePriority(const int64_t priority) {
     // We'd initially intended for any value to be allowable here, but for
     // performance reasons, we currently will only allow specific values to
@@ -1,13 +1,91 @@
 #include <libstuff/libstuff.h>
 #include "../BedrockPlugin.h"
 
+// An in-memory index of runnable jobs (state QUEUED or RUNQUEUED), so that GetJob can pick candidate jobs without
+// diving the jobsStatePriorityNextRunName B-tree for every poll. The index is a hint, not a source of truth: GetJob
+// re-reads every candidate from SQLite (a rowid point lookup) before claiming it, and falls back to the original
+// SELECT whenever the index returns fewer verified rows than the request asked for, so a stale or missing entry can
+// never return the wrong job or a spurious "404 No job found" - it just costs us the old query. That lets us keep
+// maintenance simple: write paths update the index from the state of their own uncommitted transaction, and if that
+// transaction later rolls back (e.g., on a commit conflict, where `process` just re-runs), the index is wrong - an
+// entry can even stay evicted until the next rebuild - in a way the fallback absorbs. The
+// index is rebuilt (and first enabled) by upgradeDatabase on leader standup; it stays disabled on followers, where
+// `process` never runs. Mocked jobs are never indexed, so mocked GetJob requests always take the fallback query.
+class BedrockJobsIndex {
+  public:
+    // A candidate job returned by peek.
+    struct Candidate {
+        int64_t jobID;
+        string name;
+        int64_t priority;
+        string nextRun;
+    };
+
+    // Scans the jobs table for runnable, non-mocked jobs, replaces the index contents with them, and enables the
+    // index. Called from upgradeDatabase on leader standup, which also heals any entries lost to rollbacks.
+    void rebuild(SQLite& db);
+
+    // Whether the index has been built and can serve candidates.
+    bool usable() const { return _usable.load(); }
+
+    // Returns up to `limit` of the best candidates (priority DESC, nextRun ASC) across the given exact names whose
+    // nextRun is at or before `now` (DATETIME strings compare chronologically). A `priority` of -1 matches any
+    // priority. Candidates are left in the index; callers remove them once claimed (or found stale).
+    list<Candidate> peek(const list<string>& names, const string& now, size_t limit, int64_t priority = -1);
+
+    // Inserts or replaces the entry for a job.
+    void update(int64_t jobID, const string& name, int64_t priority, const string& nextRun);
+
+    // Removes the entry for a job, if present.
+    void remove(int64_t jobID);
+
+    // Re-reads one job in the current transaction and updates, inserts, or removes its entry to match. This is how
+    // write paths that change a job's runnability keep the index coherent, and is a no-op when the index is disabled.
+    void updateFromDB(SQLite& db, int64_t jobID);
+
+    // Same, for every QUEUED child of the given parent (used when finishing a parent un-pauses its children).
+    void updateChildrenFromDB(SQLite& db, int64_t parentJobID);
+
+    // Bulk form of updateFromDB: one query over the whole jobID set and one pass under a single lock, instead of a
+    // point lookup and lock round-trip per job. Used by bulk transitions like RequeueJobs, where the per-job form
+    // made a thousand-job sweep cost a thousand queries. IDs with no row are removed from the index.
+    void updateManyFromDB(SQLite& db, const list<int64_t>& jobIDs);
+
+  private:
+    // name -> priority (highest first) -> (nextRun, jobID). The set orders each priority band by nextRun, and the
+    // by-job map lets update/remove find a job's current entry without knowing its old position.
+    map<string, map<int64_t, set<pair<string, int64_t>>, greater<int64_t>>> _byName;
+    map<int64_t, tuple<string, int64_t, string>> _byJob;
+    atomic<bool> _usable{false};
+    mutex _mutex;
+
+    // Internal versions that assume _mutex is held.
+    void _update(int64_t jobID, const string& name, int64_t priority, const string& nextRun);
+    void _remove(int64_t jobID);
+
+    // Jobs.cpp redefines SLOGPREFIX in terms of getName(); this keeps the index's logs under the plugin's name.
+    const string& getName() const;
+};
+
 class BedrockPlugin_Jobs : public BedrockPlugin {
   friend class BedrockJobsCommand;
   public:
     BedrockPlugin_Jobs(BedrockServer& s);
     virtual unique_ptr<BedrockCommand> getCommand(SQLiteCommand&& baseCommand);
+    virtual const set<string, STableComp>& supportedVerbs() const { return supportedRequestVerbs; }
     virtual const string& getName() const;
     virtual void upgradeDatabase(SQLite& db);
+    virtual void onPrepareToLead(SQLite& db);
+    virtual void holdCommand(unique_ptr<BedrockCommand>&& command);
+    virtual void timerFired(SStopwatch* timer);
+
+    // Re-queues every held GetJob whose name list could match `name` ("*" wakes all of them). Called from command
+    // processing when new runnable work lands, and from the sweep timer.
+    void wakeWaitingCommands(const string& name);
+
+    // The longest a GetJob is allowed to block for, regardless of what it asked for. Kept at the shutdown timeout so
+    // a held command can never outlive a graceful shutdown.
+    static constexpr uint64_t MAX_BLOCK_MS = 60'000;
 
     // We were using MAX_SIZE_SMALL in GetJob to check the job name, but now GetJobs accepts more than one job name,
     // because of that, we need to increase the size of the param to be able to accept around 50 job names.
@@ -18,10 +96,28 @@ class BedrockPlugin_Jobs : public BedrockPlugin {
 
     const bool isLive;
 
+    // The in-memory index of runnable jobs that GetJob peeks before touching SQLite.
+    BedrockJobsIndex jobsIndex;
+
   private:
-    static int64_t getNextID(SQLite& db);
+    int64_t getNextID(SQLite& db);
     static const string name;
     static const int64_t JOBS_DEFAULT_PRIORITY;
+
+    // The next jobID to hand out when the in-memory allocator is seeded (non-zero). upgradeDatabase seeds it from
+    // MAX(jobID) on leader standup; while it's zero, getNextID falls back to probing random IDs against the table.
+    atomic<int64_t> _nextJobID{0};
+
+    // GetJob commands parked by `BlockUntilAvailable`, each with its parsed name list so wakeWaitingCommands can
+    // match. Entries only leave by being re-queued with the server: by a matching wake or by the sweep timer below.
+    list<pair<list<string>, unique_ptr<BedrockCommand>>> _heldCommands;
+    mutex _heldCommandsMutex;
+
+    // Fires once a second and re-queues every held command, so it can re-check the table and either return a job,
+    // re-park, or time out. This bounds the cost of any wake we miss (wakes are sent before the creating transaction
+    // commits, and aren't sent at all on followers) to about a second of latency, for the price of one indexed probe
+    // per held command per second - still vastly cheaper than clients re-polling in a tight loop.
+    SStopwatch _heldCommandsSweepTimer;
 };
 
 class BedrockJobsCommand : public BedrockCommand {
@@ -36,10 +132,17 @@ class BedrockJobsCommand : public BedrockCommand {
     string _constructNextRunDATETIME(const string& lastScheduled, const string& lastRun, const string& repeat);
     bool _validateRepeat(const string& repeat) { return !_constructNextRunDATETIME("", "", repeat).empty(); }
     bool _hasPendingChildJobs(SQLite& db, int64_t jobID);
+    bool _anyJobAvailable(SQLite& db);
     void _validatePriority(const int64_t priority);
 
     bool mockRequest;
 
+    // The absolute time (in microseconds) at which a `BlockUntilAvailable` GetJob gives up and returns its 404,
+    // fixed on the first peek so that re-peeks after a wake can't extend it. Zero until then. Like all command
+    // members, this survives re-queueing but not escalation; an escalated copy that still finds nothing would pin a
+    // fresh deadline on leader, bounded by the command's own timeout.
+    uint64_t _blockUntil = 0;
+
     // Returns true if this command can skip straight to leader for process.
     bool canEscalateImmediately(SQLiteCommand& baseCommand);
 };
@@ -47,33 +47,58 @@ int MySQLPacket::deserialize(const char* packet, const size_t size) {
 }
 
 string MySQLPacket::lenEncInt(uint64_t val) {
+    string out;
+    appendLenEncInt(out, val);
+    return out;
+}
+
+string MySQLPacket::lenEncStr(const string& str) {
+    string out;
+    appendLenEncStr(out, str);
+    return out;
+}
+
+void MySQLPacket::appendLenEncInt(string& buffer, uint64_t val) {
     // Encode based on the length.
     // **NOTE: The below assume this is running on a "little-endian"
     //         machine, which means the least significant byte comes first
-    string out;
     void* valPtr = &val;
     if (val < 251) {
         // Take the last byte
-        SAppend(out, valPtr, 1);
+        SAppend(buffer, valPtr, 1);
     } else if (val < 1 << 16) {
         // Take the last 2 bytes
-        out += "\xFC";
-        SAppend(out, valPtr, 2);
+        buffer += "\xFC";
+        SAppend(buffer, valPtr, 2);
     } else if (val < 1 << 24) {
         // Take the last 3 bytes
-        out += "\xFD";
-        SAppend(out, valPtr, 3);
+        buffer += "\xFD";
+        SAppend(buffer, valPtr, 3);
     } else {
         // Take all bytes
-        out += "\xFE";
-        SAppend(out, valPtr, sizeof(val));
+        buffer += "\xFE";
+        SAppend(buffer, valPtr, sizeof(val));
     }
-    return out;
 }
 
-string MySQLPacket::lenEncStr(const string& str) {
+void MySQLPacket::appendLenEncStr(string& buffer, string_view str) {
     // Add the length, and then the string
-    return lenEncInt(str.size()) + str;
+    appendLenEncInt(buffer, str.size());
+    buffer += str;
+}
+
+size_t MySQLPacket::startPacket(string& buffer, uint8_t sequenceID) {
+    // Append a placeholder header; finishPacket patches in the payload length once it's known.
+    size_t headerOffset = buffer.size();
+    buffer.append(4, '\0');
+    buffer[headerOffset + 3] = (char)sequenceID;
+    return headerOffset;
+}
+
+void MySQLPacket::finishPacket(string& buffer, size_t headerOffset) {
+    // Everything appended since the header is the payload; patch its length into the first 3 bytes.
+    uint32_t payloadLength = (uint32_t)(buffer.size() - headerOffset - 4);
+    memcpy(&buffer[headerOffset], &payloadLength, 3);
 }
 
 string MySQLPacket::serializeHandshake() {
@@ -123,81 +148,146 @@ string MySQLPacket::serializeHandshake() {
     return handshake.serialize();
 }
 
-string MySQLPacket::serializeQueryResponse(int sequenceID, const SQResult& result) {
-    // Add the response
-    string sendBuffer;
-
-    // First the column count
-    MySQLPacket columnCount;
-    columnCount.sequenceID = ++sequenceID;
-    columnCount.payload = lenEncInt(result.headers.size());
-    sendBuffer += columnCount.serialize();
-
-    // Add all the columns
+// Encodes the entire response to a COM_QUERY into `sendBuffer`, appending length-encoded values in place, so the
+// only allocations are the buffer's occasional growth. When a socket is given, the buffer is flushed to it every
+// time it fills a flush unit's worth of encoded rows, so the resultset never accumulates in RAM a second time.
+static void _encodeQueryResponse(string& sendBuffer, int sequenceID, const SQResult& result, STCPManager::Socket* s) {
+    // Flush (when streaming) whenever at least this much is encoded: small enough to bound the buffer, big enough
+    // that the send overhead doesn't matter.
+    static const size_t FLUSH_SIZE = 64 * 1024;
+
+    // Reserve from the resultset's dimensions: the fixed parts of a column definition packet run about 50 bytes
+    // plus twice the header name, each row costs its cells plus a packet header, lenenc prefixes, and its EOF.
+    // When streaming we never hold more than a flush unit (plus one row), so cap the reservation there.
+    size_t estimate = 32;
     for (const auto& header : result.headers) {
-        // Now a column description
-        MySQLPacket column;
-        column.sequenceID = ++sequenceID;
-        column.payload += lenEncStr("def");     // catalog (lenenc_str) -- catalog (always "def")
-        column.payload += lenEncStr("unknown"); // schema (lenenc_str) -- schema-name
-        column.payload += lenEncStr("unknown"); // table (lenenc_str) -- virtual table-name
-        column.payload += lenEncStr("unknown"); // org_table (lenenc_str) -- physical table-name
-        column.payload += lenEncStr(header);    // name (lenenc_str) -- virtual column name
-        column.payload += lenEncStr(header);    // org_name (lenenc_str) -- physical column name
-
-        uint8_t next_length = 0x0c;
-        SAppend(column.payload, &next_length, 1); // next_length (lenenc_int) -- length of the following fields (always 0x0c)
-
-        uint16_t latin1_swedish_ci = 0x08;
-        SAppend(column.payload, &latin1_swedish_ci, 2); // character_set (2) -- is the column character set and is defined in Protocol::CharacterSet.
-
-        uint32_t colLength = 1024;
-        SAppend(column.payload, &colLength, 4); // column_length (4) -- maximum length of the field
-
-        //uint8_t colType = 0; // Decimal;
-        uint8_t colType = 254; // string.
-        SAppend(column.payload, &colType, 1); // column_type (1) -- type of the column as defined in Column Type
-
-        uint16_t flags = 0;
-        SAppend(column.payload, &flags, 2); // flags (2) -- flags
-
-        uint8_t decimals = 0;
-        SAppend(column.payload, &decimals, 1); // decimals (1) -- max shown decimal digits, 0x00 for integers and static strings
-
-        uint16_t filler = 0;
-        SAppend(column.payload, &filler, 2); // filler (to pad to 0x0c)
+        estimate += 50 + 2 * header.size();
+    }
+    estimate += result.contentSize() + result.cellCount() * 9 + result.size() * 5;
+    sendBuffer.reserve(s ? min(estimate, FLUSH_SIZE * 2) : estimate);
+
+    // The column-count packet, the column definitions, and the EOF that closes the column block depend only on the
+    // header names and the starting sequence ID -- not on the rows -- and BI tools issue the same statements over
+    // and over, so the encoded bytes are cached and replayed. Packet headers hold only lengths and sequence IDs, so
+    // the bytes are position-independent and safe to splice into any buffer.
+    static map<string, string> columnPrefixCache;
+    static mutex columnPrefixCacheMutex;
+    static const size_t COLUMN_PREFIX_CACHE_MAX = 1000;
+    {
+        string cacheKey = to_string(sequenceID);
+        for (const auto& header : result.headers) {
+            cacheKey += '\0';
+            cacheKey += header;
+        }
+        lock_guard<mutex> lock(columnPrefixCacheMutex);
+        auto cached = columnPrefixCache.find(cacheKey);
+        if (cached == columnPrefixCache.end()) {
+            string prefix;
+            int prefixSequenceID = sequenceID;
+
+            // First the column count
+            size_t packetOffset = MySQLPacket::startPacket(prefix, ++prefixSequenceID);
+            MySQLPacket::appendLenEncInt(prefix, result.headers.size());
+            MySQLPacket::finishPacket(prefix, packetOffset);
+
+            // Add all the columns
+            for (const auto& header : result.headers) {
+                // Now a column description
+                packetOffset = MySQLPacket::startPacket(prefix, ++prefixSequenceID);
+                MySQLPacket::appendLenEncStr(prefix, "def");     // catalog (lenenc_str) -- catalog (always "def")
+                MySQLPacket::appendLenEncStr(prefix, "unknown"); // schema (lenenc_str) -- schema-name
+                MySQLPacket::appendLenEncStr(prefix, "unknown"); // table (lenenc_str) -- virtual table-name
+                MySQLPacket::appendLenEncStr(prefix, "unknown"); // org_table (lenenc_str) -- physical table-name
+                MySQLPacket::appendLenEncStr(prefix, header);    // name (lenenc_str) -- virtual column name
+                MySQLPacket::appendLenEncStr(prefix, header);    // org_name (lenenc_str) -- physical column name
+
+                uint8_t next_length = 0x0c;
+                SAppend(prefix, &next_length, 1); // next_length (lenenc_int) -- length of the following fields (always 0x0c)
+
+                uint16_t latin1_swedish_ci = 0x08;
+                SAppend(prefix, &latin1_swedish_ci, 2); // character_set (2) -- is the column character set and is defined in Protocol::CharacterSet.
+
+                uint32_t colLength = 1024;
+                SAppend(prefix, &colLength, 4); // column_length (4) -- maximum length of the field
+
+                //uint8_t colType = 0; // Decimal;
+                uint8_t colType = 254; // string.
+                SAppend(prefix, &colType, 1); // column_type (1) -- type of the column as defined in Column Type
+
+                uint16_t flags = 0;
+                SAppend(prefix, &flags, 2); // flags (2) -- flags
+
+                uint8_t decimals = 0;
+                SAppend(prefix, &decimals, 1); // decimals (1) -- max shown decimal digits, 0x00 for integers and static strings
+
+                uint16_t filler = 0;
+                SAppend(prefix, &filler, 2); // filler (to pad to 0x0c)
+
+                MySQLPacket::finishPacket(prefix, packetOffset);
+            }
 
-        sendBuffer += column.serialize();
+            // EOF packet to signal no more columns
+            packetOffset = MySQLPacket::startPacket(prefix, ++prefixSequenceID);
+            SAppend(prefix, "\xFE", 1); // EOF
+            uint32_t zero = 0;
+            SAppend(prefix, &zero, 4); // EOF
+            MySQLPacket::finishPacket(prefix, packetOffset);
+
+            // Cache it unless the cache is full (the cap just bounds memory against pathological query diversity).
+            if (columnPrefixCache.size() < COLUMN_PREFIX_CACHE_MAX) {
+                cached = columnPrefixCache.emplace(move(cacheKey), move(prefix)).first;
+                sendBuffer += cached->second;
+            } else {
+                sendBuffer += prefix;
+            }
+        } else {
+            sendBuffer += cached->second;
+        }
     }
 
-    // EOF packet to signal no more columns
-    MySQLPacket eofPacket;
-    eofPacket.sequenceID = ++sequenceID;
-    SAppend(eofPacket.payload, "\xFE", 1); // EOF
+    // The column block consumed one sequence ID for the count packet, one per column, and one for the EOF.
+    sequenceID += result.headers.size() + 2;
+    size_t packetOffset = 0;
     uint32_t zero = 0;
-    SAppend(eofPacket.payload, &zero, 4); // EOF
-    sendBuffer += eofPacket.serialize();
 
     // Add all the rows
-    for (const auto& row : result.rows) {
+    for (const auto& row : result) {
         // Now the row
-        MySQLPacket rowPacket;
-        rowPacket.sequenceID = ++sequenceID;
+        packetOffset = MySQLPacket::startPacket(sendBuffer, ++sequenceID);
         for (const auto& cell : row) {
-            rowPacket.payload += lenEncStr(cell);
+            MySQLPacket::appendLenEncStr(sendBuffer, cell);
+        }
+        SAppend(sendBuffer, "\xFE", 1); // EOF
+        MySQLPacket::finishPacket(sendBuffer, packetOffset);
+
+        // Streaming? Flush whole packets as they accumulate instead of growing the buffer to the resultset.
+        if (s && sendBuffer.size() >= FLUSH_SIZE) {
+            s->send(sendBuffer);
+            sendBuffer.clear();
         }
-        SAppend(rowPacket.payload, "\xFE", 1); // EOF
-        sendBuffer += rowPacket.serialize();
     }
 
     // Finish with another EOF packet
-    eofPacket.sequenceID = ++sequenceID;
-    sendBuffer += eofPacket.serialize();
+    packetOffset = MySQLPacket::startPacket(sendBuffer, ++sequenceID);
+    SAppend(sendBuffer, "\xFE", 1); // EOF
+    SAppend(sendBuffer, &zero, 4); // EOF
+    MySQLPacket::finishPacket(sendBuffer, packetOffset);
+}
 
-    // Done!
+string MySQLPacket::serializeQueryResponse(int sequenceID, const SQResult& result) {
+    // Encode the whole response into one buffer
+    string sendBuffer;
+    _encodeQueryResponse(sendBuffer, sequenceID, result, nullptr);
     return sendBuffer;
 }
 
+void MySQLPacket::sendQueryResponse(STCPManager::Socket* s, int sequenceID, const SQResult& result) {
+    // Encode straight to the socket, then flush whatever's left after the last row
+    string sendBuffer;
+    _encodeQueryResponse(sendBuffer, sequenceID, result, s);
+    s->send(sendBuffer);
+}
+
 string MySQLPacket::serializeOK(int sequenceID) {
     // Just fill out the packet
     MySQLPacket ok;
@@ -227,12 +317,23 @@ string MySQLPacket::serializeERR(int sequenceID, uint16_t code, const string& me
 
 BedrockPlugin_MySQL::BedrockPlugin_MySQL(BedrockServer& s) : BedrockPlugin_DB(s)
 {
+    // Encode the static packets once up front rather than per connection or per query.
+    _cachedHandshake = MySQLPacket::serializeHandshake();
+    SQResult result;
+    result.headers.push_back("Variable Name");
+    result.headers.push_back("Value");
+    for (int c = 0; c < MYSQL_NUM_VARIABLES; ++c) {
+        result.addRow();
+        result.addCell(g_MySQLVariables[c][0]);
+        result.addCell(g_MySQLVariables[c][1]);
+    }
+    _cachedVariableList = MySQLPacket::serializeQueryResponse(0, result);
 }
 
 void BedrockPlugin_MySQL::onPortAccept(STCPManager::Socket* s) {
     // Send Protocol::HandshakeV10
     SINFO("Accepted MySQL request from '" << s->addr << "'");
-    s->send(MySQLPacket::serializeHandshake());
+    s->send(_cachedHandshake);
 }
 
 void BedrockPlugin_MySQL::onPortRecv(STCPManager::Socket* s, SData& request) {
@@ -260,70 +361,56 @@ void BedrockPlugin_MySQL::onPortRecv(STCPManager::Socket* s, SData& request) {
             }
             SINFO("Processing query '" << query << "'");
 
-            // See if it's asking for a global variable
+            // Look up the query's shape in the classification cache; tool-generated traffic repeats the same
+            // handful of shapes forever, so nearly every query after warmup skips the regex and matching chain.
+            string firstLiteral;
+            bool hadLiteral;
+            string shape = _normalizeQuery(query, firstLiteral, hadLiteral);
             string varName;
-            string regExp = "^(?:(?:SELECT\\s+)?@@(?:\\w+\\.)?|SHOW VARIABLES LIKE ')(\\w+).*$";
-            if (pcrecpp::RE(regExp, pcrecpp::RE_Options().set_caseless(true)).FullMatch(query, &varName)) {
-                // Loop across and look for it
-                SQResult result;
-                result.headers.push_back(varName);
-                for (int c = 0; c < MYSQL_NUM_VARIABLES; ++c) {
-                    if (SIEquals(g_MySQLVariables[c][0], varName)) {
-                        // Found it!
-                        SINFO("Returning variable '" << varName << "'='" << g_MySQLVariables[c][1] << "'");
-                        result.rows.resize(1);
-                        result.rows[0].push_back(g_MySQLVariables[c][1]);
-                        break;
+            QueryType type = QueryType::PASSTHROUGH;
+            bool classified = false;
+            {
+                lock_guard<mutex> lock(_queryShapeCacheMutex);
+                auto cached = _queryShapeCache.find(shape);
+                if (cached != _queryShapeCache.end()) {
+                    if (cached->second.varNameFromLiteral) {
+                        // The variable name lives in this query's (stripped) literal; take its leading word. An
+                        // empty extraction means this particular query wouldn't have matched the variable regex,
+                        // so fall through and classify it from scratch.
+                        size_t nameEnd = 0;
+                        while (nameEnd < firstLiteral.size() &&
+                               (isalnum(firstLiteral[nameEnd]) || firstLiteral[nameEnd] == '_')) {
+                            nameEnd++;
+                        }
+                        varName = firstLiteral.substr(0, nameEnd);
+                        classified = !varName.empty();
+                    } else {
+                        varName = cached->second.varName;
+                        classified = true;
+                    }
+                    if (classified) {
+                        type = cached->second.type;
+                        _queryShapeCacheHits++;
                     }
                 }
-                if (result.rows.empty()) {
-                    SHMMM("Couldn't find variable '" << varName << "', returning empty.");
-                }
-                s->send(MySQLPacket::serializeQueryResponse(packet.sequenceID, result));
-            } else if (SIEquals(query, "SHOW VARIABLES;")) {
-                // Return the variable list
-                SINFO("Responding with fake variable list");
-                SQResult result;
-                result.headers.push_back("Variable Name");
-                result.headers.push_back("Value");
-                for (int c = 0; c < MYSQL_NUM_VARIABLES; ++c) {
-                    result.rows.resize(result.rows.size() + 1);
-                    result.rows.back().resize(2);
-                    result.rows.back()[0] = g_MySQLVariables[c][0];
-                    result.rows.back()[1] = g_MySQLVariables[c][1];
+            }
+            if (!classified) {
+                _queryShapeCacheMisses++;
+                type = _classifyQuery(query, varName);
+
+                // Cache the decision unless it could have depended on a literal's contents: an EMPTY_SET verdict
+                // from a query with literals might have found "information_schema" inside one, and a same-shape
+                // query with different literals would classify differently.
+                if (type != QueryType::EMPTY_SET || !hadLiteral) {
+                    bool varNameFromLiteral = type == QueryType::VARIABLE && !SContains(query, "@@");
+                    lock_guard<mutex> lock(_queryShapeCacheMutex);
+                    if (_queryShapeCache.size() < QUERY_SHAPE_CACHE_MAX) {
+                        _queryShapeCache.emplace(move(shape), QueryShapeEntry{
+                            type, varNameFromLiteral ? "" : varName, varNameFromLiteral});
+                    }
                 }
-                s->send(MySQLPacket::serializeQueryResponse(packet.sequenceID, result));
-            } else if (SIEquals(query, "SHOW DATABASES;")) {
-                // Return a fake "main" database
-                SINFO("Responding with fake database list");
-                SQResult result;
-                result.headers.push_back("Database");
-                result.rows.resize(1);
-                result.rows.back().push_back("main");
-                s->send(MySQLPacket::serializeQueryResponse(packet.sequenceID, result));
-            } else if (SIEquals(query, "SHOW /*!50002 FULL*/ TABLES;")) {
-                // Return an empty list of tables
-                SINFO("Responding with fake table list");
-                SQResult result;
-                result.headers.push_back("Tables");
-                s->send(MySQLPacket::serializeQueryResponse(packet.sequenceID, result));
-            } else if (SContains(query, "information_schema")) {
-                // Return an empty set
-                SINFO("Responding with empty routine list");
-                SQResult result;
-                s->send(MySQLPacket::serializeQueryResponse(packet.sequenceID, result));
-            } else if (SStartsWith(SToUpper(query), "SET ") || SStartsWith(SToUpper(query), "USE ")
-                       || SIEquals(query, "ROLLBACK;")) {
-                // Ignore
-                SINFO("Responding OK to SET/USE/ROLLBACK query.");
-                s->send(MySQLPacket::serializeOK(packet.sequenceID));
-            } else {
-                // Transform this into an internal request
-                request.methodLine = "Query";
-                request["format"] = "json";
-                request["sequenceID"] = SToStr(packet.sequenceID);
-                request["query"] = query;
             }
+            _respondToQuery(s, packet.sequenceID, type, query, varName, request);
             break;
         }
 
@@ -337,6 +424,161 @@ void BedrockPlugin_MySQL::onPortRecv(STCPManager::Socket* s, SData& request) {
     }
 }
 
+string BedrockPlugin_MySQL::_normalizeQuery(const string& query, string& firstLiteral, bool& hadLiteral) {
+    string shape;
+    shape.reserve(query.size());
+    firstLiteral.clear();
+    hadLiteral = false;
+    for (size_t i = 0; i < query.size(); i++) {
+        char c = query[i];
+        if (c == '\'' || c == '"') {
+            // A quoted literal: swallow through the matching close quote (a doubled quote escapes itself) and
+            // stand in a '?'. Whitespace and everything else outside literals is preserved exactly, since the
+            // classification chain is whitespace- and case-sensitive in places.
+            char quote = c;
+            size_t literalStart = ++i;
+            while (i < query.size()) {
+                if (query[i] == quote) {
+                    if (i + 1 < query.size() && query[i + 1] == quote) {
+                        i += 2;
+                        continue;
+                    }
+                    break;
+                }
+                i++;
+            }
+            if (!hadLiteral) {
+                firstLiteral = query.substr(literalStart, i - literalStart);
+            }
+            hadLiteral = true;
+            shape += '?';
+        } else if (isdigit(c) && (!i || !(isalnum(query[i - 1]) || query[i - 1] == '_'))) {
+            // A numeric constant (not digits inside an identifier): swallow the number and stand in a '?'.
+            while (i + 1 < query.size() && (isdigit(query[i + 1]) || query[i + 1] == '.')) {
+                i++;
+            }
+            shape += '?';
+        } else {
+            shape += c;
+        }
+    }
+    return shape;
+}
+
+BedrockPlugin_MySQL::QueryType BedrockPlugin_MySQL::_classifyQuery(const string& query, string& varName) {
+    // See if it's asking for a global variable
+    string regExp = "^(?:(?:SELECT\\s+)?@@(?:\\w+\\.)?|SHOW VARIABLES LIKE ')(\\w+).*$";
+    if (pcrecpp::RE(regExp, pcrecpp::RE_Options().set_caseless(true)).FullMatch(query, &varName)) {
+        return QueryType::VARIABLE;
+    } else if (SIEquals(query, "SHOW VARIABLES;")) {
+        return QueryType::VARIABLE_LIST;
+    } else if (SIEquals(query, "SHOW DATABASES;")) {
+        return QueryType::DATABASE_LIST;
+    } else if (SIEquals(query, "SHOW /*!50002 FULL*/ TABLES;")) {
+        return QueryType::TABLE_LIST;
+    } else if (SContains(query, "information_schema")) {
+        return QueryType::EMPTY_SET;
+    } else if (SStartsWith(SToUpper(query), "SET ") || SStartsWith(SToUpper(query), "USE ")
+               || SIEquals(query, "ROLLBACK;")) {
+        return QueryType::OK_ONLY;
+    }
+    return QueryType::PASSTHROUGH;
+}
+
+void BedrockPlugin_MySQL::_respondToQuery(STCPManager::Socket* s, int sequenceID, QueryType type,
+                                          const string& query, const string& varName, SData& request) {
+    switch (type) {
+    case QueryType::VARIABLE: {
+        // Loop across and look for it
+        SQResult result;
+        result.headers.push_back(varName);
+        for (int c = 0; c < MYSQL_NUM_VARIABLES; ++c) {
+            if (SIEquals(g_MySQLVariables[c][0], varName)) {
+                // Found it!
+                SINFO("Returning variable '" << varName << "'='" << g_MySQLVariables[c][1] << "'");
+                result.addRow();
+                result.addCell(g_MySQLVariables[c][1]);
+                break;
+            }
+        }
+        if (result.empty()) {
+            SHMMM("Couldn't find variable '" << varName << "', returning empty.");
+        }
+        MySQLPacket::sendQueryResponse(s, sequenceID, result);
+        break;
+    }
+    case QueryType::VARIABLE_LIST: {
+        // Return the variable list
+        SINFO("Responding with fake variable list");
+        if (sequenceID == 0) {
+            // The usual case: the response is precomputed at construction.
+            s->send(_cachedVariableList);
+        } else {
+            SQResult result;
+            result.headers.push_back("Variable Name");
+            result.headers.push_back("Value");
+            for (int c = 0; c < MYSQL_NUM_VARIABLES; ++c) {
+                result.addRow();
+                result.addCell(g_MySQLVariables[c][0]);
+                result.addCell(g_MySQLVariables[c][1]);
+            }
+            MySQLPacket::sendQueryResponse(s, sequenceID, result);
+        }
+        break;
+    }
+    case QueryType::DATABASE_LIST: {
+        // Return a fake "main" database
+        SINFO("Responding with fake database list");
+        SQResult result;
+        result.headers.push_back("Database");
+        result.addRow();
+        result.addCell("main");
+        MySQLPacket::sendQueryResponse(s, sequenceID, result);
+        break;
+    }
+    case QueryType::TABLE_LIST: {
+        // Return an empty list of tables
+        SINFO("Responding with fake table list");
+        SQResult result;
+        result.headers.push_back("Tables");
+        MySQLPacket::sendQueryResponse(s, sequenceID, result);
+        break;
+    }
+    case QueryType::EMPTY_SET: {
+        // Return an empty set
+        SINFO("Responding with empty routine list");
+        SQResult result;
+        MySQLPacket::sendQueryResponse(s, sequenceID, result);
+        break;
+    }
+    case QueryType::OK_ONLY: {
+        // Ignore
+        SINFO("Responding OK to SET/USE/ROLLBACK query.");
+        s->send(MySQLPacket::serializeOK(sequenceID));
+        break;
+    }
+    case QueryType::PASSTHROUGH: {
+        // Transform this into an internal request
+        request.methodLine = "Query";
+        request["format"] = "json";
+        request["sequenceID"] = SToStr(sequenceID);
+        request["query"] = query;
+        break;
+    }
+    }
+}
+
+STable BedrockPlugin_MySQL::getInfo() {
+    STable info;
+    info["queryShapeCacheHits"] = SToStr(_queryShapeCacheHits.load());
+    info["queryShapeCacheMisses"] = SToStr(_queryShapeCacheMisses.load());
+    {
+        lock_guard<mutex> lock(_queryShapeCacheMutex);
+        info["queryShapeCacheSize"] = SToStr(_queryShapeCache.size());
+    }
+    return info;
+}
+
 void BedrockPlugin_MySQL::onPortRequestComplete(const BedrockCommand& command, STCPManager::Socket* s) {
     // Only one request supported: Query.
     SASSERT(SIEquals(command.request.methodLine, "Query"));
@@ -350,7 +592,7 @@ void BedrockPlugin_MySQL::onPortRequestComplete(const BedrockCommand& command, S
             // Convert the JSON response from Bedrock::DB into MySQL protocol
             SQResult result;
             SASSERT(command.response.content.empty() || result.deserialize(command.response.content));
-            s->send(MySQLPacket::serializeQueryResponse(command.request.calc("sequenceID"), result));
+            MySQLPacket::sendQueryResponse(s, command.request.calc("sequenceID"), result);
         }
     } else {
         // Failure -- pass along the message
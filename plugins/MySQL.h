@@ -52,6 +52,41 @@ struct MySQLPacket {
      */
     static string lenEncStr(const string& str);
 
+    /**
+     * Appends a MySQL length-encoded integer directly onto `buffer`, with no temporary string
+     *
+     * @param buffer The buffer being encoded into
+     * @param val    Integer value to be length-encoded
+     */
+    static void appendLenEncInt(string& buffer, uint64_t val);
+
+    /**
+     * Appends a MySQL length-encoded string directly onto `buffer`, with no temporary string
+     *
+     * @param buffer The buffer being encoded into
+     * @param str    The string to be length-encoded
+     */
+    static void appendLenEncStr(string& buffer, string_view str);
+
+    /**
+     * Starts a packet encoded in place in `buffer`: appends a placeholder header with the given sequenceID, after
+     * which the payload is appended directly onto the buffer
+     *
+     * @param buffer     The buffer being encoded into
+     * @param sequenceID The sequenceID of this packet
+     * @return           The header's offset in the buffer, to pass to finishPacket
+     */
+    static size_t startPacket(string& buffer, uint8_t sequenceID);
+
+    /**
+     * Finishes a packet started with startPacket by patching the payload length (everything appended since) into
+     * its header
+     *
+     * @param buffer       The buffer being encoded into
+     * @param headerOffset The offset returned by the matching startPacket
+     */
+    static void finishPacket(string& buffer, size_t headerOffset);
+
     /**
      * Creates the packet sent from the server to new connections
      * See: https://dev.mysql.com/doc/internals/en/connection-phase-packets.html#packet-Protocol::HandshakeV10
@@ -68,6 +103,18 @@ struct MySQLPacket {
      */
     static string serializeQueryResponse(int sequenceID, const SQResult& result);
 
+    /**
+     * Encodes the response to a COM_QUERY request straight onto the socket, flushing packets as rows are encoded
+     * rather than accumulating the entire resultset in a buffer first. The encoding is identical to
+     * serializeQueryResponse; this is what the MySQL port uses, since BI tools pull resultsets wide enough that the
+     * extra full-resultset copy (and the per-cell temporaries) dominate the cost of the query itself.
+     *
+     * @param s          The socket to stream the packets to
+     * @param sequenceID The sequenceID of the request we are responding to
+     * @param result     The results of the query we were asked to execute
+     */
+    static void sendQueryResponse(STCPManager::Socket* s, int sequenceID, const SQResult& result);
+
     /**
      * Creatse a standard OK packet
      * See: https://dev.mysql.com/doc/internals/en/packet-OK_Packet.html
@@ -103,9 +150,60 @@ class BedrockPlugin_MySQL : public BedrockPlugin_DB {
     virtual void onPortAccept(STCPManager::Socket* s);
     virtual void onPortRecv(STCPManager::Socket* s, SData& request);
     virtual void onPortRequestComplete(const BedrockCommand& command, STCPManager::Socket* s);
+    virtual STable getInfo();
 
   private:
     // Attributes
     SData _args;
     static const string name;
+
+    // What a COM_QUERY turned out to be, after running the classification chain in onPortRecv.
+    enum class QueryType {
+        VARIABLE,      // a single global variable lookup (@@name or SHOW VARIABLES LIKE 'name')
+        VARIABLE_LIST, // SHOW VARIABLES
+        DATABASE_LIST, // SHOW DATABASES
+        TABLE_LIST,    // SHOW TABLES
+        EMPTY_SET,     // information_schema queries, answered with an empty resultset
+        OK_ONLY,       // SET/USE/ROLLBACK, answered with a bare OK
+        PASSTHROUGH,   // everything else, forwarded to the DB plugin
+    };
+
+    // A cached classification, keyed by the query's normalized shape (literals and numbers stripped), so the
+    // identical statements dashboards and BI tools issue forever skip the regex and string-matching chain after
+    // the first time. For a VARIABLE whose name sat inside a stripped literal (the LIKE form), the name is
+    // re-extracted from each query's first literal instead of stored, since same-shape queries can ask for
+    // different variables.
+    struct QueryShapeEntry {
+        QueryType type;
+        string varName;
+        bool varNameFromLiteral;
+    };
+
+    // Strips quoted literals (to '?', noting the first one and whether any were seen) and numeric constants from a
+    // query, producing the shape used as the cache key.
+    static string _normalizeQuery(const string& query, string& firstLiteral, bool& hadLiteral);
+
+    // The original classification chain: regexes and string matches against the raw query text. Fills in varName
+    // for VARIABLE results.
+    QueryType _classifyQuery(const string& query, string& varName);
+
+    // Produces the response for an already-classified query: sends the canned resultset, OK, or empty set, or
+    // fills in `request` for PASSTHROUGH.
+    void _respondToQuery(STCPManager::Socket* s, int sequenceID, QueryType type, const string& query,
+                         const string& varName, SData& request);
+
+    // The shape cache and its hit counters (reported via getInfo in Status). The size cap just bounds memory
+    // against pathological query diversity.
+    map<string, QueryShapeEntry> _queryShapeCache;
+    mutex _queryShapeCacheMutex;
+    atomic<uint64_t> _queryShapeCacheHits{0};
+    atomic<uint64_t> _queryShapeCacheMisses{0};
+    static const size_t QUERY_SHAPE_CACHE_MAX = 10'000;
+
+    // Serialized packets that are byte-identical for every connection, encoded once at construction: the handshake
+    // we greet each new socket with, and the full `SHOW VARIABLES` response (for the usual case of a query arriving
+    // with sequenceID 0). Both depend only on constants compiled into this binary, so connection churn from BI
+    // tools shouldn't re-encode them.
+    string _cachedHandshake;
+    string _cachedVariableList;
 };
@@ -1,5 +1,7 @@
 #include <libstuff/libstuff.h>
+#include <libstuff/SMetrics.h>
 #include "SQLite.h"
+#include "SQLiteQueryLedger.h"
 
 #define DBINFO(_MSG_) SINFO("{" << _filename << "} " << _MSG_)
 
@@ -12,6 +14,13 @@ atomic<int> SQLite::fullCheckpointPageMin(25000); // Approx 100mb (pages are ass
 // Tracing can only be enabled or disabled globally, not per object.
 atomic<bool> SQLite::enableTrace(false);
 
+// Group commit is off unless explicitly enabled at startup.
+atomic<bool> SQLite::enableGroupCommit(false);
+
+// The maximum number of commits we'll allow in a single group before forcing a WAL sync, even if there are still
+// threads waiting on the commit lock. This bounds the amount of work that can be lost to a crash mid-group.
+static const int GROUP_COMMIT_MAX_BATCH = 32;
+
 string SQLite::initializeFilename(const string& filename) {
     // Canonicalize our filename and save that version.
     if (filename == ":memory:") {
@@ -43,6 +52,7 @@ SQLite::SharedData& SQLite::initializeSharedData(sqlite3* db, const string& file
         SASSERT(!SQuery(db, "getting commit count", query, result));
         uint64_t commitCount = result.empty() ? 0 : SToUInt64(result[0][0]);
         sharedData->commitCount = commitCount;
+        sharedData->resetTableWriteTracking(commitCount);
 
         // And then read the hash for that transaction.
         string lastCommittedHash, ignore;
@@ -63,10 +73,17 @@ SQLite::SharedData& SQLite::initializeSharedData(sqlite3* db, const string& file
     }
 }
 
-sqlite3* SQLite::initializeDB(const string& filename, int64_t mmapSizeGB) {
+sqlite3* SQLite::initializeDB(const string& filename, int64_t mmapSizeGB, bool readOnly) {
+    sqlite3* db;
+    if (readOnly) {
+        // Open the DB in read-only mode. The file must already exist for this to make any sense.
+        SINFO("Opening database '" << filename << "' read-only.");
+        SASSERT(!sqlite3_open_v2(filename.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL));
+        return db;
+    }
+
     // Open the DB in read-write mode.
     SINFO((SFileExists(filename) ? "Opening" : "Creating") << " database '" << filename << "'.");
-    sqlite3* db;
     SASSERT(!sqlite3_open_v2(filename.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NULL));
 
     // PRAGMA legacy_file_format=OFF sets the default for creating new databases, so it must be called before creating
@@ -76,21 +93,81 @@ sqlite3* SQLite::initializeDB(const string& filename, int64_t mmapSizeGB) {
     return db;
 }
 
-vector<string> SQLite::initializeJournal(sqlite3* db, int minJournalTables) {
+vector<string> SQLite::initializeJournal(sqlite3* db, int minJournalTables, const string& filename) {
     // Make sure we don't try and create more journals than we can name.
     SASSERT(minJournalTables < 10'000);
 
-    // First, we create all of the tables through `minJournalTables` if they don't exist.
-    for (int currentJounalTable = -1; currentJounalTable <= minJournalTables; currentJounalTable++) {
-        char tableName[27] = {0};
-        if (currentJounalTable < 0) {
-            // The `-1` entry is just plain "journal".
-            snprintf(tableName, 27, "journal");
-        } else {
-            snprintf(tableName, 27, "journal%04i", currentJounalTable);
+    // One sqlite_master query covers every journal table: which exist, and each one's schema. The old approach ran
+    // a schema probe per table, which added up to hundreds of queries (and restart milliseconds, which are failover
+    // milliseconds) at large -minJournalTables counts.
+    SQResult tables;
+    SASSERT(!SQuery(db, "looking up journal tables",
+                    "SELECT name, sql FROM sqlite_master WHERE type='table' AND "
+                    "(name='journal' OR name GLOB 'journal[0-9][0-9][0-9][0-9]') ORDER BY name", tables));
+    map<string, string> existing;
+    string fingerprintInput = SToStr(minJournalTables);
+    for (const auto& row : tables) {
+        existing.emplace(row[0], row[1]);
+        fingerprintInput += '\n';
+        fingerprintInput += row[0];
+        fingerprintInput += '\n';
+        fingerprintInput += row[1];
+    }
+
+    // If a previous run verified this exact table set and schema (and the same required count), skip verification
+    // entirely. The fingerprint is computed from the live sqlite_master contents, so a swapped, dropped, or altered
+    // table changes it and forces the full pass below.
+    string fingerprintFile = filename == ":memory:" ? "" : filename + "-journalFingerprint";
+    bool verified = !fingerprintFile.empty() && !tables.empty() &&
+                    SFileLoad(fingerprintFile) == SToHex(SHashSHA1(fingerprintInput));
+    if (!verified) {
+        // Verify the schema of every table through `minJournalTables`, collecting the missing ones.
+        list<string> missing;
+        for (int currentJounalTable = -1; currentJounalTable <= minJournalTables; currentJounalTable++) {
+            char tableName[27] = {0};
+            if (currentJounalTable < 0) {
+                // The `-1` entry is just plain "journal".
+                snprintf(tableName, 27, "journal");
+            } else {
+                snprintf(tableName, 27, "journal%04i", currentJounalTable);
+            }
+            string createQuery = "CREATE TABLE " + string(tableName) + " ( id INTEGER PRIMARY KEY, query TEXT, hash TEXT )";
+            auto it = existing.find(tableName);
+            if (it == existing.end()) {
+                missing.push_back(move(createQuery));
+            } else {
+                // Table exists, verify it's correct (the same check SQVerifyTable does).
+                SASSERT(it->second == createQuery);
+            }
         }
-        if (SQVerifyTable(db, tableName, "CREATE TABLE " + string(tableName) + " ( id INTEGER PRIMARY KEY, query TEXT, hash TEXT )")) {
-            SHMMM("Created " << tableName << " table.");
+
+        // Create all the missing tables in a single batched transaction, instead of a commit per table.
+        if (!missing.empty()) {
+            SASSERT(!SQuery(db, "beginning journal table creation", "BEGIN"));
+            for (const string& createQuery : missing) {
+                SASSERT(!SQuery(db, "creating journal table", createQuery));
+            }
+            SASSERT(!SQuery(db, "committing journal table creation", "COMMIT"));
+            SHMMM("Created " << missing.size() << " journal tables.");
+            for (string& createQuery : missing) {
+                // "CREATE TABLE <name> ..."; recover the name to fold the new table into the verified set.
+                string tableName = createQuery.substr(strlen("CREATE TABLE "));
+                tableName = tableName.substr(0, tableName.find(' '));
+                existing.emplace(move(tableName), move(createQuery));
+            }
+        }
+
+        // Remember what we verified, so the next restart of an unchanged database skips straight through. A map
+        // iterates in the same lexicographic order the query above returns, so the fingerprints line up.
+        if (!fingerprintFile.empty()) {
+            fingerprintInput = SToStr(minJournalTables);
+            for (const auto& table : existing) {
+                fingerprintInput += '\n';
+                fingerprintInput += table.first;
+                fingerprintInput += '\n';
+                fingerprintInput += table.second;
+            }
+            SFileSave(fingerprintFile, SToHex(SHashSHA1(fingerprintInput)));
         }
     }
 
@@ -107,7 +184,7 @@ vector<string> SQLite::initializeJournal(sqlite3* db, int minJournalTables) {
             snprintf(tableName, 27, "journal%04i", currentJounalTable);
         }
 
-        if (SQVerifyTableExists(db, tableName)) {
+        if (existing.count(tableName)) {
             journalNames.push_back(tableName);
             currentJounalTable++;
         } else {
@@ -145,23 +222,27 @@ void SQLite::commonConstructorInitialization() {
     SASSERT(_cacheSize > 0);
     SASSERT(_maxJournalSize > 0);
 
-    // Turn on page logging if specified.
-    if (_pageLoggingEnabled) {
+    // Turn on page logging if specified. Pointless on a read-only handle, which never writes pages.
+    if (_pageLoggingEnabled && !_readOnly) {
         sqlite3_begin_concurrent_report_enable(_db, 1);
     }
 
-    // WAL is what allows simultaneous read/writing.
+    // WAL is what allows simultaneous read/writing. For a read-only handle this is just a check that the DB is
+    // already in WAL mode (the pragma can't change the mode without writing).
     SASSERT(!SQuery(_db, "enabling write ahead logging", "PRAGMA journal_mode = WAL;"));
 
     if (_mmapSizeGB) {
         SASSERT(!SQuery(_db, "enabling memory-mapped I/O", "PRAGMA mmap_size=" + to_string(_mmapSizeGB * 1024 * 1024 * 1024) + ";"));
     }
 
-    // Do our own checkpointing.
-    sqlite3_wal_hook(_db, _sqliteWALCallback, this);
+    // Do our own checkpointing. Read-only handles never commit, so their WAL callback would never fire anyway.
+    if (!_readOnly) {
+        sqlite3_wal_hook(_db, _sqliteWALCallback, this);
+    }
 
-    // Enable tracing for performance analysis.
-    sqlite3_trace_v2(_db, SQLITE_TRACE_STMT, _sqliteTraceCallback, this);
+    // Enable tracing for performance analysis. The profile events feed the always-on sampled query ledger; the
+    // statement events only log when `enableTrace` is set.
+    sqlite3_trace_v2(_db, SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE, _sqliteTraceCallback, this);
 
     // Update the cache. -size means KB; +size means pages
     SINFO("Setting cache_size to " << _cacheSize << "KB");
@@ -171,12 +252,18 @@ void SQLite::commonConstructorInitialization() {
     sqlite3_set_authorizer(_db, _sqliteAuthorizerCallback, this);
 
     // I tested and found that we could set about 10,000,000 and the number of steps to run and get a callback once a
-    // second. This is set to be a bit more granular than that, which is probably adequate.
-    sqlite3_progress_handler(_db, 1'000'000, _progressHandlerCallback, this);
+    // second. The default is a bit more granular than that; `startTiming` tightens it further when a command's
+    // remaining budget calls for it (see _budgetedProgressPeriod).
+    sqlite3_progress_handler(_db, PROGRESS_PERIOD_DEFAULT, _progressHandlerCallback, this);
 
     // Check if synchronous has been set and run query to use a custom synchronous setting
     if (!_synchronous.empty()) {
         SASSERT(!SQuery(_db, "setting custom synchronous commits", "PRAGMA synchronous = " + SQ(_synchronous)  + ";"));
+    } else if (enableGroupCommit.load()) {
+        // In group-commit mode we do our own WAL syncs from `commit()`, one per group, so we turn off the per-commit
+        // sync. An explicit `-synchronous` setting takes precedence over this.
+        DBINFO("Group commit enabled, using PRAGMA synchronous = OFF with explicit per-group WAL syncs");
+        SASSERT(!SQuery(_db, "disabling per-commit sync for group commit", "PRAGMA synchronous = OFF;"));
     } else {
         DBINFO("Using SQLite default PRAGMA synchronous");
     }
@@ -187,14 +274,15 @@ SQLite::SQLite(const string& filename, int cacheSize, int maxJournalSize,
     _filename(initializeFilename(filename)),
     _maxJournalSize(maxJournalSize),
     _db(initializeDB(_filename, mmapSizeGB)),
-    _journalNames(initializeJournal(_db, minJournalTables)),
+    _journalNames(initializeJournal(_db, minJournalTables, _filename)),
     _sharedData(initializeSharedData(_db, _filename, _journalNames)),
     _journalName(_journalNames[0]),
     _journalSize(initializeJournalSize(_db, _journalNames)),
     _pageLoggingEnabled(pageLoggingEnabled),
     _cacheSize(cacheSize),
     _synchronous(synchronous),
-    _mmapSizeGB(mmapSizeGB)
+    _mmapSizeGB(mmapSizeGB),
+    _readOnly(false)
 {
     commonConstructorInitialization();
 }
@@ -210,7 +298,26 @@ SQLite::SQLite(const SQLite& from) :
     _pageLoggingEnabled(from._pageLoggingEnabled),
     _cacheSize(from._cacheSize),
     _synchronous(from._synchronous),
-    _mmapSizeGB(from._mmapSizeGB)
+    _mmapSizeGB(from._mmapSizeGB),
+    _readOnly(false)
+{
+    commonConstructorInitialization();
+}
+
+SQLite::SQLite(const SQLite& from, bool readOnly) :
+    _filename(from._filename),
+    _maxJournalSize(from._maxJournalSize),
+    _db(initializeDB(_filename, from._mmapSizeGB, readOnly)),
+    _journalNames(from._journalNames),
+    _sharedData(from._sharedData),
+    // A read-only handle never writes to a journal, so it doesn't need to claim one; just share the base name.
+    _journalName(_journalNames[0]),
+    _journalSize(from._journalSize),
+    _pageLoggingEnabled(from._pageLoggingEnabled),
+    _cacheSize(from._cacheSize),
+    _synchronous(from._synchronous),
+    _mmapSizeGB(from._mmapSizeGB),
+    _readOnly(readOnly)
 {
     commonConstructorInitialization();
 }
@@ -244,6 +351,10 @@ void SQLite::_sqliteLogCallback(void* pArg, int iErrCode, const char* zMsg) {
 int SQLite::_sqliteTraceCallback(unsigned int traceCode, void* c, void* p, void* x) {
     if (enableTrace && traceCode == SQLITE_TRACE_STMT) {
         SINFO("NORMALIZED_SQL:" << sqlite3_normalized_sql((sqlite3_stmt*)p));
+    } else if (traceCode == SQLITE_TRACE_PROFILE) {
+        // `p` is the completed statement and `x` its elapsed time in nanoseconds. The ledger decides internally
+        // whether this statement is one of its 1-in-N samples.
+        SQLiteQueryLedger::recordStatement((sqlite3_stmt*)p, *(uint64_t*)x);
     }
     return 0;
 }
@@ -251,9 +362,58 @@ int SQLite::_sqliteTraceCallback(unsigned int traceCode, void* c, void* p, void*
 int SQLite::_sqliteWALCallback(void* data, sqlite3* db, const char* dbName, int pageCount) {
     SQLite* object = static_cast<SQLite*>(data);
     object->_sharedData._currentPageCount.store(pageCount);
-    // Try a passive checkpoint if full checkpoints aren't enabled, *or* if the page count is less than the required
-    // size for a full checkpoint.
-    if (pageCount >= fullCheckpointPageMin.load()) {
+
+    // Once the WAL crosses the passive threshold, make sure the background passive checkpointer is running. Passive
+    // checkpoints never block readers or writers, so running them continually from their own thread keeps the WAL
+    // from growing to the point where the blocking restart checkpoint below is required, and keeps the checkpoint
+    // work itself off of committing threads entirely.
+    if (pageCount >= passiveCheckpointPageMin.load() && pageCount < fullCheckpointPageMin.load()) {
+        int alreadyCheckpointing = object->_sharedData._passiveCheckpointThreadBusy.fetch_add(1);
+        if (alreadyCheckpointing) {
+            // It's already running, it'll pick up the new pages itself.
+            return SQLITE_OK;
+        }
+        string dbNameCopy = dbName;
+
+        // See the comment on the restart checkpoint thread below for an explanation of `destructorLock`.
+        thread([object, dbNameCopy, destructorLock = unique_lock<mutex>(object->_destructorMutex)]() {
+            SInitialize("passiveCheckpoint");
+            while (true) {
+                // If a restart checkpoint is pending, get out of its way, it supersedes us.
+                if (object->_sharedData._checkpointThreadBusy.load()) {
+                    break;
+                }
+
+                // If a snapshot transfer is holding checkpoints, leave the main file alone; the next WAL callback
+                // after the holds clear will start us again.
+                if (object->_sharedData._checkpointHolds.load()) {
+                    SINFO("[checkpoint] Skipping passive checkpoint, checkpoints are held.");
+                    break;
+                }
+
+                // Each pass checkpoints only the frames that no current reader needs, so it never blocks anyone.
+                uint64_t start = STimeNow();
+                int walSizeFrames = 0;
+                int framesCheckpointed = 0;
+                int result = sqlite3_wal_checkpoint_v2(object->_db, dbNameCopy.c_str(), SQLITE_CHECKPOINT_PASSIVE, &walSizeFrames, &framesCheckpointed);
+                SINFO("[checkpoint] passive checkpoint complete with " << object->_sharedData._currentPageCount
+                      << " pages in WAL file. Result: " << result << ". Total frames checkpointed: "
+                      << framesCheckpointed << " of " << walSizeFrames << " in " << ((STimeNow() - start) / 1000) << "ms.");
+
+                // If we're caught up, or made no progress (a long-running reader is pinning the rest of the WAL, and
+                // retrying won't help until it finishes), we're done for now. The next WAL callback past the
+                // threshold will start us again.
+                if (result != SQLITE_OK || framesCheckpointed >= walSizeFrames || framesCheckpointed == 0) {
+                    break;
+                }
+
+                // We made partial progress. Give the readers that blocked us a moment to advance, then take another
+                // incremental pass at the remainder.
+                usleep(10'000);
+            }
+            object->_sharedData._passiveCheckpointThreadBusy.store(0);
+        }).detach();
+    } else if (pageCount >= fullCheckpointPageMin.load()) {
         // If we get here, then full checkpoints are enabled, and we have enough pages in the WAL file to perform one.
         SINFO("[checkpoint] " << pageCount << " pages behind, beginning complete checkpoint.");
 
@@ -295,6 +455,12 @@ int SQLite::_sqliteWALCallback(void* data, sqlite3* db, const char* dbName, int
                 // to prevent bouncing off of this check every loop. If that's the case, just break out of the this loop
                 // and wait for the next full check point to be required.
                 int pageCount = object->_sharedData._currentPageCount.load();
+                if (object->_sharedData._checkpointHolds.load()) {
+                    // A snapshot transfer is holding checkpoints; the main file has to stay byte-stable until it's
+                    // done, so give up and let a later WAL callback retry.
+                    SINFO("[checkpoint] Skipping restart checkpoint, checkpoints are held.");
+                    break;
+                }
                 if (pageCount < (fullCheckpointPageMin.load() / 2)) {
                     SINFO("[checkpoint] Page count decreased below half the threshold, count is now " << pageCount << ", exiting full checkpoint loop.");
                     break;
@@ -350,15 +516,21 @@ SQLite::~SQLite() {
     lock_guard<mutex> lock(_destructorMutex);
     // Now we can clean up our own data.
     // First, rollback any incomplete transaction.
-    if (!_uncommittedQuery.empty()) {
+    if (_uncommittedQuerySize) {
         SINFO("Rolling back in destructor.");
         rollback();
         SINFO("Rollback in destructor complete.");
     }
 
+    // Finalize any cached prepared statements, they can't outlive the DB handle.
+    for (auto& stmtPair : _preparedStatements) {
+        sqlite3_finalize(stmtPair.second.stmt);
+    }
+    _preparedStatements.clear();
+
     // Finally, Close the DB.
     DBINFO("Closing database '" << _filename << ".");
-    SASSERTWARN(_uncommittedQuery.empty());
+    SASSERTWARN(!_uncommittedQuerySize);
     SASSERT(!sqlite3_close(_db));
     DBINFO("Database closed.");
 }
@@ -367,15 +539,74 @@ void SQLite::waitForCheckpoint() {
     shared_lock<decltype(_sharedData.blockNewTransactionsMutex)> lock(_sharedData.blockNewTransactionsMutex);
 }
 
+void SQLite::holdCheckpoints() {
+    int holds = ++_sharedData._checkpointHolds;
+    SINFO("[checkpoint] Checkpoints held (" << holds << " holds).");
+}
+
+void SQLite::releaseCheckpoints() {
+    int holds = --_sharedData._checkpointHolds;
+    SINFO("[checkpoint] Checkpoint hold released (" << holds << " holds remain).");
+}
+
+bool SQLite::loadSnapshot(const string& snapshotFilename) {
+    // Open the received snapshot read-only; it's a complete database file, journals and all.
+    sqlite3* snapshotDB = nullptr;
+    if (sqlite3_open_v2(snapshotFilename.c_str(), &snapshotDB, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        SWARN("Couldn't open snapshot file '" << snapshotFilename << "' for bulk load.");
+        sqlite3_close(snapshotDB);
+        return false;
+    }
+
+    // Copy it into our own database page-by-page through the backup API, which handles the locking so that our
+    // other handles see the whole load as one atomic update. `-1` means copy everything in one step.
+    uint64_t start = STimeNow();
+    sqlite3_backup* backup = sqlite3_backup_init(_db, "main", snapshotDB, "main");
+    int result = SQLITE_ERROR;
+    if (backup) {
+        result = sqlite3_backup_step(backup, -1);
+        sqlite3_backup_finish(backup);
+    }
+    sqlite3_close(snapshotDB);
+    if (result != SQLITE_DONE) {
+        SWARN("Bulk load of snapshot '" << snapshotFilename << "' failed with result " << result << ".");
+        return false;
+    }
+
+    // The journal tables we just loaded are the authority on where this database now stands; refresh the shared
+    // commit count and hash from them, the same way they're initialized at startup.
+    string query = "SELECT MAX(maxIDs) FROM (" + _getJournalQuery(_journalNames, {"SELECT MAX(id) as maxIDs FROM"}, true) + ")";
+    SQResult countResult;
+    SASSERT(!SQuery(_db, "getting commit count", query, countResult));
+    uint64_t commitCount = countResult.empty() ? 0 : SToUInt64(countResult[0][0]);
+    string lastCommittedHash, ignore;
+    getCommit(_db, _journalNames, commitCount, ignore, lastCommittedHash);
+    _sharedData.commitCount = commitCount;
+    _sharedData.lastCommittedHash.store(lastCommittedHash);
+    _sharedData.resetTableWriteTracking(commitCount);
+    SINFO("Bulk-loaded snapshot '" << snapshotFilename << "' in " << ((STimeNow() - start) / 1000)
+          << "ms, now at commit " << commitCount << " (" << lastCommittedHash << ").");
+    return true;
+}
+
 bool SQLite::beginTransaction(TRANSACTION_TYPE type) {
+    // Read-only handles can't conflict with anything, so they never need the commit lock.
+    SASSERT(!_readOnly || type == TRANSACTION_TYPE::SHARED);
     if (type == TRANSACTION_TYPE::EXCLUSIVE) {
+        static atomic<uint64_t>& waitUS = SMetrics::counter("commitLock.waitUS");
+        static atomic<uint64_t>& waitCount = SMetrics::counter("commitLock.waitCount");
+        uint64_t waitStart = STimeNow();
+        _sharedData.commitLockWaiters++;
         _sharedData.commitLock.lock();
+        _sharedData.commitLockWaiters--;
+        waitUS += STimeNow() - waitStart;
+        waitCount++;
         _sharedData._commitLockTimer.start("EXCLUSIVE");
         _mutexLocked = true;
     }
     SASSERT(!_insideTransaction);
     SASSERT(_uncommittedHash.empty());
-    SASSERT(_uncommittedQuery.empty());
+    SASSERT(!_uncommittedQuerySize);
     {
         unique_lock<mutex> lock(_sharedData.notifyWaitMutex);
         _sharedData.currentTransactionCount++;
@@ -385,11 +616,14 @@ bool SQLite::beginTransaction(TRANSACTION_TYPE type) {
     // Reset before the query, as it's possible the query sets these.
     _abandonForCheckpoint = false;
     _autoRolledBack = false;
+    _writtenTables.clear();
 
     SDEBUG("[concurrent] Beginning transaction");
     uint64_t before = STimeNow();
     _currentTransactionAttemptCount = -1;
-    _insideTransaction = !SQuery(_db, "starting db transaction", "BEGIN CONCURRENT");
+
+    // Read-only handles take a plain snapshot transaction; BEGIN CONCURRENT requires a writable connection.
+    _insideTransaction = !SQuery(_db, "starting db transaction", _readOnly ? "BEGIN" : "BEGIN CONCURRENT");
 
     // Because some other thread could commit once we've run `BEGIN CONCURRENT`, this value can be slightly behind
     // where we're actually able to start such that we know we shouldn't get a conflict if this commits successfully on
@@ -398,6 +632,9 @@ bool SQLite::beginTransaction(TRANSACTION_TYPE type) {
     // the above `BEGIN CONCURRENT` and the `getCommitCount` call in a lock, which is worse.
     _dbCountAtStart = getCommitCount();
     _queryCache.clear();
+    _schemaSnapshotLoaded = false;
+    _schemaSnapshotTables.clear();
+    _schemaSnapshotIndexes.clear();
     _queryCount = 0;
     _cacheHits = 0;
     _beginElapsed = STimeNow() - before;
@@ -406,18 +643,45 @@ bool SQLite::beginTransaction(TRANSACTION_TYPE type) {
     _prepareElapsed = 0;
     _commitElapsed = 0;
     _rollbackElapsed = 0;
+
+    // Arm statement tracing for this transaction if the tracer's on. Read-only handles never hold the write
+    // position, so there's nothing to trace on them.
+    _traceActive = !_readOnly && SQLiteStatementTracer::enabled.load();
+    if (_traceActive) {
+        _traceStatements.clear();
+        _traceBeginUS = STimeNow();
+        _traceFirstWriteUS = 0;
+        _traceCommitLockUS = 0;
+        _traceOverflowCount = 0;
+    }
     return _insideTransaction;
 }
 
+void SQLite::_loadSchemaSnapshot() {
+    if (_schemaSnapshotLoaded) {
+        return;
+    }
+    SQResult result;
+    SASSERT(read("SELECT type, name, tbl_name, sql FROM sqlite_master WHERE type='table' OR type='index';", result));
+    for (size_t i = 0; i < result.size(); i++) {
+        if (result[i][0] == "table") {
+            _schemaSnapshotTables[string(result[i][1])] = string(result[i][3]);
+        } else {
+            _schemaSnapshotIndexes[string(result[i][1])] = make_pair(string(result[i][2]), string(result[i][3]));
+        }
+    }
+    _schemaSnapshotLoaded = true;
+}
+
 bool SQLite::verifyTable(const string& tableName, const string& sql, bool& created) {
     // sqlite trims semicolon, so let's not supply it else we get confused later
     SASSERT(!SEndsWith(sql, ";"));
 
-    // First, see if it's there
-    SQResult result;
-    SASSERT(read("SELECT sql FROM sqlite_master WHERE type='table' AND tbl_name=" + SQ(tableName) + ";", result));
+    // First, see if it's there, in the schema snapshot rather than with a query per table.
+    _loadSchemaSnapshot();
+    auto it = _schemaSnapshotTables.find(tableName);
     const string& collapsedSQL = SCollapse(sql);
-    if (result.empty()) {
+    if (it == _schemaSnapshotTables.end()) {
         // Table doesn't already exist, create it
         SINFO("Creating '" << tableName << "': " << collapsedSQL);
         SASSERT(write(collapsedSQL + ";"));
@@ -427,9 +691,8 @@ bool SQLite::verifyTable(const string& tableName, const string& sql, bool& creat
         // Table exists, verify it's correct.  Now, this can be a little tricky.
         // We'll count "correct" as having all the correct columns, in the correct
         // order.  However, the whitespace can differ.
-        SASSERT(!result[0].empty());
         created = false;
-        const string& collapsedResult = SCollapse(result[0][0]);
+        const string& collapsedResult = SCollapse(it->second);
         if (SStrip(collapsedResult, " ", false) == SStrip(collapsedSQL, " ", false)) {
             // Looking good
             SINFO("'" << tableName << "' already exists with correct schema.");
@@ -444,11 +707,11 @@ bool SQLite::verifyTable(const string& tableName, const string& sql, bool& creat
 
 bool SQLite::verifyIndex(const string& indexName, const string& tableName, const string& indexSQLDefinition, bool isUnique, bool createIfNotExists) {
     SINFO("Verifying index '" << indexName << "'. isUnique? " << to_string(isUnique));
-    SQResult result;
-    SASSERT(read("SELECT sql FROM sqlite_master WHERE type='index' AND tbl_name=" + SQ(tableName) + " AND name=" + SQ(indexName) + ";", result));
+    _loadSchemaSnapshot();
+    auto it = _schemaSnapshotIndexes.find(indexName);
 
     string createSQL = "CREATE" + string(isUnique ? " UNIQUE " : " ") + "INDEX " + indexName + " ON " + tableName + " " + indexSQLDefinition;
-    if (result.empty()) {
+    if (it == _schemaSnapshotIndexes.end() || it->second.first != tableName) {
         if (!createIfNotExists) {
             SINFO("Index '" << indexName << "' does not exist on table '" << tableName << "'.");
             return false;
@@ -458,15 +721,15 @@ bool SQLite::verifyIndex(const string& indexName, const string& tableName, const
         return true;
     } else {
         // Index exists, verify it is correct. Ignore spaces.
-        SASSERT(!result[0].empty());
-        return SIEquals(SReplace(createSQL, " ", ""), SReplace(result[0][0], " ", ""));
+        return SIEquals(SReplace(createSQL, " ", ""), SReplace(it->second.second, " ", ""));
     }
 }
 
 bool SQLite::addColumn(const string& tableName, const string& column, const string& columnType) {
     // Add a column to the table if it does not exist.  Totally freak out on error.
-    const string& sql =
-        SCollapse(read("SELECT sql FROM sqlite_master WHERE type='table' AND tbl_name='" + tableName + "';"));
+    _loadSchemaSnapshot();
+    auto it = _schemaSnapshotTables.find(tableName);
+    const string sql = (it == _schemaSnapshotTables.end()) ? "" : SCollapse(it->second);
     if (!SContains(sql, " " + column + " ")) {
         // Add column
         SINFO("Adding " << column << " " << columnType << " to " << tableName);
@@ -486,7 +749,26 @@ string SQLite::read(const string& query) {
     if (result.empty() || result[0].empty()) {
         return "";
     }
-    return result[0][0];
+    return string(result[0][0]);
+}
+
+string SQLite::explainQueryPlan(const string& query) {
+    SQResult result;
+    if (SQuery(_db, "explain query plan", "EXPLAIN QUERY PLAN " + query, result)) {
+        return "";
+    }
+
+    // Each row's last column is the human-readable plan step (the leading columns are tree-structure ids).
+    string plan;
+    for (size_t i = 0; i < result.size(); i++) {
+        if (!result[i].empty()) {
+            if (!plan.empty()) {
+                plan += "\n";
+            }
+            plan += result[i][result[i].size() - 1];
+        }
+    }
+    return plan;
 }
 
 bool SQLite::read(const string& query, SQResult& result) {
@@ -498,16 +780,285 @@ bool SQLite::read(const string& query, SQResult& result) {
         _cacheHits++;
         return true;
     }
+
+    // Check the shared cross-transaction cache. Results there are excluded if this transaction has its own
+    // uncommitted writes to any table the cached result read, since we need to see our own writes.
+    bool crossCacheActive = _sharedData.crossTransactionCacheActive();
+    if (crossCacheActive && _sharedData.getCachedResult(query, result, _writtenTables)) {
+        _cacheHits++;
+        _readElapsed += STimeNow() - before;
+        return true;
+    }
+
+    // Re-evaluate the timeout-check cadence at the statement boundary (the progress callback isn't allowed to
+    // reconfigure the connection that invoked it), so checks get denser as a command approaches its deadline.
+    _setProgressHandlerPeriod(_budgetedProgressPeriod());
+
     _isDeterministicQuery = true;
+    _captureQueryReadTables = crossCacheActive;
+    _queryReadTables.clear();
+    // The commit count the query's data actually reflects. Inside a transaction that's the snapshot taken at BEGIN
+    // (_dbCountAtStart is read from the snapshot itself), not the count right now: a commit that landed after our
+    // BEGIN already invalidated the cache, and publishing our pre-commit view of that table under the current count
+    // would resurrect stale data that nothing re-invalidates until the table's next write. Outside a transaction the
+    // read sees the latest committed state, so the current count is the right one (and at worst conservatively old,
+    // which just skips the publish).
+    uint64_t commitCountAtRead = _insideTransaction ? _dbCountAtStart : _sharedData.commitCount.load();
     bool queryResult = !SQuery(_db, "read only query", query, result);
+    _captureQueryReadTables = false;
     if (_isDeterministicQuery && queryResult) {
         _queryCache.emplace(make_pair(query, result));
+
+        // Publish to the cross-transaction cache too, unless we've written to one of the tables this query read (the
+        // result would include uncommitted data). cacheResult itself verifies that every table read is opted in, and
+        // that nothing committed while we ran.
+        if (crossCacheActive && !_queryReadTables.empty()) {
+            bool readOwnWrites = false;
+            for (const string& table : _queryReadTables) {
+                if (_writtenTables.count(table)) {
+                    readOwnWrites = true;
+                    break;
+                }
+            }
+            if (!readOwnWrites) {
+                _sharedData.cacheResult(query, _queryReadTables, commitCountAtRead, result);
+            }
+        }
     }
     _checkInterruptErrors("SQLite::read"s);
     _readElapsed += STimeNow() - before;
+    if (_traceActive) {
+        _traceStatement(query, before, STimeNow() - before, false);
+    }
     return queryResult;
 }
 
+bool SQLite::readStreaming(const string& query, vector<string>& headers, const function<bool(const vector<string>& row)>& onRow) {
+    uint64_t before = STimeNow();
+    _queryCount++;
+
+    // One-shot prepare: streamed queries are ad-hoc (and often enormous), so we don't want them taking up space in
+    // the prepared-statement cache, and their results never go in the query cache since we never materialize them.
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(_db, query.c_str(), (int)query.size(), &stmt, nullptr) != SQLITE_OK) {
+        SWARN("Failed to prepare streaming query (" << sqlite3_errmsg(_db) << "): " << query);
+        return false;
+    }
+    int columnCount = sqlite3_column_count(stmt);
+    headers.clear();
+    for (int i = 0; i < columnCount; i++) {
+        const char* name = sqlite3_column_name(stmt, i);
+        headers.push_back(name ? name : "");
+    }
+
+    // Step through the rows, handing each to the caller as it's produced. The row vector is re-used so each row
+    // costs us its cell contents, not an allocation per cell.
+    int stepResult;
+    vector<string> row(columnCount);
+    while ((stepResult = sqlite3_step(stmt)) == SQLITE_ROW) {
+        for (int i = 0; i < columnCount; i++) {
+            const char* text = (const char*)sqlite3_column_text(stmt, i);
+            row[i] = text ? text : "";
+        }
+        if (!onRow(row)) {
+            stepResult = SQLITE_DONE;
+            break;
+        }
+    }
+    sqlite3_finalize(stmt);
+    _checkInterruptErrors("SQLite::readStreaming"s);
+    _readElapsed += STimeNow() - before;
+    if (stepResult != SQLITE_DONE) {
+        SWARN("readStreaming failed (" << stepResult << ": " << sqlite3_errmsg(_db) << "): " << query);
+        return false;
+    }
+    return true;
+}
+
+void SQLite::_appendUncommittedQuery(string&& query) {
+    _uncommittedQuerySize += query.size();
+    _uncommittedQueryChunks.push_back(move(query));
+}
+
+const string& SQLite::_coalesceUncommittedQuery() {
+    if (!_uncommittedQueryChunks.empty()) {
+        // One exactly-sized allocation for whatever isn't already merged.
+        _uncommittedQuery.reserve(_uncommittedQuerySize);
+        for (const string& chunk : _uncommittedQueryChunks) {
+            _uncommittedQuery += chunk;
+        }
+        _uncommittedQueryChunks.clear();
+    }
+    return _uncommittedQuery;
+}
+
+void SQLite::_clearUncommittedQuery() {
+    _uncommittedQuery.clear();
+    _uncommittedQueryChunks.clear();
+    _uncommittedQuerySize = 0;
+}
+
+bool SQLite::_uncommittedQueryContains(const string& value) const {
+    // Each chunk is a whole statement, so checking them individually can't miss a keyword.
+    if (SContains(_uncommittedQuery, value)) {
+        return true;
+    }
+    for (const string& chunk : _uncommittedQueryChunks) {
+        if (SContains(chunk, value)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SQLite::CachedStatement* SQLite::_getCachedStatement(const string& query) {
+    auto it = _preparedStatements.find(query);
+    if (it != _preparedStatements.end()) {
+        return &it->second;
+    }
+
+    // Not cached yet, compile it now. This is the parse/plan step that the cache exists to skip.
+    sqlite3_stmt* stmt = nullptr;
+    int result = sqlite3_prepare_v2(_db, query.c_str(), (int)query.size(), &stmt, nullptr);
+    if (result != SQLITE_OK) {
+        SWARN("Failed to prepare statement (" << result << ": " << sqlite3_errmsg(_db) << "): " << query);
+        return nullptr;
+    }
+    CachedStatement& cached = _preparedStatements[query];
+    cached.stmt = stmt;
+    return &cached;
+}
+
+sqlite3_stmt* SQLite::_getPreparedStatement(const string& query) {
+    CachedStatement* cached = _getCachedStatement(query);
+    return cached ? cached->stmt : nullptr;
+}
+
+int SQLite::_stepPrepared(sqlite3_stmt* stmt, const vector<string>& bindings, SQResult& result) {
+    // Bind everything as text. SQLite coerces as required, and all of our query-building helpers pass values as
+    // strings anyway, so this matches how the string-based interface behaves.
+    for (size_t i = 0; i < bindings.size(); i++) {
+        sqlite3_bind_text(stmt, (int)i + 1, bindings[i].c_str(), (int)bindings[i].size(), SQLITE_TRANSIENT);
+    }
+
+    // Fill in the headers from the statement metadata.
+    result.clear();
+    int columnCount = sqlite3_column_count(stmt);
+    for (int i = 0; i < columnCount; i++) {
+        const char* name = sqlite3_column_name(stmt, i);
+        result.headers.push_back(name ? name : "");
+    }
+
+    // And step through any rows, writing the column bytes straight into the result's arena.
+    int stepResult;
+    while ((stepResult = sqlite3_step(stmt)) == SQLITE_ROW) {
+        result.addRow();
+        for (int i = 0; i < columnCount; i++) {
+            const char* text = (const char*)sqlite3_column_text(stmt, i);
+            result.addCell(text ? text : "", text ? (size_t)sqlite3_column_bytes(stmt, i) : 0);
+        }
+    }
+
+    // Reset so the statement (and its cache entry) can be immediately re-used.
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    return stepResult;
+}
+
+bool SQLite::readPrepared(const string& query, const vector<string>& bindings, SQResult& result) {
+    uint64_t before = STimeNow();
+    _queryCount++;
+    CachedStatement* cached = _getCachedStatement(query);
+    if (!cached) {
+        return false;
+    }
+
+    // Statements with enough history to know they're fast keep the sparse default cadence even near the deadline:
+    // if the observed worst case fits eight times over in what's left of the budget, dense checks can't fire before
+    // the statement finishes anyway, and just cost. Everything else gets the budget-driven period.
+    uint64_t remainingUS = (_timeoutLimit > before) ? _timeoutLimit - before : 0;
+    if (_timeoutLimit && cached->executions >= 10 && cached->worstTimeUS * 8 < remainingUS) {
+        _setProgressHandlerPeriod(PROGRESS_PERIOD_DEFAULT);
+    } else {
+        _setProgressHandlerPeriod(_budgetedProgressPeriod());
+    }
+    int stepResult = _stepPrepared(cached->stmt, bindings, result);
+    _checkInterruptErrors("SQLite::readPrepared"s);
+    uint64_t elapsed = STimeNow() - before;
+    cached->executions++;
+    cached->worstTimeUS = max(elapsed, cached->worstTimeUS - cached->worstTimeUS / 64);
+    _readElapsed += elapsed;
+    if (_traceActive) {
+        _traceStatement(query, before, elapsed, false);
+    }
+    return stepResult == SQLITE_DONE;
+}
+
+bool SQLite::writePrepared(const string& query, const vector<string>& bindings) {
+    if (_writeProbeMode) {
+        throw write_attempted_error();
+    }
+    if (_noopUpdateMode) {
+        SALERT("Non-idempotent write in _noopUpdateMode. Query: " << query);
+        return true;
+    }
+    SASSERT(_insideTransaction);
+    _queryCache.clear();
+    _queryCount++;
+
+    uint64_t changesBefore = sqlite3_total_changes(_db);
+    uint64_t before = STimeNow();
+    CachedStatement* cached = _getCachedStatement(query);
+    if (!cached) {
+        return false;
+    }
+    sqlite3_stmt* stmt = cached->stmt;
+
+    // Same cadence decision as readPrepared: known-fast statements keep the sparse default, everything else gets
+    // the budget-driven period.
+    uint64_t remainingUS = (_timeoutLimit > before) ? _timeoutLimit - before : 0;
+    if (_timeoutLimit && cached->executions >= 10 && cached->worstTimeUS * 8 < remainingUS) {
+        _setProgressHandlerPeriod(PROGRESS_PERIOD_DEFAULT);
+    } else {
+        _setProgressHandlerPeriod(_budgetedProgressPeriod());
+    }
+
+    // Bind first so we can capture the expanded SQL (with bound values substituted) for the journal before stepping.
+    for (size_t i = 0; i < bindings.size(); i++) {
+        sqlite3_bind_text(stmt, (int)i + 1, bindings[i].c_str(), (int)bindings[i].size(), SQLITE_TRANSIENT);
+    }
+    char* expanded = sqlite3_expanded_sql(stmt);
+    string expandedQuery = expanded ? expanded : query;
+    sqlite3_free(expanded);
+
+    int stepResult;
+    while ((stepResult = sqlite3_step(stmt)) == SQLITE_ROW) {
+        // Writes can return rows (i.e., RETURNING clauses), we just discard them here.
+    }
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    _checkInterruptErrors("SQLite::writePrepared"s);
+    uint64_t elapsed = STimeNow() - before;
+    cached->executions++;
+    cached->worstTimeUS = max(elapsed, cached->worstTimeUS - cached->worstTimeUS / 64);
+    _writeElapsed += elapsed;
+    if (_traceActive) {
+        _traceStatement(query, before, elapsed, true);
+    }
+    if (stepResult != SQLITE_DONE) {
+        SWARN("writePrepared failed (" << stepResult << ": " << sqlite3_errmsg(_db) << "): " << query);
+        return false;
+    }
+
+    // If the query changed anything, record the expanded SQL so the journal and replication see exactly what ran,
+    // just like `write` records the raw query string.
+    uint64_t changesAfter = sqlite3_total_changes(_db);
+    if (changesAfter > changesBefore) {
+        _appendUncommittedQuery(SEndsWith(expandedQuery, ";") ? move(expandedQuery) : (expandedQuery + ";"));
+    }
+    return true;
+}
+
 void SQLite::_checkInterruptErrors(const string& error) {
 
     // Local error code.
@@ -571,6 +1122,9 @@ bool SQLite::writeUnmodified(const string& query) {
 }
 
 bool SQLite::_writeIdempotent(const string& query, bool alwaysKeepQueries) {
+    if (_writeProbeMode) {
+        throw write_attempted_error();
+    }
     SASSERT(_insideTransaction);
     _queryCache.clear();
     _queryCount++;
@@ -584,6 +1138,9 @@ bool SQLite::_writeIdempotent(const string& query, bool alwaysKeepQueries) {
     uint64_t schemaBefore = SToUInt64(results[0][0]);
     uint64_t changesBefore = sqlite3_total_changes(_db);
 
+    // Re-evaluate the timeout-check cadence at the statement boundary, as in `read`.
+    _setProgressHandlerPeriod(_budgetedProgressPeriod());
+
     // Try to execute the query
     uint64_t before = STimeNow();
     bool result = false;
@@ -605,6 +1162,9 @@ bool SQLite::_writeIdempotent(const string& query, bool alwaysKeepQueries) {
     }
     _checkInterruptErrors("SQLite::write"s);
     _writeElapsed += STimeNow() - before;
+    if (_traceActive) {
+        _traceStatement(query, before, STimeNow() - before, true);
+    }
     if (!result) {
         return false;
     }
@@ -617,42 +1177,86 @@ bool SQLite::_writeIdempotent(const string& query, bool alwaysKeepQueries) {
 
     // If something changed, or we're always keeping queries, then save this.
     if (alwaysKeepQueries || (schemaAfter > schemaBefore) || (changesAfter > changesBefore)) {
-        _uncommittedQuery += usedRewrittenQuery ? _rewrittenQuery : query;
+        _appendUncommittedQuery(string(usedRewrittenQuery ? _rewrittenQuery : query));
+    }
+
+    // DDL went through this handle; the schema snapshot no longer matches sqlite_master.
+    if (schemaAfter > schemaBefore) {
+        _schemaSnapshotLoaded = false;
+        _schemaSnapshotTables.clear();
+        _schemaSnapshotIndexes.clear();
     }
     return true;
 }
 
 bool SQLite::prepare() {
     SASSERT(_insideTransaction);
+    SASSERT(!_readOnly);
+
+    // Do everything that doesn't depend on globally-ordered state *before* taking the commit lock, so that the
+    // serialized window holds only the work that genuinely has to be ordered: chaining the hash, claiming the next
+    // commit ID, and the journal insert. Coalescing the accumulated query chunks is the one place the full text gets
+    // materialized, into a single exactly-sized buffer, and for multi-MB transactions it's by far the biggest of
+    // these; doing it while other workers can still commit is what lets page-disjoint transactions overlap as much
+    // as the storage engine allows.
+    const string& uncommittedQuery = _coalesceUncommittedQuery();
+    sqlite3_stmt* stmt = _getPreparedStatement("INSERT INTO " + _journalName + " VALUES (?1, ?2, ?3);");
+
+    // If we're logging pages, grab the report of the pages this transaction has touched so far, so that it can be
+    // shipped to followers along with the transaction itself.
+    _lastWrittenPages.clear();
+    if (_pageLoggingEnabled) {
+        const char* report = sqlite3_begin_concurrent_report(_db);
+        _lastWrittenPages = report ? report : "";
+    }
 
     // We lock this here, so that we can guarantee the order in which commits show up in the database.
     if (!_mutexLocked) {
+        static atomic<uint64_t>& waitUS = SMetrics::counter("commitLock.waitUS");
+        static atomic<uint64_t>& waitCount = SMetrics::counter("commitLock.waitCount");
+        uint64_t waitStart = STimeNow();
+        _sharedData.commitLockWaiters++;
         _sharedData.commitLock.lock();
+        _sharedData.commitLockWaiters--;
+        waitUS += STimeNow() - waitStart;
+        waitCount++;
         _sharedData._commitLockTimer.start("SHARED");
         _mutexLocked = true;
+        if (_traceActive) {
+            // The second escalation point: from here through COMMIT, nobody else in the process can commit at all.
+            _traceCommitLockUS = STimeNow() - _traceBeginUS;
+        }
     }
 
     // Now that we've locked anybody else from committing, look up the state of the database. We don't need to lock the
-    // SharedData object to get these values as we know it can't currently change.
-    string committedQuery, committedHash;
+    // SharedData object to get these values as we know it can't currently change. The hash chains off the previous
+    // commit's hash (this is why we need the lock), computed over the two pieces without building a concatenated
+    // copy first. This chain is also why commits can't be made fully concurrent: it imposes a total order on commit
+    // IDs, on top of the single writer the WAL allows, so the best we can do is keep this window minimal.
     uint64_t commitCount = _sharedData.commitCount;
-
-    // Queue up the journal entry
-    string lastCommittedHash = getCommittedHash(); // This is why we need the lock.
-    _uncommittedHash = SToHex(SHashSHA1(lastCommittedHash + _uncommittedQuery));
+    string lastCommittedHash = getCommittedHash();
+    _uncommittedHash = SToHex(SHashSHA1(lastCommittedHash, uncommittedQuery));
     uint64_t before = STimeNow();
 
-    // Crete our query.
-    string query = "INSERT INTO " + _journalName + " VALUES (" + SQ(commitCount + 1) + ", " + SQ(_uncommittedQuery) + ", " + SQ(_uncommittedHash) + " )";
-
     // These are the values we're currently operating on, until we either commit or rollback.
-    _sharedData.prepareTransactionInfo(commitCount + 1, _uncommittedQuery, _uncommittedHash, _dbCountAtStart);
-
-    int result = SQuery(_db, "updating journal", query);
+    _sharedData.prepareTransactionInfo(commitCount + 1, uncommittedQuery, _uncommittedHash, _dbCountAtStart, _lastWrittenPages);
+
+    int result = SQLITE_ERROR;
+    if (stmt) {
+        sqlite3_bind_int64(stmt, 1, (sqlite3_int64)(commitCount + 1));
+        sqlite3_bind_text64(stmt, 2, uncommittedQuery.c_str(), uncommittedQuery.size(), SQLITE_STATIC, SQLITE_UTF8);
+        sqlite3_bind_text64(stmt, 3, _uncommittedHash.c_str(), _uncommittedHash.size(), SQLITE_STATIC, SQLITE_UTF8);
+        while ((result = sqlite3_step(stmt)) == SQLITE_ROW) {
+        }
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+        result = (result == SQLITE_DONE) ? SQLITE_OK : result;
+    }
     _prepareElapsed += STimeNow() - before;
-    if (result) {
+    if (result != SQLITE_OK) {
         // Couldn't insert into the journal; roll back the original commit
-        SWARN("Unable to prepare transaction, got result: " << result << ". Rolling back: " << _uncommittedQuery);
+        SWARN("Unable to prepare transaction, got result: " << result << ". Rolling back: "
+              << uncommittedQuery.substr(0, 200));
         rollback();
         return false;
     }
@@ -664,31 +1268,69 @@ bool SQLite::prepare() {
     return true;
 }
 
+void SQLite::_startJournalPruner() {
+    int alreadyRunning = _sharedData._journalPrunerBusy.fetch_add(1);
+    if (alreadyRunning) {
+        // It's already working through the journals, it'll pick up our new rows too.
+        return;
+    }
+
+    // Capture everything the thread needs by value (SharedData is a per-file singleton that's never destroyed, so
+    // the reference is safe). The pruner uses its own DB handle, so it costs foreground threads nothing.
+    string filename = _filename;
+    vector<string> journalNames = _journalNames;
+    uint64_t maxJournalSize = _maxJournalSize;
+    SharedData& sharedData = _sharedData;
+    thread([filename, journalNames, maxJournalSize, &sharedData]() {
+        SInitialize("journalPruner");
+        uint64_t start = STimeNow();
+        sqlite3* db = initializeDB(filename, 0);
+        int64_t totalDeleted = 0;
+        for (const string& journalName : journalNames) {
+            while (true) {
+                // Each batch is bounded and committed under the commit lock, so we serialize with foreground commits
+                // the same way the old inline DELETE did, but only for the duration of a small batch at a time.
+                {
+                    lock_guard<decltype(sharedData.commitLock)> lock(sharedData.commitLock);
+                    string query = "DELETE FROM " + journalName + " "
+                                   "WHERE id < (SELECT MAX(id) FROM " + journalName + ") - " + SQ(maxJournalSize) + " "
+                                   "LIMIT 1000";
+                    if (SQuery(db, "pruning journal", query)) {
+                        SWARN("[journal] Failed to prune " << journalName << ", giving up on this table.");
+                        break;
+                    }
+                }
+                int deleted = sqlite3_changes(db);
+                totalDeleted += deleted;
+                if (deleted < 1000) {
+                    // This table's down to size.
+                    break;
+                }
+
+                // Let foreground commits through before the next batch.
+                usleep(10'000);
+            }
+        }
+        sqlite3_close(db);
+        SINFO("[journal] Background prune deleted " << totalDeleted << " rows across " << journalNames.size()
+              << " journals in " << ((STimeNow() - start) / 1000) << "ms.");
+        sharedData._journalPrunerBusy.store(0);
+    }).detach();
+}
+
 int SQLite::commit() {
     SASSERT(_insideTransaction);
     SASSERT(!_uncommittedHash.empty()); // Must prepare first
     int result = 0;
 
-    // Do we need to truncate as we go?
+    // Do we need to truncate?
     uint64_t newJournalSize = _journalSize + 1;
     if (newJournalSize > _maxJournalSize) {
-        // Delete the oldest entry
-        uint64_t before = STimeNow();
-        string query = "DELETE FROM " + _journalName + " "
-                       "WHERE id < (SELECT MAX(id) FROM " + _journalName + ") - " + SQ(_maxJournalSize) + " "
-                       "LIMIT 10";
-        SASSERT(!SQuery(_db, "Deleting oldest journal rows", query));
-
-        // Figure out the new journal size.
-        SQResult result;
-        SASSERT(!SQuery(_db, "getting commit min", "SELECT MIN(id) AS id FROM " + _journalName, result));
-        uint64_t min = SToUInt64(result[0][0]);
-        SASSERT(!SQuery(_db, "getting commit max", "SELECT MAX(id) AS id FROM " + _journalName, result));
-        uint64_t max = SToUInt64(result[0][0]);
-        newJournalSize = max - min;
-
-        // Log timing info.
-        _writeElapsed += STimeNow() - before;
+        // Journal pruning happens on a background thread with its own DB handle, so the commit path never spends
+        // time on DELETEs or dirties a swath of the page cache while holding the commit lock. We just reset our
+        // counter here; if the pruner isn't keeping up, the next `_maxJournalSize` commits will trigger it again.
+        _startJournalPruner();
+        newJournalSize = 0;
     }
 
     // Make sure one is ready to commit
@@ -737,13 +1379,39 @@ int SQLite::commit() {
                              (report ? string(report) : "null"s);
             syslog(LOG_DEBUG, "%s", logLine.c_str());
         }
+        // In group-commit mode, the COMMIT above didn't sync the WAL. We sync here, while still holding the commit
+        // lock, but only when we're the last commit in the group: either nobody's waiting behind us, or we've hit the
+        // batch cap. Otherwise, we defer the sync to a later commit in the group, amortizing one fsync across all of
+        // them. Ordering is preserved because every one of these commits ran under the same lock.
+        if (enableGroupCommit.load()) {
+            int unsynced = _sharedData.unsyncedCommitCount.fetch_add(1) + 1;
+            if (_sharedData.commitLockWaiters.load() == 0 || unsynced >= GROUP_COMMIT_MAX_BATCH) {
+                uint64_t syncStart = STimeNow();
+                sqlite3_file* pWalFile = 0;
+                sqlite3_file_control(_db, "main", SQLITE_FCNTL_JOURNAL_POINTER, &pWalFile);
+                if (pWalFile && pWalFile->pMethods) {
+                    pWalFile->pMethods->xSync(pWalFile, SQLITE_SYNC_NORMAL);
+                }
+                SINFO("[group-commit] Synced WAL covering " << unsynced << " commits in "
+                      << ((STimeNow() - syncStart) / 1000) << "ms.");
+                _sharedData.unsyncedCommitCount.store(0);
+            }
+        }
         _commitElapsed += STimeNow() - before;
         _journalSize = newJournalSize;
         _sharedData.incrementCommit(_uncommittedHash);
+        _sharedData.recordTableWrites(_writtenTables, _sharedData.commitCount);
+
+        // Knock any results that read the tables we just wrote out of the cross-transaction query cache. This has to
+        // happen after incrementCommit so a concurrent reader can't re-publish pre-commit data (cacheResult rejects
+        // publishes whose commit count no longer matches).
+        if (_sharedData.crossTransactionCacheActive() && !_writtenTables.empty()) {
+            _sharedData.invalidateCachedTables(_writtenTables);
+        }
         SDEBUG("Commit successful (" << _sharedData.commitCount << "), releasing commitLock.");
         _insideTransaction = false;
         _uncommittedHash.clear();
-        _uncommittedQuery.clear();
+        _clearUncommittedQuery();
         _sharedData._commitLockTimer.stop();
         _sharedData.commitLock.unlock();
         _mutexLocked = false;
@@ -756,17 +1424,11 @@ int SQLite::commit() {
         }
         _sharedData.blockNewTransactionsCV.notify_one();
 
-        // See if we can checkpoint without holding the commit lock.
-        if (!_sharedData._checkpointThreadBusy) {
-            int walSizeFrames = 0;
-            int framesCheckpointed = 0;
-            uint64_t start = STimeNow();
-            int result = sqlite3_wal_checkpoint_v2(_db, 0, SQLITE_CHECKPOINT_PASSIVE, &walSizeFrames, &framesCheckpointed);
-            SINFO("[checkpoint] passive checkpoint complete with " << _sharedData._currentPageCount
-                  << " pages in WAL file. Result: " << result << ". Total frames checkpointed: "
-                  << framesCheckpointed << " of " << walSizeFrames << " in " << ((STimeNow() - start) / 1000) << "ms.");
-        }
+        // Note that we don't checkpoint here. Passive checkpoints are run by the background thread started from
+        // `_sqliteWALCallback` when the WAL crosses the threshold, so committing threads don't spend their own time
+        // on checkpoint IO.
         SINFO("Transaction commit with " << _queryCount << " queries attempted, " << _cacheHits << " served from cache.");
+        _finishTrace(true);
         _queryCount = 0;
         _cacheHits = 0;
         _dbCountAtStart = 0;
@@ -787,7 +1449,112 @@ int SQLite::commit() {
     return result;
 }
 
-map<uint64_t, tuple<string, string, uint64_t>> SQLite::popCommittedTransactions() {
+bool SQLite::applyCatchUpBatch(const vector<pair<string, string>>& commits) {
+    SASSERT(!_insideTransaction);
+    SASSERT(!_readOnly);
+    if (commits.empty()) {
+        return true;
+    }
+
+    // EXCLUSIVE takes the commit lock before BEGIN, so nothing else can commit between our snapshot and our COMMIT.
+    // That's what lets us chain and verify every hash up front with no conflict check at the end: the committed hash
+    // we start from can't move underneath us.
+    if (!beginTransaction(TRANSACTION_TYPE::EXCLUSIVE)) {
+        return false;
+    }
+
+    // Catch-up batches hold the commit lock for their whole lifetime by design; tracing them would just crowd real
+    // plugin transactions out of the statement tracer's report.
+    _traceActive = false;
+    uint64_t commitCount = _sharedData.commitCount;
+    string hash = getCommittedHash();
+    uint64_t before = STimeNow();
+    vector<string> hashes;
+    hashes.reserve(commits.size());
+    try {
+        sqlite3_stmt* stmt = _getPreparedStatement("INSERT INTO " + _journalName + " VALUES (?1, ?2, ?3);");
+        if (!stmt) {
+            STHROW("failed to prepare journal insert");
+        }
+        for (size_t i = 0; i < commits.size(); i++) {
+            const string& query = commits[i].first;
+            if (!writeUnmodified(query)) {
+                STHROW("failed to write batched transaction " + to_string(commitCount + i + 1));
+            }
+            hash = SToHex(SHashSHA1(hash, query));
+            if (hash != commits[i].second) {
+                STHROW("hash mismatch on batched transaction " + to_string(commitCount + i + 1) + ": computed "
+                       + hash + ", leader committed " + commits[i].second);
+            }
+            sqlite3_bind_int64(stmt, 1, (sqlite3_int64)(commitCount + i + 1));
+            sqlite3_bind_text64(stmt, 2, query.c_str(), query.size(), SQLITE_STATIC, SQLITE_UTF8);
+            sqlite3_bind_text64(stmt, 3, hash.c_str(), hash.size(), SQLITE_STATIC, SQLITE_UTF8);
+            int result = SQLITE_ERROR;
+            while ((result = sqlite3_step(stmt)) == SQLITE_ROW) {
+            }
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+            if (result != SQLITE_DONE) {
+                STHROW("failed to journal batched transaction " + to_string(commitCount + i + 1) + ", got result: "
+                       + to_string(result));
+            }
+            hashes.push_back(hash);
+        }
+
+        // One COMMIT (and thus one WAL sync) covers the whole batch. We've held the commit lock since before BEGIN,
+        // so a conflict is impossible here.
+        if (SQuery(_db, "committing batched transactions", "COMMIT")) {
+            STHROW("failed to commit batch");
+        }
+    } catch (const SException& e) {
+        SWARN("Catch-up batch of " << commits.size() << " commits after " << commitCount << " failed, rolling back: "
+              << e.what());
+        rollback();
+        return false;
+    } catch (const checkpoint_required_error& e) {
+        SINFO("[checkpoint] Checkpoint interrupted catch-up batch, rolling back.");
+        rollback();
+        throw;
+    }
+
+    // Walk the shared state forward the same way the equivalent individual commits would have, so every observer
+    // (commit count, last hash, waiting readers) sees the same sequence of values.
+    for (const string& entryHash : hashes) {
+        _sharedData.incrementCommit(entryHash);
+    }
+
+    // And the bookkeeping `commit()` would normally do, sized for the batch.
+    _commitElapsed += STimeNow() - before;
+    uint64_t newJournalSize = _journalSize + commits.size();
+    if (newJournalSize > _maxJournalSize) {
+        _startJournalPruner();
+        newJournalSize = 0;
+    }
+    _journalSize = newJournalSize;
+    _sharedData.recordTableWrites(_writtenTables, _sharedData.commitCount);
+    if (_sharedData.crossTransactionCacheActive() && !_writtenTables.empty()) {
+        _sharedData.invalidateCachedTables(_writtenTables);
+    }
+    _insideTransaction = false;
+    _uncommittedHash.clear();
+    _clearUncommittedQuery();
+    _sharedData._commitLockTimer.stop();
+    _sharedData.commitLock.unlock();
+    _mutexLocked = false;
+    _queryCache.clear();
+    {
+        unique_lock<mutex> lock(_sharedData.notifyWaitMutex);
+        _sharedData.currentTransactionCount--;
+    }
+    _sharedData.blockNewTransactionsCV.notify_one();
+    _enableCheckpointInterrupt = true;
+    _dbCountAtStart = 0;
+    SINFO("Applied catch-up batch of " << commits.size() << " commits through " << _sharedData.commitCount
+          << " with one WAL sync, in " << ((STimeNow() - before) / 1000) << "ms.");
+    return true;
+}
+
+map<uint64_t, tuple<string, string, uint64_t, string>> SQLite::popCommittedTransactions() {
     return _sharedData.popCommittedTransactions();
 }
 
@@ -799,8 +1566,9 @@ void SQLite::rollback() {
             SINFO("Transaction was automatically rolled back, not sending 'ROLLBACK'.");
             _autoRolledBack = false;
         } else {
-            if (_uncommittedQuery.size()) {
-                SINFO("Rolling back transaction: " << _uncommittedQuery.substr(0, 100));
+            if (_uncommittedQuerySize) {
+                const string& firstChunk = _uncommittedQuery.empty() ? _uncommittedQueryChunks.front() : _uncommittedQuery;
+                SINFO("Rolling back transaction: " << firstChunk.substr(0, 100));
             }
             uint64_t before = STimeNow();
             SASSERT(!SQuery(_db, "rolling back db transaction", "ROLLBACK"));
@@ -818,10 +1586,10 @@ void SQLite::rollback() {
         // Finally done with this.
         _insideTransaction = false;
         _uncommittedHash.clear();
-        if (_uncommittedQuery.size()) {
+        if (_uncommittedQuerySize) {
             SINFO("Rollback successful.");
         }
-        _uncommittedQuery.clear();
+        _clearUncommittedQuery();
 
         // Only unlock the mutex if we've previously locked it. We can call `rollback` to cancel a transaction without
         // ever having called `prepare`, which would have locked our mutex.
@@ -840,6 +1608,7 @@ void SQLite::rollback() {
     }
     _queryCache.clear();
     SINFO("Transaction rollback with " << _queryCount << " queries attempted, " << _cacheHits << " served from cache.");
+    _finishTrace(false);
     _queryCount = 0;
     _cacheHits = 0;
     _dbCountAtStart = 0;
@@ -848,6 +1617,34 @@ void SQLite::rollback() {
     _enableCheckpointInterrupt = true;
 }
 
+void SQLite::_traceStatement(const string& query, uint64_t startUS, uint64_t durationUS, bool isWrite) {
+    if (isWrite && !_traceFirstWriteUS) {
+        // The first write is where BEGIN CONCURRENT starts taking page locks: from here on, this transaction can
+        // conflict with (and be conflicted by) every other writer. Clamp to 1 since 0 means "never reached".
+        _traceFirstWriteUS = max(startUS - _traceBeginUS, (uint64_t)1);
+    }
+    if (_traceStatements.size() >= SQLiteStatementTracer::MAX_STATEMENTS) {
+        _traceOverflowCount++;
+        return;
+    }
+    SQLiteStatementTracer::Statement statement;
+    statement.startUS = startUS - _traceBeginUS;
+    statement.durationUS = durationUS;
+    statement.isWrite = isWrite;
+    statement.query = query.substr(0, SQLiteStatementTracer::QUERY_SNIPPET_LENGTH);
+    _traceStatements.push_back(move(statement));
+}
+
+void SQLite::_finishTrace(bool committed) {
+    if (!_traceActive) {
+        return;
+    }
+    _traceActive = false;
+    SQLiteStatementTracer::record(move(_traceStatements), _traceFirstWriteUS, _traceCommitLockUS,
+                                  STimeNow() - _traceBeginUS, _traceOverflowCount, committed);
+    _traceStatements.clear();
+}
+
 uint64_t SQLite::getLastTransactionTiming(uint64_t& begin, uint64_t& read, uint64_t& write, uint64_t& prepare,
                                           uint64_t& commit, uint64_t& rollback) {
     // Just populate and return
@@ -903,8 +1700,8 @@ bool SQLite::getCommits(uint64_t fromIndex, uint64_t toIndex, SQResult& result)
 
 int64_t SQLite::getLastInsertRowID() {
     // Make sure it *does* happen after an INSERT, but not with a IGNORE
-    SASSERTWARN(SContains(_uncommittedQuery, "INSERT") || SContains(_uncommittedQuery, "REPLACE"));
-    SASSERTWARN(!SContains(_uncommittedQuery, "IGNORE"));
+    SASSERTWARN(_uncommittedQueryContains("INSERT") || _uncommittedQueryContains("REPLACE"));
+    SASSERTWARN(!_uncommittedQueryContains("IGNORE"));
     int64_t sqliteRowID = (int64_t)sqlite3_last_insert_rowid(_db);
     return sqliteRowID;
 }
@@ -956,6 +1753,24 @@ int SQLite::_authorize(int actionCode, const char* detail1, const char* detail2,
         }
     }
 
+    // Note which tables this transaction writes, so that after a conflicting commit we can attribute the conflict to
+    // specific tables. This needs to happen before the whitelist early-return below, which is the common case.
+    if (_insideTransaction && detail1 &&
+        (actionCode == SQLITE_INSERT || actionCode == SQLITE_UPDATE || actionCode == SQLITE_DELETE)) {
+        _writtenTables.emplace(detail1);
+    }
+
+    // When the cross-transaction query cache is in use, note which tables the currently-executing read touches, so
+    // read() can decide whether the result is publishable and tag it for invalidation.
+    if (_captureQueryReadTables && detail1 && actionCode == SQLITE_READ) {
+        _queryReadTables.emplace(detail1);
+    }
+
+    // When whole-transaction read tracking is on (see trackReadTables), accumulate every table read.
+    if (_trackReadTables && detail1 && actionCode == SQLITE_READ) {
+        _readTables.emplace(detail1);
+    }
+
     // If the whitelist isn't set, we always return OK.
     if (!whitelist) {
         return SQLITE_OK;
@@ -1041,12 +1856,34 @@ void SQLite::startTiming(uint64_t timeLimitUS) {
     _timeoutStart = STimeNow();
     _timeoutLimit = _timeoutStart + timeLimitUS;
     _timeoutError = 0;
+    _setProgressHandlerPeriod(_budgetedProgressPeriod());
 }
 
 void SQLite::resetTiming() {
     _timeoutLimit = 0;
     _timeoutStart = 0;
     _timeoutError = 0;
+    _setProgressHandlerPeriod(PROGRESS_PERIOD_DEFAULT);
+}
+
+void SQLite::_setProgressHandlerPeriod(int opcodes) {
+    if (opcodes != _progressHandlerPeriod) {
+        sqlite3_progress_handler(_db, opcodes, _progressHandlerCallback, this);
+        _progressHandlerPeriod = opcodes;
+    }
+}
+
+int SQLite::_budgetedProgressPeriod() const {
+    if (!_timeoutLimit) {
+        return PROGRESS_PERIOD_DEFAULT;
+    }
+    uint64_t now = STimeNow();
+    uint64_t remainingUS = _timeoutLimit > now ? _timeoutLimit - now : 0;
+
+    // Roughly 20 checks across the remaining budget, so the overshoot on a runaway query is bounded by ~5% of
+    // whatever budget was left when it started, and by the minimum period (~0.5ms of opcodes) near the deadline.
+    uint64_t period = remainingUS * PROGRESS_OPCODES_PER_US / 20;
+    return (int)min<uint64_t>(max<uint64_t>(period, PROGRESS_PERIOD_MIN), PROGRESS_PERIOD_DEFAULT);
 }
 
 void SQLite::setUpdateNoopMode(bool enabled) {
@@ -1062,7 +1899,7 @@ void SQLite::setUpdateNoopMode(bool enabled) {
     // If we're inside a transaction, make sure this gets saved so it can be replicated.
     // If we're not (i.e., a transaction's already been rolled back), no need, there's nothing to replicate.
     if (_insideTransaction) {
-        _uncommittedQuery += query;
+        _appendUncommittedQuery(move(query));
     }
 }
 
@@ -1070,6 +1907,10 @@ bool SQLite::getUpdateNoopMode() const {
     return _noopUpdateMode;
 }
 
+void SQLite::setWriteProbeMode(bool enabled) {
+    _writeProbeMode = enabled;
+}
+
 uint64_t SQLite::getDBCountAtStart() const {
     return _dbCountAtStart;
 }
@@ -1084,9 +1925,14 @@ void SQLite::removeCheckpointListener(SQLite::CheckpointRequiredListener& listen
 
 SQLite::SharedData::SharedData() :
 nextJournalCount(0),
+commitLockWaiters(0),
+unsyncedCommitCount(0),
 currentTransactionCount(0),
 _currentPageCount(0),
 _checkpointThreadBusy(0),
+_passiveCheckpointThreadBusy(0),
+_checkpointHolds(0),
+_journalPrunerBusy(0),
 _commitLockTimer("commit lock timer", {
     {"EXCLUSIVE", chrono::steady_clock::duration::zero()},
     {"SHARED", chrono::steady_clock::duration::zero()},
@@ -1124,9 +1970,121 @@ void SQLite::SharedData::incrementCommit(const string& commitHash) {
     lastCommittedHash.store(commitHash);
 }
 
-void SQLite::SharedData::prepareTransactionInfo(uint64_t commitID, const string& query, const string& hash, uint64_t dbCountAtTransactionStart) {
+void SQLite::SharedData::enableCrossTransactionCache(const string& table) {
+    lock_guard<mutex> lock(_crossCacheMutex);
+    _crossCacheTables.insert(table);
+    _crossCacheActive.store(true);
+}
+
+bool SQLite::SharedData::getCachedResult(const string& query, SQResult& result, const set<string>& excludedTables) {
+    lock_guard<mutex> lock(_crossCacheMutex);
+    auto it = _crossCache.find(query);
+    if (it == _crossCache.end()) {
+        return false;
+    }
+
+    // If the caller wrote to any table this result read, it needs to see its own writes; make it re-run the query.
+    for (const string& table : it->second.tables) {
+        if (excludedTables.count(table)) {
+            return false;
+        }
+    }
+
+    // Hit. Move to the warm end of the LRU and copy out.
+    _crossCacheLRU.erase(it->second.lruIt);
+    _crossCacheLRU.push_front(it->first);
+    it->second.lruIt = _crossCacheLRU.begin();
+    result = it->second.result;
+    return true;
+}
+
+void SQLite::SharedData::cacheResult(const string& query, const set<string>& tables, uint64_t commitCountAtRead, const SQResult& result) {
+    lock_guard<mutex> lock(_crossCacheMutex);
+
+    // Only publishable if every table the query read is opted in, and nothing has committed since the read started -
+    // an interleaved commit may have invalidated exactly the data we're holding.
+    if (commitCountAtRead != commitCount.load()) {
+        return;
+    }
+    for (const string& table : tables) {
+        if (!_crossCacheTables.count(table)) {
+            return;
+        }
+    }
+    if (_crossCache.count(query)) {
+        return;
+    }
+    size_t bytes = query.size() + result.contentSize();
+    if (bytes > CROSS_CACHE_MAX_BYTES) {
+        return;
+    }
+
+    // Evict from the cold end until the new entry fits.
+    while (_crossCacheBytes + bytes > CROSS_CACHE_MAX_BYTES && !_crossCacheLRU.empty()) {
+        auto evictIt = _crossCache.find(_crossCacheLRU.back());
+        _crossCacheBytes -= evictIt->second.bytes;
+        _crossCache.erase(evictIt);
+        _crossCacheLRU.pop_back();
+    }
+    _crossCacheLRU.push_front(query);
+    _crossCache.emplace(query, CachedResult{result, tables, bytes, _crossCacheLRU.begin()});
+    _crossCacheBytes += bytes;
+}
+
+void SQLite::SharedData::invalidateCachedTables(const set<string>& tables) {
+    lock_guard<mutex> lock(_crossCacheMutex);
+    auto it = _crossCache.begin();
+    while (it != _crossCache.end()) {
+        bool invalid = false;
+        for (const string& table : it->second.tables) {
+            if (tables.count(table)) {
+                invalid = true;
+                break;
+            }
+        }
+        if (invalid) {
+            _crossCacheBytes -= it->second.bytes;
+            _crossCacheLRU.erase(it->second.lruIt);
+            it = _crossCache.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+void SQLite::SharedData::recordTableWrites(const set<string>& tables, uint64_t commitCount) {
+    if (tables.empty()) {
+        return;
+    }
+    lock_guard<mutex> lock(_tableWriteMutex);
+    for (const string& table : tables) {
+        uint64_t& lastWrite = _tableLastWriteCommit[table];
+        lastWrite = max(lastWrite, commitCount);
+    }
+}
+
+bool SQLite::SharedData::tablesUnmodifiedSince(const set<string>& tables, uint64_t commitCount) {
+    lock_guard<mutex> lock(_tableWriteMutex);
+    for (const string& table : tables) {
+        auto it = _tableLastWriteCommit.find(table);
+        uint64_t lastWrite = it == _tableLastWriteCommit.end() ? _tableWriteFloor : it->second;
+        if (lastWrite > commitCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SQLite::SharedData::resetTableWriteTracking(uint64_t commitCount) {
+    lock_guard<mutex> lock(_tableWriteMutex);
+    _tableLastWriteCommit.clear();
+    _tableWriteFloor = commitCount;
+}
+
+void SQLite::SharedData::prepareTransactionInfo(uint64_t commitID, const string& query, const string& hash, uint64_t dbCountAtTransactionStart,
+                                                const string& writtenPages) {
     lock_guard<decltype(_internalStateMutex)> lock(_internalStateMutex);
-    _preparedTransactions.insert_or_assign(commitID, make_tuple(query, hash, dbCountAtTransactionStart));
+    _preparedTransactions.insert_or_assign(commitID, make_tuple(query, hash, dbCountAtTransactionStart, writtenPages));
 }
 
 void SQLite::SharedData::commitTransactionInfo(uint64_t commitID) {
@@ -1134,7 +2092,7 @@ void SQLite::SharedData::commitTransactionInfo(uint64_t commitID) {
     _committedTransactions.insert(_preparedTransactions.extract(commitID));
 }
 
-map<uint64_t, tuple<string, string, uint64_t>> SQLite::SharedData::popCommittedTransactions() {
+map<uint64_t, tuple<string, string, uint64_t, string>> SQLite::SharedData::popCommittedTransactions() {
     lock_guard<decltype(_internalStateMutex)> lock(_internalStateMutex);
     decltype(_committedTransactions) result;
     result = move(_committedTransactions);
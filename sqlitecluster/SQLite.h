@@ -1,6 +1,7 @@
 #pragma once
 #include <libstuff/sqlite3.h>
 #include <libstuff/SPerformanceTimer.h>
+#include "SQLiteStatementTracer.h"
 
 class SQLite {
   public:
@@ -23,6 +24,14 @@ class SQLite {
         const char* what() const noexcept { return "checkpoint_required"; }
     };
 
+    // Thrown by the write methods in write-probe mode (see setWriteProbeMode).
+    class write_attempted_error : public exception {
+      public :
+        write_attempted_error() {};
+        virtual ~write_attempted_error() {};
+        const char* what() const noexcept { return "write_attempted"; }
+    };
+
     // Abstract base class for objects that need to be notified when we set `checkpointRequired` and then when that
     // checkpoint is complete. Why do we need to notify anyone that we're going to do a checkpoint? Because restart
     // checkpoints can't run simultaneously with any other transactions, and thus will block new transactions and wait
@@ -52,8 +61,16 @@ class SQLite {
     // with a *different* journal table. This avoids a lot of locking around creating structures that we know already
     // exist because we already have a SQLite object for this file.
     SQLite(const SQLite& from);
+
+    // Same as the above, but when `readOnly` is true the new handle is opened with SQLITE_OPEN_READONLY. Read-only
+    // handles serve snapshot-isolated reads: `beginTransaction` runs a plain BEGIN rather than BEGIN CONCURRENT, and
+    // write operations are disallowed, so they never contend on the commit lock or the journal.
+    SQLite(const SQLite& from, bool readOnly);
     ~SQLite();
 
+    // Returns true if this handle was opened read-only.
+    bool isReadOnly() const { return _readOnly; }
+
     // Returns the canonicalized filename for this database
     const string& getFilename() { return _filename; }
 
@@ -64,6 +81,30 @@ class SQLite {
     // Performs a read-only query (eg, SELECT) that returns a single value.
     string read(const string& query);
 
+    // Runs EXPLAIN QUERY PLAN on `query` and returns the plan as one detail line per step, joined with newlines (or
+    // an empty string if the statement won't prepare). Bypasses the query caches entirely, since the point is to see
+    // what the planner would pick right now (see SQLitePlanMonitor).
+    string explainQueryPlan(const string& query);
+
+    // Performs a read-only query, invoking `onRow` once per result row as sqlite3_step produces it, instead of
+    // materializing the whole result in an SQResult. `headers` is filled in from the statement metadata before the
+    // first callback (and even if there are no rows). If `onRow` returns false, the query stops early and this still
+    // returns true. Results are never cached, since they're never materialized. Used for streaming very large
+    // results to a client in bounded pieces.
+    bool readStreaming(const string& query, vector<string>& headers, const function<bool(const vector<string>& row)>& onRow);
+
+    // Performs a read-only query using a cached prepared statement. The query may contain `?` parameter markers, which
+    // are bound (as text) from `bindings` in order. The compiled statement is cached on this handle and re-used across
+    // transactions, so hot queries (i.e., GetJob's SELECT) skip the parse/plan step entirely on every call but the
+    // first. Note that this is different from the transaction-local result cache used by `read`, which caches result
+    // sets, not compiled statements, and is cleared at the end of every transaction.
+    bool readPrepared(const string& query, const vector<string>& bindings, SQResult& result);
+
+    // Performs a read/write query using a cached prepared statement, with the same binding semantics as
+    // `readPrepared`. The fully-expanded SQL (with bound values substituted) is recorded in the uncommitted query so
+    // that the journal and replication behave identically to `write`.
+    bool writePrepared(const string& query, const vector<string>& bindings);
+
     // Types of transactions that we can begin.
     enum class TRANSACTION_TYPE {
         SHARED,
@@ -106,6 +147,11 @@ class SQLite {
     void setUpdateNoopMode(bool enabled);
     bool getUpdateNoopMode() const;
 
+    // Enable or disable write-probe mode. While enabled, any attempt to write throws write_attempted_error instead
+    // of executing the query, so a caller can discover whether an operation *would* write without paying for the
+    // write itself (which could be an entire index build). Used to dry-run plugin upgrades concurrently at standup.
+    void setWriteProbeMode(bool enabled);
+
     // Prepare to commit or rollback the transaction. This also inserts the current uncommitted query into the
     // journal; no additional writes are allowed until the next transaction has begun.
     bool prepare();
@@ -136,6 +182,16 @@ class SQLite {
     // Commits the current transaction to disk. Returns an sqlite3 result code.
     int commit();
 
+    // Applies a run of sequential transactions that are already known to be committed upstream as a single local
+    // SQLite transaction: one BEGIN, one journal row per entry, and one COMMIT (and thus one WAL sync) at the end.
+    // Each entry is the transaction's full query text and the hash the leader committed it with; the hash chain and
+    // journal contents come out byte-for-byte identical to applying the entries one at a time, and each computed
+    // hash is verified against the leader's as the chain is built. On any failure the whole batch is rolled back and
+    // this returns false, leaving the commit count untouched. Throws checkpoint_required_error (after rolling back)
+    // if a checkpoint interrupts the batch, in which case the caller should wait for the checkpoint and retry.
+    // Must be called outside of any transaction; only useful on followers during catch-up.
+    bool applyCatchUpBatch(const vector<pair<string, string>>& commits);
+
     // Cancels the current transaction and rolls it back.
     void rollback();
 
@@ -160,8 +216,8 @@ class SQLite {
     string getUncommittedHash() { return _uncommittedHash; }
 
     // Returns a concatenated string containing all the 'write' queries executed within the current, uncommitted
-    // transaction.
-    string getUncommittedQuery() { return _uncommittedQuery; }
+    // transaction. The queries accumulate as chunks; this coalesces them (at most once per transaction).
+    const string& getUncommittedQuery() { return _coalesceUncommittedQuery(); }
 
     // Gets the ROWID of the last insertion (for auto-increment indexes)
     int64_t getLastInsertRowID();
@@ -172,6 +228,35 @@ class SQLite {
     // Returns true if we're inside an uncommitted transaction.
     bool insideTransaction() { return _insideTransaction; }
 
+    // Returns the set of tables that the current (or most recently finished) transaction wrote to, as reported by the
+    // authorizer. This is reset at the start of each transaction, not at commit or rollback, so after a conflicting
+    // commit the caller can still see which tables were involved.
+    const set<string>& getWrittenTables() const { return _writtenTables; }
+
+    // Whole-transaction read-set tracking: while enabled, every table the authorizer sees a read against is
+    // accumulated (this is separate from the per-query capture used by the cross-transaction cache). Enabling clears
+    // any previously-collected set; disabling keeps it, so the caller can still fetch it afterward. Used to attach a
+    // follower peek's read set to an escalation, so leader can prove the peek's conclusion is still valid.
+    void trackReadTables(bool enable) {
+        _trackReadTables = enable;
+        if (enable) {
+            _readTables.clear();
+        }
+    }
+    const set<string>& getReadTables() const { return _readTables; }
+
+    // Returns true if none of `tables` has been written by any commit after `commitCount`, according to the
+    // per-table write history shared by all handles on this file. Conservative: history this process didn't observe
+    // (commits from before startup, or restored in a snapshot) counts as modified.
+    bool tablesUnmodifiedSince(const set<string>& tables, uint64_t commitCount) {
+        return _sharedData.tablesUnmodifiedSince(tables, commitCount);
+    }
+
+    // Opts a table into the cross-transaction query cache (see SharedData). Only do this for append-only or
+    // rarely-written tables: every committed write to the table throws out all cached results that read it, and
+    // readers may be served results from commits newer than their own snapshot.
+    void enableCrossTransactionCache(const string& table) { _sharedData.enableCrossTransactionCache(table); }
+
     // Looks up the exact SQL of a paricular commit to the database, as well as gets the SHA1 hash of the database
     // immediately following tha commit.
     bool getCommit(uint64_t index, string& query, string& hash);
@@ -194,9 +279,14 @@ class SQLite {
     void removeCheckpointListener(CheckpointRequiredListener& listener);
 
     // This atomically removes and returns committed transactions from our internal list. SQLiteNode can call this, and
-    // it will return a map of transaction IDs to tuples of (query, hash, dbCountAtTransactionStart), so that those
-    // transactions can be replicated out to peers.
-    map<uint64_t, tuple<string,string, uint64_t>> popCommittedTransactions();
+    // it will return a map of transaction IDs to tuples of (query, hash, dbCountAtTransactionStart, writtenPages), so
+    // that those transactions can be replicated out to peers.
+    map<uint64_t, tuple<string, string, uint64_t, string>> popCommittedTransactions();
+
+    // Returns the begin-concurrent page report for the transaction most recently run through `prepare`, or the empty
+    // string if page logging isn't enabled. This lists the pages the transaction touched, and is attached to
+    // replicated transactions so followers can detect which ones can't possibly conflict with each other.
+    const string& getLastWrittenPages() const { return _lastWrittenPages; }
 
     // The whitelist is either nullptr, in which case the feature is disabled, or it's a map of table names to sets of
     // column names that are allowed for reading. Using whitelist at all put the database handle into a more
@@ -215,6 +305,14 @@ class SQLite {
     // Enable/disable SQL statement tracing.
     static atomic<bool> enableTrace;
 
+    // When enabled, the per-commit WAL sync is skipped (the DB runs with `PRAGMA synchronous = OFF`) and instead the
+    // thread holding the commit lock syncs the WAL once on behalf of every commit that piled up behind it: it only
+    // syncs when no other thread is waiting on the commit lock (or when the unsynced batch hits a cap). Because all
+    // commits are serialized through the commit lock anyway, this turns N fsyncs under write-heavy load into one,
+    // without changing commit ordering or the durability of the batch as a whole. Must be set before the first SQLite
+    // object is created.
+    static atomic<bool> enableGroupCommit;
+
     // Calling this before starting a transaction will prevent the next transaction from being interrupted by a restart
     // checkpoint and restarting. This causes a potential performance issue so only do this if it's *really important*
     // that this transaction isn't interrupted. The primary reason for adding this was to enable slow but very
@@ -222,6 +320,18 @@ class SQLite {
     // checkpoints to complete, thus causing an endless cycle of interrupted transactions.
     void disableCheckpointInterruptForNextTransaction() { _enableCheckpointInterrupt = false; }
 
+    // Hold off all checkpointing (passive and restart) for this database, so the main database file on disk stays
+    // byte-stable while it's streamed to a bootstrapping peer; writes keep accumulating in the WAL in the meantime.
+    // Calls nest across handles sharing the file. See SQLiteNode's snapshot transfer for the (only) use.
+    void holdCheckpoints();
+    void releaseCheckpoints();
+
+    // Bulk-load the entire contents of `snapshotFilename` — a raw database file received from a peer — into this
+    // database via sqlite3's backup API, replacing the current contents (only sane on an empty, bootstrapping node),
+    // then refresh the shared commit count and hash from the journal tables that came along inside the snapshot.
+    // Returns false on failure, leaving the database no worse than before.
+    bool loadSnapshot(const string& snapshotFilename);
+
     // public read-only accessor for _dbCountAtStart.
     uint64_t getDBCountAtStart() const;
 
@@ -247,7 +357,7 @@ class SQLite {
         void incrementCommit(const string& commitHash);
 
         // This removes and returns all committed transactions.
-        map<uint64_t, tuple<string, string, uint64_t>> popCommittedTransactions();
+        map<uint64_t, tuple<string, string, uint64_t, string>> popCommittedTransactions();
 
         // This is the last committed hash by *any* thread for this file.
         atomic<string> lastCommittedHash;
@@ -258,12 +368,32 @@ class SQLite {
 
         // When `SQLite::prepare` is called, we need to save a set of info that will be broadcast to peers when the
         // transaction is ultimately committed. This should be cleared out if the transaction is rolled back.
-        void prepareTransactionInfo(uint64_t commitID, const string& query, const string& hash, uint64_t dbCountAtTransactionStart);
+        void prepareTransactionInfo(uint64_t commitID, const string& query, const string& hash, uint64_t dbCountAtTransactionStart,
+                                    const string& writtenPages);
 
         // When a transaction that was prepared is committed, we move the data from the prepared list to the committed
         // list.
         void commitTransactionInfo(uint64_t commitID);
 
+        // Cross-transaction query cache. Tables opted in (they should be append-only or rarely written) allow whole
+        // SELECT results to be served across transactions and across handles; any committed write to such a table
+        // invalidates every cached result that read it, and the cache is size-capped with LRU eviction. Note the
+        // tradeoff: a reader on an older snapshot can be served data from a commit newer than its snapshot.
+        void enableCrossTransactionCache(const string& table);
+        bool crossTransactionCacheActive() const { return _crossCacheActive.load(); }
+        bool getCachedResult(const string& query, SQResult& result, const set<string>& excludedTables);
+        void cacheResult(const string& query, const set<string>& tables, uint64_t commitCountAtRead, const SQResult& result);
+        void invalidateCachedTables(const set<string>& tables);
+
+        // Per-table write history: every commit records the tables it wrote at its commit count, and
+        // `tablesUnmodifiedSince` answers whether any of a set of tables has been written *after* a given commit
+        // count. Tables with no recorded write fall back to the floor — the commit count at which tracking last
+        // (re)started — which is conservative for history this process didn't observe. `resetTableWriteTracking`
+        // clears the history and raises the floor; it's called wherever the commit count is (re)loaded from disk.
+        void recordTableWrites(const set<string>& tables, uint64_t commitCount);
+        bool tablesUnmodifiedSince(const set<string>& tables, uint64_t commitCount);
+        void resetTableWriteTracking(uint64_t commitCount);
+
         // The current commit count, loaded at initialization from the highest commit ID in the DB, and then accessed
         // though this atomic integer. getCommitCount() returns the value of this variable.
         atomic<uint64_t> commitCount;
@@ -273,6 +403,13 @@ class SQLite {
         // during a transaction).
         recursive_mutex commitLock;
 
+        // The number of threads currently blocked trying to acquire commitLock. The group-commit logic in `commit()`
+        // uses this to decide whether it can defer the WAL sync to a later commit in the group.
+        atomic<int> commitLockWaiters;
+
+        // The number of commits performed since the WAL was last synced, when group commit is enabled.
+        atomic<int> unsyncedCommitCount;
+
         // This mutex prevents any thread starting a new transaction when locked. The checkpoint thread will lock it
         // when required to make sure it can get exclusive use of the DB.
         shared_timed_mutex blockNewTransactionsMutex;
@@ -291,12 +428,48 @@ class SQLite {
         // Used as a flag to prevent starting multiple checkpoint threads simultaneously.
         atomic<int> _checkpointThreadBusy;
 
+        // Same, but for the background passive checkpoint thread, which can run concurrently with everything except
+        // a full (restart) checkpoint.
+        atomic<int> _passiveCheckpointThreadBusy;
+
+        // While non-zero, the checkpoint threads above bail out without touching the main database file (see
+        // holdCheckpoints); the WAL just keeps growing until the holds are released.
+        atomic<int> _checkpointHolds;
+
+        // And again, for the background journal pruner thread (see _startJournalPruner).
+        atomic<int> _journalPrunerBusy;
+
         SPerformanceTimer _commitLockTimer;
       private:
         // The data required to replicate transactions, in two lists, depending on whether this has only been prepared
         // or if it's been committed.
-        map<uint64_t, tuple<string, string, uint64_t>> _preparedTransactions;
-        map<uint64_t, tuple<string, string, uint64_t>> _committedTransactions;
+        map<uint64_t, tuple<string, string, uint64_t, string>> _preparedTransactions;
+        map<uint64_t, tuple<string, string, uint64_t, string>> _committedTransactions;
+
+        // Storage for the cross-transaction query cache above: the opted-in tables, the cached results keyed by
+        // query text (each tagged with the tables it read, its size, and its position in the LRU list), the LRU list
+        // itself (most recently used at the front), and the total cached bytes. All guarded by _crossCacheMutex;
+        // _crossCacheActive lets the read path skip the mutex entirely when nothing's opted in.
+        struct CachedResult {
+            SQResult result;
+            set<string> tables;
+            size_t bytes;
+            list<string>::iterator lruIt;
+        };
+        set<string> _crossCacheTables;
+        map<string, CachedResult> _crossCache;
+        list<string> _crossCacheLRU;
+        size_t _crossCacheBytes = 0;
+        mutex _crossCacheMutex;
+        atomic<bool> _crossCacheActive = false;
+        static constexpr size_t CROSS_CACHE_MAX_BYTES = 16 * 1024 * 1024;
+
+        // Storage for the per-table write history above: the last commit count at which each table was written, the
+        // floor assumed for tables with no recorded write, and their guard. The floor starts at UINT64_MAX so
+        // nothing is provably unmodified until tracking is initialized. Bounded by the schema's table count.
+        map<string, uint64_t> _tableLastWriteCommit;
+        uint64_t _tableWriteFloor = UINT64_MAX;
+        mutex _tableWriteMutex;
 
         // set of objects listening for checkpoints.
         set<SQLite::CheckpointRequiredListener*> _checkpointListeners;
@@ -309,8 +482,8 @@ class SQLite {
     // Initializers to support RAII-style allocation in constructors.
     static string initializeFilename(const string& filename);
     static SharedData& initializeSharedData(sqlite3* db, const string& filename, const vector<string>& journalNames);
-    static sqlite3* initializeDB(const string& filename, int64_t mmapSizeGB);
-    static vector<string> initializeJournal(sqlite3* db, int minJournalTables);
+    static sqlite3* initializeDB(const string& filename, int64_t mmapSizeGB, bool readOnly = false);
+    static vector<string> initializeJournal(sqlite3* db, int minJournalTables, const string& filename);
     static uint64_t initializeJournalSize(sqlite3* db, const vector<string>& journalNames);
     void commonConstructorInitialization();
 
@@ -339,9 +512,19 @@ class SQLite {
     bool _insideTransaction = false;
 
     // The new query and new hash to add to the journal for a transaction that's nearing completion, before we commit
-    // it.
+    // it. Writes accumulate one chunk per query in _uncommittedQueryChunks, so multi-MB transactions don't
+    // repeatedly reallocate one ever-growing string; _coalesceUncommittedQuery merges the chunks into
+    // _uncommittedQuery with a single exactly-sized allocation when the full text is actually needed.
     string _uncommittedQuery;
     string _uncommittedHash;
+    list<string> _uncommittedQueryChunks;
+    size_t _uncommittedQuerySize = 0;
+
+    // Helpers for the chunked accumulator above. The full text is always _uncommittedQuery followed by the chunks.
+    void _appendUncommittedQuery(string&& query);
+    const string& _coalesceUncommittedQuery();
+    void _clearUncommittedQuery();
+    bool _uncommittedQueryContains(const string& value) const;
 
     // Returns the name of a journal table based on it's index.
     static string getJournalTableName(vector<string>& journalNames, int64_t journalTableID, bool create = false);
@@ -364,8 +547,59 @@ class SQLite {
     // locked (i.e., this is `false` if some other DB object has locked the mutex).
     bool _mutexLocked = false;
 
+    // Statement-trace state for the current transaction (see SQLiteStatementTracer). `_traceActive` latches the
+    // tracer's enabled flag at BEGIN so a mid-transaction toggle can't produce a half-recorded trace;
+    // `_traceStatements` accumulates executed statements, and the two escalation offsets mark the first write and
+    // the commit-lock acquisition (0 = not reached). Reset by `beginTransaction`, submitted by `_finishTrace`.
+    bool _traceActive = false;
+    vector<SQLiteStatementTracer::Statement> _traceStatements;
+    uint64_t _traceBeginUS = 0;
+    uint64_t _traceFirstWriteUS = 0;
+    uint64_t _traceCommitLockUS = 0;
+    size_t _traceOverflowCount = 0;
+
+    // Records one executed statement into the current trace, marking the first-write escalation point as it goes
+    // by. `startUS` is the absolute start time (offsets are computed here). Callers check `_traceActive` first so
+    // the disabled case costs one branch.
+    void _traceStatement(const string& query, uint64_t startUS, uint64_t durationUS, bool isWrite);
+
+    // Submits the current trace to the tracer (no-op when tracing wasn't active for this transaction) and resets
+    // trace state. Called from `commit` and `rollback`.
+    void _finishTrace(bool committed);
+
     bool _writeIdempotent(const string& query, bool alwaysKeepQueries = false);
 
+    // Starts the background journal pruner thread if it's not already running. The pruner opens its own DB handle
+    // and trims every journal table back down to `maxJournalSize` rows in small batches, each committed under the
+    // commit lock, so the foreground commit path never runs journal DELETEs itself.
+    void _startJournalPruner();
+
+    // A cached compiled statement plus lightweight execution stats. The stats feed the adaptive progress-handler
+    // cadence: a statement whose observed worst case fits many times over in the remaining time budget doesn't need
+    // dense timeout checks, no matter how close the deadline is. `worstTimeUS` decays slowly so one ancient outlier
+    // doesn't pin the estimate forever.
+    struct CachedStatement {
+        sqlite3_stmt* stmt = nullptr;
+        uint64_t executions = 0;
+        uint64_t worstTimeUS = 0;
+    };
+
+    // Looks up (or compiles and caches) the statement for the given query, with its stats. Returns null (after
+    // logging a warning) if the query fails to compile.
+    CachedStatement* _getCachedStatement(const string& query);
+
+    // As above, for callers that only want the raw statement.
+    sqlite3_stmt* _getPreparedStatement(const string& query);
+
+    // Binds `bindings` to the statement and steps it to completion, filling `result` with any returned rows. Returns
+    // the sqlite3 result code of the final step. The statement is reset and its bindings cleared before returning, so
+    // it's immediately re-usable.
+    int _stepPrepared(sqlite3_stmt* stmt, const vector<string>& bindings, SQResult& result);
+
+    // Cache of compiled statements for this handle, keyed by SQL text. Statements are tied to the underlying sqlite3
+    // handle, which is only ever used by one thread at a time, so this needs no locking. Finalized in the destructor.
+    map<string, CachedStatement> _preparedStatements;
+
     // Constructs a UNION query from a list of 'query parts' over each of our journal tables.
     // Fore each table, queryParts will be joined with that table's name as a separator. I.e., if you have a tables
     // named 'journal', 'journal00, and 'journal01', and queryParts of {"SELECT * FROM", "WHERE id > 1"}, we'll create
@@ -418,6 +652,27 @@ class SQLite {
     uint64_t _timeoutLimit = 0;
     uint64_t _timeoutStart;
     uint64_t _timeoutError;
+
+    // Adaptive progress-handler cadence. The handler enforces command timeouts *and* lets checkpoints interrupt
+    // transactions, so it's never uninstalled; what varies is how many VM opcodes run between checks. Long-budget
+    // commands get the sparse default (one check per ~0.1s of opcode work, so the check cost is noise); commands
+    // close to their deadline get a period derived from the remaining budget, down to the minimum, which bounds
+    // timeout overshoot to well under a millisecond instead of tens of them. The opcodes-per-microsecond constant
+    // comes from the same measurement the old fixed period was based on (~10M opcodes/second).
+    static const int PROGRESS_PERIOD_DEFAULT = 1'000'000;
+    static const int PROGRESS_PERIOD_MIN = 5'000;
+    static const uint64_t PROGRESS_OPCODES_PER_US = 10;
+
+    // The period currently installed, so re-installation (a sqlite3 call) only happens when the target changes.
+    int _progressHandlerPeriod = PROGRESS_PERIOD_DEFAULT;
+
+    // Installs `opcodes` as the progress-handler period if it isn't already.
+    void _setProgressHandlerPeriod(int opcodes);
+
+    // The period the remaining time budget calls for: roughly 20 checks across what's left, clamped to
+    // [PROGRESS_PERIOD_MIN, PROGRESS_PERIOD_DEFAULT]. Re-evaluated at statement boundaries (not from inside the
+    // progress callback, which isn't allowed to reconfigure the connection that invoked it).
+    int _budgetedProgressPeriod() const;
     bool _abandonForCheckpoint = false;
     bool _enableCheckpointInterrupt = true;
 
@@ -438,10 +693,35 @@ class SQLite {
 
     bool _noopUpdateMode = false;
 
+    // When set, write attempts throw write_attempted_error instead of executing. See setWriteProbeMode.
+    bool _writeProbeMode = false;
+
     // A map of queries to their cached results. This is populated only with deterministic queries, and is reset on any
     // write, rollback, or commit.
     map<string, SQResult> _queryCache;
 
+    // An in-memory snapshot of sqlite_master, loaded once the first time a schema check asks, so that
+    // upgradeDatabase's pile of verifyTable/verifyIndex/addColumn calls across every plugin costs one introspection
+    // query instead of one each (leader standup time is write unavailability during failover). Invalidated whenever a
+    // write bumps schema_version, and dropped at the start of each transaction so a rollback or another handle's DDL
+    // can't leave it stale.
+    void _loadSchemaSnapshot();
+    bool _schemaSnapshotLoaded = false;
+    map<string, string> _schemaSnapshotTables;               // table name -> stored CREATE sql
+    map<string, pair<string, string>> _schemaSnapshotIndexes; // index name -> (table name, stored CREATE sql)
+
+    // The tables written by the current transaction, collected by the authorizer. See getWrittenTables().
+    set<string> _writtenTables;
+
+    // The tables read by the query currently executing in read(), collected by the authorizer when the
+    // cross-transaction cache is active, so read() can tag publishable results for invalidation.
+    set<string> _queryReadTables;
+    bool _captureQueryReadTables = false;
+
+    // Every table read while trackReadTables() is enabled, accumulated across queries. See getReadTables().
+    set<string> _readTables;
+    bool _trackReadTables = false;
+
     // Number of queries that have been attempted in this transaction (for metrics only).
     int64_t _queryCount = 0;
 
@@ -455,6 +735,10 @@ class SQLite {
     bool _isDeterministicQuery = false;
 
     bool _pageLoggingEnabled;
+
+    // The begin-concurrent page report captured in `prepare` for the current transaction (empty unless page logging
+    // is enabled).
+    string _lastWrittenPages;
     static atomic<int64_t> _transactionAttemptCount;
     static mutex _pageLogMutex;
     int64_t _currentTransactionAttemptCount = -1;
@@ -464,6 +748,10 @@ class SQLite {
     const string _synchronous;
     int64_t _mmapSizeGB;
 
+    // True if this handle was opened with SQLITE_OPEN_READONLY. Read-only handles begin plain snapshot transactions
+    // instead of BEGIN CONCURRENT, and can never touch the commit lock or the journal.
+    const bool _readOnly;
+
     // This is a bit of a weird construct. We lock this in the destructor for an SQLite object because we spawn a
     // separate thread to do checkpoints, and that thread needs this object to exist until it finishes, so we lock
     // until that thread completes. This can go away when we no longer have dedicated checkpoint threads.
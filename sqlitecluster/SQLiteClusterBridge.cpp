@@ -0,0 +1,305 @@
+#include <libstuff/libstuff.h>
+#include "SQLiteClusterBridge.h"
+#include "SQLite.h"
+#include "SQLiteNode.h"
+#include "../BedrockServer.h"
+
+SQLiteClusterBridge::SQLiteClusterBridge(BedrockServer& server, SQLitePool& dbPool, const string& name,
+                                         const string& bridgeFrom, const string& version)
+  : _server(server),
+    _dbPool(dbPool),
+    _name(name),
+    _bridgeFrom(bridgeFrom),
+    _version(version),
+    _thread(&SQLiteClusterBridge::_bridgeThreadMain, this)
+{ }
+
+SQLiteClusterBridge::~SQLiteClusterBridge() {
+    _shouldExit.store(true);
+    _thread.join();
+    if (_socket) {
+        closeSocket(_socket);
+        _socket = nullptr;
+    }
+}
+
+STable SQLiteClusterBridge::status() const {
+    STable result;
+    result["upstream"] = _bridgeFrom;
+    result["connected"] = _connected.load() ? "true" : "false";
+    uint64_t applied = _appliedPrimaryCommit.load();
+    uint64_t upstream = _primaryCommitCount.load();
+    result["appliedPrimaryCommit"] = to_string(applied);
+    result["primaryCommitCount"] = to_string(upstream);
+    result["lagCommits"] = to_string(upstream > applied ? upstream - applied : 0);
+    uint64_t lastApply = _lastApplyTime.load();
+    if (lastApply) {
+        result["lastApplyAgeSeconds"] = to_string((STimeNow() - lastApply) / STIME_US_PER_S);
+    }
+    return result;
+}
+
+void SQLiteClusterBridge::_bridgeThreadMain() {
+    SInitialize("clusterBridge");
+    SINFO("Cluster bridge starting, pulling the primary journal from '" << _bridgeFrom << "'.");
+
+    // One handle from the pool for the life of the thread, the same way replication workers hold theirs.
+    size_t dbIndex = _dbPool.getIndex();
+    SQLite& db = _dbPool.initializeIndex(dbIndex);
+
+    while (!_shouldExit) {
+        // Only the DR cluster's leader applies the primary's journal; a follower applying it independently would
+        // diverge from what its own leader replicates to it.
+        if (_server.getState() != SQLiteNode::LEADING) {
+            if (_socket) {
+                _disconnect("not leading");
+            }
+            usleep(100'000);
+            continue;
+        }
+
+        if (!_positionLoaded) {
+            _initPosition(db);
+        }
+
+        if (!_socket) {
+            uint64_t now = STimeNow();
+            if (now < _nextConnectTime) {
+                usleep(100'000);
+                continue;
+            }
+            if (!_connect()) {
+                _nextConnectTime = STimeNow() + STIME_US_PER_S + SRandom::fast64() % STIME_US_PER_S;
+                continue;
+            }
+        }
+
+        // Wait for activity on the socket, but check back at least every 100ms so leadership changes and shutdown
+        // are noticed promptly.
+        fd_map fdm;
+        prePoll(fdm);
+        S_poll(fdm, 100 * STIME_US_PER_MS);
+        postPoll(fdm);
+
+        switch (_socket->state.load()) {
+        case Socket::CONNECTING:
+            break;
+        case Socket::CONNECTED: {
+            SData message;
+            try {
+                // An outstanding SYNCHRONIZE that never gets answered means the upstream is wedged or the response
+                // was lost; reconnecting re-requests from our stored position, so nothing is skipped.
+                if (_syncInFlight && STimeNow() > _syncRequestTime + SYNC_RESPONSE_TIMEOUT) {
+                    STHROW("timed out waiting for SYNCHRONIZE_RESPONSE");
+                }
+                int messageSize = 0;
+                while ((messageSize = message.deserialize(_socket->recvBuffer))) {
+                    _socket->recvBuffer.consumeFront(messageSize);
+                    _handleMessage(db, message);
+                }
+            } catch (const SException& e) {
+                SWARN("Error from upstream '" << _bridgeFrom << "' (" << e.what() << "), reconnecting.");
+                _disconnect(e.what());
+                _nextConnectTime = STimeNow() + STIME_US_PER_S;
+            }
+            break;
+        }
+        case Socket::SHUTTINGDOWN:
+        case Socket::CLOSED:
+            SHMMM("Lost connection to upstream '" << _bridgeFrom << "', reconnecting.");
+            _disconnect("socket closed");
+            _nextConnectTime = STimeNow() + STIME_US_PER_S + SRandom::fast64() % STIME_US_PER_S;
+            break;
+        }
+    }
+
+    _dbPool.returnToPool(dbIndex);
+    SINFO("Cluster bridge exiting.");
+}
+
+bool SQLiteClusterBridge::_connect() {
+    SINFO("Connecting to upstream '" << _bridgeFrom << "'.");
+    _socket = openSocket(_bridgeFrom);
+    if (!_socket) {
+        SWARN("Couldn't open socket to upstream '" << _bridgeFrom << "'.");
+        return false;
+    }
+
+    // The STCPNode-level login associates this socket with our entry in the primary cluster's peer list.
+    SData nodeLogin("NODE_LOGIN");
+    nodeLogin["Name"] = _name;
+    _socket->send(nodeLogin.serialize());
+
+    // And the SQLiteNode-level one. We present as a permafollower stuck in SEARCHING: never a quorum participant,
+    // never a standup candidate, just a peer the upstream will serve SYNCHRONIZE to. We advertise none of the
+    // optional wire formats (binary frames, compression, templates), so everything arrives as plain text.
+    SData login("LOGIN");
+    login["Priority"] = "0";
+    login["State"] = SQLiteNode::stateName(SQLiteNode::SEARCHING);
+    login["Version"] = _version;
+    login["Permafollower"] = "true";
+    _sendToUpstream(login);
+    return true;
+}
+
+void SQLiteClusterBridge::_disconnect(const string& reason) {
+    SINFO("Disconnecting from upstream '" << _bridgeFrom << "' (" << reason << ").");
+    if (_socket) {
+        closeSocket(_socket);
+        _socket = nullptr;
+    }
+    _upstreamLoggedIn = false;
+    _syncInFlight = false;
+    _connected.store(false);
+}
+
+void SQLiteClusterBridge::_sendToUpstream(SData message) {
+    SASSERT(_socket);
+
+    // Every peer message carries the sender's committed position; ours is our position in the *primary* journal,
+    // which is what the upstream reads when deciding what a SYNCHRONIZE should serve us.
+    message["CommitCount"] = to_string(_appliedPrimaryCommit.load());
+    message["Hash"] = _primaryHash;
+    _socket->send(message.serialize());
+}
+
+void SQLiteClusterBridge::_handleMessage(SQLite& db, const SData& message) {
+    // Track the upstream node's committed position from whatever it sends; this is what lag is measured against.
+    if (message.isSet("CommitCount")) {
+        _primaryCommitCount.store(message.calcU64("CommitCount"));
+    }
+
+    if (SIEquals(message.methodLine, "PING")) {
+        SData pong("PONG");
+        pong["Timestamp"] = message["Timestamp"];
+        _sendToUpstream(pong);
+        return;
+    } else if (SIEquals(message.methodLine, "PONG")) {
+        return;
+    } else if (SIEquals(message.methodLine, "LOGIN")) {
+        SINFO("Upstream '" << _bridgeFrom << "' logged in at '" << message["State"] << "', commit #"
+              << message["CommitCount"] << ".");
+        _upstreamLoggedIn = true;
+        _connected.store(true);
+    } else if (SIEquals(message.methodLine, "SYNCHRONIZE_RESPONSE")) {
+        if (!_syncInFlight) {
+            STHROW("unexpected SYNCHRONIZE_RESPONSE");
+        }
+        _syncInFlight = false;
+        _applySynchronizeResponse(db, message);
+    } else if (SIEquals(message.methodLine, "RECONNECT")) {
+        STHROW("upstream requested reconnect");
+    }
+    // Anything else — STATE broadcasts, standup/transaction chatter for the cluster we're not really part of — only
+    // matters for the position headers consumed above.
+
+    _requestNextBatch();
+}
+
+void SQLiteClusterBridge::_requestNextBatch() {
+    if (_upstreamLoggedIn && !_syncInFlight && _primaryCommitCount.load() > _appliedPrimaryCommit.load()) {
+        _sendToUpstream(SData("SYNCHRONIZE"));
+        _syncInFlight = true;
+        _syncRequestTime = STimeNow();
+    }
+}
+
+void SQLiteClusterBridge::_applySynchronizeResponse(SQLite& db, const SData& message) {
+    if (!message.isSet("NumCommits")) {
+        STHROW("missing NumCommits");
+    }
+    int commitsRemaining = message.calc("NumCommits");
+    SData commit;
+    const char* content = message.content.c_str();
+    int messageSize = 0;
+    int remaining = (int)message.content.size();
+    while ((messageSize = commit.deserialize(content, remaining))) {
+        content += messageSize;
+        remaining -= messageSize;
+        if (!SIEquals(commit.methodLine, "COMMIT")) {
+            STHROW("expecting COMMIT");
+        }
+        if (commit.calcU64("CommitIndex") != _appliedPrimaryCommit.load() + 1) {
+            STHROW("primary commit index mismatch");
+        }
+        if (!commit.isSet("Hash")) {
+            STHROW("missing Hash");
+        }
+
+        // Re-execute the primary's transaction as a normal local commit, recording where it leaves us in the
+        // primary journal inside the same transaction so application is exactly-once across restarts. Repeats on
+        // checkpoint interruption and on conflict with a concurrent local writer.
+        while (true) {
+            try {
+                db.waitForCheckpoint();
+                if (!db.beginTransaction()) {
+                    STHROW("failed to begin transaction");
+                }
+                if (!db.writeUnmodified(commit.content)) {
+                    STHROW("failed to write transaction");
+                }
+                if (!db.write("UPDATE clusterBridgePosition SET primaryCommit = " + SQ(commit.calcU64("CommitIndex"))
+                              + ", primaryHash = " + SQ(commit["Hash"]) + ";")) {
+                    STHROW("failed to update bridge position");
+                }
+                if (!db.prepare()) {
+                    STHROW("failed to prepare transaction");
+                }
+            } catch (const SQLite::checkpoint_required_error& e) {
+                db.rollback();
+                SINFO("[checkpoint] Retrying bridge apply after checkpoint.");
+                continue;
+            } catch (const SException& e) {
+                db.rollback();
+                throw;
+            }
+            int errorCode = db.commit();
+            if (errorCode == SQLITE_BUSY_SNAPSHOT) {
+                SINFO("Bridge apply conflicted with a local write, retrying.");
+                db.rollback();
+                continue;
+            } else if (errorCode) {
+                STHROW("failed to commit bridge transaction");
+            }
+            break;
+        }
+
+        _appliedPrimaryCommit.store(commit.calcU64("CommitIndex"));
+        _primaryHash = commit["Hash"];
+        _lastApplyTime.store(STimeNow());
+        --commitsRemaining;
+    }
+    if (commitsRemaining) {
+        STHROW("commits remaining at end");
+    }
+    SINFO("Applied batch through primary commit #" << _appliedPrimaryCommit.load() << " (upstream at #"
+          << _primaryCommitCount.load() << ").");
+}
+
+void SQLiteClusterBridge::_initPosition(SQLite& db) {
+    bool created = false;
+    if (!db.beginTransaction()) {
+        STHROW("failed to begin transaction");
+    }
+    SASSERT(db.verifyTable("clusterBridgePosition",
+                           "CREATE TABLE clusterBridgePosition ( "
+                               "primaryCommit INTEGER NOT NULL, "
+                               "primaryHash TEXT NOT NULL )",
+                           created));
+    if (created) {
+        SASSERT(db.write("INSERT INTO clusterBridgePosition VALUES ( 0, '' );"));
+        SASSERT(db.prepare());
+        SASSERT(!db.commit());
+        SINFO("Created clusterBridgePosition, starting from primary commit 0.");
+    } else {
+        db.rollback();
+    }
+
+    SQResult result;
+    SASSERT(db.read("SELECT primaryCommit, primaryHash FROM clusterBridgePosition;", result));
+    SASSERT(result.size() == 1);
+    _appliedPrimaryCommit.store(SToUInt64(result[0][0]));
+    _primaryHash = result[0][1];
+    _positionLoaded = true;
+    SINFO("Bridge resuming from primary commit #" << _appliedPrimaryCommit.load() << " (" << _primaryHash << ").");
+}
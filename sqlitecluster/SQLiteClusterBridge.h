@@ -0,0 +1,97 @@
+#pragma once
+#include <libstuff/libstuff.h>
+#include "SQLitePool.h"
+class BedrockServer;
+class SQLite;
+
+// One-way asynchronous replication between clusters, for a warm disaster-recovery cluster in another region.
+//
+// The bridge runs inside the DR cluster's leader (started with -bridgeFrom). It connects to one node of the primary
+// cluster as an ordinary permafollower — the bridge's node name must appear in the primary cluster's -peerList with
+// `?Permafollower=true`, so the primary's existing login/SYNCHRONIZE machinery serves it without ever counting it
+// toward quorum — and pulls the primary's journal with repeated SYNCHRONIZE requests, exactly the way a
+// SYNCHRONIZING node catches up. Each received journal entry is re-executed against the DR leader's own database as
+// a normal local commit, which the DR cluster's sync node then replicates to DR followers like any other write. The
+// DR cluster therefore keeps its own journal, its own hash chain, and its own quorum; the primary cluster never
+// waits on it for anything.
+//
+// The bridge's position in the *primary* journal (commit index and hash) can't be derived from the DR database, so
+// it's recorded in a one-row `clusterBridgePosition` table, updated inside the same transaction that applies each
+// entry. That makes application exactly-once across restarts, and — because the position row replicates with
+// everything else — a promoted DR follower knows where its own bridge should resume. A brand-new DR cluster starts
+// from primary commit 1; to avoid replaying an old journal from the beginning, seed the DR database from a primary
+// backup and set the position row to the backup's commit/hash before starting the bridge.
+//
+// The bridge only runs while this node is LEADING (applying on a follower would diverge from the DR leader); it
+// disconnects when leadership is lost and reconnects when it's regained. Lag against the upstream node — whose
+// committed position arrives on the headers of every peer message — is reported in `Status` under `clusterBridge`.
+class SQLiteClusterBridge : public STCPManager {
+  public:
+    // `name` is our node name, which must match a permafollower entry in the primary cluster's peer list.
+    // `bridgeFrom` is the host:port of the primary-cluster node to pull from (a follower, typically, to keep load
+    // off the primary's leader).
+    SQLiteClusterBridge(BedrockServer& server, SQLitePool& dbPool, const string& name, const string& bridgeFrom,
+                        const string& version);
+    ~SQLiteClusterBridge();
+
+    // Current bridge state for `Status`: upstream, connection state, the upstream's commit count, our applied
+    // position, and the lag between them.
+    STable status() const;
+
+  private:
+    // The bridge thread: owns the upstream socket and a DB handle from the pool for its whole life, connects and
+    // logs in whenever we're LEADING, and applies whatever SYNCHRONIZE_RESPONSEs arrive.
+    void _bridgeThreadMain();
+
+    // Opens the upstream socket and sends NODE_LOGIN/LOGIN. Returns false (and schedules a retry) on failure.
+    bool _connect();
+    void _disconnect(const string& reason);
+
+    // Stamps `message` with our primary-journal position (the CommitCount/Hash headers every peer message carries,
+    // which is what the upstream serves SYNCHRONIZE from) and queues it on the socket.
+    void _sendToUpstream(SData message);
+
+    // Dispatches one message from the upstream. Throws SException to force a reconnect.
+    void _handleMessage(SQLite& db, const SData& message);
+
+    // Applies the COMMIT entries in a SYNCHRONIZE_RESPONSE to the DR database, one local transaction per entry,
+    // recording the new primary position in the same transaction. Throws SException on any discontinuity.
+    void _applySynchronizeResponse(SQLite& db, const SData& message);
+
+    // Creates the position table on first use and loads the stored position into _appliedPrimaryCommit/_primaryHash.
+    void _initPosition(SQLite& db);
+
+    // If we're logged in, idle, and the upstream has commits we haven't applied, request the next batch.
+    void _requestNextBatch();
+
+    BedrockServer& _server;
+    SQLitePool& _dbPool;
+    const string _name;
+    const string _bridgeFrom;
+    const string _version;
+
+    // All of the below (except the atomics) are bridge-thread-only.
+    Socket* _socket = nullptr;
+    bool _upstreamLoggedIn = false;
+    bool _syncInFlight = false;
+    uint64_t _syncRequestTime = 0;
+    uint64_t _nextConnectTime = 0;
+    bool _positionLoaded = false;
+
+    // Our position in the primary cluster's journal, and the upstream node's, both readable by `Status`.
+    atomic<uint64_t> _appliedPrimaryCommit = {0};
+    atomic<uint64_t> _primaryCommitCount = {0};
+    atomic<uint64_t> _lastApplyTime = {0};
+    atomic<bool> _connected = {false};
+
+    // The hash our _appliedPrimaryCommit was committed with upstream; sent with every message so the upstream can
+    // verify we share history before serving us more journal.
+    string _primaryHash;
+
+    // Give up on an outstanding SYNCHRONIZE (and the connection) after this long; matches the node's own
+    // synchronization receive timeout.
+    static const uint64_t SYNC_RESPONSE_TIMEOUT = 60 * STIME_US_PER_S;
+
+    thread _thread;
+    atomic<bool> _shouldExit = {false};
+};
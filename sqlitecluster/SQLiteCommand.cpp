@@ -12,16 +12,18 @@ SData SQLiteCommand::preprocessRequest(SData&& request) {
         string chars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
         string requestID;
         for (int i = 0; i < 6; i++) {
-            requestID += chars[SRandom::rand64() % chars.size()];
+            requestID += chars[SRandom::fast64() % chars.size()];
         }
         request["requestID"] = requestID;
     }
-    return request;
+    // Explicit move: in C++17, returning a named rvalue reference parameter copies.
+    return move(request);
 }
 
-SQLiteCommand::SQLiteCommand(SData&& _request) : 
+SQLiteCommand::SQLiteCommand(SData&& _request) :
     initiatingPeerID(0),
     initiatingClientID(0),
+    socketSequence(0),
     request(preprocessRequest(move(_request))),
     writeConsistency(SQLiteNode::ASYNC),
     complete(false),
@@ -51,6 +53,7 @@ SQLiteCommand::SQLiteCommand(SData&& _request) :
 SQLiteCommand::SQLiteCommand() :
     initiatingPeerID(0),
     initiatingClientID(0),
+    socketSequence(0),
     writeConsistency(SQLiteNode::ASYNC),
     complete(false),
     escalationTimeUS(0),
@@ -23,6 +23,13 @@ class SQLiteCommand {
     // can't respond to.
     int64_t initiatingClientID;
 
+    // If this command came from a direct client connection, this is its position in the stream of commands read from
+    // that connection, used to send responses back in the order the requests were received when clients pipeline.
+    // A value of zero means the response doesn't participate in ordering (commands that opted out with the
+    // `Idempotent` header, and commands from peers or internal sources). This is only meaningful on the node that
+    // owns the client socket; it is not serialized during escalation.
+    uint64_t socketSequence;
+
     // Each command is given a unique id that can be serialized and passed back and forth across nodes. Its id must be
     // uniquely identifiable for cases where, for instance, two peers escalate commands to the leader, and leader will
     // need to  respond to them.
@@ -37,6 +44,13 @@ class SQLiteCommand {
     // Final response
     SData response;
 
+    // The response in its final serialized form, already stamped with everything the client should see. On leader,
+    // this is filled in (for followers that advertised support) just before an escalated command's response is sent
+    // back, with fixed-width slots reserved for the values the follower fills in (see
+    // BedrockCommand::sealResponseForEscalation). On the follower, the received bytes land here and are forwarded to
+    // the client verbatim, instead of being reparsed into `response` and reserialized. Empty for every other command.
+    string sealedResponse;
+
     // Write consistency required when committing this command.
     SQLiteNode::ConsistencyLevel writeConsistency;
 
@@ -56,6 +70,14 @@ class SQLiteCommand {
     // Whether or not the command has been escalated.
     bool escalated;
 
+    // Speculative peek results, carried with an escalation. When a follower's peek concludes that a command needs
+    // `process`, it records the set of tables that peek read and the commit count of the snapshot it read them at,
+    // and they ride along on the ESCALATE message. When leader's own write history proves none of those tables
+    // changed after that commit, the conclusion still holds, and leader skips re-running `peek`. A commit count of
+    // zero means no speculation was attached.
+    set<string> speculativePeekTables;
+    uint64_t speculativePeekCommitCount = 0;
+
     // Construct that takes a request object.
     SQLiteCommand(SData&& _request);
 
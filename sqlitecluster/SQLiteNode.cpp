@@ -1,4 +1,5 @@
 #include <libstuff/libstuff.h>
+#include <libstuff/SMetrics.h>
 #include "SQLiteNode.h"
 #include "SQLiteServer.h"
 #include "SQLiteCommand.h"
@@ -60,7 +61,6 @@ const string SQLiteNode::consistencyLevelNames[] = {"ASYNC",
                                                     "ONE",
                                                     "QUORUM"};
 
-atomic<int64_t> SQLiteNode::_currentCommandThreadID(0);
 
 const vector<STCPNode::Peer*> SQLiteNode::initPeers(const string& peerListString) {
     vector<Peer*> peerList;
@@ -81,7 +81,7 @@ const vector<STCPNode::Peer*> SQLiteNode::initPeers(const string& peerListString
         Peer* peer = new Peer(name, host, params, peerList.size() + 1);
 
         // Wait up to 2s before trying the first time
-        peer->nextReconnect = STimeNow() + SRandom::rand64() % (STIME_US_PER_S * 2);
+        peer->nextReconnect = STimeNow() + SRandom::fast64() % (STIME_US_PER_S * 2);
         peerList.push_back(peer);
     }
     return peerList;
@@ -89,7 +89,8 @@ const vector<STCPNode::Peer*> SQLiteNode::initPeers(const string& peerListString
 
 SQLiteNode::SQLiteNode(SQLiteServer& server, SQLitePool& dbPool, const string& name,
                        const string& host, const string& peerList, int priority, uint64_t firstTimeout,
-                       const string& version, const bool useParallelReplication)
+                       const string& version, const bool useParallelReplication, int workerThreads,
+                       const string& subscribeTo)
     : STCPNode(name, host, initPeers(peerList), max(SQL_NODE_DEFAULT_RECV_TIMEOUT, SQL_NODE_SYNCHRONIZING_RECV_TIMEOUT)),
       _dbPool(dbPool),
       _db(_dbPool.getBase()),
@@ -99,6 +100,7 @@ SQLiteNode::SQLiteNode(SQLiteServer& server, SQLitePool& dbPool, const string& n
       _lastNetStatTime(chrono::steady_clock::now()),
       _handledCommitCount(0),
       _replicationThreadsShouldExit(false),
+      _replicationWorkersShouldExit(false),
       _replicationThreadCount(0),
       _useParallelReplication(useParallelReplication),
       _multiReplicationThreadSpawn("multi-replication"),
@@ -109,6 +111,16 @@ SQLiteNode::SQLiteNode(SQLiteServer& server, SQLitePool& dbPool, const string& n
 
     SASSERT(priority >= 0);
     _originalPriority = priority;
+
+    // Chained replication is only safe on a permafollower: a node with a real priority participates in quorum, and
+    // its approvals must be for transactions received directly from leader.
+    if (!subscribeTo.empty()) {
+        if (priority == 0) {
+            _subscribeTo = subscribeTo;
+        } else {
+            SWARN("-subscribeTo is only supported on a permafollower (priority 0), ignoring.");
+        }
+    }
     _priority = -1;
     _state = SEARCHING;
     _syncPeer = nullptr;
@@ -125,9 +137,29 @@ SQLiteNode::SQLiteNode(SQLiteServer& server, SQLitePool& dbPool, const string& n
     // Make sure we get notified when the DB needs to checkpoint.
     _dbPool.getBase().addCheckpointListener(_localCommitNotifier);
     _dbPool.getBase().addCheckpointListener(_leaderCommitNotifier);
+
+    // Spin up the persistent replication worker pool. These threads live for the life of the node, acquire a DB
+    // handle once each, and handle every replicated transaction between them, rather than spawning a new thread (and
+    // opening a fresh handle) per BEGIN_TRANSACTION.
+    if (_useParallelReplication) {
+        if (workerThreads <= 0) {
+            workerThreads = max(1u, thread::hardware_concurrency());
+        }
+        SINFO("Starting " << workerThreads << " replication worker threads.");
+        for (int threadNum = 0; threadNum < workerThreads; threadNum++) {
+            _replicationThreads.emplace_back(&SQLiteNode::_replicationWorkerLoop, this, threadNum);
+        }
+    }
 }
 
 SQLiteNode::~SQLiteNode() {
+    // Shut down the replication worker pool. The workers return their DB handles to the pool as they exit.
+    _replicationWorkersShouldExit = true;
+    _replicationQueueCV.notify_all();
+    for (auto& workerThread : _replicationThreads) {
+        workerThread.join();
+    }
+
     // Make sure it's a clean shutdown
     SASSERTWARN(_escalatedCommandMap.empty());
     SASSERTWARN(!commitInProgress());
@@ -137,14 +169,150 @@ SQLiteNode::~SQLiteNode() {
     _dbPool.getBase().removeCheckpointListener(_leaderCommitNotifier);
 }
 
-void SQLiteNode::replicate(SQLiteNode& node, Peer* peer, SData command, size_t sqlitePoolIndex) {
-    // Initialize each new thread with a new number.
-    SInitialize("replicate" + to_string(node._currentCommandThreadID.fetch_add(1)));
+void SQLiteNode::_replicationWorkerLoop(size_t threadNum) {
+    SInitialize("replicate" + to_string(threadNum));
 
-    // Allow the DB handle to be returned regardless of how this function exits.
-    SQLiteScopedHandle dbScope(node._dbPool, sqlitePoolIndex);
-    SQLite& db = dbScope.db();
+    // Acquire a DB handle once, and re-use it for every transaction this worker handles. It's returned to the pool
+    // when the worker exits at node shutdown.
+    SQLiteScopedHandle dbScope(_dbPool, _dbPool.getIndex(false));
+
+    while (true) {
+        pair<Peer*, SData> work;
+        list<SData> batch;
+        {
+            unique_lock<mutex> lock(_replicationQueueMutex);
+            while (_replicationQueue.empty() && !_replicationWorkersShouldExit) {
+                _replicationQueueCV.wait(lock);
+            }
+            if (_replicationQueue.empty()) {
+                // Only empty after the wait if we're shutting down.
+                return;
+            }
+            work = move(_replicationQueue.front());
+            _replicationQueue.pop_front();
+
+            // Catch-up batching: when the queue is deep, we're behind, and most of what's queued is already
+            // committed on leader, so there's no reason to pay a WAL sync per commit. Collect the longest run of
+            // queued BEGINs that's contiguous by NewCount with the one we just popped *and* whose commits leader
+            // has already confirmed (the COMMIT_TRANSACTION messages are handled inline at intake, so
+            // _leaderCommitNotifier already knows). Contiguity also guarantees no other worker holds anything in
+            // the middle of our run; a gap means another thread popped that transaction, and we stop there.
+            if (_replicationQueue.size() >= CATCH_UP_BATCH_MIN_QUEUE
+                && SIEquals(work.second.methodLine, "BEGIN_TRANSACTION")
+                && _leaderCommitNotifier.currentValue() >= work.second.calcU64("NewCount")) {
+                uint64_t nextCount = work.second.calcU64("NewCount") + 1;
+                while (batch.size() + 1 < CATCH_UP_BATCH_MAX && !_replicationQueue.empty()) {
+                    pair<Peer*, SData>& front = _replicationQueue.front();
+                    if (!SIEquals(front.second.methodLine, "BEGIN_TRANSACTION")
+                        || front.second.calcU64("NewCount") != nextCount
+                        || _leaderCommitNotifier.currentValue() < nextCount) {
+                        break;
+                    }
+                    batch.push_back(move(front.second));
+                    _replicationQueue.pop_front();
+                    nextCount++;
+                }
+            }
+        }
+        if (!batch.empty()) {
+            batch.push_front(move(work.second));
+            _replicateBatch(move(batch), dbScope.db());
+        } else {
+            replicate(*this, work.first, move(work.second), dbScope.db());
+        }
+    }
+}
 
+void SQLiteNode::_replicateBatch(list<SData>&& messages, SQLite& db) {
+    bool goSearchingOnExit = false;
+    {
+        // Every queued BEGIN bumped _replicationThreadCount at intake, and we're handling all of them here, so we
+        // have to decrement by the batch size however we exit.
+        struct BatchDecrement {
+            decltype(_replicationThreadCount)& counter;
+            int64_t count;
+            ~BatchDecrement() { counter -= count; }
+        } decrementer{_replicationThreadCount, (int64_t)messages.size()};
+
+        uint64_t firstCount = messages.front().calcU64("NewCount");
+        uint64_t lastCount = messages.back().calcU64("NewCount");
+        SINFO("[catch-up] Batching " << messages.size() << " replicated commits (" << firstCount << "-" << lastCount
+              << ") into one transaction.");
+
+        // The batch has to start exactly at the DB's next commit, so wait for everything before it, just like the
+        // non-batched path does.
+        while (true) {
+            SQLiteSequentialNotifier::RESULT result = _localCommitNotifier.waitFor(firstCount - 1);
+            if (result == SQLiteSequentialNotifier::RESULT::COMPLETED) {
+                break;
+            } else if (result == SQLiteSequentialNotifier::RESULT::CANCELED) {
+                SINFO("_localCommitNotifier.waitFor canceled early, returning.");
+                return;
+            } else if (result == SQLiteSequentialNotifier::RESULT::CHECKPOINT_REQUIRED) {
+                SINFO("Checkpoint required while waiting to start catch-up batch. Waiting for checkpoint.");
+                db.waitForCheckpoint();
+                continue;
+            } else {
+                SERROR("Got unhandled SQLiteSequentialNotifier::RESULT value, did someone update the enum without updating this block?");
+            }
+        }
+
+        // These transactions are all known-committed on leader, so there's no approval to send even for QUORUM ones:
+        // by the time leader sent the COMMIT we've already seen, it had its quorum without us.
+        vector<pair<string, string>> commits;
+        commits.reserve(messages.size());
+        for (SData& message : messages) {
+            commits.emplace_back(move(message.content), message["NewHash"]);
+        }
+        try {
+            if (_state != FOLLOWING) {
+                STHROW("not following");
+            }
+            while (true) {
+                try {
+                    db.waitForCheckpoint();
+                    if (!db.applyCatchUpBatch(commits)) {
+                        STHROW("failed to apply catch-up batch");
+                    }
+                    break;
+                } catch (const SQLite::checkpoint_required_error& e) {
+                    SINFO("[checkpoint] Retrying catch-up batch after checkpoint.");
+                }
+            }
+            _localCommitNotifier.notifyThrough(db.getCommitCount());
+        } catch (const SException& e) {
+            SALERT("Caught exception applying catch-up batch. Assuming this means we want to stop following. Exception: " << e.what());
+            goSearchingOnExit = true;
+        }
+    }
+    if (goSearchingOnExit) {
+        _changeState(SEARCHING);
+    }
+}
+
+// Pulls the page numbers out of a begin-concurrent page report (the `writtenPages` header on a replicated
+// transaction). We deliberately parse permissively - every run of digits in the report is treated as a page number.
+// Extra numbers can only cause false conflicts, which just serialize two transactions that would have run in
+// parallel; they can never let a real conflict through.
+static set<uint64_t> _parsePageNumbers(const string& report) {
+    set<uint64_t> pages;
+    size_t i = 0;
+    while (i < report.size()) {
+        if (isdigit(report[i])) {
+            uint64_t page = 0;
+            while (i < report.size() && isdigit(report[i])) {
+                page = page * 10 + (report[i] - '0');
+                i++;
+            }
+            pages.insert(page);
+        } else {
+            i++;
+        }
+    }
+    return pages;
+}
+
+void SQLiteNode::replicate(SQLiteNode& node, Peer* peer, SData command, SQLite& db) {
     bool goSearchingOnExit = false;
     {
         // Make sure when this thread exits we decrement our thread counter.
@@ -184,6 +352,59 @@ void SQLiteNode::replicate(SQLiteNode& node, Peer* peer, SData command, size_t s
                 }
             }
 
+            // If leader told us which pages this transaction writes, check whether any earlier in-flight transaction
+            // touches the same pages. If so, starting now would just get us a conflict at commit time, so wait for the
+            // latest conflicting transaction to commit first. Disjoint transactions start immediately, as before.
+            set<uint64_t> pages = _parsePageNumbers(command["writtenPages"]);
+            uint64_t conflictThrough = 0;
+            if (!quorum && !pages.empty()) {
+                lock_guard<mutex> lock(node._inFlightTransactionPagesMutex);
+                for (auto& inFlight : node._inFlightTransactionPages) {
+                    if (inFlight.first < newCount) {
+                        for (uint64_t page : pages) {
+                            if (inFlight.second.count(page)) {
+                                conflictThrough = max(conflictThrough, inFlight.first);
+                                break;
+                            }
+                        }
+                    }
+                }
+                node._inFlightTransactionPages.emplace(newCount, pages);
+            }
+
+            // Removes our page set from the in-flight map however we exit this block.
+            struct PageSetGuard {
+                SQLiteNode& node;
+                uint64_t id;
+                bool active;
+                ~PageSetGuard() {
+                    if (active) {
+                        lock_guard<mutex> lock(node._inFlightTransactionPagesMutex);
+                        node._inFlightTransactionPages.erase(id);
+                    }
+                }
+            } pageSetGuard = {node, newCount, !quorum && !pages.empty()};
+
+            if (conflictThrough) {
+                SINFO("Commit " << newCount << " conflicts on pages with in-flight commit " << conflictThrough
+                      << ", waiting for it to commit before beginning.");
+                while (true) {
+                    SQLiteSequentialNotifier::RESULT result = node._localCommitNotifier.waitFor(conflictThrough);
+                    if (result == SQLiteSequentialNotifier::RESULT::COMPLETED) {
+                        break;
+                    } else if (result == SQLiteSequentialNotifier::RESULT::CANCELED) {
+                        SINFO("_localCommitNotifier.waitFor canceled early, returning.");
+                        return;
+                    } else if (result == SQLiteSequentialNotifier::RESULT::CHECKPOINT_REQUIRED) {
+                        SINFO("Checkpoint required while waiting out a page conflict. Waiting for checkpoint.");
+                        db.waitForCheckpoint();
+                        continue;
+                    } else {
+                        SERROR("Got unhandled SQLiteSequentialNotifier::RESULT value, did someone update the enum without updating this block?");
+                    }
+                }
+            }
+
             try {
                 int result = -1;
                 int attemptCount = 1;
@@ -280,6 +501,14 @@ void SQLiteNode::startCommit(ConsistencyLevel consistency)
     }
 }
 
+// Effective send priority for a response to an escalated command. The ESCALATE handler stamped the follower's
+// effective priority into the rebuilt request's `priority` header, so this sees the command's real priority, not
+// just what the client sent. Commands without any priority default to 500 (BedrockCommand::PRIORITY_NORMAL);
+// reading the header keeps SQLiteNode ignorant of the BedrockCommand::Priority enum itself.
+static int _commandSendPriority(const SQLiteCommand& command) {
+    return command.request.isSet("priority") ? command.request.calc("priority") : 500;
+}
+
 void SQLiteNode::sendResponse(const SQLiteCommand& command)
 {
     Peer* peer = getPeerByID(command.initiatingPeerID);
@@ -287,9 +516,15 @@ void SQLiteNode::sendResponse(const SQLiteCommand& command)
     // If it was a peer message, we don't need to wrap it in an escalation response.
     SData escalate("ESCALATE_RESPONSE");
     escalate["ID"] = command.id;
-    escalate.content = command.response.serialize();
+    if (command.sealedResponse.size()) {
+        // The server pre-serialized the response for this follower; it'll forward these bytes to the client verbatim.
+        escalate["Sealed"] = "true";
+        escalate.content = command.sealedResponse;
+    } else {
+        escalate.content = command.response.serialize();
+    }
     SINFO("Sending ESCALATE_RESPONSE to " << peer->name << " for " << command.id << ".");
-    _sendToPeer(peer, escalate);
+    _sendEscalationToPeer(peer, move(escalate), _commandSendPriority(command));
 }
 
 void SQLiteNode::beginShutdown(uint64_t usToWait) {
@@ -328,15 +563,15 @@ bool SQLiteNode::shutdownComplete() {
     // Next, see if we're timing out the graceful shutdown and killing non-gracefully
     if (_gracefulShutdownTimeout.ringing()) {
         SWARN("Graceful shutdown timed out, killing non gracefully.");
-        auto lock = _escalatedCommandMap.scopedLock();
-        if (_escalatedCommandMap.size()) {
-            SWARN("Abandoned " << _escalatedCommandMap.size() << " escalated commands.");
-            for (auto& commandPair : _escalatedCommandMap) {
-                commandPair.second->response.methodLine = "500 Abandoned";
-                commandPair.second->complete = true;
-                _server.acceptCommand(move(commandPair.second), false);
+        auto abandoned = _escalatedCommandMap.takeAll();
+        if (abandoned.size()) {
+            SWARN("Abandoned " << abandoned.size() << " escalated commands.");
+            for (auto& command : abandoned) {
+                command->response.methodLine = "500 Abandoned";
+                command->complete = true;
+                _server.acceptCommand(move(command), false);
             }
-            _escalatedCommandMap.clear();
+            _escalatedCommandCounts.clear();
         }
         _changeState(SEARCHING);
         return true;
@@ -351,16 +586,13 @@ bool SQLiteNode::shutdownComplete() {
 
         // If we end up with anything left in the escalated command map when we're trying to shut down, let's log it,
         // so we can try and diagnose what's happening.
-        auto lock = _escalatedCommandMap.scopedLock();
-        for (auto& cmd : _escalatedCommandMap) {
-            string name = cmd.first;
-            unique_ptr<SQLiteCommand>& command = cmd.second;
+        _escalatedCommandMap.forEach([&](uint64_t id, const unique_ptr<SQLiteCommand>& command) {
             int64_t created = command->request.calcU64("commandExecuteTime");
             int64_t elapsed = STimeNow() - created;
             double elapsedSeconds = (double)elapsed / STIME_US_PER_S;
-            SINFO("Escalated command remaining at shutdown(" << name << "): " << command->request.methodLine
+            SINFO("Escalated command remaining at shutdown(" << command->id << "): " << command->request.methodLine
                   << ". Created: " << command->request["commandExecuteTime"] << " (" << elapsedSeconds << "s ago)");
-        }
+        });
         return false;
     }
 
@@ -402,37 +634,45 @@ void SQLiteNode::_sendOutstandingTransactions(const set<uint64_t>& commitOnlyIDs
         string& query = get<0>(i.second);
         string& hash = get<1>(i.second);
         uint64_t dbCountAtStart = get<2>(i.second);
-        string idHeader = to_string(id);
+        string& writtenPages = get<3>(i.second);
+
+        // The transaction ID lands in three headers; format it once.
+        char countBuffer[SFAST_U64_BUFFER_SIZE];
+        string newCount(countBuffer, SFastFormatU64(countBuffer, id));
+        string idHeader = newCount;
 
         // If this is marked as "commitOnly", we won't send the BEGIN for it.
         if (commitOnlyIDs.find(id) == commitOnlyIDs.end()) {
             // Any commit where we can send a BEGIN and a COMMIT without waiting for acknowledgement is ASYNC.
             idHeader = "ASYNC_" + idHeader;
             SData transaction("BEGIN_TRANSACTION");
-            transaction["NewCount"] = to_string(id);
+            transaction["NewCount"] = newCount;
             transaction["NewHash"] = hash;
             transaction["leaderSendTime"] = sendTime;
-            transaction["dbCountAtStart"] = to_string(dbCountAtStart);
+            transaction["dbCountAtStart"].assign(countBuffer, SFastFormatU64(countBuffer, dbCountAtStart));
             transaction["ID"] = idHeader;
+            if (!writtenPages.empty()) {
+                transaction["writtenPages"] = writtenPages;
+            }
             transaction.content = query;
             for (auto peer : peerList) {
                 // Clear the response flag from the last transaction
                 peer->transactionResponse = Peer::Response::NONE;
             }
-            _sendToAllPeers(transaction, true); // subscribed only
+            _sendTransactionToPeers(transaction);
         } else {
             SINFO("Sending COMMIT for QUORUM transaction " << idHeader << " to followers");
         }
         SData commit("COMMIT_TRANSACTION");
         commit["ID"] = idHeader;
-        commit["NewCount"] = to_string(id);
+        commit["NewCount"] = newCount;
         commit["NewHash"] = hash;
         _sendToAllPeers(commit, true); // subscribed only
         _lastSentTransactionID = id;
     }
 }
 
-void SQLiteNode::escalateCommand(unique_ptr<SQLiteCommand>&& command, bool forget) {
+void SQLiteNode::escalateCommand(unique_ptr<SQLiteCommand>&& command, bool forget, int priority) {
     AutoTimerTime time(_escalateTimer);
     lock_guard<mutex> leadPeerLock(_leadPeerMutex);
     // Send this to the leader
@@ -445,7 +685,10 @@ void SQLiteNode::escalateCommand(unique_ptr<SQLiteCommand>&& command, bool forge
         return;
     }
 
-    SASSERTEQUALS(_leadPeer.load()->state, LEADING);
+    // A chained replica's lead peer is its upstream follower rather than the leader itself; the upstream forwards
+    // our escalations on to leader (see the ESCALATE handler in _onMESSAGE).
+    SASSERT(_leadPeer.load()->state == LEADING ||
+            (!_subscribeTo.empty() && _leadPeer.load()->state == FOLLOWING));
     uint64_t elapsed = STimeNow() - command->request.calcU64("commandExecuteTime");
     SINFO("Escalating '" << command->request.methodLine << "' (" << command->id << ") to leader '" << _leadPeer.load()->name
           << "' after " << elapsed / 1000 << " ms");
@@ -453,8 +696,16 @@ void SQLiteNode::escalateCommand(unique_ptr<SQLiteCommand>&& command, bool forge
     // Create a command to send to our leader.
     SData escalate("ESCALATE");
     escalate["ID"] = command->id;
+    escalate["priority"] = to_string(priority);
     escalate.content = command->request.serialize();
 
+    // If our peek recorded speculative results (see SQLiteCommand), send them along so leader can skip its own peek
+    // when it can prove they're still valid.
+    if (command->speculativePeekCommitCount) {
+        escalate["SpeculativePeekCommitCount"] = to_string(command->speculativePeekCommitCount);
+        escalate["SpeculativePeekTables"] = SComposeList(command->speculativePeekTables);
+    }
+
     // Marking the command as escalated, even if we are going to forget it, because the command's destructor may need
     // this info.
     command->escalated = true;
@@ -464,22 +715,74 @@ void SQLiteNode::escalateCommand(unique_ptr<SQLiteCommand>&& command, bool forge
         SINFO("Firing and forgetting command '" << command->request.methodLine << "' to leader.");
     } else {
         command->escalationTimeUS = STimeNow();
-        _escalatedCommandMap.emplace(command->id, move(command));
+        _escalatedCommandCounts.increment(command->request.methodLine);
+        uint64_t deadline = _escalationDeadline(*command);
+        uint64_t id = _escalationID(command->id);
+        _escalatedCommandMap.emplace(id, move(command));
+        lock_guard<mutex> lock(_escalationTimeoutsMutex);
+        _escalationTimeouts.insert(deadline, id);
     }
 
     // And send to leader.
-    _sendToPeer(_leadPeer, escalate);
+    _sendEscalationToPeer(_leadPeer, move(escalate), priority);
+}
+
+uint64_t SQLiteNode::_escalationID(const string& commandID) {
+    // IDs look like `nodeName#N`; the counter after the '#' is the unique part.
+    size_t hash = commandID.rfind('#');
+    const char* start = commandID.c_str() + (hash == string::npos ? 0 : hash + 1);
+    return SFastParseU64(start, commandID.c_str() + commandID.size());
+}
+
+uint64_t SQLiteNode::_escalationDeadline(const SQLiteCommand& command) {
+    // The command's own `timeout` header in milliseconds when present, the same 290-second default BedrockCommand
+    // uses otherwise, from its scheduled execution time (stamped on every request at creation).
+    uint64_t timeoutMS = command.request.isSet("timeout") ? command.request.calcU64("timeout") : 290'000;
+    uint64_t start = command.request.isSet("commandExecuteTime") ? command.request.calcU64("commandExecuteTime")
+                                                                 : command.escalationTimeUS;
+    return start + timeoutMS * 1000;
+}
+
+void SQLiteNode::_failTimedOutEscalations() {
+    uint64_t now = STimeNow();
+    uint64_t deadline = 0;
+    uint64_t id = 0;
+    while (true) {
+        {
+            lock_guard<mutex> lock(_escalationTimeoutsMutex);
+            if (!_escalationTimeouts.popExpired(now, deadline, id)) {
+                return;
+            }
+        }
+
+        // If the command's already been resolved (response, abort, or a state change re-queued it), this is a stale
+        // wheel entry for a finished command; drop it.
+        unique_ptr<SQLiteCommand> command = _escalatedCommandMap.take(id);
+        if (!command) {
+            continue;
+        }
+        SHMMM("Escalated command '" << command->id << "' (" << command->request.methodLine << ") timed out after "
+              << (now - command->escalationTimeUS) / 1000 << "ms waiting for leader, failing with 555 Timeout.");
+        _escalatedCommandCounts.decrement(command->request.methodLine);
+        command->response.clear();
+        command->response.methodLine = "555 Timeout";
+        command->complete = true;
+        _server.acceptCommand(move(command), false);
+    }
 }
 
 list<string> SQLiteNode::getEscalatedCommandRequestMethodLines() {
     list<string> returnList;
-    auto lock = _escalatedCommandMap.scopedLock();
-    for (auto& commandPair : _escalatedCommandMap) {
-        returnList.push_back(commandPair.second->request.methodLine);
-    }
+    _escalatedCommandMap.forEach([&](uint64_t id, const unique_ptr<SQLiteCommand>& command) {
+        returnList.push_back(command->request.methodLine);
+    });
     return returnList;
 }
 
+map<string, int64_t> SQLiteNode::getEscalatedCommandCounts() {
+    return _escalatedCommandCounts.snapshot();
+}
+
 // --------------------------------------------------------------------------
 // State Machine
 // --------------------------------------------------------------------------
@@ -534,6 +837,16 @@ bool SQLiteNode::update() {
         SINFO(logMsg);
     }
 
+    // If we've been serving a snapshot but the requester has gone quiet, release the checkpoint hold so the
+    // checkpointer can reclaim the WAL. The file can change from here on, so we bump the epoch: any resumed transfer
+    // will see the mismatch and restart from offset zero.
+    if (_snapshotServing && STimeNow() > _snapshotServeTimeout) {
+        SINFO("Snapshot requester went quiet, releasing checkpoint hold.");
+        _db.releaseCheckpoints();
+        _snapshotServing = false;
+        _snapshotEpoch++;
+    }
+
     // Process the database state machine
     switch (_state) {
     /// - SEARCHING: Wait for a period and try to connect to all known
@@ -630,7 +943,13 @@ bool SQLiteNode::update() {
         SASSERTWARN(!_syncPeer);
         _updateSyncPeer();
         if (_syncPeer) {
-            _sendToPeer(_syncPeer, SData("SYNCHRONIZE"));
+            if (!_db.getCommitCount()) {
+                // We're completely empty: rather than replaying the peer's entire journal commit-by-commit, pull the
+                // raw database file in bulk and then SYNCHRONIZE only the tail. See _handleSnapshotResponse.
+                _requestSnapshot(_syncPeer);
+            } else {
+                _sendToPeer(_syncPeer, SData("SYNCHRONIZE"));
+            }
         } else {
             SWARN("Updated to NULL _syncPeer when about to send SYNCHRONIZE. Going to WAITING.");
             _changeState(WAITING);
@@ -653,6 +972,11 @@ bool SQLiteNode::update() {
         if (STimeNow() > _stateTimeout) {
             // Give up on synchronization; reconnect that peer and go searching
             SHMMM("Timed out while waiting for SYNCHRONIZE_RESPONSE, searching.");
+            if (_snapshotInProgress) {
+                // Keep the partial snapshot file on disk: if we come back to the same peer before it releases its
+                // checkpoint hold, we can resume from where we left off rather than starting over.
+                _snapshotInProgress = false;
+            }
             _reconnectPeer(_syncPeer);
             _syncPeer = nullptr;
             _changeState(SEARCHING);
@@ -752,6 +1076,32 @@ bool SQLiteNode::update() {
 
         SDEBUG("Dumping evaluated cluster state: numLoggedInFullPeers=" << numLoggedInFullPeers << " freshestPeer=" << freshestPeer->name << " highestPriorityPeer=" << highestPriorityPeer->name << " currentLeader=" << (currentLeader ? currentLeader->name : "none"));
 
+        // If we're a chained read replica, prefer subscribing to our named upstream peer rather than leader, so
+        // replication to a fleet of replicas fans out through followers instead of multiplying leader's send load.
+        // The upstream must itself be FOLLOWING (or be leader, in which case this is just a normal subscription);
+        // otherwise we fall through and subscribe to leader directly like anyone else.
+        if (!_subscribeTo.empty()) {
+            Peer* upstream = nullptr;
+            for (auto peer : peerList) {
+                if (peer->name == _subscribeTo) {
+                    upstream = peer;
+                    break;
+                }
+            }
+            if (upstream && upstream->loggedIn && (upstream->state == FOLLOWING || upstream->state == LEADING)) {
+                SINFO("Chained replica subscribing to upstream '" << upstream->name << "' (" << stateName(upstream->state) << ")");
+                lock_guard<mutex> leadPeerLock(_leadPeerMutex);
+                _leadPeer = upstream;
+                _leaderVersion = _leadPeer.load()->version;
+                _sendToPeer(upstream, SData("SUBSCRIBE"));
+                _changeState(SUBSCRIBING);
+                return true; // Re-update
+            }
+            if (currentLeader) {
+                SHMMM("Upstream '" << _subscribeTo << "' unavailable for chained subscription, falling back to leader.");
+            }
+        }
+
         // If there is already a leader that is higher priority than us,
         // subscribe -- even if we're not in sync with it.  (It'll bring
         // us back up to speed while subscribing.)
@@ -846,8 +1196,13 @@ bool SQLiteNode::update() {
         // If everyone's responded with approval and we form a majority, then finish standup.
         bool majorityConnected = numLoggedInFullPeers * 2 >= numFullPeers;
         if (allResponded && majorityConnected) {
-            // Complete standup
-            SINFO("All peers approved standup, going LEADING.");
+            // Complete standup. Before we accept any LEADING traffic, give the server a chance to warm its caches:
+            // after a failover the new leader's page cache is cold, and the first wave of commands otherwise pays
+            // for every page fault itself.
+            SINFO("All peers approved standup, pre-warming before LEADING.");
+            uint64_t warmStartTime = STimeNow();
+            _server.onPrepareToLead(_db);
+            SINFO("Pre-warm took " << (STimeNow() - warmStartTime) / 1000 << "ms, going LEADING.");
             _changeState(LEADING);
             _leaderVersion = _version;
             return true; // Re-update
@@ -918,8 +1273,14 @@ bool SQLiteNode::update() {
                     // It's a full peer -- is it subscribed, and if so, how did it respond?
                     ++numFullPeers;
                     if (peer->subscribed) {
-                        // Subscribed, did it respond?
-                        numFullFollowers++;
+                        // Subscribed, did it respond? A peer whose send link has been congested for a while can't
+                        // receive the transaction or answer it in time, so stop counting it as a follower we wait
+                        // for: its approval still counts if it arrives, and the majority is still measured against
+                        // all full peers, so this never weakens quorum - it just stops one bad link from stalling
+                        // every quorum commit.
+                        if (!peer->congestedFor(5 * STIME_US_PER_S)) {
+                            numFullFollowers++;
+                        }
                         if (peer->transactionResponse == Peer::Response::NONE) {
                             continue;
                         }
@@ -1079,6 +1440,9 @@ bool SQLiteNode::update() {
             } else {
                 transaction.set("ID", _lastSentTransactionID + 1);
             }
+            if (!_db.getLastWrittenPages().empty()) {
+                transaction.set("writtenPages", _db.getLastWrittenPages());
+            }
             transaction.content = _db.getUncommittedQuery();
 
             for (auto peer : peerList) {
@@ -1088,8 +1452,8 @@ bool SQLiteNode::update() {
 
             // And send it to everyone who's subscribed.
             uint64_t beforeSend = STimeNow();
-            _sendToAllPeers(transaction, true);
-            SINFO("[performance] SQLite::_sendToAllPeers in SQLiteNode took " << ((STimeNow() - beforeSend)/1000) << "ms.");
+            _sendTransactionToPeers(transaction);
+            SINFO("[performance] SQLite::_sendTransactionToPeers in SQLiteNode took " << ((STimeNow() - beforeSend)/1000) << "ms.");
 
             // We return `true` here to immediately re-update and thus commit this transaction immediately if it was
             // asynchronous.
@@ -1123,7 +1487,7 @@ bool SQLiteNode::update() {
                             standDownReason = "Found WAITING peer (" + peer->name +
                                               ") with more data than us (we have " + SToStr(_db.getCommitCount()) +
                                               "/" + _db.getCommittedHash() + ", it has " + to_string(peer->commitCount) +
-                                              "/" + peer->hash.load() + ") while LEADING, STANDINGDOWN";
+                                              "/" + peer->getHash() + ") while LEADING, STANDINGDOWN";
                         }
                     }
                 }
@@ -1190,6 +1554,11 @@ bool SQLiteNode::update() {
     ///
     case FOLLOWING:
         SASSERTWARN(!_syncPeer);
+
+        // Fail anything we escalated whose own timeout has passed rather than waiting on leader forever: a lost
+        // response would otherwise hold the command (and block graceful shutdown) until the client disconnects.
+        _failTimedOutEscalations();
+
         // If graceful shutdown requested, stop following once there is
         // nothing blocking shutdown.  We stop listening for new commands
         // immediately upon TERM.)
@@ -1204,18 +1573,19 @@ bool SQLiteNode::update() {
         // leader. We don't want to go searching before that, because we won't know when leader is done sending its
         // final transactions.
         SASSERT(_leadPeer);
-        if (_leadPeer.load()->state != LEADING && _leadPeer.load()->state != STANDINGDOWN) {
+        // A chained replica's lead peer is its upstream follower, so FOLLOWING is a healthy upstream state for it.
+        // If the upstream stops following (it'll broadcast SEARCHING when its own leader goes away), we fall through
+        // here and re-SEARCH like anyone whose leader stepped down, then resubscribe once it's healthy again.
+        if (_leadPeer.load()->state != LEADING && _leadPeer.load()->state != STANDINGDOWN &&
+            !(!_subscribeTo.empty() && _leadPeer.load()->name == _subscribeTo && _leadPeer.load()->state == FOLLOWING)) {
             // Leader stepping down
             SHMMM("Leader stepping down, re-queueing commands.");
 
             // If there were escalated commands, give them back to the server to retry.
-            {
-                auto lock = _escalatedCommandMap.scopedLock();
-                for (auto& cmd : _escalatedCommandMap) {
-                    _server.acceptCommand(move(cmd.second), false);
-                }
-                _escalatedCommandMap.clear();
+            for (auto& command : _escalatedCommandMap.takeAll()) {
+                _server.acceptCommand(move(command), false);
             }
+            _escalatedCommandCounts.clear();
 
             // Are we in the middle of a commit? This should only happen if we received a `BEGIN_TRANSACTION` without a
             // corresponding `COMMIT` or `ROLLBACK`, this isn't supposed to happen.
@@ -1278,6 +1648,16 @@ void SQLiteNode::_onMESSAGE(Peer* peer, const SData& message) {
             STHROW("you're *not* supposed to be a 0-priority permafollower");
         }
 
+        // If the peer can parse binary frames, everything we send it from here on can use the cheaper format.
+        peer->useBinaryMessages = message.test("BinaryMessages");
+
+        // And if it can decompress zstd, large message bodies (journal synchronization, escalations) go out
+        // compressed from here on.
+        peer->useZstdCompression = message.test("ZstdCompression");
+        peer->useTemplateEncoding = message.test("TemplateEncoding");
+        peer->useBulkChannel = message.test("BulkChannel");
+        peer->useSealedResponses = message.test("SealedResponses");
+
         // It's an error to have to peers configured with the same priority, except 0 and -1
         SASSERT(_priority == -1 || _priority == 0 || message.calc("Priority") != _priority);
         PINFO("Peer logged in at '" << message["State"] << "', priority #" << message["Priority"] << " commit #"
@@ -1518,9 +1898,13 @@ void SQLiteNode::_onMESSAGE(Peer* peer, const SData& message) {
             // Otherwise we handle them immediately, as the server doesn't deliver commands to workers until we've
             // stood up.
             SData response("SYNCHRONIZE_RESPONSE");
-            _queueSynchronize(this, peer, _db, response, false);
+            _queueSynchronize(this, peer, _db, response, false, message);
             _sendToPeer(peer, response);
         }
+    } else if (SIEquals(message.methodLine, "SNAPSHOT_REQUEST")) {
+        _handleSnapshotRequest(peer, message);
+    } else if (SIEquals(message.methodLine, "SNAPSHOT_RESPONSE") || SIEquals(message.methodLine, "SNAPSHOT_DENIED")) {
+        _handleSnapshotResponse(peer, message);
     } else if (SIEquals(message.methodLine, "SYNCHRONIZE_RESPONSE")) {
         // SYNCHRONIZE_RESPONSE: Sent in response to a SYNCHRONIZE request. Contains a payload of zero or more COMMIT
         // messages, all of which are immediately committed to the local database.
@@ -1535,6 +1919,19 @@ void SQLiteNode::_onMESSAGE(Peer* peer, const SData& message) {
         }
         PINFO("Beginning synchronization");
         try {
+            // If this response tells us where it will leave us, and our sync peer has more beyond that, pipeline:
+            // request the next batch *before* applying this one, so the peer reads its journal and transmits the next
+            // range while we're busy applying this one. This keeps sync throughput bounded by bandwidth rather than
+            // round-trip latency.
+            bool requestedNext = false;
+            if (message.isSet("UpThroughCommit") && _syncPeer->commitCount > message.calcU64("UpThroughCommit")) {
+                SData next("SYNCHRONIZE");
+                next["synchronizeCommitCount"] = message["UpThroughCommit"];
+                next["synchronizeHash"] = message["UpThroughHash"];
+                _sendToPeer(_syncPeer, next);
+                requestedNext = true;
+            }
+
             // Received this synchronization response; are we done?
             _recvSynchronize(peer, message);
             uint64_t peerCommitCount = _syncPeer->commitCount;
@@ -1556,16 +1953,21 @@ void SQLiteNode::_onMESSAGE(Peer* peer, const SData& message) {
                 SINFO("Synchronization underway, at commitCount #"
                       << _db.getCommitCount() << " (" << _db.getCommittedHash() << "), "
                       << peerCommitCount - _db.getCommitCount() << " to go.");
-                _updateSyncPeer();
-                if (_syncPeer) {
-                    _sendToPeer(_syncPeer, SData("SYNCHRONIZE"));
-                } else {
-                    SWARN("No usable _syncPeer but syncing not finished. Going to SEARCHING.");
-                    _changeState(SEARCHING);
+
+                // If we already pipelined the next request above, the next batch is on its way: don't switch sync
+                // peers (the in-flight response would be orphaned) and don't request again.
+                if (!requestedNext) {
+                    _updateSyncPeer();
+                    if (_syncPeer) {
+                        _sendToPeer(_syncPeer, SData("SYNCHRONIZE"));
+                    } else {
+                        SWARN("No usable _syncPeer but syncing not finished. Going to SEARCHING.");
+                        _changeState(SEARCHING);
+                    }
                 }
 
                 // Also, extend our timeout so long as we're still alive
-                _stateTimeout = STimeNow() + SQL_NODE_SYNCHRONIZING_RECV_TIMEOUT + SRandom::rand64() % STIME_US_PER_S * 5;
+                _stateTimeout = STimeNow() + SQL_NODE_SYNCHRONIZING_RECV_TIMEOUT + SRandom::fast64() % STIME_US_PER_S * 5;
             }
         } catch (const SException& e) {
             // Transaction failed
@@ -1581,7 +1983,13 @@ void SQLiteNode::_onMESSAGE(Peer* peer, const SData& message) {
         // occurred after it completed SYNCHRONIZING but before this SUBSCRIBE was received). Tag this peer as
         // "subscribed" for use in the LEADING and STANDINGDOWN update loops. Finally, if there is an outstanding
         // distributed transaction being processed, send it to this new follower.
-        if (_state != LEADING) {
+        // Leader accepts any subscriber. A follower accepts only chained read replicas (permafollowers that named us
+        // with -subscribeTo); they can't vote, so all we owe them is a relay of the replication stream. Note that
+        // under parallel replication there's a window where a transaction already handed to our worker pool is
+        // neither in the synchronize snapshot below nor relayed (it arrived before this SUBSCRIBE): the replica
+        // detects the resulting commit count mismatch, re-SEARCHes, and resubscribes, so the gap self-heals the same
+        // way any botched subscription does.
+        if (_state != LEADING && !(_state == FOLLOWING && peer->permaFollower)) {
             STHROW("not leading");
         }
         PINFO("Received SUBSCRIBE, accepting new follower");
@@ -1591,8 +1999,9 @@ void SQLiteNode::_onMESSAGE(Peer* peer, const SData& message) {
         SASSERTWARN(!peer->subscribed);
         peer->subscribed = true;
 
-        // New follower; are we in the midst of a transaction?
-        if (_commitState == CommitState::COMMITTING) {
+        // New follower; are we in the midst of a transaction? (Leader only: a follower relays transactions as they
+        // arrive and has no distributed commit of its own to invite anyone into.)
+        if (_state == LEADING && _commitState == CommitState::COMMITTING) {
             // Invite the new peer to participate in the transaction
             SINFO("Inviting peer into distributed transaction already underway (" << _db.getUncommittedHash() << ")");
 
@@ -1607,7 +2016,7 @@ void SQLiteNode::_onMESSAGE(Peer* peer, const SData& message) {
             transaction.set("dbCountAtStart", to_string(_db.getDBCountAtStart()));
             transaction.set("ID", _lastSentTransactionID + 1);
             transaction.content = _db.getUncommittedQuery();
-            _sendToPeer(peer, transaction);
+            _sendTransactionToPeers(transaction, peer);
         }
     } else if (SIEquals(message.methodLine, "SUBSCRIPTION_APPROVED")) {
         // SUBSCRIPTION_APPROVED: Sent by a follower's new leader to complete the subscription process. Includes zero or
@@ -1633,24 +2042,50 @@ void SQLiteNode::_onMESSAGE(Peer* peer, const SData& message) {
             throw e;
         }
     } else if (SIEquals(message.methodLine, "BEGIN_TRANSACTION") || SIEquals(message.methodLine, "COMMIT_TRANSACTION") || SIEquals(message.methodLine, "ROLLBACK_TRANSACTION")) {
+        // If the leader template-encoded this transaction's query, expand it back to the full SQL text up front, so
+        // nothing downstream (the journal, the commit hash, the replication workers) ever sees anything but plain
+        // queries. This has to happen here rather than in a worker, as registrations must apply in arrival order.
+        SData expanded;
+        if (SIEquals(message.methodLine, "BEGIN_TRANSACTION") && message.isSet("QueryTemplateID")) {
+            expanded = message;
+            _decodeTemplateQuery(peer, expanded);
+        }
+        const SData& transactionMessage = expanded.empty() ? message : expanded;
+
+        // Chained replication: relay the stream to any read replicas subscribed to us, in arrival order, before we
+        // apply it ourselves. We relay the *expanded* form - template shape registrations were applied to our
+        // connection from leader, and downstream connections have never seen them.
+        _relayToSubscribers(transactionMessage);
         if (_useParallelReplication) {
             if (_replicationThreadsShouldExit) {
                 SINFO("Discarding replication message, stopping FOLLOWING");
-            } else {
-                auto threadID = _replicationThreadCount.fetch_add(1);
-                SINFO("Spawning concurrent replicate thread (blocks until DB handle available): " << threadID);
+            } else if (SIEquals(message.methodLine, "BEGIN_TRANSACTION")) {
+                // Dispatch to the persistent worker pool. We count the message as an active replication immediately,
+                // so that _changeState will wait for it even if no worker has picked it up yet.
+                auto transactionNum = _replicationThreadCount.fetch_add(1);
+                SINFO("Queuing BEGIN_TRANSACTION for replication worker pool: " << transactionNum);
                 AutoTimerTime time(_multiReplicationThreadSpawn);
-                thread(replicate, ref(*this), peer, message, _dbPool.getIndex(false)).detach();
-                SINFO("Done spawning concurrent replicate thread: " << threadID);
+                {
+                    lock_guard<mutex> lock(_replicationQueueMutex);
+                    _replicationQueue.emplace_back(peer, transactionMessage);
+                }
+                _replicationQueueCV.notify_one();
+            } else if (SIEquals(message.methodLine, "COMMIT_TRANSACTION")) {
+                // Trivial, handle inline. This also guarantees that a commit notification can never be stuck in the
+                // worker queue behind the BEGIN_TRANSACTION that's blocked waiting for it.
+                _leaderCommitNotifier.notifyThrough(message.calcU64("CommitCount"));
+            } else if (SIEquals(message.methodLine, "ROLLBACK_TRANSACTION")) {
+                // A distributed rollback means we want to stop following and reconnect.
+                _changeState(SEARCHING);
             }
         } else {
             AutoTimerTime time(_legacyReplication);
             if (SIEquals(message.methodLine, "BEGIN_TRANSACTION")) {
-                handleSerialBeginTransaction(peer, message);
+                handleSerialBeginTransaction(peer, transactionMessage);
             } else if (SIEquals(message.methodLine, "COMMIT_TRANSACTION")) {
-                handleSerialCommitTransaction(peer, message);
+                handleSerialCommitTransaction(peer, transactionMessage);
             } else if (SIEquals(message.methodLine, "ROLLBACK_TRANSACTION")) {
-                handleSerialRollbackTransaction(peer, message);
+                handleSerialRollbackTransaction(peer, transactionMessage);
             }
         }
     } else if (SIEquals(message.methodLine, "APPROVE_TRANSACTION") || SIEquals(message.methodLine, "DENY_TRANSACTION")) {
@@ -1703,13 +2138,53 @@ void SQLiteNode::_onMESSAGE(Peer* peer, const SData& message) {
                   << message.calc("NewCount") << " (" << message["NewHash"] << ", " << message["ID"] << ") but '"
                   << e.what() << "', ignoring.");
         }
+    } else if (SIEquals(message.methodLine, "ESCALATE_BATCH")) {
+        // ESCALATE_BATCH: Several ESCALATE or ESCALATE_RESPONSE messages to this peer, coalesced into one peer
+        // message by _sendEscalationToPeer. Split the content back into individual messages and handle each as if it
+        // had arrived on its own. The sub-messages don't carry their own CommitCount/Hash (sharing the batch's copy
+        // is most of the savings), so attach it before recursing.
+        size_t offset = 0;
+        uint64_t count = 0;
+        while (offset < message.content.size()) {
+            SData subMessage;
+            int consumed = SParseHTTP(message.content.c_str() + offset, message.content.size() - offset,
+                                      subMessage.methodLine, subMessage.nameValueMap, subMessage.content);
+            if (consumed <= 0) {
+                STHROW("malformed escalation batch");
+            }
+            subMessage["CommitCount"] = message["CommitCount"];
+            subMessage["Hash"] = message["Hash"];
+            _onMESSAGE(peer, subMessage);
+            offset += consumed;
+            count++;
+        }
+        if (count != message.calcU64("Count")) {
+            STHROW("escalation batch count mismatch");
+        }
     } else if (SIEquals(message.methodLine, "ESCALATE")) {
         // ESCALATE: Sent to the leader by a follower. Is processed like a normal command, except when complete an
         // ESCALATE_RESPONSE is sent to the follower that initiated the escalation.
         if (!message.isSet("ID")) {
             STHROW("missing ID");
         }
-        if (_state != LEADING) {
+        if (_state == FOLLOWING && peer->subscribed) {
+            // A chained read replica escalating through us: forward the message to leader verbatim and remember
+            // which peer the response goes back to. If we're chained ourselves, our lead peer is just the next hop
+            // up and forwards again - the records unwind the chain hop by hop on the way back.
+            lock_guard<mutex> leadPeerLock(_leadPeerMutex);
+            Peer* leadPeer = _leadPeer.load();
+            if (leadPeer && (leadPeer->state == LEADING || (!_subscribeTo.empty() && leadPeer->state == FOLLOWING))) {
+                PINFO("Forwarding ESCALATE for '" << message["ID"] << "' from chained replica to '" << leadPeer->name << "'.");
+                _forwardedEscalations[message["ID"]] = peer->id;
+                _sendEscalationToPeer(leadPeer, message, message.isSet("priority") ? message.calc("priority") : 0);
+            } else {
+                // No healthy upstream to forward to; abort so the replica re-queues and retries.
+                SData aborted("ESCALATE_ABORTED");
+                aborted["ID"] = message["ID"];
+                aborted["Reason"] = "no upstream";
+                _sendToPeer(peer, aborted);
+            }
+        } else if (_state != LEADING) {
             // Reject escalation because we're no longer leading
             if (_state != STANDINGDOWN) {
                 // Don't warn if we're standing down, this is expected.
@@ -1733,10 +2208,27 @@ void SQLiteNode::_onMESSAGE(Peer* peer, const SData& message) {
             }
             PINFO("Received ESCALATE command for '" << message["ID"] << "' (" << request.methodLine << ")");
 
+            // If the follower told us the command's effective priority, stamp it into the request so the command we
+            // rebuild gets queued at the priority the follower's did, even when that priority was assigned by a
+            // plugin rather than the original client. Followers that don't send this just fall back to whatever
+            // `priority` header the client supplied.
+            if (message.isSet("priority")) {
+                request["priority"] = message["priority"];
+            }
+
             // Create a new Command and send to the server.
             auto command = make_unique<SQLiteCommand>(move(request));
             command->initiatingPeerID = peer->id;
             command->id = message["ID"];
+
+            // Carry over any speculative peek results the follower attached (see SQLiteCommand); the server checks
+            // their validity against our own write history when the command is peeked.
+            if (message.isSet("SpeculativePeekCommitCount")) {
+                command->speculativePeekCommitCount = message.calcU64("SpeculativePeekCommitCount");
+                for (const string& table : SParseList(message["SpeculativePeekTables"])) {
+                    command->speculativePeekTables.insert(table);
+                }
+            }
             _server.acceptCommand(move(command), true);
         }
     } else if (SIEquals(message.methodLine, "ESCALATE_CANCEL")) {
@@ -1747,7 +2239,16 @@ void SQLiteNode::_onMESSAGE(Peer* peer, const SData& message) {
         if (!message.isSet("ID")) {
             STHROW("missing ID");
         }
-        if (_state != LEADING) {
+        if (_state == FOLLOWING && peer->subscribed) {
+            // A chained replica cancelling an escalation we forwarded: drop our forwarding record and pass the
+            // cancellation up toward leader.
+            _forwardedEscalations.erase(message["ID"]);
+            lock_guard<mutex> leadPeerLock(_leadPeerMutex);
+            if (_leadPeer) {
+                PINFO("Forwarding ESCALATE_CANCEL for '" << message["ID"] << "' from chained replica.");
+                _sendEscalationToPeer(_leadPeer, message, 0);
+            }
+        } else if (_state != LEADING) {
             // Reject escalation because we're no longer leading
             PWARN("Received ESCALATE_CANCEL but not LEADING, ignoring.");
         } else {
@@ -1778,27 +2279,60 @@ void SQLiteNode::_onMESSAGE(Peer* peer, const SData& message) {
         if (!message.isSet("ID")) {
             STHROW("missing ID");
         }
+        // If this answers an escalation we forwarded on behalf of a chained replica, relay it downstream verbatim -
+        // nothing here is ours to parse. If the replica has since unsubscribed or disconnected, it will have
+        // re-queued the command itself when it saw us (or its upstream) change state, so dropping is safe.
+        auto forwardedIt = _forwardedEscalations.find(message["ID"]);
+        if (forwardedIt != _forwardedEscalations.end()) {
+            Peer* downstream = getPeerByID(forwardedIt->second);
+            _forwardedEscalations.erase(forwardedIt);
+            if (downstream && downstream->subscribed) {
+                PINFO("Relaying ESCALATE_RESPONSE for '" << message["ID"] << "' to chained replica '" << downstream->name << "'.");
+                _sendEscalationToPeer(downstream, message, 0);
+            } else {
+                SHMMM("Chained replica for forwarded escalation '" << message["ID"] << "' is gone, dropping response.");
+            }
+            return;
+        }
+        // Sealed responses stay as bytes and go to the client verbatim; only the legacy format needs a parse here.
+        bool sealed = message.test("Sealed");
         SData response;
-        if (!response.deserialize(message.content)) {
+        if (sealed) {
+            if (message.content.empty()) {
+                STHROW("missing content");
+            }
+        } else if (!response.deserialize(message.content)) {
             STHROW("malformed content");
         }
 
         // Go find the escalated command
         PINFO("Received ESCALATE_RESPONSE for '" << message["ID"] << "'");
-        auto lock = _escalatedCommandMap.scopedLock();
-        auto commandIt = _escalatedCommandMap.find(message["ID"]);
-        if (commandIt != _escalatedCommandMap.end()) {
+        uint64_t commandID = _escalationID(message["ID"]);
+        unique_ptr<SQLiteCommand> command = _escalatedCommandMap.take(commandID);
+        if (command && command->id != message["ID"]) {
+            // The integer key matched but the full ID doesn't, so this response is for some other node's command,
+            // which we'd never have stored. Put ours back and treat the response as unknown.
+            _escalatedCommandMap.emplace(commandID, move(command));
+        }
+        if (command) {
             // Process the escalated command response
-            unique_ptr<SQLiteCommand>& command = commandIt->second;
             if (command->escalationTimeUS) {
                 command->escalationTimeUS = STimeNow() - command->escalationTimeUS;
+                static atomic<uint64_t>& escalationUS = SMetrics::counter("escalation.rttUS");
+                static atomic<uint64_t>& escalationCount = SMetrics::counter("escalation.rttCount");
+                escalationUS += command->escalationTimeUS;
+                escalationCount++;
                 SINFO("Total escalation time for command " << command->request.methodLine << " was "
                       << command->escalationTimeUS/1000 << "ms.");
             }
-            command->response = response;
+            _escalatedCommandCounts.decrement(command->request.methodLine);
+            if (sealed) {
+                command->sealedResponse = message.content;
+            } else {
+                command->response = response;
+            }
             command->complete = true;
             _server.acceptCommand(move(command), false);
-            _escalatedCommandMap.erase(commandIt);
         } else {
             SHMMM("Received ESCALATE_RESPONSE for unknown command ID '" << message["ID"] << "', ignoring. ");
         }
@@ -1812,16 +2346,33 @@ void SQLiteNode::_onMESSAGE(Peer* peer, const SData& message) {
         }
         PINFO("Received ESCALATE_ABORTED for '" << message["ID"] << "' (" << message["Reason"] << ")");
 
+        // Relay aborts for forwarded chained-replica escalations downstream, same as ESCALATE_RESPONSE above.
+        auto forwardedAbortIt = _forwardedEscalations.find(message["ID"]);
+        if (forwardedAbortIt != _forwardedEscalations.end()) {
+            Peer* downstream = getPeerByID(forwardedAbortIt->second);
+            _forwardedEscalations.erase(forwardedAbortIt);
+            if (downstream && downstream->subscribed) {
+                PINFO("Relaying ESCALATE_ABORTED for '" << message["ID"] << "' to chained replica '" << downstream->name << "'.");
+                _sendEscalationToPeer(downstream, message, 0);
+            } else {
+                SHMMM("Chained replica for forwarded escalation '" << message["ID"] << "' is gone, dropping abort.");
+            }
+            return;
+        }
+
         // Look for that command
-        auto lock = _escalatedCommandMap.scopedLock();
-        auto commandIt = _escalatedCommandMap.find(message["ID"]);
-        if (commandIt != _escalatedCommandMap.end()) {
+        uint64_t commandID = _escalationID(message["ID"]);
+        unique_ptr<SQLiteCommand> command = _escalatedCommandMap.take(commandID);
+        if (command && command->id != message["ID"]) {
+            // Same integer key, different command ID (see ESCALATE_RESPONSE above). Not ours to re-queue.
+            _escalatedCommandMap.emplace(commandID, move(command));
+        }
+        if (command) {
             // Re-queue this
-            unique_ptr<SQLiteCommand>& command = commandIt->second;
             PINFO("Re-queueing command '" << message["ID"] << "' (" << command->request.methodLine << ") ("
                   << command->id << ")");
+            _escalatedCommandCounts.decrement(command->request.methodLine);
             _server.acceptCommand(move(command), false);
-            _escalatedCommandMap.erase(commandIt);
         } else
             SWARN("Received ESCALATE_ABORTED for unescalated command " << message["ID"] << ", ignoring.");
     } else if (SIEquals(message.methodLine, "CRASH_COMMAND") || SIEquals(message.methodLine, "BROADCAST_COMMAND")) {
@@ -1844,6 +2395,15 @@ void SQLiteNode::_onConnect(Peer* peer) {
     login["State"] = stateName(_state);
     login["Version"] = _version;
     login["Permafollower"] = _originalPriority ? "false" : "true";
+
+    // Advertise that we can receive binary-framed messages. Until the peer advertises the same, we keep sending text.
+    login["BinaryMessages"] = "true";
+
+    // Same deal for zstd-compressed message bodies: we can always decompress, but only compress for peers that ask.
+    login["ZstdCompression"] = "true";
+    login["TemplateEncoding"] = "true";
+    login["BulkChannel"] = "true";
+    login["SealedResponses"] = "true";
     _sendToPeer(peer, login);
 }
 
@@ -1892,13 +2452,10 @@ void SQLiteNode::_onDisconnect(Peer* peer) {
 
         // If there were escalated commands, give them back to the server to retry, unless it looks like they were in
         // progress when the leader died, in which case we say they completed with a 500 Error.
-        {
-            auto lock = _escalatedCommandMap.scopedLock();
-            for (auto& cmd : _escalatedCommandMap) {
-                _server.acceptCommand(move(cmd.second), false);
-            }
-            _escalatedCommandMap.clear();
+        for (auto& command : _escalatedCommandMap.takeAll()) {
+            _server.acceptCommand(move(command), false);
         }
+        _escalatedCommandCounts.clear();
         _changeState(SEARCHING);
     }
 
@@ -1950,6 +2507,10 @@ void SQLiteNode::_onDisconnect(Peer* peer) {
 }
 
 void SQLiteNode::_sendToPeer(Peer* peer, const SData& message) {
+    _sendToPeer(peer, SData(message));
+}
+
+void SQLiteNode::_sendToPeer(Peer* peer, SData&& message) {
     SASSERT(peer);
     SASSERT(!message.empty());
 
@@ -1959,10 +2520,36 @@ void SQLiteNode::_sendToPeer(Peer* peer, const SData& message) {
         return;
     }
     // Piggyback on whatever we're sending to add the CommitCount/Hash
+    message["CommitCount"] = to_string(_db.getCommitCount());
+    message["Hash"] = _db.getCommittedHash();
+
+    // Elephant payloads take the sidecar connection so they can't stall every message queued behind them.
+    if (peer->useBulkChannel && message.content.size() >= BULK_MESSAGE_MIN_SIZE) {
+        _sendBulkToPeer(peer, move(message));
+        return;
+    }
+    peer->socket->send(peer->serializeMessage(message));
+}
+
+void SQLiteNode::_relayToSubscribers(const SData& message) {
+    // The common case is no chained replicas at all, so check before paying for the message copy.
+    bool anySubscribed = false;
+    for (auto peer : peerList) {
+        if (peer->subscribed) {
+            anySubscribed = true;
+            break;
+        }
+    }
+    if (!anySubscribed) {
+        return;
+    }
+
+    // Strip the upstream's CommitCount/Hash so _sendToAllPeers re-stamps the message with our own committed state,
+    // which is what downstream peers track our freshness by.
     SData messageCopy = message;
-    messageCopy["CommitCount"] = to_string(_db.getCommitCount());
-    messageCopy["Hash"] = _db.getCommittedHash();
-    peer->socket->send(messageCopy.serialize());
+    messageCopy.erase("CommitCount");
+    messageCopy.erase("Hash");
+    _sendToAllPeers(messageCopy, true); // subscribed only
 }
 
 void SQLiteNode::_sendToAllPeers(const SData& message, bool subscribedOnly) {
@@ -1974,18 +2561,296 @@ void SQLiteNode::_sendToAllPeers(const SData& message, bool subscribedOnly) {
     if (!messageCopy.isSet("Hash")) {
         messageCopy["Hash"] = _db.getCommittedHash();
     }
-    const string& serializedMessage = messageCopy.serialize();
+    // We serialize each format at most once, lazily, since peers can differ in which one they accept and whether
+    // they take compressed bodies; large broadcast content (replicated transactions, most notably) is compressed
+    // once and shared across every peer that negotiated it, not re-compressed per peer. Each serialization is held
+    // in a shared buffer that every destination socket references rather than copies (see
+    // Socket::send(shared_ptr)), so a six-peer broadcast stores the bytes once, not six times.
+    shared_ptr<const string> serializedText;
+    shared_ptr<const string> serializedBinary;
+    shared_ptr<const string> compressedText;
+    shared_ptr<const string> compressedBinary;
+    bool compressible = messageCopy.content.size() >= Peer::COMPRESSION_MIN_SIZE;
 
     // Loop across all connected peers and send the message
     for (auto peer : peerList) {
         // Send either to everybody, or just subscribed peers.
         if (peer->socket && (!subscribedOnly || peer->subscribed)) {
-            // Send it now, without waiting for the outer event loop
-            peer->socket->send(serializedMessage);
+            // Send it now, without waiting for the outer event loop. Elephant payloads take the sidecar connection
+            // so they can't stall every message queued behind them.
+            if (peer->useBulkChannel && messageCopy.content.size() >= BULK_MESSAGE_MIN_SIZE) {
+                _sendBulkToPeer(peer, messageCopy);
+            } else if (peer->useZstdCompression && compressible) {
+                shared_ptr<const string>& serialized = peer->useBinaryMessages ? compressedBinary : compressedText;
+                if (!serialized) {
+                    SData compressedCopy = messageCopy;
+                    serialized = make_shared<const string>(peer->serializeMessage(compressedCopy));
+                }
+                peer->socket->send(serialized);
+            } else if (peer->useBinaryMessages) {
+                if (!serializedBinary) {
+                    serializedBinary = make_shared<const string>(messageCopy.serializeBinary());
+                }
+                peer->socket->send(serializedBinary);
+            } else {
+                if (!serializedText) {
+                    serializedText = make_shared<const string>(messageCopy.serialize());
+                }
+                peer->socket->send(serializedText);
+            }
         }
     }
 }
 
+bool SQLiteNode::_templateEncodeQuery(const string& query, string& shape, vector<string>& values) {
+    shape.clear();
+    values.clear();
+    shape.reserve(query.size());
+    size_t i = 0;
+    size_t size = query.size();
+    while (i < size) {
+        char c = query[i];
+        if (c == '\'' || ((c == 'x' || c == 'X') && i + 1 < size && query[i + 1] == '\'')) {
+            // String or blob literal; a doubled quote is the escape for a quote.
+            size_t start = i;
+            i += (c == '\'') ? 1 : 2;
+            while (i < size) {
+                if (query[i] == '\'') {
+                    if (i + 1 < size && query[i + 1] == '\'') {
+                        i += 2;
+                        continue;
+                    }
+                    i++;
+                    break;
+                }
+                i++;
+            }
+            values.push_back(query.substr(start, i - start));
+            shape += '?';
+        } else if (isdigit((unsigned char)c) || (c == '.' && i + 1 < size && isdigit((unsigned char)query[i + 1]))) {
+            // Numeric literal. Identifiers with digits in them can't get here; they're consumed whole below.
+            size_t start = i;
+            while (i < size && (isalnum((unsigned char)query[i]) || query[i] == '.')) {
+                i++;
+            }
+            values.push_back(query.substr(start, i - start));
+            shape += '?';
+        } else if (isalpha((unsigned char)c) || c == '_') {
+            // Keyword or identifier; copy the whole token so its trailing digits aren't mistaken for numbers.
+            while (i < size && (isalnum((unsigned char)query[i]) || query[i] == '_' || query[i] == '$')) {
+                shape += query[i++];
+            }
+        } else if (c == '"' || c == '`') {
+            // Quoted identifier; a doubled quote is the escape.
+            char quote = query[i];
+            shape += query[i++];
+            while (i < size) {
+                if (query[i] == quote) {
+                    shape += query[i++];
+                    if (i < size && query[i] == quote) {
+                        shape += query[i++];
+                        continue;
+                    }
+                    break;
+                }
+                shape += query[i++];
+            }
+        } else if (c == '[') {
+            // Bracket-quoted identifier.
+            while (i < size && query[i] != ']') {
+                shape += query[i++];
+            }
+            if (i < size) {
+                shape += query[i++];
+            }
+        } else if (c == '-' && i + 1 < size && query[i + 1] == '-') {
+            // Line comment.
+            while (i < size && query[i] != '\n') {
+                shape += query[i++];
+            }
+        } else if (c == '/' && i + 1 < size && query[i + 1] == '*') {
+            // Block comment.
+            shape += query[i++];
+            shape += query[i++];
+            while (i < size && !(query[i] == '*' && i + 1 < size && query[i + 1] == '/')) {
+                shape += query[i++];
+            }
+        } else {
+            shape += query[i++];
+        }
+    }
+    return !values.empty();
+}
+
+string SQLiteNode::_templateDecodeQuery(const string& shape, const vector<string>& values) {
+    size_t reserveSize = shape.size();
+    for (const auto& value : values) {
+        reserveSize += value.size();
+    }
+    string query;
+    query.reserve(reserveSize);
+    size_t valueIndex = 0;
+    for (char c : shape) {
+        if (c == '?') {
+            if (valueIndex >= values.size()) {
+                STHROW("not enough template values");
+            }
+            query += values[valueIndex++];
+        } else {
+            query += c;
+        }
+    }
+    if (valueIndex != values.size()) {
+        STHROW("unused template values");
+    }
+    return query;
+}
+
+void SQLiteNode::_sendTransactionToPeers(const SData& transaction, Peer* onlyPeer) {
+    string shape;
+    vector<string> values;
+    bool encoded = _templateEncodeQuery(transaction.content, shape, values);
+    if (encoded) {
+        // The commit hash is computed over the exact query text, so never trust the tokenizer blindly: an encoding
+        // only ships if splicing the values back into the shape reproduces the original byte-for-byte.
+        try {
+            encoded = _templateDecodeQuery(shape, values) == transaction.content;
+        } catch (const SException& e) {
+            encoded = false;
+        }
+    }
+    uint64_t templateID = 0;
+    if (encoded) {
+        auto it = _queryTemplateIDs.find(shape);
+        if (it != _queryTemplateIDs.end()) {
+            templateID = it->second;
+        } else if (_queryTemplateIDs.size() < MAX_QUERY_TEMPLATES) {
+            templateID = ++_lastQueryTemplateID;
+            _queryTemplateIDs.emplace(shape, templateID);
+        } else {
+            // The registry's full; this shape just ships as plain text.
+            encoded = false;
+        }
+    }
+    if (!encoded) {
+        if (onlyPeer) {
+            _sendToPeer(onlyPeer, transaction);
+        } else {
+            _sendToAllPeers(transaction, true); // subscribed only
+        }
+        return;
+    }
+
+    // The same transaction in up to three forms: the original full text for peers that didn't negotiate template
+    // encoding, id plus values for peers that already know this shape, and shape plus id plus values for a peer's
+    // first sight of it. Content items are length-prefixed since values can contain anything, newlines included.
+    string valueItems;
+    for (const auto& value : values) {
+        valueItems += to_string(value.size()) + ":" + value + ";";
+    }
+    SData encodedMessage = transaction;
+    encodedMessage["QueryTemplateID"] = to_string(templateID);
+    encodedMessage.content = valueItems;
+    SData registerMessage = encodedMessage;
+    registerMessage["QueryTemplateRegister"] = "true";
+    registerMessage.content = to_string(shape.size()) + ":" + shape + ";" + valueItems;
+
+    for (auto peer : peerList) {
+        if (onlyPeer ? (peer != onlyPeer) : !peer->subscribed) {
+            continue;
+        }
+        if (!peer->useTemplateEncoding) {
+            _sendToPeer(peer, transaction);
+        } else if (peer->sentQueryTemplates.insert(templateID).second) {
+            _sendToPeer(peer, registerMessage);
+        } else {
+            _sendToPeer(peer, encodedMessage);
+        }
+    }
+}
+
+void SQLiteNode::_decodeTemplateQuery(Peer* peer, SData& message) {
+    // Parse the length-prefixed items out of the content.
+    list<string> items;
+    size_t offset = 0;
+    while (offset < message.content.size()) {
+        size_t colon = message.content.find(':', offset);
+        if (colon == string::npos) {
+            STHROW("malformed template values");
+        }
+        uint64_t length = SToUInt64(message.content.substr(offset, colon - offset));
+        if (colon + 1 + length >= message.content.size() || message.content[colon + 1 + length] != ';') {
+            STHROW("malformed template values");
+        }
+        items.push_back(message.content.substr(colon + 1, length));
+        offset = colon + length + 2;
+    }
+
+    // On a registration, the first item is the shape itself; remember it for the rest of this connection. The leader
+    // tracks per-connection which shapes it's registered with us, so both ends forget together on reconnect.
+    uint64_t templateID = message.calcU64("QueryTemplateID");
+    if (message.test("QueryTemplateRegister")) {
+        if (items.empty()) {
+            STHROW("missing template");
+        }
+        peer->receivedQueryTemplates[templateID] = move(items.front());
+        items.pop_front();
+    }
+    auto templateIt = peer->receivedQueryTemplates.find(templateID);
+    if (templateIt == peer->receivedQueryTemplates.end()) {
+        STHROW("unknown query template");
+    }
+    vector<string> values(make_move_iterator(items.begin()), make_move_iterator(items.end()));
+    message.content = _templateDecodeQuery(templateIt->second, values);
+    message.nameValueMap.erase("QueryTemplateID");
+    message.nameValueMap.erase("QueryTemplateRegister");
+}
+
+void SQLiteNode::_sendEscalationToPeer(Peer* peer, SData message, int priority) {
+    SASSERT(peer);
+    unique_lock<mutex> lock(_escalationBatchMutex);
+    EscalationBatch& batch = _escalationBatches[peer];
+
+    // Insert behind everything at the same or higher priority: when a batch has accumulated, high-priority messages
+    // go out first, but messages at equal priority keep their FIFO order. Batches are at most an in-flight send's
+    // worth of messages, so the linear scan is cheap.
+    auto insertAt = batch.messages.begin();
+    while (insertAt != batch.messages.end() && insertAt->first >= priority) {
+        insertAt++;
+    }
+    batch.messages.emplace(insertAt, priority, move(message));
+    if (batch.flushing) {
+        // Another thread is already draining this peer's batch, and will pick this message up (or, if it just
+        // finished draining, it still holds the lock and will loop back around and see it).
+        return;
+    }
+    batch.flushing = true;
+    while (!batch.messages.empty()) {
+        list<pair<int, SData>> messages = move(batch.messages);
+        batch.messages.clear();
+        lock.unlock();
+        if (messages.size() == 1) {
+            // No concurrent senders, so there's nothing to coalesce, and no reason to add batch framing. We own the
+            // drained list, so the message moves to the socket without another copy of its body.
+            _sendToPeer(peer, move(messages.front().second));
+        } else {
+            // Everything that accumulated while the last send was in flight goes out as one peer message, sharing a
+            // single set of CommitCount/Hash headers, which is most of the per-message overhead on the wire. The
+            // receiving side splits this back into individual messages in _onMESSAGE.
+            SData batchMessage("ESCALATE_BATCH");
+            batchMessage["Count"] = to_string(messages.size());
+            for (const auto& subMessage : messages) {
+                batchMessage.content += subMessage.second.serialize();
+            }
+            SINFO("Coalescing " << messages.size() << " escalation messages to " << peer->name << " into one batch ("
+                  << batchMessage.content.size() << " bytes).");
+            _sendToPeer(peer, batchMessage);
+        }
+        lock.lock();
+    }
+    batch.flushing = false;
+}
+
 void SQLiteNode::broadcast(const SData& message, Peer* peer) {
     if (peer) {
         SINFO("Sending broadcast: " << message.serialize() << " to peer: " << peer->name);
@@ -2035,11 +2900,11 @@ void SQLiteNode::_changeState(SQLiteNode::State newState) {
             // for the other to respond, but neither sends a response. We want a short timeout on this state.
             // TODO: Maybe it would be better to re-send the message indicating we're standing up when we see someone
             // hasn't responded.
-            timeout = STIME_US_PER_S * 5 + SRandom::rand64() % STIME_US_PER_S * 5;
+            timeout = STIME_US_PER_S * 5 + SRandom::fast64() % STIME_US_PER_S * 5;
         } else if (newState == SEARCHING || newState == SUBSCRIBING) {
-            timeout = SQL_NODE_DEFAULT_RECV_TIMEOUT + SRandom::rand64() % STIME_US_PER_S * 5;
+            timeout = SQL_NODE_DEFAULT_RECV_TIMEOUT + SRandom::fast64() % STIME_US_PER_S * 5;
         } else if (newState == SYNCHRONIZING) {
-            timeout = SQL_NODE_SYNCHRONIZING_RECV_TIMEOUT + SRandom::rand64() % STIME_US_PER_S * 5;
+            timeout = SQL_NODE_SYNCHRONIZING_RECV_TIMEOUT + SRandom::fast64() % STIME_US_PER_S * 5;
         } else {
             timeout = 0;
         }
@@ -2088,15 +2953,21 @@ void SQLiteNode::_changeState(SQLiteNode::State newState) {
             // Abort all remote initiated commands if no longer LEADING
             // TODO: No we don't, we finish it, as per other documentation in this file.
         } else if (newState == SEARCHING) {
-            auto lock = _escalatedCommandMap.scopedLock();
             if (!_escalatedCommandMap.empty()) {
                 // This isn't supposed to happen, though we've seen in logs where it can.
                 // So what we'll do is try and correct the problem and log the state we're coming from to see if that
                 // gives us any more useful info in the future.
-                _escalatedCommandMap.clear();
+                _escalatedCommandMap.takeAll();
+                _escalatedCommandCounts.clear();
                 SWARN("Switching from '" << stateName(_state) << "' to '" << stateName(newState)
                       << "' but _escalatedCommandMap not empty. Clearing it and hoping for the best.");
             }
+            if (!_forwardedEscalations.empty()) {
+                // Escalations we were relaying for chained replicas. The replicas see our state change and
+                // re-escalate on their own, so the records are just dead weight now.
+                SINFO("Dropping " << _forwardedEscalations.size() << " forwarded chained-replica escalation records.");
+                _forwardedEscalations.clear();
+            }
         } else if (newState == WAITING) {
             // The first time we enter WAITING, we're caught up and ready to join the cluster - use our real priority from now on
             _priority = _originalPriority;
@@ -2115,7 +2986,8 @@ void SQLiteNode::_changeState(SQLiteNode::State newState) {
     }
 }
 
-void SQLiteNode::_queueSynchronize(SQLiteNode* node, Peer* peer, SQLite& db, SData& response, bool sendAll) {
+void SQLiteNode::_queueSynchronize(SQLiteNode* node, Peer* peer, SQLite& db, SData& response, bool sendAll,
+                                   const SData& request) {
     // We need this to check the state of the node, and we also need `name` to make the logging macros work in a static
     // function. However, if you pass a null pointer here, we can't set these, so we'll fail. We also can't log that,
     // so we are just going to rely on the signal handling for sigsegv to log that for you. Don't do that.
@@ -2125,6 +2997,14 @@ void SQLiteNode::_queueSynchronize(SQLiteNode* node, Peer* peer, SQLite& db, SDa
     uint64_t peerCommitCount = 0;
     string peerHash;
     peer->getCommit(peerCommitCount, peerHash);
+
+    // A pipelining synchronizer requests its next batch before it's finished applying the previous one, so the commit
+    // count attached to its messages lags where it actually is. In that case it tells us explicitly where the batches
+    // it's already received will leave it, and we serve the range after that instead.
+    if (request.isSet("synchronizeCommitCount")) {
+        peerCommitCount = request.calcU64("synchronizeCommitCount");
+        peerHash = request["synchronizeHash"];
+    }
     if (peerCommitCount > db.getCommitCount())
         STHROW("you have more data than me");
     if (peerCommitCount) {
@@ -2170,6 +3050,10 @@ void SQLiteNode::_queueSynchronize(SQLiteNode* node, Peer* peer, SQLite& db, SDa
         // Wrap everything into one huge message
         PINFO("Synchronizing commits from " << peerCommitCount + 1 << "-" << targetCommit);
         response["NumCommits"] = SToStr(result.size());
+
+        // Tell the peer where this batch leaves it, so it can pipeline its next SYNCHRONIZE before applying.
+        response["UpThroughCommit"] = SToStr(toIndex);
+        response["UpThroughHash"] = result.back()[0];
         for (size_t c = 0; c < result.size(); ++c) {
             // Queue the result
             SASSERT(result[c].size() == 2);
@@ -2261,6 +3145,175 @@ void SQLiteNode::_recvSynchronize(Peer* peer, const SData& message) {
         STHROW("commits remaining at end");
 }
 
+string SQLiteNode::_snapshotFilename() const {
+    return _db.getFilename() + ".snapshot";
+}
+
+void SQLiteNode::_requestSnapshot(Peer* peer) {
+    // If a previous attempt left a partial file behind, resume from wherever it left off. The meta file records the
+    // epoch the partial data was read under and how much of it is valid; if the server's epoch has moved on, it will
+    // restart us from zero anyway.
+    _snapshotInProgress = true;
+    _snapshotOffset = 0;
+    _snapshotPeerEpoch = 0;
+    string meta;
+    list<string> parts;
+    if (SFileLoad(_snapshotFilename() + ".meta", meta) && SParseList(meta, parts, ' ')) {
+        if (parts.size() == 2) {
+            _snapshotPeerEpoch = SToUInt64(parts.front());
+            _snapshotOffset = SToUInt64(parts.back());
+        }
+    }
+    PINFO("Requesting bulk snapshot starting at offset " << _snapshotOffset << ".");
+    SData request("SNAPSHOT_REQUEST");
+    request["Offset"] = to_string(_snapshotOffset);
+    request["Epoch"] = to_string(_snapshotPeerEpoch);
+    _sendToPeer(peer, request);
+}
+
+void SQLiteNode::_abortSnapshot() {
+    _snapshotInProgress = false;
+    SFileDelete(_snapshotFilename());
+    SFileDelete(_snapshotFilename() + ".meta");
+}
+
+void SQLiteNode::_handleSnapshotRequest(Peer* peer, const SData& message) {
+    // A completely empty peer wants our raw database file instead of a journal replay. Denials make it fall back to
+    // a plain SYNCHRONIZE.
+    if (!_db.getCommitCount()) {
+        PHMMM("Peer requested a snapshot but we have no data, denying.");
+        SData deny("SNAPSHOT_DENIED");
+        deny["Reason"] = "no data";
+        _sendToPeer(peer, deny);
+        return;
+    }
+
+    // Freeze the main database file for the duration of the transfer by holding checkpoints: writes keep landing in
+    // the WAL, so the bytes we stream stay self-consistent. The hold is released (and the epoch bumped) in update()
+    // once the requester goes quiet for SNAPSHOT_SERVE_TIMEOUT.
+    if (!_snapshotServing) {
+        _db.holdCheckpoints();
+        _snapshotServing = true;
+    }
+    _snapshotServeTimeout = STimeNow() + SNAPSHOT_SERVE_TIMEOUT;
+
+    // If the peer is resuming a transfer from before we last released the hold, the file may have changed underneath
+    // it; make it start over.
+    uint64_t offset = message.calcU64("Offset");
+    if (offset && message.calcU64("Epoch") != _snapshotEpoch) {
+        PHMMM("Peer tried to resume a snapshot from a stale epoch (" << message["Epoch"] << " vs " << _snapshotEpoch
+              << "), restarting it from offset 0.");
+        offset = 0;
+    }
+
+    FILE* file = fopen(_db.getFilename().c_str(), "rb");
+    if (!file) {
+        PWARN("Couldn't open database file for snapshot, denying.");
+        SData deny("SNAPSHOT_DENIED");
+        deny["Reason"] = "can't read database";
+        _sendToPeer(peer, deny);
+        return;
+    }
+    fseeko(file, 0, SEEK_END);
+    uint64_t fileSize = ftello(file);
+    string chunk(min(SNAPSHOT_CHUNK_SIZE, fileSize - min(fileSize, offset)), '\0');
+    fseeko(file, offset, SEEK_SET);
+    size_t bytesRead = fread(&chunk[0], 1, chunk.size(), file);
+    fclose(file);
+    chunk.resize(bytesRead);
+
+    SData response("SNAPSHOT_RESPONSE");
+    response["Offset"] = to_string(offset);
+    response["FileSize"] = to_string(fileSize);
+    response["Epoch"] = to_string(_snapshotEpoch);
+    response["Hash"] = SToHex(SHashSHA1(chunk));
+    response.content = move(chunk);
+    PINFO("Serving snapshot chunk at offset " << offset << " of " << fileSize << " (epoch " << _snapshotEpoch << ").");
+    _sendToPeer(peer, response);
+}
+
+void SQLiteNode::_handleSnapshotResponse(Peer* peer, const SData& message) {
+    if (_state != SYNCHRONIZING || !_snapshotInProgress) {
+        STHROW("not expecting a snapshot");
+    }
+    if (!_syncPeer) {
+        STHROW("too late, gave up on you");
+    }
+    if (peer != _syncPeer) {
+        STHROW("sync peer mismatch");
+    }
+
+    // If the peer can't serve a snapshot, fall back to a plain journal SYNCHRONIZE from scratch.
+    if (SIEquals(message.methodLine, "SNAPSHOT_DENIED")) {
+        PHMMM("Peer denied snapshot (" << message["Reason"] << "), falling back to journal synchronization.");
+        _abortSnapshot();
+        _sendToPeer(peer, SData("SYNCHRONIZE"));
+        return;
+    }
+
+    // If the server restarted us from offset zero (stale epoch), discard whatever partial data we had.
+    uint64_t offset = message.calcU64("Offset");
+    if (offset != _snapshotOffset) {
+        if (offset == 0) {
+            PINFO("Server restarted the snapshot transfer, discarding partial file.");
+            SFileDelete(_snapshotFilename());
+            _snapshotOffset = 0;
+        } else {
+            STHROW("unexpected snapshot offset");
+        }
+    }
+    _snapshotPeerEpoch = message.calcU64("Epoch");
+    _snapshotFileSize = message.calcU64("FileSize");
+
+    // Verify the chunk arrived intact; if not, just re-request the same offset.
+    if (!SIEquals(message["Hash"], SToHex(SHashSHA1(message.content)))) {
+        PWARN("Snapshot chunk at offset " << offset << " failed its checksum, re-requesting.");
+        SData retry("SNAPSHOT_REQUEST");
+        retry["Offset"] = to_string(_snapshotOffset);
+        retry["Epoch"] = to_string(_snapshotPeerEpoch);
+        _sendToPeer(peer, retry);
+        return;
+    }
+
+    // Append the chunk at its offset and record our progress so an interrupted transfer can resume.
+    FILE* file = fopen(_snapshotFilename().c_str(), offset ? "r+b" : "wb");
+    if (!file) {
+        STHROW("can't write snapshot file");
+    }
+    fseeko(file, offset, SEEK_SET);
+    size_t bytesWritten = fwrite(message.content.data(), 1, message.content.size(), file);
+    fclose(file);
+    if (bytesWritten != message.content.size()) {
+        STHROW("short write to snapshot file");
+    }
+    _snapshotOffset = offset + message.content.size();
+    SFileSave(_snapshotFilename() + ".meta", to_string(_snapshotPeerEpoch) + " " + to_string(_snapshotOffset));
+
+    // Keep extending our timeout so long as chunks keep arriving.
+    _stateTimeout = STimeNow() + SQL_NODE_SYNCHRONIZING_RECV_TIMEOUT + SRandom::fast64() % STIME_US_PER_S * 5;
+
+    if (_snapshotOffset < _snapshotFileSize) {
+        // More to go, request the next chunk.
+        SINFO("Snapshot transfer underway, " << _snapshotOffset << " of " << _snapshotFileSize << " bytes received.");
+        SData next("SNAPSHOT_REQUEST");
+        next["Offset"] = to_string(_snapshotOffset);
+        next["Epoch"] = to_string(_snapshotPeerEpoch);
+        _sendToPeer(peer, next);
+        return;
+    }
+
+    // The whole file has arrived. Bulk-load it into our live database handles, then run a normal SYNCHRONIZE to
+    // catch the tail of commits that landed in the peer's WAL while the transfer was underway.
+    bool loaded = _db.loadSnapshot(_snapshotFilename());
+    _abortSnapshot();
+    if (!loaded) {
+        STHROW("couldn't load snapshot");
+    }
+    SINFO("Snapshot transfer complete at commitCount #" << _db.getCommitCount()
+          << ", synchronizing the journal tail.");
+    _sendToPeer(peer, SData("SYNCHRONIZE"));
+}
+
 void SQLiteNode::_updateSyncPeer()
 {
     Peer* newSyncPeer = nullptr;
@@ -2383,7 +3436,7 @@ bool SQLiteNode::peekPeerCommand(shared_ptr<SQLiteNode> node, SQLite& db, SQLite
 
             // Because we hold a sharedPtr to the node, it can't delete any peers (because it only does at
             // destruction), and since our peers our thread-safe, we can run this just fine.
-            _queueSynchronize(node.get(), peer, db, command.response, false);
+            _queueSynchronize(node.get(), peer, db, command.response, false, command.request);
 
             // The following two lines are copied from `_sendToPeer`.
             command.response["CommitCount"] = to_string(db.getCommitCount());
@@ -2576,6 +3629,13 @@ int SQLiteNode::handleCommitTransaction(SQLite& db, Peer* peer, const uint64_t c
           << readElapsed / 1000 << "+" << writeElapsed / 1000 << "+"
           << prepareElapsed / 1000 << "+" << commitElapsed / 1000 << "+"
           << rollbackElapsed / 1000 << "ms)");
+
+    // Export replication apply time, so a scrape can see when the follower's sync thread starts falling behind.
+    static atomic<uint64_t>& applyUS = SMetrics::counter("replication.applyUS");
+    static atomic<uint64_t>& applyCount = SMetrics::counter("replication.applyCount");
+    applyUS += totalElapsed;
+    applyCount++;
+
     _handledCommitCount++;
     if (_handledCommitCount % 5000 == 0) {
         // Log how much time we've spent handling 5000 commits.
@@ -1,9 +1,11 @@
 #pragma once
+#include <libstuff/SStringCounts.h>
+#include <libstuff/STimerWheel.h>
 #include "SQLite.h"
 #include "SQLitePool.h"
 #include "SQLiteSequentialNotifier.h"
 #include "WallClockTimer.h"
-#include "../SynchronizedMap.h"
+#include "../ShardedMap.h"
 class SQLiteCommand;
 class SQLiteServer;
 
@@ -38,8 +40,13 @@ class SQLiteNode : public STCPNode {
     };
 
     // Constructor/Destructor
+    // `workerThreads` sizes the replication worker pool used for parallel replication (see _replicationWorkerLoop).
+    // If 0, it defaults to the number of cores on the machine.
+    // `subscribeTo`, when set, names the peer this node subscribes to instead of leader (chained replication, see
+    // `_subscribeTo`). Only honored on a permafollower (priority 0).
     SQLiteNode(SQLiteServer& server, SQLitePool& dbPool, const string& name, const string& host,
-               const string& peerList, int priority, uint64_t firstTimeout, const string& version, const bool useParallelReplication = false);
+               const string& peerList, int priority, uint64_t firstTimeout, const string& version, const bool useParallelReplication = false,
+               int workerThreads = 0, const string& subscribeTo = "");
     ~SQLiteNode();
 
     const vector<Peer*> initPeers(const string& peerList);
@@ -48,6 +55,7 @@ class SQLiteNode : public STCPNode {
     State         getState()         { return _state; }
     int           getPriority()      { return _priority; }
     const string& getLeaderVersion() { return _leaderVersion; }
+    const string& getSubscribeTo()   { return _subscribeTo; }
     const string& getVersion()       { return _version; }
     uint64_t      getCommitCount()   { return _db.getCommitCount(); }
 
@@ -87,7 +95,11 @@ class SQLiteNode : public STCPNode {
     // takes ownership of the command until it receives a response from the follower. When the command completes, it will
     // be re-queued in the SQLiteServer (_server), but its `complete` field will be set to true.
     // If the 'forget' flag is set, we will not expect a response from leader for this command.
-    void escalateCommand(unique_ptr<SQLiteCommand>&& command, bool forget = false);
+    // Escalate the given command to leader. `priority` is the command's effective priority (the server's, not just
+    // the request header's, which can differ when a plugin assigned one directly); it's carried on the ESCALATE
+    // message so leader queues the command at the same priority we would have, and it orders our own escalation
+    // sends under bursts. Commands without an explicit priority escalate at 500 (BedrockCommand::PRIORITY_NORMAL).
+    void escalateCommand(unique_ptr<SQLiteCommand>&& command, bool forget = false, int priority = 500);
 
     // This takes a completed command and sends the response back to the originating peer. If we're not the leader
     // node, or if this command doesn't have an `initiatingPeerID`, then calling this function is an error.
@@ -98,9 +110,14 @@ class SQLiteNode : public STCPNode {
     // Returns false if the node can't peek the command.
     static bool peekPeerCommand(shared_ptr<SQLiteNode>, SQLite& db, SQLiteCommand& command);
 
-    // This exists so that the _server can inspect internal state for diagnostic purposes.
+    // This exists so that the _server can inspect internal state for diagnostic purposes. It locks the escalated
+    // command map, so it's reserved for `Status?detail=full`; normal state reporting uses getEscalatedCommandCounts.
     list<string> getEscalatedCommandRequestMethodLines();
 
+    // Returns approximate counts of escalated commands by method line, from counters maintained as commands are
+    // escalated and resolved, without locking the escalated command map.
+    map<string, int64_t> getEscalatedCommandCounts();
+
     // This will broadcast a message to all peers, or a specific peer.
     void broadcast(const SData& message, Peer* peer = nullptr);
 
@@ -136,6 +153,12 @@ class SQLiteNode : public STCPNode {
     // to make sure it's up-to-date. Store the configured priority here and use "-1" until we're ready to fully join the cluster.
     int _originalPriority;
 
+    // If set, the name of the peer we subscribe to instead of leader: this node is a chained read replica, taking
+    // its replication stream relayed through a follower so that a fleet of replicas doesn't multiply leader's send
+    // fan-out. Only honored on a permafollower (a chained replica must never count toward quorum); cleared by the
+    // constructor otherwise. If the named upstream isn't available, we fall back to subscribing to leader directly.
+    string _subscribeTo;
+
     // Our current State.
     atomic<State> _state;
     
@@ -177,15 +200,114 @@ class SQLiteNode : public STCPNode {
     uint64_t _lastQuorumTime;
 
     // Helper methods
+    // The rvalue overload stamps CommitCount/Hash into the message in place and serializes it straight to the
+    // socket; the const one pays for a copy first. Escalations with MB-scale bodies come through the rvalue path.
     void _sendToPeer(Peer* peer, const SData& message);
+    void _sendToPeer(Peer* peer, SData&& message);
     void _sendToAllPeers(const SData& message, bool subscribedOnly = false);
+
+    // Sends a BEGIN_TRANSACTION to subscribed peers (or to `onlyPeer` alone), template-encoding the query for any
+    // peer that negotiated it: the query text is split into a statement shape (every literal replaced with `?`) and
+    // the list of literal values, the shape gets a leader-assigned id registered inline with the first message that
+    // uses it on each connection, and subsequent transactions with the same shape carry only the id plus values.
+    // Since the commit hash is computed over the exact query text, an encoding is only ever shipped after splicing
+    // the values back into the shape reproduced the original byte-for-byte; anything the tokenizer can't round-trip
+    // goes out as plain text. For our UPDATE-heavy workloads, where thousands of near-identical statements differ
+    // only in their values, this cuts most of the replicated query text off the wire.
+    void _sendTransactionToPeers(const SData& transaction, Peer* onlyPeer = nullptr);
+
+    // Splits `query` into a shape (literals replaced with `?`) and its literal values. Returns false if the query
+    // contains no literals, in which case there's nothing to gain from encoding it.
+    static bool _templateEncodeQuery(const string& query, string& shape, vector<string>& values);
+
+    // Inverse of the above: splices `values` back into `shape` in order. Throws if the counts don't line up.
+    static string _templateDecodeQuery(const string& shape, const vector<string>& values);
+
+    // Expands a template-encoded BEGIN_TRANSACTION received from `peer` back into its full query text in place,
+    // registering the shape from the message if it carries one. Throws if the message references a shape this
+    // connection has never seen, which disconnects the peer and resyncs.
+    void _decodeTemplateQuery(Peer* peer, SData& message);
+
+    // Shapes we've assigned ids to as leader, and the last id we handed out. Ids are stable for the life of the
+    // process (the map is append-only), so per-connection knowledge of them survives our own state transitions; the
+    // per-peer record of which ids a connection has seen lives on the Peer and clears on disconnect. Sync thread
+    // only. Bounded: once full, new shapes just ship as plain text.
+    map<string, uint64_t> _queryTemplateIDs;
+    uint64_t _lastQueryTemplateID = 0;
+    static const size_t MAX_QUERY_TEMPLATES = 10000;
+
+    // Sends an ESCALATE or ESCALATE_RESPONSE message to a peer, coalescing any messages queued for the same peer by
+    // concurrent callers into a single framed ESCALATE_BATCH message (the receiver splits it in _onMESSAGE). A lone
+    // message goes out unwrapped, so this adds no latency or framing in the un-contended case; under escalation
+    // bursts, everything that accumulates while one send is in flight shares one peer message and one set of
+    // CommitCount/Hash headers. `priority` is the command priority the message is about (from the command's
+    // `priority` request header); when a batch has accumulated, higher-priority messages go out ahead of
+    // lower-priority ones. Takes the message by value so callers done with theirs can move it in; the batch owns
+    // it from there to the socket without another copy of the body.
+    void _sendEscalationToPeer(Peer* peer, SData message, int priority);
+
+    // Per-peer escalation messages waiting to be coalesced, as (priority, message) pairs kept sorted
+    // highest-priority-first. While one thread is draining a peer's batch, other threads just append here; messages
+    // are inserted and drained under the same lock, so ordering between messages at equal priority holds.
+    struct EscalationBatch {
+        list<pair<int, SData>> messages;
+        bool flushing = false;
+    };
+    map<Peer*, EscalationBatch> _escalationBatches;
+    mutex _escalationBatchMutex;
+
+    // Escalations we've forwarded to leader on behalf of chained replicas subscribed to us: command ID -> the
+    // downstream peer's ID, so the ESCALATE_RESPONSE (or ESCALATE_ABORTED) can be relayed back to whoever escalated
+    // it. Command IDs are globally unique (`nodeName#N`), so these can never collide with our own escalations in
+    // `_escalatedCommandMap`. Sync thread only; cleared when we stop FOLLOWING (the replicas see our state change
+    // and re-escalate on their own).
+    map<string, uint64_t> _forwardedEscalations;
+
+    // Relays a replication message to any chained replicas subscribed to us; a no-op when nobody is. The upstream's
+    // CommitCount/Hash headers are stripped so the message goes out stamped with our own committed state, the same
+    // way leader stamps its sends.
+    void _relayToSubscribers(const SData& message);
+
     void _changeState(State newState);
 
     // Queue a SYNCHRONIZE message based on the current state of the node, thread-safe, but you need to pass the
     // *correct* DB for the thread that's making the call (i.e., you can't use the node's internal DB from a worker
     // thread with a different DB object) - which is why this is static.
-    static void _queueSynchronize(SQLiteNode* node, Peer* peer, SQLite& db, SData& response, bool sendAll);
+    // `request`, when supplied, is the SYNCHRONIZE message being responded to. A pipelining synchronizer includes
+    // `synchronizeCommitCount`/`synchronizeHash` headers there to report the commit it *will* be at once it finishes
+    // applying the batches it's already received, overriding the (stale) state attached to its last message.
+    static void _queueSynchronize(SQLiteNode* node, Peer* peer, SQLite& db, SData& response, bool sendAll,
+                                  const SData& request = SData());
     void _recvSynchronize(Peer* peer, const SData& message);
+
+    // Bulk snapshot transfer, for bootstrapping a brand-new (empty) node without replaying the whole journal through
+    // SYNCHRONIZE. The empty node requests raw chunks of the serving peer's main database file with
+    // SNAPSHOT_REQUEST(Offset, Epoch); the server freezes the file by holding checkpoints (writes keep landing in
+    // the WAL) and answers each request with one checksummed SNAPSHOT_RESPONSE chunk. When the file has fully
+    // arrived, the receiver bulk-loads it (SQLite::loadSnapshot) and falls into a normal SYNCHRONIZE for the tail
+    // that accumulated in the server's WAL meanwhile. Transfers resume from the local partial file's offset after a
+    // disconnect, as long as the server's Epoch — bumped whenever it releases its checkpoint hold, i.e., whenever
+    // the file may have changed — still matches; otherwise they restart from zero.
+    void _handleSnapshotRequest(Peer* peer, const SData& message);
+    void _handleSnapshotResponse(Peer* peer, const SData& message);
+    void _requestSnapshot(Peer* peer);
+    void _abortSnapshot();
+    string _snapshotFilename() const;
+
+    // Server-side transfer state: whether we're currently holding checkpoints for a requester, when that hold
+    // expires if the requester goes quiet, and the epoch described above. Only touched on the sync thread.
+    bool _snapshotServing = false;
+    uint64_t _snapshotServeTimeout = 0;
+    uint64_t _snapshotEpoch = 0;
+
+    // Receiver-side transfer state. Only touched on the sync thread.
+    bool _snapshotInProgress = false;
+    uint64_t _snapshotOffset = 0;
+    uint64_t _snapshotFileSize = 0;
+    uint64_t _snapshotPeerEpoch = 0;
+
+    static const uint64_t SNAPSHOT_CHUNK_SIZE = 4 * 1024 * 1024;
+    static const uint64_t SNAPSHOT_SERVE_TIMEOUT = 60 * STIME_US_PER_S;
     void _reconnectPeer(Peer* peer);
     void _reconnectAll();
     bool _isQueuedCommandMapEmpty();
@@ -193,8 +315,34 @@ class SQLiteNode : public STCPNode {
     bool _majoritySubscribed();
 
     // When we're a follower, we can escalate a command to the leader. When we do so, we store that command in the
-    // following map of commandID to Command until the follower responds.
-    SynchronizedMap<string, unique_ptr<SQLiteCommand>> _escalatedCommandMap;
+    // following map until the leader responds. Commands are keyed by the integer portion of their ID (see
+    // _escalationID) rather than the ID string, so the per-command store/find/erase cycle never locks a global mutex
+    // or builds map keys; only shutdown and state-change accounting scan the whole thing.
+    ShardedMap<unique_ptr<SQLiteCommand>> _escalatedCommandMap;
+
+    // Extracts the integer map key from a command ID. IDs are stamped `nodeName#N` with N from a node-local counter,
+    // and we only ever store commands we stamped ourselves, so the numeric suffix alone is unique here.
+    static uint64_t _escalationID(const string& commandID);
+
+    // Approximate per-method-line counts of the commands in _escalatedCommandMap, so `Status` doesn't need to lock
+    // it. Updated everywhere the map is.
+    SStringCounts _escalatedCommandCounts;
+
+    // Deadline index over the escalated commands: a timer wheel of (deadline, escalation ID) entries, checked each
+    // update() pass while FOLLOWING. Entries are never cancelled - an expired entry whose command has already been
+    // resolved finds nothing in the map and is dropped (IDs are never reused) - so the response path stays
+    // untouched. Its own mutex, since workers escalate while the sync thread expires.
+    STimerWheel<uint64_t> _escalationTimeouts;
+    mutex _escalationTimeoutsMutex;
+
+    // The absolute deadline for an escalated command, mirroring BedrockCommand's timeout semantics without reaching
+    // up a layer: the command's own `timeout` header (in milliseconds) when present, the same 290s default
+    // otherwise, measured from the command's scheduled execution time.
+    static uint64_t _escalationDeadline(const SQLiteCommand& command);
+
+    // Fails every escalated command whose deadline has passed with a "555 Timeout" response (same response a worker
+    // gives a command that times out locally), instead of holding it until leader responds or the client hangs up.
+    void _failTimedOutEscalations();
 
     // Replicates any transactions that have been made on our database by other threads to peers.
     void _sendOutstandingTransactions(const set<uint64_t>& commitOnlyIDs = {});
@@ -245,9 +393,52 @@ class SQLiteNode : public STCPNode {
     // noting is that a checkpoint can interrupt a transaction, forcing it to restart. See
     // SQLite::CheckpointRequiredListener for more information on that process.
     //
-    // This thread exits on completion of handling the command or when node._replicationThreadsShouldExit is set,
+    // This function exits on completion of handling the command or when node._replicationThreadsShouldExit is set,
     // which happens when a node stops FOLLOWING.
-    static void replicate(SQLiteNode& node, Peer* peer, SData command, size_t sqlitePoolIndex);
+    static void replicate(SQLiteNode& node, Peer* peer, SData command, SQLite& db);
+
+    // The loop run by each thread in the persistent replication worker pool. Each worker acquires a DB handle from
+    // the pool once, at startup, and re-uses it for every replicated transaction it handles, so we don't pay for a
+    // pthread create/destroy cycle plus a fresh SInitialize on every BEGIN_TRANSACTION received. Only
+    // BEGIN_TRANSACTION messages are dispatched to the pool; COMMIT_TRANSACTION and ROLLBACK_TRANSACTION are trivial
+    // and handled inline in _onMESSAGE, which also guarantees a commit notification can never be stuck in the queue
+    // behind the BEGIN that's waiting for it.
+    void _replicationWorkerLoop(size_t threadNum);
+
+    // Applies a run of sequential replicated transactions, all already known to be committed on leader, as one local
+    // SQLite transaction (see SQLite::applyCatchUpBatch). This is the catch-up fast path: when a follower is far
+    // behind (post-restart, post-blip), applying each queued commit as its own begin/write/prepare/commit cycle
+    // limits catch-up rate to one WAL sync per commit, not CPU or network. _replicationWorkerLoop collects an
+    // eligible run off the queue and hands it here. `messages` are the BEGIN_TRANSACTION messages, contiguous by
+    // NewCount, starting at the DB's next commit.
+    void _replicateBatch(list<SData>&& messages, SQLite& db);
+
+    // Batching kicks in only when the replication queue is at least this deep (we're clearly in catch-up, not
+    // steady-state), and applies at most this many commits per local transaction (bounding memory and how long the
+    // commit lock is held).
+    static const size_t CATCH_UP_BATCH_MIN_QUEUE = 100;
+    static const size_t CATCH_UP_BATCH_MAX = 100;
+
+    // The worker pool threads themselves (started in the constructor when parallel replication is on), the queue of
+    // replication messages they pull from, and its synchronization.
+    list<thread> _replicationThreads;
+    list<pair<Peer*, SData>> _replicationQueue;
+    mutex _replicationQueueMutex;
+    condition_variable _replicationQueueCV;
+
+    // Set in the destructor to shut the worker pool down. Note that this is distinct from
+    // _replicationThreadsShouldExit, which is set (and then cleared) every time we stop FOLLOWING.
+    atomic<bool> _replicationWorkersShouldExit;
+
+    // The page sets of replicated transactions currently being applied, keyed by commit ID. When leader ships the
+    // begin-concurrent page report with a transaction (the `writtenPages` header), replication threads use this map
+    // to predict conflicts: a new ASYNC transaction whose page set intersects an earlier in-flight one waits for
+    // that transaction's commit *before* beginning, instead of running, failing with SQLITE_BUSY_SNAPSHOT at commit,
+    // and retrying. Transactions with no page data fall back to the existing run-and-retry behavior. Note that this
+    // only affects when transactions *start*; commits always happen in leader's order regardless, because the
+    // journal's hash chain is order-dependent.
+    map<uint64_t, set<uint64_t>> _inFlightTransactionPages;
+    mutex _inFlightTransactionPagesMutex;
 
     // Counter of the total number of currently active replication threads. This is used to let us know when all
     // threads have finished.
@@ -256,8 +447,6 @@ class SQLiteNode : public STCPNode {
     // Indicates whether this node is configured for parallel replication.
     const bool _useParallelReplication;
 
-    // Monotonically increasing thread counter, used for thread IDs for logging purposes.
-    static atomic<int64_t> _currentCommandThreadID;
 
     // Utility class that can decrement _replicationThreadCount when objects go out of scope.
     template <typename CounterType>
@@ -0,0 +1,125 @@
+#include <libstuff/SMetrics.h>
+#include "SQLite.h"
+#include "SQLitePlanMonitor.h"
+
+atomic<bool> SQLitePlanMonitor::alwaysPin(false);
+mutex SQLitePlanMonitor::_mutex;
+map<string, SQLitePlanMonitor::Entry> SQLitePlanMonitor::_entries;
+atomic<uint64_t> SQLitePlanMonitor::_lastCheck(0);
+
+void SQLitePlanMonitor::registerQuery(const string& name, const string& query, const string& pinTable,
+                                      const string& pinIndex) {
+    lock_guard<mutex> lock(_mutex);
+    Entry& entry = _entries[name];
+    entry = Entry();
+    entry.query = query;
+    entry.pinTable = pinTable;
+    entry.pinIndex = pinIndex;
+}
+
+void SQLitePlanMonitor::captureBaselines(SQLite& db) {
+    lock_guard<mutex> lock(_mutex);
+    for (auto& pair : _entries) {
+        Entry& entry = pair.second;
+        if (entry.baselinePlan.empty()) {
+            entry.baselinePlan = db.explainQueryPlan(entry.query);
+            entry.currentPlan = entry.baselinePlan;
+            if (entry.baselinePlan.empty()) {
+                SWARN("Couldn't capture baseline plan for '" << pair.first << "', statement won't prepare.");
+            } else {
+                SINFO("Baseline plan for '" << pair.first << "': " << SReplace(entry.baselinePlan, "\n", " | "));
+            }
+        }
+    }
+}
+
+void SQLitePlanMonitor::check(SQLite& db) {
+    // Rate-limit: only one thread gets to run a check per interval.
+    uint64_t last = _lastCheck.load();
+    uint64_t now = STimeNow();
+    if (now < last + CHECK_INTERVAL || !_lastCheck.compare_exchange_strong(last, now)) {
+        return;
+    }
+    lock_guard<mutex> lock(_mutex);
+    for (auto& pair : _entries) {
+        Entry& entry = pair.second;
+        if (entry.baselinePlan.empty()) {
+            // Never captured (or wouldn't prepare); nothing to compare against.
+            continue;
+        }
+        string plan = db.explainQueryPlan(entry.query);
+        if (plan.empty()) {
+            // The statement stopped preparing entirely (i.e., the schema changed under it), which is its own warning.
+            SWARN("Can't re-explain '" << pair.first << "', statement won't prepare.");
+            continue;
+        }
+        if (plan != entry.currentPlan) {
+            // Log transitions, not steady state, so a changed plan warns once rather than every interval.
+            if (plan == entry.baselinePlan) {
+                SINFO("Query plan for '" << pair.first << "' returned to baseline.");
+            } else {
+                SWARN("Query plan changed for '" << pair.first << "': now [" << SReplace(plan, "\n", " | ")
+                      << "], baseline [" << SReplace(entry.baselinePlan, "\n", " | ") << "]."
+                      << (entry.pinIndex.empty() ? "" : " Pinning to " + entry.pinIndex + "."));
+                SMetrics::counter("planmonitor.changed")++;
+            }
+            entry.currentPlan = plan;
+        }
+        entry.changed = (plan != entry.baselinePlan);
+    }
+}
+
+string SQLitePlanMonitor::pin(const string& name, const string& query) {
+    string table;
+    string index;
+    {
+        lock_guard<mutex> lock(_mutex);
+        auto it = _entries.find(name);
+        if (it == _entries.end() || it->second.pinIndex.empty() || (!it->second.changed && !alwaysPin.load())) {
+            return query;
+        }
+        table = it->second.pinTable;
+        index = it->second.pinIndex;
+    }
+
+    // Don't fight a statement that already pins something explicitly.
+    if (query.find("INDEXED BY") != string::npos) {
+        return query;
+    }
+
+    // Insert `INDEXED BY` after each `FROM <table>` or `JOIN <table>`, matching whole identifiers only. Positions
+    // are collected first and applied back-to-front so earlier insertions don't shift later ones.
+    auto isIdentChar = [](char c) { return isalnum((unsigned char)c) || c == '_'; };
+    vector<size_t> insertAt;
+    for (const char* keyword : {"FROM ", "JOIN "}) {
+        string pattern = string(keyword) + table;
+        size_t pos = 0;
+        while ((pos = query.find(pattern, pos)) != string::npos) {
+            size_t end = pos + pattern.size();
+            if ((pos == 0 || !isIdentChar(query[pos - 1])) && (end == query.size() || !isIdentChar(query[end]))) {
+                insertAt.push_back(end);
+            }
+            pos = end;
+        }
+    }
+    if (insertAt.empty()) {
+        return query;
+    }
+    sort(insertAt.rbegin(), insertAt.rend());
+    string pinned = query;
+    for (size_t pos : insertAt) {
+        pinned.insert(pos, " INDEXED BY " + index);
+    }
+    return pinned;
+}
+
+STable SQLitePlanMonitor::status() {
+    STable result;
+    lock_guard<mutex> lock(_mutex);
+    for (const auto& pair : _entries) {
+        result[pair.first] = pair.second.baselinePlan.empty() ? "uncaptured"
+                           : pair.second.changed              ? "changed"
+                                                              : "baseline";
+    }
+    return result;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <libstuff/libstuff.h>
+class SQLite;
+
+// A process-wide registry of hot statements whose query plans we care about. SQLite's planner re-decides plans from
+// table statistics, so an ANALYZE run or plain stat drift can silently knock a hot query off its intended index --
+// nothing fails, everything just gets slow. Plugins register a representative instance of each hot statement (the
+// plan depends on the statement's shape, not its literal values); `captureBaselines` records what the planner picks
+// at startup, and `check` periodically re-explains each statement, logging a warning and bumping the
+// `planmonitor.changed` counter (visible in `Status`) when a plan diverges from its baseline.
+//
+// Statements registered with a pin target can additionally be forced back onto their intended index: once a plan
+// change has been detected (or `alwaysPin` is set), `pin` rewrites the statement with `INDEXED BY`, taking the
+// decision away from the planner entirely.
+class SQLitePlanMonitor {
+  public:
+    // Registers a hot statement under `name`. `query` is a representative instance with typical literal values. If
+    // `pinTable`/`pinIndex` are given, they name the index the statement is expected to use, making it eligible for
+    // `pin`. Registering the same name again replaces the entry (and its baseline).
+    static void registerQuery(const string& name, const string& query, const string& pinTable = "",
+                              const string& pinIndex = "");
+
+    // Captures the baseline plan for every registered statement that doesn't have one yet. Called once a DB handle
+    // is available (i.e., from upgradeDatabase); calling it again is cheap and only fills in new registrations.
+    static void captureBaselines(SQLite& db);
+
+    // Re-explains every registered statement and compares against its baseline, warning and counting any change.
+    // Rate-limited internally to once per CHECK_INTERVAL, so it's safe to call every pass of a main loop.
+    static void check(SQLite& db);
+
+    // Returns `query` rewritten with `INDEXED BY` forcing `name`'s pinned index, if `name` was registered with a pin
+    // and a plan change has been detected for it (or `alwaysPin` is set). Otherwise returns `query` unchanged.
+    static string pin(const string& name, const string& query);
+
+    // Forces pins for every pinnable statement regardless of whether a regression has been detected, for operators
+    // who'd rather never let the planner drift on these (set from the `-pinQueryPlans` command line flag).
+    static atomic<bool> alwaysPin;
+
+    // Per-statement plan state ("baseline" or "changed") for the Status handler.
+    static STable status();
+
+  private:
+    struct Entry {
+        string query;
+        string pinTable;
+        string pinIndex;
+        string baselinePlan;
+        string currentPlan;
+        bool changed = false;
+    };
+
+    static const uint64_t CHECK_INTERVAL = 60 * STIME_US_PER_S;
+
+    static mutex _mutex;
+    static map<string, Entry> _entries;
+    static atomic<uint64_t> _lastCheck;
+};
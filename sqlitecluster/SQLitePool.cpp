@@ -9,24 +9,29 @@ SQLitePool::SQLitePool(size_t maxDBs,
                        const string& synchronous,
                        int64_t mmapSizeGB,
                        bool pageLoggingEnabled)
-: _maxDBs(max(maxDBs, 1ul)),
+: _waiters(0),
+  _maxDBs(max(maxDBs, 1ul)),
   _baseDB(filename, cacheSize, maxJournalSize, minJournalTables, synchronous, mmapSizeGB, pageLoggingEnabled),
+  _freeListHead(0),
+  _freeListNext(_maxDBs),
+  _allocatedCount(0),
   _objects(_maxDBs, nullptr)
 {
 }
 
 SQLitePool::~SQLitePool() {
-    lock_guard<mutex> lock(_sync);
-    if (_inUseHandles.size()) {
-        SWARN("Destroying SQLitePool with DBs in use.");
+    // Drain the free list so we can tell whether every allocated handle was returned.
+    size_t freeCount = 0;
+    size_t index = 0;
+    while (_popFreeList(index)) {
+        freeCount++;
     }
-    for (auto dbHandle : _availableHandles) {
-        delete _objects[dbHandle];
-        _objects[dbHandle] = nullptr;
+    if (freeCount != _allocatedCount.load()) {
+        SWARN("Destroying SQLitePool with DBs in use.");
     }
-    for (auto dbHandle : _inUseHandles) {
-        delete _objects[dbHandle];
-        _objects[dbHandle] = nullptr;
+    for (auto& dbHandle : _objects) {
+        delete dbHandle;
+        dbHandle = nullptr;
     }
 }
 
@@ -34,34 +39,68 @@ SQLite& SQLitePool::getBase() {
     return _baseDB;
 }
 
+bool SQLitePool::_popFreeList(size_t& index) {
+    uint64_t head = _freeListHead.load();
+    while (head & 0xFFFFFFFF) {
+        size_t candidate = (head & 0xFFFFFFFF) - 1;
+        uint64_t newHead = (((head >> 32) + 1) << 32) | _freeListNext[candidate].load();
+        if (_freeListHead.compare_exchange_weak(head, newHead)) {
+            index = candidate;
+            return true;
+        }
+        // `head` was reloaded by the failed compare-exchange, try again.
+    }
+    return false;
+}
+
+void SQLitePool::_pushFreeList(size_t index) {
+    uint64_t head = _freeListHead.load();
+    while (true) {
+        _freeListNext[index].store(head & 0xFFFFFFFF);
+        uint64_t newHead = (((head >> 32) + 1) << 32) | (index + 1);
+        if (_freeListHead.compare_exchange_weak(head, newHead)) {
+            return;
+        }
+    }
+}
+
 size_t SQLitePool::getIndex(bool createHandle) {
     while (true) {
-        unique_lock<mutex> lock(_sync);
-        if (_availableHandles.size()) {
-            // Return an existing handle.
-            auto frontIt = _availableHandles.begin();
-            size_t index = *frontIt;
-            _inUseHandles.insert(index);
-            _availableHandles.erase(frontIt);
+        // Fast path: grab a previously-returned handle off the free list. This is a single compare-exchange with no
+        // locking, which matters because every worker and replication thread comes through here.
+        size_t index = 0;
+        if (_popFreeList(index)) {
             SINFO("Returning existing DB handle");
             return index;
-        } else if (_availableHandles.size() + _inUseHandles.size() < (_maxDBs - 1)) {
-            size_t index = _availableHandles.size() + _inUseHandles.size();
-            _inUseHandles.insert(index);
+        }
 
-            // Create a new handle unless we're not supposed to. We unlock here as we're no longer in a position to
-            // change which indices are in use.
-            lock.unlock();
-            if (createHandle) {
-                initializeIndex(index);
+        // Nothing free. If we haven't hit capacity, claim the next sequential slot.
+        size_t allocated = _allocatedCount.load();
+        while (allocated < _maxDBs - 1) {
+            if (_allocatedCount.compare_exchange_weak(allocated, allocated + 1)) {
+                // Create a new handle unless we're not supposed to. We've already claimed the index, so nobody else
+                // can touch this slot.
+                if (createHandle) {
+                    initializeIndex(allocated);
+                }
+                SINFO("Returning new DB handle: " << allocated);
+                return allocated;
             }
-            SINFO("Returning new DB handle: " << index);
+            // `allocated` was reloaded by the failed compare-exchange, try again.
+        }
+
+        // Truly exhausted, block until a handle is returned. We re-check the free list after registering as a
+        // waiter so a handle returned between our check above and here can't be missed.
+        unique_lock<mutex> lock(_sync);
+        _waiters++;
+        if (_popFreeList(index)) {
+            _waiters--;
+            SINFO("Returning existing DB handle");
             return index;
-        } else {
-            // Wait for a handle.
-            SINFO("Waiting for DB handle");
-            _wait.wait(lock);
         }
+        SINFO("Waiting for DB handle");
+        _wait.wait(lock);
+        _waiters--;
     }
 }
 
@@ -77,17 +116,19 @@ SQLite& SQLitePool::initializeIndex(size_t index) {
 }
 
 void SQLitePool::returnToPool(size_t index) {
-    {
+    _pushFreeList(index);
+    SINFO("DB handle returned to pool.");
+
+    // Only touch the mutex if someone's actually blocked. Acquiring it before notifying guarantees the waiter is
+    // either already waiting (and gets woken), or hasn't re-checked the free list yet (and finds our handle).
+    if (_waiters.load()) {
         lock_guard<mutex> lock(_sync);
-        _availableHandles.insert(index);
-        _inUseHandles.erase(index);
-        SINFO("DB handle returned to pool.");
+        _wait.notify_one();
     }
-    _wait.notify_one();
 }
 
 SQLiteScopedHandle::SQLiteScopedHandle(SQLitePool& pool, size_t index) : _pool(pool), _index(index)
-{} 
+{}
 
 SQLiteScopedHandle::~SQLiteScopedHandle() {
     _pool.returnToPool(_index);
@@ -28,10 +28,19 @@ class SQLitePool {
     void returnToPool(size_t index);
 
   private:
-    // Synchronization variables.
+    // Pop/push an index from/to the lock-free free list. `_popFreeList` returns false if the list is empty.
+    bool _popFreeList(size_t& index);
+    void _pushFreeList(size_t index);
+
+    // Synchronization for the exhaustion case only: when every handle is allocated and in use, `getIndex` blocks
+    // here until `returnToPool` frees one. The common checkout/return path never touches this mutex.
     mutex _sync;
     condition_variable _wait;
 
+    // The number of threads currently blocked in `getIndex` waiting for a free handle. Only modified while holding
+    // `_sync`, but read without it in `returnToPool` to decide whether a notify is needed.
+    atomic<size_t> _waiters;
+
     // Internal limit on the number of handles we'll allow. This exists to make sure we don't go over any
     // system-imposed limits on FDs.
     size_t _maxDBs;
@@ -39,9 +48,18 @@ class SQLitePool {
     // Our base object that all others are based upon.
     SQLite _baseDB;
 
-    // These are indexes into `_objects`.
-    set<size_t> _availableHandles;
-    set<size_t> _inUseHandles;
+    // Head of a Treiber stack of free indexes. The low 32 bits are the first free index plus one (0 means empty),
+    // the high 32 bits are a version tag incremented on every successful push or pop, which prevents the classic
+    // ABA problem on the compare-exchange.
+    atomic<uint64_t> _freeListHead;
+
+    // Per-slot "next" links for the free stack, in the same encoding as the head's low 32 bits. A slot's link is
+    // only written while the slot is being pushed, when no other thread can reference it.
+    vector<atomic<uint64_t>> _freeListNext;
+
+    // The number of slots ever handed out. Slots are allocated sequentially until we hit capacity, after which all
+    // checkouts are served from the free list.
+    atomic<size_t> _allocatedCount;
 
     // This is a vector of pointers to all possibly allocated objects.
     vector<SQLite*> _objects;
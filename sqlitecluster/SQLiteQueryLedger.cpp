@@ -0,0 +1,191 @@
+#include <libstuff/SMetrics.h>
+#include "SQLite.h"
+#include "SQLiteQueryLedger.h"
+
+atomic<uint64_t> SQLiteQueryLedger::sampleInterval(128);
+mutex SQLiteQueryLedger::_mutex;
+map<string, SQLiteQueryLedger::Shape> SQLiteQueryLedger::_shapes;
+atomic<uint64_t> SQLiteQueryLedger::_statementCount(0);
+atomic<uint64_t> SQLiteQueryLedger::_lastFlush(0);
+atomic<bool> SQLiteQueryLedger::_plansWanted(false);
+
+// Log lines and status entries truncate the normalized text to this, the same cap the statement tracer uses.
+static const size_t QUERY_SNIPPET_LENGTH = 200;
+
+uint64_t SQLiteQueryLedger::_p99(const vector<uint64_t>& window) {
+    vector<uint64_t> sorted(window);
+    sort(sorted.begin(), sorted.end());
+    return sorted[(sorted.size() * 99) / 100];
+}
+
+void SQLiteQueryLedger::recordStatement(sqlite3_stmt* stmt, uint64_t durationNS) {
+    const uint64_t interval = sampleInterval.load(memory_order_relaxed);
+    if (!interval || _statementCount.fetch_add(1, memory_order_relaxed) % interval) {
+        return;
+    }
+
+    // Aggregate by the normalized text (literals stripped, available because we build with SQLITE_ENABLE_NORMALIZE),
+    // which is the statement's shape: every instance of a query with different values lands in the same row.
+    const char* normalized = sqlite3_normalized_sql(stmt);
+    if (!normalized || !*normalized) {
+        return;
+    }
+
+    // stmt_status counters accumulate across executions of a cached prepared statement, so reset them as we read.
+    // For one-shot statements the numbers are exact; for cached ones each sample covers the executions since that
+    // statement's previous sample, which still attributes the work to the right shape.
+    const uint64_t durationUS = durationNS / 1000;
+    const int64_t vmSteps = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 1);
+    const int64_t fullscanSteps = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+    const int64_t sortSteps = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 1);
+    const int64_t memUsed = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_MEMUSED, 0);
+
+    lock_guard<mutex> lock(_mutex);
+    auto shapeIt = _shapes.find(normalized);
+    if (shapeIt == _shapes.end()) {
+        if (_shapes.size() >= MAX_SHAPES) {
+            // Something (probably generated DDL) is producing unbounded distinct shapes; count rather than grow.
+            static atomic<uint64_t>& overflow = SMetrics::counter("queryLedger.shapeOverflow");
+            overflow++;
+            return;
+        }
+        shapeIt = _shapes.emplace(normalized, Shape()).first;
+    }
+    Shape& shape = shapeIt->second;
+    shape.count++;
+    shape.totalUS += durationUS;
+    shape.maxUS = max(shape.maxUS, durationUS);
+    shape.vmSteps += (uint64_t)max<int64_t>(vmSteps, 0);
+    shape.fullscanSteps += (uint64_t)max<int64_t>(fullscanSteps, 0);
+    shape.sortSteps += (uint64_t)max<int64_t>(sortSteps, 0);
+    shape.memUsed = max(shape.memUsed, memUsed);
+    shape.isWrite = shape.isWrite || !sqlite3_stmt_readonly(stmt);
+
+    // Feed the duration window. The first full window sets the baseline p99; after that every sample recomputes the
+    // live p99 and checks it against the baseline.
+    if (shape.recentUS.size() < WINDOW) {
+        shape.recentUS.push_back(durationUS);
+        if (shape.recentUS.size() == WINDOW) {
+            shape.baselineP99US = _p99(shape.recentUS);
+            shape.lastP99US = shape.baselineP99US;
+        }
+        return;
+    }
+    shape.recentUS[shape.recentNext] = durationUS;
+    shape.recentNext = (shape.recentNext + 1) % WINDOW;
+    shape.lastP99US = _p99(shape.recentUS);
+    if (!shape.regressed && shape.lastP99US * REGRESSION_DEN > shape.baselineP99US * REGRESSION_NUM) {
+        // Warn on the transition, not every sample, and ask capturePlans to record what the planner is doing now.
+        // Trace callbacks may not run queries on the connection that invoked them, so the capture can't happen here.
+        shape.regressed = true;
+        shape.planWanted = true;
+        shape.regressions++;
+        _plansWanted = true;
+        SWARN("Query shape p99 regressed from " << shape.baselineP99US << "us to " << shape.lastP99US << "us: "
+                                                << shapeIt->first.substr(0, QUERY_SNIPPET_LENGTH));
+    } else if (shape.regressed && shape.lastP99US <= shape.baselineP99US) {
+        shape.regressed = false;
+        SINFO("Query shape p99 recovered to " << shape.lastP99US << "us (baseline " << shape.baselineP99US << "us): "
+                                              << shapeIt->first.substr(0, QUERY_SNIPPET_LENGTH));
+    }
+}
+
+void SQLiteQueryLedger::capturePlans(SQLite& db) {
+    // Plan capture runs promptly once a regression flags a shape; the aggregate flush is on its own interval.
+    if (_plansWanted.exchange(false)) {
+        // Copy the flagged shapes' text out, explain without the lock held (the explain is itself a statement, and
+        // its profile callback may want the lock), then store the plans back. The normalized text has unbound `?`
+        // parameters, which is exactly what the planner sees when our prepared statements are planned.
+        list<string> wanted;
+        {
+            lock_guard<mutex> lock(_mutex);
+            for (const auto& pair : _shapes) {
+                if (pair.second.planWanted) {
+                    wanted.push_back(pair.first);
+                }
+            }
+        }
+        for (const string& text : wanted) {
+            string plan = db.explainQueryPlan(text);
+            lock_guard<mutex> lock(_mutex);
+            auto shapeIt = _shapes.find(text);
+            if (shapeIt != _shapes.end()) {
+                shapeIt->second.planWanted = false;
+                shapeIt->second.plan = plan.empty() ? "(won't prepare)" : plan;
+                SINFO("Captured plan for regressed shape '" << text.substr(0, QUERY_SNIPPET_LENGTH) << "': "
+                                                            << SReplace(plan, "\n", " | "));
+            }
+        }
+    }
+
+    // Periodically flush the top shapes to the log, one line per shape, so the ledger survives restarts and feeds
+    // the dashboard without anyone having to poll Status. Rate-limit: only one thread flushes per interval.
+    uint64_t last = _lastFlush.load();
+    uint64_t now = STimeNow();
+    if (now < last + FLUSH_INTERVAL || !_lastFlush.compare_exchange_strong(last, now)) {
+        return;
+    }
+    struct Flush {
+        uint64_t totalUS;
+        string line;
+    };
+    vector<Flush> flushes;
+    {
+        lock_guard<mutex> lock(_mutex);
+        flushes.reserve(_shapes.size());
+        for (const auto& pair : _shapes) {
+            const Shape& shape = pair.second;
+            ostringstream line;
+            line << shape.count << "x total " << shape.totalUS << "us avg " << (shape.totalUS / shape.count)
+                 << "us p99 " << shape.lastP99US << "us vm " << shape.vmSteps << " fullscan " << shape.fullscanSteps
+                 << " sort " << shape.sortSteps << " " << (shape.isWrite ? 'W' : 'R') << " :: "
+                 << pair.first.substr(0, QUERY_SNIPPET_LENGTH);
+            flushes.push_back({shape.totalUS, line.str()});
+        }
+    }
+    sort(flushes.begin(), flushes.end(), [](const Flush& a, const Flush& b) { return a.totalUS > b.totalUS; });
+    size_t reportCount = min(flushes.size(), REPORT_COUNT);
+    for (size_t i = 0; i < reportCount; i++) {
+        SINFO("QueryLedger[" << (i + 1) << "/" << reportCount << "]: " << flushes[i].line);
+    }
+}
+
+STable SQLiteQueryLedger::status() {
+    // Snapshot the shapes and rank by total sampled time, most expensive first.
+    vector<pair<string, Shape>> shapes;
+    {
+        lock_guard<mutex> lock(_mutex);
+        shapes.assign(_shapes.begin(), _shapes.end());
+    }
+    sort(shapes.begin(), shapes.end(),
+         [](const pair<string, Shape>& a, const pair<string, Shape>& b) { return a.second.totalUS > b.second.totalUS; });
+
+    STable result;
+    size_t reportCount = min(shapes.size(), REPORT_COUNT);
+    for (size_t i = 0; i < reportCount; i++) {
+        const Shape& shape = shapes[i].second;
+        STable entry;
+        entry["query"] = shapes[i].first.substr(0, QUERY_SNIPPET_LENGTH);
+        entry["isWrite"] = shape.isWrite ? "true" : "false";
+        entry["sampleCount"] = SToStr(shape.count);
+        entry["totalUS"] = SToStr(shape.totalUS);
+        entry["avgUS"] = SToStr(shape.totalUS / shape.count);
+        entry["maxUS"] = SToStr(shape.maxUS);
+        entry["p99US"] = SToStr(shape.lastP99US);
+        entry["baselineP99US"] = SToStr(shape.baselineP99US);
+        entry["vmSteps"] = SToStr(shape.vmSteps);
+        entry["fullscanSteps"] = SToStr(shape.fullscanSteps);
+        entry["sortSteps"] = SToStr(shape.sortSteps);
+        entry["maxMemUsed"] = SToStr(shape.memUsed);
+        if (shape.regressions) {
+            entry["regressions"] = SToStr(shape.regressions);
+            entry["plan"] = shape.plan;
+        }
+
+        // STable keys render in lexical order, so zero-pad the rank to keep the report most-expensive-first.
+        char rank[8];
+        snprintf(rank, sizeof(rank), "%02zu", i + 1);
+        result[rank] = SComposeJSONObject(entry);
+    }
+    return result;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <libstuff/libstuff.h>
+class SQLite;
+
+// Always-on sampled query telemetry. Finding expensive queries by turning on full query logging destroys the very
+// performance you're trying to measure, so instead we sample 1-in-N completed statements from sqlite's profile trace
+// callback and aggregate them per normalized statement shape (sqlite3_normalized_sql, which strips literals): count,
+// duration, VM/full-scan/sort step counts from sqlite3_stmt_status, and statement memory. Each shape keeps a window
+// of recent sampled durations; the first full window sets a p99 baseline, and when the live p99 runs past double the
+// baseline the shape is flagged and its EXPLAIN QUERY PLAN is captured on the next `capturePlans` pass, so the plan
+// that caused a regression is on record before anyone has to reproduce it. The ledger is served by `Status` requests
+// carrying a `queryLedger` header, and the top shapes are flushed to the log (which is async when -asyncLogging is
+// on) once per flush interval.
+class SQLiteQueryLedger {
+  public:
+    // Sampling interval: one of every N completed statements is recorded. 0 disables the ledger entirely. Set from
+    // the `-queryLedgerSampleRate` command line flag; the default is cheap enough to leave on everywhere.
+    static atomic<uint64_t> sampleInterval;
+
+    // Called from the sqlite profile trace callback for every completed statement. Decides (one relaxed atomic
+    // increment) whether this statement is sampled, and if so folds it into its shape's aggregates. Trace callbacks
+    // may not touch the connection that invoked them, so no queries run here; plan capture for regressed shapes is
+    // deferred to `capturePlans`.
+    static void recordStatement(sqlite3_stmt* stmt, uint64_t durationNS);
+
+    // Captures EXPLAIN QUERY PLAN for any shape flagged as regressed since the last pass (run against the normalized
+    // text, so parameters are unbound, which is exactly what the planner sees for our prepared statements), and
+    // flushes the top shapes by total time to the log once per FLUSH_INTERVAL. Rate-limited internally, so it's safe
+    // to call every pass of a main loop.
+    static void capturePlans(SQLite& db);
+
+    // The top shapes by total sampled time as JSON objects keyed by rank, for the Status handler. Empty when the
+    // ledger is disabled or nothing has been sampled yet.
+    static STable status();
+
+  private:
+    struct Shape {
+        uint64_t count = 0;
+        uint64_t totalUS = 0;
+        uint64_t maxUS = 0;
+        uint64_t vmSteps = 0;
+        uint64_t fullscanSteps = 0;
+        uint64_t sortSteps = 0;
+        int64_t memUsed = 0;
+        bool isWrite = false;
+
+        // Recent sampled durations, a ring once WINDOW entries have accumulated. baselineP99US is set the first time
+        // the window fills; regressed flips when the live p99 crosses REGRESSION_NUM/REGRESSION_DEN times baseline
+        // (and back when it recovers to baseline), so each regression episode warns and captures a plan once.
+        vector<uint64_t> recentUS;
+        size_t recentNext = 0;
+        uint64_t baselineP99US = 0;
+        uint64_t lastP99US = 0;
+        bool regressed = false;
+        bool planWanted = false;
+        uint64_t regressions = 0;
+        string plan;
+    };
+
+    // Window of sampled durations per shape, how many shapes the ledger holds before new ones are dropped (counted
+    // in `queryLedger.shapeOverflow`), how many shapes `status` and the log flush report, and the regression
+    // threshold as a ratio (p99 beyond 2x baseline flags the shape).
+    static const size_t WINDOW = 100;
+    static const size_t MAX_SHAPES = 1000;
+    static const size_t REPORT_COUNT = 50;
+    static const uint64_t REGRESSION_NUM = 2;
+    static const uint64_t REGRESSION_DEN = 1;
+    static const uint64_t FLUSH_INTERVAL = 5 * 60 * STIME_US_PER_S;
+
+    // Computes the p99 of a full window (copies and sorts it; only runs on the 1-in-N sampled path).
+    static uint64_t _p99(const vector<uint64_t>& window);
+
+    static mutex _mutex;
+    static map<string, Shape> _shapes;
+    static atomic<uint64_t> _statementCount;
+    static atomic<uint64_t> _lastFlush;
+
+    // Set when any shape has planWanted, so capturePlans can skip taking the lock at all on the common pass.
+    static atomic<bool> _plansWanted;
+};
@@ -1,16 +1,23 @@
 #include "SQLiteSequentialNotifier.h"
 
 SQLiteSequentialNotifier::RESULT SQLiteSequentialNotifier::waitFor(uint64_t value) {
-    shared_ptr<WaitState> state(nullptr);
+    // Fast path: if the value's already been reached, we're done without taking any locks.
+    if (value <= _value.load()) {
+        return RESULT::COMPLETED;
+    }
+
+    shared_ptr<WaitState> state = make_shared<WaitState>();
+    Shard& shard = _shards[value % SHARD_COUNT];
     {
-        lock_guard<mutex> lock(_internalStateMutex);
-        if (value <= _value) {
+        lock_guard<mutex> lock(shard.shardMutex);
+
+        // Re-check under the shard lock. `notifyThrough` updates `_value` *before* it scans the shards (holding
+        // each shard's lock in turn), so if it raced past our value between the check above and our registration,
+        // we're guaranteed to see the updated `_value` here.
+        if (value <= _value.load()) {
             return RESULT::COMPLETED;
         }
-
-        // Create a new WaitState object and save a shared_ptr to it in `state`.
-        state = make_shared<WaitState>();
-        _valueToPendingThreadMap.emplace(value, state);
+        shard.valueToPendingThreadMap.emplace(value, state);
     }
     while (true) {
         unique_lock<mutex> lock(state->waitingThreadMutex);
@@ -24,66 +31,67 @@ SQLiteSequentialNotifier::RESULT SQLiteSequentialNotifier::waitFor(uint64_t valu
 }
 
 void SQLiteSequentialNotifier::notifyThrough(uint64_t value) {
-    lock_guard<mutex> lock(_internalStateMutex);
-    if (value > _value) {
-        _value = value;
-    }
-    auto lastToDelete = _valueToPendingThreadMap.begin();
-    for (auto it = _valueToPendingThreadMap.begin(); it != _valueToPendingThreadMap.end(); it++) {
-        if (it->first > value)  {
-            // If we've passed our value, there's nothing else to erase, so we can stop.
+    // Advance `_value` first (see the ordering comment in `waitFor`). If it's already at or past `value`, a previous
+    // call covered this whole range, and there's nothing to wake.
+    uint64_t previous = _value.load();
+    while (true) {
+        if (value <= previous) {
+            return;
+        }
+        if (_value.compare_exchange_weak(previous, value)) {
             break;
         }
-
-        // Note that we'll delete this item from the map.
-        lastToDelete++;
-
-        // Make the changes to the state object - mark it complete and notify anyone waiting.
-        lock_guard<mutex> lock(it->second->waitingThreadMutex);
-        it->second->result = RESULT::COMPLETED;
-        it->second->waitingThreadConditionVariable.notify_all();
     }
 
-    // Now we've finished with all of our updates and notifications and can remove everything from our map.
-    // Note that erasing an empty range (i.e., from() begin to begin()) is tested to be a no-op. The documentation I've
-    // fond for multimap is unclear on this, though the docuemtnation for `std::list` specifies:
-    // "The iterator first does not need to be dereferenceable if first==last: erasing an empty range is a no-op."
-    //
-    // I think it's reasonable to assume this is the intention for multimap as well, and in my testing, that was the
-    // case.
-    _valueToPendingThreadMap.erase(_valueToPendingThreadMap.begin(), lastToDelete);
+    // Wake only the waiters whose value has been reached. Values are sharded by modulo, so any shard can contain
+    // them; within a shard the multimap is ordered, so we stop at the first value past ours.
+    for (auto& shard : _shards) {
+        lock_guard<mutex> lock(shard.shardMutex);
+        auto it = shard.valueToPendingThreadMap.begin();
+        while (it != shard.valueToPendingThreadMap.end() && it->first <= value) {
+            // Make the changes to the state object - mark it complete and notify anyone waiting.
+            {
+                lock_guard<mutex> waitLock(it->second->waitingThreadMutex);
+                it->second->result = RESULT::COMPLETED;
+                it->second->waitingThreadConditionVariable.notify_all();
+            }
+            it = shard.valueToPendingThreadMap.erase(it);
+        }
+    }
 }
 
 void SQLiteSequentialNotifier::cancel() {
-    lock_guard<mutex> lock(_internalStateMutex);
     _globalResult = RESULT::CANCELED;
-    for (auto& p : _valueToPendingThreadMap) {
-        lock_guard<mutex> lock(p.second->waitingThreadMutex);
-        p.second->result = RESULT::CANCELED;
-        p.second->waitingThreadConditionVariable.notify_all();
+    for (auto& shard : _shards) {
+        lock_guard<mutex> lock(shard.shardMutex);
+        for (auto& p : shard.valueToPendingThreadMap) {
+            lock_guard<mutex> waitLock(p.second->waitingThreadMutex);
+            p.second->result = RESULT::CANCELED;
+            p.second->waitingThreadConditionVariable.notify_all();
+        }
+        shard.valueToPendingThreadMap.clear();
     }
-    _valueToPendingThreadMap.clear();
     _value = 0;
 }
 
 void SQLiteSequentialNotifier::checkpointRequired(SQLite& db) {
-    lock_guard<mutex> lock(_internalStateMutex);
     _globalResult = RESULT::CHECKPOINT_REQUIRED;
-    for (auto& p : _valueToPendingThreadMap) {
-        lock_guard<mutex> lock(p.second->waitingThreadMutex);
-        p.second->result = RESULT::CHECKPOINT_REQUIRED;
-        p.second->waitingThreadConditionVariable.notify_all();
+    for (auto& shard : _shards) {
+        lock_guard<mutex> lock(shard.shardMutex);
+        for (auto& p : shard.valueToPendingThreadMap) {
+            lock_guard<mutex> waitLock(p.second->waitingThreadMutex);
+            p.second->result = RESULT::CHECKPOINT_REQUIRED;
+            p.second->waitingThreadConditionVariable.notify_all();
+        }
+        shard.valueToPendingThreadMap.clear();
     }
-    _valueToPendingThreadMap.clear();
 }
 
 void SQLiteSequentialNotifier::checkpointComplete(SQLite& db) {
-    lock_guard<mutex> lock(_internalStateMutex);
     _globalResult = RESULT::UNKNOWN;
 }
 
 void SQLiteSequentialNotifier::reset() {
-    lock_guard<mutex> lock(_internalStateMutex);
     _globalResult = RESULT::UNKNOWN;
     _value = 0;
 }
@@ -31,12 +31,18 @@ class SQLiteSequentialNotifier : public SQLite::CheckpointRequiredListener {
     SQLiteSequentialNotifier() : _value(0), _globalResult(RESULT::UNKNOWN) {}
 
     // Blocks until `_value` meets or exceeds `value`, unless an exceptional case (CANCELED, CHEKPOINT_REQUIRED) is
-    // hit, and returns the corresponding RESULT.
+    // hit, and returns the corresponding RESULT. The already-notified fast path is a single atomic load.
     SQLiteSequentialNotifier::RESULT waitFor(uint64_t value);
 
-    // Causes any threads waiting for a value up to and including `value` to return `true`.
+    // Causes any threads waiting for a value up to and including `value` to return `true`. This covers the whole
+    // range at once, so a caller that has applied several commits can make one call with the highest value rather
+    // than one per commit; calls with values that have already been notified return without taking any locks.
     void notifyThrough(uint64_t value);
 
+    // The highest value notified so far; a single atomic load. Lets a caller ask "has this already happened?"
+    // without blocking (e.g., whether the leader has reported committing a given transaction yet).
+    uint64_t currentValue() const { return _value.load(); }
+
     // Causes any thread waiting for any value to return `false`. Also, any future calls to `waitFor` will return
     // `false` until `reset` is called.
     void cancel();
@@ -61,11 +67,20 @@ class SQLiteSequentialNotifier : public SQLite::CheckpointRequiredListener {
         RESULT result;
     };
 
-    mutex _internalStateMutex;
-    multimap<uint64_t, shared_ptr<WaitState>> _valueToPendingThreadMap;
-    uint64_t _value;
+    // Pending waiters are sharded by target value so that concurrent `waitFor` registrations (every parallel
+    // replication thread does one per transaction) don't all serialize on a single mutex. Each waiter registers its
+    // exact target value, and `notifyThrough` only wakes the waiters whose value has actually been reached.
+    static const size_t SHARD_COUNT = 16;
+    struct Shard {
+        mutex shardMutex;
+        multimap<uint64_t, shared_ptr<WaitState>> valueToPendingThreadMap;
+    };
+    Shard _shards[SHARD_COUNT];
+
+    // The highest value notified so far. Atomic so `waitFor` and `notifyThrough` can check it without locking.
+    atomic<uint64_t> _value;
 
     // If there is a global result for all pending operations (i.e., they've been canceled or a checkpoint needs to
     // happen), that is stored here.
-    RESULT _globalResult;
+    atomic<RESULT> _globalResult;
 };
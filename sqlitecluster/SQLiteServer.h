@@ -1,4 +1,5 @@
 #pragma once
+class SQLite;
 class SQLiteCommand;
 
 // This is an abstract class to define the interface for a "server" that a SQLiteNode can communicate with to process
@@ -23,4 +24,9 @@ class SQLiteServer : public STCPServer {
 
     // When a node connects to the cluster, this function will be called on the sync thread.
     virtual void onNodeLogin(SQLiteNode::Peer* peer) = 0;
+
+    // Called on the sync thread by an SQLiteNode whose standup has been approved, just before it switches to LEADING.
+    // The node blocks here, so the server can warm caches (the page cache is typically cold after a failover) before
+    // any leader traffic arrives. Default is to do nothing.
+    virtual void onPrepareToLead(SQLite& db) { }
 };
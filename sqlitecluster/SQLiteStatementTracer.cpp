@@ -0,0 +1,63 @@
+#include "SQLiteStatementTracer.h"
+
+atomic<bool> SQLiteStatementTracer::enabled(false);
+mutex SQLiteStatementTracer::_mutex;
+vector<SQLiteStatementTracer::Trace> SQLiteStatementTracer::_traces;
+
+void SQLiteStatementTracer::record(vector<Statement>&& statements, uint64_t firstWriteUS, uint64_t commitLockUS,
+                                   uint64_t totalUS, size_t overflowCount, bool committed) {
+    // The write position is held from the first write through the end of the transaction. A transaction that never
+    // wrote anything (and never took the commit lock) held nothing worth reporting.
+    if (!firstWriteUS && !commitLockUS) {
+        return;
+    }
+    uint64_t writeHoldUS = totalUS - (firstWriteUS ? firstWriteUS : commitLockUS);
+    uint64_t commitLockHoldUS = commitLockUS ? totalUS - commitLockUS : 0;
+
+    lock_guard<mutex> lock(_mutex);
+    if (_traces.size() >= KEEP_COUNT && writeHoldUS <= _traces.back().writeHoldUS) {
+        return;
+    }
+    auto insertAt = _traces.begin();
+    while (insertAt != _traces.end() && insertAt->writeHoldUS >= writeHoldUS) {
+        insertAt++;
+    }
+    _traces.emplace(insertAt, Trace{writeHoldUS, commitLockHoldUS, totalUS, overflowCount, committed, move(statements)});
+    if (_traces.size() > KEEP_COUNT) {
+        _traces.pop_back();
+    }
+}
+
+STable SQLiteStatementTracer::status() {
+    STable result;
+    lock_guard<mutex> lock(_mutex);
+    for (size_t i = 0; i < _traces.size(); i++) {
+        const Trace& trace = _traces[i];
+
+        // One line per statement: offset into the transaction, duration, read or write, and the (truncated) text,
+        // i.e., "+12.3ms 45.6ms W UPDATE jobs SET ...". The W line with the earliest offset is where this
+        // transaction started holding the write position; everything after it extended the hold.
+        list<string> statements;
+        for (const Statement& statement : trace.statements) {
+            char timing[64];
+            snprintf(timing, sizeof(timing), "+%.1fms %.1fms %c ", (double)statement.startUS / 1000.0,
+                     (double)statement.durationUS / 1000.0, statement.isWrite ? 'W' : 'R');
+            statements.push_back(timing + statement.query);
+        }
+        STable entry;
+        entry["writeHoldMS"] = SToStr(trace.writeHoldUS / 1000);
+        entry["commitLockHoldMS"] = SToStr(trace.commitLockHoldUS / 1000);
+        entry["totalMS"] = SToStr(trace.totalUS / 1000);
+        entry["committed"] = trace.committed ? "true" : "false";
+        if (trace.overflowCount) {
+            entry["untracedStatementCount"] = SToStr(trace.overflowCount);
+        }
+        entry["statements"] = SComposeJSONArray(statements);
+
+        // STable keys render in lexical order, so zero-pad the rank to keep the report worst-first.
+        char rank[8];
+        snprintf(rank, sizeof(rank), "%02zu", i + 1);
+        result[rank] = SComposeJSONObject(entry);
+    }
+    return result;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <libstuff/libstuff.h>
+
+// An analysis mode for finding out where the lock hold time of our multi-statement transactions actually goes.
+// Plugin transactions interleave reads and writes such that write locks are held across slow reads (i.e., FinishJob
+// reads parent state after its first UPDATE), and without data the hold time is a black box. With
+// `-enableStatementTrace`, every write transaction records its statement sequence -- each statement's offset within
+// the transaction, its duration, and whether it read or wrote -- plus its two lock escalation points: the first
+// write (where BEGIN CONCURRENT starts taking page locks, making the transaction conflictable) and the commit-lock
+// acquisition (where it starts serializing every other committer). `record` retains the transactions that held the
+// write position longest, and `status` renders them for `Status` requests carrying a `statementTrace` header, which
+// is the data we need to decide which reads to hoist ahead of the first write when restructuring a plugin.
+class SQLiteStatementTracer {
+  public:
+    // Global switch, read per-transaction at BEGIN; set from the `-enableStatementTrace` command line flag.
+    static atomic<bool> enabled;
+
+    // One executed statement within a traced transaction. `startUS` is the offset from the transaction's BEGIN.
+    // Statements served from the query caches are omitted; they don't meaningfully extend any lock hold.
+    struct Statement {
+        uint64_t startUS = 0;
+        uint64_t durationUS = 0;
+        bool isWrite = false;
+        string query;
+    };
+
+    // How much of each statement's text we keep, how many statements one transaction can record (SQLite counts the
+    // overflow past the cap rather than growing unbounded), and how many worst transactions the report retains.
+    static const size_t QUERY_SNIPPET_LENGTH = 200;
+    static const size_t MAX_STATEMENTS = 200;
+    static const size_t KEEP_COUNT = 10;
+
+    // Submits a completed write transaction's trace. `firstWriteUS` and `commitLockUS` are the escalation points as
+    // offsets from BEGIN (0 = never reached), `totalUS` is BEGIN through COMMIT/ROLLBACK, and `overflowCount` is
+    // how many statements ran past MAX_STATEMENTS. Kept only if the transaction's write-position hold time (first
+    // write through the end) makes the current top KEEP_COUNT.
+    static void record(vector<Statement>&& statements, uint64_t firstWriteUS, uint64_t commitLockUS,
+                       uint64_t totalUS, size_t overflowCount, bool committed);
+
+    // The retained transactions as JSON objects keyed by rank, worst hold first, for the Status handler. Empty when
+    // tracing is off or nothing has been recorded yet.
+    static STable status();
+
+  private:
+    struct Trace {
+        uint64_t writeHoldUS;
+        uint64_t commitLockHoldUS;
+        uint64_t totalUS;
+        size_t overflowCount;
+        bool committed;
+        vector<Statement> statements;
+    };
+
+    static mutex _mutex;
+    static vector<Trace> _traces; // Sorted by writeHoldUS, worst first.
+};
@@ -34,6 +34,11 @@ class ClusterTester {
     // Stops a given node.
     void stopNode(size_t index);
 
+    // Runs BedrockTester's load driver against the node at `index`. Pointing this at a follower makes every write in
+    // the mix escalate to leader, which is the escalation-heavy production shape.
+    typename T::LoadResult runLoadTest(size_t index, const vector<typename T::LoadCommand>& mix, int clientThreads,
+                                       int socketsPerThread, uint64_t durationUS);
+
   private:
 
     // The number of nodes in the cluster.
@@ -132,6 +137,9 @@ ClusterTester<T>::ClusterTester(ClusterSize size,
             {"-peerList", peerString},
             {"-plugins", pluginsToLoad},
             {"-overrideProcessName", "bedrock" + to_string(nodePort)},
+            // Settle fast: don't wait out the multi-minute production election backoff when a peer is slow to
+            // connect. Tests that want the production timing can override this.
+            {"-firstTimeoutUS", "500000"},
         };
 
         // Now, if any args were supplied, we'll use those instead of these ones (note that this overwrites our
@@ -211,6 +219,13 @@ void ClusterTester<T>::stopNode(size_t index)
     next(_cluster.begin(), index)->stopServer();
 }
 
+template <typename T>
+typename T::LoadResult ClusterTester<T>::runLoadTest(size_t index, const vector<typename T::LoadCommand>& mix,
+                                                     int clientThreads, int socketsPerThread, uint64_t durationUS)
+{
+    return next(_cluster.begin(), index)->runLoadTest(mix, clientThreads, socketsPerThread, durationUS);
+}
+
 template <typename T>
 string ClusterTester<T>::startNode(size_t index)
 {
@@ -35,7 +35,9 @@ int main(int argc, char* argv[]) {
     set<string> exclude;
     list<string> before;
     list<string> after;
-    int threads = 1;
+    // Each fixture stands up a whole cluster (three servers plus their sync and worker threads), so default to a
+    // quarter of the cores rather than one worker per core. `-threads 1` gets the old serial run.
+    int threads = max(1, (int)thread::hardware_concurrency() / 4);
     int repeatCount = 1;
 
     if (args.isSet("-duplicateRequests")) {
@@ -83,6 +83,7 @@ unique_ptr<BedrockCommand> BedrockPlugin_TestPlugin::getCommand(SQLiteCommand&&
         "generateassertpeek",
         "preventattach",
         "chainedrequest",
+        "continuationchainedrequest",
         "ineffectiveUpdate",
         "exceptioninprocess",
         "generatesegfaultprocess",
@@ -141,6 +142,27 @@ void TestPluginCommand::reset(BedrockCommand::STAGE stage) {
     BedrockCommand::reset(stage);
 };
 
+void TestPluginCommand::continuationChainStep(list<string> remainingURLs, string results) {
+    if (remainingURLs.empty()) {
+        // Chain's done. Leave the accumulated results for `process` and don't suspend again.
+        chainedHTTPResponseContent = move(results);
+        return;
+    }
+    SData newRequest("GET / HTTP/1.1");
+    string host = remainingURLs.front();
+    remainingURLs.pop_front();
+    newRequest["Host"] = host;
+    SHTTPSManager::Transaction* transaction = plugin().httpsManager->send("https://" + host + "/", newRequest);
+    httpsRequests.push_back(transaction);
+
+    // Capturing `this` is safe: the continuation lives on the command itself, so it can't outlive it.
+    continuation = [this, transaction, remainingURLs = move(remainingURLs), results = move(results)](SQLite& db) mutable {
+        continuationChainStep(move(remainingURLs),
+                              results + transaction->fullRequest["Host"] + ":" + to_string(transaction->response) + "\n");
+        return false;
+    };
+}
+
 bool BedrockPlugin_TestPlugin::preventAttach() {
     return shouldPreventAttach;
 }
@@ -294,6 +316,12 @@ bool TestPluginCommand::peek(SQLite& db) {
             // case
             return false;
         }
+    } else if (SStartsWith(request.methodLine, "continuationchainedrequest")) {
+        // The same serial chain as `chainedrequest`, written against the suspendable-command API: each step's state
+        // is the captures of the continuation it arms, so nothing is re-derived and `peek` never re-runs. `peek`
+        // just kicks the chain off.
+        continuationChainStep(SParseList(urls), "");
+        return false;
     } else if (request.methodLine == "testescalate") {
         string serverState = SQLiteNode::stateName(plugin().server.getState());
         string statString = "Peeking testescalate (" + serverState + ")\n";
@@ -407,7 +435,7 @@ void TestPluginCommand::process(SQLite& db) {
     } else if (SStartsWith(request.methodLine, "ineffectiveUpdate")) {
         // This command does nothing on purpose so that we can run it in 10x mode and verify it replicates OK.
         return;
-    } else if (SStartsWith(request.methodLine, "chainedrequest")) {
+    } else if (SStartsWith(request.methodLine, "chainedrequest") || SStartsWith(request.methodLine, "continuationchainedrequest")) {
         // Note that we eventually got to process, though we write nothing to the DB.
         response.content = chainedHTTPResponseContent + "PROCESSED\n";
     } else if (request.methodLine == "testescalate") {
@@ -45,6 +45,11 @@ class TestPluginCommand : public BedrockCommand {
   private:
     BedrockPlugin_TestPlugin& plugin() { return static_cast<BedrockPlugin_TestPlugin&>(*_plugin); }
 
+    // One step of `continuationchainedrequest`: starts a request for the first URL and arms a continuation that
+    // records its result and recurses for the rest. The chain's whole state lives in the continuation's captures
+    // (compare the member variables below, which exist to carry `chainedrequest`'s state across `repeek` calls).
+    void continuationChainStep(list<string> remainingURLs, string results);
+
     bool pendingResult;
     string chainedHTTPResponseContent;
     string urls;
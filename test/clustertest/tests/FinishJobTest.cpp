@@ -257,8 +257,8 @@ struct FinishJobTest : tpunit::TestFixture {
         SQResult result;
         list<string> ids = {parentID, finishedChildID, cancelledChildID};
         clusterTester->getTester(0).readDB("SELECT jobID, state FROM jobs WHERE jobID IN(" + SComposeList(ids) + ");", result);
-        ASSERT_EQUAL(result.rows.size(), 3);
-        for (auto& row : result.rows) {
+        ASSERT_EQUAL(result.size(), 3);
+        for (const auto& row : result) {
             if (row[0] == parentID) {
                 ASSERT_EQUAL(row[1], "PAUSED");
             } else if (row[0] == finishedChildID) {
@@ -329,7 +329,7 @@ struct FinishJobTest : tpunit::TestFixture {
         // Get the nextRun value
         SQResult result;
         clusterTester->getTester(0).readDB("SELECT nextRun FROM jobs WHERE jobID = " + jobID + ";", result);
-        string originalNextRun = result[0][0];
+        string originalNextRun(result[0][0]);
 
         // Get the job
         command.clear();
@@ -346,7 +346,7 @@ struct FinishJobTest : tpunit::TestFixture {
 
         // Assert the new nextRun time is 5 seconds after the original nextRun time
         clusterTester->getTester(0).readDB("SELECT nextRun FROM jobs WHERE jobID = " + jobID + ";", result);
-        time_t currentNextRunTime = JobTestHelper::getTimestampForDateTimeString(result[0][0]);
+        time_t currentNextRunTime = JobTestHelper::getTimestampForDateTimeString(string(result[0][0]));
         time_t originalNextRunTime = JobTestHelper::getTimestampForDateTimeString(originalNextRun);
         ASSERT_EQUAL(difftime(currentNextRunTime, originalNextRunTime), 5);
     }
@@ -375,8 +375,8 @@ struct FinishJobTest : tpunit::TestFixture {
         // Confirm nextRun is in 1 hour from the created time
         SQResult result;
         clusterTester->getTester(0).readDB("SELECT lastRun, nextRun FROM jobs WHERE jobID = " + jobID + ";", result);
-        time_t createdTime = JobTestHelper::getTimestampForDateTimeString(result[0][0]);
-        time_t nextRunTime = JobTestHelper::getTimestampForDateTimeString(result[0][1]);
+        time_t createdTime = JobTestHelper::getTimestampForDateTimeString(string(result[0][0]));
+        time_t nextRunTime = JobTestHelper::getTimestampForDateTimeString(string(result[0][1]));
         ASSERT_EQUAL(difftime(nextRunTime, createdTime), 3600);
     }
 
@@ -438,9 +438,9 @@ struct FinishJobTest : tpunit::TestFixture {
         clusterTester->getTester(0).readDB("SELECT lastRun, nextRun FROM jobs WHERE jobID = " + jobID + ";", result);
         struct tm tm1;
         struct tm tm2;
-        strptime(result[0][0].c_str(), "%Y-%m-%d %H:%M:%S", &tm1);
+        strptime(string(result[0][0]).c_str(), "%Y-%m-%d %H:%M:%S", &tm1);
         time_t createdTime = mktime(&tm1);
-        strptime(result[0][1].c_str(), "%Y-%m-%d %H:%M:%S", &tm2);
+        strptime(string(result[0][1]).c_str(), "%Y-%m-%d %H:%M:%S", &tm2);
         time_t nextRunTime = mktime(&tm2);
         ASSERT_EQUAL(difftime(nextRunTime, createdTime), 3600);
     }
@@ -499,9 +499,9 @@ struct FinishJobTest : tpunit::TestFixture {
         clusterTester->getTester(0).readDB("SELECT lastRun, nextRun FROM jobs WHERE jobID = " + jobID + ";", result);
         struct tm tm1;
         struct tm tm2;
-        strptime(result[0][0].c_str(), "%Y-%m-%d %H:%M:%S", &tm1);
+        strptime(string(result[0][0]).c_str(), "%Y-%m-%d %H:%M:%S", &tm1);
         time_t createdTime = mktime(&tm1);
-        strptime(result[0][1].c_str(), "%Y-%m-%d %H:%M:%S", &tm2);
+        strptime(string(result[0][1]).c_str(), "%Y-%m-%d %H:%M:%S", &tm2);
         time_t nextRunTime = mktime(&tm2);
         ASSERT_EQUAL(difftime(nextRunTime, createdTime), 3600);
     }
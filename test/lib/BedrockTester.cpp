@@ -1,5 +1,10 @@
 #include "BedrockTester.h"
+#include <fcntl.h>
+#include <sys/ioctl.h>
 #include <sys/wait.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
 
 // Define static vars.
 string BedrockTester::defaultDBFile; // Unused, exists for backwards compatibility.
@@ -25,6 +30,80 @@ string BedrockTester::getTempFileName(string prefix) {
     return buffer;
 }
 
+bool BedrockTester::cloneFile(const string& src, const string& dst) {
+    int in = open(src.c_str(), O_RDONLY);
+    if (in == -1) {
+        return false;
+    }
+    int out = open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (out == -1) {
+        close(in);
+        return false;
+    }
+#ifdef FICLONE
+    // Try a copy-on-write reflink first. This shares blocks with the source, so it's constant-time regardless of DB
+    // size, but only works on filesystems that support it (btrfs, XFS) — fall through to a plain copy if it fails.
+    if (ioctl(out, FICLONE, in) == 0) {
+        close(in);
+        close(out);
+        return true;
+    }
+#endif
+    bool success = true;
+    char buffer[65536];
+    ssize_t bytes;
+    while ((bytes = ::read(in, buffer, sizeof(buffer))) > 0) {
+        if (::write(out, buffer, bytes) != bytes) {
+            success = false;
+            break;
+        }
+    }
+    if (bytes < 0) {
+        success = false;
+    }
+    close(in);
+    close(out);
+    return success;
+}
+
+// Cache of template DBs built this run, keyed by their initialization SQL. The destructor cleans the files up at
+// process exit.
+struct TemplateDBCache {
+    ~TemplateDBCache() {
+        for (auto& row : files) {
+            unlink(row.second.c_str());
+        }
+    }
+    mutex m;
+    map<string, string> files;
+};
+static TemplateDBCache _templateDBs;
+
+string BedrockTester::_templateDB(const list<string>& queries) {
+    string key = SComposeList(queries, "\n");
+    lock_guard<mutex> lock(_templateDBs.m);
+    auto it = _templateDBs.files.find(key);
+    if (it != _templateDBs.files.end()) {
+        return it->second;
+    }
+
+    // First tester with this initialization builds the template. We don't use SQLite here, because we specifically
+    // want to avoid dealing with journal tables.
+    string fileName = getTempFileName("template_");
+    sqlite3* db = nullptr;
+    sqlite3_initialize();
+    sqlite3_open_v2(fileName.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NULL);
+    for (const string& query : queries) {
+        int error = sqlite3_exec(db, query.c_str(), 0, 0, 0);
+        if (error) {
+            cout << "Template Init Query: " << query << ", FAILED. Error: " << error << endl;
+        }
+    }
+    SASSERT(!sqlite3_close(db));
+    _templateDBs.files.emplace(key, fileName);
+    return fileName;
+}
+
 string BedrockTester::getServerName() {
     for (auto location : locations) {
         if (SFileExists(location)) {
@@ -117,24 +196,30 @@ BedrockTester::BedrockTester(int threadID, const map<string, string>& args,
     
     _controlAddr = _args["-controlPort"];
 
-    // If the DB file doesn't exist, create it.
-    if (!SFileExists(_dbName)) {
-        SFileSave(_dbName, "");
-    }
-
-    // Run any supplied queries on the DB.
-    // We don't use SQLite here, because we specifically want to avoid dealing with journal tables.
-    if (queries.size()) {
-        sqlite3* _db;
-        sqlite3_initialize();
-        sqlite3_open_v2(_dbName.c_str(), &_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NULL);
-        for (string query : queries) {
-            int error = sqlite3_exec(_db, query.c_str(), 0, 0, 0);
-            if (error) {
-                cout << "Init Query: " << query << ", FAILED. Error: " << error << endl;
+    // When we generated the DB file ourselves and there are initialization queries, run them once into a per-suite
+    // template DB and clone that for this tester, rather than re-running the queries for every node of every test.
+    if (queries.size() && !args.count("-db")) {
+        SASSERT(cloneFile(_templateDB(queries), _dbName));
+    } else {
+        // If the DB file doesn't exist, create it.
+        if (!SFileExists(_dbName)) {
+            SFileSave(_dbName, "");
+        }
+
+        // Run any supplied queries on the DB.
+        // We don't use SQLite here, because we specifically want to avoid dealing with journal tables.
+        if (queries.size()) {
+            sqlite3* _db;
+            sqlite3_initialize();
+            sqlite3_open_v2(_dbName.c_str(), &_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NULL);
+            for (string query : queries) {
+                int error = sqlite3_exec(_db, query.c_str(), 0, 0, 0);
+                if (error) {
+                    cout << "Init Query: " << query << ", FAILED. Error: " << error << endl;
+                }
             }
+            SASSERT(!sqlite3_close(_db));
         }
-        SASSERT(!sqlite3_close(_db));
     }
     if (startImmediately) {
         startServer();
@@ -509,6 +594,191 @@ vector<SData> BedrockTester::executeWaitMultipleData(vector<SData> requests, int
     return results;
 }
 
+bool BedrockTester::LoadResult::meetsThresholds(double minCommandsPerSecond, uint64_t maxP99US, double maxFailureRate) const {
+    bool passed = true;
+    if (minCommandsPerSecond && commandsPerSecond < minCommandsPerSecond) {
+        cout << "Load test below throughput threshold: " << commandsPerSecond << " commands/sec, required "
+             << minCommandsPerSecond << "." << endl;
+        passed = false;
+    }
+    if (maxP99US && p99US > maxP99US) {
+        cout << "Load test over p99 latency threshold: " << p99US << "us, allowed " << maxP99US << "us." << endl;
+        passed = false;
+    }
+    double failureRate = commandsSent ? (double)failures / (double)commandsSent : 0.0;
+    if (maxFailureRate >= 0.0 && failureRate > maxFailureRate) {
+        cout << "Load test over failure rate threshold: " << failures << "/" << commandsSent << " failed, allowed rate "
+             << maxFailureRate << "." << endl;
+        passed = false;
+    }
+    return passed;
+}
+
+BedrockTester::LoadResult BedrockTester::runLoadTest(const vector<LoadCommand>& mix, int clientThreads,
+                                                     int socketsPerThread, uint64_t durationUS) {
+    // Build the cumulative weight table for weighted command selection.
+    vector<double> cumulativeWeights;
+    double totalWeight = 0.0;
+    for (const LoadCommand& command : mix) {
+        totalWeight += command.weight;
+        cumulativeWeights.push_back(totalWeight);
+    }
+
+    // Shared between client threads.
+    atomic<uint64_t> sequence(0);
+    mutex resultsMutex;
+    LoadResult result;
+    vector<uint64_t> latencies;
+
+    uint64_t start = STimeNow();
+    uint64_t deadline = start + durationUS;
+    list<thread> threads;
+    for (int threadNum = 0; threadNum < clientThreads; threadNum++) {
+        threads.emplace_back([&]() {
+            // Each socket carries at most one command at a time; the thread sends on every socket, then collects
+            // every response, so it keeps `socketsPerThread` commands in flight.
+            struct SocketState {
+                int fd = -1;
+                uint64_t sentAt = 0;
+                bool inFlight = false;
+                string verb;
+                SFastBuffer recvBuffer;
+            };
+            vector<SocketState> sockets(socketsPerThread);
+            vector<uint64_t> myLatencies;
+            map<string, uint64_t> myCounts;
+            uint64_t mySent = 0;
+            uint64_t myFailures = 0;
+
+            while (STimeNow() < deadline) {
+                // Send one command on each socket.
+                for (SocketState& s : sockets) {
+                    s.inFlight = false;
+                    if (s.fd < 0) {
+                        s.fd = S_socket(_serverAddr, true, false, true);
+                        if (s.fd == -1) {
+                            s.fd = -1;
+                            continue;
+                        }
+                    }
+
+                    // Pick a command from the mix by weight.
+                    double roll = totalWeight * ((double)SRandom::rand64() / (double)UINT64_MAX);
+                    size_t pick = 0;
+                    while (pick + 1 < cumulativeWeights.size() && roll >= cumulativeWeights[pick]) {
+                        pick++;
+                    }
+                    SData request = mix[pick].makeRequest ? mix[pick].makeRequest(sequence++) : mix[pick].request;
+                    s.verb = request.getVerb();
+                    s.sentAt = STimeNow();
+                    mySent++;
+
+                    SFastBuffer sendBuffer(request.serialize());
+                    bool sendFailed = false;
+                    while (sendBuffer.size()) {
+                        if (!S_sendconsume(s.fd, sendBuffer)) {
+                            sendFailed = true;
+                            break;
+                        }
+                    }
+                    if (sendFailed) {
+                        ::shutdown(s.fd, SHUT_RDWR);
+                        ::close(s.fd);
+                        s.fd = -1;
+                        myFailures++;
+                        continue;
+                    }
+                    s.inFlight = true;
+                }
+
+                // Collect the responses.
+                for (SocketState& s : sockets) {
+                    if (!s.inFlight) {
+                        continue;
+                    }
+                    s.recvBuffer.clear();
+                    string methodLine, content;
+                    STable headers;
+                    bool failed = false;
+                    while (!SParseHTTP(s.recvBuffer.c_str(), s.recvBuffer.size(), methodLine, headers, content)) {
+                        pollfd readSock;
+                        readSock.fd = s.fd;
+                        readSock.events = POLLIN | POLLHUP;
+                        readSock.revents = 0;
+                        poll(&readSock, 1, 1000);
+                        if (readSock.revents & POLLIN) {
+                            if (!S_recvappend(s.fd, s.recvBuffer)) {
+                                failed = true;
+                                break;
+                            }
+                        } else if (readSock.revents & POLLHUP) {
+                            failed = true;
+                            break;
+                        } else if (s.sentAt + 60'000'000 < STimeNow()) {
+                            // Nothing in a minute; give up on this command.
+                            failed = true;
+                            break;
+                        }
+                    }
+
+                    if (failed) {
+                        ::shutdown(s.fd, SHUT_RDWR);
+                        ::close(s.fd);
+                        s.fd = -1;
+                        myFailures++;
+                    } else if (!SStartsWith(methodLine, "2")) {
+                        myFailures++;
+                    } else {
+                        myLatencies.push_back(STimeNow() - s.sentAt);
+                        myCounts[s.verb]++;
+                        if (headers["Connection"] == "close") {
+                            ::shutdown(s.fd, SHUT_RDWR);
+                            ::close(s.fd);
+                            s.fd = -1;
+                        }
+                    }
+                }
+            }
+
+            // Close whatever's still open.
+            for (SocketState& s : sockets) {
+                if (s.fd >= 0) {
+                    ::shutdown(s.fd, SHUT_RDWR);
+                    ::close(s.fd);
+                }
+            }
+
+            // Merge this thread's numbers into the shared result.
+            SAUTOLOCK(resultsMutex);
+            result.commandsSent += mySent;
+            result.failures += myFailures;
+            latencies.insert(latencies.end(), myLatencies.begin(), myLatencies.end());
+            for (const auto& count : myCounts) {
+                result.countByVerb[count.first] += count.second;
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+
+    // Summarize.
+    result.durationUS = STimeNow() - start;
+    double seconds = (double)result.durationUS / STIME_US_PER_S;
+    result.commandsPerSecond = seconds ? (double)latencies.size() / seconds : 0.0;
+    if (!latencies.empty()) {
+        sort(latencies.begin(), latencies.end());
+        result.p50US = latencies[latencies.size() * 50 / 100];
+        result.p90US = latencies[min(latencies.size() - 1, latencies.size() * 90 / 100)];
+        result.p99US = latencies[min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        result.maxUS = latencies.back();
+    }
+    cout << "Load test: " << result.commandsSent << " sent, " << result.failures << " failed, "
+         << result.commandsPerSecond << " commands/sec, latency p50/p90/p99/max (us): " << result.p50US << "/"
+         << result.p90US << "/" << result.p99US << "/" << result.maxUS << "." << endl;
+    return result;
+}
+
 SQLite& BedrockTester::getSQLiteDB()
 {
     if (!_db) {
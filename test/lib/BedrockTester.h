@@ -12,6 +12,11 @@ class BedrockTester {
     // Generate a temporary filename for a test DB, with an optional prefix.
     static string getTempFileName(string prefix = "");
 
+    // Copies `src` to `dst`, using a copy-on-write reflink where the filesystem supports it (so cloning an
+    // initialized template DB for each node is nearly free), and falling back to a plain copy where it doesn't.
+    // Returns false if the copy failed.
+    static bool cloneFile(const string& src, const string& dst);
+
     // Returns the name of the server binary, by finding the first path that exists in `locations`.
     static string getServerName();
 
@@ -73,6 +78,43 @@ class BedrockTester {
     // If the response method line doesn't begin with the expected result, throws.
     STable executeWaitVerifyContentTable(SData request, const string& expectedResult = "200");
 
+    // One entry in a load-test command mix: a prototype request and its relative weight. If `makeRequest` is set,
+    // it's called with a global sequence number to build each request instead of reusing the prototype, for commands
+    // that need unique values (e.g., unique job names).
+    struct LoadCommand {
+        SData request;
+        double weight = 1.0;
+        function<SData(uint64_t sequence)> makeRequest;
+    };
+
+    // Aggregated outcome of `runLoadTest`.
+    struct LoadResult {
+        uint64_t commandsSent = 0;
+        uint64_t failures = 0; // Disconnects, timeouts, and non-2xx responses.
+        uint64_t durationUS = 0;
+        double commandsPerSecond = 0.0;
+
+        // Latency percentiles across all completed commands, in microseconds.
+        uint64_t p50US = 0;
+        uint64_t p90US = 0;
+        uint64_t p99US = 0;
+        uint64_t maxUS = 0;
+
+        // Completed commands per verb, to confirm the mix came out as weighted.
+        map<string, uint64_t> countByVerb;
+
+        // Pass/fail gate for CI: prints a line for each violated threshold and returns false if any were. A zero
+        // `minCommandsPerSecond` or `maxP99US` is skipped; the failure rate is always checked (the default allows no
+        // failures at all).
+        bool meetsThresholds(double minCommandsPerSecond, uint64_t maxP99US = 0, double maxFailureRate = 0.0) const;
+    };
+
+    // Drives a weighted command mix at the server from `clientThreads` threads for `durationUS`. Each thread
+    // multiplexes `socketsPerThread` sockets: it sends one command on every socket, then collects all the responses,
+    // so it keeps that many commands in flight at once. Returns throughput and latency percentiles; commands that
+    // fail (disconnect, timeout, or a non-2xx response) count toward `failures` but not toward the latency numbers.
+    LoadResult runLoadTest(const vector<LoadCommand>& mix, int clientThreads, int socketsPerThread, uint64_t durationUS);
+
     // Read from the DB file. Interface is the same as SQLiteNode's 'read' for backwards compatibility.
     string readDB(const string& query);
     bool readDB(const string& query, SQResult& result);
@@ -137,6 +179,11 @@ class BedrockTester {
     // A set of all bedrock testers.
     static set<BedrockTester*> _testers;
 
+    // Returns the path to a template DB initialized with `queries`, building it on first use and caching it for the
+    // rest of the suite run so that every tester with the same initialization can clone it instead of re-running the
+    // queries.
+    static string _templateDB(const list<string>& queries);
+
     // Flag indicating whether the DB should be kept when the tester is destroyed.
     bool _keepFilesWhenFinished;
 
@@ -1,9 +1,25 @@
 #include "tpunit++.hpp"
 #include <string.h>
+#include <cstdarg>
 #include <iostream>
 #include <regex>
 using namespace tpunit;
 
+// Routes a fixture's output: straight to stdout when running serially, into the fixture's buffer when running
+// multithreaded (flushed as one block when the fixture finishes, so parallel fixtures don't interleave).
+static void _fixtureOutput(tpunit::TestFixture* f, const char* format, ...) {
+    char line[2048];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (f->_multiThreaded) {
+        f->_outputBuffer += line;
+    } else {
+        fputs(line, stdout);
+    }
+}
+
 bool tpunit::TestFixture::exitFlag = false;
 
 tpunit::TestFixture::method::method(TestFixture* obj, void (TestFixture::*addr)(), const char* name, unsigned char type)
@@ -208,14 +224,20 @@ int tpunit::TestFixture::tpunit_detail_do_run(const set<string>& include, const
                     }
 
                    // At this point, we know this test should run.
-                   if (!f->_multiThreaded) {
-                       printf("[--------------]\n");
+                   if (f->_multiThreaded) {
+                       f->_outputBuffer.clear();
                    }
+                   _fixtureOutput(f, "[--------------]\n");
                    tpunit_detail_do_methods(f->_before_classes);
                    tpunit_detail_do_tests(f);
                    tpunit_detail_do_methods(f->_after_classes);
-                   if (!f->_multiThreaded) {
-                       printf("[--------------]\n\n");
+                   _fixtureOutput(f, "[--------------]\n\n");
+                   if (f->_multiThreaded) {
+                       // Print the whole fixture's output in one go, so blocks from parallel fixtures stay intact.
+                       lock_guard<recursive_mutex> lock(m);
+                       fputs(f->_outputBuffer.c_str(), stdout);
+                       fflush(stdout);
+                       f->_outputBuffer.clear();
                    }
                 }
             } catch (ShutdownException se) {
@@ -332,17 +354,17 @@ bool tpunit::TestFixture::tpunit_detail_fp_equal(double lhs, double rhs, unsigne
 // TODO: These three functions need to be updated to act on the current TestFixture.
 void tpunit::TestFixture::tpunit_detail_assert(TestFixture* f, const char* _file, int _line) {
     lock_guard<recursive_mutex> lock(*(f->_mutex));
-    printf("[              ]    assertion #%i at %s:%i\n", ++f->_stats._assertions, _file, _line);
+    _fixtureOutput(f, "[              ]    assertion #%i at %s:%i\n", ++f->_stats._assertions, _file, _line);
 }
 
 void tpunit::TestFixture::tpunit_detail_exception(TestFixture* f, method* _method, const char* _message) {
     lock_guard<recursive_mutex> lock(*(f->_mutex));
-    printf("[              ]    exception #%i from %s with cause: %s\n", ++f->_stats._exceptions, _method->_name, _message);
+    _fixtureOutput(f, "[              ]    exception #%i from %s with cause: %s\n", ++f->_stats._exceptions, _method->_name, _message);
 }
 
 void tpunit::TestFixture::tpunit_detail_trace(TestFixture* f, const char* _file, int _line, const char* _message) {
     lock_guard<recursive_mutex> lock(*(f->_mutex));
-    printf("[              ]    trace #%i at %s:%i: %s\n", ++f->_stats._traces, _file, _line, _message);
+    _fixtureOutput(f, "[              ]    trace #%i at %s:%i: %s\n", ++f->_stats._traces, _file, _line, _message);
 }
 
 void tpunit::TestFixture::tpunit_detail_do_method(tpunit::TestFixture::method* m) {
@@ -377,19 +399,17 @@ void tpunit::TestFixture::tpunit_detail_do_tests(TestFixture* f) {
     while(t) {
        int _prev_assertions = f->_stats._assertions;
        int _prev_exceptions = f->_stats._exceptions;
-       if (!f->_multiThreaded) {
-           printf("[ RUN          ] %s\n", t->_name);
-       }
+       _fixtureOutput(f, "[ RUN          ] %s\n", t->_name);
        tpunit_detail_do_methods(f->_befores);
        tpunit_detail_do_method(t);
        tpunit_detail_do_methods(f->_afters);
        if(_prev_assertions == f->_stats._assertions && _prev_exceptions == f->_stats._exceptions) {
           lock_guard<recursive_mutex> lock(m);
-          printf("[       PASSED ] %s\n", t->_name);
+          _fixtureOutput(f, "[       PASSED ] %s\n", t->_name);
           tpunit_detail_stats()._passes++;
        } else {
           lock_guard<recursive_mutex> lock(m);
-          printf("[       FAILED ] %s\n", t->_name);
+          _fixtureOutput(f, "[       FAILED ] %s\n", t->_name);
           tpunit_detail_stats()._failures++;
        }
        t = t->_next;
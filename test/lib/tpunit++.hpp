@@ -211,6 +211,14 @@ namespace tpunit {
          recursive_mutex* _mutex;
          int _threadID;
 
+         // True if running multithreaded.
+         bool _multiThreaded;
+
+         // When running multithreaded, each fixture's output accumulates here and is printed as one block when the
+         // fixture finishes, so parallel fixtures don't interleave their lines. A fixture runs entirely on one
+         // thread, so no lock is needed to append.
+         std::string _outputBuffer;
+
       protected:
 
          /**
@@ -345,9 +353,6 @@ namespace tpunit {
          method* _befores;
          method* _before_classes;
          method* _tests;
-
-         // True if running multithreaded.
-         bool _multiThreaded;
    };
 
    /**
@@ -28,7 +28,9 @@ int main(int argc, char* argv[]) {
     set<string> exclude;
     list<string> before;
     list<string> after;
-    int threads = 1;
+    // Fixtures shard across worker threads, each with its own DB directory and ports, so default to one worker per
+    // core. `-threads 1` gets the old serial run.
+    int threads = max(1, (int)thread::hardware_concurrency());
     int repeatCount = 1;
 
     if (args.isSet("-repeatCount")) {
@@ -5,10 +5,22 @@
 struct ChainedHTTPTest : tpunit::TestFixture {
     ChainedHTTPTest()
         : tpunit::TestFixture("ChainedHTTP",
-                              TEST(ChainedHTTPTest::test))
+                              TEST(ChainedHTTPTest::test),
+                              TEST(ChainedHTTPTest::testContinuation))
     { }
 
+    // The `repeek` version of the chain: every completed request re-runs `peek` from the top.
     void test() {
+        run("chainedrequest");
+    }
+
+    // The suspendable version: each completed request resumes a continuation where the chain left off. The observable
+    // behavior is identical, which is the point.
+    void testContinuation() {
+        run("continuationchainedrequest");
+    }
+
+    void run(const string& methodLine) {
         // Load the clustertest testplugin that implements our chained command.
         char cwd[1024];
         if (!getcwd(cwd, sizeof(cwd))) {
@@ -26,7 +38,7 @@ struct ChainedHTTPTest : tpunit::TestFixture {
             "www.amazon.com",
         };
 
-        SData request("chainedrequest");
+        SData request(methodLine);
         request["urls"] = SComposeList(urls);
         vector<SData> result = tester.executeWaitMultipleData({request}, 1);
 
@@ -1,9 +1,19 @@
 #include <libstuff/libstuff.h>
+#include <libstuff/SCryptoAccel.h>
+#include <libstuff/SHistogram.h>
+#include <mbedtls/aes.h>
+#include <mbedtls/sha1.h>
+#include <mbedtls/sha256.h>
+#include <libstuff/SMetrics.h>
+#include <libstuff/SScratchArena.h>
+#include <libstuff/STimerWheel.h>
+#include <sqlitecluster/SQLiteCommand.h>
 #include <test/lib/BedrockTester.h>
 
 struct LibStuff : tpunit::TestFixture {
     LibStuff() : tpunit::TestFixture("LibStuff",
                                     TEST(LibStuff::testEncryptDecrpyt),
+                                    TEST(LibStuff::testCryptoAccel),
                                     TEST(LibStuff::testSHMACSHA1),
                                     TEST(LibStuff::testSHMACSHA256),
                                     TEST(LibStuff::testJSONDecode),
@@ -13,16 +23,31 @@ struct LibStuff : tpunit::TestFixture {
                                     TEST(LibStuff::testCollapse),
                                     TEST(LibStuff::testStrip),
                                     TEST(LibStuff::testChunkedEncoding),
+                                    TEST(LibStuff::testResumableParse),
                                     TEST(LibStuff::testDaysInMonth),
                                     TEST(LibStuff::testGZip),
+                                    TEST(LibStuff::testZstd),
                                     TEST(LibStuff::testConstantTimeEquals),
                                     TEST(LibStuff::testParseIntegerList),
                                     TEST(LibStuff::testSData),
+                                    TEST(LibStuff::testSDataBinarySerialization),
+                                    TEST(LibStuff::testSFastBuffer),
+                                    TEST(LibStuff::testSBufferPool),
+                                    TEST(LibStuff::testSSlabPool),
+                                    TEST(LibStuff::testSDNSCache),
+                                    TEST(LibStuff::testSQResult),
+                                    TEST(LibStuff::testSDataView),
+                                    TEST(LibStuff::testMoveSemantics),
+                                    TEST(LibStuff::testScratchArena),
                                     TEST(LibStuff::testSTable),
+                                    TEST(LibStuff::testSTimerWheel),
+                                    TEST(LibStuff::testHistogram),
+                                    TEST(LibStuff::testMetrics),
                                     TEST(LibStuff::testFileIO),
                                     TEST(LibStuff::testSQList),
                                     TEST(LibStuff::testRandom),
                                     TEST(LibStuff::testHexConversion),
+                                    TEST(LibStuff::testFastIntConversion),
                                     TEST(LibStuff::testBase32Conversion),
                                     TEST(LibStuff::testContains))
     { }
@@ -37,6 +62,73 @@ struct LibStuff : tpunit::TestFixture {
         ASSERT_EQUAL(clearText, decrypted);
     }
 
+    void testCryptoAccel() {
+        if (!SCryptoAccel::aesAvailable() && !SCryptoAccel::shaAvailable()) {
+            // Nothing to verify on this CPU; the helpers are already on the mbedtls path.
+            return;
+        }
+
+        // Cross-check the hardware paths against mbedtls across lengths covering empty input, partial blocks, the
+        // one-vs-two final SHA padding blocks, and multi-block messages.
+        const string key = "0123456789abcdef0123456789abcdef"; // SAES_KEY_SIZE bytes.
+        const string iv = "fedcba9876543210";                  // SAES_IV_SIZE bytes.
+        for (size_t length : {0ul, 1ul, 15ul, 16ul, 55ul, 56ul, 63ul, 64ul, 65ul, 1000ul, 65536ul}) {
+            string buffer(length, '\0');
+            for (size_t i = 0; i < length; i++) {
+                buffer[i] = (char)SRandom::rand64();
+            }
+
+            if (SCryptoAccel::shaAvailable()) {
+                // SHashSHA1/SHashSHA256 dispatch to the hardware path, so compare them to mbedtls directly.
+                string expected(20, '\0');
+                mbedtls_sha1((unsigned char*)buffer.c_str(), buffer.size(), (unsigned char*)&expected[0]);
+                ASSERT_EQUAL(SHashSHA1(buffer), expected);
+                expected.resize(32);
+                mbedtls_sha256((unsigned char*)buffer.c_str(), buffer.size(), (unsigned char*)&expected[0], 0);
+                ASSERT_EQUAL(SHashSHA256(buffer), expected);
+            }
+
+            if (SCryptoAccel::aesAvailable() && length && length % SAES_BLOCK_SIZE == 0) {
+                string encrypted = SAESEncrypt(buffer, iv, key);
+                unsigned char ivCopy[SAES_BLOCK_SIZE];
+                memcpy(ivCopy, iv.c_str(), SAES_BLOCK_SIZE);
+                mbedtls_aes_context ctx;
+                mbedtls_aes_setkey_enc(&ctx, (unsigned char*)key.c_str(), 8 * SAES_KEY_SIZE);
+                string expected(length, '\0');
+                mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_ENCRYPT, (int)length, ivCopy, (unsigned char*)buffer.c_str(),
+                                      (unsigned char*)&expected[0]);
+                ASSERT_EQUAL(encrypted, expected);
+                ASSERT_EQUAL(SAESDecryptNoStrip(encrypted, encrypted.size(), iv, key), buffer);
+            }
+        }
+
+        // A quick bench over 8MB each way, to show the hardware gain in the test log.
+        string payload(8 * 1024 * 1024, 'x');
+        uint64_t start = STimeNow();
+        SHashSHA256(payload);
+        uint64_t accelUS = STimeNow() - start;
+        string expected(32, '\0');
+        start = STimeNow();
+        mbedtls_sha256((unsigned char*)payload.c_str(), payload.size(), (unsigned char*)&expected[0], 0);
+        uint64_t softUS = STimeNow() - start;
+        cout << "SHA256 8MB: accel " << accelUS << "us, mbedtls " << softUS << "us" << endl;
+
+        start = STimeNow();
+        string encrypted = SAESEncrypt(payload, iv, key);
+        accelUS = STimeNow() - start;
+        unsigned char ivCopy[SAES_BLOCK_SIZE];
+        memcpy(ivCopy, iv.c_str(), SAES_BLOCK_SIZE);
+        mbedtls_aes_context ctx;
+        mbedtls_aes_setkey_enc(&ctx, (unsigned char*)key.c_str(), 8 * SAES_KEY_SIZE);
+        expected.resize(payload.size());
+        start = STimeNow();
+        mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_ENCRYPT, (int)payload.size(), ivCopy,
+                              (unsigned char*)payload.c_str(), (unsigned char*)&expected[0]);
+        softUS = STimeNow() - start;
+        cout << "AES-256-CBC 8MB: accel " << accelUS << "us, mbedtls " << softUS << "us" << endl;
+        ASSERT_EQUAL(encrypted, expected);
+    }
+
     void testSHMACSHA1() {
         ASSERT_EQUAL(SToHex(SHMACSHA1("", "")), "FBDB1D1B18AA6C08324B7D64B71FB76370690E1D");
         ASSERT_EQUAL(SToHex(SHMACSHA1("key", "The quick brown fox jumps over the lazy dog")),
@@ -296,6 +388,51 @@ struct LibStuff : tpunit::TestFixture {
         ASSERT_EQUAL(content, "");
     }
 
+    void testResumableParse() {
+        // Feed a message in through an SHTTPParseState in dribs, like a slow socket would, and verify the stateful
+        // overload gives the same answers as the stateless one without restarting from scratch.
+        string full = "some method line\r\n"
+                      "header1: value1\r\n"
+                      "Content-Length: 10\r\n"
+                      "\r\n"
+                      "0123456789";
+        SHTTPParseState state;
+        string methodLine, content;
+        STable headers;
+
+        // Parse attempts against growing prefixes should all fail, but leave progress behind in the state.
+        for (size_t length = 0; length < full.size(); length++) {
+            ASSERT_EQUAL(SParseHTTP(full.c_str(), length, methodLine, headers, content, state), 0);
+        }
+
+        // Once the headers were complete, the state should know exactly how many bytes the message needs.
+        ASSERT_EQUAL(state.neededBytes, full.size());
+
+        // The whole message parses, and the state is reset for the next message.
+        size_t processed = SParseHTTP(full.c_str(), full.size(), methodLine, headers, content, state);
+        ASSERT_EQUAL(processed, full.size());
+        ASSERT_EQUAL(methodLine, "some method line");
+        ASSERT_EQUAL(headers["header1"], "value1");
+        ASSERT_EQUAL(content, "0123456789");
+        ASSERT_EQUAL(state.parsedOffset, 0u);
+        ASSERT_EQUAL(state.neededBytes, 0u);
+
+        // A receive buffer carries its own state, so SData::deserialize resumes automatically; consuming the parsed
+        // message resets it for the next one.
+        SFastBuffer buffer;
+        SData data;
+        buffer.append(full.c_str(), 20);
+        ASSERT_EQUAL(data.deserialize(buffer), 0);
+        ASSERT_TRUE(buffer.httpParseState.parsedOffset > 0);
+        buffer.append(full.c_str() + 20, full.size() - 20);
+        int consumed = data.deserialize(buffer);
+        ASSERT_EQUAL((size_t)consumed, full.size());
+        ASSERT_EQUAL(data.methodLine, "some method line");
+        ASSERT_EQUAL(data.content, "0123456789");
+        buffer.consumeFront(consumed);
+        ASSERT_EQUAL(buffer.httpParseState.parsedOffset, 0u);
+    }
+
     void testDaysInMonth() {
         ASSERT_EQUAL(SDaysInMonth(2012, 2), 29);
         ASSERT_EQUAL(SDaysInMonth(2013, 2), 28);
@@ -325,6 +462,50 @@ struct LibStuff : tpunit::TestFixture {
 
         // Test end to end.
         ASSERT_EQUAL(SGUnzip(SGZip(data)), data);
+
+        // The streaming variant produces the same stream as the one-shot call, including from a multi-segment
+        // buffer: a big rvalue append keeps its own segment in the chain rather than being condensed.
+        string body(2'000'000, '\0');
+        for (size_t i = 0; i < body.size(); i++) {
+            body[i] = (char)(SRandom::rand64() % 256);
+        }
+        SFastBuffer input;
+        input.append("HTTP/1.1 200 OK\r\n\r\n");
+        input.append(string(body));
+        SFastBuffer compressed;
+        ASSERT_TRUE(SGZipStream(input, compressed));
+        ASSERT_EQUAL(SGUnzip(compressed.toString()), "HTTP/1.1 200 OK\r\n\r\n" + body);
+        ASSERT_EQUAL(compressed.toString(), SGZip("HTTP/1.1 200 OK\r\n\r\n" + body));
+
+        // Empty input still yields a valid (empty) gzip stream.
+        SFastBuffer emptyIn, emptyOut;
+        ASSERT_TRUE(SGZipStream(emptyIn, emptyOut));
+        ASSERT_EQUAL(SGUnzip(emptyOut.toString()), "");
+    }
+
+    void testZstd() {
+        // Round-trip some compressible SQL-ish text.
+        string data;
+        for (int i = 0; i < 10000; i++) {
+            data += "INSERT INTO journal VALUES (" + SToStr(i) + ", 'someQuery', 'someHash');";
+        }
+        string compressed = SZstdCompress(data);
+        ASSERT_TRUE(compressed.size() > 0);
+        ASSERT_TRUE(compressed.size() < data.size());
+        ASSERT_EQUAL(SZstdDecompress(compressed), data);
+
+        // Empty and tiny inputs round-trip too.
+        ASSERT_EQUAL(SZstdDecompress(SZstdCompress("")), "");
+        ASSERT_EQUAL(SZstdDecompress(SZstdCompress("x")), "x");
+
+        // Garbage input throws rather than returning garbage.
+        bool threw = false;
+        try {
+            SZstdDecompress("this is not a zstd frame");
+        } catch (const SException& e) {
+            threw = true;
+        }
+        ASSERT_TRUE(threw);
     }
 
     void testConstantTimeEquals() {
@@ -377,6 +558,442 @@ struct LibStuff : tpunit::TestFixture {
         ASSERT_EQUAL(SToInt(c["g"]), 97);
     }
 
+    void testSDataBinarySerialization() {
+        // Round-trip a message through the binary format.
+        SData a("COMMIT_TRANSACTION");
+        a["NewCount"] = "12345";
+        a["NewHash"] = "abcdef0123456789";
+        a.content = "INSERT INTO test VALUES ('binary\r\ncontent', 1);";
+        string binary = a.serializeBinary();
+
+        SData b;
+        int consumed = b.deserialize(binary.c_str(), binary.size());
+        ASSERT_EQUAL(consumed, (int)binary.size());
+        ASSERT_EQUAL(b.methodLine, a.methodLine);
+        ASSERT_EQUAL(b["NewCount"], a["NewCount"]);
+        ASSERT_EQUAL(b["NewHash"], a["NewHash"]);
+        ASSERT_EQUAL(b.content, a.content);
+
+        // An incomplete frame consumes nothing.
+        SData c;
+        ASSERT_EQUAL(c.deserialize(binary.c_str(), binary.size() - 1), 0);
+
+        // Two frames back-to-back parse one at a time, like the text format.
+        string doubled = binary + binary;
+        SData d;
+        ASSERT_EQUAL(d.deserialize(doubled.c_str(), doubled.size()), (int)binary.size());
+
+        // And the text format still parses as text.
+        SData e;
+        string text = a.serialize();
+        ASSERT_EQUAL(e.deserialize(text.c_str(), text.size()), (int)text.size());
+        ASSERT_EQUAL(e.methodLine, a.methodLine);
+        ASSERT_EQUAL(e.content, a.content);
+    }
+
+    void testSFastBuffer() {
+        // Small appends stay in one contiguous region.
+        SFastBuffer buf;
+        buf += "small";
+        ASSERT_EQUAL(buf.size(), 5u);
+        ASSERT_EQUAL(buf.firstSegmentSize(), 5u);
+
+        // A large rvalue append gets chained as its own segment rather than copied.
+        string large(20'000, 'x');
+        string expected = "small" + large;
+        buf += move(large);
+        ASSERT_EQUAL(buf.size(), expected.size());
+        ASSERT_EQUAL(buf.firstSegmentSize(), 5u);
+        ASSERT_EQUAL(buf.toString(), expected);
+
+        // Both segments show up for scatter-gather sends.
+        struct iovec iov[4];
+        ASSERT_EQUAL(buf.gather(iov, 4), 2);
+        ASSERT_EQUAL(iov[0].iov_len + iov[1].iov_len, expected.size());
+
+        // Consuming part of the first segment just advances it.
+        buf.consumeFront(3);
+        ASSERT_EQUAL(buf.size(), expected.size() - 3);
+        ASSERT_EQUAL(string(buf.c_str(), buf.firstSegmentSize()), "ll");
+
+        // Consuming across the segment boundary drops the first segment entirely.
+        buf.consumeFront(10);
+        ASSERT_EQUAL(buf.size(), expected.size() - 13);
+        ASSERT_EQUAL(buf.gather(iov, 4), 1);
+        ASSERT_EQUAL(buf.toString(), expected.substr(13));
+
+        // Consuming exactly to the end empties the buffer.
+        buf.consumeFront(buf.size());
+        ASSERT_TRUE(buf.empty());
+        ASSERT_EQUAL(buf.gather(iov, 4), 0);
+
+        // Copying appends after a chained segment still come out in order.
+        SFastBuffer ordered;
+        ordered += string(20'000, 'y');
+        ordered.append("tail", 4);
+        ASSERT_EQUAL(ordered.size(), 20'004u);
+        ASSERT_EQUAL(ordered.toString().substr(20'000), "tail");
+
+        // Zero-copy appends: fill the writable tail directly, commit what was written.
+        SFastBuffer direct;
+        direct += "head";
+        char* tail = direct.writableTail(1024);
+        memcpy(tail, "12345", 5);
+        direct.commit(5);
+        ASSERT_EQUAL(direct.toString(), "head12345");
+
+        // A commit of zero leaves the buffer exactly as it was.
+        direct.writableTail(1024);
+        direct.commit(0);
+        ASSERT_EQUAL(direct.toString(), "head12345");
+
+        // With chained segments, the tail lands after them, same as a copying append would.
+        tail = ordered.writableTail(16);
+        memcpy(tail, "!", 1);
+        ordered.commit(1);
+        ASSERT_EQUAL(ordered.size(), 20'005u);
+        ASSERT_EQUAL(ordered.toString().substr(20'000), "tail!");
+
+        // A shared payload is referenced by every buffer it's appended to, not copied into each.
+        auto shared = make_shared<const string>(string(2'000, 'z'));
+        SFastBuffer peerA;
+        SFastBuffer peerB;
+        peerA.append(shared);
+        peerB.append(shared);
+        ASSERT_EQUAL(peerA.gather(iov, 4), 1);
+        ASSERT_TRUE(iov[0].iov_base == (void*)shared->data());
+        ASSERT_EQUAL(peerB.toString(), *shared);
+
+        // Consuming part of a shared segment advances within it; appends after it land in a new segment, and the
+        // whole thing drains in order.
+        peerA.consumeFront(500);
+        ASSERT_EQUAL(peerA.size(), 1'500u);
+        ASSERT_EQUAL(string(peerA.c_str(), 4), "zzzz");
+        peerA.append("end", 3);
+        ASSERT_EQUAL(peerA.toString(), shared->substr(500) + "end");
+        peerA.consumeFront(peerA.size());
+        ASSERT_TRUE(peerA.empty());
+
+        // One buffer consuming its reference doesn't touch the other's.
+        ASSERT_EQUAL(peerB.size(), 2'000u);
+        ASSERT_EQUAL(peerB.toString(), *shared);
+
+        // Tiny shared payloads get copied instead of chained, and still read back correctly.
+        auto tiny = make_shared<const string>("abc");
+        peerB.append(tiny);
+        ASSERT_EQUAL(peerB.size(), 2'003u);
+        ASSERT_EQUAL(peerB.toString().substr(2'000), "abc");
+    }
+
+    void testSBufferPool() {
+        // Acquired backings always cover the request, rounded up to the class size.
+        string small = SBufferPool::acquire(100);
+        ASSERT_TRUE(small.capacity() >= 4 * 1024);
+        string medium = SBufferPool::acquire(10'000);
+        ASSERT_TRUE(medium.capacity() >= 64 * 1024);
+        string big = SBufferPool::acquire(100'000);
+        ASSERT_TRUE(big.capacity() >= 1024 * 1024);
+
+        // A released backing comes back on the next acquire of its class instead of a fresh allocation.
+        const char* bigPtr = big.data();
+        SBufferPool::release(move(big));
+        ASSERT_TRUE(SBufferPool::freeBytes() >= 1024 * 1024);
+        string reused = SBufferPool::acquire(500'000);
+        ASSERT_TRUE(reused.data() == bigPtr);
+        ASSERT_TRUE(reused.empty());
+
+        // A buffer that grows into pool territory returns its backing when it drains, so the next grower reuses it.
+        SFastBuffer buf;
+        buf.append(string(100'000, 'x').c_str(), 100'000);
+        buf.consumeFront(buf.size());
+        ASSERT_TRUE(buf.empty());
+        size_t freeAfterDrain = SBufferPool::freeBytes();
+        SFastBuffer buf2;
+        buf2.append(string(100'000, 'y').c_str(), 100'000);
+        ASSERT_TRUE(SBufferPool::freeBytes() < freeAfterDrain);
+        ASSERT_EQUAL(buf2.size(), 100'000u);
+    }
+
+    void testSSlabPool() {
+        // A freed block comes straight back from the thread's magazine on the next allocation of its size class
+        // (200 and 250 both land in the 256-byte class).
+        void* block = SSlabPool::allocate(200);
+        SSlabPool::deallocate(block, 200);
+        void* reused = SSlabPool::allocate(250);
+        ASSERT_TRUE(reused == block);
+        SSlabPool::deallocate(reused, 250);
+
+        // Freeing more blocks than a magazine holds spills batches into the shared depot.
+        list<void*> blocks;
+        for (int i = 0; i < 100; i++) {
+            blocks.push_back(SSlabPool::allocate(1'000));
+        }
+        size_t depotBefore = SSlabPool::depotBytes();
+        for (void* b : blocks) {
+            SSlabPool::deallocate(b, 1'000);
+        }
+        ASSERT_TRUE(SSlabPool::depotBytes() > depotBefore);
+
+        // Oversized blocks fall through to the allocator.
+        void* big = SSlabPool::allocate(100'000);
+        ASSERT_TRUE(big != nullptr);
+        SSlabPool::deallocate(big, 100'000);
+    }
+
+    void testSDNSCache() {
+        SDNSCache::clear();
+
+        // localhost resolves (via /etc/hosts, so no network required) and gets cached.
+        uint32_t ip = SDNSCache::resolve("localhost");
+        ASSERT_EQUAL(ip, htonl(INADDR_LOOPBACK));
+        ASSERT_TRUE(SDNSCache::size() >= 1);
+
+        // A second resolution serves the cached address.
+        ASSERT_EQUAL(SDNSCache::resolve("localhost"), ip);
+
+        // An unresolvable name throws, and the failure is negative-cached so the retry also throws (without a
+        // second trip to the resolver, though we can only observe the throw here).
+        bool threw = false;
+        try {
+            SDNSCache::resolve("unresolvable.invalid");
+        } catch (const SException& e) {
+            threw = true;
+        }
+        ASSERT_TRUE(threw);
+        threw = false;
+        try {
+            SDNSCache::resolve("unresolvable.invalid");
+        } catch (const SException& e) {
+            threw = true;
+        }
+        ASSERT_TRUE(threw);
+        SDNSCache::clear();
+    }
+
+    void testSQResult() {
+        // JSON round-trip: escaped strings, bare-looking numbers, and empty cells all survive.
+        SQResult result;
+        result.headers = {"name", "count", "note"};
+        result.addRow();
+        result.addCell("say \"hi\"");
+        result.addCell("42");
+        result.addCell("");
+        result.addRow();
+        result.addCell("plain");
+        result.addCell("-7");
+        result.addCell("line1\nline2");
+        string json = result.serializeToJSON();
+
+        SQResult parsed;
+        ASSERT_TRUE(parsed.deserialize(json));
+        ASSERT_EQUAL(parsed.size(), 2);
+        ASSERT_TRUE(parsed.headers == result.headers);
+        ASSERT_TRUE(parsed[0][0] == "say \"hi\"");
+        ASSERT_TRUE(parsed[0][1] == "42");
+        ASSERT_TRUE(parsed[0][2] == "");
+        ASSERT_TRUE(parsed[1][2] == "line1\nline2");
+
+        // Re-serializing the parsed copy reproduces the same bytes.
+        ASSERT_EQUAL(parsed.serializeToJSON(), json);
+
+        // An empty result round-trips too.
+        SQResult emptyResult;
+        SQResult emptyParsed;
+        ASSERT_TRUE(emptyParsed.deserialize(emptyResult.serializeToJSON()));
+        ASSERT_TRUE(emptyParsed.empty());
+        ASSERT_TRUE(emptyParsed.headers.empty());
+
+        // Malformed input fails cleanly and leaves the result empty.
+        ASSERT_FALSE(parsed.deserialize("{\"headers\":[\"a\"]}"));
+        ASSERT_TRUE(parsed.empty());
+        ASSERT_FALSE(parsed.deserialize("{\"headers\":[\"a\"],\"rows\":[[\"x\",\"y\"]]}"));
+        ASSERT_FALSE(parsed.deserialize("not json"));
+
+        // Binary round-trip preserves everything byte-for-byte, including content JSON would have to escape.
+        string binary = result.serializeBinary();
+        SQResult binaryParsed;
+        ASSERT_TRUE(binaryParsed.deserializeBinary(binary));
+        ASSERT_TRUE(binaryParsed.headers == result.headers);
+        ASSERT_EQUAL(binaryParsed.size(), result.size());
+        ASSERT_TRUE(binaryParsed[0][0] == "say \"hi\"");
+        ASSERT_TRUE(binaryParsed[1][2] == "line1\nline2");
+        ASSERT_EQUAL(binaryParsed.serializeBinary(), binary);
+
+        // Truncated or corrupt binary input is rejected.
+        ASSERT_FALSE(binaryParsed.deserializeBinary(binary.substr(0, binary.size() - 1)));
+        ASSERT_TRUE(binaryParsed.empty());
+        string corrupt = binary;
+        corrupt[0] = 0x00;
+        ASSERT_FALSE(binaryParsed.deserializeBinary(corrupt));
+    }
+
+    void testSDataView() {
+        // A complete message parses into views over the original buffer, with no copies.
+        string message = "GET / HTTP/1.1\r\nHost: example.com\r\nContent-Length: 5\r\nCount: 42\r\n\r\nhello";
+        SDataView view;
+        int consumed = view.deserialize(message.c_str(), message.size());
+        ASSERT_EQUAL(consumed, (int)message.size());
+        ASSERT_TRUE(view.methodLine == "GET / HTTP/1.1");
+        ASSERT_TRUE(view["host"] == "example.com"); // case-insensitive
+        ASSERT_TRUE(view.content == "hello");
+        ASSERT_TRUE(view.isSet("Count"));
+        ASSERT_FALSE(view.isSet("Missing"));
+        ASSERT_EQUAL(view.calc64("Count"), 42);
+        ASSERT_TRUE(view.content.data() >= message.c_str() && view.content.data() < message.c_str() + message.size());
+
+        // Incomplete messages consume nothing.
+        SDataView incomplete;
+        ASSERT_EQUAL(incomplete.deserialize(message.c_str(), message.size() - 1), 0);
+        ASSERT_TRUE(incomplete.empty());
+
+        // Constructs the view parser can't represent (here, chunked encoding) also consume nothing, so the caller
+        // falls back to the copying parser.
+        string chunked = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n";
+        SDataView unsupported;
+        ASSERT_EQUAL(unsupported.deserialize(chunked.c_str(), chunked.size()), 0);
+        SData fallback;
+        ASSERT_EQUAL(fallback.deserialize(chunked), (int)chunked.size());
+        ASSERT_EQUAL(fallback.content, "hello");
+
+        // Pinning copies the bytes so the views survive the original buffer changing.
+        view.pin();
+        fill(message.begin(), message.end(), 'x');
+        ASSERT_TRUE(view.methodLine == "GET / HTTP/1.1");
+        ASSERT_TRUE(view["Host"] == "example.com");
+        ASSERT_TRUE(view.content == "hello");
+
+        // And a view materializes into an equivalent SData.
+        SData owned = view.toSData();
+        ASSERT_EQUAL(owned.methodLine, "GET / HTTP/1.1");
+        ASSERT_EQUAL(owned["Host"], "example.com");
+        ASSERT_EQUAL(owned.content, "hello");
+        ASSERT_EQUAL(owned.calc64("Count"), 42);
+    }
+
+    void testMoveSemantics() {
+        // All the strings here are far past small-string storage, so any copy shows up as an allocation.
+        string bigMethod(256, 'M');
+
+        // Constructing an SData from an rvalue string moves it into the methodLine.
+        string fromCopy = bigMethod;
+        const char* methodBytes = fromCopy.data();
+        size_t before = SGetAllocationCount();
+        SData fromMove(move(fromCopy));
+        size_t moveAllocations = SGetAllocationCount() - before;
+        ASSERT_EQUAL(fromMove.methodLine, bigMethod);
+        ASSERT_TRUE(fromMove.methodLine.data() == methodBytes);
+
+        // And strictly fewer allocations than the copying constructor.
+        before = SGetAllocationCount();
+        SData fromLValue(bigMethod);
+        size_t copyAllocations = SGetAllocationCount() - before;
+        ASSERT_LESS_THAN(moveAllocations, copyAllocations);
+
+        // merge from an rvalue moves the values across instead of copying them.
+        STable source;
+        source["moved"] = string(100'000, 'v');
+        const char* valueBytes = source["moved"].data();
+        SData target;
+        target.merge(move(source));
+        ASSERT_TRUE(target["moved"].data() == valueBytes);
+
+        // set() with an rvalue moves too.
+        string bigValue(100'000, 'w');
+        valueBytes = bigValue.data();
+        target.set("setMoved", move(bigValue));
+        ASSERT_TRUE(target["setMoved"].data() == valueBytes);
+
+        // A command round-trip: the request's content must travel from the parsed SData into the command without
+        // being copied, and the whole construction shouldn't allocate proportionally to the content.
+        SData request("BigCommand");
+        request["requestID"] = "abc123";
+        request["commandExecuteTime"] = "1";
+        request.content = string(1'000'000, 'c');
+        const char* contentBytes = request.content.data();
+        before = SGetAllocationCount();
+        SQLiteCommand command(move(request));
+        size_t commandAllocations = SGetAllocationCount() - before;
+        ASSERT_TRUE(command.request.content.data() == contentBytes);
+
+        // The bound is loose (id generation and header touch-ups allocate a little), but a reintroduced copy of a
+        // 1MB body blows well past it.
+        ASSERT_LESS_THAN(commandAllocations, 50u);
+    }
+
+    void testFastIntConversion() {
+        // Parse: digits only, stopping at the first non-digit.
+        ASSERT_EQUAL(SFastParseU64("0"), 0u);
+        ASSERT_EQUAL(SFastParseU64("42"), 42u);
+        ASSERT_EQUAL(SFastParseU64("18446744073709551615"), 18446744073709551615ull);
+        ASSERT_EQUAL(SFastParseU64("123abc"), 123u);
+        ASSERT_EQUAL(SFastParseU64(""), 0u);
+        ASSERT_EQUAL(SFastParseU64("abc"), 0u);
+
+        // Format round-trips through to_string for a spread of magnitudes.
+        for (uint64_t value : {0ull, 1ull, 9ull, 10ull, 99ull, 12345ull, 18446744073709551615ull}) {
+            char buffer[SFAST_U64_BUFFER_SIZE];
+            size_t length = SFastFormatU64(buffer, value);
+            ASSERT_EQUAL(string(buffer, length), to_string(value));
+        }
+
+        // calc64 handles the signed fixed format the fast path replaced strtoll for.
+        SData data;
+        data["positive"] = "12345";
+        data["negative"] = "-12345";
+        data["huge"] = "9223372036854775807";
+        ASSERT_EQUAL(data.calc64("positive"), 12345);
+        ASSERT_EQUAL(data.calc64("negative"), -12345);
+        ASSERT_EQUAL(data.calc64("huge"), 9223372036854775807ll);
+        ASSERT_EQUAL(data.calcU64("positive"), 12345u);
+        ASSERT_EQUAL(data.calc64("missing"), 0);
+    }
+
+    void testScratchArena() {
+        SScratchArena arena;
+        ASSERT_EQUAL(arena.bytesUsed(), 0u);
+
+        // Sequential small allocations come out of the same chunk, in order, and properly aligned.
+        char* first = static_cast<char*>(arena.allocate(100));
+        char* second = static_cast<char*>(arena.allocate(100));
+        ASSERT_TRUE(first != nullptr);
+        ASSERT_TRUE(second > first);
+        ASSERT_EQUAL(reinterpret_cast<uintptr_t>(first) % alignof(max_align_t), 0u);
+        ASSERT_EQUAL(reinterpret_cast<uintptr_t>(second) % alignof(max_align_t), 0u);
+        memset(first, 'a', 100);
+        memset(second, 'b', 100);
+        ASSERT_EQUAL(first[99], 'a'); // No overlap.
+
+        // An allocation bigger than the default chunk gets its own chunk.
+        char* big = static_cast<char*>(arena.allocate(100'000));
+        memset(big, 'c', 100'000);
+        ASSERT_TRUE(arena.bytesUsed() >= 100'200u);
+
+        // reset discards the contents but keeps the chunks: the next allocation reuses the same memory.
+        arena.reset();
+        ASSERT_EQUAL(arena.bytesUsed(), 0u);
+        char* reused = static_cast<char*>(arena.allocate(100));
+        ASSERT_TRUE(reused == big || reused == first);
+
+        // The allocator handle works with STL containers.
+        vector<int64_t, SScratchAllocator<int64_t>> numbers((SScratchAllocator<int64_t>(arena)));
+        for (int64_t i = 0; i < 1000; i++) {
+            numbers.push_back(i);
+        }
+        ASSERT_EQUAL(numbers.size(), 1000u);
+        ASSERT_EQUAL(numbers[999], 999);
+
+        // Chunks from a destroyed arena are recycled by the next arena on this thread.
+        char* oldChunk;
+        {
+            SScratchArena doomed;
+            oldChunk = static_cast<char*>(doomed.allocate(100));
+            memset(oldChunk, 'd', 100);
+        }
+        SScratchArena recycler;
+        char* recycled = static_cast<char*>(recycler.allocate(100));
+        ASSERT_TRUE(recycled == oldChunk);
+    }
+
     void testSTable() {
         // Verify that auto-stringification works.
         STable test;
@@ -402,6 +1019,142 @@ struct LibStuff : tpunit::TestFixture {
         ASSERT_EQUAL(test["i"], "string");
         ASSERT_EQUAL(test["j"], "true");
         ASSERT_EQUAL(test["k"], "false");
+
+        // Lookups are case-insensitive, and iteration comes back in sorted order.
+        ASSERT_TRUE(test.find("A") != test.end());
+        ASSERT_EQUAL(test["I"], "string");
+        ASSERT_EQUAL(test.begin()->first, "a");
+
+        // insert/emplace don't overwrite existing entries, like map's.
+        ASSERT_FALSE(test.emplace("i", "other").second);
+        ASSERT_EQUAL(test["i"], "string");
+        ASSERT_TRUE(test.emplace("l", "new").second);
+        ASSERT_EQUAL(test["l"], "new");
+
+        // And erase works by name.
+        ASSERT_EQUAL(test.erase("l"), 1u);
+        ASSERT_EQUAL(test.erase("l"), 0u);
+        ASSERT_FALSE(SContains(test, "l"));
+    }
+
+    void testSTimerWheel() {
+        STimerWheel<int> wheel;
+        uint64_t now = STimeNow();
+
+        // Nothing expires in an empty wheel.
+        uint64_t when = 0;
+        int value = 0;
+        ASSERT_TRUE(wheel.empty());
+        ASSERT_FALSE(wheel.peekExpired(now, when, value));
+
+        // Insert timers near, far, and very far out.
+        wheel.insert(now + 5'000, 1);              // 5ms: near wheel.
+        wheel.insert(now + 2'000'000, 2);          // 2s: a coarser level.
+        wheel.insert(now + 600'000'000, 3);        // 10 minutes: coarser still.
+        wheel.insert(now + 90ull * 86'400'000'000, 4); // 90 days: past the wheel's range.
+        ASSERT_EQUAL(wheel.size(), 4u);
+
+        // Nothing's due yet.
+        ASSERT_FALSE(wheel.peekExpired(now, when, value));
+
+        // Advance past the first timer: only it fires, and in order.
+        ASSERT_TRUE(wheel.popExpired(now + 10'000, when, value));
+        ASSERT_EQUAL(value, 1);
+        ASSERT_EQUAL(when, now + 5'000);
+        ASSERT_FALSE(wheel.popExpired(now + 10'000, when, value));
+
+        // The 2s timer survives the cascade from its coarser level down to the near wheel.
+        ASSERT_TRUE(wheel.popExpired(now + 3'000'000, when, value));
+        ASSERT_EQUAL(value, 2);
+        ASSERT_EQUAL(wheel.size(), 2u);
+
+        // Cancellation requires the exact time and value, and works before expiration...
+        ASSERT_FALSE(wheel.cancel(now + 600'000'000, 99));
+        ASSERT_TRUE(wheel.cancel(now + 600'000'000, 3));
+        ASSERT_FALSE(wheel.cancel(now + 600'000'000, 3));
+        ASSERT_EQUAL(wheel.size(), 1u);
+
+        // ...and after expiration but before popping.
+        wheel.insert(now + 3'500'000, 5);
+        ASSERT_TRUE(wheel.peekExpired(now + 4'000'000, when, value));
+        ASSERT_EQUAL(value, 5);
+        ASSERT_TRUE(wheel.cancel(now + 3'500'000, 5));
+        ASSERT_FALSE(wheel.popExpired(now + 4'000'000, when, value));
+
+        // Timers in the past expire immediately.
+        wheel.insert(now, 6);
+        ASSERT_TRUE(wheel.popExpired(now + 4'000'000, when, value));
+        ASSERT_EQUAL(value, 6);
+
+        // Only the parked far-future timer remains.
+        ASSERT_EQUAL(wheel.size(), 1u);
+        ASSERT_FALSE(wheel.peekExpired(now + 4'000'000, when, value));
+
+        // The parked timer's slot was chosen from the wheel's position at insert time rather than its own tick, so
+        // cancelling it after the wheel has advanced exercises the full top-level scan.
+        ASSERT_TRUE(wheel.cancel(now + 90ull * 86'400'000'000, 4));
+        ASSERT_TRUE(wheel.empty());
+
+        // Cancellation must find entries that haven't cascaded down to the level their remaining time implies. Pin a
+        // fresh wheel to a 256-tick boundary so the cascade points are deterministic, then insert a timer 1100 ticks
+        // out (level 1, cascading down at tick 1024) and advance 900 ticks: the remaining 200 ticks look like the
+        // near wheel, but the entry is still in level 1.
+        STimerWheel<int> alignedWheel;
+        uint64_t base = ((STimeNow() / 1000 + 512) & ~255ull) * 1000;
+        ASSERT_FALSE(alignedWheel.peekExpired(base, when, value));
+        alignedWheel.insert(base + 1'100'000, 8);
+        ASSERT_FALSE(alignedWheel.peekExpired(base + 900'000, when, value));
+        ASSERT_TRUE(alignedWheel.cancel(base + 1'100'000, 8));
+        ASSERT_TRUE(alignedWheel.empty());
+    }
+
+    void testHistogram() {
+        SHistogram histogram;
+        ASSERT_EQUAL(histogram.count(), 0u);
+        ASSERT_EQUAL(histogram.percentile(99), 0u);
+
+        // Small values get exact buckets.
+        for (uint64_t i = 1; i <= 10; i++) {
+            histogram.record(i);
+        }
+        ASSERT_EQUAL(histogram.count(), 10u);
+        ASSERT_EQUAL(histogram.percentile(50), 5u);
+        ASSERT_EQUAL(histogram.max(), 10u);
+
+        // A bimodal distribution: the tail shows up in p99 even though 99% of samples are fast. Percentiles report
+        // the bucket's upper bound, so they can err high by the bucket width (~6%), but never low.
+        histogram.clear();
+        for (int i = 0; i < 9900; i++) {
+            histogram.record(100);
+        }
+        for (int i = 0; i < 100; i++) {
+            histogram.record(1'000'000);
+        }
+        ASSERT_EQUAL(histogram.count(), 10'000u);
+        uint64_t p50 = histogram.percentile(50);
+        ASSERT_TRUE(p50 >= 100 && p50 <= 107);
+        uint64_t p999 = histogram.percentile(99.9);
+        ASSERT_TRUE(p999 >= 1'000'000 && p999 <= 1'070'000);
+        ASSERT_EQUAL(histogram.max(), 1'000'000u);
+
+        // The percentile never exceeds the exact recorded maximum.
+        histogram.clear();
+        histogram.record(123'456'789);
+        ASSERT_EQUAL(histogram.percentile(99), 123'456'789u);
+    }
+
+    void testMetrics() {
+        // The same name returns the same counter, and the reference stays usable directly.
+        atomic<uint64_t>& counter = SMetrics::counter("test.counter");
+        ASSERT_TRUE(&counter == &SMetrics::counter("test.counter"));
+        uint64_t before = counter;
+        counter += 41;
+        counter++;
+        ASSERT_EQUAL(counter - before, 42u);
+
+        // The snapshot includes it.
+        STable all = SMetrics::getAll();
+        ASSERT_EQUAL(all["test.counter"], to_string(counter.load()));
     }
 
     void testFileIO() {
@@ -548,6 +1301,13 @@ struct LibStuff : tpunit::TestFixture {
 
         ASSERT_EQUAL(SQList(intVector), SQList(SComposeList(intList)));
         ASSERT_EQUAL(SQList(stringList), SQList(SComposeList(stringList), false));
+
+        // Values containing quote characters get them doubled, identically to SQ().
+        ASSERT_EQUAL(SQ("it's"), "'it''s'");
+        ASSERT_EQUAL(SQ("''"), "''''''");
+        ASSERT_EQUAL(SQ(""), "''");
+        list<string> quotedList = {"it's", "a''b", "plain"};
+        ASSERT_EQUAL(SQList(quotedList), "'it''s', 'a''''b', 'plain'");
     }
 
     void testUpperLower() {
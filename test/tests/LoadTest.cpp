@@ -0,0 +1,46 @@
+#include <test/lib/BedrockTester.h>
+
+struct LoadTest : tpunit::TestFixture {
+    LoadTest()
+        : tpunit::TestFixture("Load",
+                              BEFORE_CLASS(LoadTest::setup),
+                              TEST(LoadTest::loadDriver),
+                              AFTER_CLASS(LoadTest::tearDown)) { }
+
+    BedrockTester* tester;
+
+    void setup() { tester = new BedrockTester(_threadID, {{"-plugins", "db,cache"}}); }
+
+    void tearDown() { delete tester; }
+
+    void loadDriver() {
+        // Prime the cache so the read side of the mix has something to hit.
+        SData write("WriteCache");
+        write["name"] = "loadtest";
+        write["value"] = string(512, 'v');
+        tester->executeWaitVerifyContent(write);
+
+        // A read-heavy mix: mostly cache reads, some cache writes, a few queries.
+        vector<BedrockTester::LoadCommand> mix(3);
+        mix[0].request = write;
+        mix[0].weight = 1.0;
+        mix[1].request.methodLine = "ReadCache";
+        mix[1].request["name"] = "loadtest";
+        mix[1].weight = 6.0;
+        mix[2].request.methodLine = "Query";
+        mix[2].request["query"] = "SELECT 1;";
+        mix[2].weight = 1.0;
+
+        auto result = tester->runLoadTest(mix, 4, 2, 2'000'000);
+
+        // The mix should have completed commands of every verb.
+        ASSERT_TRUE(result.countByVerb["WriteCache"] > 0);
+        ASSERT_TRUE(result.countByVerb["ReadCache"] > 0);
+        ASSERT_TRUE(result.countByVerb["Query"] > 0);
+
+        // These thresholds gate "still works under concurrency", not absolute speed, so they're deliberately loose
+        // enough to pass on a busy CI box.
+        ASSERT_TRUE(result.meetsThresholds(10.0, 0, 0.0));
+    }
+
+} __LoadTest;
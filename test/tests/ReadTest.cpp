@@ -7,6 +7,7 @@ struct ReadTest : tpunit::TestFixture {
                               TEST(ReadTest::simpleRead),
                               TEST(ReadTest::simpleReadWithHttp),
                               TEST(ReadTest::readNoSemicolon),
+                              TEST(ReadTest::compressedRead),
                               AFTER_CLASS(ReadTest::tearDown)) { }
 
     BedrockTester* tester;
@@ -37,4 +38,34 @@ struct ReadTest : tpunit::TestFixture {
         tester->executeWaitVerifyContent(status, "502");
     }
 
+    void compressedRead() {
+        // A client that advertises gzip gets a compressed body once it's over the size threshold.
+        SData request("Query");
+        request["query"] = "SELECT hex(zeroblob(2000));";
+        request["Accept-Encoding"] = "gzip";
+        SData response = tester->executeWaitMultipleData({request})[0];
+        ASSERT_EQUAL(response["Content-Encoding"], "gzip");
+        const string body = SGUnzip(response.content);
+        ASSERT_TRUE(SContains(body, string(4000, '0')));
+
+        // zstd is preferred when the client accepts both.
+        request["Accept-Encoding"] = "gzip, zstd";
+        response = tester->executeWaitMultipleData({request})[0];
+        ASSERT_EQUAL(response["Content-Encoding"], "zstd");
+        ASSERT_EQUAL(SZstdDecompress(response.content), body);
+
+        // Small responses aren't worth compressing and go out plain.
+        SData small("Query");
+        small["query"] = "SELECT 1;";
+        small["Accept-Encoding"] = "gzip";
+        response = tester->executeWaitMultipleData({small})[0];
+        ASSERT_FALSE(response.isSet("Content-Encoding"));
+
+        // And clients that didn't ask never get an encoded body.
+        request.erase("Accept-Encoding");
+        response = tester->executeWaitMultipleData({request})[0];
+        ASSERT_FALSE(response.isSet("Content-Encoding"));
+        ASSERT_TRUE(SContains(response.content, string(4000, '0')));
+    }
+
 } __ReadTest;
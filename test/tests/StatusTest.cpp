@@ -5,11 +5,13 @@ struct StatusTest : tpunit::TestFixture {
         : tpunit::TestFixture("Status",
                               BEFORE_CLASS(StatusTest::setup),
                               TEST(StatusTest::test),
+                              TEST(StatusTest::queryLedger),
                               AFTER_CLASS(StatusTest::tearDown)) { }
 
     BedrockTester* tester;
 
-    void setup() { tester = new BedrockTester(_threadID); }
+    // Sample every statement so the query ledger test doesn't depend on hitting the default 1-in-128 rate.
+    void setup() { tester = new BedrockTester(_threadID, {{"-queryLedgerSampleRate", "1"}}); }
 
     void tearDown() { delete tester; }
 
@@ -20,4 +22,22 @@ struct StatusTest : tpunit::TestFixture {
         ASSERT_TRUE(SContains(response, "multiWriteManualBlacklist"));
     }
 
+    void queryLedger() {
+        // Run a query so the ledger has at least one sampled shape to report.
+        SData query("Query");
+        query["query"] = "SELECT 1;";
+        tester->executeWaitVerifyContent(query);
+
+        // The ledger is only included when asked for.
+        SData status("Status");
+        string response = tester->executeWaitMultipleData({status})[0].content;
+        ASSERT_FALSE(SContains(response, "queryLedger"));
+
+        status["queryLedger"] = "1";
+        response = tester->executeWaitMultipleData({status})[0].content;
+        ASSERT_TRUE(SContains(response, "queryLedger"));
+        ASSERT_TRUE(SContains(response, "sampleCount"));
+        ASSERT_TRUE(SContains(response, "totalUS"));
+    }
+
 } __StatusTest;
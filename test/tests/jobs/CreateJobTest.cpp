@@ -55,8 +55,8 @@ struct CreateJobTest : tpunit::TestFixture {
         ASSERT_EQUAL(originalJob[0][5], "");
         ASSERT_EQUAL(originalJob[0][6], "");
         ASSERT_EQUAL(originalJob[0][7], "{}");
-        ASSERT_EQUAL(stol(originalJob[0][8]), 500);
-        ASSERT_EQUAL(stol(originalJob[0][9]), 0);
+        ASSERT_EQUAL(stol(string(originalJob[0][8])), 500);
+        ASSERT_EQUAL(stol(string(originalJob[0][9])), 0);
     }
 
     void createWithHttp() {
@@ -78,8 +78,8 @@ struct CreateJobTest : tpunit::TestFixture {
         ASSERT_EQUAL(originalJob[0][5], "");
         ASSERT_EQUAL(originalJob[0][6], "");
         ASSERT_EQUAL(originalJob[0][7], "{}");
-        ASSERT_EQUAL(stol(originalJob[0][8]), 500);
-        ASSERT_EQUAL(stol(originalJob[0][9]), 0);
+        ASSERT_EQUAL(stol(string(originalJob[0][8])), 500);
+        ASSERT_EQUAL(stol(string(originalJob[0][9])), 0);
     }
 
     void createWithPriority() {
@@ -104,7 +104,7 @@ struct CreateJobTest : tpunit::TestFixture {
         ASSERT_EQUAL(originalJob[0][6], "");
         ASSERT_EQUAL(originalJob[0][7], "{}");
         ASSERT_EQUAL(originalJob[0][8], priority);
-        ASSERT_EQUAL(stol(originalJob[0][9]), 0);
+        ASSERT_EQUAL(stol(string(originalJob[0][9])), 0);
     }
 
     void createWithData() {
@@ -130,8 +130,8 @@ struct CreateJobTest : tpunit::TestFixture {
         ASSERT_EQUAL(originalJob[0][5], "");
         ASSERT_EQUAL(originalJob[0][6], "");
         ASSERT_EQUAL(originalJob[0][7], data);
-        ASSERT_EQUAL(stol(originalJob[0][8]), 500);
-        ASSERT_EQUAL(stol(originalJob[0][9]), 0);
+        ASSERT_EQUAL(stol(string(originalJob[0][8])), 500);
+        ASSERT_EQUAL(stol(string(originalJob[0][9])), 0);
     }
 
     void createWithRepeat() {
@@ -155,8 +155,8 @@ struct CreateJobTest : tpunit::TestFixture {
         ASSERT_EQUAL(originalJob[0][5], "");
         ASSERT_EQUAL(originalJob[0][6], repeat);
         ASSERT_EQUAL(originalJob[0][7], "{}");
-        ASSERT_EQUAL(stol(originalJob[0][8]), 500);
-        ASSERT_EQUAL(stol(originalJob[0][9]), 0);
+        ASSERT_EQUAL(stol(string(originalJob[0][8])), 500);
+        ASSERT_EQUAL(stol(string(originalJob[0][9])), 0);
     }
 
     // Create a unique job
@@ -290,8 +290,8 @@ struct CreateJobTest : tpunit::TestFixture {
         ASSERT_EQUAL(originalJob[0][5], "");
         ASSERT_EQUAL(originalJob[0][6], repeatValue);
         ASSERT_EQUAL(originalJob[0][7], "{}");
-        ASSERT_EQUAL(stol(originalJob[0][8]), 500);
-        ASSERT_EQUAL(stol(originalJob[0][9]), 0);
+        ASSERT_EQUAL(stol(string(originalJob[0][8])), 500);
+        ASSERT_EQUAL(stol(string(originalJob[0][9])), 0);
         ASSERT_EQUAL(originalJob[0][10], retryValue);
 
         // Get the job
@@ -308,8 +308,8 @@ struct CreateJobTest : tpunit::TestFixture {
         SQResult jobData;
         tester->readDB("SELECT state, nextRun, lastRun FROM jobs WHERE jobID = " + jobID + ";", jobData);
         ASSERT_EQUAL(jobData[0][0], "RUNQUEUED");
-        time_t nextRunTime = JobTestHelper::getTimestampForDateTimeString(jobData[0][1]);
-        time_t lastRunTime = JobTestHelper::getTimestampForDateTimeString(jobData[0][2]);
+        time_t nextRunTime = JobTestHelper::getTimestampForDateTimeString(string(jobData[0][1]));
+        time_t lastRunTime = JobTestHelper::getTimestampForDateTimeString(string(jobData[0][2]));
         ASSERT_EQUAL(difftime(nextRunTime, lastRunTime), 5);
 
         // Get the job, confirm error because 1 second hasn't passed
@@ -357,8 +357,8 @@ struct CreateJobTest : tpunit::TestFixture {
 
         // Query db and confirm job still exists
         tester->readDB("SELECT state, nextRun, lastRun FROM jobs WHERE jobID = " + jobID + ";", jobData);
-        nextRunTime = JobTestHelper::getTimestampForDateTimeString(jobData[0][1]);
-        lastRunTime = JobTestHelper::getTimestampForDateTimeString(jobData[0][2]);
+        nextRunTime = JobTestHelper::getTimestampForDateTimeString(string(jobData[0][1]));
+        lastRunTime = JobTestHelper::getTimestampForDateTimeString(string(jobData[0][2]));
         ASSERT_EQUAL(jobData[0][0], "QUEUED");
         ASSERT_EQUAL(difftime(nextRunTime, lastRunTime), 10);
     }
@@ -399,8 +399,8 @@ struct CreateJobTest : tpunit::TestFixture {
         ASSERT_EQUAL(originalJob[0][5], "");
         ASSERT_EQUAL(originalJob[0][6], "");
         ASSERT_EQUAL(originalJob[0][7], "{}");
-        ASSERT_EQUAL(stol(originalJob[0][8]), 500);
-        ASSERT_EQUAL(stol(originalJob[0][9]), 0);
+        ASSERT_EQUAL(stol(string(originalJob[0][8])), 500);
+        ASSERT_EQUAL(stol(string(originalJob[0][9])), 0);
         ASSERT_EQUAL(originalJob[0][10], retryValue);
 
         // Get the job
@@ -417,8 +417,8 @@ struct CreateJobTest : tpunit::TestFixture {
         SQResult jobData;
         tester->readDB("SELECT state, nextRun, lastRun FROM jobs WHERE jobID = " + jobID + ";", jobData);
         ASSERT_EQUAL(jobData[0][0], "RUNQUEUED");
-        time_t nextRunTime = JobTestHelper::getTimestampForDateTimeString(jobData[0][1]);
-        time_t lastRunTime = JobTestHelper::getTimestampForDateTimeString(jobData[0][2]);
+        time_t nextRunTime = JobTestHelper::getTimestampForDateTimeString(string(jobData[0][1]));
+        time_t lastRunTime = JobTestHelper::getTimestampForDateTimeString(string(jobData[0][2]));
         ASSERT_EQUAL(difftime(nextRunTime, lastRunTime), 5);
 
         // Get the job, confirm error
@@ -88,7 +88,7 @@ struct GetJobTest : tpunit::TestFixture {
         ASSERT_EQUAL(currentJob[0][4], originalJob[0][4]);
 
         // The lastRun time can be anything from start to end, inclusive.
-        ASSERT_TRUE(isBetweenSecondsInclusive(start, end, currentJob[0][5]));
+        ASSERT_TRUE(isBetweenSecondsInclusive(start, end, string(currentJob[0][5])));
 
         ASSERT_EQUAL(currentJob[0][6], originalJob[0][6]);
         ASSERT_EQUAL(currentJob[0][7], originalJob[0][7]);
@@ -133,7 +133,7 @@ struct GetJobTest : tpunit::TestFixture {
         ASSERT_EQUAL(currentJob[0][4], originalJob[0][4]);
 
         // The lastRun time can be anything from start to end, inclusive.
-        ASSERT_TRUE(isBetweenSecondsInclusive(start, end, currentJob[0][5]));
+        ASSERT_TRUE(isBetweenSecondsInclusive(start, end, string(currentJob[0][5])));
 
         ASSERT_EQUAL(currentJob[0][6], originalJob[0][6]);
         ASSERT_EQUAL(currentJob[0][7], originalJob[0][7]);
@@ -526,8 +526,8 @@ struct GetJobTest : tpunit::TestFixture {
         ASSERT_EQUAL(result.size(), 2);
 
         // Make sure both run times are in the allowable range.
-        ASSERT_TRUE(isBetweenSecondsInclusive(start + 2'000'000, end + 2'000'000, result[0][0]));
-        ASSERT_TRUE(isBetweenSecondsInclusive(start + 2'000'000, end + 2'000'000, result[1][0]));
+        ASSERT_TRUE(isBetweenSecondsInclusive(start + 2'000'000, end + 2'000'000, string(result[0][0])));
+        ASSERT_TRUE(isBetweenSecondsInclusive(start + 2'000'000, end + 2'000'000, string(result[1][0])));
 
         // This should push us past the time when high_1 and medium_4 are re-queued.
         sleep(3);
@@ -81,9 +81,9 @@ struct GetJobsTest : tpunit::TestFixture {
         // `retryAfter`. We allow this to be within 3 seconds, because it's possible that the timestamps are generated
         // in sequential seconds, and so these can end up being, for instance, 5 minutes and 1 second different.
         SQResult jobData = getAllJobData(tester);
-        for (auto& row : jobData.rows) {
+        for (const auto& row : jobData) {
             // Assert that the difference between "lastRun + 5min" and "nextRun" is less than 3 seconds.
-            ASSERT_LESS_THAN(absoluteDiff(stringToUnixTimestamp(row[2]) + 5 * 60, stringToUnixTimestamp(row[3])), 3);
+            ASSERT_LESS_THAN(absoluteDiff(stringToUnixTimestamp(string(row[2])) + 5 * 60, stringToUnixTimestamp(string(row[3]))), 3);
             ASSERT_EQUAL(row[1], "RUNQUEUED");
         }
 
@@ -102,20 +102,20 @@ struct GetJobsTest : tpunit::TestFixture {
 
         // Now see what they look like.
         jobData = getAllJobData(tester);
-        for (auto& row : jobData.rows) {
+        for (const auto& row : jobData) {
             // Should be queued again.
             ASSERT_EQUAL(row[1], "QUEUED");
 
             // Let's see if it's scheduled at the right time.
-            if (stoull(row[0]) == jobIDs[0]) {
+            if (stoull(string(row[0])) == jobIDs[0]) {
                 // Assert that the difference between "lastRun + 1hour" and "nextRun" is less than 3 seconds.
-                ASSERT_LESS_THAN(absoluteDiff(stringToUnixTimestamp(row[2]) + 1 * 60 * 60, stringToUnixTimestamp(row[3])), 3);
-            } else if (stoull(row[0]) == jobIDs[1]) {
+                ASSERT_LESS_THAN(absoluteDiff(stringToUnixTimestamp(string(row[2])) + 1 * 60 * 60, stringToUnixTimestamp(string(row[3]))), 3);
+            } else if (stoull(string(row[0])) == jobIDs[1]) {
                 // Assert that the difference between "lastRun + 1day" and "nextRun" is less than 3 seconds.
-                ASSERT_LESS_THAN(absoluteDiff(stringToUnixTimestamp(row[2]) + 1 * 60 * 60 * 24, stringToUnixTimestamp(row[3])), 3);
-            } else if (stoull(row[0]) == jobIDs[2]) {
+                ASSERT_LESS_THAN(absoluteDiff(stringToUnixTimestamp(string(row[2])) + 1 * 60 * 60 * 24, stringToUnixTimestamp(string(row[3]))), 3);
+            } else if (stoull(string(row[0])) == jobIDs[2]) {
                 // Assert that the difference between "finishedTime + 7days" and "nextRun" is less than 3 seconds.
-                ASSERT_LESS_THAN(absoluteDiff(stringToUnixTimestamp(finishedTime) + 7 * 60 * 60 * 24, stringToUnixTimestamp(row[3])), 3);
+                ASSERT_LESS_THAN(absoluteDiff(stringToUnixTimestamp(finishedTime) + 7 * 60 * 60 * 24, stringToUnixTimestamp(string(row[3]))), 3);
             } else {
                 // It should be one of the above three.
                 ASSERT_TRUE(false);
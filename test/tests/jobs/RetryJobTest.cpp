@@ -238,7 +238,7 @@ struct RetryJobTest : tpunit::TestFixture {
         // Get a timestamp from before we update nextRun.
         SQResult result;
         tester->readDB("SELECT nextRun FROM jobs WHERE jobID = " + jobID + ";", result);
-        string minimumLastRun = result[0][0];
+        string minimumLastRun(result[0][0]);
 
         // Get the job
         command.clear();
@@ -255,11 +255,11 @@ struct RetryJobTest : tpunit::TestFixture {
             
         // Get a timestamp from after we update nextRun.
         tester->readDB("SELECT DATETIME();", result);
-        string maximumLastRun = result[0][0];
+        string maximumLastRun(result[0][0]);
 
         // Get the actual value of nextRun.
         tester->readDB("SELECT nextRun FROM jobs WHERE jobID = " + jobID + ";", result);
-        string actualNextRun = result[0][0];
+        string actualNextRun(result[0][0]);
 
         // Because nextRun is updated during RetryJob based on the *current time*, we don't know exactly what it should
         // be, but we do have two values that can't be more/less than this, so make sure it falls in this range.
@@ -286,7 +286,7 @@ struct RetryJobTest : tpunit::TestFixture {
         // Get the nextRun value
         SQResult result;
         tester->readDB("SELECT nextRun FROM jobs WHERE jobID = " + jobID + ";", result);
-        string originalNextRun = result[0][0];
+        string originalNextRun(result[0][0]);
 
         // Get the job
         command.clear();
@@ -326,8 +326,8 @@ struct RetryJobTest : tpunit::TestFixture {
         // Confirm nextRun is in 1 hour
         SQResult result;
         tester->readDB("SELECT lastRun, nextRun FROM jobs WHERE jobID = " + jobID + ";", result);
-        time_t createdTime = JobTestHelper::getTimestampForDateTimeString(result[0][0]);
-        time_t nextRunTime = JobTestHelper::getTimestampForDateTimeString(result[0][1]);
+        time_t createdTime = JobTestHelper::getTimestampForDateTimeString(string(result[0][0]));
+        time_t nextRunTime = JobTestHelper::getTimestampForDateTimeString(string(result[0][1]));
         ASSERT_EQUAL(difftime(nextRunTime, createdTime), 3600);
     }
 
@@ -506,9 +506,9 @@ struct RetryJobTest : tpunit::TestFixture {
         tester->readDB("SELECT lastRun, nextRun FROM jobs WHERE jobID = " + jobID + ";", result);
         struct tm tm1;
         struct tm tm2;
-        strptime(result[0][0].c_str(), "%Y-%m-%d %H:%M:%S", &tm1);
+        strptime(string(result[0][0]).c_str(), "%Y-%m-%d %H:%M:%S", &tm1);
         time_t createdTime = mktime(&tm1);
-        strptime(result[0][1].c_str(), "%Y-%m-%d %H:%M:%S", &tm2);
+        strptime(string(result[0][1]).c_str(), "%Y-%m-%d %H:%M:%S", &tm2);
         time_t nextRunTime = mktime(&tm2);
         ASSERT_EQUAL(difftime(nextRunTime, createdTime), 3600);
     }
@@ -540,9 +540,9 @@ struct RetryJobTest : tpunit::TestFixture {
         tester->readDB("SELECT lastRun, nextRun FROM jobs WHERE jobID = " + jobID + ";", result);
         struct tm tm1;
         struct tm tm2;
-        strptime(result[0][0].c_str(), "%Y-%m-%d %H:%M:%S", &tm1);
+        strptime(string(result[0][0]).c_str(), "%Y-%m-%d %H:%M:%S", &tm1);
         time_t createdTime = mktime(&tm1);
-        strptime(result[0][1].c_str(), "%Y-%m-%d %H:%M:%S", &tm2);
+        strptime(string(result[0][1]).c_str(), "%Y-%m-%d %H:%M:%S", &tm2);
         time_t nextRunTime = mktime(&tm2);
         ASSERT_EQUAL(difftime(nextRunTime, createdTime), 3600);
     }